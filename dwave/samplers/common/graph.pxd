@@ -0,0 +1,45 @@
+# Copyright 2026 D-Wave Systems Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from libcpp cimport bool
+from libcpp.memory cimport shared_ptr
+from libcpp.vector cimport vector
+
+from dimod.cyqmbase.cyqmbase_float64 cimport bias_type, index_type
+from dimod.libcpp.binary_quadratic_model cimport BinaryQuadraticModel as cppBinaryQuadraticModel
+
+cdef extern from "graph.h":
+    cdef cppclass AdjacencyOptions:
+        bool sort_neighbors
+        bool merge_duplicates
+
+    cdef cppclass cppIsingGraph "IsingGraph":
+        vector[double] linear
+        int num_variables()
+
+    cppIsingGraph build_ising_graph(
+        const vector[double]& linear,
+        const vector[int]& coupler_starts,
+        const vector[int]& coupler_ends,
+        const vector[double]& coupler_weights,
+        const AdjacencyOptions& options
+    ) except +
+
+    cppIsingGraph build_ising_graph_bqm "build_ising_graph" (
+        const cppBinaryQuadraticModel[bias_type, index_type]& bqm,
+        const AdjacencyOptions& options
+    ) except +
+
+cdef class IsingGraph:
+    cdef shared_ptr[cppIsingGraph] graph
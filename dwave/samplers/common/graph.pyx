@@ -0,0 +1,124 @@
+# distutils: language = c++
+# distutils: include_dirs = dwave/samplers/common/src/
+# cython: language_level = 3
+
+# Copyright 2026 D-Wave Systems Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from cython.operator cimport dereference as deref
+from libcpp.memory cimport make_shared
+from libcpp.vector cimport vector
+
+import dimod
+cimport dimod
+
+__all__ = ['IsingGraph']
+
+
+cdef AdjacencyOptions _adjacency_options(sort_neighbors, merge_duplicates):
+    cdef AdjacencyOptions options
+    options.sort_neighbors = sort_neighbors
+    options.merge_duplicates = merge_duplicates
+    return options
+
+
+cdef class IsingGraph:
+    """Wraps `IsingGraph` from `graph.h`. The linear biases and the compressed
+    sparse row adjacency of an Ising problem, built once so that several
+    samplers can share them.
+
+    The graph is read-only once built. It can be passed to
+    :meth:`dwave.samplers.sa.simulated_annealing.AnnealingProblem.from_graph`
+    and to
+    :func:`dwave.samplers.greedy.descent.steepest_gradient_descent_graph`,
+    for instance to post-process the samples of simulated annealing with
+    steepest descent without building the adjacency twice.
+
+    Parameters
+    ----------
+    h : list(float)
+        The h or field values for the problem.
+
+    coupler_starts : list(int)
+        A list of the start variable of each coupler.
+
+    coupler_ends : list(int)
+        A list of the end variable of each coupler.
+
+    coupler_weights : list(float)
+        A list of the J values or weight on each coupler, in the same
+        order as `coupler_starts` and `coupler_ends`.
+
+    sort_neighbors : bool, optional, default=False
+        Store the neighbors of each variable sorted by index rather than in
+        the order of the couplers.
+
+    merge_duplicates : bool, optional, default=False
+        Replace the couplers between the same two variables by a single
+        coupler whose weight is the sum of theirs. Implies `sort_neighbors`.
+
+    """
+    def __init__(self, h, coupler_starts, coupler_ends, coupler_weights,
+                 *, sort_neighbors=False, merge_duplicates=False):
+        cdef vector[double] _h = h
+        cdef vector[int] _coupler_starts = coupler_starts
+        cdef vector[int] _coupler_ends = coupler_ends
+        cdef vector[double] _coupler_weights = coupler_weights
+        cdef AdjacencyOptions options = _adjacency_options(sort_neighbors,
+                                                           merge_duplicates)
+        self.graph = make_shared[cppIsingGraph](build_ising_graph(
+            _h, _coupler_starts, _coupler_ends, _coupler_weights, options))
+
+    @staticmethod
+    def from_bqm(bqm, *, sort_neighbors=False, merge_duplicates=False):
+        """Build the graph of a spin-valued binary quadratic model.
+
+        The biases are read directly from the BQM's C++ adjacency, without
+        first flattening them into arrays. The variables of the graph are the
+        indices of the BQM's variables.
+
+        Parameters
+        ----------
+        bqm : dimod.BinaryQuadraticModel
+            A spin-valued binary quadratic model. Models with biases other
+            than float64 are copied first. The offset is ignored.
+
+        sort_neighbors : bool, optional, default=False
+            See :class:`IsingGraph`.
+
+        merge_duplicates : bool, optional, default=False
+            See :class:`IsingGraph`.
+
+        Returns
+        -------
+        graph : IsingGraph
+
+        """
+        if bqm.vartype is not dimod.SPIN:
+            raise ValueError("bqm must be spin-valued")
+
+        cdef dimod.cyBQM_float64 cybqm = dimod.as_bqm(bqm, dtype=float).data
+        cdef AdjacencyOptions options = _adjacency_options(sort_neighbors,
+                                                           merge_duplicates)
+        cdef IsingGraph graph = IsingGraph.__new__(IsingGraph)
+        graph.graph = make_shared[cppIsingGraph](
+            build_ising_graph_bqm(deref(cybqm.data()), options))
+        return graph
+
+    @property
+    def num_variables(self):
+        """int: The number of variables in the problem."""
+        if self.graph.get() == NULL:
+            return 0
+        return deref(self.graph).num_variables()
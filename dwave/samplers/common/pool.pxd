@@ -0,0 +1,29 @@
+# Copyright 2026 D-Wave Systems Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from libcpp cimport bool
+
+cdef extern from "pool.h":
+    cdef cppclass cppWorkerPool "WorkerPool":
+        int num_threads()
+        bool pinned()
+        void configure(int num_threads, bool pin) except + nogil
+
+    cppWorkerPool& worker_pool()
+    void set_worker_pool(cppWorkerPool* pool)
+
+# The pool that all of the kernel extensions run their parallel loops on. Each
+# extension compiles its own copy of the kernels, so each calls
+# ``set_worker_pool(shared_worker_pool())`` when it is imported.
+cdef cppWorkerPool* shared_worker_pool() noexcept
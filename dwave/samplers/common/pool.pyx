@@ -0,0 +1,77 @@
+# distutils: language = c++
+# distutils: include_dirs = dwave/samplers/common/src/
+# cython: language_level = 3
+
+# Copyright 2026 D-Wave Systems Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""The worker threads that the samplers run their parallel loops on.
+
+All of the samplers of a process share one pool of workers, which is started
+the first time a sampler runs on more than one thread. Its size is given by
+the ``DWAVE_SAMPLERS_NUM_THREADS`` environment variable if it is set, and
+otherwise by the number of CPUs, and the ``num_threads`` argument of a
+sampler only chooses how many of the workers it uses.
+"""
+
+__all__ = ['num_threads', 'pinned', 'set_num_threads']
+
+
+cdef cppWorkerPool* _pool = &worker_pool()
+set_worker_pool(_pool)
+
+
+cdef cppWorkerPool* shared_worker_pool() noexcept:
+    return _pool
+
+
+def num_threads() -> int:
+    """The number of worker threads shared by the samplers."""
+    return _pool.num_threads()
+
+
+def pinned() -> bool:
+    """Whether the worker threads are pinned to CPUs."""
+    return _pool.pinned()
+
+
+def set_num_threads(num_threads: int = 0, pin: bool = None):
+    """Replace the worker threads shared by the samplers.
+
+    Waits for the samplers running on the current workers to finish.
+
+    Args:
+        num_threads:
+            The number of worker threads, or 0 for the default, see the
+            module docstring.
+
+        pin:
+            Whether to pin the workers to the CPUs the process may run on,
+            node by node on a NUMA system, so that the buffers a sampler
+            allocates on a worker are on the node of its CPU. Only supported
+            on Linux. Defaults to the current setting.
+
+    Examples:
+        >>> from dwave.samplers.common import pool
+        >>> pool.set_num_threads(4)
+        >>> pool.num_threads()
+        4
+
+    """
+    if num_threads < 0:
+        raise ValueError("num_threads must be non-negative")
+    cdef bint p = _pool.pinned() if pin is None else pin
+    cdef int n = num_threads
+    with nogil:
+        _pool.configure(n, p)
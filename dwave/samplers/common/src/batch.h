@@ -0,0 +1,67 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// Running a batch of independent problems, eg. the subproblems of a
+// decomposition solver, in one native call. Each problem is solved whole by
+// one thread, with the reads of the problem taken in turn, so a batch of many
+// small problems is not held back by the per-read threading of the samplers.
+// The threads are those of the shared worker pool, see pool.h.
+
+#ifndef _batch_h
+#define _batch_h
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+
+#include "pool.h"
+
+// Calls `task(i)` for each problem `i` of `0, ..., num_problems - 1`, on up to
+// `num_threads` threads, the calling thread and workers of the shared pool,
+// that claim the problems from a shared counter (see `run_parallel`). The
+// first exception thrown by a task stops the threads from claiming more
+// problems, and is rethrown once they are all done. If `num_threads` is less
+// than two, the problems are solved in order on the calling thread instead.
+template <class Task>
+void run_batch(const int num_problems, int num_threads, Task &task) {
+    std::atomic<int> next_problem(0);
+    std::atomic<bool> stop(false);
+    std::mutex lock;
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+        while (!stop) {
+            const int problem = next_problem++;
+            if (problem >= num_problems) break;
+
+            try {
+                task(problem);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) error = std::current_exception();
+                stop = true;
+            }
+        }
+    };
+
+    num_threads = std::min(num_threads, num_problems);
+    run_parallel(num_threads, worker);
+
+    if (error) std::rethrow_exception(error);
+}
+
+#endif
@@ -0,0 +1,57 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// The instrumentation counters of the kernels. Counting is compiled in when
+// DWAVE_SAMPLERS_COUNTERS is defined, eg. with
+//
+//     DWAVE_SAMPLERS_COUNTERS=1 pip install .
+//
+// and otherwise the kernels skip it with `if constexpr (counters_enabled)`,
+// so that their hot loops are the same as without any counters.
+
+#ifndef _counters_h
+#define _counters_h
+
+#include <chrono>
+
+#ifdef DWAVE_SAMPLERS_COUNTERS
+constexpr bool counters_enabled = true;
+#else
+constexpr bool counters_enabled = false;
+#endif
+
+// Measures the time since it was constructed, if counters are enabled
+class CounterTimer {
+  public:
+    CounterTimer() {
+        if constexpr (counters_enabled) start_ = std::chrono::steady_clock::now();
+    }
+
+    // the seconds elapsed, or 0 if counters are disabled
+    double seconds() const {
+        if constexpr (counters_enabled) {
+            return std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start_).count();
+        } else {
+            return 0;
+        }
+    }
+
+  private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif
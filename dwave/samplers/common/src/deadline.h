@@ -0,0 +1,120 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// The time limits of the samplers. A kernel checks its deadline once per
+// iteration, which on small problems takes a few hundred nanoseconds, so
+// reading the clock every time would cost a measurable part of the run.
+// Instead the clock is read every `stride` checks, with the stride
+// calibrated from the measured time between reads so that the clock is read
+// about once per check interval, whatever an iteration costs.
+
+#ifndef _deadline_h
+#define _deadline_h
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// A deadline, checked by one thread. Checks are cheap countdowns between two
+// clock reads, so the deadline is noticed at most about a check interval (or
+// a single iteration, if it takes longer) after it has passed.
+class Deadline {
+  public:
+    typedef std::chrono::steady_clock clock;
+
+    // The time, in seconds, between two clock reads once calibrated
+    static constexpr double default_check_interval = 1e-4;
+
+    // @param seconds the time from now until the deadline; if it is not
+    //        finite, the deadline never passes
+    // @param check_interval the target time, in seconds, between clock reads
+    explicit Deadline(
+        const double seconds = std::numeric_limits<double>::infinity(),
+        const double check_interval = default_check_interval
+    ) : timed_(std::isfinite(seconds)), check_interval_(check_interval), last_(clock::now()) {
+        if (timed_) {
+            deadline_ = last_ + std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>(seconds));
+        }
+    }
+
+    // @param deadline the time point of the deadline, eg. shared by the
+    //        threads of a sampler, each of which checks its own copy
+    // @param check_interval the target time, in seconds, between clock reads
+    explicit Deadline(
+        const clock::time_point deadline,
+        const double check_interval = default_check_interval
+    ) : timed_(true), check_interval_(check_interval), last_(clock::now()), deadline_(deadline) {}
+
+    // Whether the deadline can pass at all
+    bool timed() const { return timed_; }
+
+    // Returns true once the deadline has passed. Only one call in `stride()`
+    // reads the clock, the others count down.
+    bool expired() {
+        if (!timed_) return expired_;
+        if (expired_) return true;
+        if (--countdown_ > 0) return false;
+        return check();
+    }
+
+    // Reads the clock and returns true if the deadline has passed, eg. at
+    // the coarse boundaries of a search where an exact answer is wanted.
+    bool check() {
+        if (!timed_ || expired_) return expired_;
+        const clock::time_point now = clock::now();
+        if (now >= deadline_) return expired_ = true;
+
+        // aim the next read at a check interval from now, or at the deadline
+        // if it is nearer, from the cost of the checks since the last read,
+        // growing the stride at most twofold per read so that iterations
+        // shorter than usual do not overshoot the target
+        const double calls = stride_ - countdown_;
+        const double elapsed = std::chrono::duration<double>(now - last_).count();
+        if (calls > 0) {
+            const double target = std::min(
+                check_interval_, std::chrono::duration<double>(deadline_ - now).count());
+            double stride = 2.0 * stride_;
+            if (elapsed > 0) stride = std::min(stride, calls * (target / elapsed));
+            stride_ = std::max<std::int64_t>(1, std::min((std::int64_t)stride, max_stride));
+        }
+
+        countdown_ = stride_;
+        last_ = now;
+        return false;
+    }
+
+    // Expires the deadline at once, eg. when the search is otherwise done
+    void expire() { expired_ = true; }
+
+    // The number of checks per clock read
+    std::int64_t stride() const { return stride_; }
+
+  private:
+    static constexpr std::int64_t max_stride = 1 << 20;
+
+    bool timed_;
+    bool expired_ = false;
+    double check_interval_;
+    std::int64_t stride_ = 1;
+    std::int64_t countdown_ = 1;
+    clock::time_point last_;
+    clock::time_point deadline_;
+};
+
+#endif
@@ -0,0 +1,269 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// The problem graph shared by the sa, greedy and tabu samplers. It is header
+// only, so that each extension module compiles its own copy, and an
+// `IsingGraph` built by one of them can be handed to the others.
+
+#ifndef _graph_h
+#define _graph_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// A neighbor of a variable together with the weight of the coupling between
+// them. Packing both into one record means the adjacency walk in the inner
+// loops only touches a single contiguous array.
+template <class Weight>
+struct BasicNeighbor {
+    std::int32_t var;
+    Weight weight;
+};
+
+// Compressed sparse row (CSR) adjacency. The neighbors of variable `v` are
+// `neighbors[offsets[v]], ..., neighbors[offsets[v + 1] - 1]`. A coupler
+// between `u` and `v` appears in the rows of both, so a coupler from a
+// variable to itself appears twice in its row.
+template <class Weight>
+struct BasicAdjacency {
+    typedef Weight weight_type;
+
+    std::vector<int> offsets;
+    std::vector<BasicNeighbor<Weight>> neighbors;
+
+    int num_variables() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+    const BasicNeighbor<Weight>* begin(int v) const { return neighbors.data() + offsets[v]; }
+    const BasicNeighbor<Weight>* end(int v) const { return neighbors.data() + offsets[v + 1]; }
+};
+
+typedef BasicNeighbor<double> Neighbor;
+typedef BasicAdjacency<double> Adjacency;
+
+// How to arrange the neighbors of each variable when building an adjacency.
+// By default they are stored in the order the couplers are given.
+struct AdjacencyOptions {
+    // sort the neighbors of each variable by their index, keeping the
+    // couplers between the same two variables in the order they are given
+    bool sort_neighbors = false;
+    // replace the couplers between the same two variables by a single one,
+    // whose weight is the sum of theirs; implies `sort_neighbors`
+    bool merge_duplicates = false;
+};
+
+// Sorts and/or merges the rows of `adj` in place, see `AdjacencyOptions`.
+template <class Weight>
+void arrange_adjacency(BasicAdjacency<Weight>& adj, const AdjacencyOptions& options) {
+    if (!options.sort_neighbors && !options.merge_duplicates) return;
+
+    const int num_vars = adj.num_variables();
+    int size = 0;
+    for (int v = 0; v < num_vars; v++) {
+        auto first = adj.neighbors.begin() + adj.offsets[v];
+        auto last = adj.neighbors.begin() + adj.offsets[v + 1];
+        std::stable_sort(first, last,
+            [](const BasicNeighbor<Weight>& a, const BasicNeighbor<Weight>& b) {
+                return a.var < b.var;
+            });
+
+        // compact the row towards the front, merging if asked to
+        adj.offsets[v] = size;
+        for (auto it = first; it != last; ++it) {
+            if (options.merge_duplicates && size > adj.offsets[v] &&
+                    adj.neighbors[size - 1].var == it->var) {
+                adj.neighbors[size - 1].weight += it->weight;
+            } else {
+                adj.neighbors[size++] = *it;
+            }
+        }
+    }
+    adj.offsets[num_vars] = size;
+    adj.neighbors.resize(size);
+}
+
+// Builds the CSR adjacency of a problem from its list of couplers.
+// @param num_vars the number of variables in the problem
+// @param coupler_starts an int vector containing the variables of one side of
+//        each coupler in the problem
+// @param coupler_ends an int vector containing the variables of the other side
+//        of each coupler in the problem
+// @param coupler_weights a double vector containing the weights of the couplers
+//        in the same order as coupler_starts and coupler_ends
+// @param options see `AdjacencyOptions`
+// @return the adjacency, with weights converted to `Weight`
+template <class Weight = double>
+BasicAdjacency<Weight> build_adjacency(
+    const int num_vars,
+    const std::vector<int>& coupler_starts,
+    const std::vector<int>& coupler_ends,
+    const std::vector<double>& coupler_weights,
+    const AdjacencyOptions& options = AdjacencyOptions()
+) {
+    if (!((coupler_starts.size() == coupler_ends.size()) &&
+                (coupler_starts.size() == coupler_weights.size()))) {
+        throw std::runtime_error("coupler vectors have mismatched lengths");
+    }
+
+    BasicAdjacency<Weight> adj;
+
+    // first count the degree of each variable, storing the degree of `v` in
+    // offsets[v + 1] so that a prefix sum gives the row offsets
+    adj.offsets.assign(num_vars + 1, 0);
+    for (unsigned int cplr = 0; cplr < coupler_starts.size(); cplr++) {
+        int u = coupler_starts[cplr];
+        int v = coupler_ends[cplr];
+
+        if ((u < 0) || (v < 0) || (u >= num_vars) || (v >= num_vars)) {
+            throw std::runtime_error("coupler indexes contain an invalid variable");
+        }
+
+        adj.offsets[u + 1]++;
+        adj.offsets[v + 1]++;
+    }
+    for (int v = 0; v < num_vars; v++) {
+        adj.offsets[v + 1] += adj.offsets[v];
+    }
+
+    // then fill in the rows, using `next` to track the next free slot in each
+    std::vector<int> next(adj.offsets.begin(), adj.offsets.end() - 1);
+    adj.neighbors.resize(adj.offsets[num_vars]);
+    for (unsigned int cplr = 0; cplr < coupler_starts.size(); cplr++) {
+        int u = coupler_starts[cplr];
+        int v = coupler_ends[cplr];
+        const Weight weight = static_cast<Weight>(coupler_weights[cplr]);
+
+        adj.neighbors[next[u]++] = {v, weight};
+        adj.neighbors[next[v]++] = {u, weight};
+    }
+
+    arrange_adjacency(adj, options);
+    return adj;
+}
+
+// Builds the CSR adjacency of a binary quadratic model, reading its
+// neighborhoods in place. `BQM` is expected to provide the interface of
+// `dimod::BinaryQuadraticModel`: `num_variables()` and, for each variable,
+// `cbegin_neighborhood(v)`/`cend_neighborhood(v)` over terms with fields `v`
+// and `bias`. The neighborhoods of a dimod model are already sorted and free
+// of duplicates, but `options` is applied all the same.
+template <class Weight = double, class BQM>
+BasicAdjacency<Weight> build_adjacency(
+    const BQM& bqm,
+    const AdjacencyOptions& options = AdjacencyOptions()
+) {
+    const int num_vars = bqm.num_variables();
+
+    BasicAdjacency<Weight> adj;
+    adj.offsets.assign(num_vars + 1, 0);
+    for (int v = 0; v < num_vars; v++) {
+        adj.offsets[v + 1] = adj.offsets[v] +
+            (bqm.cend_neighborhood(v) - bqm.cbegin_neighborhood(v));
+    }
+
+    adj.neighbors.reserve(adj.offsets[num_vars]);
+    for (int v = 0; v < num_vars; v++) {
+        for (auto it = bqm.cbegin_neighborhood(v); it != bqm.cend_neighborhood(v); ++it) {
+            adj.neighbors.push_back({static_cast<std::int32_t>(it->v),
+                                     static_cast<Weight>(it->bias)});
+        }
+    }
+
+    arrange_adjacency(adj, options);
+    return adj;
+}
+
+// A SPIN-valued problem: the linear biases and the adjacency of the couplers.
+// Samplers only ever read it, so once built it can be shared between them
+// (typically through a `std::shared_ptr<const IsingGraph>`), for instance to
+// post-process the samples of simulated annealing with steepest descent
+// without building the adjacency twice.
+struct IsingGraph {
+    std::vector<double> linear;
+    Adjacency adjacency;
+
+    int num_variables() const { return linear.size(); }
+};
+
+// Builds the graph of a problem from its linear biases and list of couplers,
+// see `build_adjacency`.
+inline IsingGraph build_ising_graph(
+    const std::vector<double>& linear,
+    const std::vector<int>& coupler_starts,
+    const std::vector<int>& coupler_ends,
+    const std::vector<double>& coupler_weights,
+    const AdjacencyOptions& options = AdjacencyOptions()
+) {
+    return {linear, build_adjacency(linear.size(), coupler_starts, coupler_ends,
+                                    coupler_weights, options)};
+}
+
+// Builds the graph of a SPIN-valued binary quadratic model, reading it in
+// place, see `build_adjacency`. `BQM` must also provide `linear(v)`. The
+// graph does not include the model's offset.
+template <class BQM>
+IsingGraph build_ising_graph(
+    const BQM& bqm,
+    const AdjacencyOptions& options = AdjacencyOptions()
+) {
+    IsingGraph graph;
+    graph.linear.resize(bqm.num_variables());
+    for (int v = 0; v < (int)graph.linear.size(); v++) {
+        graph.linear[v] = bqm.linear(v);
+    }
+    graph.adjacency = build_adjacency(bqm, options);
+    return graph;
+}
+
+// Returns the energy of a SPIN-valued `state` in O(num_vars), given the
+// energy delta of flipping each of its variables. With the local field
+// `f[v] = linear[v] + sum_u J[v][u] * state[u]`, flipping `v` changes the
+// energy by `-2 * state[v] * f[v]`, and the energy is
+// `sum_v state[v] * (linear[v] + f[v]) / 2`. A coupler from a variable to
+// itself only adds a constant to the energy, so the problem must have none.
+inline double state_energy_from_flip_energies(
+    const std::int8_t* state,
+    const std::vector<double>& linear,
+    const double* flip_energies
+) {
+    double energy = 0;
+    for (int v = 0; v < (int)linear.size(); v++) {
+        energy += .5 * state[v] * linear[v] - .25 * flip_energies[v];
+    }
+    return energy;
+}
+
+// The samplers keep track of the energy of each state incrementally, from the
+// energy deltas of the flips they make. When built with
+// DWAVE_SAMPLERS_VERIFY_ENERGY defined, they also recompute the energy of
+// every state they return, and `VERIFY_ENERGY` throws if the two disagree
+// beyond rounding errors. Otherwise the check, including the recomputation,
+// compiles to nothing.
+inline void verify_energy(const double tracked, const double exact) {
+    if (std::fabs(tracked - exact) > 1e-6 * std::max(1.0, std::fabs(exact))) {
+        throw std::runtime_error("tracked energy differs from the energy of the state");
+    }
+}
+
+#ifdef DWAVE_SAMPLERS_VERIFY_ENERGY
+#define VERIFY_ENERGY(tracked, exact) verify_energy((tracked), (exact))
+#else
+#define VERIFY_ENERGY(tracked, exact) ((void)0)
+#endif
+
+#endif
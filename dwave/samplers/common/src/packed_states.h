@@ -0,0 +1,76 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// Bit-packed states, one bit per variable, for samplers returning many states
+// of large problems. A bit is set when its variable takes the upper value of
+// its vartype: +1 for SPIN, 1 for BINARY. Each state is a row of
+// `packed_row_bytes(num_vars)` bytes, and the first variable of each byte is
+// its most significant bit, which is the layout of
+// `numpy.packbits(states > 0, axis=1)`, so rows can also be unpacked with
+// `numpy.unpackbits(packed, axis=1, count=num_vars)`.
+
+#ifndef _packed_states_h
+#define _packed_states_h
+
+#include <cstddef>
+#include <cstdint>
+
+// The number of bytes of a packed state of `num_vars` variables
+inline std::size_t packed_row_bytes(const int num_vars) {
+    return (static_cast<std::size_t>(num_vars) + 7) / 8;
+}
+
+// Packs `state`, of SPIN or BINARY values, into `row`
+inline void pack_state(const std::int8_t* state, const int num_vars, std::uint8_t* row) {
+    for (std::size_t byte = 0; byte < packed_row_bytes(num_vars); byte++) row[byte] = 0;
+    for (int v = 0; v < num_vars; v++) {
+        if (state[v] > 0) row[v >> 3] |= 0x80 >> (v & 7);
+    }
+}
+
+// Unpacks `row` into `state`, as SPIN values if `is_spin` and otherwise as
+// BINARY values
+inline void unpack_state(
+    const std::uint8_t* row,
+    const int num_vars,
+    const bool is_spin,
+    std::int8_t* state
+) {
+    const std::int8_t low = is_spin ? -1 : 0;
+    const std::int8_t high = 1;
+    for (int v = 0; v < num_vars; v++) {
+        state[v] = (row[v >> 3] & (0x80 >> (v & 7))) ? high : low;
+    }
+}
+
+// Unpacks `num_states` consecutive packed rows into states `stride` bytes
+// apart, eg. into the sample field of a `dimod.SampleSet` record, without an
+// intermediate unpacked copy
+inline void unpack_states(
+    const std::uint8_t* packed,
+    const std::int64_t num_states,
+    const int num_vars,
+    const bool is_spin,
+    std::int8_t* states,
+    const std::ptrdiff_t stride
+) {
+    const std::size_t row_bytes = packed_row_bytes(num_vars);
+    for (std::int64_t i = 0; i < num_states; i++) {
+        unpack_state(packed + i * row_bytes, num_vars, is_spin, states + i * stride);
+    }
+}
+
+#endif
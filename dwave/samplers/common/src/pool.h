@@ -0,0 +1,401 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// The worker threads shared by the parallel loops of all of the kernels. A
+// loop runs on its calling thread together with workers of a process-wide
+// pool, rather than on threads of its own, so that samplers composed with one
+// another (eg. annealing followed by a descent, inside an outer thread pool)
+// share a bounded number of threads instead of each starting theirs.
+//
+// Each worker has a deque of tasks. The tasks a worker submits go to the back
+// of its own deque, and those submitted by other threads go to a queue shared
+// by all of the workers. A worker runs the tasks at the back of its deque
+// first, then those of the shared queue, and then steals from the front of
+// the deques of the other workers.
+
+#ifndef _pool_h
+#define _pool_h
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+class WorkerPool {
+  public:
+    // @param num_threads the number of workers, or 0 for
+    //        `default_num_threads()`. They are started by the first loop
+    //        that needs them.
+    // @param pin whether to pin the workers to CPUs, see `configure`
+    explicit WorkerPool(const int num_threads = 0, const bool pin = default_pin())
+        : num_threads_(num_threads > 0 ? num_threads : default_num_threads()),
+          pin_(pin) {}
+
+    ~WorkerPool() {
+        std::lock_guard<std::mutex> guard(start_lock_);
+        stop();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // The number of workers, given by the DWAVE_SAMPLERS_NUM_THREADS
+    // environment variable if it is set, and otherwise the number of CPUs.
+    static int default_num_threads() {
+        const char* value = std::getenv("DWAVE_SAMPLERS_NUM_THREADS");
+        if (value && std::atoi(value) > 0) return std::atoi(value);
+        return std::max<int>(1, std::thread::hardware_concurrency());
+    }
+
+    // Whether the workers are pinned, given by the DWAVE_SAMPLERS_PIN_THREADS
+    // environment variable.
+    static bool default_pin() {
+        const char* value = std::getenv("DWAVE_SAMPLERS_PIN_THREADS");
+        return value && std::atoi(value) > 0;
+    }
+
+    int num_threads() const {
+        std::lock_guard<std::mutex> guard(config_lock_);
+        return num_threads_;
+    }
+
+    bool pinned() const {
+        std::lock_guard<std::mutex> guard(config_lock_);
+        return pin_;
+    }
+
+    // Replaces the workers by `num_threads` new ones (or
+    // `default_num_threads()` if it is 0), once the current ones have run all
+    // of the tasks submitted so far.
+    //
+    // If `pin` is true, the workers are pinned to the CPUs the process may run
+    // on, taken node by node on a NUMA system, so that consecutive workers
+    // share a node. The kernels allocate their scratch buffers on the thread
+    // that uses them, so with the first-touch policy of the OS the buffers of
+    // a pinned worker are on its local node. Pinning is only supported on
+    // Linux, and is ignored elsewhere.
+    //
+    // Must not be called by a task of the pool.
+    void configure(const int num_threads, const bool pin) {
+        if (current_pool_ == this) {
+            throw std::logic_error("a worker pool cannot be configured by one of its tasks");
+        }
+        std::lock_guard<std::mutex> guard(start_lock_);
+        stop();
+        std::lock_guard<std::mutex> config_guard(config_lock_);
+        num_threads_ = num_threads > 0 ? num_threads : default_num_threads();
+        pin_ = pin;
+    }
+
+    // Calls `body()` on the calling thread and on up to `num_threads - 1`
+    // workers, and returns once all of the calls have returned. The workers
+    // that have not started their call by the time the calling thread's call
+    // returns skip it, so a `body` that claims its work from a shared counter,
+    // and returns once there is none left, does all of the work even when no
+    // worker is free, in particular when the calling thread is a worker
+    // itself (nested parallelism). The first exception thrown by a call is
+    // rethrown.
+    template <class Body>
+    void run(const int num_threads, Body& body) {
+        run(num_threads, body, body);
+    }
+
+    // Same as above, but the calling thread calls `caller()` rather than
+    // `body()`, eg. to poll for interrupts while the workers do the work.
+    template <class Body, class Caller>
+    void run(const int num_threads, Body& body, Caller& caller) {
+        const int num_helpers = std::min(num_threads, this->num_threads() + 1) - 1;
+        if (num_helpers < 1) {
+            caller();
+            return;
+        }
+
+        const std::function<void()> call = [&body]() { body(); };
+        auto region = std::make_shared<Region>();
+        region->body = &call;
+        // the pool of a worker is running, and may be waiting for the worker
+        // to stop it
+        if (current_pool_ != this) start();
+        for (int i = 0; i < num_helpers; i++) submit(region);
+
+        std::exception_ptr error;
+        try {
+            caller();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        // the helpers that have not started never will
+        std::unique_lock<std::mutex> guard(region->lock);
+        region->closed = true;
+        region->done.wait(guard, [&]() { return region->active == 0; });
+        if (!error) error = region->error;
+        guard.unlock();
+
+        if (error) std::rethrow_exception(error);
+    }
+
+  private:
+    // The calls of a `run` on the workers.
+    struct Region {
+        std::mutex lock;
+        std::condition_variable done;
+        const std::function<void()>* body = nullptr;
+        // whether the calling thread's call has returned
+        bool closed = false;
+        // the number of workers calling `body`
+        int active = 0;
+        std::exception_ptr error;
+
+        void help() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (closed) return;
+                active++;
+            }
+            std::exception_ptr body_error;
+            try {
+                (*body)();
+            } catch (...) {
+                body_error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            if (body_error && !error) error = body_error;
+            if (--active == 0) done.notify_all();
+        }
+    };
+    typedef std::shared_ptr<Region> Task;
+
+    struct Worker {
+        std::mutex lock;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    // Starts the workers, if they are not running.
+    void start() {
+        std::lock_guard<std::mutex> guard(start_lock_);
+        if (!workers_.empty()) return;
+
+        std::vector<int> cpus;
+        if (pinned()) cpus = node_major_cpus();
+
+        stopping_ = false;
+        const int n = num_threads();
+        for (int i = 0; i < n; i++) workers_.emplace_back(new Worker);
+        for (int i = 0; i < n; i++) {
+            const int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+            workers_[i]->thread = std::thread(&WorkerPool::work, this, i, cpu);
+        }
+    }
+
+    // Stops and joins the workers, once every task is done. The caller holds
+    // `start_lock_`.
+    void stop() {
+        if (workers_.empty()) return;
+        {
+            std::lock_guard<std::mutex> sleep_guard(sleep_lock_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) worker->thread.join();
+        workers_.clear();
+    }
+
+    void submit(const Task& task) {
+        if (current_pool_ == this) {
+            Worker& worker = *workers_[current_index_];
+            std::lock_guard<std::mutex> guard(worker.lock);
+            worker.tasks.push_back(task);
+        } else {
+            std::lock_guard<std::mutex> guard(shared_lock_);
+            shared_.push_back(task);
+        }
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock_);
+            queued_++;
+        }
+        wake_.notify_one();
+    }
+
+    // Takes the next task for worker `index`, or returns null if there is
+    // none.
+    Task take(const int index) {
+        Task task;
+        {
+            Worker& own = *workers_[index];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+            }
+        }
+        if (!task) {
+            std::lock_guard<std::mutex> guard(shared_lock_);
+            if (!shared_.empty()) {
+                task = std::move(shared_.front());
+                shared_.pop_front();
+            }
+        }
+        for (int i = 1; !task && i < (int)workers_.size(); i++) {
+            Worker& victim = *workers_[(index + i) % workers_.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+        if (task) queued_--;
+        return task;
+    }
+
+    void work(const int index, const int cpu) {
+        current_pool_ = this;
+        current_index_ = index;
+        if (cpu >= 0) pin_to(cpu);
+
+        for (;;) {
+            if (Task task = take(index)) {
+                task->help();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> guard(sleep_lock_);
+            wake_.wait(guard, [&]() { return stopping_ || queued_ > 0; });
+            if (queued_ == 0) return;
+        }
+    }
+
+    // The CPUs the process may run on, node by node.
+    static std::vector<int> node_major_cpus() {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return cpus;
+
+        std::vector<bool> taken(CPU_SETSIZE, false);
+        auto add = [&](const int cpu) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed) && !taken[cpu]) {
+                taken[cpu] = true;
+                cpus.push_back(cpu);
+            }
+        };
+
+        // eg. "0-3,8-11"
+        for (int node = 0;; node++) {
+            std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!list) break;
+            std::string range;
+            while (std::getline(list, range, ',')) {
+                const std::size_t dash = range.find('-');
+                const int first = std::atoi(range.c_str());
+                const int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+                for (int cpu = first; cpu <= last; cpu++) add(cpu);
+            }
+        }
+        // the CPUs of no node, or all of them if there is no node information
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) add(cpu);
+#endif
+        return cpus;
+    }
+
+    static void pin_to(const int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        static_cast<void>(cpu);
+#endif
+    }
+
+    // guards the configuration, and is taken after `start_lock_` when both are
+    mutable std::mutex config_lock_;
+    int num_threads_;
+    bool pin_;
+
+    // guards `workers_` while the workers are started or stopped
+    std::mutex start_lock_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex shared_lock_;
+    std::deque<Task> shared_;
+
+    // guards the changes of `queued_` that can wake a worker, and `stopping_`
+    std::mutex sleep_lock_;
+    std::condition_variable wake_;
+    std::atomic<long long> queued_{0};
+    bool stopping_ = false;
+
+    // the pool and the index of the worker that the calling thread is, if any
+    static inline thread_local WorkerPool* current_pool_ = nullptr;
+    static inline thread_local int current_index_ = -1;
+};
+
+// The pool installed by `set_worker_pool`, if any.
+inline std::atomic<WorkerPool*>& installed_worker_pool() {
+    static std::atomic<WorkerPool*> pool(nullptr);
+    return pool;
+}
+
+// Makes the kernels run their parallel loops on `pool`, eg. so that all of the
+// kernels of a process, however many copies of them it has loaded, share the
+// same workers. If `pool` is null, they use a pool of their own again.
+inline void set_worker_pool(WorkerPool* pool) {
+    installed_worker_pool() = pool;
+}
+
+// The pool the kernels run their parallel loops on: the pool installed by
+// `set_worker_pool`, or else one of their own, of
+// `WorkerPool::default_num_threads()` workers, which lives as long as the
+// process does.
+inline WorkerPool& worker_pool() {
+    if (WorkerPool* pool = installed_worker_pool()) return *pool;
+    // never destroyed, so that it outlives any loop running at exit
+    static WorkerPool* own = new WorkerPool();
+    return *own;
+}
+
+// Calls `body()` on up to `num_threads` threads, of which the calling thread
+// is one, see `WorkerPool::run`. If `num_threads` is less than two, `body` is
+// only called on the calling thread, and no worker is started.
+template <class Body>
+void run_parallel(const int num_threads, Body& body) {
+    if (num_threads < 2) {
+        body();
+    } else {
+        worker_pool().run(num_threads, body);
+    }
+}
+
+#endif
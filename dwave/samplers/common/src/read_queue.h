@@ -0,0 +1,166 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// A bounded queue through which a sampler running on its own threads hands
+// the reads it completes to a consumer (typically Python) while it keeps
+// sampling. Reads are identified by their index: the sampler writes the
+// state and energy of a read into its output buffers and then pushes the
+// index, and the consumer may read them as soon as it pops the index.
+
+#ifndef _read_queue_h
+#define _read_queue_h
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// A bounded lock-free queue of read indices, with any number of producers and
+// consumers (the ring buffer of Dmitry Vyukov's bounded MPMC queue). Each cell
+// has a sequence number telling whether it is free for the push or ready for
+// the pop of a given position, so neither takes a lock. Pushing a read
+// releases, and popping it acquires, the writes made before the push, ie. the
+// state and energy of the read.
+//
+// When the queue is full, `push` waits for room, so a slow consumer holds
+// the producers back rather than losing reads. A consumer that gives up calls
+// `close`, after which pushes return at once, and the producers call `finish`
+// once they have pushed every read, after which a consumer that finds the
+// queue empty knows it is done.
+class ReadQueue {
+  public:
+    // The capacity is rounded up to a power of two.
+    explicit ReadQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask_ = size - 1;
+        cells_.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enqueue_pos_.store(0, std::memory_order_relaxed);
+        dequeue_pos_.store(0, std::memory_order_relaxed);
+    }
+
+    ReadQueue(const ReadQueue&) = delete;
+    ReadQueue& operator=(const ReadQueue&) = delete;
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    // Pushes `read` if there is room, and returns whether it did.
+    bool try_push(const int read) {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t dif = (std::intptr_t)seq - (std::intptr_t)pos;
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->read = read;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pushes `read`, waiting for room while the queue is full. Returns false,
+    // without pushing, if the queue is or gets closed.
+    bool push(const int read) {
+        while (!closed()) {
+            if (try_push(read)) return true;
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+    // Pops a read into `read` if there is one, and returns whether it did.
+    bool try_pop(int& read) {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t dif = (std::intptr_t)seq - (std::intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        read = cell->read;
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pops up to `max_reads` reads into `reads`, waiting up to `timeout`
+    // seconds for the first one unless the queue is finished. Returns the
+    // number of reads popped.
+    std::size_t pop(int* reads, const std::size_t max_reads, const double timeout) {
+        const auto deadline = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(std::max(timeout, 0.0)));
+        std::chrono::microseconds backoff(10);
+
+        std::size_t num_popped = 0;
+        for (;;) {
+            // a finished queue is empty once a pop after finishing finds nothing
+            const bool was_finished = finished();
+            while (num_popped < max_reads && try_pop(reads[num_popped])) num_popped++;
+            if (num_popped || was_finished || max_reads == 0) return num_popped;
+
+            if (std::chrono::steady_clock::now() >= deadline) return 0;
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min(backoff * 2, std::chrono::microseconds(1000));
+        }
+    }
+
+    // The consumer stops taking reads: pushes no longer wait.
+    void close() { closed_.store(true, std::memory_order_release); }
+    bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+    // The producers have pushed every read.
+    void finish() { finished_.store(true, std::memory_order_release); }
+    bool finished() const { return finished_.load(std::memory_order_acquire); }
+
+  private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        int read;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_;
+    alignas(64) std::atomic<std::size_t> dequeue_pos_;
+    std::atomic<bool> closed_{false};
+    std::atomic<bool> finished_{false};
+};
+
+#endif
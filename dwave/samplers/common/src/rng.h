@@ -0,0 +1,89 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// The random number generator shared by the samplers: xorshift128+, split
+// into independent streams. The state of a stream only depends on the seed
+// and on the index of the stream, eg. the index of a read, so a sampler that
+// gives each read (or block of reads) its own stream returns the same results
+// for a given seed whichever thread runs each read, and seeding a stream is
+// cheap enough to do once per read.
+
+#ifndef _rng_h
+#define _rng_h
+
+#include <cstdint>
+#include <limits>
+
+// splitmix64 as defined https://prng.di.unimi.it/splitmix64.c, advances `x`
+// and returns the next output
+inline std::uint64_t splitmix64(std::uint64_t &x) {
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// xorshift128+ as defined https://en.wikipedia.org/wiki/Xorshift#xorshift.2B,
+// advances the two words of `state` and returns the next output
+inline std::uint64_t xorshift128p(std::uint64_t* state) {
+    std::uint64_t x = state[0];
+    std::uint64_t const y = state[1];
+    state[0] = y;
+    x ^= x << 23;
+    state[1] = x ^ y ^ (x >> 17) ^ (y >> 26);
+    return state[1] + y;
+}
+
+// Seeds the two words of `state` with stream `stream` of `seed`. The streams
+// are decorrelated by hashing their index with splitmix64, so consecutive
+// indices give unrelated streams.
+inline void seed_stream(std::uint64_t* state, const std::uint64_t seed, std::uint64_t stream) {
+    std::uint64_t x = seed ^ splitmix64(stream);
+    state[0] = splitmix64(x);
+    state[1] = splitmix64(x);
+    // note that xorshift+ requires a non-zero state
+    if (!state[0] && !state[1]) state[0] = std::numeric_limits<std::uint64_t>::max();
+}
+
+// One stream of xorshift128+, see `seed_stream`. It is a standard uniform
+// random bit generator, so it can also be used with the distributions of
+// <random>.
+class StreamRng {
+  public:
+    typedef std::uint64_t result_type;
+
+    explicit StreamRng(const std::uint64_t seed = 0, const std::uint64_t stream = 0) {
+        seed_stream(state_, seed, stream);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() { return xorshift128p(state_); }
+
+    // Returns a uniform double in [0, 1), from the upper 53 bits of an output
+    double uniform() { return (operator()() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Returns a uniform integer in [0, n), for 0 < n <= 2^53
+    std::uint64_t below(const std::uint64_t n) {
+        return static_cast<std::uint64_t>(uniform() * n);
+    }
+
+  private:
+    std::uint64_t state_[2];
+};
+
+#endif
@@ -0,0 +1,34 @@
+# Copyright 2026 D-Wave Systems Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from libcpp cimport bool
+
+cdef extern from "read_queue.h":
+    cdef cppclass cppReadQueue "ReadQueue":
+        cppReadQueue(size_t capacity) except +
+        size_t capacity()
+        size_t pop(int* reads, size_t max_reads, double timeout) nogil
+        void close() nogil
+        bool closed() nogil
+        void finish() nogil
+        bool finished() nogil
+
+cdef class ReadQueue:
+    cdef cppReadQueue* queue
+    cdef readonly object states
+    cdef readonly object energies
+    cdef object vectors
+    cdef object variables
+    cdef object offset
+    cdef object vartype
@@ -0,0 +1,212 @@
+# distutils: language = c++
+# distutils: include_dirs = dwave/samplers/common/src/
+# cython: language_level = 3
+
+# Copyright 2026 D-Wave Systems Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import threading
+from time import perf_counter
+
+import dimod
+import numpy as np
+cimport numpy as np
+
+__all__ = ['ReadQueue', 'stream']
+
+
+cdef class ReadQueue:
+    """Wraps `ReadQueue` from `read_queue.h`. A bounded queue through which a
+    sampler running natively, without the GIL, hands over each read as soon
+    as it is complete.
+
+    The sampler writes the state and energy of a read into the arrays given
+    to :meth:`attach` and then pushes the index of the read, so a consumer
+    can turn the popped reads into a sample set while the other reads are
+    still being sampled. When the queue is full the sampler waits for the
+    consumer, and once the consumer calls :meth:`close` the sampler no longer
+    waits and runs to completion.
+
+    Most users want a sampler's ``sample_stream`` method, see :func:`stream`,
+    rather than this class.
+
+    Parameters
+    ----------
+    capacity : int, optional, default=1024
+        The number of reads the queue holds, rounded up to a power of two.
+
+    """
+    def __cinit__(self, capacity=1024):
+        if capacity < 1:
+            raise ValueError("capacity must be a positive integer")
+        self.queue = new cppReadQueue(capacity)
+        self.vectors = {}
+
+    def __dealloc__(self):
+        del self.queue
+
+    @property
+    def capacity(self):
+        """int: The number of reads the queue holds."""
+        return self.queue.capacity()
+
+    def attach(self, states, energies, **vectors):
+        """Sets the arrays the sampler writes the states and energies of the
+        reads into, and any other per-read data `vectors` of the sample sets.
+        Called by the sampler before it starts."""
+        self.states = states
+        self.energies = energies
+        self.vectors = vectors
+
+    def describe(self, variables, offset, vartype):
+        """Sets how the states are turned into sample sets: their variables,
+        the offset added to the energies and the vartype of the model. The
+        states are SPIN-valued."""
+        self.variables = variables
+        self.offset = offset
+        self.vartype = vartype
+
+    def pop(self, max_reads=None, timeout=None):
+        """Pops the index of up to `max_reads` completed reads, all of them
+        if None, waiting up to `timeout` seconds, or indefinitely if None,
+        for the first one unless the queue is finished.
+
+        Returns
+        -------
+        numpy.ndarray
+            The indices of the reads popped, empty if there were none.
+
+        """
+        cdef size_t _max_reads = self.queue.capacity() if max_reads is None else max_reads
+        reads_numpy = np.empty(max(_max_reads, 1), dtype=np.intc)
+        cdef int[:] reads = reads_numpy
+        cdef size_t num_popped = 0
+        cdef bint finished
+        cdef double wait
+
+        # wait in short steps, so that signals such as KeyboardInterrupt are
+        # handled while waiting
+        deadline = None if timeout is None else perf_counter() + timeout
+        while True:
+            finished = self.queue.finished()
+            wait = 0.1 if deadline is None else min(max(deadline - perf_counter(), 0), 0.1)
+            with nogil:
+                num_popped = self.queue.pop(&reads[0], _max_reads, wait)
+            if num_popped or finished or not _max_reads:
+                break
+            if deadline is not None and perf_counter() >= deadline:
+                break
+        return reads_numpy[:num_popped]
+
+    def close(self):
+        """Stops taking reads, so that the sampler no longer waits for room."""
+        self.queue.close()
+
+    def closed(self):
+        """bool: Whether the queue is closed."""
+        return self.queue.closed()
+
+    def finish(self):
+        """Marks every read as pushed. Called once the sampler returns."""
+        self.queue.finish()
+
+    def finished(self):
+        """bool: Whether every read has been pushed."""
+        return self.queue.finished()
+
+    def sampleset(self, reads):
+        """Returns the sample set of the popped `reads`."""
+        reads = np.sort(np.asarray(reads, dtype=np.intp))
+        sampleset = dimod.SampleSet.from_samples(
+            (self.states[reads], self.variables),
+            energy=self.energies[reads] + self.offset,
+            vartype=dimod.SPIN,
+            **{name: vector[reads] for name, vector in self.vectors.items()}
+        )
+        sampleset.change_vartype(self.vartype, inplace=True)
+        return sampleset
+
+
+def stream(run, ReadQueue queue not None, batch_size=None):
+    """Yields the reads of a sampler as sample sets while it is still
+    sampling.
+
+    Parameters
+    ----------
+    run : callable
+        Runs the sampler with `queue` and returns its sample set. It is
+        called on a separate thread, so the sampler must release the GIL
+        while it samples.
+
+    queue : :class:`ReadQueue`
+        The queue `run` hands the reads over through.
+
+    batch_size : int, optional
+        The largest number of reads in a sample set. By default each sample
+        set holds all of the reads completed since the last one.
+
+    Yields
+    ------
+    :class:`dimod.SampleSet`
+        The reads completed since the last sample set, for the variables of
+        the model. If the sampler hands over no reads, for instance if it has
+        no variables or ends before the first read, the complete sample set
+        is yielded instead.
+
+    Returns
+    -------
+    :class:`dimod.SampleSet`
+        The sample set returned by `run`, with its info field, as the value
+        of the ``StopIteration``. Closing the generator early lets the
+        sampler run to completion without waiting for a consumer.
+
+    """
+    if batch_size is not None and batch_size < 1:
+        raise ValueError("batch_size must be a positive integer")
+
+    result = []
+    errors = []
+
+    def target():
+        try:
+            result.append(run())
+        except BaseException as err:
+            errors.append(err)
+        finally:
+            queue.finish()
+
+    thread = threading.Thread(target=target, daemon=True)
+    thread.start()
+
+    num_yielded = 0
+    try:
+        while True:
+            # the queue is drained once a pop after it finished finds nothing
+            finished = queue.finished()
+            reads = queue.pop(batch_size)
+            if not len(reads):
+                if finished:
+                    break
+                continue
+            num_yielded += len(reads)
+            yield queue.sampleset(reads)
+    finally:
+        queue.close()
+        thread.join()
+
+    if errors:
+        raise errors[0]
+    if not num_yielded:
+        yield result[0]
+    return result[0]
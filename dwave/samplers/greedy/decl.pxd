@@ -12,13 +12,21 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-from libcpp cimport bool
+from libc.stdint cimport int64_t, uint64_t
 from libcpp.vector cimport vector
 
+from dimod.cyqmbase.cyqmbase_float64 cimport bias_type, index_type
+from dimod.libcpp.binary_quadratic_model cimport BinaryQuadraticModel as cppBinaryQuadraticModel
 cimport numpy as np
 
+from dwave.samplers.common.graph cimport cppIsingGraph
+from dwave.samplers.common.stream cimport cppReadQueue
+
 cdef extern from "descent.h":
 
+    ctypedef enum DescentSolver:
+        LinearSearch, OrderedSet, IndexedHeap
+
     unsigned int steepest_gradient_descent(
         np.int8_t* states,
         double* energies,
@@ -28,5 +36,77 @@ cdef extern from "descent.h":
         const vector[int]& coupler_starts,
         const vector[int]& coupler_ends,
         const vector[double]& coupler_weights,
-        bool large_sparse_opt
+        DescentSolver solver,
+        int num_threads
+    ) nogil
+
+    void steepest_gradient_descent(
+        np.int8_t* states,
+        double* energies,
+        unsigned* num_steps,
+        const int num_samples,
+        const cppBinaryQuadraticModel[bias_type, index_type]& bqm,
+        DescentSolver solver,
+        int num_threads,
+        cppReadQueue* completed
+    ) nogil
+
+    void steepest_gradient_descent(
+        np.int8_t* states,
+        double* energies,
+        unsigned* num_steps,
+        const int num_samples,
+        const cppIsingGraph& graph,
+        DescentSolver solver,
+        int num_threads,
+        cppReadQueue* completed
     ) nogil
+
+    void iterated_local_search(
+        np.int8_t* states,
+        double* energies,
+        unsigned* num_steps,
+        const int num_samples,
+        const cppBinaryQuadraticModel[bias_type, index_type]& bqm,
+        const int perturbation_size,
+        const int64_t max_iterations,
+        const double time_limit,
+        const uint64_t seed,
+        int num_threads,
+        cppReadQueue* completed
+    ) except + nogil
+
+    cdef cppclass cppDescentState "DescentState":
+        cppDescentState(
+            const cppIsingGraph& graph,
+            const np.int8_t* initial_states,
+            const int num_samples,
+            unsigned* num_steps,
+            int num_threads
+        ) except + nogil
+
+        void update(
+            const vector[int]& linear_vars,
+            const vector[double]& linear_deltas,
+            const vector[int]& coupler_starts,
+            const vector[int]& coupler_ends,
+            const vector[double]& coupler_deltas,
+            unsigned* num_steps,
+            int num_threads
+        ) except + nogil
+
+        int num_variables()
+        int num_samples()
+        const np.int8_t* states()
+        const double* energies()
+
+    void steepest_gradient_descent_batch(
+        const vector[cppBinaryQuadraticModel[bias_type, index_type]*]& bqms,
+        np.int8_t* states,
+        double* energies,
+        unsigned* num_steps,
+        const int num_samples,
+        const uint64_t seed,
+        DescentSolver solver,
+        int num_threads
+    ) except + nogil
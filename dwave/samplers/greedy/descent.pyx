@@ -1,6 +1,6 @@
 # distutils: language = c++
 # distutils: include_dirs = greedy/src/
-# distutils: include_dirs = dwave/samplers/greedy/src/
+# distutils: include_dirs = dwave/samplers/greedy/src/ dwave/samplers/common/src/
 # distutils: sources = dwave/samplers/greedy/src/descent.cpp
 
 # Copyright 2019 D-Wave Systems Inc.
@@ -17,19 +17,35 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-from libcpp cimport bool
+from cython.operator cimport dereference as deref
+from libc.stdint cimport int64_t, uint64_t
+from libc.string cimport memcpy
+from libcpp.memory cimport unique_ptr
 from libcpp.vector cimport vector
 
+import dimod
+cimport dimod
+from dimod.cyqmbase.cyqmbase_float64 cimport bias_type, index_type
+from dimod.libcpp.binary_quadratic_model cimport BinaryQuadraticModel as cppBinaryQuadraticModel
 import numpy as np
 cimport numpy as np
 
 cimport dwave.samplers.greedy.decl as decl
+from dwave.samplers.common.graph cimport (
+    AdjacencyOptions, IsingGraph, build_ising_graph_bqm, cppIsingGraph)
+from dwave.samplers.common.stream cimport ReadQueue
+from dwave.samplers.common.pool cimport set_worker_pool, shared_worker_pool
+
+# run the parallel loops of the kernels on the workers shared by all samplers
+set_worker_pool(shared_worker_pool())
 
 def steepest_gradient_descent(num_samples,
                               linear_biases,
                               coupler_starts, coupler_ends, coupler_weights,
                               np.ndarray[np.int8_t, ndim=2, mode="c"] states_numpy,
-                              large_sparse_opt=False):
+                              large_sparse_opt=False,
+                              solver=None,
+                              num_threads=1):
 
     """Wraps `steepest_gradient_descent` from `descent.cpp`. Accepts
     an Ising problem defined on a general graph and returns samples
@@ -65,6 +81,16 @@ def steepest_gradient_descent(num_samples,
     large_sparse_opt : bool
         When set to True, large-and-sparse problem graph optimizations are used.
 
+    solver : str, optional
+        The data structure used to find the steepest descent variable:
+        'linear' (linear search), 'tree' (ordered set) or 'heap' (indexed
+        binary heap). If not given, 'tree' is used if `large_sparse_opt` is
+        True, and 'linear' otherwise. All of them give the same descents.
+
+    num_threads : int
+        The number of threads to distribute the samples over. The results do
+        not depend on the number of threads.
+
     Returns
     -------
     samples : numpy.ndarray
@@ -98,7 +124,8 @@ def steepest_gradient_descent(num_samples,
     cdef double* _energies = &energies[0]
     cdef unsigned* _num_steps = &num_steps[0]
     cdef int _num_samples = num_samples
-    cdef bool _large_sparse_opt = large_sparse_opt
+    cdef decl.DescentSolver _solver = _descent_solver(large_sparse_opt, solver)
+    cdef int _num_threads = num_threads
     cdef vector[double] _linear_biases = linear_biases
 
     # TODO: in dimod 0.10+, coupler indices default to int64, but we downcast
@@ -112,6 +139,509 @@ def steepest_gradient_descent(num_samples,
         decl.steepest_gradient_descent(
             _states, _energies, _num_steps, _num_samples,
             _linear_biases, _coupler_starts, _coupler_ends, _coupler_weights,
-            _large_sparse_opt)
+            _solver, _num_threads)
 
     return states_numpy, energies_numpy, num_steps_numpy
+
+
+def steepest_gradient_descent_bqm(num_samples, bqm,
+                                  np.ndarray[np.int8_t, ndim=2, mode="c"] states_numpy,
+                                  large_sparse_opt=False,
+                                  solver=None,
+                                  num_threads=1,
+                                  ReadQueue read_queue=None):
+    """Wraps `steepest_gradient_descent` from `descent.h`, reading the biases
+    of a spin-valued binary quadratic model directly from its C++ adjacency
+    rather than from flattened arrays.
+
+    Parameters
+    ----------
+    num_samples : int
+        Number of samples to get from the sampler.
+
+    bqm : dimod.BinaryQuadraticModel
+        A spin-valued binary quadratic model. Models with biases other than
+        float64 are copied first.
+
+    states_numpy : np.ndarray[np.int8_t, ndim=2, mode="c"], values in (-1, 1)
+        The initial seeded states of the gradient descent runs. Should be of
+        a contiguous numpy.ndarray of shape (num_samples, num_variables),
+        with the columns in the order of ``bqm.variables``.
+
+    large_sparse_opt : bool
+        When set to True, large-and-sparse problem graph optimizations are used.
+
+    solver : str, optional
+        See :func:`steepest_gradient_descent`.
+
+    num_threads : int
+        See :func:`steepest_gradient_descent`.
+
+    read_queue : :class:`~dwave.samplers.common.stream.ReadQueue`, optional
+        If given, the index of each sample is pushed to it as soon as its
+        descent is done.
+
+    Returns
+    -------
+    samples : numpy.ndarray
+        A 2D numpy array where each row is a sample.
+
+    energies: numpy.ndarray
+        Sample energies, not including the offset of `bqm`.
+
+    num_steps: numpy.ndarray
+        Number of downhill steps per sample.
+    """
+    if bqm.vartype is not dimod.SPIN:
+        raise ValueError("bqm must be spin-valued")
+
+    cdef dimod.cyBQM_float64 cybqm = dimod.as_bqm(bqm, dtype=float).data
+    num_vars = cybqm.num_variables()
+
+    # short-circuit null edge cases
+    if num_samples == 0 or num_vars == 0:
+        states = np.empty((num_samples, num_vars), dtype=np.int8)
+        return (states,
+                np.zeros(num_samples, dtype=np.double),
+                np.zeros(num_samples, dtype=np.uint32))
+
+    if states_numpy.shape[0] != num_samples or states_numpy.shape[1] != num_vars:
+        raise ValueError("states_numpy must have shape (num_samples, num_variables)")
+
+    # allocate ndarray for energies
+    energies_numpy = np.empty(num_samples, dtype=np.float64)
+    cdef double[:] energies = energies_numpy
+
+    # allocate ndarray for steps
+    num_steps_numpy = np.empty(num_samples, dtype=np.uint32)
+    cdef unsigned[:] num_steps = num_steps_numpy
+
+    # explicitly convert all Python types to C while we have the GIL
+    cdef np.int8_t* _states = &states_numpy[0, 0]
+    cdef double* _energies = &energies[0]
+    cdef unsigned* _num_steps = &num_steps[0]
+    cdef int _num_samples = num_samples
+    cdef decl.DescentSolver _solver = _descent_solver(large_sparse_opt, solver)
+    cdef int _num_threads = num_threads
+    cdef decl.cppReadQueue* _completed = NULL
+    if read_queue is not None:
+        read_queue.attach(states_numpy, energies_numpy, num_steps=num_steps_numpy)
+        _completed = read_queue.queue
+
+    with nogil:
+        decl.steepest_gradient_descent(
+            _states, _energies, _num_steps, _num_samples,
+            deref(cybqm.data()), _solver, _num_threads, _completed)
+
+    return states_numpy, energies_numpy, num_steps_numpy
+
+
+cdef decl.DescentSolver _descent_solver(large_sparse_opt, solver) except *:
+    if solver is None:
+        solver = 'tree' if large_sparse_opt else 'linear'
+    if solver == 'linear':
+        return decl.LinearSearch
+    elif solver == 'tree':
+        return decl.OrderedSet
+    elif solver == 'heap':
+        return decl.IndexedHeap
+    raise ValueError(f"Unknown solver: {solver!r}")
+
+
+def steepest_gradient_descent_graph(num_samples, IsingGraph graph not None,
+                                    np.ndarray[np.int8_t, ndim=2, mode="c"] states_numpy,
+                                    large_sparse_opt=False,
+                                    solver=None,
+                                    num_threads=1):
+    """Wraps `steepest_gradient_descent` from `descent.h`, on a problem graph
+    that is built once and can be shared with other samplers.
+
+    Parameters
+    ----------
+    num_samples : int
+        Number of samples to get from the sampler.
+
+    graph : :class:`dwave.samplers.common.graph.IsingGraph`
+        The graph of the problem, for instance the one of an
+        :class:`~dwave.samplers.sa.simulated_annealing.AnnealingProblem`
+        whose samples are descended from.
+
+    states_numpy : np.ndarray[np.int8_t, ndim=2, mode="c"], values in (-1, 1)
+        The initial seeded states of the gradient descent runs. Should be of
+        a contiguous numpy.ndarray of shape (num_samples, num_variables).
+
+    large_sparse_opt : bool
+        When set to True, large-and-sparse problem graph optimizations are used.
+
+    solver : str, optional
+        See :func:`steepest_gradient_descent`.
+
+    num_threads : int
+        See :func:`steepest_gradient_descent`.
+
+    Returns
+    -------
+    samples : numpy.ndarray
+        A 2D numpy array where each row is a sample.
+
+    energies: numpy.ndarray
+        Sample energies.
+
+    num_steps: numpy.ndarray
+        Number of downhill steps per sample.
+    """
+    if graph.graph.get() == NULL:
+        raise ValueError("graph is not initialized")
+
+    num_vars = graph.num_variables
+
+    # short-circuit null edge cases
+    if num_samples == 0 or num_vars == 0:
+        states = np.empty((num_samples, num_vars), dtype=np.int8)
+        return (states,
+                np.zeros(num_samples, dtype=np.double),
+                np.zeros(num_samples, dtype=np.uint32))
+
+    if states_numpy.shape[0] != num_samples or states_numpy.shape[1] != num_vars:
+        raise ValueError("states_numpy must have shape (num_samples, num_variables)")
+
+    # allocate ndarray for energies
+    energies_numpy = np.empty(num_samples, dtype=np.float64)
+    cdef double[:] energies = energies_numpy
+
+    # allocate ndarray for steps
+    num_steps_numpy = np.empty(num_samples, dtype=np.uint32)
+    cdef unsigned[:] num_steps = num_steps_numpy
+
+    # explicitly convert all Python types to C while we have the GIL
+    cdef np.int8_t* _states = &states_numpy[0, 0]
+    cdef double* _energies = &energies[0]
+    cdef unsigned* _num_steps = &num_steps[0]
+    cdef int _num_samples = num_samples
+    cdef decl.DescentSolver _solver = _descent_solver(large_sparse_opt, solver)
+    cdef int _num_threads = num_threads
+
+    with nogil:
+        decl.steepest_gradient_descent(
+            _states, _energies, _num_steps, _num_samples,
+            deref(graph.graph), _solver, _num_threads, NULL)
+
+    return states_numpy, energies_numpy, num_steps_numpy
+
+
+def steepest_gradient_descent_batch(bqms, num_samples, seed,
+                                    large_sparse_opt=False,
+                                    solver=None,
+                                    num_threads=1):
+    """Wraps `steepest_gradient_descent_batch` from `descent.h`. Runs
+    steepest gradient descent from random initial states on each of a list
+    of spin-valued binary quadratic models, in a single native call that
+    spreads the models over `num_threads` threads.
+
+    Parameters
+    ----------
+    bqms : list(dimod.BinaryQuadraticModel)
+        Spin-valued binary quadratic models, read in place. Models with
+        biases other than float64 are copied first.
+
+    num_samples : int
+        Number of samples to get from each model.
+
+    seed : int
+        The seed of the initial states. Those of the `i`-th model only depend
+        on the seed and on `i`, not on `num_threads`.
+
+    large_sparse_opt, solver : see :func:`steepest_gradient_descent`.
+
+    num_threads : int
+        Number of threads to spread the models over.
+
+    Returns
+    -------
+    samples : list(numpy.ndarray)
+        The samples of each model, one 2D array of `num_samples` rows each,
+        in the order of the model's variables. They are views of a single
+        array.
+
+    energies: numpy.ndarray
+        Sample energies, one row per model, not including the offsets.
+
+    num_steps: numpy.ndarray
+        Number of downhill steps per sample, one row per model.
+    """
+    cdef vector[cppBinaryQuadraticModel[bias_type, index_type]*] _bqms
+    cdef dimod.cyBQM_float64 cybqm
+    cdef Py_ssize_t total_vars = 0
+
+    # hold the float64 models until the descents are done
+    models = []
+    for bqm in bqms:
+        if bqm.vartype is not dimod.SPIN:
+            raise ValueError("bqms must be spin-valued")
+        cybqm = dimod.as_bqm(bqm, dtype=float).data
+        models.append(cybqm)
+        _bqms.push_back(cybqm.cppbqm)
+        total_vars += bqm.num_variables
+
+    # allocate single arrays for the results of all the models
+    states_numpy = np.empty(num_samples * total_vars, dtype=np.int8)
+    energies_numpy = np.empty((len(models), num_samples), dtype=np.float64)
+    num_steps_numpy = np.empty((len(models), num_samples), dtype=np.uint32)
+
+    # explicitly convert all Python types to C while we have the GIL
+    cdef np.int8_t* _states = <np.int8_t*> np.PyArray_DATA(states_numpy)
+    cdef double* _energies = <double*> np.PyArray_DATA(energies_numpy)
+    cdef unsigned* _num_steps = <unsigned*> np.PyArray_DATA(num_steps_numpy)
+    cdef int _num_samples = num_samples
+    cdef uint64_t _seed = seed
+    cdef decl.DescentSolver _solver = _descent_solver(large_sparse_opt, solver)
+    cdef int _num_threads = num_threads
+
+    with nogil:
+        decl.steepest_gradient_descent_batch(
+            _bqms, _states, _energies, _num_steps, _num_samples,
+            _seed, _solver, _num_threads)
+
+    samples = []
+    cdef Py_ssize_t offset = 0
+    for bqm in bqms:
+        size = num_samples * bqm.num_variables
+        samples.append(states_numpy[offset:offset + size].reshape(num_samples, bqm.num_variables))
+        offset += size
+
+    return samples, energies_numpy, num_steps_numpy
+
+
+
+def iterated_local_search_bqm(num_samples, bqm,
+                              np.ndarray[np.int8_t, ndim=2, mode="c"] states_numpy,
+                              perturbation_size, num_iterations, time_limit, seed,
+                              num_threads=1,
+                              ReadQueue read_queue=None):
+    """Wraps `iterated_local_search` from `descent.h`. Descends from each
+    initial state, then repeatedly flips `perturbation_size` random variables
+    of the minimum and descends again, keeping the new minimum if it is no
+    higher, all in a single native call.
+
+    Parameters
+    ----------
+    num_samples, bqm, states_numpy : see :func:`steepest_gradient_descent_bqm`.
+
+    perturbation_size : int
+        Number of distinct variables flipped per iteration.
+
+    num_iterations : int, optional
+        Number of iterations per sample. None for no limit.
+
+    time_limit : float, optional
+        Time, in seconds, each sample may take. None for no limit. At least
+        one of `num_iterations` and `time_limit` must be given.
+
+    seed : int
+        The seed of the perturbations. Those of the `i`-th sample only depend
+        on the seed and on `i`, so with no time limit the results do not
+        depend on `num_threads`.
+
+    num_threads : int
+        Number of threads to distribute the samples over.
+
+    read_queue : :class:`~dwave.samplers.common.stream.ReadQueue`, optional
+        If given, the index of each sample is pushed to it as soon as its
+        search is done.
+
+    Returns
+    -------
+    samples : numpy.ndarray
+        A 2D numpy array where each row is a sample.
+
+    energies: numpy.ndarray
+        Sample energies, not including the offset of `bqm`.
+
+    num_steps: numpy.ndarray
+        Number of downhill steps of all the descents of each sample.
+    """
+    if bqm.vartype is not dimod.SPIN:
+        raise ValueError("bqm must be spin-valued")
+    if num_iterations is None and time_limit is None:
+        raise ValueError("one of num_iterations and time_limit must be given")
+
+    cdef dimod.cyBQM_float64 cybqm = dimod.as_bqm(bqm, dtype=float).data
+    num_vars = cybqm.num_variables()
+
+    # short-circuit null edge cases
+    if num_samples == 0 or num_vars == 0:
+        states = np.empty((num_samples, num_vars), dtype=np.int8)
+        return (states,
+                np.zeros(num_samples, dtype=np.double),
+                np.zeros(num_samples, dtype=np.uint32))
+
+    if states_numpy.shape[0] != num_samples or states_numpy.shape[1] != num_vars:
+        raise ValueError("states_numpy must have shape (num_samples, num_variables)")
+
+    energies_numpy = np.empty(num_samples, dtype=np.float64)
+    cdef double[:] energies = energies_numpy
+    num_steps_numpy = np.empty(num_samples, dtype=np.uint32)
+    cdef unsigned[:] num_steps = num_steps_numpy
+
+    # explicitly convert all Python types to C while we have the GIL
+    cdef np.int8_t* _states = &states_numpy[0, 0]
+    cdef double* _energies = &energies[0]
+    cdef unsigned* _num_steps = &num_steps[0]
+    cdef int _num_samples = num_samples
+    cdef int _perturbation_size = perturbation_size
+    cdef int64_t _max_iterations = -1 if num_iterations is None else num_iterations
+    cdef double _time_limit = float('inf') if time_limit is None else time_limit
+    cdef uint64_t _seed = seed
+    cdef int _num_threads = num_threads
+    cdef decl.cppReadQueue* _completed = NULL
+    if read_queue is not None:
+        read_queue.attach(states_numpy, energies_numpy, num_steps=num_steps_numpy)
+        _completed = read_queue.queue
+
+    with nogil:
+        decl.iterated_local_search(
+            _states, _energies, _num_steps, _num_samples, deref(cybqm.data()),
+            _perturbation_size, _max_iterations, _time_limit, _seed,
+            _num_threads, _completed)
+
+    return states_numpy, energies_numpy, num_steps_numpy
+
+cdef class DescentState:
+    """Wraps `DescentState` from `descent.h`. Local minima of a spin-valued
+    problem, kept with the problem and the flip energies of every sample so
+    that they can be descended again cheaply after a few of its biases
+    change.
+
+    Each update recomputes only the flip energies of the variables whose
+    biases change, and descends every sample from its previous minimum with
+    an indexed binary heap.
+
+    Parameters
+    ----------
+    graph : :class:`dwave.samplers.common.graph.IsingGraph`
+        The graph of the problem. It is copied, so later updates do not
+        change it.
+
+    initial_states : np.ndarray[np.int8_t, ndim=2, mode="c"], values in (-1, 1)
+        The initial states of the descents, of shape
+        (num_samples, num_variables).
+
+    num_threads : int
+        The number of threads to distribute the samples over. The results do
+        not depend on the number of threads.
+    """
+    cdef unique_ptr[decl.cppDescentState] state
+
+    cdef readonly object num_steps
+    """numpy.ndarray: Number of downhill steps per sample, of the last
+    descent."""
+
+    def __init__(self, IsingGraph graph not None,
+                 np.ndarray[np.int8_t, ndim=2, mode="c"] initial_states,
+                 num_threads=1):
+        if graph.graph.get() == NULL:
+            raise ValueError("graph is not initialized")
+        self._init(deref(graph.graph), initial_states, num_threads)
+
+    @staticmethod
+    def from_bqm(bqm, np.ndarray[np.int8_t, ndim=2, mode="c"] initial_states,
+                 num_threads=1):
+        """Descend from the initial states of a spin-valued binary quadratic
+        model, with the columns of `initial_states` in the order of
+        ``bqm.variables``. The energies do not include the offset of `bqm`.
+        """
+        if bqm.vartype is not dimod.SPIN:
+            raise ValueError("bqm must be spin-valued")
+
+        cdef dimod.cyBQM_float64 cybqm = dimod.as_bqm(bqm, dtype=float).data
+        cdef AdjacencyOptions options
+        options.sort_neighbors = False
+        options.merge_duplicates = False
+        cdef DescentState descent = DescentState.__new__(DescentState)
+        descent._init(build_ising_graph_bqm(deref(cybqm.data()), options),
+                      initial_states, num_threads)
+        return descent
+
+    cdef _init(self, const cppIsingGraph& graph, np.ndarray initial_states,
+               num_threads):
+        num_samples = initial_states.shape[0]
+        if initial_states.shape[1] != graph.num_variables():
+            raise ValueError("initial_states must have shape (num_samples, num_variables)")
+
+        self.num_steps = np.zeros(num_samples, dtype=np.uint32)
+
+        # explicitly convert all Python types to C while we have the GIL
+        cdef const np.int8_t* _initial_states = <np.int8_t*> np.PyArray_DATA(initial_states)
+        cdef unsigned* _num_steps = <unsigned*> np.PyArray_DATA(self.num_steps)
+        cdef int _num_samples = num_samples
+        cdef int _num_threads = num_threads
+        cdef decl.cppDescentState* state
+
+        with nogil:
+            state = new decl.cppDescentState(
+                graph, _initial_states, _num_samples, _num_steps, _num_threads)
+        self.state.reset(state)
+
+    def update(self, linear_vars, linear_deltas,
+               coupler_starts, coupler_ends, coupler_deltas,
+               num_threads=1):
+        """Add deltas to the biases of the problem and descend every sample
+        from its current minimum.
+
+        Parameters
+        ----------
+        linear_vars, linear_deltas : list(int), list(float)
+            The variables whose linear biases change, and their changes.
+
+        coupler_starts, coupler_ends, coupler_deltas : list(int), list(int), list(float)
+            The couplers whose weights change, see
+            :func:`steepest_gradient_descent`, and their changes. Couplers
+            the problem does not have yet are added, which costs as much as
+            building the problem again.
+
+        num_threads : int
+            The number of threads to distribute the samples over.
+
+        Returns
+        -------
+        num_steps: numpy.ndarray
+            Number of downhill steps per sample.
+        """
+        cdef vector[int] _linear_vars = linear_vars
+        cdef vector[double] _linear_deltas = linear_deltas
+        cdef vector[int] _coupler_starts = coupler_starts
+        cdef vector[int] _coupler_ends = coupler_ends
+        cdef vector[double] _coupler_deltas = coupler_deltas
+        cdef int _num_threads = num_threads
+
+        num_steps = np.zeros(self.state.get().num_samples(), dtype=np.uint32)
+        cdef unsigned* _num_steps = <unsigned*> np.PyArray_DATA(num_steps)
+
+        with nogil:
+            self.state.get().update(
+                _linear_vars, _linear_deltas,
+                _coupler_starts, _coupler_ends, _coupler_deltas,
+                _num_steps, _num_threads)
+
+        self.num_steps = num_steps
+        return num_steps
+
+    @property
+    def states(self):
+        """numpy.ndarray: A copy of the minima, one row per sample."""
+        num_samples = self.state.get().num_samples()
+        num_vars = self.state.get().num_variables()
+        states = np.empty((num_samples, num_vars), dtype=np.int8)
+        if states.size:
+            memcpy(np.PyArray_DATA(states), self.state.get().states(), states.size)
+        return states
+
+    @property
+    def energies(self):
+        """numpy.ndarray: A copy of the energies of the minima."""
+        num_samples = self.state.get().num_samples()
+        energies = np.empty(num_samples, dtype=np.float64)
+        if num_samples:
+            memcpy(np.PyArray_DATA(energies), self.state.get().energies(),
+                   num_samples * sizeof(double))
+        return energies
@@ -16,16 +16,19 @@
 
 from numbers import Integral
 from time import perf_counter_ns
-from typing import Optional
+from typing import Iterator, List, Mapping, Optional, Sequence, Tuple
 
 from dimod.core.initialized import InitialStateGenerator
 
 import dimod
 import numpy as np
 
-from dwave.samplers.greedy.descent import steepest_gradient_descent
+from dwave.samplers.common.stream import ReadQueue, stream
+from dwave.samplers.greedy.descent import (
+    DescentState, iterated_local_search_bqm, steepest_gradient_descent_batch,
+    steepest_gradient_descent_bqm)
 
-__all__ = ["SteepestDescentSolver", "SteepestDescentSampler"]
+__all__ = ["SteepestDescentSolver", "SteepestDescentSampler", "IncrementalDescent"]
 
 
 class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
@@ -50,7 +53,9 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
 
     In the ``large_sparse_opt`` mode, runtime complexity on sparse graphs is
     :math:`O(|V|*log|V|)` for initialization and :math:`O(max\_degree * log|V|)`
-    per downhill step.
+    per downhill step. The ``solver="heap"`` mode has the same per-step
+    complexity with a smaller constant factor, and :math:`O(|E|)`
+    initialization.
 
     Aliased as :class:`~greedy.sampler.SteepestDescentSampler`.
 
@@ -104,7 +109,7 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
         >>> from dwave.samplers import SteepestDescentSampler
         >>> sampler = SteepestDescentSampler()
         >>> sampler.parameters.keys()
-        dict_keys(['num_reads', 'initial_states', 'initial_states_generator', 'seed', 'large_sparse_opt'])
+        dict_keys(['num_reads', 'initial_states', 'initial_states_generator', 'seed', 'large_sparse_opt', 'solver', 'num_threads', 'num_iterations', 'time_limit', 'perturbation_size', 'read_queue'])
 
     """
 
@@ -116,7 +121,7 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
         >>> from dwave.samplers import SteepestDescentSampler
         >>> sampler = SteepestDescentSampler()
         >>> sampler.properties.keys()
-        dict_keys(['initial_states_generators', 'large_sparse_opt_values'])
+        dict_keys(['initial_states_generators', 'large_sparse_opt_values', 'solver_values'])
 
     """
 
@@ -128,10 +133,17 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
             'initial_states_generator': ['initial_states_generators'],
             'seed': [],
             'large_sparse_opt': ['large_sparse_opt_values'],
+            'solver': ['solver_values'],
+            'num_threads': [],
+            'num_iterations': [],
+            'time_limit': [],
+            'perturbation_size': [],
+            'read_queue': [],
         }
         self.properties = {
             'initial_states_generators': ('none', 'tile', 'random'),
             'large_sparse_opt_values': (True, False),
+            'solver_values': ('linear', 'tree', 'heap'),
         }
 
     def sample(self, bqm: dimod.BinaryQuadraticModel,
@@ -139,7 +151,14 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
                initial_states: Optional[dimod.typing.SamplesLike] = None,
                initial_states_generator: InitialStateGenerator = "random",
                seed: Optional[int] = None,
-               large_sparse_opt: bool = False, **kwargs) -> dimod.SampleSet:
+               large_sparse_opt: bool = False,
+               solver: Optional[str] = None,
+               num_threads: int = 1,
+               num_iterations: Optional[int] = None,
+               time_limit: Optional[float] = None,
+               perturbation_size: int = 3,
+               read_queue: Optional[ReadQueue] = None,
+               **kwargs) -> dimod.SampleSet:
         """Find minima of a binary quadratic model.
 
         Starts from ``initial_states``, and converges to local minima using
@@ -186,6 +205,57 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
                 Use optimizations for large and sparse problems (search tree for
                 next descent variable instead of linear array).
 
+            solver:
+                Data structure used to find the next descent variable:
+
+                * "linear":
+                    Linear search through all the variables. Fastest for
+                    complete and/or dense problem graphs.
+
+                * "tree":
+                    Search tree (balanced binary tree) of the flip energies.
+
+                * "heap":
+                    Indexed binary heap of the flip energies. Fastest for
+                    large and sparse problem graphs.
+
+                If not given, "tree" is used if ``large_sparse_opt`` is True, and
+                "linear" otherwise. All solvers reach the same local minima
+                from the same initial states.
+
+            num_threads:
+                Number of threads to distribute the reads over. Each thread
+                has its own scratch buffers, and the results do not depend on
+                ``num_threads``.
+
+            num_iterations:
+                If given, each read runs an iterated local search from its
+                minimum: each iteration flips ``perturbation_size`` random
+                variables of the current minimum and descends again, keeping
+                the new minimum if its energy is no higher. The whole search
+                runs natively, updating the flip energies incrementally, so an
+                iteration costs about as much as the few downhill steps it
+                takes. ``num_iterations`` is the number of iterations of
+                each read. The iterations always find the descent variable
+                with the "heap" solver.
+
+            time_limit:
+                If given, each read runs the iterated local search (see
+                ``num_iterations``) for at most ``time_limit`` seconds, or
+                until it has run ``num_iterations`` iterations if that is
+                also given. With a time limit, the results depend on how
+                fast the reads run.
+
+            perturbation_size:
+                Number of distinct variables flipped per iteration of the
+                iterated local search.
+
+            read_queue:
+                If given, each read is handed over to this
+                :class:`~dwave.samplers.common.stream.ReadQueue` as soon as its
+                descent is done. Used by :meth:`sample_stream`, which most
+                users want instead.
+
         Returns:
             A `dimod.SampleSet` for the binary quadratic model.
 
@@ -199,6 +269,8 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
         Note:
             Number of descents (single variable flips) taken to reach the local
             minimum for each sample is stored in a data vector called ``num_steps``.
+            With the iterated local search, it counts the downhill steps of all
+            the descents of the read.
 
         Examples:
             This example samples a simple two-variable Ising model.
@@ -247,11 +319,45 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
             Notice it required 2 variable flips (``num_steps`` field in the last
             column) to reach the minimum state, ``(-1, -1)``, from the initial
             state, ``(1, 1)``.
+
+            Escape the first local minima with an iterated local search of a
+            thousand perturbations per read, spread over four threads:
+
+            >>> bqm = dimod.generators.ran_r(1, 100, seed=1)
+            >>> descents = sampler.sample(bqm, num_reads=8, seed=2)
+            >>> searches = sampler.sample(bqm, num_reads=8, seed=2,
+            ...                           num_iterations=1000, num_threads=4)
+            >>> searches.first.energy <= descents.first.energy
+            True
         """
         timestamp_preprocess = perf_counter_ns()
         # get the original vartype so we can return consistently
         original_vartype = bqm.vartype
 
+        if solver is not None and solver not in self.properties['solver_values']:
+            raise ValueError("'solver' should be one of {}: value = {!r}".format(
+                self.properties['solver_values'], solver))
+        if large_sparse_opt and solver == 'linear':
+            raise ValueError("'large_sparse_opt' cannot be used with solver='linear'")
+
+        if not isinstance(num_threads, Integral):
+            raise TypeError("'num_threads' should be a positive integer")
+        if num_threads < 1:
+            raise ValueError("'num_threads' should be a positive integer")
+
+        iterated = num_iterations is not None or time_limit is not None
+        if num_iterations is not None:
+            if not isinstance(num_iterations, Integral):
+                raise TypeError("'num_iterations' should be a non-negative integer")
+            if num_iterations < 0:
+                raise ValueError("'num_iterations' should be a non-negative integer")
+        if time_limit is not None and not time_limit >= 0:
+            raise ValueError("'time_limit' should be a non-negative number of seconds")
+        if not isinstance(perturbation_size, Integral):
+            raise TypeError("'perturbation_size' should be a positive integer")
+        if perturbation_size < 1:
+            raise ValueError("'perturbation_size' should be a positive integer")
+
         # convert to spin
         if bqm.vartype is not dimod.SPIN:
             bqm = bqm.change_vartype(dimod.SPIN, inplace=False)
@@ -273,28 +379,40 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
         num_reads = parsed_initial_states.num_reads
         initial_states = parsed_initial_states.initial_states
 
-        # get linear/quadratic data
-        linear, (coupler_starts, coupler_ends, coupler_weights), offset = \
-            bqm.to_numpy_vectors(variable_order=initial_states.variables)
-
-        # we need initial states as contiguous numpy array
+        # we need initial states as contiguous numpy array, in the BQM's
+        # variable order, as the descent reads the BQM in place
+        variable_order = initial_states.variables
+        initial_states_array = initial_states.record.sample
+        if variable_order != bqm.variables:
+            initial_states_array = initial_states_array[
+                :, [variable_order.index(v) for v in bqm.variables]]
+            variable_order = bqm.variables
         initial_states_array = \
-            np.ascontiguousarray(initial_states.record.sample, dtype=np.int8)
+            np.ascontiguousarray(initial_states_array, dtype=np.int8)
+
+        if read_queue is not None:
+            read_queue.describe(variable_order, bqm.offset, original_vartype)
 
         timestamp_sample = perf_counter_ns()
 
-        # run the steepest descent
-        samples, energies, num_steps = steepest_gradient_descent(
-            num_reads,
-            linear, coupler_starts, coupler_ends, coupler_weights,
-            initial_states_array, large_sparse_opt)
+        # run the steepest descent, or the iterated local search
+        if iterated:
+            samples, energies, num_steps = iterated_local_search_bqm(
+                num_reads, bqm, initial_states_array, perturbation_size,
+                num_iterations, time_limit,
+                np.random.default_rng(seed).integers(2**32),
+                num_threads, read_queue)
+        else:
+            samples, energies, num_steps = steepest_gradient_descent_bqm(
+                num_reads, bqm, initial_states_array, large_sparse_opt, solver,
+                num_threads, read_queue)
 
         timestamp_postprocess = perf_counter_ns()
 
         # resulting sampleset
         result = dimod.SampleSet.from_samples(
-            (samples, initial_states.variables),
-            energy=energies + offset,
+            (samples, variable_order),
+            energy=energies + bqm.offset,
             vartype=dimod.SPIN,
             num_steps=num_steps,
         )
@@ -312,5 +430,300 @@ class SteepestDescentSolver(dimod.Sampler, dimod.Initialized):
 
         return result
 
+    def sample_stream(self, bqm: dimod.BinaryQuadraticModel, *,
+                      batch_size: Optional[int] = None,
+                      queue_size: int = 1024,
+                      **parameters) -> Iterator[dimod.SampleSet]:
+        """Find minima of a binary quadratic model, yielding the reads while
+        the other descents are still running.
+
+        The descents run natively on a separate thread, with the same results
+        as :meth:`sample` for the same parameters, and each read is handed
+        over as soon as its descent is done. With ``num_threads`` greater
+        than 1, the reads are not handed over in order.
+
+        Args:
+            bqm: Binary quadratic model to be sampled.
+
+            batch_size:
+                Largest number of reads in a yielded sample set. By default
+                each sample set holds all of the reads completed since the
+                previous one.
+
+            queue_size:
+                Number of completed reads held for the consumer. Once it is
+                reached, the descents wait for the consumer to catch up.
+
+            **parameters:
+                Parameters of :meth:`sample`.
+
+        Yields:
+            A `dimod.SampleSet` of the reads completed since the previous
+            one, with their ``num_steps``. The generator returns, as the
+            value of its ``StopIteration``, the sample set :meth:`sample`
+            would have returned.
+
+        Examples:
+            >>> import dimod
+            >>> from dwave.samplers import SteepestDescentSolver
+            ...
+            >>> solver = SteepestDescentSolver()
+            >>> bqm = dimod.generators.ran_r(1, 20, seed=1)
+            >>> sum(len(sampleset) for sampleset in
+            ...     solver.sample_stream(bqm, num_reads=100, batch_size=10))
+            100
+
+        """
+        read_queue = ReadQueue(queue_size)
+        return stream(lambda: self.sample(bqm, read_queue=read_queue, **parameters),
+                      read_queue, batch_size)
+
+
+    def sample_batch(self, bqms: Sequence[dimod.BinaryQuadraticModel], *,
+                     num_reads: int = 1,
+                     seed: Optional[int] = None,
+                     large_sparse_opt: bool = False,
+                     solver: Optional[str] = None,
+                     num_threads: int = 1) -> List[dimod.SampleSet]:
+        """Find minima of each of many binary quadratic models in one native
+        call.
+
+        Intended for many small problems, eg. the subproblems of a
+        decomposition solver, for which the per-call overhead of
+        :meth:`sample` outweighs the descents themselves. The models are
+        spread over ``num_threads`` threads, each of which runs all the
+        descents of one model at a time, from random initial states.
+
+        Args:
+            bqms: Binary quadratic models to be sampled.
+
+            num_reads: Number of descents from random states of each model.
+
+            seed:
+                Seed of the random initial states. Those of each model only
+                depend on the seed and on the position of the model in
+                ``bqms``.
+
+            large_sparse_opt: See :meth:`sample`.
+
+            solver: See :meth:`sample`.
+
+            num_threads: Number of threads to spread the models over.
+
+        Returns:
+            A `dimod.SampleSet` for each model, in the order of ``bqms``,
+            with the ``num_steps`` of each read.
+
+        Examples:
+            >>> import dimod
+            >>> from dwave.samplers import SteepestDescentSolver
+            ...
+            >>> solver = SteepestDescentSolver()
+            >>> bqms = [dimod.generators.ran_r(1, 20, seed=s) for s in range(100)]
+            >>> samplesets = solver.sample_batch(bqms, num_reads=10, num_threads=4)
+            >>> len(samplesets)
+            100
+
+        """
+        if not isinstance(num_threads, Integral) or not isinstance(num_reads, Integral):
+            raise TypeError("'num_reads' and 'num_threads' should be positive integers")
+        if num_threads < 1 or num_reads < 1:
+            raise ValueError("'num_reads' and 'num_threads' should be positive integers")
+
+        if not (seed is None or isinstance(seed, Integral)):
+            raise TypeError("'seed' should be None or a positive 32-bit integer")
+        if seed is None:
+            seed = np.random.default_rng().integers(2**32)
+
+        spin_bqms = [bqm if bqm.vartype is dimod.SPIN
+                     else bqm.change_vartype(dimod.SPIN, inplace=False)
+                     for bqm in bqms]
+
+        samples, energies, num_steps = steepest_gradient_descent_batch(
+            spin_bqms, num_reads, seed, large_sparse_opt, solver, num_threads)
+
+        samplesets = []
+        for bqm, spin, states, energy, steps in zip(
+                bqms, spin_bqms, samples, energies, num_steps):
+            sampleset = dimod.SampleSet.from_samples(
+                (states, spin.variables),
+                energy=energy + spin.offset,
+                vartype=dimod.SPIN,
+                num_steps=steps,
+            )
+            sampleset.change_vartype(bqm.vartype, inplace=True)
+            samplesets.append(sampleset)
+
+        return samplesets
+
+
+    def incremental_descent(self, bqm: dimod.BinaryQuadraticModel,
+                            num_reads: Optional[int] = None,
+                            initial_states: Optional[dimod.typing.SamplesLike] = None,
+                            initial_states_generator: InitialStateGenerator = "random",
+                            seed: Optional[int] = None,
+                            num_threads: int = 1) -> 'IncrementalDescent':
+        """Find minima of a binary quadratic model, and keep them to descend
+        again after the model's biases change.
+
+        Intended for a model that is solved many times with a few biases
+        changed in between, eg. by a Lagrangian or penalty-tuning loop. After
+        each change, only the flip energies of the touched variables are
+        recomputed and each read descends from its previous minimum, so a
+        small change costs time in the number of touched variables rather
+        than in the size of the model.
+
+        Args:
+            bqm: Binary quadratic model to be sampled. It is copied, so later
+                changes to it are not seen.
+
+            num_reads: See :meth:`sample`.
+
+            initial_states: See :meth:`sample`.
+
+            initial_states_generator: See :meth:`sample`.
+
+            seed: See :meth:`sample`.
+
+            num_threads: Number of threads to distribute the reads over.
+
+        Returns:
+            An :class:`IncrementalDescent` holding the minima, which the
+            descents from the "heap" solver of :meth:`sample` also reach.
+
+        Examples:
+            >>> import dimod
+            >>> from dwave.samplers import SteepestDescentSolver
+            ...
+            >>> bqm = dimod.BQM.from_ising({'x': 2, 'y': 2}, {'xy': -1})
+            >>> descent = SteepestDescentSolver().incremental_descent(bqm, num_reads=3)
+            >>> descent.sampleset.first.energy
+            -5.0
+            >>> descent.update(linear={'x': -6, 'y': -6}).first.energy
+            -9.0
+
+        """
+        if not isinstance(num_threads, Integral):
+            raise TypeError("'num_threads' should be a positive integer")
+        if num_threads < 1:
+            raise ValueError("'num_threads' should be a positive integer")
+
+        original_vartype = bqm.vartype
+        bqm = bqm.change_vartype(dimod.SPIN, inplace=False)
+
+        if not (seed is None or isinstance(seed, Integral)):
+            raise TypeError("'seed' should be None or a positive 32-bit integer")
+        if isinstance(seed, Integral) and not 0 <= seed <= 2**32 - 1:
+            raise ValueError("'seed' should be an integer between 0 and 2**32 - 1 inclusive")
+
+        parsed_initial_states = self.parse_initial_states(
+            bqm,
+            num_reads=num_reads,
+            initial_states=initial_states,
+            initial_states_generator=initial_states_generator,
+            seed=seed)
+        initial_states = parsed_initial_states.initial_states
+
+        # the descent reads the columns in the BQM's variable order
+        initial_states_array = initial_states.record.sample
+        if initial_states.variables != bqm.variables:
+            initial_states_array = initial_states_array[
+                :, [initial_states.variables.index(v) for v in bqm.variables]]
+        initial_states_array = \
+            np.ascontiguousarray(initial_states_array, dtype=np.int8)
+
+        descent = DescentState.from_bqm(bqm, initial_states_array, num_threads)
+        return IncrementalDescent(bqm, original_vartype, descent)
+
+
+class IncrementalDescent:
+    """Local minima of a binary quadratic model, descended again from where
+    they are after each change of the model's biases.
+
+    Created by :meth:`SteepestDescentSolver.incremental_descent`.
+    """
+
+    def __init__(self, bqm: dimod.BinaryQuadraticModel,
+                 vartype: dimod.Vartype, descent: DescentState):
+        # `bqm` is a spin-valued copy, which the updates are not applied to;
+        # only its variables and offset are used
+        self._variables = bqm.variables
+        self._index = {v: i for i, v in enumerate(bqm.variables)}
+        self._offset = bqm.offset
+        self._vartype = vartype
+        self._descent = descent
+
+    @property
+    def sampleset(self) -> dimod.SampleSet:
+        """The current minima, with the ``num_steps`` of their last
+        descent."""
+        sampleset = dimod.SampleSet.from_samples(
+            (self._descent.states, self._variables),
+            energy=self._descent.energies + self._offset,
+            vartype=dimod.SPIN,
+            num_steps=self._descent.num_steps,
+        )
+        sampleset.change_vartype(self._vartype, inplace=True)
+        return sampleset
+
+    def update(self, linear: Optional[Mapping[dimod.typing.Variable, float]] = None,
+               quadratic: Optional[Mapping[Tuple[dimod.typing.Variable, dimod.typing.Variable], float]] = None,
+               offset: float = 0,
+               num_threads: int = 1) -> dimod.SampleSet:
+        """Add to the biases of the model and descend from the current minima.
+
+        Args:
+            linear: Changes of linear biases, keyed by variable, in the
+                vartype of the original model.
+
+            quadratic: Changes of quadratic biases, keyed by pairs of
+                variables, in the vartype of the original model. Interactions
+                the model does not have yet are added, which costs as much as
+                building the model again.
+
+            offset: Change of the offset.
+
+            num_threads: Number of threads to distribute the reads over.
+
+        Returns:
+            The new minima, see :attr:`sampleset`.
+
+        """
+        if not isinstance(num_threads, Integral):
+            raise TypeError("'num_threads' should be a positive integer")
+        if num_threads < 1:
+            raise ValueError("'num_threads' should be a positive integer")
+
+        def index(v):
+            try:
+                return self._index[v]
+            except KeyError:
+                raise ValueError(f"unknown variable {v!r}") from None
+
+        # the changes of the spin-valued model, s = 2x - 1
+        linear_vars, linear_deltas = [], []
+        coupler_starts, coupler_ends, coupler_deltas = [], [], []
+        binary = self._vartype is dimod.BINARY
+        for v, bias in (linear or {}).items():
+            linear_vars.append(index(v))
+            linear_deltas.append(bias / 2 if binary else bias)
+            if binary:
+                offset += bias / 2
+        for (u, v), bias in (quadratic or {}).items():
+            if u == v:
+                raise ValueError(f"{u!r} cannot have an interaction with itself")
+            coupler_starts.append(index(u))
+            coupler_ends.append(index(v))
+            coupler_deltas.append(bias / 4 if binary else bias)
+            if binary:
+                linear_vars.extend((index(u), index(v)))
+                linear_deltas.extend((bias / 4, bias / 4))
+                offset += bias / 4
+
+        self._descent.update(linear_vars, linear_deltas,
+                             coupler_starts, coupler_ends, coupler_deltas,
+                             num_threads)
+        self._offset += offset
+        return self.sampleset
 
 SteepestDescentSampler = SteepestDescentSolver
@@ -12,12 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <exception>
+#include <limits>
+#include <mutex>
 #include <vector>
 #include <set>
 #include <cassert>
 #include <stdexcept>
+#include "deadline.h"
 #include "descent.h"
+#include "pool.h"
 
 using std::vector;
 using std::set;
@@ -94,6 +101,98 @@ double get_state_energy(
 }
 
 
+
+// Returns the energy of a given state for the input problem.
+//
+// @param state a int8 array containing the spin state to compute the energy of
+// @param linear_biases vector of h or field value on each variable
+// @param neighbors lists of the neighbors of each variable, such that
+//        neighbors[i][j] is the jth neighbor of variable i. Each coupler is
+//        counted once, from its lower-indexed variable. A coupler from a
+//        variable to itself appears twice in its list, so each half is counted.
+// @param neighbour_couplings same as neighbors, but instead has the J value.
+//
+// @return A double corresponding to the energy for `state` on the problem
+//        defined by linear_biases and the neighbors passed in
+double get_state_energy(
+    std::int8_t* state,
+    const vector<double>& linear_biases,
+    const vector<vector<int>>& neighbors,
+    const vector<vector<double>>& neighbour_couplings
+) {
+    double energy = 0.0;
+
+    for (unsigned int var = 0; var < linear_biases.size(); var++) {
+        // sum the energy due to the local field on the variable
+        energy += state[var] * linear_biases[var];
+
+        // and due to the coupling weights to its higher-indexed neighbors
+        for (unsigned int idx = 0; idx < neighbors[var].size(); idx++) {
+            int n_var = neighbors[var][idx];
+            if (n_var > (int)var) {
+                energy += state[var] * neighbour_couplings[var][idx] * state[n_var];
+            } else if (n_var == (int)var) {
+                energy += .5 * neighbour_couplings[var][idx];
+            }
+        }
+    }
+
+    return energy;
+}
+
+
+// Returns the energy delta from flipping a SPIN variable at index `var`.
+//
+// @param var, state, linear_biases see `get_flip_energy` above
+// @param adj the adjacency of the problem, see `build_adjacency`
+//
+// @return delta energy
+static inline double get_flip_energy(
+    int var,
+    std::int8_t *state,
+    const vector<double>& linear_biases,
+    const Adjacency& adj
+) {
+    double contrib = linear_biases[var];
+    for (const Neighbor* n = adj.begin(var); n != adj.end(var); ++n) {
+        contrib += state[n->var] * n->weight;
+    }
+
+    return -2 * state[var] * contrib;
+}
+
+
+// Returns the energy of a given state for the input problem.
+//
+// @param state, linear_biases see `get_state_energy` above
+// @param adj the adjacency of the problem, see `build_adjacency`. Each coupler
+//        is counted once, from its lower-indexed variable.
+//
+// @return A double corresponding to the energy for `state` on the problem
+//        defined by linear_biases and adj
+double get_state_energy(
+    std::int8_t* state,
+    const vector<double>& linear_biases,
+    const Adjacency& adj
+) {
+    double energy = 0.0;
+
+    for (unsigned int var = 0; var < linear_biases.size(); var++) {
+        energy += state[var] * linear_biases[var];
+
+        for (const Neighbor* n = adj.begin(var); n != adj.end(var); ++n) {
+            if (n->var > (int)var) {
+                energy += state[var] * n->weight * state[n->var];
+            } else if (n->var == (int)var) {
+                energy += .5 * n->weight;
+            }
+        }
+    }
+
+    return energy;
+}
+
+
 // One run of the steepest gradient descent on the input Ising model.
 //
 // Linear search for the steepest descent variable. Fastest approach for
@@ -103,21 +202,19 @@ double get_state_energy(
 //        variable. Note that this will be used as the initial state of the
 //        run.
 // @param linear_biases vector of h or field value on each variable
-// @param neighbors lists of the neighbors of each variable, such that
-//        neighbors[i][j] is the jth neighbor of variable i. Note
-// @param neighbour_couplings same as neighbors, but instead has the J value.
-//        neighbour_couplings[i][j] is the J value or weight on the coupling
-//        between variables i and neighbors[i][j].
-// @param flip_energies vector used for caching of variable flip delta
-//        energies
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @param flip_energies the flip energies of the variables in `state`, see
+//        `get_flip_energy`. Kept up to date as the state descends.
+// @param energy the energy of `state`, which the energy change of every
+//        downhill step is added to
 //
 // @return number of downhill steps; `state` contains the result of the run.
 unsigned int steepest_gradient_descent_solver(
     std::int8_t* state,
     const vector<double>& linear_biases,
-    const vector<vector<int>>& neighbors,
-    const vector<vector<double>>& neighbour_couplings,
-    vector<double>& flip_energies
+    const Adjacency& adj,
+    vector<double>& flip_energies,
+    double& energy
 ) {
     const int num_vars = linear_biases.size();
 
@@ -126,14 +223,6 @@ unsigned int steepest_gradient_descent_solver(
         return 0;
     }
 
-    // calculate flip energies for all variables, based on the current
-    // state (loop invariant) ~ O(num_vars * max_degree)
-    for (int var = 0; var < num_vars; var++) {
-        flip_energies[var] = get_flip_energy(
-            var, state, linear_biases, neighbors, neighbour_couplings
-        );
-    }
-
     // descend ~ O(downhill_steps * num_vars)
     unsigned int steps = 0;
     while (true) {
@@ -162,15 +251,16 @@ unsigned int steepest_gradient_descent_solver(
         // otherwise, we can improve the solution by descending down the
         // `best_var` dimension
         state[best_var] *= -1;
+        energy += best_flip_energy;
 
         // but to maintain the `flip_energies` invariant (after flipping
         // `best_var`), we need to update flip energies for the flipped var and
         // all neighbors of the flipped var
         flip_energies[best_var] *= -1;
 
-        for (int n_idx = 0; n_idx < neighbors[best_var].size(); n_idx++) {
-            int n_var = neighbors[best_var][n_idx];
-            double w = neighbour_couplings[best_var][n_idx];
+        for (const Neighbor* n = adj.begin(best_var); n != adj.end(best_var); ++n) {
+            int n_var = n->var;
+            double w = n->weight;
             // flip energy for each `neighbor` includes the
             // `2 * state[neighbor] * coupling weight * state[best_var]` term.
             // the change of the flip energy due to flipping `best_var` is
@@ -208,21 +298,18 @@ struct EnergyVarCmp {
 //        variable. Note that this will be used as the initial state of the
 //        run.
 // @param linear_biases vector of h or field value on each variable
-// @param neighbors lists of the neighbors of each variable, such that
-//        neighbors[i][j] is the jth neighbor of variable i. Note
-// @param neighbour_couplings same as neighbors, but instead has the J value.
-//        neighbour_couplings[i][j] is the J value or weight on the coupling
-//        between variables i and neighbors[i][j].
-// @param flip_energies_vector vector used for caching of variable flip delta
-//        energies
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @param flip_energies_vector the flip energies of the variables in `state`,
+//        see `steepest_gradient_descent_solver`
+// @param energy see `steepest_gradient_descent_solver`
 //
 // @return number of downhill steps; `state` contains the result of the run.
 unsigned int steepest_gradient_descent_ls_solver(
     std::int8_t* state,
     const vector<double>& linear_biases,
-    const vector<vector<int>>& neighbors,
-    const vector<vector<double>>& neighbour_couplings,
-    vector<double>& flip_energies_vector
+    const Adjacency& adj,
+    vector<double>& flip_energies_vector,
+    double& energy
 ) {
     const int num_vars = linear_biases.size();
 
@@ -231,20 +318,15 @@ unsigned int steepest_gradient_descent_ls_solver(
         return 0;
     }
 
-    // calculate flip energies for all variables, based on the current
-    // state (loop invariant); store them in:
+    // the flip energies for all variables, based on the current state (loop
+    // invariant), are stored in:
     // (1) vector for fast var-to-energy look-up
     // (2) ordered set (rb-tree) for fast best var energy look-up
-    // ~ O(N * (max_degree + 1 + logN))
-    // => ~ O(N^2) for dense graphs, ~ O(N*logN) for sparse
+    // ~ O(N * logN)
     set<EnergyVar, EnergyVarCmp> flip_energies_set;
 
     for (int var = 0; var < num_vars; var++) {
-        double energy = get_flip_energy(
-            var, state, linear_biases, neighbors, neighbour_couplings
-        );
-        flip_energies_vector[var] = energy;
-        flip_energies_set.insert({energy, var});
+        flip_energies_set.insert({flip_energies_vector[var], var});
     }
 
     // descend ~ O(downhill_steps * max_degree * logN)
@@ -270,9 +352,9 @@ unsigned int steepest_gradient_descent_ls_solver(
 
         // update flip energies (and their ordered set) of all `best_var`'s
         // neighbors ~ O(max_degree * logN)
-        for (int n_idx = 0; n_idx < neighbors[best_var].size(); n_idx++) {
-            int n_var = neighbors[best_var][n_idx];
-            double w = neighbour_couplings[best_var][n_idx];
+        for (const Neighbor* n = adj.begin(best_var); n != adj.end(best_var); ++n) {
+            int n_var = n->var;
+            double w = n->weight;
             // flip energy for each `neighbor` includes the
             // `2 * state[neighbor] * coupling weight * state[best_var]` term.
             // the change of the flip energy due to flipping `best_var` is
@@ -296,6 +378,7 @@ unsigned int steepest_gradient_descent_ls_solver(
 
         // finally, descend down the `var` dim (flip it)
         state[best_var] *= -1;
+        energy += best_energy;
 
         // and update flip energy for the flipped best_var, in both vector and set
         best_energy *= -1;
@@ -310,6 +393,265 @@ unsigned int steepest_gradient_descent_ls_solver(
 }
 
 
+// A binary min-heap of variables keyed by their flip energies, with ties
+// broken by the variable index, so that the top is the same variable the
+// linear search picks. The heap and the position of each variable in it are
+// kept in flat arrays, so updating a key allocates nothing.
+class FlipEnergyHeap {
+  public:
+    // @param flip_energies the keys, read (not copied) on every comparison
+    // @param heap, positions buffers used for the heap, resized as needed
+    // @param heapify if false, the buffers already hold the heap over
+    //        `flip_energies`, for instance from an earlier descent, and are
+    //        used as they are
+    FlipEnergyHeap(
+        const vector<double>& flip_energies,
+        vector<int>& heap,
+        vector<int>& positions,
+        bool heapify = true
+    ) : flip_energies(flip_energies), heap(heap), positions(positions) {
+        if (!heapify) return;
+
+        const int num_vars = flip_energies.size();
+        heap.resize(num_vars);
+        positions.resize(num_vars);
+        for (int var = 0; var < num_vars; var++) {
+            heap[var] = var;
+            positions[var] = var;
+        }
+        // heapify ~ O(num_vars)
+        for (int idx = num_vars / 2 - 1; idx >= 0; idx--) {
+            sift_down(idx);
+        }
+    }
+
+    int top() const {
+        return heap[0];
+    }
+
+    // Restores the heap order after the flip energy of `var` changed.
+    void update(int var) {
+        int idx = positions[var];
+        if (idx > 0 && less(var, heap[(idx - 1) / 2])) {
+            sift_up(idx);
+        } else {
+            sift_down(idx);
+        }
+    }
+
+  private:
+    bool less(int u, int v) const {
+        return flip_energies[u] < flip_energies[v] ||
+            (flip_energies[u] == flip_energies[v] && u < v);
+    }
+
+    void place(int idx, int var) {
+        heap[idx] = var;
+        positions[var] = idx;
+    }
+
+    void sift_up(int idx) {
+        const int var = heap[idx];
+        while (idx > 0) {
+            const int parent = (idx - 1) / 2;
+            if (!less(var, heap[parent])) break;
+            place(idx, heap[parent]);
+            idx = parent;
+        }
+        place(idx, var);
+    }
+
+    void sift_down(int idx) {
+        const int size = heap.size();
+        const int var = heap[idx];
+        while (true) {
+            int child = 2 * idx + 1;
+            if (child >= size) break;
+            if (child + 1 < size && less(heap[child + 1], heap[child])) child++;
+            if (!less(heap[child], var)) break;
+            place(idx, heap[child]);
+            idx = child;
+        }
+        place(idx, var);
+    }
+
+    const vector<double>& flip_energies;
+    vector<int>& heap;
+    vector<int>& positions;
+};
+
+
+// Flips `var` in `state`, keeping `energy`, the flip energies of `var` and of
+// its neighbors, and their heap up to date ~ O(max_degree * logN).
+//
+// @param var the variable to flip
+// @param state, adj, flip_energies, energy, flip_energies_heap see
+//        `heap_descent`
+static inline void heap_flip(
+    const int var,
+    std::int8_t* state,
+    const Adjacency& adj,
+    vector<double>& flip_energies,
+    double& energy,
+    FlipEnergyHeap& flip_energies_heap
+) {
+    // update flip energies (and their positions in the heap) of all `var`'s
+    // neighbors, see `steepest_gradient_descent_ls_solver`
+    for (const Neighbor* n = adj.begin(var); n != adj.end(var); ++n) {
+        int n_var = n->var;
+        double w = n->weight;
+        flip_energies[n_var] += 4 * state[var] * w * state[n_var];
+        flip_energies_heap.update(n_var);
+    }
+
+    // finally, flip `var` itself
+    state[var] *= -1;
+    energy += flip_energies[var];
+    flip_energies[var] *= -1;
+    flip_energies_heap.update(var);
+}
+
+
+// Descends from `state` until no flip lowers its energy, finding the steepest
+// descent variable with a heap kept over `flip_energies`.
+//
+// @param state, adj, flip_energies, energy see
+//        `steepest_gradient_descent_solver`
+// @param flip_energies_heap the heap over `flip_energies`
+// @param flipped if given, the variables flipped are appended to it, eg. so
+//        that the descent can be undone
+//
+// @return number of downhill steps; `state` contains the result of the run.
+static unsigned int heap_descent(
+    std::int8_t* state,
+    const Adjacency& adj,
+    vector<double>& flip_energies,
+    double& energy,
+    FlipEnergyHeap& flip_energies_heap,
+    vector<int>* flipped = nullptr
+) {
+    // short-circuit on empty models
+    if (flip_energies.empty()) {
+        return 0;
+    }
+
+    // descend ~ O(downhill_steps * max_degree * logN)
+    unsigned int steps = 0;
+    while (true) {
+        // find the variable flipping of which results with the steepest
+        // descent in energy landscape ~ O(1)
+        int best_var = flip_energies_heap.top();
+
+        // are we in a minimum already?
+        if (flip_energies[best_var] >= 0) {
+            break;
+        }
+
+        // descend down the `best_var` dim (flip it)
+        heap_flip(best_var, state, adj, flip_energies, energy, flip_energies_heap);
+        if (flipped) flipped->push_back(best_var);
+
+        steps++;
+    }
+
+    return steps;
+}
+
+
+// One run of the steepest gradient descent on the input Ising model.
+//
+// Flip energies are kept in an indexed binary heap, see `FlipEnergyHeap`. Like
+// the ordered set of `steepest_gradient_descent_ls_solver`, this scales well
+// for *large* and *sparse* problem graphs, but with a smaller constant
+// overhead and no allocation per update. The descent is the same as with the
+// other solvers.
+//
+// @param state, linear_biases, adj, flip_energies, energy see
+//        `steepest_gradient_descent_solver`
+// @param heap, heap_positions buffers used for the heap
+//
+// @return number of downhill steps; `state` contains the result of the run.
+unsigned int steepest_gradient_descent_heap_solver(
+    std::int8_t* state,
+    const vector<double>& linear_biases,
+    const Adjacency& adj,
+    vector<double>& flip_energies,
+    double& energy,
+    vector<int>& heap,
+    vector<int>& heap_positions
+) {
+    // short-circuit on empty models
+    if (linear_biases.empty()) {
+        return 0;
+    }
+
+    // build the heap over the flip energies of all variables, based on the
+    // current state (loop invariant) ~ O(num_vars)
+    FlipEnergyHeap flip_energies_heap(flip_energies, heap, heap_positions);
+
+    return heap_descent(state, adj, flip_energies, energy, flip_energies_heap);
+}
+
+
+// One run of the steepest gradient descent with the given solver.
+//
+// @param state, linear_biases, adj, flip_energies, energy see
+//        `steepest_gradient_descent_solver`
+// @param solver the data structure used to find the steepest descent
+//        variable, see `DescentSolver`
+// @param heap, heap_positions buffers used by the IndexedHeap solver
+//
+// @return number of downhill steps; `state` contains the result of the run.
+static unsigned int descent_run(
+    std::int8_t* state,
+    const vector<double>& linear_biases,
+    const Adjacency& adj,
+    vector<double>& flip_energies,
+    double& energy,
+    DescentSolver solver,
+    vector<int>& heap,
+    vector<int>& heap_positions
+) {
+    if (solver == IndexedHeap) {
+        return steepest_gradient_descent_heap_solver(
+            state, linear_biases, adj, flip_energies, energy, heap, heap_positions
+        );
+    } else if (solver == OrderedSet) {
+        return steepest_gradient_descent_ls_solver(
+            state, linear_biases, adj, flip_energies, energy
+        );
+    } else {
+        return steepest_gradient_descent_solver(
+            state, linear_biases, adj, flip_energies, energy
+        );
+    }
+}
+
+
+// One run of the steepest gradient descent from a state whose flip energies
+// are already known, for instance because another sampler kept them up to
+// date while producing the state.
+//
+// @param state, linear_biases, adj, flip_energies, solver see `descent_run`.
+//        On return `flip_energies` holds the flip energies of the final state.
+// @param energy the energy of `state`. On return, the energy of the final
+//        state.
+//
+// @return number of downhill steps; `state` contains the result of the run.
+unsigned int steepest_gradient_descent_run(
+    std::int8_t* state,
+    const vector<double>& linear_biases,
+    const Adjacency& adj,
+    vector<double>& flip_energies,
+    double& energy,
+    DescentSolver solver
+) {
+    vector<int> heap, heap_positions;
+    return descent_run(state, linear_biases, adj, flip_energies, energy, solver,
+                       heap, heap_positions);
+}
+
+
 // Perform `num_samples` runs of steepest gradient descent on a general problem.
 //
 // @param states int8 array of size num_samples * number of variables in the
@@ -328,8 +670,10 @@ unsigned int steepest_gradient_descent_ls_solver(
 //        of each coupler in the problem
 // @param coupler_weights a double vector containing the weights of the couplers
 //        in the same order as coupler_starts and coupler_ends
-// @param large_sparse_opt boolean that determines
-//        if linear search or balanced tree search should be used for descent.
+// @param solver the data structure used to find the steepest descent
+//        variable, see `DescentSolver`.
+// @param num_threads the number of threads to distribute the samples over.
+//        The results do not depend on the number of threads.
 //
 // @return Nothing. Results are in `states` buffer.
 void steepest_gradient_descent(
@@ -341,64 +685,499 @@ void steepest_gradient_descent(
     const vector<int>& coupler_starts,
     const vector<int>& coupler_ends,
     const vector<double>& coupler_weights,
-    bool large_sparse_opt
+    DescentSolver solver,
+    int num_threads
+) {
+    // the coupler vectors are validated by `build_adjacency`
+    steepest_gradient_descent(
+        states, energies, num_steps, num_samples,
+        build_ising_graph(linear_biases, coupler_starts, coupler_ends, coupler_weights),
+        solver, num_threads
+    );
+}
+
+
+// Perform `num_samples` runs of steepest gradient descent on a general problem
+// given by the neighbors of each variable.
+//
+// @param states, energies, num_steps, num_samples, linear_biases,
+//        solver, num_threads see `steepest_gradient_descent`
+// @param neighbors lists of the neighbors of each variable, such that
+//        neighbors[i][j] is the jth neighbor of variable i
+// @param neighbour_couplings same as neighbors, but instead has the J value.
+//        neighbour_couplings[i][j] is the J value or weight on the coupling
+//        between variables i and neighbors[i][j].
+//
+// @return Nothing. Results are in `states` buffer.
+void steepest_gradient_descent_neighbors(
+    std::int8_t* states,
+    double* energies,
+    unsigned* num_steps,
+    const int num_samples,
+    const vector<double>& linear_biases,
+    const vector<vector<int>>& neighbors,
+    const vector<vector<double>>& neighbour_couplings,
+    DescentSolver solver,
+    int num_threads
 ) {
-    // the number of variables in the problem
     const int num_vars = linear_biases.size();
-    if (coupler_starts.size() != coupler_ends.size() ||
-        coupler_starts.size() != coupler_weights.size()
+    if (neighbors.size() != (size_t)num_vars ||
+        neighbour_couplings.size() != (size_t)num_vars
     ) {
-        throw runtime_error("coupler vectors have mismatched lengths");
+        throw runtime_error("neighbor vectors have mismatched lengths");
     }
-    
-    // neighbors is a vector of vectors, such that neighbors[i][j] is the jth
-    // neighbor of variable i
-    vector<vector<int>> neighbors(num_vars);
-    // neighbour_couplings is another vector of vectors with the same structure
-    // except neighbour_couplings[i][j] is the weight on the coupling between i
-    // and its jth neighbor
-    vector<vector<double>> neighbour_couplings(num_vars);
-
-    // build the neighbors, and neighbour_couplings vectors by iterating over
-    // the input coupler vectors
-    for (unsigned coupler = 0; coupler < coupler_starts.size(); coupler++) {
-        int u = coupler_starts[coupler];
-        int v = coupler_ends[coupler];
-
-        if (u < 0 || v < 0 || u >= num_vars || v >= num_vars) {
-            throw runtime_error("coupler indexes contain an invalid variable");
-        }
 
-        // add v to u's neighbors list and vice versa
-        neighbors[u].push_back(v);
-        neighbors[v].push_back(u);
-        // add the weights
-        neighbour_couplings[u].push_back(coupler_weights[coupler]);
-        neighbour_couplings[v].push_back(coupler_weights[coupler]);
+    IsingGraph graph;
+    graph.linear = linear_biases;
+    graph.adjacency.offsets.assign(num_vars + 1, 0);
+    for (int var = 0; var < num_vars; var++) {
+        if (neighbors[var].size() != neighbour_couplings[var].size()) {
+            throw runtime_error("neighbor vectors have mismatched lengths");
+        }
+        graph.adjacency.offsets[var + 1] =
+            graph.adjacency.offsets[var] + neighbors[var].size();
+    }
+    graph.adjacency.neighbors.reserve(graph.adjacency.offsets[num_vars]);
+    for (int var = 0; var < num_vars; var++) {
+        for (unsigned idx = 0; idx < neighbors[var].size(); idx++) {
+            int n_var = neighbors[var][idx];
+            if (n_var < 0 || n_var >= num_vars) {
+                throw runtime_error("neighbor indexes contain an invalid variable");
+            }
+            graph.adjacency.neighbors.push_back({n_var, neighbour_couplings[var][idx]});
+        }
     }
 
-    // variable flip energies cache
-    vector<double> flip_energies_vector(num_vars);
+    steepest_gradient_descent(
+        states, energies, num_steps, num_samples, graph, solver, num_threads
+    );
+}
 
-    // run the steepest descent for `num_samples` times,
-    // each time seeded with the initial state from `states`
-    for (int sample = 0; sample < num_samples; sample++) {
+
+// Perform `num_samples` runs of steepest gradient descent on a problem graph,
+// which can be shared with other samplers.
+//
+// @param states, energies, num_steps, num_samples, solver, num_threads see
+//        `steepest_gradient_descent`
+// @param graph the linear biases and adjacency of the problem, see
+//        `IsingGraph`
+// @param completed if given, the index of each sample is pushed to it once
+//        its state, energy and number of steps are written, see `ReadQueue`
+//
+// @return Nothing. Results are in `states` buffer.
+void steepest_gradient_descent(
+    std::int8_t* states,
+    double* energies,
+    unsigned* num_steps,
+    const int num_samples,
+    const IsingGraph& graph,
+    DescentSolver solver,
+    int num_threads,
+    ReadQueue* completed
+) {
+    const int num_vars = graph.num_variables();
+    const vector<double>& linear_biases = graph.linear;
+    const Adjacency& adj = graph.adjacency;
+
+    // run the steepest descent on the initial state of `sample` from `states`,
+    // using the given scratch buffers
+    auto descend = [&](
+        const int sample,
+        vector<double>& flip_energies_vector,
+        vector<int>& heap,
+        vector<int>& heap_positions
+    ) {
         // get initial state from states buffer; the solution overwrites the same buffer
         std::int8_t *state = states + sample * num_vars;
 
-        if (large_sparse_opt) {
-            num_steps[sample] = steepest_gradient_descent_ls_solver(
-                state, linear_biases, neighbors, neighbour_couplings, flip_energies_vector
-            );
-        } else {
-            num_steps[sample] = steepest_gradient_descent_solver(
-                state, linear_biases, neighbors, neighbour_couplings, flip_energies_vector
-            );
+        // calculate flip energies for all variables, based on the initial
+        // state ~ O(num_vars * max_degree)
+        for (int var = 0; var < num_vars; var++) {
+            flip_energies_vector[var] = get_flip_energy(var, state, linear_biases, adj);
         }
 
-        // compute the energy of the sample
-        energies[sample] = get_state_energy(
-            state, linear_biases, coupler_starts, coupler_ends, coupler_weights
+        // the energy of the initial state follows from the flip energies
+        // ~ O(num_vars), and the solvers track its changes
+        double energy = state_energy_from_flip_energies(
+            state, linear_biases, flip_energies_vector.data()
+        );
+
+        num_steps[sample] = descent_run(
+            state, linear_biases, adj, flip_energies_vector, energy, solver,
+            heap, heap_positions
+        );
+
+        energies[sample] = energy;
+        VERIFY_ENERGY(energy, get_state_energy(state, linear_biases, adj));
+        if (completed) completed->push(sample);
+    };
+
+    // each thread claims samples from a shared counter and has its own
+    // scratch buffers: the variable flip energies cache, and the buffers of
+    // the heap solver
+    std::atomic<int> next_sample(0);
+    std::atomic<bool> stop(false);
+    std::mutex lock;
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+        vector<double> flip_energies_vector(num_vars);
+        vector<int> heap, heap_positions;
+
+        while (!stop) {
+            const int sample = next_sample++;
+            if (sample >= num_samples) break;
+
+            try {
+                descend(sample, flip_energies_vector, heap, heap_positions);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) error = std::current_exception();
+                stop = true;
+            }
+        }
+    };
+
+    // on fewer than two threads, run the steepest descent for `num_samples`
+    // times on this thread
+    num_threads = std::min(num_threads, num_samples);
+    run_parallel(num_threads, worker);
+
+    if (error) std::rethrow_exception(error);
+}
+
+
+
+// Perform `num_samples` runs of an iterated local search on a problem graph.
+// Each run descends from its initial state, then repeatedly flips
+// `perturbation_size` distinct random variables of its current minimum and
+// descends again, keeping the new minimum if its energy is no higher and
+// otherwise undoing the flips. Both the perturbation and the descent update
+// the flip energies and their heap incrementally, and the rejected flips are
+// undone the same way, so an iteration costs
+// O((perturbation_size + downhill_steps) * max_degree * logN) rather than
+// O(problem).
+//
+// @param states, energies, num_steps, num_samples, graph, num_threads,
+//        completed see `steepest_gradient_descent`. `num_steps` receives the
+//        downhill steps of all of the descents of each sample.
+// @param perturbation_size the number of variables flipped per iteration,
+//        at most the number of variables
+// @param max_iterations the number of iterations of each sample, or a
+//        negative number for no limit
+// @param time_limit the time, in seconds, each sample may take, or infinity
+//        for no limit
+// @param seed the perturbations of sample `i` are drawn from stream `i` of
+//        the seed, so with no time limit the results do not depend on
+//        `num_threads`
+//
+// @return Nothing. Results are in `states` buffer.
+void iterated_local_search(
+    std::int8_t* states,
+    double* energies,
+    unsigned* num_steps,
+    const int num_samples,
+    const IsingGraph& graph,
+    const int perturbation_size,
+    const std::int64_t max_iterations,
+    const double time_limit,
+    const std::uint64_t seed,
+    int num_threads,
+    ReadQueue* completed
+) {
+    if (perturbation_size < 1) {
+        throw runtime_error("perturbation_size must be positive");
+    }
+    if (max_iterations < 0 && !(time_limit < std::numeric_limits<double>::infinity())) {
+        throw runtime_error("the search needs an iteration or a time limit");
+    }
+
+    const int num_vars = graph.num_variables();
+    const vector<double>& linear_biases = graph.linear;
+    const Adjacency& adj = graph.adjacency;
+    const int k = std::min(perturbation_size, num_vars);
+
+    // run the search from the initial state of `sample` from `states`, using
+    // the given scratch buffers
+    auto search = [&](
+        const int sample,
+        vector<double>& flip_energies,
+        vector<int>& heap,
+        vector<int>& heap_positions,
+        vector<int>& flipped,
+        vector<char>& picked
+    ) {
+        std::int8_t *state = states + static_cast<std::size_t>(sample) * num_vars;
+        StreamRng rng(seed, sample);
+        Deadline deadline(time_limit);
+
+        for (int var = 0; var < num_vars; var++) {
+            flip_energies[var] = get_flip_energy(var, state, linear_biases, adj);
+        }
+        double energy = state_energy_from_flip_energies(
+            state, linear_biases, flip_energies.data()
         );
+
+        FlipEnergyHeap flip_energies_heap(flip_energies, heap, heap_positions);
+        unsigned steps = heap_descent(state, adj, flip_energies, energy, flip_energies_heap);
+        double best = energy;
+
+        for (std::int64_t it = 0; k > 0 && (max_iterations < 0 || it < max_iterations); it++) {
+            if (deadline.expired()) break;
+
+            // flip `k` distinct variables of the minimum ~ O(k * max_degree * logN)
+            flipped.clear();
+            for (int i = 0; i < k; i++) {
+                int var;
+                do {
+                    var = rng.below(num_vars);
+                } while (picked[var]);
+                picked[var] = 1;
+                flipped.push_back(var);
+                heap_flip(var, state, adj, flip_energies, energy, flip_energies_heap);
+            }
+            for (int i = 0; i < k; i++) picked[flipped[i]] = 0;
+
+            steps += heap_descent(state, adj, flip_energies, energy, flip_energies_heap, &flipped);
+
+            // no worse, so the search can drift across plateaus
+            if (energy <= best) {
+                best = energy;
+                continue;
+            }
+
+            // otherwise back to the previous minimum
+            for (auto var = flipped.rbegin(); var != flipped.rend(); ++var) {
+                heap_flip(*var, state, adj, flip_energies, energy, flip_energies_heap);
+            }
+            energy = best;
+        }
+
+        // the energy tracked over many iterations gathers rounding errors, so
+        // it is recomputed ~ O(num_vars * max_degree)
+        num_steps[sample] = steps;
+        energies[sample] = get_state_energy(state, linear_biases, adj);
+        if (completed) completed->push(sample);
+    };
+
+    // each thread claims samples from a shared counter and has its own
+    // scratch buffers, see `steepest_gradient_descent`
+    std::atomic<int> next_sample(0);
+    std::atomic<bool> stop(false);
+    std::mutex lock;
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+        vector<double> flip_energies(num_vars);
+        vector<int> heap, heap_positions, flipped;
+        vector<char> picked(num_vars, 0);
+
+        while (!stop) {
+            const int sample = next_sample++;
+            if (sample >= num_samples) break;
+
+            try {
+                search(sample, flip_energies, heap, heap_positions, flipped, picked);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) error = std::current_exception();
+                stop = true;
+            }
+        }
+    };
+
+    num_threads = std::min(num_threads, num_samples);
+    run_parallel(num_threads, worker);
+
+    if (error) std::rethrow_exception(error);
+}
+
+DescentState::DescentState(
+    const IsingGraph& graph,
+    const std::int8_t* initial_states,
+    const int num_samples,
+    unsigned* num_steps,
+    int num_threads
+) : graph_(graph), num_samples_(num_samples) {
+    if (num_samples < 0) {
+        throw runtime_error("num_samples must be non-negative");
     }
+
+    // merged couplers have a single record in each row to update
+    AdjacencyOptions options;
+    options.merge_duplicates = true;
+    arrange_adjacency(graph_.adjacency, options);
+
+    const int num_vars = num_variables();
+    states_.assign(initial_states,
+                   initial_states + static_cast<std::size_t>(num_samples) * num_vars);
+    energies_.resize(num_samples);
+    flip_energies_.resize(num_samples);
+    heaps_.resize(num_samples);
+    heap_positions_.resize(num_samples);
+
+    const vector<double>& linear_biases = graph_.linear;
+    const Adjacency& adj = graph_.adjacency;
+
+    auto task = [&](const int sample) {
+        std::int8_t* state = states_.data() + static_cast<std::size_t>(sample) * num_vars;
+        vector<double>& flip_energies = flip_energies_[sample];
+
+        flip_energies.resize(num_vars);
+        for (int var = 0; var < num_vars; var++) {
+            flip_energies[var] = get_flip_energy(var, state, linear_biases, adj);
+        }
+        double energy = get_state_energy(state, linear_biases, adj);
+
+        FlipEnergyHeap flip_energies_heap(
+            flip_energies, heaps_[sample], heap_positions_[sample]);
+        const unsigned steps = heap_descent(
+            state, adj, flip_energies, energy, flip_energies_heap);
+
+        energies_[sample] = energy;
+        if (num_steps) num_steps[sample] = steps;
+        VERIFY_ENERGY(energy, get_state_energy(state, linear_biases, adj));
+    };
+    run_batch(num_samples, num_threads, task);
+}
+
+
+void DescentState::update(
+    const vector<int>& linear_vars,
+    const vector<double>& linear_deltas,
+    const vector<int>& coupler_starts,
+    const vector<int>& coupler_ends,
+    const vector<double>& coupler_deltas,
+    unsigned* num_steps,
+    int num_threads
+) {
+    const int num_vars = num_variables();
+
+    // validate everything before changing anything
+    if (linear_vars.size() != linear_deltas.size()) {
+        throw runtime_error("linear vectors have mismatched lengths");
+    }
+    if (coupler_starts.size() != coupler_ends.size() ||
+            coupler_starts.size() != coupler_deltas.size()) {
+        throw runtime_error("coupler vectors have mismatched lengths");
+    }
+    for (const int v : linear_vars) {
+        if (v < 0 || v >= num_vars) {
+            throw runtime_error("linear indexes contain an invalid variable");
+        }
+    }
+    for (std::size_t i = 0; i < coupler_starts.size(); i++) {
+        if (coupler_starts[i] < 0 || coupler_starts[i] >= num_vars ||
+                coupler_ends[i] < 0 || coupler_ends[i] >= num_vars) {
+            throw runtime_error("coupler indexes contain an invalid variable");
+        }
+    }
+
+    add_couplers(coupler_starts, coupler_ends);
+
+    for (std::size_t i = 0; i < linear_vars.size(); i++) {
+        graph_.linear[linear_vars[i]] += linear_deltas[i];
+    }
+    for (std::size_t i = 0; i < coupler_starts.size(); i++) {
+        const int u = coupler_starts[i], v = coupler_ends[i];
+        if (u == v) {
+            // the merged record of a coupler from a variable to itself holds
+            // both of its halves
+            find_neighbor(u, u)->weight += 2 * coupler_deltas[i];
+        } else {
+            find_neighbor(u, v)->weight += coupler_deltas[i];
+            find_neighbor(v, u)->weight += coupler_deltas[i];
+        }
+    }
+
+    // only the flip energies of the variables whose biases changed differ
+    vector<int> touched(linear_vars);
+    touched.insert(touched.end(), coupler_starts.begin(), coupler_starts.end());
+    touched.insert(touched.end(), coupler_ends.begin(), coupler_ends.end());
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    const vector<double>& linear_biases = graph_.linear;
+    const Adjacency& adj = graph_.adjacency;
+
+    auto task = [&](const int sample) {
+        std::int8_t* state = states_.data() + static_cast<std::size_t>(sample) * num_vars;
+        vector<double>& flip_energies = flip_energies_[sample];
+
+        // the energy change of the previous minimum ~ O(touched)
+        double energy = energies_[sample];
+        for (std::size_t i = 0; i < linear_vars.size(); i++) {
+            energy += linear_deltas[i] * state[linear_vars[i]];
+        }
+        for (std::size_t i = 0; i < coupler_starts.size(); i++) {
+            const int u = coupler_starts[i], v = coupler_ends[i];
+            energy += u == v ? coupler_deltas[i] : coupler_deltas[i] * state[u] * state[v];
+        }
+
+        // and the heap from its previous descent, with the touched flip
+        // energies recomputed ~ O(touched * max_degree * logN)
+        FlipEnergyHeap flip_energies_heap(
+            flip_energies, heaps_[sample], heap_positions_[sample], false);
+        for (const int var : touched) {
+            flip_energies[var] = get_flip_energy(var, state, linear_biases, adj);
+            flip_energies_heap.update(var);
+        }
+
+        const unsigned steps = heap_descent(
+            state, adj, flip_energies, energy, flip_energies_heap);
+
+        energies_[sample] = energy;
+        if (num_steps) num_steps[sample] = steps;
+        VERIFY_ENERGY(energy, get_state_energy(state, linear_biases, adj));
+    };
+    run_batch(num_samples_, num_threads, task);
+}
+
+
+Neighbor* DescentState::find_neighbor(int u, int v) {
+    Adjacency& adj = graph_.adjacency;
+    Neighbor* first = adj.neighbors.data() + adj.offsets[u];
+    Neighbor* last = adj.neighbors.data() + adj.offsets[u + 1];
+    Neighbor* it = std::lower_bound(first, last, v,
+        [](const Neighbor& n, int var) { return n.var < var; });
+    return (it != last && it->var == v) ? it : nullptr;
+}
+
+
+void DescentState::add_couplers(
+    const vector<int>& coupler_starts,
+    const vector<int>& coupler_ends
+) {
+    bool missing = false;
+    for (std::size_t i = 0; i < coupler_starts.size() && !missing; i++) {
+        missing = find_neighbor(coupler_starts[i], coupler_ends[i]) == nullptr;
+    }
+    if (!missing) return;
+
+    // the couplers of the problem, each once, followed by the given ones with
+    // no weight, which the merge folds into the existing ones
+    const int num_vars = num_variables();
+    const Adjacency& adj = graph_.adjacency;
+    vector<int> starts, ends;
+    vector<double> weights;
+    for (int var = 0; var < num_vars; var++) {
+        for (const Neighbor* n = adj.begin(var); n != adj.end(var); ++n) {
+            if (n->var > var) {
+                starts.push_back(var);
+                ends.push_back(n->var);
+                weights.push_back(n->weight);
+            } else if (n->var == var) {
+                starts.push_back(var);
+                ends.push_back(var);
+                weights.push_back(n->weight / 2);
+            }
+        }
+    }
+    starts.insert(starts.end(), coupler_starts.begin(), coupler_starts.end());
+    ends.insert(ends.end(), coupler_ends.begin(), coupler_ends.end());
+    weights.resize(starts.size(), 0.0);
+
+    AdjacencyOptions options;
+    options.merge_duplicates = true;
+    graph_.adjacency = build_adjacency(num_vars, starts, ends, weights, options);
 }
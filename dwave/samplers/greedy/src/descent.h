@@ -15,11 +15,24 @@
 #ifndef _DESCENT_H
 #define _DESCENT_H
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
+#include "batch.h"
+#include "graph.h"
+#include "read_queue.h"
+#include "rng.h"
+
 using std::vector;
 
+// The data structure used to find the steepest descent variable. All of them
+// give the same descents.
+enum DescentSolver {
+    LinearSearch,  /// linear search over the flip energies, best for dense problems
+    OrderedSet,    /// flip energies in a balanced binary tree
+    IndexedHeap,   /// flip energies in an indexed binary heap, best for large sparse problems
+};
 
 double get_flip_energy(
     int var,
@@ -37,18 +50,42 @@ double get_state_energy(
     const vector<double>& coupler_weights
 );
 
-unsigned steepest_gradient_descent_solver(
+double get_state_energy(
     std::int8_t* state,
     const vector<double>& linear_biases,
     const vector<vector<int>>& neighbors,
     const vector<vector<double>>& neighbour_couplings
 );
 
+double get_state_energy(
+    std::int8_t* state,
+    const vector<double>& linear_biases,
+    const Adjacency& adj
+);
+
+unsigned steepest_gradient_descent_solver(
+    std::int8_t* state,
+    const vector<double>& linear_biases,
+    const Adjacency& adj,
+    vector<double>& flip_energies,
+    double& energy
+);
+
 unsigned steepest_gradient_descent_ls_solver(
     std::int8_t* state,
     const vector<double>& linear_biases,
-    const vector<vector<int>>& neighbors,
-    const vector<vector<double>>& neighbour_couplings
+    const Adjacency& adj,
+    vector<double>& flip_energies,
+    double& energy
+);
+
+unsigned steepest_gradient_descent_run(
+    std::int8_t* state,
+    const vector<double>& linear_biases,
+    const Adjacency& adj,
+    vector<double>& flip_energies,
+    double& energy,
+    DescentSolver solver=LinearSearch
 );
 
 void steepest_gradient_descent(
@@ -60,7 +97,220 @@ void steepest_gradient_descent(
     const vector<int>& coupler_starts,
     const vector<int>& coupler_ends,
     const vector<double>& coupler_weights,
-    bool large_sparse_opt=false
+    DescentSolver solver=LinearSearch,
+    int num_threads=1
+);
+
+void steepest_gradient_descent_neighbors(
+    std::int8_t* states,
+    double* energies,
+    unsigned* num_steps,
+    const int num_samples,
+    const vector<double>& linear_biases,
+    const vector<vector<int>>& neighbors,
+    const vector<vector<double>>& neighbour_couplings,
+    DescentSolver solver,
+    int num_threads=1
 );
 
+void steepest_gradient_descent(
+    std::int8_t* states,
+    double* energies,
+    unsigned* num_steps,
+    const int num_samples,
+    const IsingGraph& graph,
+    DescentSolver solver=LinearSearch,
+    int num_threads=1,
+    ReadQueue* completed=nullptr
+);
+
+// Perform `num_samples` runs of steepest gradient descent on a SPIN-valued
+// binary quadratic model, reading its biases in place rather than from
+// flattened coupler vectors, see `build_ising_graph`. The energies do not
+// include the model's offset.
+template <class BQM>
+void steepest_gradient_descent(
+    std::int8_t* states,
+    double* energies,
+    unsigned* num_steps,
+    const int num_samples,
+    const BQM& bqm,
+    DescentSolver solver=LinearSearch,
+    int num_threads=1,
+    ReadQueue* completed=nullptr
+) {
+    steepest_gradient_descent(
+        states, energies, num_steps, num_samples,
+        build_ising_graph(bqm), solver, num_threads, completed
+    );
+}
+
+void iterated_local_search(
+    std::int8_t* states,
+    double* energies,
+    unsigned* num_steps,
+    const int num_samples,
+    const IsingGraph& graph,
+    const int perturbation_size,
+    const std::int64_t max_iterations,
+    const double time_limit,
+    const std::uint64_t seed,
+    int num_threads=1,
+    ReadQueue* completed=nullptr
+);
+
+// Perform `num_samples` runs of an iterated local search on a SPIN-valued
+// binary quadratic model, read in place, see `build_ising_graph`. Each run
+// perturbs and re-descends its minimum within one call, for `max_iterations`
+// iterations (if not negative) or `time_limit` seconds, whichever comes
+// first. The energies do not include the model's offset.
+template <class BQM>
+void iterated_local_search(
+    std::int8_t* states,
+    double* energies,
+    unsigned* num_steps,
+    const int num_samples,
+    const BQM& bqm,
+    const int perturbation_size,
+    const std::int64_t max_iterations,
+    const double time_limit,
+    const std::uint64_t seed,
+    int num_threads=1,
+    ReadQueue* completed=nullptr
+) {
+    iterated_local_search(
+        states, energies, num_steps, num_samples, build_ising_graph(bqm),
+        perturbation_size, max_iterations, time_limit, seed, num_threads, completed
+    );
+}
+
+// The local minima found by steepest descent from a set of initial states,
+// kept together with the problem and the flip energies of every sample, so
+// that they can be descended again after a few biases of the problem change.
+// An update only recomputes the flip energies of the variables it touches and
+// re-descends each sample from its previous minimum with an indexed heap, so
+// a small change costs O(touched variables * max_degree * logN) per sample,
+// plus its downhill steps, rather than O(problem).
+//
+// The problem is copied, with its couplers between the same two variables
+// merged into a single one.
+class DescentState {
+  public:
+    // Descends from `num_samples` initial states of `graph`, `num_variables`
+    // values each, over `num_threads` threads. If given, `num_steps` receives
+    // the number of downhill steps of each sample.
+    DescentState(
+        const IsingGraph& graph,
+        const std::int8_t* initial_states,
+        const int num_samples,
+        unsigned* num_steps=nullptr,
+        int num_threads=1
+    );
+
+    // Adds `linear_deltas[i]` to the linear bias of `linear_vars[i]`, and
+    // `coupler_deltas[i]` to the coupling between `coupler_starts[i]` and
+    // `coupler_ends[i]`, then descends every sample from its current state.
+    // Couplers the problem does not have yet are added; doing so rebuilds
+    // the adjacency, in O(problem).
+    //
+    // @param num_steps if given, the number of downhill steps of each sample
+    // @param num_threads the number of threads to distribute the samples
+    //        over. The results do not depend on the number of threads.
+    void update(
+        const vector<int>& linear_vars,
+        const vector<double>& linear_deltas,
+        const vector<int>& coupler_starts,
+        const vector<int>& coupler_ends,
+        const vector<double>& coupler_deltas,
+        unsigned* num_steps=nullptr,
+        int num_threads=1
+    );
+
+    int num_variables() const { return graph_.num_variables(); }
+    int num_samples() const { return num_samples_; }
+
+    // The current problem, with all the updates applied.
+    const IsingGraph& graph() const { return graph_; }
+
+    // The minima, `num_samples` rows of `num_variables` values.
+    const std::int8_t* states() const { return states_.data(); }
+
+    // The energies of the minima, without any offset.
+    const double* energies() const { return energies_.data(); }
+
+  private:
+    // Adds the couplers that are not in the adjacency yet, keeping its rows
+    // sorted and free of duplicates.
+    void add_couplers(
+        const vector<int>& coupler_starts,
+        const vector<int>& coupler_ends
+    );
+
+    // The record of `v` in the row of `u`, or null if they are not coupled.
+    Neighbor* find_neighbor(int u, int v);
+
+    IsingGraph graph_;
+    int num_samples_;
+    vector<std::int8_t> states_;
+    vector<double> energies_;
+
+    // the flip energies of each sample, and the heap over them
+    vector<vector<double>> flip_energies_;
+    vector<vector<int>> heaps_;
+    vector<vector<int>> heap_positions_;
+};
+
+// Perform `num_samples` runs of steepest gradient descent on each of a batch
+// of SPIN-valued binary quadratic models, read in place, from random initial
+// states. The models are spread over `num_threads` threads, each of which
+// builds the graph of one model at a time and descends from all of its
+// initial states in turn, see `run_batch`.
+//
+// @param bqms the models
+// @param states the samples of each model in turn, `num_samples` rows of
+//        `bqms[i]->num_variables()` values for model `i`
+// @param energies, num_steps those of the samples of each model in turn;
+//        the energies do not include the offsets
+// @param num_samples the number of samples of each model
+// @param seed the initial states of model `i` are drawn from stream `i` of
+//        the seed, so the results do not depend on `num_threads`
+template <class BQM>
+void steepest_gradient_descent_batch(
+    const vector<BQM*>& bqms,
+    std::int8_t* states,
+    double* energies,
+    unsigned* num_steps,
+    const int num_samples,
+    const std::uint64_t seed,
+    DescentSolver solver=LinearSearch,
+    int num_threads=1
+) {
+    // the offsets of the samples of each model
+    vector<std::int64_t> offsets(bqms.size() + 1, 0);
+    for (std::size_t i = 0; i < bqms.size(); i++) {
+        offsets[i + 1] = offsets[i] +
+            static_cast<std::int64_t>(num_samples) * bqms[i]->num_variables();
+    }
+
+    auto task = [&](const int i) {
+        const std::int64_t first = static_cast<std::int64_t>(num_samples) * i;
+        if (offsets[i + 1] == offsets[i]) {
+            std::fill(energies + first, energies + first + num_samples, 0.0);
+            std::fill(num_steps + first, num_steps + first + num_samples, 0u);
+            return;
+        }
+
+        StreamRng rng(seed, i);
+        for (std::int64_t k = offsets[i]; k < offsets[i + 1]; k++) {
+            states[k] = (rng() >> 63) ? 1 : -1;
+        }
+
+        steepest_gradient_descent(
+            states + offsets[i], energies + first, num_steps + first,
+            num_samples, build_ising_graph(*bqms[i]), solver, 1
+        );
+    };
+    run_batch(bqms.size(), num_threads, task);
+}
+
 #endif
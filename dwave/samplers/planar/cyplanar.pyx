@@ -0,0 +1,83 @@
+# distutils: language = c++
+# distutils: include_dirs = dwave/samplers/planar/src/
+# distutils: sources = dwave/samplers/planar/src/planar.cpp dwave/samplers/planar/src/matching.cpp
+# cython: language_level = 3
+
+# Copyright 2026 D-Wave Systems Inc.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+from libcpp.vector cimport vector
+
+import numpy as np
+cimport numpy as np
+
+cdef extern from "planar.h":
+    void planar_ground_state(
+        np.int8_t* state,
+        const int num_nodes,
+        const vector[int]& edge_starts,
+        const vector[int]& edge_ends,
+        const vector[double]& edge_weights,
+        const vector[double]& x,
+        const vector[double]& y
+    ) nogil except +
+
+
+def ground_state(int num_nodes,
+                 edge_starts, edge_ends, edge_weights,
+                 x, y):
+    """Wraps `planar_ground_state` from `planar.cpp`.
+
+    Parameters
+    ----------
+    num_nodes : int
+        The number of nodes of the graph, each of which has an edge.
+
+    edge_starts : list(int)
+        The first node of each edge.
+
+    edge_ends : list(int)
+        The second node of each edge.
+
+    edge_weights : list(float)
+        The weight of each edge, -2 times its coupling in the SPIN domain.
+
+    x : list(float)
+        The x-coordinate of each node.
+
+    y : list(float)
+        The y-coordinate of each node.
+
+    Returns
+    -------
+    state : numpy.ndarray
+        The BINARY value of each node of a ground state, with node 0 set
+        to 0.
+
+    """
+    state_numpy = np.empty(num_nodes, dtype=np.int8)
+
+    # explicitly convert all Python types to C while we have the GIL
+    cdef np.int8_t* _state = <np.int8_t*> np.PyArray_DATA(state_numpy)
+    cdef vector[int] _edge_starts = edge_starts
+    cdef vector[int] _edge_ends = edge_ends
+    cdef vector[double] _edge_weights = edge_weights
+    cdef vector[double] _x = x
+    cdef vector[double] _y = y
+
+    with nogil:
+        planar_ground_state(_state, num_nodes,
+                            _edge_starts, _edge_ends, _edge_weights, _x, _y)
+
+    return state_numpy
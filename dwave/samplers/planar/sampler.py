@@ -18,7 +18,7 @@ import typing
 import dimod
 import networkx as nx
 
-from dwave.samplers.planar.planar import rotation_from_coordinates, plane_triangulate, expanded_dual
+from dwave.samplers.planar.cyplanar import ground_state
 from dwave.samplers.planar.util import bqm_to_multigraph
 
 __all__ = ["PlanarGraphSolver"]
@@ -69,24 +69,25 @@ class PlanarGraphSolver(dimod.Sampler, dimod.Initialized):
         if pos is None:
             pos = _determine_pos(G)
 
-        # apply the rotation system
-        r = rotation_from_coordinates(G, pos)
-        nx.set_node_attributes(G, name='rotation', values=r)
-
-        # triangulation
-        plane_triangulate(G)
-
-        # create an edge indexing scheme
-        indices = {edge: idx for idx, edge in enumerate(G.edges(keys=True))}
-        nx.set_edge_attributes(G, name='index', values=indices)
-
-        dual = expanded_dual(G)
-        matching = nx.max_weight_matching(dual, maxcardinality=True, weight='weight')
-
-        assert nx.is_perfect_matching(dual, matching)
-
-        cut = _dual_matching_to_cut(G, matching)
-        state = _cut_to_state(G, cut)
+        # the nodes are indexed in order, so that the first of them is the
+        # one whose state is set to 0
+        nodes = list(G)
+        index = {v: i for i, v in enumerate(nodes)}
+        edge_starts = []
+        edge_ends = []
+        edge_weights = []
+        for u, v, weight in G.edges(data='weight'):
+            edge_starts.append(index[u])
+            edge_ends.append(index[v])
+            edge_weights.append(weight)
+
+        try:
+            binary = ground_state(len(nodes), edge_starts, edge_ends, edge_weights,
+                                  [pos[v][0] for v in nodes], [pos[v][1] for v in nodes])
+        except RuntimeError as err:
+            raise ValueError(str(err)) from err
+
+        state = dict(zip(nodes, binary.tolist()))
 
         if bqm.vartype is not dimod.BINARY:
             state = {v: 2 * b - 1 for v, b in state.items()}
@@ -100,43 +101,3 @@ def _determine_pos(G: nx.MultiGraph) -> dict:
         raise ValueError("The provided BQM does not yield a planar embedding")
 
     return nx.planar_layout(P)
-
-
-def _dual_matching_to_cut(G: nx.MultiGraph, matching: set) -> set:
-    """
-    Then for each edge u,v in G, the expanded dual has two nodes (u,v), (v,u) with
-    an edge between them. The matching is defined on that graph. There are
-    additional edges, but we don't care about those
-    """
-    cut = set(G.edges)
-
-    # need to get the cut from the matching
-    for u, v in matching:
-        if u[0] == v[1] and u[1] == v[0] and u[2] == v[2]:
-            cut.discard(u)
-            cut.discard(v)
-
-    return cut
-
-
-def _cut_to_state(G: nx.MultiGraph, cut: set, node=None, val=0) -> dict:
-    if node is None:
-        node = next(iter(G))  # get any node and assign it to val
-
-    state = {}
-
-    def _cut_to_state0(v, s):
-        if v in state:
-            assert state[v] == s, "Inconsistent state"
-        else:
-            state[v] = s
-            for u in G[v]:
-                for key in G[u][v]:
-                    if (u, v, key) in cut or (v, u, key) in cut:
-                        _cut_to_state0(u, 1 - s)
-                    else:
-                        _cut_to_state0(u, s)
-
-    _cut_to_state0(node, val)
-
-    return state
@@ -0,0 +1,676 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// The blossom algorithm follows the design of Kolmogorov's Blossom V, as a
+// minimum cost perfect matching with the costs -w: the vertices are 0..n-1
+// and the blossoms n..2n-1, the nodes, and edge k has the half-edges 2k and
+// 2k+1, whose vertices are `endpoint[h]`. Every half-edge is in the list of
+// the node it currently leaves, `head[h]`: that of the outermost node for
+// which the edge is external, so the edges inside a blossom stay with its
+// children and its list holds its boundary. The slack of each edge is kept,
+// rather than worked out from the duals, so after it is shrunk a blossom is
+// handled as a single node, and its children are only visited again when it
+// is expanded.
+//
+// All the free vertices root alternating trees at once, which share the total
+// dual change so far, epsilon, applied lazily: the dual of a labelled node x
+// has changed by `label[x] * (epsilon - since[x])` beyond `dual[x]`, and the
+// slacks of its edges by as much the other way. An augmentation between two
+// trees releases both, and their nodes rejoin the others as they are met
+// again. The least-slack edges and the T-blossom of least dual are found with
+// heaps of the candidates met while the trees grow. Each node gets a fresh
+// stamp whenever its label or its place among the blossoms changes, which
+// invalidates the candidates found for it before.
+//
+// The matching is kept for the outer nodes only, and that of the children of
+// a blossom is set from its own when it is expanded.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "matching.h"
+
+using std::vector;
+
+namespace {
+
+class BlossomMatching {
+  public:
+    BlossomMatching(
+        const int num_vertices,
+        const vector<int>& edge_starts,
+        const vector<int>& edge_ends,
+        const vector<double>& edge_weights
+    ) : n_(num_vertices), m_(edge_weights.size()) {
+        if (num_vertices < 0) throw std::invalid_argument("num_vertices must be non-negative");
+        if (edge_starts.size() != edge_weights.size() || edge_ends.size() != edge_weights.size()) {
+            throw std::invalid_argument("edge vectors have mismatched lengths");
+        }
+
+        endpoint_.resize(2 * m_);
+        for (int k = 0; k < m_; k++) {
+            const int i = edge_starts[k], j = edge_ends[k];
+            if (i < 0 || i >= n_ || j < 0 || j >= n_) {
+                throw std::invalid_argument("edges contain an invalid vertex");
+            }
+            endpoint_[2 * k] = i;
+            endpoint_[2 * k + 1] = j;
+        }
+
+        head_.assign(2 * m_, -1);
+        next_.assign(2 * m_, -1);
+        prev_.assign(2 * m_, -1);
+        first_.assign(2 * n_, -1);
+        for (int h = 0; h < 2 * m_; h++) {
+            // a self-loop is never matched
+            if (endpoint_[h] != endpoint_[h ^ 1]) link(endpoint_[h], h);
+        }
+
+        parent_.assign(2 * n_, -1);
+        label_.assign(2 * n_, 0);
+        root_.assign(2 * n_, -1);
+        members_.resize(n_);
+        match_.assign(2 * n_, -1);
+        tree_.assign(2 * n_, -1);
+        dual_.assign(2 * n_, 0);
+        since_.assign(2 * n_, 0);
+        stamp_.assign(2 * n_, 0);
+        mark_.assign(2 * n_, 0);
+        held_.assign(2 * m_, -1);
+        slack_.resize(m_);
+        next_blossom_ = n_;
+
+        jump_start(edge_weights);
+    }
+
+    vector<int> solve() {
+        for (int v = 0; v < n_; v++) {
+            if (match_[v] != -1) continue;
+            relabel(v, 1, v);
+            queue_.push_back(v);
+            free_roots_++;
+        }
+
+        while (free_roots_) {
+            while (!queue_.empty()) {
+                const int x = queue_.back();
+                queue_.pop_back();
+                if (parent_[x] == -1 && label_[x] == 1) scan(x);
+            }
+            if (!free_roots_) break;
+
+            // the largest dual change that keeps the duals feasible
+            drop_invalid_candidates();
+            vector<Candidate>* next = nullptr;
+            for (vector<Candidate>* heap : {&to_free_, &between_s_, &t_blossoms_}) {
+                if (!heap->empty() && (next == nullptr || heap->front().key < next->front().key)) {
+                    next = heap;
+                }
+            }
+            if (next == nullptr) throw std::runtime_error("the graph has no perfect matching");
+
+            const int index = next->front().index;
+            epsilon_ = std::max(epsilon_, next->front().key);
+            pop(*next);
+            if (next == &to_free_) {
+                grow(index);
+            } else if (next == &between_s_) {
+                join(index / 2);
+            } else {
+                expand(index);
+            }
+        }
+
+        // the matching of the vertices, from that of the outer blossoms
+        vector<int> stack;
+        for (int b = n_; b < next_blossom_; b++) {
+            if (parent_[b] == -1 && !blossom(b).childs.empty()) stack.push_back(b);
+        }
+        while (!stack.empty()) {
+            const int b = stack.back();
+            stack.pop_back();
+            const vector<int> childs = blossom(b).childs;
+            dissolve(b, half_at(match_[b], b));
+            for (const int child : childs) {
+                if (child >= n_) stack.push_back(child);
+            }
+        }
+
+        return vector<int>(match_.begin(), match_.begin() + n_);
+    }
+
+  private:
+    // The children of a blossom, around its odd cycle, and the edge from
+    // each child to the next
+    struct Blossom {
+        vector<int> childs;
+        vector<int> edges;
+    };
+
+    // A candidate for the next dual change: a half-edge at a S-node, whose
+    // slack would drop to zero at epsilon = `key`, or a T-blossom, whose dual
+    // would. `stamps` are those of the nodes when it was found.
+    struct Candidate {
+        double key;
+        int index;
+        std::uint64_t stamps[2];
+
+        bool operator>(const Candidate& other) const { return key > other.key; }
+    };
+
+    int n_;
+    int m_;
+    vector<int> endpoint_;
+    vector<double> slack_;
+
+    // the half-edges leaving each node, as circular doubly linked lists
+    vector<int> head_;
+    vector<int> next_;
+    vector<int> prev_;
+    vector<int> first_;
+
+    vector<int> parent_;
+    vector<int> label_;
+    // the root of the tree of each labelled node, and the nodes labelled in
+    // the tree of each root
+    vector<int> root_;
+    vector<vector<int>> members_;
+    int free_roots_ = 0;
+    // the matched edge of each outer node, and the edge from each T-node to
+    // its parent in the tree
+    vector<int> match_;
+    vector<int> tree_;
+    vector<double> dual_;
+    vector<double> since_;
+    vector<std::uint64_t> stamp_;
+    std::uint64_t stamp_count_ = 0;
+    vector<int> mark_;
+    int mark_count_ = 0;
+
+    // the nodes each half-edge left as it was moved out to blossoms, as
+    // linked stacks in a shared pool, so that expanding a blossom does not
+    // walk up from the vertices to its children
+    vector<int> held_;
+    vector<int> held_node_;
+    vector<int> held_next_;
+    int held_free_ = -1;
+
+    // the blossoms are only stored once they are used, indexed from n
+    vector<Blossom> blossoms_;
+    vector<int> unused_blossoms_;
+    int next_blossom_;
+
+    // the total dual change so far, and the S-nodes to scan
+    double epsilon_ = 0;
+    vector<int> queue_;
+    // min-heaps of the edges from S-nodes to free nodes, of the edges
+    // between S-nodes and of the T-blossoms
+    vector<Candidate> to_free_;
+    vector<Candidate> between_s_;
+    vector<Candidate> t_blossoms_;
+
+    Blossom& blossom(const int b) { return blossoms_[b - n_]; }
+
+    void link(const int x, const int h) {
+        head_[h] = x;
+        if (first_[x] == -1) {
+            first_[x] = next_[h] = prev_[h] = h;
+        } else {
+            const int f = first_[x];
+            next_[h] = f;
+            prev_[h] = prev_[f];
+            next_[prev_[f]] = h;
+            prev_[f] = h;
+        }
+    }
+
+    void unlink(const int x, const int h) {
+        if (next_[h] == h) {
+            first_[x] = -1;
+        } else {
+            next_[prev_[h]] = next_[h];
+            prev_[next_[h]] = prev_[h];
+            if (first_[x] == h) first_[x] = next_[h];
+        }
+    }
+
+    // Fills `halves` with the half-edges leaving x
+    void list(const int x, vector<int>& halves) const {
+        halves.clear();
+        const int f = first_[x];
+        if (f == -1) return;
+        int h = f;
+        do {
+            halves.push_back(h);
+            h = next_[h];
+        } while (h != f);
+    }
+
+    void push_head(const int h) {
+        int entry = held_free_;
+        if (entry == -1) {
+            entry = held_node_.size();
+            held_node_.push_back(0);
+            held_next_.push_back(0);
+        } else {
+            held_free_ = held_next_[entry];
+        }
+        held_node_[entry] = head_[h];
+        held_next_[entry] = held_[h];
+        held_[h] = entry;
+    }
+
+    int pop_head(const int h) {
+        const int entry = held_[h];
+        held_[h] = held_next_[entry];
+        held_next_[entry] = held_free_;
+        held_free_ = entry;
+        return held_node_[entry];
+    }
+
+    // the half-edge of edge k leaving node x
+    int half_at(const int k, const int x) const { return head_[2 * k] == x ? 2 * k : 2 * k + 1; }
+
+    // the node at the far side of edge k from node x
+    int other(const int k, const int x) const { return head_[half_at(k, x) ^ 1]; }
+
+    double offset(const int x) const { return label_[x] * (epsilon_ - since_[x]); }
+
+    double slack(const int k) const {
+        return slack_[k] - offset(head_[2 * k]) - offset(head_[2 * k + 1]);
+    }
+
+    // Applies the lazy dual change of node x to its dual and its edges
+    void settle(const int x) {
+        const double d = offset(x);
+        since_[x] = epsilon_;
+        if (d == 0) return;
+        dual_[x] += d;
+        const int f = first_[x];
+        if (f == -1) return;
+        int h = f;
+        do {
+            slack_[h / 2] -= d;
+            h = next_[h];
+        } while (h != f);
+    }
+
+    void relabel(const int x, const int t, const int root = -1) {
+        settle(x);
+        label_[x] = t;
+        root_[x] = root;
+        stamp_[x] = ++stamp_count_;
+        if (t) members_[root].push_back(x);
+    }
+
+    static void push(vector<Candidate>& heap, const Candidate& candidate) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+    }
+
+    static void pop(vector<Candidate>& heap) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Candidate>());
+        heap.pop_back();
+    }
+
+    // A candidate for the edge of half-edge h, at a S-node
+    Candidate edge_candidate(const double key, const int h) const {
+        return {key, h, {stamp_[head_[h]], stamp_[head_[h ^ 1]]}};
+    }
+
+    bool is_current(const Candidate& candidate) const {
+        const int h = candidate.index;
+        return stamp_[head_[h]] == candidate.stamps[0] && stamp_[head_[h ^ 1]] == candidate.stamps[1];
+    }
+
+    // Makes the duals feasible, with a tight edge at every vertex, and
+    // matches vertices greedily along tight edges.
+    void jump_start(const vector<double>& weights) {
+        for (int v = 0; v < n_; v++) {
+            if (first_[v] == -1) throw std::runtime_error("the graph has no perfect matching");
+            double best = std::numeric_limits<double>::infinity();
+            int h = first_[v];
+            do {
+                best = std::min(best, -weights[h / 2] / 2);
+                h = next_[h];
+            } while (h != first_[v]);
+            dual_[v] = best;
+        }
+
+        for (int v = 0; v < n_; v++) {
+            if (match_[v] != -1) continue;
+
+            // raise the dual of v until one of its edges is tight
+            double best = std::numeric_limits<double>::infinity();
+            int h = first_[v];
+            do {
+                best = std::min(best, -weights[h / 2] - dual_[endpoint_[h ^ 1]]);
+                h = next_[h];
+            } while (h != first_[v]);
+            dual_[v] = best;
+
+            h = first_[v];
+            do {
+                const int w = endpoint_[h ^ 1];
+                if (match_[w] == -1 && -weights[h / 2] - dual_[v] - dual_[w] <= 0) {
+                    match_[v] = match_[w] = h / 2;
+                    break;
+                }
+                h = next_[h];
+            } while (h != first_[v]);
+        }
+
+        for (int k = 0; k < m_; k++) {
+            slack_[k] = -weights[k] - dual_[endpoint_[2 * k]] - dual_[endpoint_[2 * k + 1]];
+        }
+    }
+
+    // The S-node above S-node s in the tree, or -1 for the root
+    int tree_parent(const int s) const {
+        if (match_[s] == -1) return -1;
+        const int t = other(match_[s], s);
+        return other(tree_[t], t);
+    }
+
+    // Drops the labels of the tree of `root`, whose nodes are free again
+    void release(const int root, vector<int>& released) {
+        for (const int x : members_[root]) {
+            if (parent_[x] != -1 || label_[x] == 0 || root_[x] != root) continue;
+            relabel(x, 0);
+            released.push_back(x);
+        }
+        members_[root].clear();
+    }
+
+    // Augments the matching along the tight edge k between S-nodes of two
+    // trees, swapping the matched and unmatched edges up to both roots, and
+    // drops the two trees
+    void augment(const int k) {
+        const int roots[2] = {root_[head_[2 * k]], root_[head_[2 * k + 1]]};
+        for (const int x : {head_[2 * k], head_[2 * k + 1]}) {
+            int s = x, edge = k;
+            for (;;) {
+                const int old = match_[s];
+                match_[s] = edge;
+                if (old == -1) break;
+                const int t = other(old, s);
+                edge = tree_[t];
+                match_[t] = edge;
+                s = other(edge, t);
+            }
+        }
+
+        // the edges from the other trees to the free nodes are candidates
+        // again
+        vector<int> released, halves;
+        release(roots[0], released);
+        release(roots[1], released);
+        for (const int x : released) {
+            list(x, halves);
+            for (const int h : halves) {
+                if (label_[head_[h ^ 1]] != 1) continue;
+                push(to_free_, edge_candidate(epsilon_ + std::max(slack(h / 2), 0.0), h ^ 1));
+            }
+        }
+        free_roots_ -= 2;
+    }
+
+    // Grows the tree of S-node head[h] along the tight edge of half-edge h,
+    // to a free node and its mate
+    void grow(const int h) {
+        const int x = head_[h], y = head_[h ^ 1];
+        relabel(y, -1, root_[x]);
+        tree_[y] = h / 2;
+        if (y >= n_) push(t_blossoms_, {epsilon_ + dual_[y], y, {stamp_[y], 0}});
+        const int z = other(match_[y], y);
+        relabel(z, 1, root_[x]);
+        queue_.push_back(z);
+    }
+
+    // Shrinks the odd cycle closed by the tight edge k between two S-nodes
+    // of a tree into a S-blossom
+    void shrink(const int k) {
+        const int x = head_[2 * k], y = head_[2 * k + 1];
+
+        // the lowest common ancestor, walking up from both ends in turns
+        mark_count_++;
+        int lca = -1;
+        for (int u = x, w = y; lca == -1; std::swap(u, w)) {
+            if (u == -1) continue;
+            if (mark_[u] == mark_count_) {
+                lca = u;
+            } else {
+                mark_[u] = mark_count_;
+                u = tree_parent(u);
+            }
+        }
+
+        int b;
+        if (!unused_blossoms_.empty()) {
+            b = unused_blossoms_.back();
+            unused_blossoms_.pop_back();
+        } else {
+            b = next_blossom_++;
+            blossoms_.emplace_back();
+        }
+        vector<int>& childs = blossom(b).childs;
+        vector<int>& edges = blossom(b).edges;
+        childs.assign(1, lca);
+        edges.clear();
+
+        // lca, down to x, then y and up to lca
+        vector<int> path, path_edges;
+        auto walk_up = [&](int s) {
+            path.clear();
+            path_edges.clear();
+            while (s != lca) {
+                const int t = other(match_[s], s);
+                path.push_back(s);
+                path_edges.push_back(match_[s]);
+                path.push_back(t);
+                path_edges.push_back(tree_[t]);
+                s = other(tree_[t], t);
+            }
+        };
+        walk_up(x);
+        for (int i = path.size() - 1; i >= 0; i--) {
+            edges.push_back(path_edges[i]);
+            childs.push_back(path[i]);
+        }
+        edges.push_back(k);
+        walk_up(y);
+        for (std::size_t i = 0; i < path.size(); i++) {
+            childs.push_back(path[i]);
+            edges.push_back(path_edges[i]);
+        }
+
+        for (const int child : childs) parent_[child] = b;
+        parent_[b] = -1;
+        first_[b] = -1;
+        dual_[b] = 0;
+        label_[b] = 0;
+        since_[b] = epsilon_;
+        match_[b] = match_[lca];
+
+        // the edges leaving the cycle now leave the blossom
+        vector<int> halves;
+        for (const int child : childs) {
+            settle(child);
+            label_[child] = 0;
+            stamp_[child] = ++stamp_count_;
+            list(child, halves);
+            for (const int h : halves) {
+                if (parent_[head_[h ^ 1]] == b) continue;
+                unlink(child, h);
+                push_head(h);
+                link(b, h);
+            }
+        }
+
+        relabel(b, 1, root_[lca]);
+        queue_.push_back(b);
+    }
+
+    // Makes the children of blossom b outer nodes, matched as b was through
+    // half-edge h of its matched edge
+    void dissolve(const int b, const int h) {
+        const vector<int>& childs = blossom(b).childs;
+        const vector<int>& edges = blossom(b).edges;
+
+        vector<int> halves;
+        list(b, halves);
+        first_[b] = -1;
+        for (const int g : halves) {
+            link(pop_head(g), g);
+        }
+
+        for (const int child : childs) {
+            parent_[child] = -1;
+            label_[child] = 0;
+            since_[child] = epsilon_;
+            stamp_[child] = ++stamp_count_;
+        }
+
+        // the child at h is the base, and the others are matched in pairs
+        // around the cycle
+        const int size = childs.size();
+        const int base = std::find(childs.begin(), childs.end(), head_[h]) - childs.begin();
+        match_[childs[base]] = match_[b];
+        for (int i = 1; i < size; i += 2) {
+            const int j = (base + i) % size;
+            match_[childs[j]] = match_[childs[(j + 1) % size]] = edges[j];
+        }
+    }
+
+    // Expands the T-blossom b, whose dual has dropped to zero: the even path
+    // around it from the child its tree edge enters to its base joins the
+    // tree, and the other children are free
+    void expand(const int b) {
+        settle(b);
+        const int entry = half_at(tree_[b], b), matched = half_at(match_[b], b);
+        const int tree_edge = tree_[b], root = root_[b];
+
+        const vector<int> childs = blossom(b).childs;
+        const vector<int> edges = blossom(b).edges;
+        dissolve(b, matched);
+        label_[b] = 0;
+        stamp_[b] = ++stamp_count_;
+        blossom(b).childs.clear();
+        blossom(b).edges.clear();
+        unused_blossoms_.push_back(b);
+
+        const int size = childs.size();
+        const int base = std::find(childs.begin(), childs.end(), head_[matched]) - childs.begin();
+        int j = std::find(childs.begin(), childs.end(), head_[entry]) - childs.begin();
+        const int step = (j - base + size) % size % 2 ? 1 : -1;
+
+        mark_count_++;
+        int edge = tree_edge;
+        for (int i = 0;; i++) {
+            const int child = childs[j];
+            mark_[child] = mark_count_;
+            if (i % 2) {
+                relabel(child, 1, root);
+                queue_.push_back(child);
+            } else {
+                relabel(child, -1, root);
+                tree_[child] = edge;
+                if (child >= n_) push(t_blossoms_, {epsilon_ + dual_[child], child, {stamp_[child], 0}});
+                if (j == base) break;
+            }
+            const int next = (j + step + size) % size;
+            edge = edges[step == 1 ? j : next];
+            j = next;
+        }
+
+        // the edges from S-nodes to the free children are candidates again
+        vector<int> halves;
+        for (const int child : childs) {
+            if (mark_[child] == mark_count_) continue;
+            list(child, halves);
+            for (const int h : halves) {
+                if (label_[head_[h ^ 1]] != 1) continue;
+                push(to_free_, edge_candidate(epsilon_ + std::max(slack(h / 2), 0.0), h ^ 1));
+            }
+        }
+    }
+
+    // Shrinks or augments along the tight edge k between two S-nodes
+    void join(const int k) {
+        if (root_[head_[2 * k]] == root_[head_[2 * k + 1]]) {
+            shrink(k);
+        } else {
+            augment(k);
+        }
+    }
+
+    // Scans the edges of S-node x, growing the trees along the tight ones
+    // and keeping the others as candidates
+    void scan(const int x) {
+        const int f = first_[x];
+        if (f == -1) return;
+        int h = f;
+        do {
+            const int next = next_[h];
+            const int y = head_[h ^ 1];
+            const double s = slack(h / 2);
+            if (label_[y] == 1) {
+                if (s <= 0) {
+                    // x is now inside a blossom, which will be scanned, or
+                    // free
+                    join(h / 2);
+                    return;
+                }
+                push(between_s_, edge_candidate(epsilon_ + s / 2, h));
+            } else if (label_[y] == 0) {
+                if (s <= 0) {
+                    grow(h);
+                } else {
+                    push(to_free_, edge_candidate(epsilon_ + s, h));
+                }
+            }
+            h = next;
+        } while (h != f);
+    }
+
+    // Drops the candidates at the top of each heap that are no longer valid
+    void drop_invalid_candidates() {
+        while (!to_free_.empty() && !is_current(to_free_.front())) pop(to_free_);
+        while (!between_s_.empty() && !is_current(between_s_.front())) pop(between_s_);
+        while (!t_blossoms_.empty() &&
+                stamp_[t_blossoms_.front().index] != t_blossoms_.front().stamps[0]) {
+            pop(t_blossoms_);
+        }
+    }
+};
+
+}  // anonymous namespace
+
+
+std::vector<int> max_weight_perfect_matching(
+    const int num_vertices,
+    const std::vector<int>& edge_starts,
+    const std::vector<int>& edge_ends,
+    const std::vector<double>& edge_weights
+) {
+    BlossomMatching matching(num_vertices, edge_starts, edge_ends, edge_weights);
+    return matching.solve();
+}
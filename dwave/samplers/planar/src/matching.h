@@ -0,0 +1,46 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _matching_h
+#define _matching_h
+
+#include <vector>
+
+// Find a maximum weight perfect matching of a graph, with Edmonds' primal-dual
+// blossom algorithm.
+//
+// The dual variables are jump-started so that most vertices are matched
+// greedily along tight edges, and the alternating trees of the remaining free
+// vertices are then grown together, as in Blossom V. The dual updates are
+// lazy and the tight edges are found with heaps, so on sparse graphs (eg. the
+// expanded duals of planar graphs) a change of the tree or of a blossom costs
+// about the size of its boundary rather than that of the graph.
+//
+// @param num_vertices the number of vertices of the graph
+// @param edge_starts the first vertex of each edge
+// @param edge_ends the second vertex of each edge
+// @param edge_weights the weight of each edge
+//
+// @return the index of the matched edge of each vertex
+//
+// @throws std::invalid_argument if an edge has an invalid vertex
+// @throws std::runtime_error if the graph has no perfect matching
+std::vector<int> max_weight_perfect_matching(
+    const int num_vertices,
+    const std::vector<int>& edge_starts,
+    const std::vector<int>& edge_ends,
+    const std::vector<double>& edge_weights
+);
+
+#endif
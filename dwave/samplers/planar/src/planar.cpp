@@ -0,0 +1,255 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "matching.h"
+#include "planar.h"
+
+using std::vector;
+
+RotationSystem::RotationSystem(
+    const int num_nodes,
+    const vector<int>& edge_starts,
+    const vector<int>& edge_ends,
+    const vector<double>& x,
+    const vector<double>& y
+) {
+    if (num_nodes < 0) throw std::invalid_argument("num_nodes must be non-negative");
+    if (edge_starts.size() != edge_ends.size()) {
+        throw std::invalid_argument("edge vectors have mismatched lengths");
+    }
+    if ((int)x.size() != num_nodes || (int)y.size() != num_nodes) {
+        throw std::invalid_argument("there must be a position for each node");
+    }
+
+    const int num_half_edges = 2 * edge_starts.size();
+    origin_.resize(num_half_edges);
+    for (std::size_t k = 0; k < edge_starts.size(); k++) {
+        origin_[2 * k] = edge_starts[k];
+        origin_[2 * k + 1] = edge_ends[k];
+        if (edge_starts[k] < 0 || edge_starts[k] >= num_nodes ||
+                edge_ends[k] < 0 || edge_ends[k] >= num_nodes) {
+            throw std::invalid_argument("edges contain an invalid node");
+        }
+        if (edge_starts[k] == edge_ends[k]) {
+            throw std::invalid_argument("edges contain a self-loop");
+        }
+    }
+
+    // the half-edges leaving each node, in the order of their angle
+    vector<double> angle(num_half_edges);
+    for (int h = 0; h < num_half_edges; h++) {
+        const int u = origin_[h], v = origin_[h ^ 1];
+        angle[h] = std::atan2(y[v] - y[u], x[v] - x[u]);
+    }
+    vector<int> order(num_half_edges);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const int a, const int b) {
+        return origin_[a] < origin_[b] || (origin_[a] == origin_[b] && angle[a] < angle[b]);
+    });
+
+    next_.resize(num_half_edges);
+    prev_.resize(num_half_edges);
+    first_.assign(num_nodes, -1);
+    for (int i = 0; i < num_half_edges;) {
+        const int u = origin_[order[i]];
+        int end = i;
+        while (end < num_half_edges && origin_[order[end]] == u) end++;
+        first_[u] = order[i];
+        for (int j = i; j < end; j++) {
+            const int h = order[j];
+            const int g = order[j + 1 < end ? j + 1 : i];
+            next_[h] = g;
+            prev_[g] = h;
+        }
+        i = end;
+    }
+}
+
+void RotationSystem::insert_chord(const int ij, const int jk) {
+    const int i = origin(ij), k = target(jk);
+    const int ik = origin_.size(), ki = ik + 1;
+    origin_.push_back(i);
+    origin_.push_back(k);
+    next_.resize(ki + 1);
+    prev_.resize(ki + 1);
+
+    // ki follows kj around k
+    const int kj = jk ^ 1;
+    next_[ki] = next_[kj];
+    prev_[next_[kj]] = ki;
+    next_[kj] = ki;
+    prev_[ki] = kj;
+
+    // and ik precedes ij around i
+    const int before = prev_[ij];
+    next_[before] = ik;
+    prev_[ik] = before;
+    next_[ik] = ij;
+    prev_[ij] = ik;
+}
+
+void RotationSystem::triangulate() {
+    if (num_nodes() < 3) throw std::invalid_argument("only defined for graphs with 3 or more nodes");
+
+    vector<int> out;
+    for (int n = 0; n < num_nodes(); n++) {
+        if (first_[n] == -1) continue;
+
+        // the half-edges leaving n before any chords are added at n
+        out.clear();
+        int h = first_[n];
+        do {
+            out.push_back(h);
+            h = next_[h];
+        } while (h != first_[n]);
+
+        // walk the face after each half-edge, adding chords from its first
+        // node until it is a triangle
+        for (const int start : out) {
+            int ij = start;
+            int jk = next(ij ^ 1);
+            int kl = next(jk ^ 1);
+
+            // every chord shortens the face, so a face of the embedding can
+            // take no more steps than there are half-edges
+            std::size_t steps = 0;
+            while (target(kl) != origin(ij)) {
+                if (++steps > origin_.size()) {
+                    throw std::runtime_error("the positions do not give a plane embedding");
+                }
+                const int mn = next(kl ^ 1);
+                if (target(mn) == target(ij)) break;
+
+                if (origin(ij) == target(jk)) {
+                    // avoid a self-loop
+                    ij = jk;
+                    jk = kl;
+                    kl = next(jk ^ 1);
+                }
+
+                insert_chord(ij, jk);
+
+                ij = kl;
+                jk = next(ij ^ 1);
+                kl = next(jk ^ 1);
+            }
+        }
+    }
+
+    if (!is_triangulated()) throw std::runtime_error("the positions do not give a plane embedding");
+}
+
+bool RotationSystem::is_triangulated() const {
+    for (std::size_t h = 0; h < origin_.size(); h++) {
+        const int a = next(h ^ 1);
+        const int b = next(a ^ 1);
+        if (next(b ^ 1) != (int)h || origin(a) == origin(h) || origin(b) == origin(h)) return false;
+    }
+    return true;
+}
+
+void expanded_dual(
+    const RotationSystem& graph,
+    const vector<double>& weights,
+    vector<int>& dual_starts,
+    vector<int>& dual_ends,
+    vector<double>& dual_weights
+) {
+    const int num_half_edges = 2 * graph.num_edges();
+    dual_starts.clear();
+    dual_ends.clear();
+    dual_weights.clear();
+    dual_starts.reserve(num_half_edges / 2 + num_half_edges);
+    dual_ends.reserve(num_half_edges / 2 + num_half_edges);
+    dual_weights.reserve(num_half_edges / 2 + num_half_edges);
+
+    // the edges crossing the edges of the graph, from the right-hand side of
+    // each edge to its left-hand side
+    for (int k = 0; k < graph.num_edges(); k++) {
+        dual_starts.push_back(2 * k);
+        dual_ends.push_back(2 * k + 1);
+        dual_weights.push_back(k < (int)weights.size() ? weights[k] : 0);
+    }
+
+    // and the edges within each triangular face
+    for (int h = 0; h < num_half_edges; h++) {
+        dual_starts.push_back(h);
+        dual_ends.push_back(graph.next(h) ^ 1);
+        dual_weights.push_back(0);
+    }
+}
+
+void planar_ground_state(
+    std::int8_t* state,
+    const int num_nodes,
+    const vector<int>& edge_starts,
+    const vector<int>& edge_ends,
+    const vector<double>& edge_weights,
+    const vector<double>& x,
+    const vector<double>& y
+) {
+    if (edge_weights.size() != edge_starts.size()) {
+        throw std::invalid_argument("edge vectors have mismatched lengths");
+    }
+
+    RotationSystem graph(num_nodes, edge_starts, edge_ends, x, y);
+    graph.triangulate();
+
+    vector<int> dual_starts, dual_ends;
+    vector<double> dual_weights;
+    expanded_dual(graph, edge_weights, dual_starts, dual_ends, dual_weights);
+    const vector<int> matched = max_weight_perfect_matching(
+        2 * graph.num_edges(), dual_starts, dual_ends, dual_weights);
+
+    // an edge is cut unless its two half-edges are matched together
+    const int num_edges = graph.num_edges();
+    vector<char> cut(num_edges);
+    for (int k = 0; k < num_edges; k++) cut[k] = matched[2 * k] != k;
+
+    // the nodes adjacent to each node, through each half-edge
+    vector<int> start(num_nodes + 1, 0);
+    for (int h = 0; h < 2 * num_edges; h++) start[graph.origin(h) + 1]++;
+    std::partial_sum(start.begin(), start.end(), start.begin());
+    vector<int> half_edges(2 * num_edges);
+    vector<int> fill(start.begin(), start.end() - 1);
+    for (int h = 0; h < 2 * num_edges; h++) half_edges[fill[graph.origin(h)]++] = h;
+
+    vector<char> seen(num_nodes, 0);
+    vector<int> stack;
+    for (int root = 0; root < num_nodes; root++) {
+        if (seen[root]) continue;
+        seen[root] = 1;
+        state[root] = 0;
+        stack.assign(1, root);
+        while (!stack.empty()) {
+            const int u = stack.back();
+            stack.pop_back();
+            for (int i = start[u]; i < start[u + 1]; i++) {
+                const int h = half_edges[i];
+                const int v = graph.target(h);
+                if (seen[v]) continue;
+                seen[v] = 1;
+                state[v] = state[u] ^ cut[h / 2];
+                stack.push_back(v);
+            }
+        }
+    }
+}
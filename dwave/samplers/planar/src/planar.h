@@ -0,0 +1,128 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// ===========================================================================
+//
+// The native counterpart of `planar.py`: the ground state of a planar Ising
+// problem without fields is read from a maximum weight perfect matching of
+// the expanded dual of a plane triangulation of its graph.
+//
+// The embedded graph is a rotation system over half-edges: edge k has the
+// half-edges 2k, from its first node, and 2k + 1, from its second, so the
+// twin of half-edge h is h ^ 1, and `next(h)` is the half-edge following h
+// counterclockwise around its origin.
+
+#ifndef _planar_h
+#define _planar_h
+
+#include <cstdint>
+#include <vector>
+
+class RotationSystem {
+  public:
+    // The rotation system given by the positions of the nodes, each edge
+    // leaving its nodes at the angle of the line to its other node.
+    //
+    // @param num_nodes the number of nodes
+    // @param edge_starts the first node of each edge
+    // @param edge_ends the second node of each edge
+    // @param x the x-coordinate of each node
+    // @param y the y-coordinate of each node
+    RotationSystem(
+        const int num_nodes,
+        const std::vector<int>& edge_starts,
+        const std::vector<int>& edge_ends,
+        const std::vector<double>& x,
+        const std::vector<double>& y
+    );
+
+    int num_nodes() const { return first_.size(); }
+    int num_edges() const { return origin_.size() / 2; }
+
+    int origin(const int h) const { return origin_[h]; }
+    int target(const int h) const { return origin_[h ^ 1]; }
+    int next(const int h) const { return next_[h]; }
+
+    // Adds edges, with a weight of zero, until the graph is plane
+    // triangulated: biconnected, with triangular faces. This follows
+    // `planar.plane_triangulate`.
+    //
+    // @throws std::invalid_argument if the graph has fewer than three nodes
+    // @throws std::runtime_error if the embedding is not plane, eg. the
+    //         positions of a planar graph cross some of its edges
+    void triangulate();
+
+    // Whether each face is a triangle
+    bool is_triangulated() const;
+
+  private:
+    std::vector<int> origin_;
+    std::vector<int> next_;
+    std::vector<int> prev_;
+    // a half-edge at each node, or -1
+    std::vector<int> first_;
+
+    // Adds an edge between origin(ij) and target(jk), into the face of the
+    // consecutive half-edges ij and jk.
+    void insert_chord(const int ij, const int jk);
+};
+
+// The expanded dual of a plane triangulated graph, whose vertices are the
+// half-edges: each edge k joins its half-edges 2k and 2k + 1 with weight
+// `weights[k]` (zero for the edges added by the triangulation), and each
+// half-edge h is joined to the twin of next(h) with weight zero.
+//
+// @param graph a plane triangulated rotation system
+// @param weights the weight of each edge of the graph before it was
+//        triangulated
+// @param dual_starts, dual_ends, dual_weights the edges of the dual; the
+//        first `graph.num_edges()` of them are those crossing the edges of
+//        the graph
+void expanded_dual(
+    const RotationSystem& graph,
+    const std::vector<double>& weights,
+    std::vector<int>& dual_starts,
+    std::vector<int>& dual_ends,
+    std::vector<double>& dual_weights
+);
+
+// Find a ground state of a planar Ising problem without fields.
+//
+// The edges of the graph whose half-edges are matched in a maximum weight
+// perfect matching of the expanded dual are uncut, and the others cut, so
+// the state is then found by a traversal of the graph from node 0.
+//
+// @param state the BINARY value of each node, with node 0 set to 0
+// @param num_nodes the number of nodes, each of which has an edge
+// @param edge_starts the first node of each edge
+// @param edge_ends the second node of each edge
+// @param edge_weights the weight of each edge, -2 times its coupling in the
+//        SPIN domain, as given by `util.bqm_to_multigraph`
+// @param x the x-coordinate of each node
+// @param y the y-coordinate of each node
+//
+// @throws std::invalid_argument if the arguments have mismatched lengths or
+//         the graph has fewer than three nodes
+// @throws std::runtime_error if the positions do not give a plane embedding
+void planar_ground_state(
+    std::int8_t* state,
+    const int num_nodes,
+    const std::vector<int>& edge_starts,
+    const std::vector<int>& edge_ends,
+    const std::vector<double>& edge_weights,
+    const std::vector<double>& x,
+    const std::vector<double>& y
+);
+
+#endif
@@ -1,4 +1,6 @@
 # distutils: language = c++
+# distutils: include_dirs = dwave/samplers/random/src/ dwave/samplers/common/src/
+# distutils: sources = dwave/samplers/random/src/random_sampler.cpp
 # cython: language_level = 3
 
 # Copyright 2022 D-Wave Systems Inc.
@@ -17,56 +19,46 @@
 
 cimport cython
 
-from cpython.pycapsule cimport PyCapsule_IsValid, PyCapsule_GetPointer
-from libcpp.algorithm cimport make_heap, push_heap, pop_heap
-from libcpp.utility cimport pair
-from libcpp.vector cimport vector
+from cython.operator cimport dereference as deref
+from libc.stddef cimport ptrdiff_t
+from libc.stdint cimport int64_t, uint64_t
 
 import dimod
 cimport dimod
+from dimod.cyqmbase.cyqmbase_float64 cimport bias_type, index_type
+from dimod.libcpp.binary_quadratic_model cimport BinaryQuadraticModel as cppBinaryQuadraticModel
 import numpy as np
 cimport numpy as np
-cimport numpy.random
 
-# chrono is not included in Cython's libcpp. So we do it more manually
-cdef extern from *:
-    """
-    #include <chrono>
-
-    double realtime_clock() {
-        auto t = std::chrono::high_resolution_clock::now();
-        return std::chrono::duration<double>(t.time_since_epoch()).count();
-    }
-    """
-    double realtime_clock()
-
-
-# it would be nicer to use a struct, but OSX throws segfaults when sorting
-# Cython-created structs. We should retest that when we switch to Cython 3.
-ctypedef pair[np.float64_t, vector[np.int8_t]] state_t
-
-
-cdef state_t get_sample(dimod.cyBQM_float64 cybqm,
-                        numpy.random.bitgen_t* bitgen,
-                        bint is_spin = False,
-                        ):
-    # developer note: there is a bunch of potential optimization here
-    cdef state_t state
-
-    # generate the sample
-    state.second.reserve(cybqm.num_variables())
-    cdef Py_ssize_t i
-    for i in range(cybqm.num_variables()):
-        state.second.push_back(bitgen.next_uint32(bitgen.state) % 2)
-
-    if is_spin:
-        # go back through and convert to spin
-        for i in range(state.second.size()):
-            state.second[i] = 2 * state.second[i] - 1
-
-    state.first = cybqm.data().energy(state.second.begin())
-
-    return state
+from dwave.samplers.common.pool cimport set_worker_pool, shared_worker_pool
+
+# run the parallel loops of the kernels on the workers shared by all samplers
+set_worker_pool(shared_worker_pool())
+
+cdef extern from "random_sampler.h":
+    int64_t random_sample_packed(
+        np.uint8_t* packed_states,
+        double* energies,
+        int64_t* num_kept,
+        const cppBinaryQuadraticModel[bias_type, index_type]& bqm,
+        bint is_spin,
+        int64_t num_reads,
+        double time_limit,
+        int64_t max_num_samples,
+        uint64_t seed,
+        int num_threads
+    ) nogil except +
+
+    size_t packed_row_bytes(int num_vars) nogil
+
+    void unpack_states(
+        const np.uint8_t* packed,
+        int64_t num_states,
+        int num_vars,
+        bint is_spin,
+        np.int8_t* states,
+        ptrdiff_t stride
+    ) nogil
 
 
 @cython.boundscheck(False)
@@ -75,9 +67,8 @@ def sample(object bqm,
            Py_ssize_t num_reads,
            np.float64_t time_limit,
            Py_ssize_t max_num_samples,
-           object seed):
-
-    cdef Py_ssize_t i, j  # counters for use later
+           object seed,
+           int num_threads = 1):
 
     # Get Cython access to the BQM. We could template to avoid the copy,
     # but honestly everyone just uses float64 anyway so...
@@ -90,73 +81,49 @@ def sample(object bqm,
         raise ValueError("time_limit must be positive")
     if max_num_samples <= 0:
         raise ValueError("max_num_samples must be positive")
+    if num_threads <= 0:
+        raise ValueError("num_threads must be positive")
 
-    # Get Cython access to the rng
+    # the samples are drawn from streams derived from a single seed, so that
+    # they do not depend on the number of threads
     rng = np.random.default_rng(seed)
-    cdef numpy.random.bitgen_t *bitgen
-    cdef const char *capsule_name = "BitGenerator"
-    capsule = rng.bit_generator.capsule
-    if not PyCapsule_IsValid(capsule, capsule_name):
-        raise ValueError("Invalid pointer to anon_func_state")
-    bitgen = <numpy.random.bitgen_t *> PyCapsule_GetPointer(capsule, capsule_name)
-
-    # ok, time to start sampling!
-    cdef double sampling_start_time = realtime_clock()
-    cdef double sampling_stop_time = sampling_start_time + time_limit
-
-    # fill out the population
-    cdef vector[state_t] samples
-    for i in range(max_num_samples):
-        samples.push_back(get_sample(cybqm, bitgen, is_spin))
-
-        if samples.size() >= num_reads:
-            break
-        if realtime_clock() >= sampling_stop_time:
-            break
-
-    cdef Py_ssize_t num_drawn = samples.size()
-
-    # determine if we need to keep going
-    if samples.size() < num_reads and realtime_clock() < sampling_stop_time:
-        # at this point, we want to stop growing our samples vector, so
-        # we turn it into a heap
-        make_heap(samples.begin(), samples.end())
-
-        # we're never going to change size, so we stop testing the num_reads
-        # condition. It was up to the caller to ensure that max_num_samples >= num_reads
-        # if they want to terminate on num_reads
-        while realtime_clock() < sampling_stop_time:
-            samples.push_back(get_sample(cybqm, bitgen, is_spin))
-            push_heap(samples.begin(), samples.end())
-            pop_heap(samples.begin(), samples.end())
-            samples.pop_back()
-
-            num_drawn += 1
-
-    # sampling done!
-    # time to construct the return objects
+    cdef uint64_t _seed = rng.integers(2**64, dtype=np.uint64)
+
+    # the kernel keeps the samples bit-packed, and they are unpacked straight
+    # into the record, so that no int8 copy of them is made in between
+    cdef Py_ssize_t capacity = min(num_reads, max_num_samples)
+    cdef int num_vars = bqm.num_variables
+    packed_numpy = np.empty((capacity, packed_row_bytes(num_vars)), dtype=np.uint8)
+    energies_numpy = np.empty(capacity, dtype=np.float64)
+
+    # explicitly convert all Python types to C while we have the GIL
+    cdef np.uint8_t* _packed = <np.uint8_t*> np.PyArray_DATA(packed_numpy)
+    cdef double* _energies = <double*> np.PyArray_DATA(energies_numpy)
+    cdef int64_t _num_kept = 0
+    cdef int64_t _num_drawn
+
+    with nogil:
+        _num_drawn = random_sample_packed(
+            _packed, _energies, &_num_kept, deref(cybqm.data()), is_spin,
+            num_reads, time_limit, max_num_samples, _seed, num_threads)
 
     record = np.rec.array(
-        np.empty(samples.size(),
-                 dtype=[('sample', np.int8, (bqm.num_variables,)),
+        np.empty(_num_kept,
+                 dtype=[('sample', np.int8, (num_vars,)),
                         ('energy', float),
                         ('num_occurrences', int)]))
 
-    record['num_occurrences'][:] = 1
-
-    cdef np.float64_t[:] energies_view = record['energy']
-    for i in range(samples.size()):
-        energies_view[i] = samples[i].first
-
     cdef np.int8_t[:, :] sample_view = record['sample']
-    for i in range(samples.size()):
-        for j in range(cybqm.num_variables()):
-            sample_view[i, j] = samples[i].second[j]
+    if _num_kept and num_vars:
+        unpack_states(_packed, _num_kept, num_vars, is_spin,
+                      &sample_view[0, 0], sample_view.strides[0])
+    record['energy'] = energies_numpy[:_num_kept]
+    record['num_occurrences'][:] = 1
 
     sampleset = dimod.SampleSet(record, bqm.variables, info=dict(), vartype=bqm.vartype)
 
     sampleset.info.update(
-        num_reads=num_drawn,
+        num_reads=_num_drawn,
         # todo: timing data
         )
 
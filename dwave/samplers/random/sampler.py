@@ -13,6 +13,7 @@
 #    limitations under the License.
 
 import datetime
+import numbers
 import sys
 import typing
 
@@ -53,6 +54,7 @@ class RandomSampler(dimod.Sampler):
         time_limit=[],
         max_num_samples=[],
         seed=[],
+        num_threads=[],
         )
     """Keyword arguments accepted by the sampling methods.
 
@@ -61,7 +63,7 @@ class RandomSampler(dimod.Sampler):
         >>> from dwave.samplers import RandomSampler
         >>> sampler = RandomSampler()
         >>> sampler.parameters
-        {'num_reads': [], 'time_limit': [], 'max_num_samples': [], 'seed': []}
+        {'num_reads': [], 'time_limit': [], 'max_num_samples': [], 'seed': [], 'num_threads': []}
 
     """
 
@@ -85,6 +87,7 @@ class RandomSampler(dimod.Sampler):
                time_limit: typing.Optional[typing.Union[float, datetime.timedelta]] = None,
                max_num_samples: int = 1000,
                seed: typing.Union[None, int, np.random.Generator] = None,
+               num_threads: int = 1,
                **kwargs,
                ) -> dimod.SampleSet:
         """Return random samples for a binary quadratic model.
@@ -114,6 +117,11 @@ class RandomSampler(dimod.Sampler):
                 Seed for the random number generator.
                 Passed to :func:`numpy.random.default_rng()`.
 
+            num_threads:
+                Number of threads to draw the samples on. When all
+                ``num_reads`` samples are drawn, the results do not depend on
+                ``num_threads``.
+
         Returns:
             A sample set.
             Some additional information is provided in the
@@ -152,9 +160,15 @@ class RandomSampler(dimod.Sampler):
         if max_num_samples <= 0:
             raise ValueError("max_num_samples must be a positive integer")
 
+        if not isinstance(num_threads, numbers.Integral):
+            raise TypeError("num_threads must be a positive integer")
+        if num_threads < 1:
+            raise ValueError("num_threads must be a positive integer")
+
         return sample(bqm,
                       num_reads=num_reads,
                       time_limit=time_limit,
                       max_num_samples=max_num_samples,
                       seed=seed,
+                      num_threads=num_threads,
                       )
@@ -0,0 +1,349 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "deadline.h"
+#include "pool.h"
+#include "random_sampler.h"
+#include "rng.h"
+
+using std::int64_t;
+using std::uint64_t;
+using std::vector;
+
+namespace {
+
+const int B = RANDOM_SAMPLE_BLOCK_SIZE;
+
+// Unpacks the word of each variable into its value in each of the B samples
+// of a block, `values[v * B + s]` being the value of `v` in sample `s`
+void unpack_block(const uint64_t* words, int num_vars, bool is_spin, std::int8_t* values) {
+    const std::int8_t low = is_spin ? -1 : 0;
+    const std::int8_t scale = is_spin ? 2 : 1;
+    for (int v = 0; v < num_vars; v++) {
+        const uint64_t word = words[v];
+        std::int8_t* row = values + (std::size_t)v * B;
+        for (int s = 0; s < B; s++) row[s] = low + scale * (std::int8_t)((word >> s) & 1);
+    }
+}
+
+// Computes the energies of the B samples of a block from their values. The
+// samples are laid out side by side, so that the inner loops run over
+// contiguous arrays and vectorize.
+void block_energies(
+    const IsingGraph& graph,
+    const double offset,
+    const std::int8_t* values,
+    double* energies
+) {
+    const Adjacency& adj = graph.adjacency;
+    double field[B];
+
+    for (int s = 0; s < B; s++) energies[s] = offset;
+
+    for (int v = 0; v < graph.num_variables(); v++) {
+        for (int s = 0; s < B; s++) field[s] = graph.linear[v];
+
+        // each coupler is counted from its larger variable
+        for (auto it = adj.begin(v); it != adj.end(v); ++it) {
+            if (it->var >= v) continue;
+            const std::int8_t* row = values + (std::size_t)it->var * B;
+            const double weight = it->weight;
+            for (int s = 0; s < B; s++) field[s] += weight * row[s];
+        }
+
+        const std::int8_t* row = values + (std::size_t)v * B;
+        for (int s = 0; s < B; s++) energies[s] += row[s] * field[s];
+    }
+}
+
+#ifdef DWAVE_SAMPLERS_VERIFY_ENERGY
+// The energy of a single state, to verify those of the blocks
+double state_energy(
+    const std::int8_t* state,
+    const IsingGraph& graph,
+    const double offset
+) {
+    double energy = offset;
+    for (int v = 0; v < graph.num_variables(); v++) {
+        double field = graph.linear[v];
+        for (auto it = graph.adjacency.begin(v); it != graph.adjacency.end(v); ++it) {
+            if (it->var < v) field += it->weight * state[it->var];
+        }
+        energy += state[v] * field;
+    }
+    return energy;
+}
+#endif
+
+// A sample kept, stored in row `slot` of the states buffer
+struct Kept {
+    double energy;
+    int64_t index;
+    int64_t slot;
+};
+
+// Orders samples by energy, then by the order they were drawn in
+inline bool kept_less(const Kept& a, const Kept& b) {
+    return a.energy < b.energy || (a.energy == b.energy && a.index < b.index);
+}
+
+// Draws the samples of `random_sample`, storing each sample kept as a row of
+// `rows`, unpacked or packed (see `packed_states.h`)
+int64_t sample_rows(
+    std::uint8_t* rows,
+    const bool packed,
+    int64_t* num_kept,
+    double* energies,
+    const IsingGraph& graph,
+    double offset,
+    bool is_spin,
+    int64_t num_reads,
+    double time_limit,
+    int64_t max_num_samples,
+    uint64_t seed,
+    int num_threads
+) {
+    if (num_reads <= 0) throw std::invalid_argument("num_reads must be positive");
+    if (max_num_samples <= 0) throw std::invalid_argument("max_num_samples must be positive");
+    if (!(time_limit > 0)) throw std::invalid_argument("time_limit must be positive");
+
+    const int num_vars = graph.num_variables();
+    const std::size_t row_bytes = packed ? packed_row_bytes(num_vars) : num_vars;
+    const int64_t capacity = std::min(num_reads, max_num_samples);
+    const int64_t num_blocks = (num_reads - 1) / B + 1;
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool timed = std::isfinite(time_limit);
+    const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(timed ? time_limit : 0));
+
+    // the samples kept, in a max-heap, and the energy of its top once it is
+    // full, which most blocks can be rejected against without taking the lock
+    vector<Kept> heap;
+    heap.reserve(capacity);
+    std::atomic<double> threshold(std::numeric_limits<double>::infinity());
+
+    std::atomic<int64_t> next_block(0);
+    std::atomic<int64_t> num_drawn(0);
+    std::atomic<bool> stop(false);
+    std::mutex lock;
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+        vector<uint64_t> words(num_vars);
+        vector<std::int8_t> values((std::size_t)num_vars * B);
+        double block[B];
+        uint64_t rng_state[2];
+        // each thread checks its own copy of the deadline
+        Deadline block_deadline(deadline);
+
+        while (!stop) {
+            const int64_t b = next_block++;
+            if (b >= num_blocks) break;
+
+            try {
+                const int64_t first = b * B;
+                const int count = (int)std::min<int64_t>(B, num_reads - first);
+
+                // each block gets its own stream, so that a sample does not
+                // depend on which thread drew it
+                seed_stream(rng_state, seed, b);
+                for (int v = 0; v < num_vars; v++) words[v] = xorshift128p(rng_state);
+                unpack_block(words.data(), num_vars, is_spin, values.data());
+                block_energies(graph, offset, values.data(), block);
+                num_drawn += count;
+
+                // ties are broken by index under the lock
+                const double t = threshold;
+                bool any = false;
+                for (int s = 0; s < count; s++) any |= block[s] <= t;
+
+                if (any) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    for (int s = 0; s < count; s++) {
+                        Kept sample = {block[s], first + s, (int64_t)heap.size()};
+                        if ((int64_t)heap.size() < capacity) {
+                            heap.push_back(sample);
+                        } else if (kept_less(sample, heap.front())) {
+                            sample.slot = heap.front().slot;
+                            std::pop_heap(heap.begin(), heap.end(), kept_less);
+                            heap.back() = sample;
+                        } else {
+                            continue;
+                        }
+                        std::push_heap(heap.begin(), heap.end(), kept_less);
+
+                        std::uint8_t* row = rows + sample.slot * row_bytes;
+                        if (packed) {
+                            for (std::size_t byte = 0; byte < row_bytes; byte++) row[byte] = 0;
+                            for (int v = 0; v < num_vars; v++) {
+                                row[v >> 3] |= ((words[v] >> s) & 1) << (7 - (v & 7));
+                            }
+                        } else {
+                            for (int v = 0; v < num_vars; v++) {
+                                row[v] = (std::uint8_t)values[(std::size_t)v * B + s];
+                            }
+                        }
+                        if ((int64_t)heap.size() == capacity) threshold = heap.front().energy;
+                    }
+                }
+
+                if (timed && block_deadline.expired()) stop = true;
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) error = std::current_exception();
+                stop = true;
+            }
+        }
+    };
+
+    num_threads = (int)std::min<int64_t>(std::max(num_threads, 1), num_blocks);
+    run_parallel(num_threads, worker);
+
+    if (error) std::rethrow_exception(error);
+
+    // put the samples kept in the order they were drawn, moving the rows
+    // along the cycles of the permutation
+    std::sort(heap.begin(), heap.end(),
+              [](const Kept& a, const Kept& b) { return a.index < b.index; });
+
+    const int64_t kept = heap.size();
+    vector<int64_t> source(kept);
+    for (int64_t i = 0; i < kept; i++) {
+        source[i] = heap[i].slot;
+        energies[i] = heap[i].energy;
+    }
+
+    vector<std::uint8_t> row(row_bytes);
+    for (int64_t i = 0; i < kept; i++) {
+        if (source[i] < 0 || source[i] == i) continue;
+        std::copy(rows + i * row_bytes, rows + (i + 1) * row_bytes, row.begin());
+        int64_t j = i;
+        while (source[j] != i) {
+            const int64_t k = source[j];
+            std::copy(rows + k * row_bytes, rows + (k + 1) * row_bytes, rows + j * row_bytes);
+            source[j] = -1;
+            j = k;
+        }
+        std::copy(row.begin(), row.end(), rows + j * row_bytes);
+        source[j] = -1;
+    }
+
+#ifdef DWAVE_SAMPLERS_VERIFY_ENERGY
+    vector<std::int8_t> state(num_vars);
+    for (int64_t i = 0; i < kept; i++) {
+        if (packed) {
+            unpack_state(rows + i * row_bytes, num_vars, is_spin, state.data());
+        } else {
+            std::copy(rows + i * row_bytes, rows + (i + 1) * row_bytes, (std::uint8_t*)state.data());
+        }
+        VERIFY_ENERGY(energies[i], state_energy(state.data(), graph, offset));
+    }
+#endif
+
+    *num_kept = kept;
+    return num_drawn;
+}
+
+}  // anonymous namespace
+
+
+// Draw uniformly random samples of a problem, keeping the lowest energy ones.
+//
+// The samples are drawn in blocks of `RANDOM_SAMPLE_BLOCK_SIZE`, each from its
+// own random stream, and the blocks are distributed over the threads. The
+// energies of a block are computed together, and its samples are compared
+// with a bounded max-heap of those kept, so only the samples that make it
+// into the heap are ever written out.
+//
+// @param states a buffer of `min(num_reads, max_num_samples) * num_vars`
+//        int8, the first `*num_kept` rows of which are filled with the
+//        samples kept, in the order they were drawn
+// @param energies a buffer of `min(num_reads, max_num_samples)` doubles
+//        holding the energies of the samples kept
+// @param num_kept the number of samples kept
+// @param graph the linear biases and adjacency of the problem
+// @param offset the energy offset of the problem
+// @param is_spin whether the variables are SPIN valued (-1, +1), rather than
+//        BINARY valued (0, 1)
+// @param num_reads the number of samples to draw
+// @param time_limit the time, in seconds, after which no more blocks are
+//        started; can be infinite
+// @param max_num_samples the greatest number of samples kept
+// @param seed the seed of the random streams
+// @param num_threads the number of threads to draw samples on. When all
+//        `num_reads` samples are drawn, the results do not depend on the
+//        number of threads.
+//
+// @return the number of samples drawn
+int64_t random_sample(
+    std::int8_t* states,
+    double* energies,
+    int64_t* num_kept,
+    const IsingGraph& graph,
+    double offset,
+    bool is_spin,
+    int64_t num_reads,
+    double time_limit,
+    int64_t max_num_samples,
+    uint64_t seed,
+    int num_threads
+) {
+    return sample_rows(
+        reinterpret_cast<std::uint8_t*>(states), false, num_kept, energies, graph, offset,
+        is_spin, num_reads, time_limit, max_num_samples, seed, num_threads
+    );
+}
+
+
+// Draw uniformly random samples of a problem, keeping the lowest energy ones
+// bit-packed, see `packed_states.h`.
+//
+// @param packed_states a buffer of `min(num_reads, max_num_samples) *
+//        packed_row_bytes(num_vars)` bytes, the first `*num_kept` rows of
+//        which are filled with the samples kept, in the order they were drawn
+// @param energies, num_kept, graph, offset, is_spin, num_reads, time_limit,
+//        max_num_samples, seed, num_threads see `random_sample`
+//
+// @return the number of samples drawn
+int64_t random_sample_packed(
+    std::uint8_t* packed_states,
+    double* energies,
+    int64_t* num_kept,
+    const IsingGraph& graph,
+    double offset,
+    bool is_spin,
+    int64_t num_reads,
+    double time_limit,
+    int64_t max_num_samples,
+    uint64_t seed,
+    int num_threads
+) {
+    return sample_rows(
+        packed_states, true, num_kept, energies, graph, offset,
+        is_spin, num_reads, time_limit, max_num_samples, seed, num_threads
+    );
+}
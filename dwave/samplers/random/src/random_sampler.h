@@ -0,0 +1,99 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _RANDOM_SAMPLER_H
+#define _RANDOM_SAMPLER_H
+
+#include <cstdint>
+
+#include "graph.h"
+#include "packed_states.h"
+
+// The samples are drawn in blocks of this many, one random word giving the
+// value of a variable in every sample of a block
+const int RANDOM_SAMPLE_BLOCK_SIZE = 64;
+
+std::int64_t random_sample(
+    std::int8_t* states,
+    double* energies,
+    std::int64_t* num_kept,
+    const IsingGraph& graph,
+    double offset,
+    bool is_spin,
+    std::int64_t num_reads,
+    double time_limit,
+    std::int64_t max_num_samples,
+    std::uint64_t seed,
+    int num_threads=1
+);
+
+std::int64_t random_sample_packed(
+    std::uint8_t* packed_states,
+    double* energies,
+    std::int64_t* num_kept,
+    const IsingGraph& graph,
+    double offset,
+    bool is_spin,
+    std::int64_t num_reads,
+    double time_limit,
+    std::int64_t max_num_samples,
+    std::uint64_t seed,
+    int num_threads=1
+);
+
+// Draw random samples of a binary quadratic model, reading its biases in
+// place, see `build_ising_graph`. Unlike the other samplers, the model can be
+// SPIN- or BINARY-valued, as given by `is_spin`, and the energies include its
+// offset.
+template <class BQM>
+std::int64_t random_sample(
+    std::int8_t* states,
+    double* energies,
+    std::int64_t* num_kept,
+    const BQM& bqm,
+    bool is_spin,
+    std::int64_t num_reads,
+    double time_limit,
+    std::int64_t max_num_samples,
+    std::uint64_t seed,
+    int num_threads=1
+) {
+    return random_sample(
+        states, energies, num_kept, build_ising_graph(bqm), bqm.offset(),
+        is_spin, num_reads, time_limit, max_num_samples, seed, num_threads
+    );
+}
+
+// Draw random samples of a binary quadratic model, keeping them bit-packed,
+// see `random_sample`.
+template <class BQM>
+std::int64_t random_sample_packed(
+    std::uint8_t* packed_states,
+    double* energies,
+    std::int64_t* num_kept,
+    const BQM& bqm,
+    bool is_spin,
+    std::int64_t num_reads,
+    double time_limit,
+    std::int64_t max_num_samples,
+    std::uint64_t seed,
+    int num_threads=1
+) {
+    return random_sample_packed(
+        packed_states, energies, num_kept, build_ising_graph(bqm), bqm.offset(),
+        is_spin, num_reads, time_limit, max_num_samples, seed, num_threads
+    );
+}
+
+#endif
@@ -14,3 +14,6 @@
 
 from dwave.samplers.sa.sampler import *
 import dwave.samplers.sa.sampler
+
+from dwave.samplers.sa.tempering import *
+import dwave.samplers.sa.tempering
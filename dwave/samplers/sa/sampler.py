@@ -17,11 +17,11 @@ import math
 from numbers import Integral
 from numpy.random import randint
 from collections import defaultdict
-from typing import List, Sequence, Tuple, Optional, Union
+from typing import Iterator, List, Sequence, Tuple, Optional, Union
 from time import perf_counter_ns
 try:
     from typing import Literal
-    BetaScheduleType = Literal['linear', 'geometric', 'custom']
+    BetaScheduleType = Literal['linear', 'geometric', 'adaptive', 'custom']
 except ImportError:
     BetaScheduleType = str
 
@@ -31,7 +31,8 @@ from dimod.core.initialized import InitialStateGenerator
 import dimod
 import numpy as np
 
-from dwave.samplers.sa.simulated_annealing import simulated_annealing
+from dwave.samplers.common.stream import ReadQueue, stream
+from dwave.samplers.sa.simulated_annealing import AnnealingProblem, simulated_annealing_batch
 
 import warnings
 
@@ -106,15 +107,26 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
         beta_range
         beta_schedule
         beta_schedule_type
+        descend
         initial_states
         initial_states_generator
         interrupt_function
+        lookup_table
+        multi_spin
         num_reads
         num_sweeps
         num_sweeps_per_beta
+        num_threads
+        precision
         proposal_acceptance_criteria
         randomize_order
+        read_queue
         seed
+        stall_sweeps
+        sweep_threads
+        target_energy
+        time_limit
+        vectorize
         >>> sampler.parameters['beta_range']
         []
         >>> sampler.parameters['beta_schedule_type']
@@ -131,7 +143,7 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
         >>> from dwave.samplers import SimulatedAnnealingSampler
         >>> sampler = SimulatedAnnealingSampler()
         >>> sampler.properties['beta_schedule_options']
-        ('linear', 'geometric', 'custom')
+        ('linear', 'geometric', 'adaptive', 'custom')
 
     """
 
@@ -149,9 +161,20 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
                            'initial_states_generator': [],
                            'randomize_order': [],
                            'proposal_acceptance_criteria': [],
+                           'num_threads': [],
+                           'multi_spin': [],
+                           'vectorize': [],
+                           'sweep_threads': [],
+                           'lookup_table': [],
+                           'precision': [],
+                           'time_limit': [],
+                           'target_energy': [],
+                           'stall_sweeps': [],
+                           'descend': [],
+                           'read_queue': [],
                            }
         self.properties = {'beta_schedule_options': ('linear', 'geometric',
-                                                     'custom')}
+                                                     'adaptive', 'custom')}
 
     def sample(self, bqm: dimod.BinaryQuadraticModel,
                beta_range: Optional[Union[List[float], Tuple[float, float]]] = None,
@@ -166,6 +189,17 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
                initial_states_generator: InitialStateGenerator = "random",
                randomize_order: bool = False,
                proposal_acceptance_criteria: str = 'Metropolis',
+               num_threads: int = 1,
+               multi_spin: bool = False,
+               vectorize: bool = False,
+               sweep_threads: int = 1,
+               lookup_table: bool = False,
+               precision: str = 'double',
+               time_limit: Optional[float] = None,
+               target_energy: Optional[float] = None,
+               stall_sweeps: Optional[int] = None,
+               descend: bool = False,
+               read_queue: Optional[ReadQueue] = None,
                **kwargs) -> dimod.SampleSet:
         """Sample from a binary quadratic model.
 
@@ -203,8 +237,17 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
 
                 * "geometric"
 
+                * "adaptive"
+
                 * "custom"
 
+                "adaptive" sweeps the betas of the "geometric" schedule, but
+                each read steps through them faster, doubling its step each
+                time, at betas where it accepts fewer than 0.1% of its flip
+                proposals, as colder betas would not move it either. The
+                last beta is always swept. Requires ``vectorize=False``, and
+                ``multi_spin`` is then not used.
+
                 "custom" is recommended for high-performance applications, which
                 typically require optimizing :math:`\\beta` schedules beyond those
                 of the "linear" and "geometric" options, with bounds beyond those
@@ -271,13 +314,108 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
                 annealing terminates and returns with all of the samples and
                 energies found so far.
 
+            num_threads:
+                Number of threads to distribute the reads over. Each read
+                uses its own random number stream, derived from ``seed`` and
+                the index of the read, so results for a given ``seed`` do not
+                depend on ``num_threads``. ``interrupt_function`` is called
+                from the calling thread only; when more than one thread is
+                used, reads already in progress when it returns True are
+                still completed and returned.
+
+            multi_spin:
+                When `True`, anneal 64 reads at once using multi-spin coding,
+                which packs the state of a variable in all 64 reads into a
+                single machine word and decides the spin flips for all reads
+                with bitwise operations. Each read remains independent. This
+                is typically an order of magnitude faster for problems with
+                small integer biases, such as :math:`\pm J` spin glasses.
+
+                Requires ``randomize_order=False`` and that, in the Ising
+                representation of the model, all biases are integers and the
+                sum of the absolute biases on each variable is at most 255.
+                Otherwise the reads are annealed one at a time, as when
+                `False`. Results differ from ``multi_spin=False`` for the same
+                ``seed``, and ``interrupt_function`` is called once every 64
+                reads.
+
+            vectorize:
+                When `True`, each sweep updates the variables one color class
+                of a greedy graph coloring at a time, rather than in the
+                order of the labeled variables. Variables of the same color
+                are not coupled to each other, so the acceptance tests for
+                many of them are evaluated at once with SIMD instructions
+                (selected at runtime for the CPU). Requires
+                ``randomize_order=False``. Results differ from
+                ``vectorize=False`` for the same ``seed``.
+
+            sweep_threads:
+                Number of threads used to update the variables within each
+                read. When greater than 1, implies ``vectorize=True``, and
+                the variables of each color class are updated in parallel.
+                This lets a single read of a very large, sparse problem scale
+                across cores; use ``num_threads`` to parallelize over reads
+                instead. The results for a given ``seed`` are the same for any
+                ``sweep_threads`` greater than 1.
+
+            precision:
+                Arithmetic of the energy deltas and couplings of the sweeps
+                when ``vectorize=False``: "double", "single" or "integer".
+                The narrower types halve the memory each sweep walks through,
+                which speeds up problems too large for the CPU caches.
+                "single" rounds the energy deltas to float32 and recomputes
+                them exactly every 64 sweeps, so the rounding errors do not
+                build up. "integer" keeps them as int32 multiples of a
+                common quantum of the biases, which is exact, and falls back
+                to "double" if there is none. The energies returned are exact
+                in every precision.
+
+            time_limit:
+                Maximum wall-clock time, in seconds, of each read. A read
+                ends at the end of the sweep during which it is reached, so
+                bound the latency of a call with ``num_reads`` and
+                ``num_threads``.
+
+            target_energy:
+                If given, each read ends after the first sweep that leaves it
+                in a state with energy at most ``target_energy``.
+
+            stall_sweeps:
+                If given, each read ends after this many consecutive sweeps
+                that do not lower the lowest energy it has reached.
+
+                Unlike ``interrupt_function``, which is only called between
+                reads, the ``time_limit``, ``target_energy`` and
+                ``stall_sweeps`` criteria are checked natively after every
+                sweep. ``multi_spin`` is not used if any of them is given.
+
+            descend:
+                If True, each read is followed by a steepest gradient descent
+                to a local minimum, run natively on the state the annealing
+                ends in. This gives the same samples as wrapping the sampler
+                in :class:`~dwave.samplers.SteepestDescentComposite`, but
+                without converting the samples to a sample set and back in
+                between.
+
+            read_queue:
+                If given, each read is handed over to this
+                :class:`~dwave.samplers.common.stream.ReadQueue` as soon as it
+                is complete. Used by :meth:`sample_stream`, which most users
+                want instead.
+
         Returns:
             A `dimod.SampleSet` for the binary quadratic model.
 
             The `info` field of the sample set contains information about the sampling procedure:
             1. the beta range used,
             2. the beta schedule type used, and
-            3. timing information (details below).
+            3. timing information (details below), and
+            4. if the kernels were built with ``DWAVE_SAMPLERS_COUNTERS``
+               defined, ``counters``: the ``accepted``, ``rejected`` and
+               ``skipped`` flip proposals at each beta of the schedule, summed
+               over the reads. Skipped proposals are rejected without
+               drawing a random number, their acceptance probability being
+               below the resolution of the RNG.
 
             Timing information is categorized into three: preprocessing, sampling, and
             postprocessing time. All timings are reported in units of nanoseconds.
@@ -354,13 +492,54 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
 
         variable_order = parsed.initial_states.variables
 
-        # read out the BQM
-        ldata, (irow, icol, qdata), off = bqm.to_numpy_vectors(
-            variable_order=variable_order)
+        # the annealer reads the BQM in place, so the initial states need to
+        # be in the BQM's variable order
+        if variable_order != bqm.variables:
+            initial_states_array = np.ascontiguousarray(initial_states_array[
+                :, [variable_order.index(v) for v in bqm.variables]])
+            variable_order = bqm.variables
 
         if interrupt_function and not callable(interrupt_function):
             raise TypeError("'interrupt_function' should be a callable")
 
+        if not isinstance(sweep_threads, Integral):
+            error_msg = "'sweep_threads' should be a positive integer: value = {}".format(sweep_threads)
+            raise TypeError(error_msg)
+        if sweep_threads < 1:
+            error_msg = "'sweep_threads' should be a positive integer: value = {}".format(sweep_threads)
+            raise ValueError(error_msg)
+        if sweep_threads > 1:
+            vectorize = True
+
+        if vectorize and randomize_order:
+            raise ValueError("'vectorize' and 'sweep_threads' require 'randomize_order' to be False")
+
+        if vectorize and beta_schedule_type == "adaptive":
+            raise ValueError("beta_schedule_type='adaptive' requires 'vectorize' to be False")
+
+        if time_limit is not None and not time_limit > 0:
+            error_msg = "'time_limit' should be None or a positive number: value = {}".format(time_limit)
+            raise ValueError(error_msg)
+
+        if stall_sweeps is not None:
+            if not isinstance(stall_sweeps, Integral):
+                error_msg = "'stall_sweeps' should be None or a positive integer: value = {}".format(stall_sweeps)
+                raise TypeError(error_msg)
+            if stall_sweeps < 1:
+                error_msg = "'stall_sweeps' should be None or a positive integer: value = {}".format(stall_sweeps)
+                raise ValueError(error_msg)
+
+        if target_energy is not None:
+            # the annealer does not know about the offset
+            target_energy = target_energy - bqm.offset
+
+        if not isinstance(num_threads, Integral):
+            error_msg = "'num_threads' should be a positive integer: value = {}".format(num_threads)
+            raise TypeError(error_msg)
+        if num_threads < 1:
+            error_msg = "'num_threads' should be a positive integer: value = {}".format(num_threads)
+            raise ValueError(error_msg)
+
         if not isinstance(num_sweeps_per_beta, Integral):
             error_msg = "'num_sweeps_per_beta' should be a positive integer: value = {}".format(num_sweeps_per_beta)
             raise TypeError(error_msg)
@@ -368,6 +547,8 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
             error_msg = "'num_sweeps_per_beta' should be a positive integer: value = {}".format(num_sweeps_per_beta)
             raise ValueError(error_msg)
 
+        problem = AnnealingProblem.from_bqm(bqm)
+
         # handle beta_schedule et al
         if beta_schedule_type == "custom":
 
@@ -403,7 +584,7 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
                 raise ValueError(error_msg)
 
             if beta_range is None:
-                beta_range = _default_ising_beta_range(bqm.linear, bqm.quadratic)
+                beta_range = _problem_beta_range(problem)
             elif len(beta_range) != 2 or min(beta_range) < 0:
                 error_msg = "'beta_range' should be a 2-tuple, or 2 element list of positive numbers. The latter value is the target value."
                 raise ValueError(error_msg)
@@ -415,30 +596,49 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
                 if beta_schedule_type == "linear":
                     # interpolate a linear beta schedule
                     beta_schedule = np.linspace(*beta_range, num=num_betas)
-                elif beta_schedule_type == "geometric":
+                elif beta_schedule_type in ("geometric", "adaptive"):
                     if min(beta_range) <= 0:
-                        error_msg = "'beta_range' must contain non-zero values for 'beta_schedule_type' = 'geometric'"
+                        error_msg = "'beta_range' must contain non-zero values for 'beta_schedule_type' = '{}'".format(beta_schedule_type)
                         raise ValueError(error_msg)
                     # interpolate a geometric beta schedule
                     beta_schedule = np.geomspace(*beta_range, num=num_betas)
                 else:
                     raise ValueError("Beta schedule type {} not implemented".format(beta_schedule_type))
 
+        if read_queue is not None:
+            read_queue.describe(variable_order, bqm.offset, original_vartype)
+
         timestamp_sample = perf_counter_ns()
 
         # run the simulated annealing algorithm
-        samples, energies = simulated_annealing(
-            num_reads, ldata, irow, icol, qdata,
-            num_sweeps_per_beta, beta_schedule,
+        counters = {}
+        samples, energies = problem.sample(
+            num_reads, num_sweeps_per_beta, beta_schedule,
             seed, initial_states_array,
-            randomize_order, proposal_acceptance_criteria,
-            interrupt_function)
+            randomize_order=randomize_order,
+            proposal_acceptance_criteria=proposal_acceptance_criteria,
+            interrupt_function=interrupt_function,
+            num_threads=num_threads,
+            multi_spin=multi_spin,
+            vectorize=vectorize,
+            sweep_threads=sweep_threads,
+            lookup_table=lookup_table,
+            precision=precision,
+            time_limit=time_limit,
+            target_energy=target_energy,
+            stall_sweeps=stall_sweeps,
+            descend=descend,
+            read_queue=read_queue,
+            counters=counters,
+            min_acceptance=_ADAPTIVE_MIN_ACCEPTANCE if beta_schedule_type == "adaptive" else None)
         timestamp_postprocess = perf_counter_ns()
 
         info = {
             "beta_range": beta_range,
             "beta_schedule_type": beta_schedule_type
         }
+        if counters:
+            info["counters"] = counters
         response = dimod.SampleSet.from_samples(
             (samples, variable_order),
             energy=energies+bqm.offset,  # add back in the offset
@@ -459,9 +659,177 @@ class SimulatedAnnealingSampler(dimod.Sampler, dimod.Initialized):
 
         return response
 
+    def sample_stream(self, bqm: dimod.BinaryQuadraticModel, *,
+                      batch_size: Optional[int] = None,
+                      queue_size: int = 1024,
+                      **parameters) -> Iterator[dimod.SampleSet]:
+        """Sample from a binary quadratic model, yielding the reads while the
+        others are still being annealed.
+
+        The annealing runs natively on a separate thread, with the same
+        results as :meth:`sample` for the same parameters, and hands over
+        each read as soon as it is complete, so the first reads of a long
+        call can be inspected, or the call abandoned, early. With
+        ``num_threads`` greater than 1, the reads are not handed over in
+        order.
+
+        Args:
+            bqm: Binary quadratic model to be sampled.
+
+            batch_size:
+                Largest number of reads in a yielded sample set. By default
+                each sample set holds all of the reads completed since the
+                previous one.
+
+            queue_size:
+                Number of completed reads held for the consumer. Once it is
+                reached, the annealing waits for the consumer to catch up.
+
+            **parameters:
+                Parameters of :meth:`sample`.
+
+        Yields:
+            A `dimod.SampleSet` of the reads completed since the previous
+            one. The generator returns, as the value of its
+            ``StopIteration``, the sample set :meth:`sample` would have
+            returned. Closing the generator early lets the remaining reads
+            complete without waiting for a consumer.
+
+        Examples:
+            >>> import dimod
+            >>> from dwave.samplers import SimulatedAnnealingSampler
+            ...
+            >>> sampler = SimulatedAnnealingSampler()
+            >>> bqm = dimod.generators.ran_r(1, 20, seed=1)
+            >>> num_reads = 0
+            >>> for sampleset in sampler.sample_stream(bqm, num_reads=100):
+            ...     num_reads += len(sampleset)
+            >>> num_reads
+            100
+
+        """
+        read_queue = ReadQueue(queue_size)
+        return stream(lambda: self.sample(bqm, read_queue=read_queue, **parameters),
+                      read_queue, batch_size)
+
+
+    def sample_batch(self, bqms: Sequence[dimod.BinaryQuadraticModel], *,
+                     num_reads: int = 1,
+                     num_sweeps: int = 1000,
+                     num_sweeps_per_beta: int = 1,
+                     beta_range: Optional[Union[List[float], Tuple[float, float]]] = None,
+                     beta_schedule_type: BetaScheduleType = "geometric",
+                     seed: Optional[int] = None,
+                     randomize_order: bool = False,
+                     proposal_acceptance_criteria: str = 'Metropolis',
+                     num_threads: int = 1) -> List[dimod.SampleSet]:
+        """Sample from each of many binary quadratic models in one native call.
+
+        Intended for many small problems, eg. the subproblems of a
+        decomposition solver, for which the per-call overhead of
+        :meth:`sample` outweighs the annealing itself. The models are spread
+        over ``num_threads`` threads, each of which anneals all the reads of
+        one model at a time, from random initial states.
+
+        Args:
+            bqms: Binary quadratic models to be sampled.
+
+            num_reads: Number of reads of each model.
+
+            num_sweeps: Number of sweeps of each read.
+
+            num_sweeps_per_beta: Number of sweeps at each beta.
+
+            beta_range:
+                The hot and cold betas of all the schedules. By default each
+                model gets its own, as in :meth:`sample`.
+
+            beta_schedule_type:
+                "linear" or "geometric", see :meth:`sample`.
+
+            seed:
+                Seed of the PRNG. The reads of each model only depend on the
+                seed and on the position of the model in ``bqms``.
+
+            randomize_order: See :meth:`sample`.
+
+            proposal_acceptance_criteria: See :meth:`sample`.
+
+            num_threads: Number of threads to spread the models over.
+
+        Returns:
+            A `dimod.SampleSet` for each model, in the order of ``bqms``.
+
+        Examples:
+            >>> import dimod
+            >>> from dwave.samplers import SimulatedAnnealingSampler
+            ...
+            >>> sampler = SimulatedAnnealingSampler()
+            >>> bqms = [dimod.generators.ran_r(1, 20, seed=s) for s in range(100)]
+            >>> samplesets = sampler.sample_batch(bqms, num_reads=10, num_threads=4)
+            >>> len(samplesets)
+            100
+
+        """
+        if seed is None:
+            seed = randint(2**31)
+        elif not isinstance(seed, Integral):
+            raise TypeError("'seed' should be None or an integer between 0 and 2^32 - 1: value = {}".format(seed))
+
+        if not isinstance(num_threads, Integral) or not isinstance(num_reads, Integral):
+            raise TypeError("'num_reads' and 'num_threads' should be positive integers")
+        if num_threads < 1 or num_reads < 1:
+            raise ValueError("'num_reads' and 'num_threads' should be positive integers")
+
+        if beta_schedule_type not in ("linear", "geometric"):
+            raise ValueError("'beta_schedule_type' should be 'linear' or 'geometric' for sample_batch")
+
+        num_betas, rem = divmod(num_sweeps, num_sweeps_per_beta)
+        if rem > 0 or num_betas < 1:
+            raise ValueError("'num_sweeps' must be a positive value divisible by 'num_sweeps_per_beta'.")
+
+        if beta_range is not None:
+            if len(beta_range) != 2 or min(beta_range) < 0:
+                raise ValueError("'beta_range' should be a 2-tuple, or 2 element list of positive numbers. The latter value is the target value.")
+            if beta_schedule_type == "geometric" and min(beta_range) <= 0:
+                raise ValueError("'beta_range' must contain non-zero values for 'beta_schedule_type' = 'geometric'")
+
+        spin_bqms = [bqm if bqm.vartype is dimod.SPIN
+                     else bqm.change_vartype(dimod.SPIN, inplace=False)
+                     for bqm in bqms]
+
+        samples, energies, beta_ranges = simulated_annealing_batch(
+            spin_bqms, num_reads, num_sweeps_per_beta, num_betas,
+            beta_range, beta_schedule_type == "geometric", seed,
+            randomize_order=randomize_order,
+            proposal_acceptance_criteria=proposal_acceptance_criteria,
+            num_threads=num_threads)
+
+        samplesets = []
+        for bqm, spin, states, energy, model_range in zip(
+                bqms, spin_bqms, samples, energies, beta_ranges):
+            sampleset = dimod.SampleSet.from_samples(
+                (states, spin.variables),
+                energy=energy + spin.offset,
+                info=dict(beta_range=list(model_range),
+                          beta_schedule_type=beta_schedule_type),
+                vartype=dimod.SPIN)
+            sampleset.change_vartype(bqm.vartype, inplace=True)
+            samplesets.append(sampleset)
+
+        return samplesets
 
 Neal = SimulatedAnnealingSampler
 
+# the fraction of its proposals below which a read of an "adaptive" schedule
+# steps faster through the betas
+_ADAPTIVE_MIN_ACCEPTANCE = 1e-3
+
+_ZERO_BIASES_WARNING = (
+    'All bqm biases are zero (all energies are zero), this is '
+    'likely a value error. Temperature range is set arbitrarily '
+    'to [0.1,1]. Metropolis-Hastings update is non-ergodic.')
+
 
 def _default_ising_beta_range(h, J,
                               max_single_qubit_excitation_rate = 0.01,
@@ -539,10 +907,7 @@ def _default_ising_beta_range(h, J,
         #Metropolis-Hastings is not suitable for unbiased and uncoupled
         #variables, sampling of equilibrium is possible, but only if a uniform
         #random initial condition is used (this is default, but allows changes).
-        warn_msg = ('All bqm biases are zero (all energies are zero), this is '
-                    'likely a value error. Temperature range is set arbitrarily '
-                    'to [0.1,1]. Metropolis-Hastings update is non-ergodic.')
-        warnings.warn(warn_msg)
+        warnings.warn(_ZERO_BIASES_WARNING)
         return([0.1,1])
 
 
@@ -598,6 +963,17 @@ def _default_ising_beta_range(h, J,
 
     return [hot_beta, cold_beta]
 
+def _problem_beta_range(problem):
+    """The beta range of :func:`_default_ising_beta_range` for an
+    :class:`~dwave.samplers.sa.simulated_annealing.AnnealingProblem`,
+    computed natively from its adjacency."""
+    hot_beta, cold_beta = problem.default_beta_range()
+    if not hot_beta:
+        # see _default_ising_beta_range
+        warnings.warn(_ZERO_BIASES_WARNING)
+        return [0.1, 1]
+    return [hot_beta, cold_beta]
+
 def default_beta_range(bqm):
-    ising = bqm.spin
-    return _default_ising_beta_range(ising.linear, ising.quadratic)
+    ising = bqm.change_vartype(dimod.SPIN, inplace=False)
+    return _problem_beta_range(AnnealingProblem.from_bqm(ising))
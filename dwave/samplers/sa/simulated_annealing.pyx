@@ -1,6 +1,6 @@
 # distutils: language = c++
-# distutils: include_dirs = dwave/samplers/sa/src/
-# distutils: sources = dwave/samplers/sa/src/cpu_sa.cpp
+# distutils: include_dirs = dwave/samplers/sa/src/ dwave/samplers/greedy/src/ dwave/samplers/common/src/
+# distutils: sources = dwave/samplers/sa/src/cpu_sa.cpp dwave/samplers/greedy/src/descent.cpp
 # cython: language_level = 3
 
 # Copyright 2018 D-Wave Systems Inc.
@@ -17,34 +17,108 @@
 #    See the License for the specific language governing permissions and
 #    limitations under the License.
 
+from cython.operator cimport dereference as deref
+from libc.stdint cimport int64_t
 from libcpp cimport bool
+from libcpp.memory cimport shared_ptr
+from libcpp.utility cimport pair
 from libcpp.vector cimport vector
 
+import dimod
+cimport dimod
+from dimod.cyqmbase.cyqmbase_float64 cimport bias_type, index_type
+from dimod.libcpp.binary_quadratic_model cimport BinaryQuadraticModel as cppBinaryQuadraticModel
 import numpy as np
 cimport numpy as np
 
+from dwave.samplers.common.counters cimport counters_enabled
+from dwave.samplers.common.graph cimport IsingGraph, cppIsingGraph
+from dwave.samplers.common.pool cimport set_worker_pool, shared_worker_pool
+from dwave.samplers.common.stream cimport ReadQueue, cppReadQueue
+from dwave.samplers.greedy.decl cimport DescentSolver, LinearSearch, OrderedSet, IndexedHeap
+
+# run the parallel loops of the kernels on the workers shared by all samplers
+set_worker_pool(shared_worker_pool())
+
 
 cdef extern from "cpu_sa.h":
     ctypedef bool (*callback)(void *function)
     ctypedef enum Proposal:
         Gibbs, Metropolis
     ctypedef enum VariableOrder:
-        Sequential, Random
-    int general_simulated_annealing(
-            np.int8_t* samples,
+        Sequential, Random, Colored
+    ctypedef enum Precision:
+        DoublePrecision, SinglePrecision, IntegerPrecision
+    cdef cppclass Termination:
+        double time_limit
+        double target_energy
+        int stall_sweeps
+    cdef cppclass ProposalCounts:
+        int64_t accepted
+        int64_t rejected
+        int64_t skipped
+    cdef cppclass AnnealingBatch:
+        int num_samples
+        int sweeps_per_beta
+        int num_betas
+        double hot_beta
+        double cold_beta
+        bool geometric
+        VariableOrder varorder
+        Proposal proposal_acceptance_criteria
+    void simulated_annealing_batch(
+            const vector[cppBinaryQuadraticModel[bias_type, index_type]*] & bqms,
+            np.int8_t* states,
             double* energies,
-            const int num_samples,
-            const vector[double] & h,
-            const vector[int] & coupler_starts,
-            const vector[int] & coupler_ends,
-            const vector[double] & coupler_weights,
-            const int sweeps_per_beta,
-            const vector[double] & beta_schedule,
+            pair[double, double]* beta_ranges,
+            const AnnealingBatch & batch,
             const unsigned long long seed,
-            const VariableOrder varorder,
-            const Proposal proposal_acceptance_criteria,
-            callback interrupt_callback,
-            void *interrupt_function) nogil
+            const int num_threads) except + nogil
+    cdef cppclass _AnnealingProblem "AnnealingProblem":
+        _AnnealingProblem(const vector[double] & h,
+                          const vector[int] & coupler_starts,
+                          const vector[int] & coupler_ends,
+                          const vector[double] & coupler_weights) except +
+        _AnnealingProblem(const cppBinaryQuadraticModel[bias_type, index_type] & bqm) except +
+        _AnnealingProblem(shared_ptr[cppIsingGraph] graph) except +
+        int num_variables()
+        pair[double, double] default_beta_range(
+            const double max_single_qubit_excitation_rate,
+            const bool scale_T_with_N) except +
+        int sample(np.int8_t* samples,
+                   double* energies,
+                   const int num_samples,
+                   const int sweeps_per_beta,
+                   const vector[double] & beta_schedule,
+                   const unsigned long long seed,
+                   const VariableOrder varorder,
+                   const Proposal proposal_acceptance_criteria,
+                   callback interrupt_callback,
+                   void *interrupt_function,
+                   const int num_threads,
+                   const bool multi_spin,
+                   const int sweep_threads,
+                   const bool lookup_table,
+                   const Termination & termination,
+                   const bool descend,
+                   const DescentSolver descent_solver,
+                   cppReadQueue* completed,
+                   vector[ProposalCounts]* proposal_counts,
+                   const double min_acceptance,
+                   const Precision precision) except + nogil
+        int parallel_tempering(np.int8_t* samples,
+                               double* energies,
+                               const int num_samples,
+                               const vector[double] & beta_ladder,
+                               const int sweeps_per_swap,
+                               const int num_swaps,
+                               const unsigned long long seed,
+                               const VariableOrder varorder,
+                               const Proposal proposal_acceptance_criteria,
+                               callback interrupt_callback,
+                               void *interrupt_function,
+                               const int num_threads,
+                               int64_t *swap_accepts) except + nogil
 
 
 def simulated_annealing(num_samples, h, coupler_starts, coupler_ends,
@@ -52,10 +126,22 @@ def simulated_annealing(num_samples, h, coupler_starts, coupler_ends,
                         np.ndarray[np.int8_t, ndim=2, mode="c"] states_numpy,
                         randomize_order=False,
                         proposal_acceptance_criteria='Metropolis',
-                        interrupt_function=None):
-    """Wraps `general_simulated_annealing` from `cpu_sa.cpp`. Accepts
-    an Ising problem defined on a general graph and returns samples
-    using simulated annealing.
+                        interrupt_function=None,
+                        num_threads=1,
+                        multi_spin=False,
+                        vectorize=False,
+                        sweep_threads=1,
+                        lookup_table=False,
+                        time_limit=None,
+                        target_energy=None,
+                        stall_sweeps=None,
+                        descend=False,
+                        descent_solver=None,
+                        min_acceptance=None,
+                        precision='double'):
+    """Accepts an Ising problem defined on a general graph and returns
+    samples using simulated annealing. To sample the same problem
+    repeatedly, see :class:`AnnealingProblem`.
 
     Parameters
     ----------
@@ -123,6 +209,96 @@ def simulated_annealing(num_samples, h, coupler_starts, coupler_ends,
         When `Metropolis`, each spin flip proposal is accepted according to the
         Metropolis-Hastings criteria.
 
+    num_threads: int
+        The number of threads to distribute the samples over. Each sample
+        uses its own PRNG stream derived from `seed` and the index of the
+        sample, so the returned samples do not depend on `num_threads`.
+        `interrupt_function` is always called from the calling thread, once
+        per finished sample; samples already in progress when it returns True
+        are still completed and returned.
+
+    multi_spin: bool
+        When True, and all of the biases are integers with the sum of the
+        absolute biases on each variable at most 255, 64 samples are annealed
+        at once using multi-spin coding. Only supported with
+        `randomize_order=False`; otherwise, or if the biases are not
+        representable, the samples are annealed one at a time as usual. The
+        samples differ from those returned with `multi_spin=False` for the
+        same `seed`, and `interrupt_function` is called once per 64 samples.
+
+    vectorize: bool
+        When True, and `randomize_order` is False, the variables are updated
+        one color class of a greedy graph coloring at a time, instead of in
+        index order. Variables of the same color are not coupled, so the
+        acceptance tests for a block of them are evaluated together using
+        SIMD instructions, selected at runtime for the CPU.
+
+    sweep_threads: int
+        When greater than 1, and `vectorize` is True, the blocks of each
+        color class are updated in parallel on this many threads within each
+        sample. Each variable's energy delta is then recomputed just before
+        its update, and each block uses its own PRNG stream, so the samples
+        do not depend on `sweep_threads` (as long as it is greater than 1).
+
+    lookup_table: bool
+        When True, and all of the biases are integer multiples of a common
+        quantum, the acceptance thresholds for every reachable energy delta
+        are precomputed once per beta and looked up instead of calling exp().
+        Not used with `vectorize`. Falls back to calling exp() if the biases
+        are not quantized or the tables would be too large.
+
+    time_limit: float, optional
+        If given, each sample ends after at most this many seconds, at the end
+        of the sweep during which the time limit is reached.
+
+    target_energy: float, optional
+        If given, each sample ends at the end of the first sweep after which
+        its energy is at most `target_energy`.
+
+    stall_sweeps: int, optional
+        If given, each sample ends after this many consecutive sweeps that do
+        not lower the lowest energy it has reached.
+
+        The termination criteria are checked natively after every sweep,
+        unlike `interrupt_function`, which is only called between samples.
+        Multi-spin coding is not used if any of them is given.
+
+    descend: bool
+        When True, each sample is followed by a steepest gradient descent from
+        its final state, natively and without copying the states in between.
+        The descent starts from the energy deltas that the annealing kept up
+        to date. The samples and energies returned are those of the local
+        minima reached, as with
+        :func:`dwave.samplers.greedy.descent.steepest_gradient_descent` on the
+        annealed states.
+
+    descent_solver: str, optional
+        The data structure the descent uses to find the steepest descent
+        variable: 'linear' (the default), 'tree' or 'heap', see
+        :func:`dwave.samplers.greedy.descent.steepest_gradient_descent`. All of
+        them give the same samples.
+
+    min_acceptance: float, optional
+        If given, each sample walks `beta_schedule` adaptively: after the
+        sweeps at a beta where fewer than this fraction of its flip proposals
+        were accepted, it steps twice as far through the schedule as it last
+        did, and otherwise it goes on to the next beta. A state that hardly
+        moves at a beta hardly moves at the colder ones either, so fewer
+        sweeps are spent where nothing happens. The last beta is always
+        swept. Requires `vectorize=False`, and multi-spin coding is not used.
+
+    precision: str
+        The arithmetic of the energy deltas and couplings of the sweeps when
+        `vectorize` is False: 'double' (the default), 'single' or 'integer'.
+        The narrower types halve the memory the sweeps walk through, which
+        speeds up problems too large for the caches. 'single' rounds the
+        energy deltas to float32, and recomputes them exactly every 64 sweeps
+        so that the rounding errors do not build up. 'integer' keeps them as
+        int32 multiples of the quantum of the biases, which is exact, and
+        gives the same samples as 'double' when the quantum is a power of
+        two; it falls back to 'double' if the biases are not multiples of a
+        common quantum. The energies returned are exact in every precision.
+
     Returns
     -------
     samples : numpy.ndarray
@@ -132,66 +308,555 @@ def simulated_annealing(num_samples, h, coupler_starts, coupler_ends,
         The energies.
 
     """
-    num_vars = len(h)
+    problem = AnnealingProblem(h, coupler_starts, coupler_ends, coupler_weights)
+    return problem.sample(num_samples, sweeps_per_beta, beta_schedule, seed,
+                          states_numpy,
+                          randomize_order=randomize_order,
+                          proposal_acceptance_criteria=proposal_acceptance_criteria,
+                          interrupt_function=interrupt_function,
+                          num_threads=num_threads,
+                          multi_spin=multi_spin,
+                          vectorize=vectorize,
+                          sweep_threads=sweep_threads,
+                          lookup_table=lookup_table,
+                          time_limit=time_limit,
+                          target_energy=target_energy,
+                          stall_sweeps=stall_sweeps,
+                          descend=descend,
+                          descent_solver=descent_solver,
+                          min_acceptance=min_acceptance,
+                          precision=precision)
+
+
+def simulated_annealing_batch(bqms, num_samples, sweeps_per_beta, num_betas,
+                              beta_range, geometric, seed,
+                              randomize_order=False,
+                              proposal_acceptance_criteria='Metropolis',
+                              num_threads=1):
+    """Wraps `simulated_annealing_batch` from `cpu_sa.h`. Samples each of a
+    list of spin-valued binary quadratic models using simulated annealing, in
+    a single native call that spreads the models over `num_threads` threads.
+
+    The initial states are random, and the beta schedule of each model spans
+    `beta_range`, or the default beta range of the model if `beta_range` is
+    None, see :meth:`AnnealingProblem.default_beta_range`.
+
+    Parameters
+    ----------
+    bqms : list(dimod.BinaryQuadraticModel)
+        Spin-valued binary quadratic models, read in place. Models with
+        biases other than float64 are copied first.
+
+    num_samples : int
+        Number of samples to get from each model.
+
+    sweeps_per_beta : int
+        The number of sweeps at each beta of the schedules.
+
+    num_betas : int
+        The number of betas of each schedule.
+
+    beta_range : (float, float) or None
+        The hot and cold betas of all the schedules.
+
+    geometric : bool
+        Whether the schedules are geometric rather than linear.
+
+    seed : 64 bit int > 0
+        The seed. The samples of the `i`-th model only depend on the seed
+        and on `i`, not on `num_threads`.
+
+    randomize_order, proposal_acceptance_criteria, num_threads :
+        See :func:`simulated_annealing`.
+
+    Returns
+    -------
+    samples : list(numpy.ndarray)
+        The samples of each model, one 2D array of
+        `num_samples` rows each, in the order of the model's variables.
+        They are views of a single array.
+
+    energies : numpy.ndarray
+        The energies of the samples, one row per model, without the offsets.
+
+    beta_ranges : numpy.ndarray
+        The hot and cold betas of the schedule of each model, one row per
+        model.
+
+    """
+    cdef vector[cppBinaryQuadraticModel[bias_type, index_type]*] _bqms
+    cdef dimod.cyBQM_float64 cybqm
+    cdef Py_ssize_t total_vars = 0
 
-    # in the case that we either need no samples or there are no variables,
-    # we can safely return an empty array (and set energies to 0)
-    if num_samples*num_vars == 0:
-        annealed_states = np.empty((num_samples, num_vars), dtype=np.int8)
-        return annealed_states, np.zeros(num_samples, dtype=np.double)
+    # hold the float64 models until the annealing is done
+    models = []
+    for bqm in bqms:
+        if bqm.vartype is not dimod.SPIN:
+            raise ValueError("bqms must be spin-valued")
+        cybqm = dimod.as_bqm(bqm, dtype=float).data
+        models.append(cybqm)
+        _bqms.push_back(cybqm.cppbqm)
+        total_vars += bqm.num_variables
 
-    # allocate ndarray for energies
-    energies_numpy = np.empty(num_samples, dtype=np.float64)
-    cdef double[:] energies = energies_numpy
+    cdef AnnealingBatch batch
+    batch.num_samples = num_samples
+    batch.sweeps_per_beta = sweeps_per_beta
+    batch.num_betas = num_betas
+    if beta_range is not None:
+        batch.hot_beta, batch.cold_beta = beta_range
+    batch.geometric = geometric
+    batch.varorder = _variable_order(randomize_order)
+    batch.proposal_acceptance_criteria = _proposal(proposal_acceptance_criteria)
+
+    # allocate a single array for the samples of all the models
+    states_numpy = np.empty(num_samples * total_vars, dtype=np.int8)
+    energies_numpy = np.empty((len(models), num_samples), dtype=np.float64)
+    cdef vector[pair[double, double]] beta_ranges
+    beta_ranges.resize(len(models))
 
     # explicitly convert all Python types to C while we have the GIL
-    cdef np.int8_t* _states = &states_numpy[0, 0]
-    cdef double* _energies = &energies[0]
-    cdef int _num_samples = num_samples
-    cdef vector[double] _h = h
-    cdef vector[int] _coupler_starts = coupler_starts
-    cdef vector[int] _coupler_ends = coupler_ends
-    cdef vector[double] _coupler_weights = coupler_weights
-    cdef int _sweeps_per_beta = sweeps_per_beta
-    cdef vector[double] _beta_schedule = beta_schedule
+    cdef np.int8_t* _states = <np.int8_t*> np.PyArray_DATA(states_numpy)
+    cdef double* _energies = <double*> np.PyArray_DATA(energies_numpy)
     cdef unsigned long long _seed = seed
-    cdef VariableOrder _varorder
-    if randomize_order:
-        _varorder = Random
-    else:
-        _varorder = Sequential
-    cdef Proposal _proposal_acceptance_criteria
+    cdef int _num_threads = num_threads
+
+    with nogil:
+        simulated_annealing_batch(_bqms, _states, _energies, beta_ranges.data(),
+                                  batch, _seed, _num_threads)
+
+    samples = []
+    cdef Py_ssize_t offset = 0
+    for bqm in bqms:
+        size = num_samples * bqm.num_variables
+        samples.append(states_numpy[offset:offset + size].reshape(num_samples, bqm.num_variables))
+        offset += size
+
+    # the pairs are converted to tuples
+    beta_ranges_numpy = np.array(beta_ranges, dtype=np.float64).reshape(-1, 2)
+
+    return samples, energies_numpy, beta_ranges_numpy
+
+
+cdef class AnnealingProblem:
+    """Wraps `AnnealingProblem` from `cpu_sa.cpp`. An Ising problem defined on
+    a general graph, prepared once so that it can be sampled repeatedly using
+    simulated annealing.
+
+    The adjacency of the problem is built when the object is created, or
+    shared with other samplers, see :meth:`from_graph`, and the other
+    structures derived from the problem are built by the first sample that
+    needs them, so repeated calls to :meth:`sample` only pay for the annealing
+    itself.
+
+    Parameters
+    ----------
+    h : list(float)
+        The h or field values for the problem.
+
+    coupler_starts : list(int)
+        A list of the start variable of each coupler.
+
+    coupler_ends : list(int)
+        A list of the end variable of each coupler.
+
+    coupler_weights : list(float)
+        A list of the J values or weight on each coupler, in the same
+        order as `coupler_starts` and `coupler_ends`.
+
+    See :func:`simulated_annealing` for details.
+
+    """
+    cdef _AnnealingProblem* _problem
+
+    def __cinit__(self):
+        self._problem = NULL
+
+    def __init__(self, h, coupler_starts, coupler_ends, coupler_weights):
+        cdef vector[double] _h = h
+        cdef vector[int] _coupler_starts = coupler_starts
+        cdef vector[int] _coupler_ends = coupler_ends
+        cdef vector[double] _coupler_weights = coupler_weights
+        # in case __init__ is called more than once
+        del self._problem
+        self._problem = NULL
+        self._problem = new _AnnealingProblem(_h, _coupler_starts,
+                                              _coupler_ends, _coupler_weights)
+
+    def __dealloc__(self):
+        del self._problem
+
+    @staticmethod
+    def from_bqm(bqm):
+        """Prepare a spin-valued binary quadratic model for simulated annealing.
+
+        The biases are read directly from the BQM's C++ adjacency, without
+        first flattening them into arrays. The variables of the problem are
+        the indices of the BQM's variables, so the states passed to
+        :meth:`sample` must be in the order of ``bqm.variables``.
+
+        Parameters
+        ----------
+        bqm : dimod.BinaryQuadraticModel
+            A spin-valued binary quadratic model. Models with biases other
+            than float64 are copied first. The offset is ignored.
+
+        Returns
+        -------
+        problem : AnnealingProblem
+
+        """
+        if bqm.vartype is not dimod.SPIN:
+            raise ValueError("bqm must be spin-valued")
+
+        cdef dimod.cyBQM_float64 cybqm = dimod.as_bqm(bqm, dtype=float).data
+        cdef AnnealingProblem problem = AnnealingProblem.__new__(AnnealingProblem)
+        problem._problem = new _AnnealingProblem(deref(cybqm.data()))
+        return problem
+
+    @staticmethod
+    def from_graph(IsingGraph graph not None):
+        """Prepare a problem graph for simulated annealing, sharing it rather
+        than copying it.
+
+        Parameters
+        ----------
+        graph : :class:`dwave.samplers.common.graph.IsingGraph`
+            The graph of the problem. The same graph can also be passed to
+            other samplers, for instance to
+            :func:`dwave.samplers.greedy.descent.steepest_gradient_descent_graph`.
+
+        Returns
+        -------
+        problem : AnnealingProblem
+
+        """
+        cdef AnnealingProblem problem = AnnealingProblem.__new__(AnnealingProblem)
+        problem._problem = new _AnnealingProblem(graph.graph)
+        return problem
+
+    @property
+    def num_variables(self):
+        """int: The number of variables in the problem."""
+        return self._problem.num_variables()
+
+    def default_beta_range(self, max_single_qubit_excitation_rate=0.01,
+                           scale_T_with_N=True):
+        """Returns the default beta range of the problem.
+
+        Computes what
+        :func:`dwave.samplers.sa.sampler._default_ising_beta_range` does from
+        the biases, in a single native pass over the adjacency of the problem.
+
+        Parameters
+        ----------
+        max_single_qubit_excitation_rate : float
+            The targeted single qubit excitation rate at the cold beta, in
+            (0, 1).
+
+        scale_T_with_N : bool
+            Whether the cold beta grows with the number of variables of the
+            smallest bias.
+
+        Returns
+        -------
+        hot_beta, cold_beta : (float, float)
+            The betas, or ``(0.0, 0.0)`` if all the biases are zero.
+
+        """
+        cdef pair[double, double] beta_range = self._problem.default_beta_range(
+            max_single_qubit_excitation_rate, scale_T_with_N)
+        return beta_range.first, beta_range.second
+
+    def sample(self, num_samples, sweeps_per_beta, beta_schedule, seed,
+               np.ndarray[np.int8_t, ndim=2, mode="c"] states_numpy,
+               randomize_order=False,
+               proposal_acceptance_criteria='Metropolis',
+               interrupt_function=None,
+               num_threads=1,
+               multi_spin=False,
+               vectorize=False,
+               sweep_threads=1,
+               lookup_table=False,
+               time_limit=None,
+               target_energy=None,
+               stall_sweeps=None,
+               descend=False,
+               descent_solver=None,
+               ReadQueue read_queue=None,
+               dict counters=None,
+               min_acceptance=None,
+               precision='double'):
+        """Returns samples of the problem using simulated annealing.
+
+        Takes the same parameters as :func:`simulated_annealing`, less those
+        that define the problem. The object may be sampled from several
+        threads at once.
+
+        If `read_queue` is given, the index of each read is pushed to it as
+        soon as the read is complete, see
+        :class:`~dwave.samplers.common.stream.ReadQueue`.
+
+        If `counters` is given and the kernels were built with
+        ``DWAVE_SAMPLERS_COUNTERS``, it is filled with the ``accepted``,
+        ``rejected`` and ``skipped`` flip proposals at each beta of
+        `beta_schedule`, summed over the samples, as int64 arrays. Skipped
+        proposals are those rejected without drawing a random number, their
+        acceptance probability being below the resolution of the RNG.
+
+        Returns
+        -------
+        samples : numpy.ndarray
+            A 2D numpy array where each row is a sample.
+
+        energies: np.ndarray
+            The energies.
+
+        """
+        num_vars = self._problem.num_variables()
+
+        # in the case that we either need no samples or there are no variables,
+        # we can safely return an empty array (and set energies to 0)
+        if num_samples*num_vars == 0:
+            annealed_states = np.empty((num_samples, num_vars), dtype=np.int8)
+            return annealed_states, np.zeros(num_samples, dtype=np.double)
+
+        if states_numpy.shape[0] != num_samples or states_numpy.shape[1] != num_vars:
+            raise ValueError("states_numpy must have shape (num_samples, num_variables)")
+
+        # allocate ndarray for energies
+        energies_numpy = np.empty(num_samples, dtype=np.float64)
+        cdef double[:] energies = energies_numpy
+
+        # explicitly convert all Python types to C while we have the GIL
+        cdef np.int8_t* _states = &states_numpy[0, 0]
+        cdef double* _energies = &energies[0]
+        cdef int _num_samples = num_samples
+        cdef int _sweeps_per_beta = sweeps_per_beta
+        cdef vector[double] _beta_schedule = beta_schedule
+        cdef unsigned long long _seed = seed
+        if randomize_order and vectorize:
+            raise ValueError("vectorize=True requires randomize_order=False")
+        cdef VariableOrder _varorder = Colored if vectorize else _variable_order(randomize_order)
+        cdef Proposal _proposal_acceptance_criteria = _proposal(proposal_acceptance_criteria)
+        cdef void* _interrupt_function
+        if interrupt_function is None:
+            _interrupt_function = NULL
+        else:
+            _interrupt_function = <void *>interrupt_function
+        cdef int _num_threads = num_threads
+        cdef bool _multi_spin = multi_spin
+        cdef int _sweep_threads = sweep_threads
+        cdef bool _lookup_table = lookup_table
+        cdef Termination _termination
+        if time_limit is not None:
+            _termination.time_limit = time_limit
+        if target_energy is not None:
+            _termination.target_energy = target_energy
+        if stall_sweeps is not None:
+            _termination.stall_sweeps = stall_sweeps
+        cdef bool _descend = descend
+        cdef DescentSolver _descent_solver = _solver(descent_solver)
+        cdef cppReadQueue* _completed = NULL
+        if read_queue is not None:
+            read_queue.attach(states_numpy, energies_numpy)
+            _completed = read_queue.queue
+        cdef vector[ProposalCounts] proposal_counts
+        cdef vector[ProposalCounts]* _proposal_counts = NULL
+        cdef size_t b
+        if counters is not None and counters_enabled:
+            _proposal_counts = &proposal_counts
+        cdef double _min_acceptance = 0
+        if min_acceptance is not None:
+            if not min_acceptance > 0:
+                raise ValueError("min_acceptance should be None or a positive number")
+            if vectorize:
+                raise ValueError("min_acceptance requires vectorize=False")
+            _min_acceptance = min_acceptance
+        cdef Precision _precision = _sweep_precision(precision)
+
+        with nogil:
+            num = self._problem.sample(_states,
+                                       _energies,
+                                       _num_samples,
+                                       _sweeps_per_beta,
+                                       _beta_schedule,
+                                       _seed,
+                                       _varorder,
+                                       _proposal_acceptance_criteria,
+                                       interrupt_callback,
+                                       _interrupt_function,
+                                       _num_threads,
+                                       _multi_spin,
+                                       _sweep_threads,
+                                       _lookup_table,
+                                       _termination,
+                                       _descend,
+                                       _descent_solver,
+                                       _completed,
+                                       _proposal_counts,
+                                       _min_acceptance,
+                                       _precision)
+
+        if _proposal_counts != NULL:
+            counts = np.empty((3, proposal_counts.size()), dtype=np.int64)
+            for b in range(proposal_counts.size()):
+                counts[0, b] = proposal_counts[b].accepted
+                counts[1, b] = proposal_counts[b].rejected
+                counts[2, b] = proposal_counts[b].skipped
+            counters.update(accepted=counts[0], rejected=counts[1], skipped=counts[2])
+
+        # discard the noise if we were interrupted
+        return states_numpy[:num], energies_numpy[:num]
+
+    def parallel_tempering(self, num_samples, beta_ladder, sweeps_per_swap,
+                           num_swaps, seed,
+                           np.ndarray[np.int8_t, ndim=2, mode="c"] states_numpy,
+                           randomize_order=False,
+                           proposal_acceptance_criteria='Metropolis',
+                           interrupt_function=None,
+                           num_threads=1):
+        """Returns samples of the problem using parallel tempering (replica
+        exchange Monte Carlo).
+
+        For each sample, one replica of the problem, starting from the
+        sample's initial state, is kept at each beta of `beta_ladder`. Rounds
+        of `sweeps_per_swap` sweeps of every replica alternate with attempts to
+        swap the replicas at neighboring betas, accepted with probability
+        ``min(1, exp((b0 - b1) * (e0 - e1)))``. The sample is the final state
+        of the replica at the last beta of the ladder.
+
+        Parameters
+        ----------
+        num_samples : int
+            Number of samples to get from the sampler.
+
+        beta_ladder : list(float)
+            The beta of each replica, typically increasing.
+
+        sweeps_per_swap : int
+            The number of sweeps of each replica between swap attempts.
+
+        num_swaps : int
+            The number of rounds of swap attempts. Each replica is swept
+            ``sweeps_per_swap * num_swaps`` times.
+
+        seed : 64 bit int > 0
+            The seed to use for the PRNG.
+
+        states_numpy : np.ndarray[int8_t, ndim=2, mode="c"], values in (-1, 1)
+            The initial states, of shape (num_samples, num_variables).
+
+        randomize_order: bool
+            See :func:`simulated_annealing`.
+
+        proposal_acceptance_criteria: str
+            See :func:`simulated_annealing`.
+
+        interrupt_function: function
+            See :func:`simulated_annealing`. It is called once per sample.
+
+        num_threads: int
+            The number of threads to sweep the replicas of each sample on.
+            The samples do not depend on `num_threads`.
+
+        Returns
+        -------
+        samples : numpy.ndarray
+            A 2D numpy array where each row is a sample.
+
+        energies: np.ndarray
+            The energies.
+
+        swap_accepts: np.ndarray
+            The number of accepted swaps between each pair of neighboring
+            betas, summed over the samples.
+
+        """
+        num_vars = self._problem.num_variables()
+
+        if len(beta_ladder) < 1:
+            raise ValueError("beta_ladder must not be empty")
+
+        swap_accepts_numpy = np.zeros(len(beta_ladder), dtype=np.int64)
+        if num_samples*num_vars == 0:
+            annealed_states = np.empty((num_samples, num_vars), dtype=np.int8)
+            return (annealed_states, np.zeros(num_samples, dtype=np.double),
+                    swap_accepts_numpy[:-1])
+
+        if states_numpy.shape[0] != num_samples or states_numpy.shape[1] != num_vars:
+            raise ValueError("states_numpy must have shape (num_samples, num_variables)")
+
+        energies_numpy = np.empty(num_samples, dtype=np.float64)
+        cdef double[:] energies = energies_numpy
+        cdef int64_t[:] swap_accepts = swap_accepts_numpy
+
+        # explicitly convert all Python types to C while we have the GIL
+        cdef np.int8_t* _states = &states_numpy[0, 0]
+        cdef double* _energies = &energies[0]
+        cdef int _num_samples = num_samples
+        cdef vector[double] _beta_ladder = beta_ladder
+        cdef int _sweeps_per_swap = sweeps_per_swap
+        cdef int _num_swaps = num_swaps
+        cdef unsigned long long _seed = seed
+        cdef VariableOrder _varorder = _variable_order(randomize_order)
+        cdef Proposal _proposal_acceptance_criteria = _proposal(proposal_acceptance_criteria)
+        cdef void* _interrupt_function
+        if interrupt_function is None:
+            _interrupt_function = NULL
+        else:
+            _interrupt_function = <void *>interrupt_function
+        cdef int _num_threads = num_threads
+        cdef int64_t* _swap_accepts = &swap_accepts[0]
+
+        with nogil:
+            num = self._problem.parallel_tempering(_states,
+                                                   _energies,
+                                                   _num_samples,
+                                                   _beta_ladder,
+                                                   _sweeps_per_swap,
+                                                   _num_swaps,
+                                                   _seed,
+                                                   _varorder,
+                                                   _proposal_acceptance_criteria,
+                                                   interrupt_callback,
+                                                   _interrupt_function,
+                                                   _num_threads,
+                                                   _swap_accepts)
+
+        # discard the noise if we were interrupted
+        return states_numpy[:num], energies_numpy[:num], swap_accepts_numpy[:-1]
+
+
+cdef VariableOrder _variable_order(randomize_order):
+    return Random if randomize_order else Sequential
+
+
+cdef Proposal _proposal(proposal_acceptance_criteria) except *:
     if proposal_acceptance_criteria.lower() == 'gibbs':
-        _proposal_acceptance_criteria = Gibbs
+        return Gibbs
     elif proposal_acceptance_criteria.lower() == 'metropolis':
-        _proposal_acceptance_criteria = Metropolis
-    else:
-        raise ValueError(f'Unknown proposal_acceptance_criteria: {proposal_acceptance_criteria}')
-    cdef void* _interrupt_function
-    if interrupt_function is None:
-        _interrupt_function = NULL
-    else:
-        _interrupt_function = <void *>interrupt_function
+        return Metropolis
+    raise ValueError(f'Unknown proposal_acceptance_criteria: {proposal_acceptance_criteria}')
 
 
-    with nogil:
-        num = general_simulated_annealing(_states,
-                                          _energies,
-                                          _num_samples,
-                                          _h,
-                                          _coupler_starts,
-                                          _coupler_ends,
-                                          _coupler_weights,
-                                          _sweeps_per_beta,
-                                          _beta_schedule,
-                                          _seed,
-                                          _varorder,
-                                          _proposal_acceptance_criteria,
-                                          interrupt_callback,
-                                          _interrupt_function)
-
-    # discard the noise if we were interrupted
-    return states_numpy[:num], energies_numpy[:num]
+cdef Precision _sweep_precision(precision) except *:
+    if precision == 'double':
+        return DoublePrecision
+    elif precision == 'single':
+        return SinglePrecision
+    elif precision == 'integer':
+        return IntegerPrecision
+    raise ValueError(f'Unknown precision: {precision}')
+
+
+cdef DescentSolver _solver(descent_solver) except *:
+    if descent_solver is None or descent_solver == 'linear':
+        return LinearSearch
+    elif descent_solver == 'tree':
+        return OrderedSet
+    elif descent_solver == 'heap':
+        return IndexedHeap
+    raise ValueError(f'Unknown descent_solver: {descent_solver}')
 
 
 cdef bool interrupt_callback(void * const interrupt_function) noexcept with gil:
@@ -14,55 +14,63 @@
 //
 // ===========================================================================
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <cstdint>
+#include <exception>
+#include <functional>
 #include <math.h>
+#include <mutex>
+#include <type_traits>
 #include <vector>
 #include <stdexcept>
 #include "cpu_sa.h"
+#include "deadline.h"
+#include "pool.h"
+#include "rng.h"
 
 
-// xorshift128+ as defined https://en.wikipedia.org/wiki/Xorshift#xorshift.2B
 #define FASTRAND(rand) do {                       \
-    uint64_t x = rng_state[0];                    \
-    uint64_t const y = rng_state[1];              \
-    rng_state[0] = y;                             \
-    x ^= x << 23;                                 \
-    rng_state[1] = x ^ y ^ (x >> 17) ^ (y >> 26); \
-    rand = rng_state[1] + y;                      \
+    rand = xorshift128p(rng_state);               \
 } while (0)
 
 #define RANDMAX ((uint64_t)-1L)
 
 using namespace std;
 
-// this holds the state of our thread-safe/local RNG
+// this holds the state of our thread-safe/local RNG, see `rng.h`
 thread_local uint64_t rng_state[2];
 
+// Seeds the (thread-local) RNG with one of many independent streams. The state
+// only depends on `seed` and `stream`, so for instance when each sample uses
+// the stream given by its index, the result of a sample does not depend on
+// which thread ran it or on the order in which the samples were taken.
+// @param seed the user provided seed
+// @param stream the index of the stream
+static void seed_rng(const uint64_t seed, uint64_t stream) {
+    seed_stream(rng_state, seed, stream);
+}
+
 // Returns the energy delta from flipping variable at index `var`
 // @param var the index of the variable to flip
 // @param state the current state of all variables
 // @param h vector of h or field value on each variable
-// @param degrees the degree of each variable
-// @param neighbors lists of the neighbors of each variable, such that 
-//     neighbors[i][j] is the jth neighbor of variable i.
-// @param neighbour_couplings same as neighbors, but instead has the J value.
-//     neighbour_couplings[i][j] is the J value or weight on the coupling
-//     between variables i and neighbors[i][j]. 
+// @param adj the adjacency of the problem, see `build_adjacency`
 // @return delta energy
 double get_flip_energy(
     int var,
     std::int8_t *state,
     const vector<double>& h,
-    const vector<int>& degrees,
-    const vector<vector<int>>& neighbors,
-    const vector<vector<double>>& neighbour_couplings
+    const Adjacency& adj
 ) {
     double energy = h[var];
     // iterate over the neighbors of variable `var`
-    for (int n_i = 0; n_i < degrees[var]; n_i++) {
+    for (const Neighbor *n = adj.begin(var), *end = adj.end(var); n != end; n++) {
         // increase `energy` by the state of the neighbor variable * the
         // corresponding coupler weight
-        energy += state[neighbors[var][n_i]] * neighbour_couplings[var][n_i];
+        energy += state[n->var] * n->weight;
     }
     // the value of the variable `energy` is now equal to the sum of the
     // coefficients of `var`.  we then multiply this by -2 * the state of `var`
@@ -71,290 +79,2013 @@ double get_flip_energy(
     return -2 * state[var] * energy;
 }
 
+// Keeps track of the termination criteria of a read, see `Termination`.
+class TerminationMonitor {
+  public:
+    // @param termination the criteria, or null if there are none
+    // @param energy the energy of the initial state of the read, only used if
+    //        `termination->needs_energy()`
+    TerminationMonitor(const Termination *termination, const double energy)
+        : termination_(termination),
+          deadline_(termination && termination->time_limit > 0
+                    ? Deadline(termination->time_limit) : Deadline()),
+          best_energy_(energy) {}
+
+    // Returns true if the read should end.
+    // @param energy the energy of the state after the latest sweep, only
+    //        used if `termination->needs_energy()`
+    bool done(const double energy) {
+        if (!termination_) return false;
+        if (termination_->needs_energy()) {
+            if (energy <= termination_->target_energy) return true;
+            // ignore the rounding errors of the incrementally updated energy
+            if (energy < best_energy_ - 1e-9 * max(1.0, fabs(best_energy_))) {
+                best_energy_ = energy;
+                stalled_sweeps_ = 0;
+            } else if (termination_->stall_sweeps > 0 &&
+                       ++stalled_sweeps_ >= termination_->stall_sweeps) {
+                return true;
+            }
+        }
+        // the clock is only read every so many sweeps, see `Deadline`
+        return deadline_.expired();
+    }
+
+  private:
+    const Termination *termination_;
+    Deadline deadline_;
+    double best_energy_;
+    int stalled_sweeps_ = 0;
+};
+
+// The largest table size, in entries per beta and over all betas, that we are
+// willing to use for the Boltzmann lookup tables.
+static const int MAX_LOOKUP_LEVEL = 1 << 16;
+static const long long MAX_LOOKUP_ENTRIES = 1 << 22;
+
+// Precomputed acceptance thresholds for problems whose biases are all integer
+// multiples of a common quantum q. Then every energy delta is 2 * q * k for a
+// `level` k in [-max_level, max_level], and the values needed by the
+// acceptance tests can be looked up rather than calling exp().
+struct BoltzmannTables {
+    double inv_two_quantum;
+    int max_level;
+    // values[beta_idx * (2 * max_level + 1) + max_level + k] for level k
+    vector<double> values;
+
+    // the table for the given beta, indexed by level
+    const double* row(int beta_idx) const {
+        return values.data() + (size_t)beta_idx * (2 * max_level + 1) + max_level;
+    }
+
+    // the level of an energy delta, rounded to absorb floating point error
+    int level(double delta_energy) const {
+        const double k = delta_energy * inv_two_quantum;
+        return (int)(k >= 0 ? k + .5 : k - .5);
+    }
+};
+
+// Returns the quantum of the biases, i.e. the largest q such that every bias
+// is an integer multiple of q, or 0 if there is none. We only look for
+// quanta of the form (smallest absolute bias) / d for small integers d.
+// @param h vector of h or field value on each variable
+// @param coupler_weights a double vector containing the weights of the couplers
+double bias_quantum(const vector<double>& h, const vector<double>& coupler_weights) {
+    double smallest = INFINITY;
+    for (double bias : h) if (bias) smallest = min(smallest, fabs(bias));
+    for (double bias : coupler_weights) if (bias) smallest = min(smallest, fabs(bias));
+    if (!isfinite(smallest)) return 0;
+
+    auto is_multiple = [](double bias, double quantum) {
+        const double ratio = bias / quantum;
+        return fabs(ratio - round(ratio)) <= 1e-9 * max(1.0, fabs(ratio));
+    };
+
+    for (int d = 1; d <= 16; d++) {
+        const double quantum = smallest / d;
+        bool quantized = true;
+        for (int v = 0; quantized && v < (int)h.size(); v++) {
+            quantized = is_multiple(h[v], quantum);
+        }
+        for (int c = 0; quantized && c < (int)coupler_weights.size(); c++) {
+            quantized = is_multiple(coupler_weights[c], quantum);
+        }
+        if (quantized) return quantum;
+    }
+
+    return 0;
+}
+
+// Returns the default beta range of a problem, as `_default_ising_beta_range`
+// in sampler.py computes it, in a single pass over the adjacency. The hot
+// beta lets the variable of the largest effective field flip with
+// probability 1/2, and the cold beta makes the probability of exciting any of
+// the variables whose smallest nonzero bias is the smallest of all at most
+// `max_single_qubit_excitation_rate`.
+// @param h vector of h or field value on each variable
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @param max_single_qubit_excitation_rate the targeted excitation rate at the
+//        cold beta, in (0, 1)
+// @param scale_T_with_N whether the cold beta grows with the number of
+//        variables of the smallest bias, rather than assuming there is one
+// @return the hot and cold betas, or {0, 0} if all the biases are zero
+pair<double, double> default_beta_range(
+    const vector<double>& h,
+    const Adjacency& adj,
+    const double max_single_qubit_excitation_rate,
+    const bool scale_T_with_N
+) {
+    if (!(0 < max_single_qubit_excitation_rate && max_single_qubit_excitation_rate < 1)) {
+        throw std::invalid_argument(
+            "max_single_qubit_excitation_rate must be in range (0, 1)");
+    }
+
+    // the largest sum of the absolute biases of a variable, and the smallest
+    // of their nonzero values over all variables, with the number of
+    // variables it is the smallest of
+    double max_effective_field = 0;
+    double min_effective_field = INFINITY;
+    int64_t number_min_gaps = 0;
+    for (int var = 0; var < (int)h.size(); var++) {
+        double sum_abs = fabs(h[var]);
+        double min_abs = h[var] ? sum_abs : INFINITY;
+        const Neighbor *end = adj.end(var);
+        for (const Neighbor *n = adj.begin(var); n != end; n++) {
+            const double bias = fabs(n->weight);
+            sum_abs += bias;
+            if (bias) min_abs = min(min_abs, bias);
+        }
+        max_effective_field = max(max_effective_field, sum_abs);
+
+        if (min_abs < min_effective_field) {
+            min_effective_field = min_abs;
+            number_min_gaps = 1;
+        } else if (min_abs == min_effective_field && isfinite(min_abs)) {
+            number_min_gaps++;
+        }
+    }
+
+    if (!isfinite(min_effective_field)) return {0, 0};
+
+    const double hot_beta = log(2.0) / (2 * max_effective_field);
+    if (!scale_T_with_N) number_min_gaps = 1;
+    const double cold_beta = log(number_min_gaps / max_single_qubit_excitation_rate) /
+        (2 * min_effective_field);
+    return {hot_beta, cold_beta};
+}
+
+// Builds the Boltzmann lookup tables for a quantized problem.
+// @param h vector of h or field value on each variable
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @param quantum the quantum of the biases, see `bias_quantum`
+// @param beta_schedule the beta values to build tables for
+// @param tables will be filled in with the tables
+// @return false if the tables would be too large, in which case `tables` is
+//         not usable
+template <Proposal proposal_acceptance_criteria>
+bool build_boltzmann_tables(
+    const vector<double>& h,
+    const Adjacency& adj,
+    const double quantum,
+    const vector<double>& beta_schedule,
+    BoltzmannTables& tables
+) {
+    // the largest |delta energy| / 2 is the largest total absolute bias
+    double max_total = 0;
+    for (int var = 0; var < (int)h.size(); var++) {
+        double total = fabs(h[var]);
+        for (const Neighbor *n = adj.begin(var), *end = adj.end(var); n != end; n++) {
+            total += fabs(n->weight);
+        }
+        max_total = max(max_total, total);
+    }
+
+    const double max_level = ceil(max_total / quantum - 1e-6);
+    if (max_level > MAX_LOOKUP_LEVEL ||
+            (2 * max_level + 1) * beta_schedule.size() > MAX_LOOKUP_ENTRIES) {
+        return false;
+    }
+
+    tables.inv_two_quantum = 1 / (2 * quantum);
+    tables.max_level = max_level;
+    tables.values.resize((2 * tables.max_level + 1) * beta_schedule.size());
+
+    for (int beta_idx = 0; beta_idx < (int)beta_schedule.size(); beta_idx++) {
+        const double beta = beta_schedule[beta_idx];
+        double *row = const_cast<double*>(tables.row(beta_idx));
+        for (int k = -tables.max_level; k <= tables.max_level; k++) {
+            const double delta_energy = 2 * quantum * k;
+            // the same expressions as in simulated_annealing_run, so that
+            // the accepted flips are identical
+            if constexpr (proposal_acceptance_criteria == Metropolis) {
+                row[k] = exp(-delta_energy*beta) * RANDMAX;
+            } else {
+                row[k] = 1+exp(delta_energy*beta);
+            }
+        }
+    }
+
+    return true;
+}
+
+// The number of sweeps after which a single precision run recomputes its
+// delta energies and energy exactly, so that the rounding errors of the
+// updates of the accepted flips do not build up.
+static const int SINGLE_PRECISION_RESYNC_SWEEPS = 64;
+
+// The couplings of a problem in a narrower type than double, for the
+// Sequential and Random sweeps, see `Precision`. The weights, and the delta
+// energies of the sweeps, are those of the problem divided by `scale`.
+template <class Weight>
+struct ReducedProblem {
+    double scale;
+    BasicAdjacency<Weight> adj;
+
+    // the delta energy of the problem in the units of the sweeps
+    Weight units(const double delta_energy) const {
+        if constexpr (std::is_integral<Weight>::value) {
+            return (Weight)llround(delta_energy / scale);
+        } else {
+            return (Weight)(delta_energy / scale);
+        }
+    }
+};
+
+// Copies the adjacency of a problem into one of the given reduced problem,
+// converting each weight to its units.
+template <class Weight>
+static void reduce_adjacency(const Adjacency& adj, ReducedProblem<Weight>& reduced) {
+    reduced.adj.offsets = adj.offsets;
+    reduced.adj.neighbors.resize(adj.neighbors.size());
+    for (size_t i = 0; i < adj.neighbors.size(); i++) {
+        reduced.adj.neighbors[i].var = adj.neighbors[i].var;
+        reduced.adj.neighbors[i].weight = reduced.units(adj.neighbors[i].weight);
+    }
+}
+
+// Builds the integer representation of a quantized problem.
+// @param h vector of h or field value on each variable
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @param quantum the quantum of the biases, see `bias_quantum`
+// @param reduced will be filled in with the representation
+// @return false if there is no quantum or the delta energies could overflow
+//         an int32, in which case `reduced` is not usable
+static bool build_integer_problem(
+    const vector<double>& h,
+    const Adjacency& adj,
+    const double quantum,
+    ReducedProblem<int32_t>& reduced
+) {
+    if (!(quantum > 0)) return false;
+
+    // the largest |delta energy| / 2 is the largest total absolute bias, and
+    // every intermediate value of the updates is a delta energy
+    double max_total = 0;
+    for (int var = 0; var < (int)h.size(); var++) {
+        double total = fabs(h[var]);
+        for (const Neighbor *n = adj.begin(var), *end = adj.end(var); n != end; n++) {
+            total += fabs(n->weight);
+        }
+        max_total = max(max_total, total);
+    }
+    if (2 * ceil(max_total / quantum - 1e-6) > INT32_MAX) return false;
+
+    reduced.scale = quantum;
+    reduce_adjacency(adj, reduced);
+    return true;
+}
+
+// Performs a single sweep of `num_vars` spin updates at a fixed beta.
+// The delta energies and weights are of type `Weight`, in whatever units the
+// caller uses, see `ReducedProblem`.
+// @param state a int8 array where each int8 holds the state of a variable
+// @param delta_energy the delta energy of flipping each variable in `state`,
+//        kept up to date with the accepted flips
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @param num_vars the number of variables in the problem
+// @param beta the beta value to run the sweep at, per unit of delta energy
+// @param table If `lookup` is true, the row of `tables` for `beta`.
+// @param tables If `lookup` is true, the Boltzmann lookup tables to use
+//        instead of calling exp(), see `build_boltzmann_tables`, indexed in
+//        the units of the delta energies.
+// @param counts If not null and counters are enabled, the outcomes of the
+//        proposals of the sweep are added to it.
+// @return the change in energy due to the accepted flips, in the units of the
+//         delta energies
+template <VariableOrder varorder, Proposal proposal_acceptance_criteria, bool lookup,
+          class Weight>
+static inline double annealing_sweep(
+    std::int8_t* state,
+    Weight* delta_energy,
+    const BasicAdjacency<Weight>& adj,
+    const int num_vars,
+    const double beta,
+    const double* table,
+    const BoltzmannTables* tables,
+    ProposalCounts* counts,
+    int64_t& num_flips
+) {
+    uint64_t rand; // this will hold the value of the rng
+    bool flip_spin;
+    double energy_change = 0;
+    ProposalCounts sweep_counts;
+
+    // this threshold will allow us to skip the metropolis update for
+    // variables that have zero chance of getting flipped.
+    // our RNG generates 64 bit integers, so we have a resolution of
+    // 1 / 2^64. since log(1 / 2^64) = -44.361, if the delta energy is
+    // greater than 44.361 / beta, then we can safely skip computing
+    // the probability.
+    const double threshold = 44.36142 / beta;
+    for (int varI = 0; varI < num_vars; varI++) {
+        int var;
+        if constexpr (varorder == Random) {
+            FASTRAND(rand);
+            var = rand%num_vars;
+        } else {
+            var = varI;
+        }
+        if (delta_energy[var] >= threshold) {
+            if constexpr (counters_enabled) sweep_counts.skipped++;
+            continue;
+        }
+
+        flip_spin = false;
+
+        if constexpr (proposal_acceptance_criteria == Metropolis) {
+            // Metropolis-Hastings acceptance rule
+            if (delta_energy[var] <= 0.0) {
+                // automatically accept any flip that results in a lower
+                // energy
+                flip_spin = true;
+            } else {
+                // get a random number, storing it in rand
+                FASTRAND(rand);
+                // accept the flip if exp(-delta_energy*beta) > random(0, 1)
+                if constexpr (lookup) {
+                    flip_spin = table[tables->level(delta_energy[var])] > rand;
+                } else if (exp(-delta_energy[var]*beta) * RANDMAX > rand) {
+                    flip_spin = true;
+                }
+            }
+        }
+        else {
+            // Gibbs update: Sample fairly from the two available states,
+            // independent of the current value
+            FASTRAND(rand);
+            if constexpr (lookup) {
+                flip_spin = RANDMAX > rand * table[tables->level(delta_energy[var])];
+            } else if (RANDMAX > rand * (1+exp(delta_energy[var]*beta))) {
+                flip_spin = true;
+            }
+        }
+
+        if constexpr (counters_enabled) {
+            sweep_counts.accepted += flip_spin;
+            sweep_counts.rejected += !flip_spin;
+        }
+
+        if (flip_spin) {
+            // since we have accepted the spin flip of variable `var`, 
+            // we need to adjust the delta energies of all the 
+            // neighboring variables
+            const std::int8_t multiplier = 4 * state[var];
+            // iterate over the neighbors of `var`
+            const BasicNeighbor<Weight> *end = adj.end(var);
+            for (const BasicNeighbor<Weight> *n = adj.begin(var); n != end; n++) {
+                const int neighbor = n->var;
+                // adjust the delta energy by 
+                // 4 * `var` state * coupler weight * neighbor state
+                // the 4 is because the original contribution from 
+                // `var` to the neighbor's delta energy was
+                // 2 * `var` state * coupler weight * neighbor state,
+                // so since we are flipping `var`'s state, we need to 
+                // multiply it again by 2 to get the full offset.
+                delta_energy[neighbor] += multiplier * 
+                    n->weight * state[neighbor];
+            }
+
+            // now we just need to flip its state and negate its delta 
+            // energy
+            energy_change += delta_energy[var];
+            state[var] *= -1;
+            delta_energy[var] *= -1;
+            num_flips++;
+        }
+    }
+
+    if constexpr (counters_enabled) {
+        if (counts) *counts += sweep_counts;
+    }
+
+    return energy_change;
+}
+
 // Performs a single run of simulated annealing with the given inputs.
 // @param state a int8 array where each int8 holds the state of a
 //        variable. Note that this will be used as the initial state of the
 //        run.
 // @param h vector of h or field value on each variable
-// @param degrees the degree of each variable
-// @param neighbors lists of the neighbors of each variable, such that 
-//        neighbors[i][j] is the jth neighbor of variable i. Note
-// @param neighbour_couplings same as neighbors, but instead has the J value.
-//        neighbour_couplings[i][j] is the J value or weight on the coupling
-//        between variables i and neighbors[i][j]. 
+// @param adj the adjacency of the problem, see `build_adjacency`
 // @param sweeps_per_beta The number of sweeps to perform at each beta value.
 //        Total number of sweeps is `sweeps_per_beta` * length of
 //        `beta_schedule`.
 // @param beta_schedule A list of the beta values to run `sweeps_per_beta`
 //        sweeps at.
-// @return Nothing, but `state` now contains the result of the run.
-template <VariableOrder varorder, Proposal proposal_acceptance_criteria>
-void simulated_annealing_run(
+// @param tables If `lookup` is true, the Boltzmann lookup tables to use
+//        instead of calling exp(), see `build_boltzmann_tables`.
+// @param termination If not null, the criteria for ending the run early.
+// @param delta_energy_vector Scratch space for the delta energy of flipping
+//        each variable. On return it holds those of the final `state`.
+// @param counts If not null and counters are enabled, the outcomes of the
+//        proposals at each beta are added to counts[beta_idx].
+// @param min_acceptance If positive, the schedule is walked adaptively: after
+//        the sweeps at a beta where fewer than `min_acceptance` of the
+//        proposals were accepted, the run steps twice as far through the
+//        schedule as it last did, and otherwise it steps to the next beta.
+//        A state that hardly moves at a beta hardly moves at the colder ones
+//        either, so this spends fewer sweeps where nothing happens. The last
+//        beta of the schedule is always swept.
+// @param reduced Unless `Weight` is double, the problem in the precision of the
+//        sweeps, see `ReducedProblem`. Its delta energies are kept apart from
+//        `delta_energy_vector`, which is only filled in at the end, exactly.
+//        Those of a single precision run are recomputed exactly every
+//        `SINGLE_PRECISION_RESYNC_SWEEPS` sweeps.
+// @return The energy of the final state, kept track of from the delta energies
+//         of the flips (and recomputed at the end of a reduced precision run);
+//         `state` now contains the result of the run.
+template <VariableOrder varorder, Proposal proposal_acceptance_criteria, bool lookup,
+          class Weight = double>
+double simulated_annealing_run(
     std::int8_t* state,
     const vector<double>& h,
-    const vector<int>& degrees,
-    const vector<vector<int>>& neighbors,
-    const vector<vector<double>>& neighbour_couplings,
+    const Adjacency& adj,
     const int sweeps_per_beta,
-    const vector<double>& beta_schedule
+    const vector<double>& beta_schedule,
+    const BoltzmannTables* tables,
+    const Termination* termination,
+    vector<double>& delta_energy_vector,
+    ProposalCounts* counts,
+    const double min_acceptance,
+    const ReducedProblem<Weight>* reduced = nullptr
 ) {
+    static const bool exact = std::is_same<Weight, double>::value;
     const int num_vars = h.size();
+    const int last_beta = (int)beta_schedule.size() - 1;
 
     // this double array will hold the delta energy for every variable
     // delta_energy[v] is the delta energy for variable `v`
-    double *delta_energy = (double*)malloc(num_vars * sizeof(double));
-
-    uint64_t rand; // this will hold the value of the rng
+    delta_energy_vector.resize(num_vars);
 
     // build the delta_energy array by getting the delta energy for each
-    // variable
-    for (int var = 0; var < num_vars; var++) {
-        delta_energy[var] = get_flip_energy(var, state, h, degrees,
-                                            neighbors, neighbour_couplings);
+    // variable, and the energy of `state`, which follows from them
+    double energy;
+    auto compute_delta_energy = [&]() {
+        for (int var = 0; var < num_vars; var++) {
+            delta_energy_vector[var] = get_flip_energy(var, state, h, adj);
+        }
+        energy = state_energy_from_flip_energies(state, h, delta_energy_vector.data());
+    };
+    compute_delta_energy();
+
+    // the delta energies and the adjacency that the sweeps update them from
+    Weight *delta_energy;
+    const BasicAdjacency<Weight> *sweep_adj;
+    vector<Weight> reduced_delta_energy;
+    double scale = 1;
+    auto reduce_delta_energy = [&]() {
+        for (int var = 0; var < num_vars; var++) {
+            delta_energy[var] = reduced->units(delta_energy_vector[var]);
+        }
+    };
+    if constexpr (exact) {
+        delta_energy = delta_energy_vector.data();
+        sweep_adj = &adj;
+    } else {
+        reduced_delta_energy.resize(num_vars);
+        delta_energy = reduced_delta_energy.data();
+        sweep_adj = &reduced->adj;
+        scale = reduced->scale;
+        reduce_delta_energy();
     }
+    int sweeps_since_resync = 0;
+
+    // every sweep returns the change of the energy
+    TerminationMonitor monitor(termination, energy);
+    bool done = false;
 
-    bool flip_spin;
     // perform the sweeps
-    for (int beta_idx = 0; beta_idx < (int)beta_schedule.size(); beta_idx++) {
+    int step = 1;
+    for (int beta_idx = 0; beta_idx <= last_beta && !done; beta_idx += step) {
         // get the beta value for this sweep
         const double beta = beta_schedule[beta_idx];
-        for (int sweep = 0; sweep < sweeps_per_beta; sweep++) {
-
-            // this threshold will allow us to skip the metropolis update for
-            // variables that have zero chance of getting flipped.
-            // our RNG generates 64 bit integers, so we have a resolution of
-            // 1 / 2^64. since log(1 / 2^64) = -44.361, if the delta energy is
-            // greater than 44.361 / beta, then we can safely skip computing
-            // the probability.
-            const double threshold = 44.36142 / beta;
-            for (int varI = 0; varI < num_vars; varI++) {
-                int var;
-                if constexpr (varorder == Random) {
-                    FASTRAND(rand);
-                    var = rand%num_vars;
-                } else {
-                    var = varI;
+        const double *table = nullptr;
+        if constexpr (lookup) table = tables->row(beta_idx);
+        ProposalCounts *beta_counts = counts ? counts + beta_idx : nullptr;
+        int64_t num_flips = 0;
+        int sweep = 0;
+        for (; sweep < sweeps_per_beta && !done; sweep++) {
+            energy += scale * annealing_sweep<varorder, proposal_acceptance_criteria, lookup>(
+                state, delta_energy, *sweep_adj, num_vars, beta * scale, table, tables,
+                beta_counts, num_flips);
+            if constexpr (std::is_floating_point<Weight>::value && !exact) {
+                if (++sweeps_since_resync == SINGLE_PRECISION_RESYNC_SWEEPS) {
+                    compute_delta_energy();
+                    reduce_delta_energy();
+                    sweeps_since_resync = 0;
                 }
-                if (delta_energy[var] >= threshold) continue;
+            }
+            done = monitor.done(energy);
+        }
 
-                flip_spin = false;
+        if (min_acceptance > 0) {
+            const bool frozen = num_flips < min_acceptance * sweep * num_vars;
+            step = frozen ? 2 * step : 1;
+            if (beta_idx < last_beta) step = min(step, last_beta - beta_idx);
+        }
+    }
 
-                if constexpr (proposal_acceptance_criteria == Metropolis) {
-                    // Metropolis-Hastings acceptance rule
-                    if (delta_energy[var] <= 0.0) {
-                        // automatically accept any flip that results in a lower
-                        // energy
-                        flip_spin = true;
-                    } else {
-                        // get a random number, storing it in rand
-                        FASTRAND(rand);
-                        // accept the flip if exp(-delta_energy*beta) > random(0, 1)
-                        if (exp(-delta_energy[var]*beta) * RANDMAX > rand) {
-                            flip_spin = true;
-                        }
-                    }
-                }
-                else {
-                    // Gibbs update: Sample fairly from the two available states,
-                    // independent of the current value
-                    FASTRAND(rand);
-                    if (RANDMAX > rand * (1+exp(delta_energy[var]*beta))) {
-                        flip_spin = true;
-                    }
-                }
+    if constexpr (!exact) compute_delta_energy();
 
-                if (flip_spin) {
-                    // since we have accepted the spin flip of variable `var`, 
-                    // we need to adjust the delta energies of all the 
-                    // neighboring variables
-                    const std::int8_t multiplier = 4 * state[var];
-                    // iterate over the neighbors of `var`
-                    for (int n_i = 0; n_i < degrees[var]; n_i++) {
-                        int neighbor = neighbors[var][n_i];
-                        // adjust the delta energy by 
-                        // 4 * `var` state * coupler weight * neighbor state
-                        // the 4 is because the original contribution from 
-                        // `var` to the neighbor's delta energy was
-                        // 2 * `var` state * coupler weight * neighbor state,
-                        // so since we are flipping `var`'s state, we need to 
-                        // multiply it again by 2 to get the full offset.
-                        delta_energy[neighbor] += multiplier * 
-                            neighbour_couplings[var][n_i] * state[neighbor];
-                    }
+    return energy;
+}
 
-                    // now we just need to flip its state and negate its delta 
-                    // energy
-                    state[var] *= -1;
-                    delta_energy[var] *= -1;
-                }
-            }
-        }
+// Calls `simulated_annealing_run`, using the Boltzmann lookup tables if there
+// are any.
+template <VariableOrder varorder, Proposal proposal_acceptance_criteria, class Weight>
+double lookup_annealing_run(
+    std::int8_t* state,
+    const vector<double>& h,
+    const Adjacency& adj,
+    const int sweeps_per_beta,
+    const vector<double>& beta_schedule,
+    const BoltzmannTables* tables,
+    const Termination* termination,
+    vector<double>& delta_energy,
+    ProposalCounts* counts,
+    const double min_acceptance,
+    const ReducedProblem<Weight>* reduced
+) {
+    if (tables) {
+        return simulated_annealing_run<varorder, proposal_acceptance_criteria, true>(
+            state, h, adj, sweeps_per_beta, beta_schedule, tables, termination,
+            delta_energy, counts, min_acceptance, reduced);
+    } else {
+        return simulated_annealing_run<varorder, proposal_acceptance_criteria, false>(
+            state, h, adj, sweeps_per_beta, beta_schedule, nullptr, termination,
+            delta_energy, counts, min_acceptance, reduced);
     }
-
-    free(delta_energy);
 }
 
-// Returns the energy of a given state and problem
-// @param state a int8 array containing the spin state to compute the energy of
-// @param h vector of h or field value on each variable
-// @param coupler_starts an int vector containing the variables of one side of
-//        each coupler in the problem
-// @param coupler_ends an int vector containing the variables of the other side 
-//        of each coupler in the problem
-// @param coupler_weights a double vector containing the weights of the 
-//        couplers in the same order as coupler_starts and coupler_ends
-// @return A double corresponding to the energy for `state` on the problem
-//        defined by h and the couplers passed in
-double get_state_energy(
+// Calls `lookup_annealing_run` in integer precision if `integer` is given, in
+// single precision if `single` is, and in double precision otherwise.
+template <VariableOrder varorder, Proposal proposal_acceptance_criteria>
+double scalar_annealing_run(
     std::int8_t* state,
     const vector<double>& h,
-    const vector<int>& coupler_starts,
-    const vector<int>& coupler_ends,
-    const vector<double>& coupler_weights
+    const Adjacency& adj,
+    const int sweeps_per_beta,
+    const vector<double>& beta_schedule,
+    const BoltzmannTables* tables,
+    const Termination* termination,
+    vector<double>& delta_energy,
+    ProposalCounts* counts,
+    const double min_acceptance,
+    const ReducedProblem<float>* single,
+    const ReducedProblem<int32_t>* integer
 ) {
-    double energy = 0.0;
-    // sum the energy due to local fields on variables
-    for (unsigned int var = 0; var < h.size(); var++) {
-        energy += state[var] * h[var];
+    if (integer) {
+        return lookup_annealing_run<varorder, proposal_acceptance_criteria>(
+            state, h, adj, sweeps_per_beta, beta_schedule, tables, termination,
+            delta_energy, counts, min_acceptance, integer);
+    } else if (single) {
+        return lookup_annealing_run<varorder, proposal_acceptance_criteria>(
+            state, h, adj, sweeps_per_beta, beta_schedule, tables, termination,
+            delta_energy, counts, min_acceptance, single);
+    } else {
+        return lookup_annealing_run<varorder, proposal_acceptance_criteria, double>(
+            state, h, adj, sweeps_per_beta, beta_schedule, tables, termination,
+            delta_energy, counts, min_acceptance, nullptr);
     }
-    // sum the energy due to coupling weights
-    for (unsigned int c = 0; c < coupler_starts.size(); c++) {
-        energy += state[coupler_starts[c]] * coupler_weights[c] * state[coupler_ends[c]];
+}
+
+// Returns a greedy coloring of the variables, such that no two variables of
+// the same color are adjacent. Variables are colored in order, each getting
+// the smallest color not already used by one of its neighbors.
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @return the color classes, i.e. classes[c] is the list of the variables of
+//         color c, in increasing order
+vector<vector<int>> greedy_coloring(const Adjacency& adj) {
+    const int num_vars = adj.offsets.size() - 1;
+
+    vector<int> color(num_vars, -1);
+    vector<vector<int>> classes;
+
+    // blocked[c] == var means that color c is used by a neighbor of var
+    vector<int> blocked;
+
+    for (int var = 0; var < num_vars; var++) {
+        for (const Neighbor *n = adj.begin(var), *end = adj.end(var); n != end; n++) {
+            if (color[n->var] >= 0) blocked[color[n->var]] = var;
+        }
+
+        int c = 0;
+        while (c < (int)classes.size() && blocked[c] == var) c++;
+        if (c == (int)classes.size()) {
+            classes.emplace_back();
+            blocked.push_back(-1);
+        }
+
+        color[var] = c;
+        classes[c].push_back(var);
     }
-    return energy;
+
+    return classes;
 }
 
-// Perform simulated annealing on a general problem
-// @param states a int8 array of size num_samples * number of variables in the
-//        problem. Will be overwritten by this function as samples are filled
-//        in. The initial state of the samples are used to seed the simulated
-//        annealing runs.
-// @param energies a double array of size num_samples. Will be overwritten by
-//        this function as energies are filled in.
-// @param num_samples the number of samples to get.
+// Runtime dispatch for the vectorized kernels. On x86-64 glibc with GCC or
+// clang, one clone of each kernel is compiled per instruction set and the best
+// one supported by the CPU is selected when the module is loaded (this relies
+// on ifunc support). Elsewhere only the default is compiled, which for
+// instance on aarch64 uses NEON.
+#if defined(__x86_64__) && defined(__GLIBC__) && (defined(__GNUC__) || defined(__clang__))
+#define SA_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SA_TARGET_CLONES
+#endif
+
+// GCC does not vectorize loops at -O2 before version 12, so ask for it
+#if defined(__GNUC__) && !defined(__clang__)
+#define SA_VECTORIZE __attribute__((optimize("tree-vectorize")))
+#else
+#define SA_VECTORIZE
+#endif
+
+// The number of variables whose acceptance is evaluated at once
+static const int BLOCK_SIZE = 256;
+
+// Returns exp(x) for x in [-700, 700], with a relative error of about 1e-12.
+// Unlike the standard library's exp this can be inlined into a vectorized
+// loop. We write exp(x) = 2^n * exp(r) with n = round(x / ln(2)), so that
+// |r| <= ln(2) / 2 and a degree 10 Taylor polynomial suffices for exp(r).
+static inline double fast_exp(const double x) {
+    // adding 1.5 * 2^52 rounds to the nearest integer, leaving it in the
+    // low bits of the mantissa
+    const double shift = 0x1.8p52;
+    const double t = x * 1.4426950408889634 + shift;
+    const double n = t - shift;
+
+    // ln(2) split into a high and low part so that n * ln2_hi is exact
+    const double r = (x - n * 0.6931471803691238) - n * 1.9082149292705877e-10;
+
+    double p = 1 / 3628800.;
+    p = p * r + 1 / 362880.;
+    p = p * r + 1 / 40320.;
+    p = p * r + 1 / 5040.;
+    p = p * r + 1 / 720.;
+    p = p * r + 1 / 120.;
+    p = p * r + 1 / 24.;
+    p = p * r + 1 / 6.;
+    p = p * r + .5;
+    p = p * r + 1;
+    p = p * r + 1;
+
+    // build 2^n from its bits
+    uint64_t t_bits, shift_bits;
+    memcpy(&t_bits, &t, sizeof(t));
+    memcpy(&shift_bits, &shift, sizeof(shift));
+    const uint64_t scale_bits = (t_bits - shift_bits + 1023) << 52;
+    double scale;
+    memcpy(&scale, &scale_bits, sizeof(scale));
+
+    return p * scale;
+}
+
+// Sets accept[i] iff a flip with energy delta delta_energy[i] is accepted
+// according to the Metropolis-Hastings criteria, given uniform random numbers
+// in [0, 1).
+SA_TARGET_CLONES SA_VECTORIZE
+static void metropolis_accept(
+    const int n,
+    const double beta,
+    const double *delta_energy,
+    const double *uniform,
+    std::uint8_t *accept
+) {
+    // clamp the energy deltas rather than the exponents, which lets GCC
+    // vectorize the loop without -fno-trapping-math
+    const double max_delta = 700 / beta;
+    for (int i = 0; i < n; i++) {
+        double delta = delta_energy[i];
+        // downhill flips get probability 1
+        delta = delta > 0 ? delta : 0;
+        delta = delta < max_delta ? delta : max_delta;
+        accept[i] = uniform[i] < fast_exp(-beta * delta);
+    }
+}
+
+// Same as `metropolis_accept`, but according to the Gibbs criteria
+SA_TARGET_CLONES SA_VECTORIZE
+static void gibbs_accept(
+    const int n,
+    const double beta,
+    const double *delta_energy,
+    const double *uniform,
+    std::uint8_t *accept
+) {
+    const double max_delta = 700 / beta;
+    for (int i = 0; i < n; i++) {
+        double delta = delta_energy[i];
+        delta = delta > -max_delta ? delta : -max_delta;
+        delta = delta < max_delta ? delta : max_delta;
+        accept[i] = uniform[i] * (1 + fast_exp(beta * delta)) < 1;
+    }
+}
+
+// Flips variable `var`, updating the delta energies of it and its neighbors
+static inline void flip_variable(
+    const int var,
+    std::int8_t *state,
+    double *delta_energy,
+    const Adjacency& adj
+) {
+    // see simulated_annealing_run
+    const std::int8_t multiplier = 4 * state[var];
+    const Neighbor *end = adj.end(var);
+    for (const Neighbor *n = adj.begin(var); n != end; n++) {
+        delta_energy[n->var] += multiplier * n->weight * state[n->var];
+    }
+    state[var] *= -1;
+    delta_energy[var] *= -1;
+}
+
+// Adds the outcomes of the `n` proposals of a block to `counts`
+static inline void count_block(
+    const int n,
+    const std::uint8_t *accept,
+    ProposalCounts& counts
+) {
+    int accepted = 0;
+    for (int i = 0; i < n; i++) accepted += accept[i];
+    counts.accepted += accepted;
+    counts.rejected += n - accepted;
+}
+
+// Performs a single run of simulated annealing, updating the variables one
+// color class at a time. Because variables of the same color are never
+// adjacent, flipping one does not change the delta energy of the others, so
+// the acceptance of a whole block of them can be evaluated at once with
+// vector instructions.
+// @param state a int8 array where each int8 holds the state of a
+//        variable. Note that this will be used as the initial state of the
+//        run.
 // @param h vector of h or field value on each variable
-// @param coupler_starts an int vector containing the variables of one side of
-//        each coupler in the problem
-// @param coupler_ends an int vector containing the variables of the other side 
-//        of each coupler in the problem
-// @param coupler_weights a double vector containing the weights of the couplers
-//        in the same order as coupler_starts and coupler_ends
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @param classes the color classes of the variables, see `greedy_coloring`
 // @param sweeps_per_beta The number of sweeps to perform at each beta value.
 //        Total number of sweeps is `sweeps_per_beta` * length of
 //        `beta_schedule`.
 // @param beta_schedule A list of the beta values to run `sweeps_per_beta`
 //        sweeps at.
-// @param interrupt_callback A function that is invoked between each run of simulated annealing
-//        if the function returns True then it will stop running.
-// @param interrupt_function A pointer to contents that are passed to interrupt_callback.
-// @return the number of samples taken. If no interrupt occured, will equal num_samples.
-int general_simulated_annealing(
-    std::int8_t* states,
-    double* energies,
-    const int num_samples,
-    const vector<double> h,
-    const vector<int> coupler_starts,
-    const vector<int> coupler_ends,
-    const vector<double> coupler_weights,
+// @param termination If not null, the criteria for ending the run early.
+// @param delta_energy Scratch space for the delta energy of flipping each
+//        variable. On return it holds those of the final `state`.
+// @param counts see `simulated_annealing_run`. Every proposal is evaluated,
+//        so none are skipped.
+// @return The energy of the final state, see `simulated_annealing_run`;
+//         `state` now contains the result of the run.
+template <Proposal proposal_acceptance_criteria>
+double colored_annealing_run(
+    std::int8_t* state,
+    const vector<double>& h,
+    const Adjacency& adj,
+    const vector<vector<int>>& classes,
     const int sweeps_per_beta,
-    const vector<double> beta_schedule,
-    const uint64_t seed,
-    const VariableOrder varorder,
-    const Proposal proposal_acceptance_criteria,
-    callback interrupt_callback,
-    void * const interrupt_function
+    const vector<double>& beta_schedule,
+    const Termination* termination,
+    vector<double>& delta_energy,
+    ProposalCounts* counts
 ) {
-    // TODO 
-    // assert len(states) == num_samples*num_vars*sizeof(int8_t)
-    // assert len(coupler_starts) == len(coupler_ends) == len(coupler_weights)
-    // assert max(coupler_starts + coupler_ends) < num_vars
-    
-    // the number of variables in the problem
     const int num_vars = h.size();
-    if (!((coupler_starts.size() == coupler_ends.size()) &&
-                (coupler_starts.size() == coupler_weights.size()))) {
-        throw runtime_error("coupler vectors have mismatched lengths");
+
+    delta_energy.resize(num_vars);
+    for (int var = 0; var < num_vars; var++) {
+        delta_energy[var] = get_flip_energy(var, state, h, adj);
     }
-    
-    // set the seed of the RNG
-    // note that xorshift+ requires a non-zero seed
-    rng_state[0] = seed ? seed : RANDMAX;
-    rng_state[1] = 0;
 
-    // degrees will be a vector of the degrees of each variable
-    vector<int> degrees(num_vars, 0);
-    // neighbors is a vector of vectors, such that neighbors[i][j] is the jth
-    // neighbor of variable i
-    vector<vector<int>> neighbors(num_vars);
-    // neighbour_couplings is another vector of vectors with the same structure
-    // except neighbour_couplings[i][j] is the weight on the coupling between i
-    // and its jth neighbor
-    vector<vector<double>> neighbour_couplings(num_vars);
+    double block_delta_energy[BLOCK_SIZE];
+    double uniform[BLOCK_SIZE];
+    std::uint8_t accept[BLOCK_SIZE];
+    uint64_t rand;
 
-    // build the degrees, neighbors, and neighbour_couplings vectors by
-    // iterating over the inputted coupler vectors
-    for (unsigned int cplr = 0; cplr < coupler_starts.size(); cplr++) {
-        int u = coupler_starts[cplr];
-        int v = coupler_ends[cplr];
+    double energy = state_energy_from_flip_energies(state, h, delta_energy.data());
+    TerminationMonitor monitor(termination, energy);
+    bool done = false;
 
-        if ((u < 0) || (v < 0) || (u >= num_vars) || (v >= num_vars)) {
-            throw runtime_error("coupler indexes contain an invalid variable");
-        }
+    for (int beta_idx = 0; beta_idx < (int)beta_schedule.size() && !done; beta_idx++) {
+        const double beta = beta_schedule[beta_idx];
+        for (int sweep = 0; sweep < sweeps_per_beta && !done; sweep++) {
+            for (const vector<int>& vars : classes) {
+                for (int first = 0; first < (int)vars.size(); first += BLOCK_SIZE) {
+                    const int *block = vars.data() + first;
+                    const int n = min(BLOCK_SIZE, (int)vars.size() - first);
 
-        // add v to u's neighbors list and vice versa
-        neighbors[u].push_back(v);
-        neighbors[v].push_back(u);
-        // add the weights
-        neighbour_couplings[u].push_back(coupler_weights[cplr]);
-        neighbour_couplings[v].push_back(coupler_weights[cplr]);
+                    for (int i = 0; i < n; i++) {
+                        block_delta_energy[i] = delta_energy[block[i]];
+                        FASTRAND(rand);
+                        // the top 53 bits, as a double in [0, 1)
+                        uniform[i] = (rand >> 11) * 0x1.0p-53;
+                    }
 
-        // increase the degrees of both variables
-        degrees[u]++;
-        degrees[v]++;
-    }
+                    if constexpr (proposal_acceptance_criteria == Metropolis) {
+                        metropolis_accept(n, beta, block_delta_energy, uniform, accept);
+                    } else {
+                        gibbs_accept(n, beta, block_delta_energy, uniform, accept);
+                    }
 
+                    for (int i = 0; i < n; i++) {
+                        if (accept[i]) {
+                            energy += delta_energy[block[i]];
+                            flip_variable(block[i], state, delta_energy.data(), adj);
+                        }
+                    }
 
-    // get the simulated annealing samples
-    int sample = 0;
-    while (sample < num_samples) {
-        // states is a giant spin array that will hold the resulting states for
-        // all the samples, so we need to get the location inside that vector
-        // where we will store the sample for this sample
-        std::int8_t *state = states + sample*num_vars;
-        // then do the actual sample. this function will modify state, storing
-        // the sample there
-	// Branching here is designed to make expicit compile time optimizations
-        if (varorder == Random) {
-            if (proposal_acceptance_criteria == Metropolis) {
-                simulated_annealing_run<Random, Metropolis>(state, h, degrees,
-                                                    neighbors, neighbour_couplings,
-                                                    sweeps_per_beta, beta_schedule);
-            } else {
-                simulated_annealing_run<Random, Gibbs>(state, h, degrees,
-                                                     neighbors, neighbour_couplings,
-                                                     sweeps_per_beta, beta_schedule);
-          }
-        } else {
-            if (proposal_acceptance_criteria == Metropolis) {
-                simulated_annealing_run<Sequential, Metropolis>(state, h, degrees,
-                                                     neighbors, neighbour_couplings,
-                                                     sweeps_per_beta, beta_schedule);
-            } else {
-                simulated_annealing_run<Sequential, Gibbs>(state, h, degrees,
-                                                      neighbors, neighbour_couplings,
-                                                      sweeps_per_beta, beta_schedule);
+                    if constexpr (counters_enabled) {
+                        if (counts) count_block(n, accept, counts[beta_idx]);
+                    }
+                }
             }
+            done = monitor.done(energy);
         }
-        // compute the energy of the sample and store it in `energies`
-        energies[sample] = get_state_energy(state, h, coupler_starts, 
-                                            coupler_ends, coupler_weights);
+    }
+
+    return energy;
+}
+
+// The threads used to update the blocks of a color class in parallel: the
+// calling thread and workers of the shared pool, see pool.h.
+class BlockPool {
+  public:
+    // @param num_threads the total number of threads, including the caller
+    explicit BlockPool(const int num_threads) : num_threads_(num_threads) {}
+
+    // Calls `task(block)` for each block in [0, num_blocks), returning once
+    // all of the calls are done. `task` must not throw.
+    void run(const int num_blocks, const function<void(int)>& task) {
+        atomic<int> next_block(0);
+        auto work = [&]() {
+            int block;
+            while ((block = next_block++) < num_blocks) task(block);
+        };
+        run_parallel(min(num_threads_, num_blocks), work);
+    }
+
+  private:
+    const int num_threads_;
+};
+
+// Same as `colored_annealing_run`, but the blocks of each color class are
+// updated in parallel on `pool`. Each variable's energy delta is computed
+// from the states of its neighbors just before it is updated, rather than
+// being kept up to date on every flip, so that threads only ever write the
+// states of their own block. Every block of every sweep draws from its own
+// RNG stream, so the result does not depend on the number of threads.
+// @param state see `colored_annealing_run`
+// @param h see `colored_annealing_run`
+// @param adj see `colored_annealing_run`
+// @param classes see `colored_annealing_run`
+// @param sweeps_per_beta see `colored_annealing_run`
+// @param beta_schedule see `colored_annealing_run`
+// @param pool the threads to update the blocks with
+// @param termination If not null, the criteria for ending the run early.
+// @param counts see `colored_annealing_run`
+// @return The energy of the final state. The variables of a color class are
+//         not coupled, so the energy changes of the blocks of a class add up;
+//         `state` now contains the result of the run.
+template <Proposal proposal_acceptance_criteria>
+double parallel_colored_annealing_run(
+    std::int8_t* state,
+    const vector<double>& h,
+    const Adjacency& adj,
+    const vector<vector<int>>& classes,
+    const int sweeps_per_beta,
+    const vector<double>& beta_schedule,
+    BlockPool& pool,
+    const Termination* termination,
+    ProposalCounts* counts
+) {
+    // the key for this run's block streams, drawn from the sample's stream
+    uint64_t key;
+    FASTRAND(key);
+
+    // counts the color class updates, identifying the current one
+    uint64_t step = 0;
+    double beta;
+    const vector<int> *vars;
+
+    // the energy change of each block of the current color class
+    size_t max_blocks = 0;
+    for (const vector<int>& color_class : classes) {
+        max_blocks = max(max_blocks, (color_class.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    }
+    vector<double> block_energy_change(max_blocks);
+    // and the outcomes of its proposals
+    vector<ProposalCounts> block_counts(counters_enabled && counts ? max_blocks : 0);
+
+    const function<void(int)> update_block = [&](const int b) {
+        // only the first `n` entries are used, but the compiler cannot see
+        // that through the accept kernels
+        double block_delta_energy[BLOCK_SIZE] = {};
+        double uniform[BLOCK_SIZE] = {};
+        std::uint8_t accept[BLOCK_SIZE];
+        uint64_t rand;
+
+        seed_rng(key, (step << 32) | b);
+
+        const int *block = vars->data() + b * BLOCK_SIZE;
+        const int n = min(BLOCK_SIZE, (int)vars->size() - b * BLOCK_SIZE);
+
+        for (int i = 0; i < n; i++) {
+            block_delta_energy[i] = get_flip_energy(block[i], state, h, adj);
+            FASTRAND(rand);
+            uniform[i] = (rand >> 11) * 0x1.0p-53;
+        }
+
+        if constexpr (proposal_acceptance_criteria == Metropolis) {
+            metropolis_accept(n, beta, block_delta_energy, uniform, accept);
+        } else {
+            gibbs_accept(n, beta, block_delta_energy, uniform, accept);
+        }
+
+        double energy_change = 0;
+        for (int i = 0; i < n; i++) {
+            if (accept[i]) {
+                energy_change += block_delta_energy[i];
+                state[block[i]] *= -1;
+            }
+        }
+        block_energy_change[b] = energy_change;
+        if constexpr (counters_enabled) {
+            if (counts) {
+                block_counts[b] = ProposalCounts();
+                count_block(n, accept, block_counts[b]);
+            }
+        }
+    };
+
+    double energy = get_state_energy(state, h, adj);
+    TerminationMonitor monitor(termination, energy);
+    bool done = false;
+
+    for (int beta_idx = 0; beta_idx < (int)beta_schedule.size() && !done; beta_idx++) {
+        beta = beta_schedule[beta_idx];
+        for (int sweep = 0; sweep < sweeps_per_beta && !done; sweep++) {
+            for (const vector<int>& color_class : classes) {
+                vars = &color_class;
+                const int num_blocks = (color_class.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+                pool.run(num_blocks, update_block);
+                step++;
+                // summed in block order, so the energy does not depend on
+                // the number of threads
+                for (int b = 0; b < num_blocks; b++) energy += block_energy_change[b];
+                if constexpr (counters_enabled) {
+                    if (counts) {
+                        for (int b = 0; b < num_blocks; b++) counts[beta_idx] += block_counts[b];
+                    }
+                }
+            }
+            done = monitor.done(energy);
+        }
+    }
+
+    return energy;
+}
+
+// The multi-spin coding engine anneals 64 independent replicas (samples) of
+// the same problem at once. Bit `r` of `spins[v]` is set iff variable `v` is
+// +1 in replica `r`, so a single bitwise operation acts on all replicas.
+//
+// It only supports problems with small integer biases. Treating each linear
+// bias as a coupling to a fixed +1 spin, the energy delta of flipping `v` is
+// 2 * (total[v] - 2 * U), where total[v] is the sum of the absolute biases on
+// `v` and U is the sum of the absolute biases of the unsatisfied (positive
+// energy) couplings of `v`. U is accumulated for all replicas as a bit-sliced
+// integer, then each replica accepts or rejects the flip independently.
+static const int NUM_REPLICAS = 64;
+
+// the largest total bias on a variable supported by the multi-spin engine
+static const int MULTI_SPIN_MAX_TOTAL = 255;
+static const int MULTI_SPIN_MAX_PLANES = 8;
+
+// used in the acceptance tables, means the flip is always accepted
+static const uint64_t ALWAYS_ACCEPT = (uint64_t)1 << 32;
+
+// A coupling of a variable in the multi-spin engine
+struct MultiSpinBond {
+    std::int32_t var;
+    std::uint32_t weight;  // absolute value of the bias
+    uint64_t flip;         // all bits set if the bias is positive, else zero
+};
+
+struct MultiSpinProblem {
+    int max_total;
+    int num_planes;
+    vector<int> total;
+    // the linear biases as couplings to a fixed +1 spin
+    vector<std::uint32_t> h_weight;
+    vector<uint64_t> h_flip;
+    // CSR adjacency as in `Adjacency`
+    vector<int> offsets;
+    vector<MultiSpinBond> bonds;
+};
+
+// Converts a problem to the representation used by the multi-spin engine.
+// @param h vector of h or field value on each variable
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @param problem will be filled in with the converted problem
+// @return false if the problem cannot be represented, i.e. it has biases that
+//         are not integers or a variable's total bias is too large.
+bool build_multi_spin_problem(
+    const vector<double>& h,
+    const Adjacency& adj,
+    MultiSpinProblem& problem
+) {
+    const int num_vars = h.size();
+
+    // converts a bias to its absolute value, returning false if that cannot
+    // be done exactly
+    auto to_weight = [](double bias, std::uint32_t& weight) {
+        const double magnitude = fabs(bias);
+        if (!(magnitude <= MULTI_SPIN_MAX_TOTAL) || magnitude != floor(magnitude)) {
+            return false;
+        }
+        weight = (std::uint32_t)magnitude;
+        return true;
+    };
+
+    problem.max_total = 0;
+    problem.total.assign(num_vars, 0);
+    problem.h_weight.resize(num_vars);
+    problem.h_flip.resize(num_vars);
+    problem.offsets = adj.offsets;
+    problem.bonds.resize(adj.neighbors.size());
+
+    for (int v = 0; v < num_vars; v++) {
+        std::uint32_t weight;
+        if (!to_weight(h[v], weight)) return false;
+
+        // a positive h is unsatisfied when the spin is +1
+        problem.h_weight[v] = weight;
+        problem.h_flip[v] = h[v] < 0 ? RANDMAX : 0;
+        int total = weight;
+
+        for (int i = adj.offsets[v]; i < adj.offsets[v + 1]; i++) {
+            const Neighbor& n = adj.neighbors[i];
+            if (!to_weight(n.weight, weight)) return false;
+
+            // a positive coupling is unsatisfied when the spins are equal
+            problem.bonds[i] = {n.var, weight, n.weight > 0 ? RANDMAX : 0};
+            total += weight;
+            if (total > MULTI_SPIN_MAX_TOTAL) return false;
+        }
+
+        problem.total[v] = total;
+        problem.max_total = max(problem.max_total, total);
+    }
+
+    // the number of bits needed to hold any U
+    problem.num_planes = 1;
+    while ((1 << problem.num_planes) <= problem.max_total) problem.num_planes++;
+
+    return true;
+}
+
+// Adds `weight` to the bit-sliced integer `planes` in the replicas set in
+// `mask`. planes[j] holds bit j of the integer for every replica.
+static inline void add_weighted(
+    uint64_t *planes,
+    const int num_planes,
+    const uint64_t mask,
+    std::uint32_t weight
+) {
+    for (int k = 0; weight; k++, weight >>= 1) {
+        if (!(weight & 1)) continue;
+        uint64_t carry = mask;
+        for (int j = k; carry && j < num_planes; j++) {
+            const uint64_t next = planes[j] & carry;
+            planes[j] ^= carry;
+            carry = next;
+        }
+    }
+}
+
+// Returns the replicas in which the bit-sliced integer `planes` equals `value`
+static inline uint64_t equal_mask(
+    const uint64_t *planes,
+    const int num_planes,
+    const int value
+) {
+    uint64_t eq = RANDMAX;
+    for (int j = 0; j < num_planes; j++) {
+        eq &= ((value >> j) & 1) ? planes[j] : ~planes[j];
+    }
+    return eq;
+}
+
+// Returns the replicas in which the bit-sliced integer `planes` is at least
+// `value`
+static inline uint64_t at_least_mask(
+    const uint64_t *planes,
+    const int num_planes,
+    const int value
+) {
+    uint64_t gt = 0;
+    uint64_t eq = RANDMAX;
+    for (int j = num_planes - 1; j >= 0; j--) {
+        if ((value >> j) & 1) {
+            eq &= planes[j];
+        } else {
+            gt |= eq & planes[j];
+            eq &= ~planes[j];
+        }
+    }
+    return gt | eq;
+}
+
+// Returns a random subset of the replicas in `mask`, where each replica is
+// selected independently with probability `threshold` / 2^32. This compares,
+// for every replica at once, `threshold` against a uniform 32 bit integer
+// whose bits are drawn from the most significant down, lazily, stopping as
+// soon as all of the comparisons are decided.
+static inline uint64_t random_subset(uint64_t mask, const uint64_t threshold) {
+    uint64_t rand;
+    uint64_t less = 0;
+    for (int k = 31; k >= 0 && mask; k--) {
+        FASTRAND(rand);
+        if ((threshold >> k) & 1) {
+            less |= mask & ~rand;
+            mask &= rand;
+        } else {
+            mask &= ~rand;
+        }
+    }
+    return less;
+}
+
+// Returns the number of replicas set in `mask`
+static inline int count_replicas(uint64_t mask) {
+    mask = mask - ((mask >> 1) & 0x5555555555555555ULL);
+    mask = (mask & 0x3333333333333333ULL) + ((mask >> 2) & 0x3333333333333333ULL);
+    mask = (mask + (mask >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (int)((mask * 0x0101010101010101ULL) >> 56);
+}
+
+// Performs a single run of simulated annealing on NUM_REPLICAS replicas at
+// once, updating the variables sequentially.
+// @param spins a uint64 array with the packed state of each variable, see
+//        above. Note that this will be used as the initial state of the run.
+// @param problem the problem, see `build_multi_spin_problem`
+// @param sweeps_per_beta The number of sweeps to perform at each beta value.
+//        Total number of sweeps is `sweeps_per_beta` * length of
+//        `beta_schedule`.
+// @param beta_schedule A list of the beta values to run `sweeps_per_beta`
+//        sweeps at.
+// @param active the replicas that hold samples, the others being padding
+// @param counts If not null and counters are enabled, the outcomes of the
+//        proposals to the `active` replicas at each beta are added to
+//        counts[beta_idx]. Those whose flip is never accepted at the
+//        resolution of the acceptance tables are counted as skipped.
+// @return Nothing, but `spins` now contains the result of the run.
+template <Proposal proposal_acceptance_criteria>
+void multi_spin_annealing_run(
+    uint64_t *spins,
+    const MultiSpinProblem& problem,
+    const int sweeps_per_beta,
+    const vector<double>& beta_schedule,
+    const uint64_t active,
+    ProposalCounts* counts
+) {
+    const int num_vars = problem.total.size();
+    const int max_total = problem.max_total;
+    const int num_planes = problem.num_planes;
+
+    // acceptance[d + max_total] is the probability, as a 32 bit fixed point
+    // number, of accepting a flip with an energy delta of 2 * d
+    vector<uint64_t> acceptance(2 * max_total + 1);
+
+    uint64_t planes[MULTI_SPIN_MAX_PLANES];
+
+    for (int beta_idx = 0; beta_idx < (int)beta_schedule.size(); beta_idx++) {
+        const double beta = beta_schedule[beta_idx];
+
+        // the acceptance probability decreases with d, so all of the d up to
+        // `always` are always accepted and all of the d from `never` on are
+        // never accepted
+        int always = -2 * max_total - 2;
+        int never = 2 * max_total + 2;
+        for (int d = max_total; d >= -max_total; d--) {
+            const double delta_energy = 2 * d;
+            double p;
+            if constexpr (proposal_acceptance_criteria == Metropolis) {
+                p = delta_energy <= 0 ? 1 : exp(-delta_energy * beta);
+            } else {
+                p = 1 / (1 + exp(delta_energy * beta));
+            }
+
+            uint64_t& threshold = acceptance[d + max_total];
+            threshold = p >= 1 ? ALWAYS_ACCEPT : (uint64_t)(p * 4294967296.0);
+            if (threshold == ALWAYS_ACCEPT && always < d) always = d;
+            if (threshold == 0) never = d;
+        }
+
+        for (int sweep = 0; sweep < sweeps_per_beta; sweep++) {
+            for (int var = 0; var < num_vars; var++) {
+                const uint64_t spin = spins[var];
+                const int total = problem.total[var];
+
+                // accumulate U, the weight of the unsatisfied couplings
+                for (int j = 0; j < num_planes; j++) planes[j] = 0;
+                add_weighted(planes, num_planes, spin ^ problem.h_flip[var],
+                             problem.h_weight[var]);
+                const MultiSpinBond *end = problem.bonds.data() + problem.offsets[var + 1];
+                for (const MultiSpinBond *b = problem.bonds.data() + problem.offsets[var];
+                        b != end; b++) {
+                    add_weighted(planes, num_planes, spin ^ spins[b->var] ^ b->flip,
+                                 b->weight);
+                }
+
+                // U in [0, lo) is never accepted, U in [hi, total] always is,
+                // and each U in between is accepted with some probability
+                // note that d = total - 2 * U
+                const int lo = total >= never ? (total - never) / 2 + 1 : 0;
+                const int hi = max(0, (total - always + 1) / 2);
+
+                uint64_t accept = hi <= total ? at_least_mask(planes, num_planes, hi) : 0;
+                for (int u = lo; u < min(hi, total + 1); u++) {
+                    const uint64_t eq = equal_mask(planes, num_planes, u);
+                    if (eq) {
+                        accept |= random_subset(eq, acceptance[total - 2 * u + max_total]);
+                    }
+                }
+
+                spins[var] = spin ^ accept;
+
+                if constexpr (counters_enabled) {
+                    if (counts) {
+                        const uint64_t never_accepted = lo > total ? RANDMAX :
+                            ~at_least_mask(planes, num_planes, lo);
+                        const int accepted = count_replicas(accept & active);
+                        const int skipped = count_replicas(never_accepted & active);
+                        counts[beta_idx].accepted += accepted;
+                        counts[beta_idx].skipped += skipped;
+                        counts[beta_idx].rejected += count_replicas(active) - accepted - skipped;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// A replica of the problem in parallel tempering, with its own state, energy
+// and RNG stream.
+struct Replica {
+    vector<std::int8_t> state;
+    // delta_energy[v] is the delta energy of flipping `v` in `state`
+    vector<double> delta_energy;
+    double energy;
+    uint64_t rng[2];
+};
+
+// Performs a single run of parallel tempering (replica exchange Monte Carlo).
+// One replica is kept at each beta of `beta_ladder`. Rounds of
+// `sweeps_per_swap` sweeps of every replica at its beta alternate with
+// attempts to swap the replicas at neighboring betas, the even pairs and the
+// odd pairs in turn. A swap of the replicas at betas `b0` and `b1`, with
+// energies `e0` and `e1`, is accepted with probability
+// min(1, exp((b0 - b1) * (e0 - e1))), which keeps every replica in
+// equilibrium at its beta.
+// Each replica has its own RNG stream, derived from `seed` and `sample`, so
+// the result does not depend on the number of threads.
+// @param state a int8 array where each int8 holds the state of a
+//        variable. Note that this will be used as the initial state of every
+//        replica.
+// @param h vector of h or field value on each variable
+// @param adj the adjacency of the problem, see `build_adjacency`
+// @param beta_ladder the beta of each replica
+// @param sweeps_per_swap the number of sweeps between swap attempts
+// @param num_swaps the number of rounds of swap attempts
+// @param seed the seed of the run
+// @param sample the index of the run, see `seed_rng`
+// @param swap_accepts if not null, swap_accepts[k] is incremented for each
+//        accepted swap between beta_ladder[k] and beta_ladder[k + 1]
+// @param pool if not null, the threads to sweep the replicas with
+// @return The energy of the replica at the last beta of the ladder, kept track
+//         of from the delta energies of its flips; `state` now contains its
+//         final state.
+template <VariableOrder varorder, Proposal proposal_acceptance_criteria>
+double parallel_tempering_run(
+    std::int8_t* state,
+    const vector<double>& h,
+    const Adjacency& adj,
+    const vector<double>& beta_ladder,
+    const int sweeps_per_swap,
+    const int num_swaps,
+    const uint64_t seed,
+    const int sample,
+    std::int64_t* swap_accepts,
+    BlockPool* pool
+) {
+    const int num_vars = h.size();
+    const int num_replicas = beta_ladder.size();
+
+    // every replica starts from `state`
+    vector<double> delta_energy(num_vars);
+    for (int var = 0; var < num_vars; var++) {
+        delta_energy[var] = get_flip_energy(var, state, h, adj);
+    }
+    const double energy = state_energy_from_flip_energies(state, h, delta_energy.data());
+
+    vector<Replica> replicas(num_replicas);
+    for (int k = 0; k < num_replicas; k++) {
+        Replica &replica = replicas[k];
+        replica.state.assign(state, state + num_vars);
+        replica.delta_energy = delta_energy;
+        replica.energy = energy;
+
+        seed_rng(seed, ((uint64_t)(k + 1) << 32) | (uint32_t)sample);
+        replica.rng[0] = rng_state[0];
+        replica.rng[1] = rng_state[1];
+    }
+
+    // the swap attempts use the stream of the run. it is saved between rounds
+    // because the calling thread also sweeps replicas when there is a pool
+    seed_rng(seed, sample);
+    uint64_t swap_rng[2] = {rng_state[0], rng_state[1]};
+
+    // at[k] is the index of the replica at beta_ladder[k]
+    vector<int> at(num_replicas);
+    for (int k = 0; k < num_replicas; k++) at[k] = k;
+
+    const function<void(int)> sweep_replica = [&](const int k) {
+        Replica &replica = replicas[at[k]];
+        rng_state[0] = replica.rng[0];
+        rng_state[1] = replica.rng[1];
+        int64_t num_flips = 0;
+        for (int sweep = 0; sweep < sweeps_per_swap; sweep++) {
+            replica.energy += annealing_sweep<varorder, proposal_acceptance_criteria, false>(
+                replica.state.data(), replica.delta_energy.data(), adj, num_vars,
+                beta_ladder[k], nullptr, nullptr, nullptr, num_flips);
+        }
+        replica.rng[0] = rng_state[0];
+        replica.rng[1] = rng_state[1];
+    };
+
+    uint64_t rand;
+    for (int round = 0; round < num_swaps; round++) {
+        if (pool) {
+            pool->run(num_replicas, sweep_replica);
+        } else {
+            for (int k = 0; k < num_replicas; k++) sweep_replica(k);
+        }
+
+        rng_state[0] = swap_rng[0];
+        rng_state[1] = swap_rng[1];
+        for (int k = round % 2; k + 1 < num_replicas; k += 2) {
+            const double log_accept = (beta_ladder[k] - beta_ladder[k + 1]) *
+                (replicas[at[k]].energy - replicas[at[k + 1]].energy);
+
+            bool accept = log_accept >= 0;
+            if (!accept) {
+                FASTRAND(rand);
+                accept = exp(log_accept) * RANDMAX > rand;
+            }
+            if (accept) {
+                std::swap(at[k], at[k + 1]);
+                if (swap_accepts) swap_accepts[k]++;
+            }
+        }
+        swap_rng[0] = rng_state[0];
+        swap_rng[1] = rng_state[1];
+    }
+
+    const Replica &coldest = replicas[at[num_replicas - 1]];
+    std::copy(coldest.state.begin(), coldest.state.end(), state);
+    return coldest.energy;
+}
+
+// Takes the samples `0, ..., num_samples - 1` on `num_threads` threads of the
+// shared worker pool, see pool.h. Workers claim sample indices from a shared
+// counter, so that the samples taken before an interrupt always form a prefix.
+// `interrupt_callback` is only ever invoked from the calling thread, once for
+// each finished sample; the calling thread then only takes samples itself
+// while no worker is, eg. because the call is nested in another loop of the
+// pool, which leaves no worker free.
+// If `num_threads` is less than two, the samples are taken in order on the
+// calling thread instead.
+// @param num_samples the number of samples to take.
+// @param num_threads the number of worker threads to use.
+// @param take_sample a function taking a single sample, given its index.
+// @param interrupt_callback see `general_simulated_annealing`.
+// @param interrupt_function see `general_simulated_annealing`.
+// @return the number of samples taken.
+template <class SampleFunction>
+int run_samples(
+    const int num_samples,
+    int num_threads,
+    SampleFunction &take_sample,
+    callback interrupt_callback,
+    void * const interrupt_function
+) {
+    num_threads = min(num_threads, num_samples);
+
+    if (num_threads < 2) {
+        int sample = 0;
+        while (sample < num_samples) {
+            take_sample(sample);
+
+            sample++;
+
+            // if interrupt_function returns true, stop sampling
+            if (interrupt_function && interrupt_callback(interrupt_function)) break;
+        }
+
+        // return the number of samples we actually took
+        return sample;
+    }
+
+    atomic<int> next_sample(0);
+    atomic<bool> stop(false);
+
+    // guards `num_finished`, `num_working` and `error`
+    mutex lock;
+    condition_variable finished;
+    int num_finished = 0;
+    int num_working = 0;
+    exception_ptr error;
+
+    // takes the next sample, returning false if there is none left
+    auto take_next = [&]() {
+        if (stop) return false;
+        const int sample = next_sample++;
+        if (sample >= num_samples) return false;
+
+        try {
+            take_sample(sample);
+        } catch (...) {
+            lock_guard<mutex> guard(lock);
+            if (!error) error = current_exception();
+            stop = true;
+        }
+
+        {
+            lock_guard<mutex> guard(lock);
+            num_finished++;
+        }
+        finished.notify_one();
+        return true;
+    };
+
+    auto worker = [&]() {
+        {
+            lock_guard<mutex> guard(lock);
+            num_working++;
+        }
+        while (take_next()) {}
+        {
+            lock_guard<mutex> guard(lock);
+            num_working--;
+        }
+        finished.notify_one();
+    };
+
+    auto poll = [&]() {
+        int num_polled = 0;
+        unique_lock<mutex> guard(lock);
+        while (!stop && num_polled < num_samples) {
+            finished.wait(guard, [&]() {
+                return stop || num_finished > num_polled ||
+                    (num_working == 0 && next_sample < num_samples);
+            });
+
+            // call the interrupt function without holding the lock, so the
+            // workers are free to keep going in the meantime
+            while (!stop && num_polled < num_finished) {
+                num_polled++;
+                guard.unlock();
+                if (interrupt_callback(interrupt_function)) stop = true;
+                guard.lock();
+            }
+
+            if (!stop && num_polled == num_finished && num_working == 0) {
+                guard.unlock();
+                take_next();
+                guard.lock();
+            }
+        }
+    };
+
+    if (interrupt_function) {
+        // the calling thread polls rather than taking samples
+        worker_pool().run(num_threads + 1, worker, poll);
+    } else {
+        run_parallel(num_threads, worker);
+    }
+
+    if (error) rethrow_exception(error);
+
+    return min(next_sample.load(), num_samples);
+}
+
+AnnealingProblem::AnnealingProblem(
+    const vector<double> &h,
+    const vector<int> &coupler_starts,
+    const vector<int> &coupler_ends,
+    const vector<double> &coupler_weights
+) : AnnealingProblem(make_shared<const IsingGraph>(
+        build_ising_graph(h, coupler_starts, coupler_ends, coupler_weights))) {}
+
+AnnealingProblem::AnnealingProblem(shared_ptr<const IsingGraph> graph)
+    : graph_(graph ? std::move(graph)
+                   : throw runtime_error("the graph of the problem is null")),
+      h_(graph_->linear), adj_(graph_->adjacency) {}
+
+// defined here, where `MultiSpinProblem` is complete
+AnnealingProblem::~AnnealingProblem() {}
+
+const vector<vector<int>>& AnnealingProblem::color_classes() const {
+    std::call_once(classes_once_, [this] { classes_ = greedy_coloring(adj_); });
+    return classes_;
+}
+
+const MultiSpinProblem* AnnealingProblem::multi_spin_problem() const {
+    std::call_once(multi_spin_once_, [this] {
+        std::unique_ptr<MultiSpinProblem> problem(new MultiSpinProblem);
+        if (build_multi_spin_problem(h_, adj_, *problem)) {
+            multi_spin_ = std::move(problem);
+        }
+    });
+    return multi_spin_.get();
+}
+
+pair<double, double> AnnealingProblem::default_beta_range(
+    const double max_single_qubit_excitation_rate,
+    const bool scale_T_with_N
+) const {
+    return ::default_beta_range(h_, adj_, max_single_qubit_excitation_rate, scale_T_with_N);
+}
+
+double AnnealingProblem::quantum() const {
+    std::call_once(quantum_once_, [this] {
+        // every coupler appears twice in the adjacency, which does not change
+        // the quantum
+        vector<double> weights(adj_.neighbors.size());
+        for (size_t i = 0; i < weights.size(); i++) {
+            weights[i] = adj_.neighbors[i].weight;
+        }
+        quantum_ = bias_quantum(h_, weights);
+    });
+    return quantum_;
+}
+
+const ReducedProblem<float>* AnnealingProblem::single_problem() const {
+    std::call_once(single_once_, [this] {
+        single_.reset(new ReducedProblem<float>);
+        single_->scale = 1;
+        reduce_adjacency(adj_, *single_);
+    });
+    return single_.get();
+}
+
+const ReducedProblem<int32_t>* AnnealingProblem::integer_problem() const {
+    std::call_once(integer_once_, [this] {
+        std::unique_ptr<ReducedProblem<int32_t>> problem(new ReducedProblem<int32_t>);
+        if (build_integer_problem(h_, adj_, quantum(), *problem)) {
+            integer_ = std::move(problem);
+        }
+    });
+    return integer_.get();
+}
+
+int AnnealingProblem::sample(
+    std::int8_t* states,
+    double* energies,
+    const int num_samples,
+    const int sweeps_per_beta,
+    const vector<double> &beta_schedule,
+    const uint64_t seed,
+    const VariableOrder varorder,
+    const Proposal proposal_acceptance_criteria,
+    callback interrupt_callback,
+    void * const interrupt_function,
+    const int num_threads,
+    const bool multi_spin,
+    const int sweep_threads,
+    const bool lookup_table,
+    const Termination &termination,
+    const bool descend,
+    const DescentSolver descent_solver,
+    ReadQueue *completed,
+    vector<ProposalCounts> *proposal_counts,
+    const double min_acceptance,
+    const Precision precision
+) const {
+    // TODO 
+    // assert len(states) == num_samples*num_vars*sizeof(int8_t)
+
+    // the number of variables in the problem
+    const int num_vars = h_.size();
+    const vector<double> &h = h_;
+    const Adjacency &adj = adj_;
+
+    // if there are no criteria, the runs do not check them
+    const Termination *termination_ptr = termination.enabled() ? &termination : nullptr;
+
+    if (min_acceptance > 0 && varorder == Colored) {
+        throw std::invalid_argument(
+            "an adaptive schedule requires the Sequential or Random variable order");
+    }
+
+    // each sample counts the outcomes of its proposals on its own, and adds
+    // them to `proposal_counts` once it is done
+    const bool counting = counters_enabled && proposal_counts;
+    if (counting) proposal_counts->assign(beta_schedule.size(), ProposalCounts());
+    mutex counts_lock;
+    auto add_counts = [&](const vector<ProposalCounts>& counts) {
+        lock_guard<mutex> guard(counts_lock);
+        for (size_t b = 0; b < counts.size(); b++) (*proposal_counts)[b] += counts[b];
+    };
+
+    const MultiSpinProblem *multi_spin_problem_ptr = nullptr;
+    if (multi_spin && varorder == Sequential && !termination_ptr && !(min_acceptance > 0)) {
+        multi_spin_problem_ptr = multi_spin_problem();
+    }
+    if (multi_spin_problem_ptr) {
+        const MultiSpinProblem &multi_spin_problem = *multi_spin_problem_ptr;
+        const int num_batches = (num_samples + NUM_REPLICAS - 1) / NUM_REPLICAS;
+
+        // take the samples `batch * NUM_REPLICAS, ...` at once
+        auto take_batch = [&](const int batch) {
+            // each batch gets its own RNG stream
+            seed_rng(seed, batch);
+
+            const int first = batch * NUM_REPLICAS;
+            const int num_replicas = min(NUM_REPLICAS, num_samples - first);
+
+            // pack the initial states, the unused replicas are left at -1
+            vector<uint64_t> spins(num_vars, 0);
+            for (int r = 0; r < num_replicas; r++) {
+                const std::int8_t *state = states + (first + r)*num_vars;
+                for (int var = 0; var < num_vars; var++) {
+                    if (state[var] > 0) spins[var] |= (uint64_t)1 << r;
+                }
+            }
+
+            const uint64_t active = num_replicas == NUM_REPLICAS ?
+                RANDMAX : ((uint64_t)1 << num_replicas) - 1;
+            vector<ProposalCounts> counts(counting ? beta_schedule.size() : 0);
+            ProposalCounts *counts_ptr = counting ? counts.data() : nullptr;
+
+            if (proposal_acceptance_criteria == Metropolis) {
+                multi_spin_annealing_run<Metropolis>(spins.data(), multi_spin_problem,
+                                                     sweeps_per_beta, beta_schedule,
+                                                     active, counts_ptr);
+            } else {
+                multi_spin_annealing_run<Gibbs>(spins.data(), multi_spin_problem,
+                                                sweeps_per_beta, beta_schedule,
+                                                active, counts_ptr);
+            }
+            if (counting) add_counts(counts);
+
+            // unpack the results
+            vector<double> delta_energy(descend ? num_vars : 0);
+            for (int r = 0; r < num_replicas; r++) {
+                std::int8_t *state = states + (first + r)*num_vars;
+                for (int var = 0; var < num_vars; var++) {
+                    state[var] = (spins[var] >> r) & 1 ? 1 : -1;
+                }
+                if (descend) {
+                    for (int var = 0; var < num_vars; var++) {
+                        delta_energy[var] = get_flip_energy(var, state, h, adj);
+                    }
+                    double energy = state_energy_from_flip_energies(
+                        state, h, delta_energy.data());
+                    steepest_gradient_descent_run(state, h, adj, delta_energy,
+                                                  energy, descent_solver);
+                    energies[first + r] = energy;
+                    VERIFY_ENERGY(energy, get_state_energy(state, h, adj));
+                } else {
+                    energies[first + r] = get_state_energy(state, h, adj);
+                }
+            }
+            if (completed) {
+                for (int r = 0; r < num_replicas; r++) completed->push(first + r);
+            }
+        };
+
+        const int batches = run_samples(num_batches, num_threads, take_batch,
+                                        interrupt_callback, interrupt_function);
+        return min(batches * NUM_REPLICAS, num_samples);
+    }
+
+    // used by the Colored variable order
+    static const vector<vector<int>> no_classes;
+    const vector<vector<int>> &classes =
+        varorder == Colored ? color_classes() : no_classes;
+
+    // used by the Sequential and Random variable orders, if the problem is
+    // quantized
+    BoltzmannTables boltzmann_tables;
+    const BoltzmannTables *tables = nullptr;
+    if (lookup_table && varorder != Colored) {
+        const double quantum = this->quantum();
+        bool built = false;
+        if (quantum > 0 && proposal_acceptance_criteria == Metropolis) {
+            built = build_boltzmann_tables<Metropolis>(h, adj, quantum, beta_schedule,
+                                                       boltzmann_tables);
+        } else if (quantum > 0) {
+            built = build_boltzmann_tables<Gibbs>(h, adj, quantum, beta_schedule,
+                                                  boltzmann_tables);
+        }
+        if (built) tables = &boltzmann_tables;
+    }
+
+    // used by the Sequential and Random variable orders, in reduced precision
+    const ReducedProblem<float> *single = nullptr;
+    const ReducedProblem<int32_t> *integer = nullptr;
+    if (precision == IntegerPrecision && varorder != Colored) {
+        integer = integer_problem();
+        // the delta energies are then in units of the quantum, i.e. twice the
+        // levels of the tables
+        if (integer) boltzmann_tables.inv_two_quantum = .5;
+    } else if (precision == SinglePrecision && varorder != Colored) {
+        single = single_problem();
+    }
+
+    // take a single simulated annealing sample
+    auto take_sample = [&](const int sample) {
+        // each sample gets its own RNG stream, see `seed_rng`
+        seed_rng(seed, sample);
+
+        // states is a giant spin array that will hold the resulting states for
+        // all the samples, so we need to get the location inside that vector
+        // where we will store the sample for this sample
+        std::int8_t *state = states + sample*num_vars;
+        // the delta energy of flipping each variable, which the runs other
+        // than the parallel colored one keep up to date
+        vector<double> delta_energy;
+        // and the energy of the final state, which all of them keep track of
+        double energy;
+        vector<ProposalCounts> counts(counting ? beta_schedule.size() : 0);
+        ProposalCounts *counts_ptr = counting ? counts.data() : nullptr;
+        // then do the actual sample. this function will modify state, storing
+        // the sample there
+        // Branching here is designed to make expicit compile time optimizations
+        if (varorder == Colored && sweep_threads > 1) {
+            BlockPool pool(sweep_threads);
+            if (proposal_acceptance_criteria == Metropolis) {
+                energy = parallel_colored_annealing_run<Metropolis>(state, h, adj, classes,
+                                                           sweeps_per_beta, beta_schedule,
+                                                           pool, termination_ptr, counts_ptr);
+            } else {
+                energy = parallel_colored_annealing_run<Gibbs>(state, h, adj, classes,
+                                                      sweeps_per_beta, beta_schedule,
+                                                      pool, termination_ptr, counts_ptr);
+            }
+        } else if (varorder == Colored) {
+            if (proposal_acceptance_criteria == Metropolis) {
+                energy = colored_annealing_run<Metropolis>(state, h, adj, classes,
+                                                  sweeps_per_beta, beta_schedule,
+                                                  termination_ptr, delta_energy, counts_ptr);
+            } else {
+                energy = colored_annealing_run<Gibbs>(state, h, adj, classes,
+                                             sweeps_per_beta, beta_schedule,
+                                             termination_ptr, delta_energy, counts_ptr);
+            }
+        } else if (varorder == Random) {
+            if (proposal_acceptance_criteria == Metropolis) {
+                energy = scalar_annealing_run<Random, Metropolis>(state, h, adj,
+                                                    sweeps_per_beta, beta_schedule,
+                                                    tables, termination_ptr, delta_energy, counts_ptr,
+                                                    min_acceptance, single, integer);
+            } else {
+                energy = scalar_annealing_run<Random, Gibbs>(state, h, adj,
+                                                     sweeps_per_beta, beta_schedule,
+                                                     tables, termination_ptr, delta_energy, counts_ptr,
+                                                     min_acceptance, single, integer);
+          }
+        } else {
+            if (proposal_acceptance_criteria == Metropolis) {
+                energy = scalar_annealing_run<Sequential, Metropolis>(state, h, adj,
+                                                     sweeps_per_beta, beta_schedule,
+                                                     tables, termination_ptr, delta_energy, counts_ptr,
+                                                     min_acceptance, single, integer);
+            } else {
+                energy = scalar_annealing_run<Sequential, Gibbs>(state, h, adj,
+                                                      sweeps_per_beta, beta_schedule,
+                                                      tables, termination_ptr, delta_energy, counts_ptr,
+                                                      min_acceptance, single, integer);
+            }
+        }
+        if (counting) add_counts(counts);
+        if (descend) {
+            if (delta_energy.empty()) {
+                delta_energy.resize(num_vars);
+                for (int var = 0; var < num_vars; var++) {
+                    delta_energy[var] = get_flip_energy(var, state, h, adj);
+                }
+            }
+            steepest_gradient_descent_run(state, h, adj, delta_energy, energy,
+                                          descent_solver);
+        }
+        energies[sample] = energy;
+        VERIFY_ENERGY(energy, get_state_energy(state, h, adj));
+        if (completed) completed->push(sample);
+    };
+
+    // get the simulated annealing samples
+    return run_samples(num_samples, num_threads, take_sample,
+                       interrupt_callback, interrupt_function);
+}
+
+int AnnealingProblem::parallel_tempering(
+    std::int8_t* states,
+    double* energies,
+    const int num_samples,
+    const vector<double> &beta_ladder,
+    const int sweeps_per_swap,
+    const int num_swaps,
+    const uint64_t seed,
+    const VariableOrder varorder,
+    const Proposal proposal_acceptance_criteria,
+    callback interrupt_callback,
+    void * const interrupt_function,
+    const int num_threads,
+    std::int64_t *swap_accepts
+) const {
+    if (beta_ladder.empty()) {
+        throw runtime_error("beta_ladder must not be empty");
+    }
+    if (varorder == Colored) {
+        throw runtime_error("parallel tempering does not support the Colored variable order");
+    }
+
+    const int num_vars = h_.size();
+
+    // the pool is shared by all of the samples
+    std::unique_ptr<BlockPool> pool;
+    if (num_threads > 1) pool.reset(new BlockPool(num_threads));
+
+    auto take_sample = [&](const int sample) {
+        std::int8_t *state = states + sample*num_vars;
+        double energy;
+        if (varorder == Random && proposal_acceptance_criteria == Metropolis) {
+            energy = parallel_tempering_run<Random, Metropolis>(
+                state, h_, adj_, beta_ladder, sweeps_per_swap, num_swaps, seed,
+                sample, swap_accepts, pool.get());
+        } else if (varorder == Random) {
+            energy = parallel_tempering_run<Random, Gibbs>(
+                state, h_, adj_, beta_ladder, sweeps_per_swap, num_swaps, seed,
+                sample, swap_accepts, pool.get());
+        } else if (proposal_acceptance_criteria == Metropolis) {
+            energy = parallel_tempering_run<Sequential, Metropolis>(
+                state, h_, adj_, beta_ladder, sweeps_per_swap, num_swaps, seed,
+                sample, swap_accepts, pool.get());
+        } else {
+            energy = parallel_tempering_run<Sequential, Gibbs>(
+                state, h_, adj_, beta_ladder, sweeps_per_swap, num_swaps, seed,
+                sample, swap_accepts, pool.get());
+        }
+        energies[sample] = energy;
+        VERIFY_ENERGY(energy, get_state_energy(state, h_, adj_));
+    };
+
+    return run_samples(num_samples, 1, take_sample,
+                       interrupt_callback, interrupt_function);
+}
+
+// Perform simulated annealing on a general problem
+// @param states a int8 array of size num_samples * number of variables in the
+//        problem. Will be overwritten by this function as samples are filled
+//        in. The initial state of the samples are used to seed the simulated
+//        annealing runs.
+// @param energies a double array of size num_samples. Will be overwritten by
+//        this function as energies are filled in.
+// @param num_samples the number of samples to get.
+// @param h vector of h or field value on each variable
+// @param coupler_starts an int vector containing the variables of one side of
+//        each coupler in the problem
+// @param coupler_ends an int vector containing the variables of the other side 
+//        of each coupler in the problem
+// @param coupler_weights a double vector containing the weights of the couplers
+//        in the same order as coupler_starts and coupler_ends
+// @param sweeps_per_beta The number of sweeps to perform at each beta value.
+//        Total number of sweeps is `sweeps_per_beta` * length of
+//        `beta_schedule`.
+// @param beta_schedule A list of the beta values to run `sweeps_per_beta`
+//        sweeps at.
+// @param interrupt_callback A function that is invoked between each run of simulated annealing
+//        if the function returns True then it will stop running.
+// @param interrupt_function A pointer to contents that are passed to interrupt_callback.
+// @param num_threads The number of threads to distribute the samples over. The
+//        samples are independent of the number of threads used. When more than
+//        one thread is used, the samples already in progress when an interrupt
+//        occurs are still completed and returned.
+// @param multi_spin If true, and the problem only has small integer biases
+//        and `varorder` is Sequential, anneal 64 samples at once using
+//        multi-spin coding. Otherwise falls back to annealing each sample
+//        separately. When using multi-spin coding the interrupt callback is
+//        invoked after each batch of 64 samples.
+// @param sweep_threads If greater than one, and `varorder` is Colored, the
+//        blocks of each color class are updated in parallel on this many
+//        threads, see `parallel_colored_annealing_run`. The samples then do
+//        not depend on the value of `sweep_threads`.
+// @param lookup_table If true, and all of the biases are integer multiples of
+//        a common quantum, the Sequential and Random variable orders look the
+//        acceptance thresholds up in precomputed per-beta tables rather than
+//        calling exp(). Falls back to exp() if the tables would be too large.
+// @param termination The criteria for ending each sample before the end of
+//        the beta schedule, see `Termination`. They are checked after every
+//        sweep, without calling back into the interrupt callback. Multi-spin
+//        coding is not used if any criterion is enabled.
+// @param descend If true, each sample is followed by a steepest gradient
+//        descent from its final state, see `steepest_gradient_descent_run`.
+//        The descent starts from the delta energies the annealing kept up to
+//        date, and the returned states and energies are those of the local
+//        minima it reaches.
+// @param descent_solver The data structure the descent uses to find the
+//        steepest descent variable, see `DescentSolver`.
+// @return the number of samples taken. If no interrupt occured, will equal num_samples.
+int general_simulated_annealing(
+    std::int8_t* states,
+    double* energies,
+    const int num_samples,
+    const vector<double> &h,
+    const vector<int> &coupler_starts,
+    const vector<int> &coupler_ends,
+    const vector<double> &coupler_weights,
+    const int sweeps_per_beta,
+    const vector<double> &beta_schedule,
+    const uint64_t seed,
+    const VariableOrder varorder,
+    const Proposal proposal_acceptance_criteria,
+    callback interrupt_callback,
+    void * const interrupt_function,
+    const int num_threads,
+    const bool multi_spin,
+    const int sweep_threads,
+    const bool lookup_table,
+    const Termination &termination,
+    const bool descend,
+    const DescentSolver descent_solver
+) {
+    const AnnealingProblem problem(h, coupler_starts, coupler_ends, coupler_weights);
+    return problem.sample(states, energies, num_samples, sweeps_per_beta,
+                          beta_schedule, seed, varorder,
+                          proposal_acceptance_criteria, interrupt_callback,
+                          interrupt_function, num_threads, multi_spin,
+                          sweep_threads, lookup_table, termination, descend,
+                          descent_solver);
+}
+
+void sample_batch_problem(
+    const AnnealingProblem &problem,
+    std::int8_t *states,
+    double *energies,
+    pair<double, double> &beta_range,
+    const AnnealingBatch &batch,
+    const uint64_t seed,
+    const int index
+) {
+    const int num_vars = problem.num_variables();
+
+    beta_range = {batch.hot_beta, batch.cold_beta};
+    if (!(batch.hot_beta > 0 || batch.cold_beta > 0)) {
+        beta_range = problem.default_beta_range();
+        // all the biases are zero, see `_default_ising_beta_range`
+        if (!beta_range.first) beta_range = {0.1, 1};
+    }
+
+    if (!num_vars) {
+        std::fill(energies, energies + batch.num_samples, 0.0);
+        return;
+    }
 
-        sample++;
+    // the initial states come from the same stream as the seed of the
+    // annealing, so each problem only depends on its own index
+    StreamRng rng(seed, index);
+    const int64_t size = static_cast<int64_t>(batch.num_samples) * num_vars;
+    for (int64_t i = 0; i < size; i++) states[i] = (rng() >> 63) ? 1 : -1;
 
-        // if interrupt_function returns true, stop sampling
-        if (interrupt_function && interrupt_callback(interrupt_function)) break;
+    vector<double> beta_schedule(max(batch.num_betas, 1), beta_range.second);
+    const int num_betas = beta_schedule.size();
+    for (int b = 0; b + 1 < num_betas; b++) {
+        const double t = static_cast<double>(b) / (num_betas - 1);
+        beta_schedule[b] = batch.geometric
+            ? beta_range.first * pow(beta_range.second / beta_range.first, t)
+            : beta_range.first + (beta_range.second - beta_range.first) * t;
     }
 
-    // return the number of samples we actually took
-    return sample;
+    problem.sample(states, energies, batch.num_samples, batch.sweeps_per_beta,
+                   beta_schedule, rng(), batch.varorder,
+                   batch.proposal_acceptance_criteria, nullptr, nullptr);
 }
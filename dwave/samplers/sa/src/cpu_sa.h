@@ -18,6 +18,17 @@
 #define _cpu_sa_h
 
 #include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "batch.h"
+#include "counters.h"
+#include "descent.h"
+#include "graph.h"
+#include "read_queue.h"
 
 #ifdef _MSC_VER
     // add uint64_t definition for windows
@@ -38,41 +49,303 @@ enum Proposal {
 enum VariableOrder {
     Sequential,   /// Variables updated sequentially on each sweep
     Random,       /// Variable updated uniformly at random per spin-update
+    Colored,      /// Variables updated one color class (of a greedy coloring)
+                  /// at a time per sweep, with vectorized acceptance tests
 };
 
-double get_flip_energy(
-    int var, std::int8_t *state, const std::vector<double> & h,
-    const std::vector<int>& degrees,
-    const std::vector<std::vector<int>>& neighbors,
-    const std::vector<std::vector<double>>& neighbour_couplings
+// The arithmetic of the delta energies and couplings of the Sequential and
+// Random sweeps, see `AnnealingProblem::sample`. The narrower types halve the
+// size of the adjacency walked by every accepted flip.
+enum Precision {
+    DoublePrecision,   /// double delta energies and couplings
+    SinglePrecision,   /// float delta energies and couplings, recomputed
+                       /// exactly every so many sweeps to bound their drift
+    IntegerPrecision,  /// int32 delta energies and couplings, in units of the
+                       /// quantum of the biases, which is exact
+};
+
+std::vector<std::vector<int>> greedy_coloring(const Adjacency& adj);
+
+double bias_quantum(
+    const std::vector<double>& h,
+    const std::vector<double>& coupler_weights
 );
 
-void simulated_annealing_run(
-    std::int8_t *state, const std::vector<double>& h,
-    const std::vector<int>& degrees,
-    const std::vector<std::vector<int>>& neighbors,
-    const std::vector<std::vector<double>>& neighbour_couplings,
-    const int sweeps_per_beta,
-    const std::vector<double>& beta_schedule
+std::pair<double, double> default_beta_range(
+    const std::vector<double>& h,
+    const Adjacency& adj,
+    const double max_single_qubit_excitation_rate = 0.01,
+    const bool scale_T_with_N = true
+);
+
+double get_flip_energy(
+    int var, std::int8_t *state, const std::vector<double> & h,
+    const Adjacency& adj
 );
 
 typedef bool (*const callback)(void * const function);
 
+// Criteria for ending a read before the end of its beta schedule, checked
+// after every sweep. Each criterion is disabled by its default value.
+struct Termination {
+    // the wall-clock time, in seconds, after which a read ends
+    double time_limit = 0;
+    // a read ends once the energy of its state is at most `target_energy`
+    double target_energy = -std::numeric_limits<double>::infinity();
+    // a read ends after `stall_sweeps` consecutive sweeps that do not lower
+    // the lowest energy it has reached
+    int stall_sweeps = 0;
+
+    bool needs_energy() const {
+        return target_energy > -std::numeric_limits<double>::infinity() ||
+            stall_sweeps > 0;
+    }
+    bool enabled() const { return time_limit > 0 || needs_energy(); }
+};
+
+// The outcomes of the flip proposals at a beta of the schedule, see
+// `AnnealingProblem::sample`
+struct ProposalCounts {
+    std::int64_t accepted = 0;
+    std::int64_t rejected = 0;
+    // the proposals rejected without drawing a random number, because their
+    // acceptance probability is below the resolution of the RNG (the
+    // `threshold` shortcut of the scalar sweeps)
+    std::int64_t skipped = 0;
+
+    ProposalCounts& operator+=(const ProposalCounts& other) {
+        accepted += other.accepted;
+        rejected += other.rejected;
+        skipped += other.skipped;
+        return *this;
+    }
+};
+
+struct MultiSpinProblem;
+template <class Weight> struct ReducedProblem;
+
+// A problem prepared for simulated annealing. The graph of the problem is
+// built once, when the problem is constructed, or is given already built, and
+// the other structures derived from the problem (the coloring, the multi-spin
+// representation, the bias quantum) are built the first time a sample needs
+// them. Sampling does not modify the problem, so it can be sampled
+// repeatedly, and from several threads at once.
+class AnnealingProblem {
+  public:
+    AnnealingProblem(
+        const std::vector<double> &h,
+        const std::vector<int> &coupler_starts,
+        const std::vector<int> &coupler_ends,
+        const std::vector<double> &coupler_weights
+    );
+
+    // Reads a SPIN-valued binary quadratic model in place, see
+    // `build_ising_graph`.
+    template <class BQM>
+    explicit AnnealingProblem(const BQM &bqm)
+        : AnnealingProblem(std::make_shared<const IsingGraph>(build_ising_graph(bqm))) {}
+
+    // Shares a graph that is already built, for instance one that is also
+    // given to `steepest_gradient_descent`.
+    explicit AnnealingProblem(std::shared_ptr<const IsingGraph> graph);
+    ~AnnealingProblem();
+
+    AnnealingProblem(const AnnealingProblem&) = delete;
+    AnnealingProblem& operator=(const AnnealingProblem&) = delete;
+
+    int num_variables() const { return h_.size(); }
+    const std::shared_ptr<const IsingGraph>& graph() const { return graph_; }
+
+    // The default hot and cold betas of the problem, see `default_beta_range`
+    std::pair<double, double> default_beta_range(
+        const double max_single_qubit_excitation_rate = 0.01,
+        const bool scale_T_with_N = true
+    ) const;
+
+    // See `general_simulated_annealing`. If `completed` is given, the index of
+    // each sample is pushed to it once its state and energy are written, so
+    // that they can be read while the other samples are still annealing.
+    // If `proposal_counts` is given and the kernels are built with counters
+    // (see counters.h), it is resized to the length of `beta_schedule` and
+    // filled with the outcomes of the proposals at each beta, summed over
+    // the samples.
+    // If `min_acceptance` is positive, each sample walks `beta_schedule`
+    // adaptively, taking larger steps through it while fewer than
+    // `min_acceptance` of its proposals are accepted, see
+    // `simulated_annealing_run`. This requires the Sequential or Random
+    // variable order, and the multi-spin engine is then not used.
+    // `precision` is the arithmetic of the Sequential and Random sweeps, see
+    // `Precision`; the other engines ignore it. IntegerPrecision needs the
+    // biases to be integer multiples of a common quantum whose delta energies
+    // fit in an int32, and otherwise falls back to DoublePrecision. The
+    // energies returned are exact in every precision.
+    int sample(
+        std::int8_t *states,
+        double *energies,
+        const int num_samples,
+        const int sweeps_per_beta,
+        const std::vector<double> &beta_schedule,
+        const uint64_t seed,
+        const VariableOrder varorder,
+        const Proposal proposal_acceptance_criteria,
+        callback interrupt_callback,
+        void * const interrupt_function,
+        const int num_threads = 1,
+        const bool multi_spin = false,
+        const int sweep_threads = 1,
+        const bool lookup_table = false,
+        const Termination &termination = Termination(),
+        const bool descend = false,
+        const DescentSolver descent_solver = LinearSearch,
+        ReadQueue *completed = nullptr,
+        std::vector<ProposalCounts> *proposal_counts = nullptr,
+        const double min_acceptance = 0,
+        const Precision precision = DoublePrecision
+    ) const;
+
+    // Samples the problem using parallel tempering (replica exchange Monte
+    // Carlo) instead of annealing, see `parallel_tempering_run`. Each sample
+    // is the final state of the replica at the last beta of `beta_ladder`.
+    // The replicas of each sample are swept on `num_threads` threads, and the
+    // samples are taken one at a time. The varorder must be Sequential or
+    // Random. If `swap_accepts` is not null, `swap_accepts[k]` is incremented
+    // for every swap between `beta_ladder[k]` and `beta_ladder[k + 1]`.
+    int parallel_tempering(
+        std::int8_t *states,
+        double *energies,
+        const int num_samples,
+        const std::vector<double> &beta_ladder,
+        const int sweeps_per_swap,
+        const int num_swaps,
+        const uint64_t seed,
+        const VariableOrder varorder,
+        const Proposal proposal_acceptance_criteria,
+        callback interrupt_callback,
+        void * const interrupt_function,
+        const int num_threads = 1,
+        std::int64_t *swap_accepts = nullptr
+    ) const;
+
+  private:
+    const std::vector<std::vector<int>>& color_classes() const;
+    // nullptr if the problem is not representable by the multi-spin engine
+    const MultiSpinProblem* multi_spin_problem() const;
+    double quantum() const;
+    const ReducedProblem<float>* single_problem() const;
+    // nullptr if the problem is not representable in integers
+    const ReducedProblem<std::int32_t>* integer_problem() const;
+
+    const std::shared_ptr<const IsingGraph> graph_;
+    const std::vector<double> &h_;
+    const Adjacency &adj_;
+
+    mutable std::once_flag classes_once_;
+    mutable std::vector<std::vector<int>> classes_;
+    mutable std::once_flag multi_spin_once_;
+    mutable std::unique_ptr<MultiSpinProblem> multi_spin_;
+    mutable std::once_flag quantum_once_;
+    mutable double quantum_ = 0;
+    mutable std::once_flag single_once_;
+    mutable std::unique_ptr<ReducedProblem<float>> single_;
+    mutable std::once_flag integer_once_;
+    mutable std::unique_ptr<ReducedProblem<std::int32_t>> integer_;
+};
+
 int general_simulated_annealing(
     std::int8_t *states,
     double *energies,
     const int num_samples,
-    const std::vector<double> h,
-    const std::vector<int> coupler_starts,
-    const std::vector<int> coupler_ends,
-    const std::vector<double> coupler_values,
+    const std::vector<double> &h,
+    const std::vector<int> &coupler_starts,
+    const std::vector<int> &coupler_ends,
+    const std::vector<double> &coupler_values,
     const int sweeps_per_beta,
-    const std::vector<double> beta_schedule,
+    const std::vector<double> &beta_schedule,
     const uint64_t seed,
     const VariableOrder varorder,
     const Proposal proposal_acceptance_criteria,
     callback interrupt_callback,
-    void * const interrupt_function
+    void * const interrupt_function,
+    const int num_threads = 1,
+    const bool multi_spin = false,
+    const int sweep_threads = 1,
+    const bool lookup_table = false,
+    const Termination &termination = Termination(),
+    const bool descend = false,
+    const DescentSolver descent_solver = LinearSearch
 );
 
+// The parameters shared by the problems of `simulated_annealing_batch`.
+struct AnnealingBatch {
+    // the number of samples of each problem
+    int num_samples = 1;
+    int sweeps_per_beta = 1;
+    // the number of betas of each schedule
+    int num_betas = 1000;
+    // the hot and cold betas of the schedules, or 0 for those of
+    // `AnnealingProblem::default_beta_range` for each problem; problems whose
+    // biases are all zero then get the range [0.1, 1]
+    double hot_beta = 0;
+    double cold_beta = 0;
+    // a geometric schedule if true, a linear one otherwise
+    bool geometric = true;
+    VariableOrder varorder = Sequential;
+    Proposal proposal_acceptance_criteria = Metropolis;
+};
+
+// Samples one problem of a batch, from random initial states drawn from
+// stream `index` of `seed`, see `simulated_annealing_batch`.
+// @param beta_range set to the hot and cold betas of the schedule
+void sample_batch_problem(
+    const AnnealingProblem &problem,
+    std::int8_t *states,
+    double *energies,
+    std::pair<double, double> &beta_range,
+    const AnnealingBatch &batch,
+    const uint64_t seed,
+    const int index
+);
+
+// Samples each of a batch of SPIN-valued binary quadratic models, read in
+// place (see `build_ising_graph`), with simulated annealing. The models are
+// spread over `num_threads` threads, each of which builds and samples one
+// model at a time, so that the per-call costs of `AnnealingProblem::sample`
+// are paid natively rather than once per model by the caller.
+// @param bqms the models
+// @param states the samples of each model in turn, `batch.num_samples` rows
+//        of `bqms[i]->num_variables()` values for model `i`
+// @param energies the energies of the samples of each model in turn, not
+//        including the offset
+// @param beta_ranges the hot and cold betas of the schedule of each model
+// @param batch see `AnnealingBatch`
+// @param seed the initial states and the samples of model `i` draw from
+//        stream `i` of the seed, so the results do not depend on
+//        `num_threads`
+// @param num_threads the number of threads to spread the models over
+template <class BQM>
+void simulated_annealing_batch(
+    const std::vector<BQM*> &bqms,
+    std::int8_t *states,
+    double *energies,
+    std::pair<double, double> *beta_ranges,
+    const AnnealingBatch &batch,
+    const uint64_t seed,
+    const int num_threads = 1
+) {
+    // the offsets of the samples of each model
+    std::vector<std::int64_t> offsets(bqms.size() + 1, 0);
+    for (std::size_t i = 0; i < bqms.size(); i++) {
+        offsets[i + 1] = offsets[i] +
+            static_cast<std::int64_t>(batch.num_samples) * bqms[i]->num_variables();
+    }
+
+    auto task = [&](const int i) {
+        const AnnealingProblem problem(*bqms[i]);
+        sample_batch_problem(problem, states + offsets[i],
+                             energies + static_cast<std::int64_t>(batch.num_samples) * i,
+                             beta_ranges[i], batch, seed, i);
+    };
+    run_batch(bqms.size(), num_threads, task);
+}
+
 #endif
@@ -0,0 +1,354 @@
+# Copyright 2026 D-Wave Systems Inc.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+from numbers import Integral
+from numpy.random import randint
+from typing import List, Sequence, Tuple, Optional, Union
+from time import perf_counter_ns
+
+from dimod.core.initialized import InitialStateGenerator
+
+import dimod
+import numpy as np
+
+from dwave.samplers.sa.sampler import _problem_beta_range
+from dwave.samplers.sa.simulated_annealing import AnnealingProblem
+
+__all__ = ["ParallelTemperingSampler"]
+
+
+class ParallelTemperingSampler(dimod.Sampler, dimod.Initialized):
+    """Parallel tempering sampler for binary quadratic models.
+
+    `Parallel tempering <https://en.wikipedia.org/wiki/Parallel_tempering>`_,
+    also known as replica exchange Monte Carlo, runs several replicas of the
+    model, each at a fixed :math:`\\beta` of a ladder of inverse temperatures.
+    Between rounds of single-spin Metropolis (or Gibbs) sweeps, the replicas
+    at neighboring values of :math:`\\beta` attempt to swap states, so that
+    states found at high temperature can migrate to low temperature. Each
+    read returns the final state of the replica at the largest
+    :math:`\\beta`.
+
+    The sweeps use the same kernel as the :class:`.SimulatedAnnealingSampler`.
+
+    Examples:
+        This example solves a simple Ising problem.
+
+        >>> from dwave.samplers import ParallelTemperingSampler
+        >>> sampler = ParallelTemperingSampler()
+        >>> h = {'a': 0.0, 'b': 0.0, 'c': 0.0}
+        >>> J = {('a', 'b'): 1.0, ('b', 'c'): 1.0, ('a', 'c'): 1.0}
+        >>> sampleset = sampler.sample_ising(h, J, num_reads=10)
+        >>> print(sampleset.first.energy)
+        -1.0
+
+    """
+
+    parameters = None
+    """Keyword arguments accepted by the sampling methods.
+
+    See :meth:`.ParallelTemperingSampler.sample` for a description of the
+    parameters.
+
+    Examples:
+        This example looks at a sampler's parameters and some of their values.
+
+        >>> from dwave.samplers import ParallelTemperingSampler
+        >>> sampler = ParallelTemperingSampler()
+        >>> for kwarg in sorted(sampler.parameters):
+        ...     print(kwarg)
+        beta_ladder
+        beta_range
+        initial_states
+        initial_states_generator
+        interrupt_function
+        num_reads
+        num_replicas
+        num_sweeps
+        num_sweeps_per_swap
+        num_threads
+        proposal_acceptance_criteria
+        randomize_order
+        seed
+
+    """
+
+    properties = None
+    """A dict containing any additional information about the sampler."""
+
+    def __init__(self):
+        # create a local copy in case folks for some reason want to modify them
+        self.parameters = {'beta_range': [],
+                           'beta_ladder': [],
+                           'num_replicas': [],
+                           'num_reads': [],
+                           'num_sweeps': [],
+                           'num_sweeps_per_swap': [],
+                           'seed': [],
+                           'interrupt_function': [],
+                           'initial_states': [],
+                           'initial_states_generator': [],
+                           'randomize_order': [],
+                           'proposal_acceptance_criteria': [],
+                           'num_threads': [],
+                           }
+        self.properties = {}
+
+    def sample(self, bqm: dimod.BinaryQuadraticModel,
+               beta_range: Optional[Union[List[float], Tuple[float, float]]] = None,
+               num_replicas: int = 16,
+               beta_ladder: Optional[Union[Sequence[float], np.ndarray]] = None,
+               num_reads: Optional[int] = None,
+               num_sweeps: int = 1000,
+               num_sweeps_per_swap: int = 1,
+               seed: Optional[int] = None,
+               interrupt_function = None,
+               initial_states: Optional[dimod.typing.SamplesLike] = None,
+               initial_states_generator: InitialStateGenerator = "random",
+               randomize_order: bool = False,
+               proposal_acceptance_criteria: str = 'Metropolis',
+               num_threads: int = 1,
+               **kwargs) -> dimod.SampleSet:
+        """Sample from a binary quadratic model.
+
+        Args:
+            bqm: Binary quadratic model to be sampled.
+
+            beta_range:
+                A 2-tuple or list defining the smallest and largest
+                :math:`\\beta` of the ladder, which is geometrically spaced
+                between them. Default range is set based on the total bias
+                associated with each node, as for the
+                :class:`.SimulatedAnnealingSampler`.
+
+            num_replicas:
+                Number of replicas, and so of :math:`\\beta` values, in the
+                ladder interpolated within ``beta_range``.
+
+            beta_ladder:
+                Sequence of :math:`\\beta` values, one per replica, typically
+                increasing. Format must be compatible with
+                ``numpy.array(beta_ladder, dtype=float)``. Values should be
+                non-negative. When given, ``beta_range`` and
+                ``num_replicas`` must be None or consistent with it.
+
+            num_reads:
+                Number of reads. Each read is generated by one run of parallel
+                tempering, with its own set of replicas. If ``num_reads`` is
+                not explicitly given, it is selected to match the number of
+                initial states given. If initial states are not provided, only
+                one read is performed.
+
+            num_sweeps:
+                Number of sweeps of each replica.
+
+            num_sweeps_per_swap:
+                Number of sweeps of each replica between swap attempts. Must
+                divide ``num_sweeps``. Swaps are attempted alternately between
+                the even and the odd pairs of neighboring replicas.
+
+            seed:
+                Seed to use for the PRNG. Specifying a particular seed with a
+                constant set of parameters produces identical results. If not
+                provided, a random seed is chosen.
+
+            initial_states:
+                One or more samples, each defining the initial state, for all
+                of its replicas, of a read. See
+                :meth:`.SimulatedAnnealingSampler.sample`.
+
+            initial_states_generator:
+                Defines the expansion of ``initial_states`` if fewer than
+                ``num_reads`` are specified. See
+                :meth:`.SimulatedAnnealingSampler.sample`.
+
+            randomize_order:
+                See :meth:`.SimulatedAnnealingSampler.sample`.
+
+            proposal_acceptance_criteria:
+                See :meth:`.SimulatedAnnealingSampler.sample`.
+
+            interrupt_function (function, optional):
+                A function called with no parameters between each read. If the
+                function returns True, parallel tempering terminates and
+                returns with all of the samples and energies found so far.
+
+            num_threads:
+                Number of threads to sweep the replicas of each read on. Each
+                replica uses its own random number stream, so results for a
+                given ``seed`` do not depend on ``num_threads``.
+
+        Returns:
+            A `dimod.SampleSet` for the binary quadratic model.
+
+            The `info` field of the sample set contains the beta ladder used,
+            the fraction of attempted swaps accepted between each pair of
+            neighboring replicas, and timing information in nanoseconds, as
+            for the :class:`.SimulatedAnnealingSampler`.
+
+        Examples:
+            This example runs parallel tempering on a binary quadratic model
+            and looks at the swap acceptance rates along the ladder.
+
+            >>> import dimod
+            >>> from dwave.samplers import ParallelTemperingSampler
+            ...
+            >>> sampler = ParallelTemperingSampler()
+            >>> bqm = dimod.generators.ran_r(1, 20, seed=5)
+            >>> sampleset = sampler.sample(bqm, num_reads=4, num_replicas=8,
+            ...                            seed=1234)
+            >>> len(sampleset.info['swap_acceptance_rates'])
+            7
+
+        """
+        timestamp_preprocess = perf_counter_ns()
+        # get the original vartype so we can return consistently
+        original_vartype = bqm.vartype
+
+        # convert to spin (if needed)
+        if bqm.vartype is not dimod.SPIN:
+            bqm = bqm.change_vartype(dimod.SPIN, inplace=False)
+
+        if seed is None:
+            seed = randint(2**31)
+        elif not isinstance(seed, Integral):
+            error_msg = ("'seed' should be None or an integer between 0 and 2^32 "
+                         "- 1: value = {}".format(seed))
+            raise TypeError(error_msg)
+        elif not (0 <= seed < 2**31):
+            error_msg = ("'seed' should be an integer between 0 and 2^32 - 1: "
+                         "value = {}".format(seed))
+            raise ValueError(error_msg)
+
+        # parse the inputs
+        parsed = self.parse_initial_states(
+            bqm,
+            num_reads=num_reads,
+            initial_states=initial_states,
+            initial_states_generator=initial_states_generator,
+            seed=seed)
+
+        num_reads = parsed.num_reads
+
+        # read out the initial states and the variable order
+        initial_states_array = np.ascontiguousarray(
+            parsed.initial_states.record.sample)
+
+        variable_order = parsed.initial_states.variables
+
+        # the sweeps read the BQM in place, so the initial states need to be
+        # in the BQM's variable order
+        if variable_order != bqm.variables:
+            initial_states_array = np.ascontiguousarray(initial_states_array[
+                :, [variable_order.index(v) for v in bqm.variables]])
+            variable_order = bqm.variables
+
+        if interrupt_function and not callable(interrupt_function):
+            raise TypeError("'interrupt_function' should be a callable")
+
+        if not isinstance(num_threads, Integral):
+            error_msg = "'num_threads' should be a positive integer: value = {}".format(num_threads)
+            raise TypeError(error_msg)
+        if num_threads < 1:
+            error_msg = "'num_threads' should be a positive integer: value = {}".format(num_threads)
+            raise ValueError(error_msg)
+
+        if not isinstance(num_sweeps_per_swap, Integral):
+            error_msg = "'num_sweeps_per_swap' should be a positive integer: value = {}".format(num_sweeps_per_swap)
+            raise TypeError(error_msg)
+        if num_sweeps_per_swap < 1:
+            error_msg = "'num_sweeps_per_swap' should be a positive integer: value = {}".format(num_sweeps_per_swap)
+            raise ValueError(error_msg)
+
+        num_swaps, rem = divmod(num_sweeps, num_sweeps_per_swap)
+        if rem > 0 or num_swaps < 0:
+            error_msg = "'num_sweeps' must be a non-negative value divisible by 'num_sweeps_per_swap'."
+            raise ValueError(error_msg)
+
+        problem = AnnealingProblem.from_bqm(bqm)
+
+        if beta_ladder is not None:
+            try:
+                beta_ladder = np.array(beta_ladder, dtype=float)
+            except:
+                raise ValueError('beta_ladder cannot be cast as a numpy array of dtype=float')
+            if beta_ladder.ndim != 1 or len(beta_ladder) < 1:
+                raise ValueError("'beta_ladder' should be a non-empty sequence of numbers.")
+            if np.min(beta_ladder) < 0:
+                raise ValueError("'beta_ladder' cannot include negative values.")
+            if beta_range is not None and (beta_range[0] != beta_ladder[0] or beta_range[-1] != beta_ladder[-1]):
+                error_msg = "'beta_range' should be set to None, or a value consistent with 'beta_ladder'."
+                raise ValueError(error_msg)
+            beta_range = [beta_ladder[0], beta_ladder[-1]]
+        else:
+            if not isinstance(num_replicas, Integral):
+                error_msg = "'num_replicas' should be a positive integer: value = {}".format(num_replicas)
+                raise TypeError(error_msg)
+            if num_replicas < 1:
+                error_msg = "'num_replicas' should be a positive integer: value = {}".format(num_replicas)
+                raise ValueError(error_msg)
+
+            if beta_range is None:
+                beta_range = _problem_beta_range(problem)
+            elif len(beta_range) != 2 or min(beta_range) <= 0:
+                error_msg = "'beta_range' should be a 2-tuple, or 2 element list of positive numbers. The latter value is the target value."
+                raise ValueError(error_msg)
+
+            if num_replicas == 1:
+                beta_ladder = np.array([beta_range[-1]], dtype=float)
+            else:
+                beta_ladder = np.geomspace(*beta_range, num=num_replicas)
+
+        timestamp_sample = perf_counter_ns()
+
+        samples, energies, swap_accepts = problem.parallel_tempering(
+            num_reads, beta_ladder, num_sweeps_per_swap, num_swaps,
+            seed, initial_states_array,
+            randomize_order=randomize_order,
+            proposal_acceptance_criteria=proposal_acceptance_criteria,
+            interrupt_function=interrupt_function,
+            num_threads=num_threads)
+        timestamp_postprocess = perf_counter_ns()
+
+        # swaps are attempted on the even pairs of replicas in even rounds and
+        # on the odd pairs in odd rounds
+        pairs = np.arange(len(swap_accepts))
+        attempts = len(samples) * np.where(pairs % 2 == 0,
+                                           (num_swaps + 1) // 2, num_swaps // 2)
+        with np.errstate(divide='ignore', invalid='ignore'):
+            swap_acceptance_rates = np.where(attempts > 0,
+                                             swap_accepts / attempts, 0.)
+
+        info = {
+            "beta_range": beta_range,
+            "beta_ladder": beta_ladder,
+            "swap_acceptance_rates": swap_acceptance_rates,
+        }
+        response = dimod.SampleSet.from_samples(
+            (samples, variable_order),
+            energy=energies+bqm.offset,  # add back in the offset
+            info=info,
+            vartype=dimod.SPIN
+        )
+
+        response.change_vartype(original_vartype, inplace=True)
+
+        response.info.update(dict(timing=dict(
+            preprocessing_ns=timestamp_sample - timestamp_preprocess,
+            sampling_ns=timestamp_postprocess - timestamp_sample,
+            # Update timing info last to capture the full postprocessing time
+            postprocessing_ns=perf_counter_ns() - timestamp_postprocess,
+        )))
+
+        return response
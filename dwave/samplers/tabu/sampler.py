@@ -14,13 +14,14 @@
 
 """A dimod :term:`sampler` that uses the MST2 multistart tabu search algorithm."""
 
+from numbers import Integral
+from typing import List, Optional, Sequence
+
 import numpy as np
 import dimod
 
-from typing import Optional
-
 from dimod.core.initialized import InitialStateGenerator
-from dwave.samplers.tabu import TabuSearch
+from dwave.samplers.tabu.tabu_search import multi_problem_tabu_search, multi_read_tabu_search
 
 __all__ = ["TabuSampler"]
 
@@ -79,6 +80,8 @@ class TabuSampler(dimod.Sampler, dimod.Initialized):
             'coefficient_z_first': [],
             'coefficient_z_restart': [],
             'lower_bound_z': [],
+            'num_threads': [],
+            'elite_pool_size': [],
         }
         self.properties = {}
 
@@ -94,6 +97,8 @@ class TabuSampler(dimod.Sampler, dimod.Initialized):
                coefficient_z_first: Optional[int] = None,
                coefficient_z_restart: Optional[int] = None,
                lower_bound_z: Optional[int] = None,
+               num_threads: int = 1,
+               elite_pool_size: int = 0,
                **kwargs) -> dimod.SampleSet:
         """Run a multistart tabu search on a given binary quadratic model.
 
@@ -168,6 +173,26 @@ class TabuSampler(dimod.Sampler, dimod.Initialized):
                 searches, see ``coefficient_z_first``. The bound defaults to 
                 500000. 
 
+            num_threads:
+                Number of threads to distribute the reads over. The problem is
+                shared by all reads, each of which draws from its own stream
+                of ``seed``, so the results do not depend on ``num_threads``,
+                unless the reads cooperate.
+
+            elite_pool_size:
+                If positive, the reads cooperate: they share a pool of this many
+                of the best solutions found by any of them, and restart from
+                those rather than from their own best solution. The results
+                then depend on the order the threads run in, so they are not
+                reproducible even with ``seed`` set. Defaults to 0, where the
+                reads are independent.
+
+        Returns:
+            A :class:`dimod.SampleSet` with the ``num_restarts`` of each read.
+            Its ``info`` holds ``counters``: the ``num_iterations`` of the
+            simple tabu searches of each read, and the ``num_evaluations``,
+            the moves they evaluated, in the order of the reads.
+
         Examples:
             This example samples a simple two-variable Ising model.
 
@@ -194,31 +219,47 @@ class TabuSampler(dimod.Sampler, dimod.Initialized):
         elif not 0 <= tenure < len(bqm):
             raise ValueError("'tenure' should be an integer in range [0, num_vars - 1]")
 
+        if not isinstance(num_threads, Integral):
+            raise TypeError("'num_threads' should be a positive integer")
+        if num_threads < 1:
+            raise ValueError("'num_threads' should be a positive integer")
+
+        if not isinstance(elite_pool_size, Integral):
+            raise TypeError("'elite_pool_size' should be a non-negative integer")
+        if elite_pool_size < 0:
+            raise ValueError("'elite_pool_size' should be a non-negative integer")
+
+        # the search reads the QUBO in place
+        qubo = bqm.binary
+        varorder = qubo.variables
+
         # Get initial_states in binary form
-        parsed = self.parse_initial_states(bqm.binary,
+        parsed = self.parse_initial_states(qubo,
                                            initial_states=initial_states,
                                            initial_states_generator=initial_states_generator,
                                            num_reads=num_reads,
                                            seed=seed)
 
-        parsed_initial_states = np.ascontiguousarray(parsed.initial_states.record.sample)
-
-        qubo, varorder = self._bqm_to_tabu_qubo(bqm.binary)
+        # in the QUBO's variable order
+        parsed_initial_states = parsed.initial_states.record.sample
+        if parsed.initial_states.variables != varorder:
+            parsed_initial_states = parsed_initial_states[
+                :, [parsed.initial_states.variables.index(v) for v in varorder]]
+        parsed_initial_states = np.ascontiguousarray(parsed_initial_states)
 
         if timeout is None:
             timeout = -1    # Using negative timeout to mean ignore timeout parameter
 
-        # run Tabu search
-        samples = np.empty((parsed.num_reads, len(bqm)), dtype=np.int8)
-
-        rng = np.random.default_rng(seed)
+        # run Tabu search, one read per initial state, each of which draws
+        # from its own stream of the seed
+        if seed is None:
+            seed = np.random.default_rng().integers(2**63)
 
-        restarts = []
-        for ni, initial_state in enumerate(parsed_initial_states):
-            seed_per_read = rng.integers(2**32, dtype=np.uint32)
-            r = TabuSearch(qubo, initial_state, tenure, timeout, num_restarts, seed_per_read, energy_threshold, coefficient_z_first, coefficient_z_restart, lower_bound_z)
-            samples[ni, :] = r.bestSolution()
-            restarts.append(r.numRestarts())
+        counters = {}
+        samples, restarts = multi_read_tabu_search(
+            qubo, parsed_initial_states, tenure, timeout, num_restarts, seed,
+            energy_threshold, coefficient_z_first, coefficient_z_restart,
+            lower_bound_z, num_threads, elite_pool_size, counters)
 
         # we received samples in binary form, so convert if needed
         if bqm.vartype is dimod.SPIN:
@@ -228,7 +269,86 @@ class TabuSampler(dimod.Sampler, dimod.Initialized):
             # sanity check
             raise ValueError("unknown vartype")
 
-        return dimod.SampleSet.from_samples_bqm((samples, varorder), bqm=bqm, num_restarts=restarts)
+        return dimod.SampleSet.from_samples_bqm((samples, varorder), bqm=bqm,
+                                                info=dict(counters=counters),
+                                                num_restarts=restarts)
+
+    def sample_batch(self, bqms: Sequence[dimod.BinaryQuadraticModel], *,
+                     num_reads: int = 1,
+                     seed: Optional[int] = None,
+                     timeout: int = 20,
+                     num_restarts: int = 1000000,
+                     energy_threshold: Optional[float] = None,
+                     coefficient_z_first: Optional[int] = None,
+                     coefficient_z_restart: Optional[int] = None,
+                     lower_bound_z: Optional[int] = None,
+                     num_threads: int = 1) -> List[dimod.SampleSet]:
+        """Run multistart tabu searches on each of many binary quadratic models
+        in one native call.
+
+        Intended for many small problems, eg. the subproblems of a
+        decomposition solver, for which the per-call overhead of
+        :meth:`sample` outweighs the searches themselves. The models are
+        spread over ``num_threads`` threads, each of which runs all the reads
+        of one model at a time, from random initial states, with the default
+        ``tenure`` of :meth:`sample`.
+
+        Args:
+            bqms: Binary quadratic models to be sampled.
+
+            num_reads: Number of reads of each model.
+
+            seed:
+                Seed of the PRNG. The reads of each model only depend on the
+                seed and on the position of the model in ``bqms``.
+
+            timeout, num_restarts, energy_threshold, coefficient_z_first,
+            coefficient_z_restart, lower_bound_z:
+                See :meth:`sample`. They apply to every read of every model.
+
+            num_threads: Number of threads to spread the models over.
+
+        Returns:
+            A `dimod.SampleSet` for each model, in the order of ``bqms``,
+            with the ``num_restarts`` of each read.
+
+        Examples:
+            >>> import dimod
+            >>> from dwave.samplers import TabuSampler
+            ...
+            >>> bqms = [dimod.generators.ran_r(1, 20, seed=s) for s in range(10)]
+            >>> samplesets = TabuSampler().sample_batch(bqms, timeout=1, num_threads=2)
+            >>> len(samplesets)
+            10
+
+        """
+        if not isinstance(num_threads, Integral) or not isinstance(num_reads, Integral):
+            raise TypeError("'num_reads' and 'num_threads' should be positive integers")
+        if num_threads < 1 or num_reads < 1:
+            raise ValueError("'num_reads' and 'num_threads' should be positive integers")
+
+        if timeout is None:
+            timeout = -1    # Using negative timeout to mean ignore timeout parameter
+
+        if seed is None:
+            seed = np.random.default_rng().integers(2**63)
+
+        # the searches read the QUBOs in place
+        qubos = [bqm.binary for bqm in bqms]
+
+        samples, restarts = multi_problem_tabu_search(
+            qubos, num_reads, timeout, num_restarts, seed, energy_threshold,
+            coefficient_z_first, coefficient_z_restart, lower_bound_z,
+            num_threads)
+
+        samplesets = []
+        for bqm, qubo, solutions, num_restarts_ in zip(bqms, qubos, samples, restarts):
+            if bqm.vartype is dimod.SPIN:
+                solutions = 2 * solutions - 1
+            samplesets.append(dimod.SampleSet.from_samples_bqm(
+                (solutions, qubo.variables), bqm=bqm, num_restarts=num_restarts_))
+
+        return samplesets
 
     @staticmethod
     def _bqm_to_tabu_qubo(bqm):
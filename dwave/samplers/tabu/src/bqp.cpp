@@ -16,14 +16,16 @@
 
 #include <math.h>
 #include <limits>
+#include <utility>
 
 #include "common.h"
 
 using std::vector;
 
-BQP::BQP(std::vector<std::vector<double>> Q) 
-    : Q(Q), 
-      nVars(Q.size()), 
+BQP::BQP() : BQP(vector<double>(), Adjacency()) {}
+
+BQP::BQP(const std::vector<std::vector<double>> &Q) 
+    : nVars(Q.size()), 
       solutionQuality{0},
       nIterations{0},
       restartNum{0}, 
@@ -41,23 +43,91 @@ BQP::BQP(std::vector<std::vector<double>> Q)
             }
         }
     }
+
+    // keep the nonzero coefficients only, row by row so that each row is
+    // sorted
+    linear.resize(nVars);
+    quadratic.offsets.assign(nVars + 1, 0);
+    for (int i = 0; i < nVars; i++) {
+        linear[i] = Q[i][i];
+        for (int j = 0; j < nVars; j++) {
+            if ((j != i) && (Q[i][j] != 0)) {
+                quadratic.neighbors.push_back({j, Q[i][j] + Q[j][i]});
+            }
+        }
+        quadratic.offsets[i + 1] = quadratic.neighbors.size();
+    }
+
+    if (quadratic.neighbors.size() >= DENSE_STORAGE_DENSITY * nVars * (nVars - 1.)) {
+        useDenseStorage();
+    }
 }
 
-void BQP::initialize(const vector<int> &initSolution) {
-    toUpperTriangular();
+BQP::BQP(vector<double> linear, Adjacency quadratic)
+    : linear(std::move(linear)),
+      quadratic(std::move(quadratic)),
+      nVars(this->linear.size()),
+      solutionQuality{0},
+      nIterations{0},
+      restartNum{0}, 
+      iterNum{0},  
+      evalNum{0}, 
+      upperBound{-std::numeric_limits<double>::max()} {
 
-    solution = initSolution;
-    solutionQuality = getObjective(solution);
-    nIterations = 1;
+    if (this->quadratic.offsets.empty()) {
+        this->quadratic.offsets.assign(nVars + 1, 0);
+    }
+    if (this->quadratic.num_variables() != nVars) {
+        throw Exception("quadratic must have a row for each variable");
+    }
+    for (int i = 0; i < nVars; i++) {
+        for (const Neighbor *n = this->quadratic.begin(i); n != this->quadratic.end(i); ++n) {
+            if ((n->var < 0) || (n->var >= nVars) || (n->var == i)) {
+                throw Exception("quadratic contains an invalid variable");
+            }
+        }
+    }
+
+    AdjacencyOptions options;
+    options.merge_duplicates = true;
+    arrange_adjacency(this->quadratic, options);
+
+    if (this->quadratic.neighbors.size() >= DENSE_STORAGE_DENSITY * nVars * (nVars - 1.)) {
+        useDenseStorage();
+    }
 }
 
-void BQP::toUpperTriangular() {
+template <class Weight>
+static std::shared_ptr<const vector<Weight>> denseCopy(const Adjacency &quadratic) {
+    const int nVars = quadratic.num_variables();
+    auto dense = std::make_shared<vector<Weight>>((size_t)nVars * nVars, 0);
     for (int i = 0; i < nVars; i++) {
-        for (int j = i + 1; j < nVars; j++) {
-            Q[i][j] = Q[i][j] + Q[j][i];
-            Q[j][i] = 0;
+        Weight *row = dense->data() + (size_t)i * nVars;
+        for (const Neighbor *n = quadratic.begin(i); n != quadratic.end(i); ++n) {
+            row[n->var] = n->weight;
         }
     }
+    return dense;
+}
+
+void BQP::useDenseStorage(bool singlePrecision) {
+    useSparseStorage();
+    if (singlePrecision) {
+        denseQuadraticFloat = denseCopy<float>(quadratic);
+    } else {
+        denseQuadratic = denseCopy<double>(quadratic);
+    }
+}
+
+void BQP::useSparseStorage() {
+    denseQuadratic.reset();
+    denseQuadraticFloat.reset();
+}
+
+void BQP::initialize(const vector<int> &initSolution) {
+    solution = initSolution;
+    solutionQuality = getObjective(solution);
+    nIterations = 1;
 }
 
 double BQP::getObjective(const vector<int> &solution) {
@@ -75,10 +145,10 @@ double BQP::getObjective(const vector<int> &solution) {
 
 double BQP::getChangeInObjective(const vector<int> &oldSolution, int flippedBit) {
     // Add up all biases associated with the variable at flippedBit
-    double change = Q[flippedBit][flippedBit];
-    for (int i = 0; i < nVars; i++) {
-        if ((oldSolution[i] == 1) && (i != flippedBit)) {
-            change += Q[flippedBit][i] + Q[i][flippedBit];
+    double change = linear[flippedBit];
+    for (const Neighbor *n = quadratic.begin(flippedBit); n != quadratic.end(flippedBit); ++n) {
+        if (oldSolution[n->var] == 1) {
+            change += n->weight;
         }
     }
 
@@ -87,11 +157,15 @@ double BQP::getChangeInObjective(const vector<int> &oldSolution, int flippedBit)
 }
 
 double BQP::getMaxBQPCoeff() {
-    double M = Q[0][0];
+    double M = linear[0];
     for (int i = 0; i < nVars; i++) {
-        for (int j = 0; j < nVars; j++) {
-            if (M < abs(Q[i][j])) {
-                M = abs(Q[i][j]);
+        if (M < abs(linear[i])) {
+            M = abs(linear[i]);
+        }
+        // each coefficient is split evenly over Q[i][j] and Q[j][i]
+        for (const Neighbor *n = quadratic.begin(i); n != quadratic.end(i); ++n) {
+            if (M < abs(.5 * n->weight)) {
+                M = abs(.5 * n->weight);
             }
         }
     }
@@ -99,18 +173,17 @@ double BQP::getMaxBQPCoeff() {
 }
 
 void BQP::printQ() {
-    printf("BQP: Number of variables: %d\nCoefficient matrix:\n", nVars);
+    printf("BQP: Number of variables: %d\nCoefficients:\n", nVars);
     printf("{\n");
     for (int i = 0; i < nVars; i++) {
-        printf("{");
-        for (int j = 0; j < nVars; j++) {
-            printf("%6f,", Q[i][j]);
+        printf("%d: {%d: %6f", i, i, linear[i]);
+        for (const Neighbor *n = quadratic.begin(i); n != quadratic.end(i); ++n) {
+            printf(", %d: %6f", n->var, n->weight);
         }
         printf("},\n");
     }
     printf("}\n");
 }
-
 void BQP::printSolution() {
     printf("Objective function value: %f\n", getObjective(solution));
     printf("Variable assignment:\n");
@@ -16,25 +16,68 @@
 
 #define _BQP_H_
 
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "graph.h"
+
+// The fraction of the pairs of variables that must interact for the
+// constructors of BQP to add the dense copy of the coefficients
+const double DENSE_STORAGE_DENSITY = .25;
+
+/**
+ * A BINARY-valued problem, stored sparsely: the diagonal of Q and, for each
+ * pair of variables i != j with a nonzero Q[i][j] + Q[j][i], that sum in the
+ * compressed sparse row adjacency of both (see graph.h). The objective of a
+ * solution x is sum_i linear[i] * x[i] + sum_{i < j} Q[i][j] * x[i] * x[j]
+ * over the quadratic coefficients.
+ */
 class BQP 
 {
     public:
-        BQP(std::vector<std::vector<double>> Q);
+        BQP();
+
+        /**
+         * Builds the problem of a dense, symmetric Q matrix
+         * @param Q: Symmetric Q matrix, see bqmToQ()
+         */
+        BQP(const std::vector<std::vector<double>> &Q);
+
+        /**
+         * Builds the problem of its linear and quadratic coefficients. The
+         * neighbors of each variable are sorted, and the duplicate ones merged.
+         * @param linear: The linear coefficient of each variable
+         * @param quadratic: The quadratic coefficients, each one in the rows
+         *        of both of its variables
+         */
+        BQP(std::vector<double> linear, Adjacency quadratic);
 
         /**
-         * Calls toUpperTriangular() and sets the solution
+         * Sets the solution
          * @return void
          */
         void initialize(const std::vector<int> &initSolution);
 
         /**
-         * Converts a generic bqp Q matrix into upper triangular using:
-         * Q[i][j] = Q[i][j] + Q[j][i] for all i < j
+         * Adds a dense, row-major copy of the quadratic coefficients, with a
+         * zero diagonal. The tabu search then updates the changes in
+         * objective of a flip over a whole contiguous row, which vectorizes,
+         * rather than over the neighbors of the flipped variable. This pays
+         * off when most pairs of variables interact, and the constructors
+         * call it for problems with a density of at least DENSE_STORAGE_DENSITY.
+         * @param singlePrecision: Store the coefficients as float, halving
+         *        the memory and bandwidth of the copy, at the cost of rounding
+         *        them to single precision in the search
          * @return void
          */
-        void toUpperTriangular();
+        void useDenseStorage(bool singlePrecision = false);
+
+        /**
+         * Removes the dense copy of the quadratic coefficients, if any
+         * @return void
+         */
+        void useSparseStorage();
 
         /**
          * Computes the value by which the objective function is changed if
@@ -53,13 +96,13 @@ class BQP
         double getObjective(const std::vector<int> &solution);
         
         /**
-         * Gets the maximum abs(Q[i][j])
+         * Gets the maximum abs(Q[i][j]) of the symmetric Q matrix
          * @return Maximum Q[i][j]
          */
         double getMaxBQPCoeff();
 
         /**
-         * Prints Q matrix
+         * Prints the coefficients of the problem
          * @return void
          */
         void printQ();
@@ -70,7 +113,10 @@ class BQP
          */
         void printSolution();
 
-        std::vector<std::vector<double> > Q;    // Q matrix
+        std::vector<double> linear;             // Linear coefficients, the diagonal of Q
+        Adjacency quadratic;                    // Quadratic coefficients, Q[i][j] + Q[j][i] for i != j
+        std::shared_ptr<const std::vector<double>> denseQuadratic;     // Optional dense copy of quadratic
+        std::shared_ptr<const std::vector<float>> denseQuadraticFloat; // Or its single precision copy
         int nVars;                              // Number of problem variables
         std::vector<int> solution;              // Current solution, vector of size nVars where every entry is 0 or 1
         double solutionQuality;                 // Objective function value at solution
@@ -83,4 +129,84 @@ class BQP
         double upperBound;
 };
 
+/**
+ * Builds the Q matrix of a BINARY-valued binary quadratic model, reading its
+ * biases in place. The linear biases are on the diagonal, and each quadratic
+ * bias is split evenly between Q[u][v] and Q[v][u].
+ * BQM is expected to provide the interface of dimod::BinaryQuadraticModel:
+ * num_variables(), linear(v), and cbegin_neighborhood(v)/cend_neighborhood(v)
+ * over terms with fields v and bias.
+ * @param bqm: The binary quadratic model
+ * @return Symmetric Q matrix
+ */
+template <class BQM>
+std::vector<std::vector<double>> bqmToQ(const BQM &bqm) {
+    int nVars = bqm.num_variables();
+    std::vector<std::vector<double>> Q(nVars, std::vector<double>(nVars, 0));
+    for (int i = 0; i < nVars; i++) {
+        Q[i][i] = bqm.linear(i);
+        for (auto it = bqm.cbegin_neighborhood(i); it != bqm.cend_neighborhood(i); ++it) {
+            Q[i][it->v] = .5 * it->bias;
+        }
+    }
+    return Q;
+}
+
+/**
+ * Builds the Q matrix of a BINARY-valued problem given by its graph, for
+ * instance one shared with another sampler, in the same layout as bqmToQ.
+ * The biases of couplers between the same two variables are summed.
+ * @param graph: The linear biases and adjacency of the problem
+ * @return Symmetric Q matrix
+ */
+inline std::vector<std::vector<double>> graphToQ(const IsingGraph &graph) {
+    int nVars = graph.num_variables();
+    std::vector<std::vector<double>> Q(nVars, std::vector<double>(nVars, 0));
+    for (int i = 0; i < nVars; i++) {
+        Q[i][i] += graph.linear[i];
+        for (const Neighbor *n = graph.adjacency.begin(i); n != graph.adjacency.end(i); ++n) {
+            Q[i][n->var] += .5 * n->weight;
+        }
+    }
+    return Q;
+}
+
+/**
+ * Builds the sparse problem of a BINARY-valued binary quadratic model,
+ * reading its biases in place, see bqmToQ().
+ * @param bqm: The binary quadratic model
+ * @return The problem
+ */
+template <class BQM>
+BQP bqmToBQP(const BQM &bqm) {
+    std::vector<double> linear(bqm.num_variables());
+    for (int i = 0; i < (int)linear.size(); i++) {
+        linear[i] = bqm.linear(i);
+    }
+    return BQP(std::move(linear), build_adjacency(bqm));
+}
+
+/**
+ * Builds the sparse problem of a BINARY-valued problem given by its graph,
+ * see graphToQ(). A coupler from a variable to itself adds to its linear bias.
+ * @param graph: The linear biases and adjacency of the problem
+ * @return The problem
+ */
+inline BQP graphToBQP(const IsingGraph &graph) {
+    std::vector<double> linear(graph.linear);
+    Adjacency quadratic;
+    quadratic.offsets.assign(graph.num_variables() + 1, 0);
+    for (int i = 0; i < graph.num_variables(); i++) {
+        for (const Neighbor *n = graph.adjacency.begin(i); n != graph.adjacency.end(i); ++n) {
+            if (n->var == i) {
+                linear[i] += .5 * n->weight;
+            } else {
+                quadratic.neighbors.push_back(*n);
+            }
+        }
+        quadratic.offsets[i + 1] = quadratic.neighbors.size();
+    }
+    return BQP(std::move(linear), std::move(quadratic));
+}
+
 #endif
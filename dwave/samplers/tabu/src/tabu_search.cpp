@@ -14,27 +14,434 @@
 
 #include "tabu_search.h"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
 
 #include "common.h"
-#include "tabu_utils.h"
+#include "deadline.h"
+#include "pool.h"
 
 using std::vector;
 using std::size_t;
 
-TabuSearch::TabuSearch(vector<vector<double>> Q, 
+// The dense row updates are compiled for AVX-512 and AVX2 as well as the
+// baseline on x86-64 with glibc, the best of which is picked at load time
+// (it relies on ifunc support). Elsewhere only the default is compiled.
+#if defined(__x86_64__) && defined(__GLIBC__) && (defined(__GNUC__) || defined(__clang__))
+#define TABU_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define TABU_TARGET_CLONES
+#endif
+
+// GCC does not vectorize loops at -O2 before version 12, so ask for it
+#if defined(__GNUC__) && !defined(__clang__)
+#define TABU_VECTORIZE __attribute__((optimize("tree-vectorize")))
+#else
+#define TABU_VECTORIZE
+#endif
+
+// Flipping a variable to `value` changes the change in objective of every
+// other variable j by Q[i][j] + Q[j][i] if j now differs from it, and by its
+// opposite otherwise. Given the row of the flipped variable in the dense
+// storage of BQP, whose diagonal is zero, this updates all of them at once.
+TABU_TARGET_CLONES TABU_VECTORIZE
+static void updateDenseRow(int nVars, const double *row, const int *solution,
+                           int value, double *changeInObjective) {
+    for (int j = 0; j < nVars; j++) {
+        double change = row[j];
+        changeInObjective[j] += (solution[j] != value)? change : -change;
+    }
+}
+
+// Same as above, for the single precision dense storage
+TABU_TARGET_CLONES TABU_VECTORIZE
+static void updateDenseRow(int nVars, const float *row, const int *solution,
+                           int value, double *changeInObjective) {
+    for (int j = 0; j < nVars; j++) {
+        double change = row[j];
+        changeInObjective[j] += (solution[j] != value)? change : -change;
+    }
+}
+
+// Updates the changes in objective for the flip of `flipped` in `solution`
+// with the dense storage of `bqp`. Returns false, leaving them unchanged, if
+// `bqp` has none.
+static bool updateDense(const BQP &bqp, int flipped, const vector<int> &solution,
+                        vector<double> &changeInObjective) {
+    const size_t offset = (size_t)flipped * bqp.nVars;
+    if (bqp.denseQuadratic) {
+        updateDenseRow(bqp.nVars, bqp.denseQuadratic->data() + offset, solution.data(),
+                       solution[flipped], changeInObjective.data());
+    } else if (bqp.denseQuadraticFloat) {
+        updateDenseRow(bqp.nVars, bqp.denseQuadraticFloat->data() + offset, solution.data(),
+                       solution[flipped], changeInObjective.data());
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+// The candidate moves of the simple tabu search: the change in objective of
+// flipping each variable that is not tabu, in a tournament tree over the
+// variables. Each node holds the minimum change of its leaves, how many of
+// them attain it, and how many of them are not tabu, so that the move the
+// search would find by scanning the variables in index order is found in
+// O(log nVars), and each change is updated in O(log nVars).
+class MoveTree {
+    public:
+        explicit MoveTree(int nVars) : size(1) {
+            while (size < nVars) size *= 2;
+            minChange.assign(2 * size, std::numeric_limits<double>::infinity());
+            numTies.assign(2 * size, 0);
+            numFree.assign(2 * size, 0);
+        }
+
+        // Sets every leaf, those with taboo[i] set being tabu
+        void build(const vector<double> &changeInObjective, const vector<char> &taboo) {
+            for (int i = 0; i < (int)changeInObjective.size(); i++) {
+                setLeaf(i, !taboo[i], changeInObjective[i]);
+            }
+            for (int node = size - 1; node > 0; node--) pull(node);
+        }
+
+        // Sets the change of a variable that is not tabu
+        void update(int var, double change) {
+            setLeaf(var, true, change);
+            for (int node = (size + var) / 2; node > 0; node /= 2) pull(node);
+        }
+
+        // Makes a variable tabu
+        void remove(int var) {
+            setLeaf(var, false, 0);
+            for (int node = (size + var) / 2; node > 0; node /= 2) pull(node);
+        }
+
+        // The number of variables that are not tabu
+        int free() const { return numFree[1]; }
+
+        // The smallest change, and how many variables have it
+        double min() const { return minChange[1]; }
+        int ties() const { return numTies[1]; }
+
+        // The first variable in index order whose change satisfies
+        // offset + change < bound, or -1 if there are none. Sets `position`
+        // to the number of variables up to it that are not tabu.
+        int firstBelow(double offset, double bound, long long &position) const {
+            if (!(offset + minChange[1] < bound)) return -1;
+            position = 1;
+            int node = 1;
+            while (node < size) {
+                if (offset + minChange[2 * node] < bound) {
+                    node = 2 * node;
+                } else {
+                    position += numFree[2 * node];
+                    node = 2 * node + 1;
+                }
+            }
+            return node - size;
+        }
+
+        // The `tie`-th variable in index order among those with the
+        // smallest change, counting from 0
+        int nthTie(int tie) const {
+            const double target = minChange[1];
+            int node = 1;
+            while (node < size) {
+                int left = (minChange[2 * node] == target)? numTies[2 * node] : 0;
+                if (tie < left) {
+                    node = 2 * node;
+                } else {
+                    tie -= left;
+                    node = 2 * node + 1;
+                }
+            }
+            return node - size;
+        }
+
+    private:
+        void setLeaf(int var, bool isFree, double change) {
+            const int leaf = size + var;
+            minChange[leaf] = isFree? change : std::numeric_limits<double>::infinity();
+            numTies[leaf] = isFree;
+            numFree[leaf] = isFree;
+        }
+
+        void pull(int node) {
+            const int left = 2 * node, right = 2 * node + 1;
+            const double m = std::min(minChange[left], minChange[right]);
+            minChange[node] = m;
+            numTies[node] = ((minChange[left] == m)? numTies[left] : 0) +
+                            ((minChange[right] == m)? numTies[right] : 0);
+            numFree[node] = numFree[left] + numFree[right];
+        }
+
+        int size;
+        vector<double> minChange;
+        vector<int> numTies;
+        vector<int> numFree;
+};
+
+// Whether rebuilding a tree with numLeaves leaves costs less than updating
+// `changed` of them one at a time, as it does for the dense rows of a problem
+inline bool rebuildCheaper(int changed, int numLeaves) {
+    return 8 * changed > numLeaves;
+}
+
+// The variables that selectVariables can still select, with their estimates
+// d, in a tree over the variables. Given the smallest and largest estimate,
+// the probability weight of a variable is a linear function of its estimate
+// whose coefficients depend on its sign, so each node holds the sums and the
+// numbers of the nonpositive and positive estimates of its leaves, besides
+// their extremes. The total weight, and the variable that scanning the
+// cumulative weights in index order would select, are then found in
+// O(log nVars), and each estimate is updated in O(log nVars).
+class SelectionTree {
+    public:
+        explicit SelectionTree(int nVars) : size(1) {
+            while (size < nVars) size *= 2;
+            nodes.assign(2 * size, Node());
+        }
+
+        // Sets every leaf, those with selected[i] set being selected already
+        void build(const vector<double> &d, const vector<int> &selected) {
+            for (int i = 0; i < (int)d.size(); i++) {
+                setLeaf(i, !selected[i], d[i]);
+            }
+            for (int node = size - 1; node > 0; node--) pull(node);
+        }
+
+        // Sets the estimate of a variable that is not selected
+        void update(int var, double d) {
+            setLeaf(var, true, d);
+            for (int node = (size + var) / 2; node > 0; node /= 2) pull(node);
+        }
+
+        // Marks a variable as selected
+        void remove(int var) {
+            setLeaf(var, false, 0);
+            for (int node = (size + var) / 2; node > 0; node /= 2) pull(node);
+        }
+
+        // The smallest and largest estimates of the variables not selected
+        double min() const { return nodes[1].dmin; }
+        double max() const { return nodes[1].dmax; }
+
+        // The sum of the weights of the variables not selected
+        double total() const { return weight(nodes[1]); }
+
+        // The first variable not selected at which the cumulative weight,
+        // in index order, reaches `target`, or the last one if rounding
+        // leaves the total short of it
+        int pick(double target) const {
+            int node = 1;
+            while (node < size) {
+                const Node &left = nodes[2 * node];
+                const double leftWeight = weight(left);
+                if (left.numFree > 0 && (target <= leftWeight || nodes[2 * node + 1].numFree == 0)) {
+                    node = 2 * node;
+                } else {
+                    target -= leftWeight;
+                    node = 2 * node + 1;
+                }
+            }
+            return node - size;
+        }
+
+    private:
+        struct Node {
+            int numFree = 0;
+            int numNonPositive = 0;
+            double sumNonPositive = 0;
+            double sumPositive = 0;
+            double dmin = std::numeric_limits<double>::max();
+            double dmax = -std::numeric_limits<double>::max();
+        };
+
+        // The weights given to the estimates by selectVariables: 1 each if
+        // they are all equal, 1 - d / dmin for nonpositive ones if dmin is
+        // negative, 0 for zeros if dmin is zero, and 1 + LAMBDA * d / dmax
+        // for the others
+        double weight(const Node &node) const {
+            const double dmin = nodes[1].dmin, dmax = nodes[1].dmax;
+            if (dmin == dmax) {
+                return node.numFree;
+            }
+            double w = 0;
+            if (dmin < 0) {
+                w += node.numNonPositive - node.sumNonPositive / dmin;
+            }
+            const int numPositive = node.numFree - node.numNonPositive;
+            if (numPositive > 0) {
+                w += numPositive + LAMBDA * (node.sumPositive / dmax);
+            }
+            return w;
+        }
+
+        void setLeaf(int var, bool isFree, double d) {
+            Node &leaf = nodes[size + var];
+            leaf = Node();
+            if (isFree) {
+                leaf.numFree = 1;
+                leaf.numNonPositive = d <= 0;
+                (d <= 0? leaf.sumNonPositive : leaf.sumPositive) = d;
+                leaf.dmin = leaf.dmax = d;
+            }
+        }
+
+        void pull(int node) {
+            const Node &left = nodes[2 * node], &right = nodes[2 * node + 1];
+            Node &parent = nodes[node];
+            parent.numFree = left.numFree + right.numFree;
+            parent.numNonPositive = left.numNonPositive + right.numNonPositive;
+            parent.sumNonPositive = left.sumNonPositive + right.sumNonPositive;
+            parent.sumPositive = left.sumPositive + right.sumPositive;
+            parent.dmin = std::min(left.dmin, right.dmin);
+            parent.dmax = std::max(left.dmax, right.dmax);
+        }
+
+        int size;
+        vector<Node> nodes;
+};
+
+// The variables that steepestAscent has yet to set, by their position in its
+// selection, in a tournament tree that holds the position of the largest
+// pair (q1, q2) of its leaves, the first one among equals, so that the next
+// variable to set is found in O(1) and each pair is updated in
+// O(log numSelection).
+class AscentTree {
+    public:
+        explicit AscentTree(int numSelection) : size(1) {
+            while (size < numSelection) size *= 2;
+            best.assign(2 * size, -1);
+            q1.assign(size, 0);
+            q2.assign(size, 0);
+        }
+
+        // Sets the pairs of every position, those with done[p] set being set
+        void build(const vector<double> &pairs1, const vector<double> &pairs2, const vector<char> &done) {
+            for (int p = 0; p < (int)done.size(); p++) {
+                q1[p] = pairs1[p];
+                q2[p] = pairs2[p];
+                best[size + p] = done[p]? -1 : p;
+            }
+            for (int node = size - 1; node > 0; node--) pull(node);
+        }
+
+        // Sets the pair of a position that is not set
+        void update(int position, double pair1, double pair2) {
+            q1[position] = pair1;
+            q2[position] = pair2;
+            for (int node = (size + position) / 2; node > 0; node /= 2) pull(node);
+        }
+
+        // Marks a position as set
+        void remove(int position) {
+            best[size + position] = -1;
+            for (int node = (size + position) / 2; node > 0; node /= 2) pull(node);
+        }
+
+        // The position with the largest pair
+        int top() const { return best[1]; }
+
+    private:
+        void pull(int node) {
+            const int left = best[2 * node], right = best[2 * node + 1];
+            if (left < 0 || (right >= 0 && (q1[right] > q1[left] ||
+                                            (q1[right] == q1[left] && q2[right] > q2[left])))) {
+                best[node] = right;
+            } else {
+                best[node] = left;
+            }
+        }
+
+        int size;
+        vector<int> best;
+        vector<double> q1;
+        vector<double> q2;
+};
+
+}  // namespace
+
+ElitePool::ElitePool(int capacity) : capacity(capacity) {
+    if (capacity < 1) {
+        throw Exception("the capacity of an elite pool must be positive");
+    }
+}
+
+void ElitePool::offer(const vector<int> &solution, double objective) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    int worst = -1;
+    for (int i = 0; i < (int)solutions.size(); i++) {
+        if (objectives[i] == objective && solutions[i] == solution) {
+            return;
+        }
+        if (worst < 0 || objectives[i] > objectives[worst]) {
+            worst = i;
+        }
+    }
+
+    if ((int)solutions.size() < capacity) {
+        solutions.push_back(solution);
+        objectives.push_back(objective);
+    } else if (objective < objectives[worst]) {
+        solutions[worst] = solution;
+        objectives[worst] = objective;
+    }
+}
+
+bool ElitePool::draw(StreamRng &generator, vector<int> &solution, double &objective) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (solutions.empty()) {
+        return false;
+    }
+    int i = generator.below(solutions.size());
+    solution = solutions[i];
+    objective = objectives[i];
+    return true;
+}
+
+int ElitePool::size() {
+    std::lock_guard<std::mutex> guard(lock);
+    return solutions.size();
+}
+
+TabuSearch::TabuSearch(const vector<vector<double>> &Q, 
                        const vector<int> initSol, 
                        int tenure, 
                        long int timeout,
                        int numRestarts,
-                       unsigned int seed,
+                       std::uint64_t seed,
                        double energyThreshold,
                        int coeffZFirst,
                        int coeffZRestart,
                        int lowerBoundZ) 
-    : bqp(Q) {
+    : TabuSearch(BQP(Q), initSol, tenure, timeout, numRestarts, seed,
+                 energyThreshold, coeffZFirst, coeffZRestart, lowerBoundZ) {}
+
+TabuSearch::TabuSearch(const BQP &problem, 
+                       const vector<int> initSol, 
+                       int tenure, 
+                       long int timeout,
+                       int numRestarts,
+                       std::uint64_t seed,
+                       double energyThreshold,
+                       int coeffZFirst,
+                       int coeffZRestart,
+                       int lowerBoundZ,
+                       ElitePool *elitePool,
+                       std::uint64_t stream) 
+    : bqp(problem), generator(seed, stream), elitePool(elitePool) {
     
-    size_t nvars = Q.size();
+    size_t nvars = bqp.nVars;
     if (initSol.size() != nvars)
         throw Exception("length of init_solution doesn't match the size of Q");
 
@@ -48,8 +455,6 @@ TabuSearch::TabuSearch(vector<vector<double>> Q,
         tabooTenure = (20 < (int)(bqp.nVars / 4.0))? 20 : (int)(bqp.nVars / 4.0);
     }
 
-    generator.seed(seed);
-
     // Solve and update bqp
     multiStartTabuSearch(timeout, numRestarts, energyThreshold, coeffZFirst, coeffZRestart,
                          lowerBoundZ, initSol, nullptr);
@@ -70,6 +475,16 @@ int TabuSearch::numRestarts()
     return bqp.restartNum;
 }
 
+unsigned long long TabuSearch::numIterations()
+{
+    return bqp.iterNum;
+}
+
+unsigned long long TabuSearch::numEvaluations()
+{
+    return bqp.evalNum;
+}
+
 void TabuSearch::multiStartTabuSearch(long long timeLimitInMilliSecs, 
                                       int numRestarts, 
                                       double energyThreshold,
@@ -79,7 +494,9 @@ void TabuSearch::multiStartTabuSearch(long long timeLimitInMilliSecs,
                                       const vector<int> &initSolution, 
                                       const bqpSolver_Callback *callback) {
 
-    long long startTime = realtime_clock();
+    // a single deadline for the whole search, which the restarts share
+    Deadline deadline(timeLimitInMilliSecs >= 0 ? timeLimitInMilliSecs / 1000.0
+                                                : std::numeric_limits<double>::infinity());
 
     vector<int> I(bqp.nVars); // will store set of variables to apply steepest ascent to
 
@@ -98,27 +515,31 @@ void TabuSearch::multiStartTabuSearch(long long timeLimitInMilliSecs,
     long long maxIterRestartedSearch = (lowerBoundZ > coeffZRestart * (long long)bqp.nVars) ? lowerBoundZ : coeffZRestart * (long long)bqp.nVars;
     bqp.initialize(initSolution);
 
-    bool useTimeLimit = timeLimitInMilliSecs >= 0;
-
     simpleTabuSearch(bqp.solution, 
                      bqp.solutionQuality, 
                      maxIterInitialSearch, 
-                     timeLimitInMilliSecs, 
-                     useTimeLimit, 
+                     deadline, 
                      energyThreshold, 
                      callback);
 
     double bestSolutionQuality = bqp.solutionQuality;
     vector<int> bestSolution(bqp.solution.begin(), bqp.solution.end());
+    if (elitePool != nullptr) {
+        elitePool->offer(bqp.solution, bqp.solutionQuality);
+    }
 
-    vector<vector<double>> C(bqp.nVars, vector<double>(bqp.nVars));
+    vector<double> C(bqp.nVars);
 
     for (long iter = 0; iter < numRestarts; iter++) {
-        if ((bestSolutionQuality <= energyThreshold) ||
-            (useTimeLimit && (realtime_clock() - startTime) > timeLimitInMilliSecs)) {
+        if ((bestSolutionQuality <= energyThreshold) || deadline.check()) {
             break;
         }
 
+        // Cooperating searches restart from any of the elite solutions
+        if (elitePool != nullptr) {
+            elitePool->draw(generator, bqp.solution, bqp.solutionQuality);
+        }
+
         // Compute coefficients from current solution (used later to get solution from steepestAscent())
         computeC(C, bqp.solution);
 
@@ -146,8 +567,7 @@ void TabuSearch::multiStartTabuSearch(long long timeLimitInMilliSecs,
         simpleTabuSearch(bqp.solution, 
                          bqp.solutionQuality, 
                          maxIterRestartedSearch, 
-                         timeLimitInMilliSecs - (realtime_clock() - startTime), 
-                         useTimeLimit, 
+                         deadline, 
                          energyThreshold, 
                          callback);
     
@@ -155,6 +575,9 @@ void TabuSearch::multiStartTabuSearch(long long timeLimitInMilliSecs,
             bestSolutionQuality = bqp.solutionQuality;
             bestSolution = bqp.solution;
         }
+        if (elitePool != nullptr) {
+            elitePool->offer(bqp.solution, bqp.solutionQuality);
+        }
 
         if (callback != nullptr) {
             callback->func(callback, &bqp);
@@ -168,92 +591,99 @@ void TabuSearch::multiStartTabuSearch(long long timeLimitInMilliSecs,
 void TabuSearch::simpleTabuSearch(const vector<int> &starting,
                                   double startingObjective,
                                   long long maxIter,
-                                  long long timeLimitInMilliSecs,
-                                  bool useTimeLimit,
+                                  Deadline &deadline,
                                   double energyThreshold,
                                   const bqpSolver_Callback *callback) {
 
-    long long startTime = realtime_clock();
     bqp.solutionQuality = startingObjective;
 
-    vector<int> taboo(bqp.nVars);  // used to keep track of history of flipped bits
+    vector<char> taboo(bqp.nVars, 0);  // used to keep track of history of flipped bits
     vector<int> solution(bqp.nVars);
     vector<double> changeInObjective(bqp.nVars);
 
     for (int i = 0; i < bqp.nVars; i++) {
-        taboo[i] = 0;
         solution[i] = starting[i];
         bqp.solution[i] = starting[i];
         changeInObjective[i] = bqp.getChangeInObjective(starting, i);
     }
 
+    MoveTree moves(bqp.nVars);
+    moves.build(changeInObjective, taboo);
+
+    // the tabu variables, in the order they were flipped, each with the step
+    // it was flipped at. A variable stays tabu for tabooTenure steps.
+    std::deque<std::pair<int, long long>> tabooList;
+    long long step = 0;
+
     double prevCost = bqp.solutionQuality;
     double cost = 0;
 
-    vector<int> tieList(bqp.nVars);
-
     long long iter = 0;
 
     while (iter < maxIter) {
-        if ((bqp.solutionQuality <= energyThreshold) ||
-            (useTimeLimit && (realtime_clock() - startTime) > timeLimitInMilliSecs)) {
+        // the deadline only reads the clock every so many iterations
+        if ((bqp.solutionQuality <= energyThreshold) || deadline.expired()) {
             break;
         }
 
         bqp.iterNum++; // added to record more statistics
         double localMinCost = std::numeric_limits<double>::max();
-        int bestK = -1;
         bool globalMinFound = false;
-        int numTies = 0;
         bqp.evalNum += bqp.nVars; // added to record more statistics
 
-        for (int k = 0; k < bqp.nVars; k++) {
-            if (taboo[k] != 0) {
-                // variable at k was not recently flipped
-                continue;
-            }
-            iter++;
-            cost = prevCost + changeInObjective[k];
-            if (cost < bqp.solutionQuality) {
-                globalMinFound = true;
-                bestK = k;
-                break;
-            }
-            if (cost < localMinCost) {
-                bestK = k;
-                localMinCost = cost;
-                tieList[0] = k;
-                numTies = 1;
-            }
-            else if (cost == localMinCost) {
-                tieList[numTies] = k; numTies++;
-            }
+        while (!tabooList.empty() && tabooList.front().second + tabooTenure < step) {
+            int i = tabooList.front().first;
+            taboo[i] = 0;
+            moves.update(i, changeInObjective[i]);
+            tabooList.pop_front();
         }
 
-        if (!globalMinFound && numTies > 1) {
-            bestK = numTies * (double)generator() / ((double)generator.max() + 1);
-            bestK = tieList[bestK];
+        // the first move that improves on the best solution, or else one of
+        // the best moves, with every move that is not tabu counted as an
+        // iteration up to the one taken
+        long long position = 0;
+        int bestK = moves.firstBelow(prevCost, bqp.solutionQuality, position);
+        if (bestK >= 0) {
+            globalMinFound = true;
+            iter += position;
+            cost = prevCost + changeInObjective[bestK];
         }
-        for (int i = 0; i < bqp.nVars; i++) {
-            if (taboo[i] > 0) {
-                taboo[i] = taboo[i] - 1;
+        else if (moves.free() > 0) {
+            iter += moves.free();
+            localMinCost = prevCost + moves.min();
+            int numTies = moves.ties();
+            int tie = 0;
+            if (numTies > 1) {
+                tie = generator.below(numTies);
             }
+            bestK = moves.nthTie(tie);
         }
+        step++;
         if (bestK == -1) {
             continue;
         }
         solution[bestK] = 1 - solution[bestK];
         prevCost = localMinCost;
-        for (int i = 0; i < bestK; i++) {
-            double change = bqp.Q[i][bestK];
-            changeInObjective[i] += (solution[i] != solution[bestK])? change : -change; 
-        }
-        for (int i = bestK + 1; i < bqp.nVars; i++) {
-            double change = bqp.Q[bestK][i];
-            changeInObjective[i] += (solution[i] != solution[bestK])? change : -change;
+        // a dense row changes almost every move, so the tree is rebuilt
+        // rather than updated for each of them
+        const bool dense = updateDense(bqp, bestK, solution, changeInObjective);
+        if (!dense) {
+            for (const Neighbor *n = bqp.quadratic.begin(bestK); n != bqp.quadratic.end(bestK); ++n) {
+                double change = n->weight;
+                changeInObjective[n->var] += (solution[n->var] != solution[bestK])? change : -change;
+                if (!taboo[n->var]) {
+                    moves.update(n->var, changeInObjective[n->var]);
+                }
+            }
         }
         changeInObjective[bestK] = -changeInObjective[bestK];
-        taboo[bestK] = tabooTenure;
+        taboo[bestK] = 1;
+        if (dense) {
+            moves.build(changeInObjective, taboo);
+        } else {
+            moves.remove(bestK);
+        }
+        tabooList.emplace_back(bestK, step - 1);
         if (globalMinFound) {
             localSearchInternal(solution, cost, changeInObjective);
             solution = bqp.solution;
@@ -261,12 +691,16 @@ void TabuSearch::simpleTabuSearch(const vector<int> &starting,
             iter += bqp.nIterations;
             bqp.nIterations = iter;
 
+            // the local search changes any number of moves
+            moves.build(changeInObjective, taboo);
+
             if (callback != nullptr) {
                 callback->func(callback, &bqp);
             }
 
-            if (bqp.solutionQuality <= bqp.upperBound) {
-                timeLimitInMilliSecs = 0;
+            // a timed search that reaches the upper bound ends this restart
+            if (deadline.timed() && bqp.solutionQuality <= bqp.upperBound) {
+                break;
             }
         }
     }
@@ -288,9 +722,10 @@ void TabuSearch::localSearchInternal(const vector<int> &starting, double startin
                 bqp.solution[i] = 1 - bqp.solution[i];
                 bqp.solutionQuality = bqp.solutionQuality + changeInObjective[i];
                 changeInObjective[i] = -changeInObjective[i];
-                for (int j = 0; j < bqp.nVars; j++) {
-                    if (j != i) {
-                        double change = bqp.Q[i][j] + bqp.Q[j][i];
+                if (!updateDense(bqp, i, bqp.solution, changeInObjective)) {
+                    for (const Neighbor *n = bqp.quadratic.begin(i); n != bqp.quadratic.end(i); ++n) {
+                        double change = n->weight;
+                        int j = n->var;
                         changeInObjective[j] += (bqp.solution[j] != bqp.solution[i])? change : -change;
                     }
                 }
@@ -301,177 +736,250 @@ void TabuSearch::localSearchInternal(const vector<int> &starting, double startin
     bqp.nIterations = iter;
 }
 
-void TabuSearch::selectVariables(int numSelection, vector<vector<double>> &C, vector<int> &I) {
-    int i, ctr;
-    vector<double> d(bqp.nVars);   // estimate used to calculate e
-    for (i = 0; i < bqp.nVars; i++) {
-        d[i] = C[i][i];
-    }
+// The entry C[i][j] of the C matrix for the neighbor n of i: Q[i][j] + Q[j][i]
+// if i and j differ in `solution`, and its opposite otherwise
+static inline double coefficient(const vector<int> &solution, int i, const Neighbor &n) {
+    return (solution[i] == solution[n.var])? -n.weight : n.weight;
+}
 
-    vector<double> e(bqp.nVars);   // used to assign probability of being selected as a free variable  
-    vector<double> prob(bqp.nVars);
-    vector<int> selected(bqp.nVars, 0);   
-    double prevProb, sumE;
+void TabuSearch::selectVariables(int numSelection, const vector<double> &C, vector<int> &I) {
+    vector<double> d(C);   // estimate used to calculate the probability of being selected as a free variable
+    vector<int> selected(bqp.nVars, 0);
+    vector<int> changed;
+
+    SelectionTree candidates(bqp.nVars);
+    candidates.build(d, selected);
+
+    for (int ctr = 0; ctr < numSelection; ctr++) {
+        // if every weight is zero, the first variable is selected
+        double sumE = candidates.total();
+        double selectedProb = generator.uniform();
+        int selectedVar = candidates.pick((sumE == 0)? 0 : selectedProb * sumE);
 
-    for (ctr = 0; ctr < numSelection; ctr++) {
-        double dmin = std::numeric_limits<double>::max();
-        double dmax = -std::numeric_limits<double>::max();
-        for (i = 0; i < bqp.nVars; i++) {
-            if (selected[i] == 1) {
-                continue;
-            }
-            if (d[i] > dmax) {
-                dmax = d[i];
-            }
-            if (d[i] < dmin) {
-                dmin = d[i];
-            }
-        }
-        if (dmin == dmax) {
-            for (i = 0; i < bqp.nVars; i++) {
-                if (selected[i] == 1) {
-                    continue;
-                }
-                e[i] = 1;
-            }
-        }
-        else {
-            for (i = 0; i < bqp.nVars; i++) {
-                if(selected[i] == 1) {
-                    continue;
-                }
-                if (d[i] <= 0 && dmin < 0) {
-                    // Default lambda is large, d[i]
-                    // selected only after exhausing positive d[i]
-                    e[i] = 1 - d[i] / dmin;
-                }
-                else if (d[i] == dmin && dmin == 0) {
-                    e[i] = 0;
-                }
-                else {
-                    e[i] = 1 + LAMBDA * (d[i] / dmax);
-                }
-            }
-        }
-        for (i = 0, sumE = 0, prevProb = 0; i < bqp.nVars; i++) {
-            if (selected[i] == 1) {
-                continue;
-            }
-            prob[i] = prevProb + e[i];
-            prevProb = prob[i];
-            sumE = sumE + e[i];
-        }
-        if (sumE == 0) {
-            sumE = 1;
-            for (i = 0; i < bqp.nVars; i++) {
-                if (selected[i] == 0) {
-                    if (prob[i] == 0) {
-                        prob[i] = 1;
-                    }
-                    else {
-                        printf("ERROR: probability is non-zero and yet the sum is zero\n");
-                    }
-                }
-            }
-        }
-        double selectedProb = (double)generator() / ((double)generator.max() + 1);
-        int selectedVar = -1;
-        for (int i = 0; i < bqp.nVars; i++) {
-            if (selected[i] == 1) {
-                continue;
-            }
-            if (selectedProb <= prob[i] / sumE) {
-                selectedVar = i;
-                break;
-            }
-        }
-        if (selectedVar < 0 || selectedVar > bqp.nVars - 1) {
-            printf("ERROR!!!\n");
-        }
         I[ctr] = selectedVar;
         selected[selectedVar] = 1;
-        for (int i = 0; i < bqp.nVars; i++) {
-            if (selected[i] == 0) {
-                d[i] = d[i] + C[i][selectedVar];    // update d for each unselected variable
+        changed.clear();
+        for (const Neighbor *n = bqp.quadratic.begin(selectedVar); n != bqp.quadratic.end(selectedVar); ++n) {
+            if (selected[n->var] == 0) {
+                d[n->var] = d[n->var] + coefficient(bqp.solution, selectedVar, *n);    // update d for each unselected variable
+                changed.push_back(n->var);
+            }
+        }
+        if (rebuildCheaper(changed.size(), bqp.nVars)) {
+            candidates.build(d, selected);
+        } else {
+            candidates.remove(selectedVar);
+            for (int i : changed) {
+                candidates.update(i, d[i]);
             }
         }
     }
 }
 
-void TabuSearch::steepestAscent(int numSelection, vector<vector<double>> &C, vector<int> &I, vector<int> &solution) {
-    int i, j, ctr;
-    int idI, idJ, r, v = 0;
-    vector<double> h1(bqp.nVars);
-    vector<double> h2(bqp.nVars);
-    vector<double> q1(bqp.nVars);
-    vector<double> q2(bqp.nVars);
-    vector<int> visited(bqp.nVars, 0);
+void TabuSearch::steepestAscent(int numSelection, const vector<double> &C, vector<int> &I, vector<int> &solution) {
+    // the state of the selected variables, by their position in I
+    vector<double> h1(numSelection);
+    vector<double> h2(numSelection, 0);
+    vector<double> q1(numSelection);
+    vector<double> q2(numSelection);
+    vector<char> visited(numSelection, 0);
+    vector<int> position(bqp.nVars, -1);
 
     std::fill(solution.begin(), solution.end(), 0); // all vars outside of selected variables (I) stay fixed at 0
 
-    for (i = 0; i < numSelection; i++) {
-        idI = I[i];
-        h1[idI] = C[idI][idI];
-        h2[idI] = 0;
-        for (j = 0; j < numSelection; j++) {
-            idJ = I[j];
-            if (idJ != idI) {
-                h2[idI] = h2[idI] + (C[idI][idJ]);
+    for (int p = 0; p < numSelection; p++) {
+        position[I[p]] = p;
+    }
+    for (int p = 0; p < numSelection; p++) {
+        int idI = I[p];
+        h1[p] = C[idI];
+        for (const Neighbor *n = bqp.quadratic.begin(idI); n != bqp.quadratic.end(idI); ++n) {
+            if (position[n->var] >= 0) {
+                h2[p] = h2[p] + coefficient(bqp.solution, idI, *n);
             }
         }
-        h2[idI] = h2[idI] * 1;
     }
 
-    for (ctr = 0; ctr < numSelection; ctr++) {
-        double V1 = -std::numeric_limits<double>::max();
-        double V2 = -std::numeric_limits<double>::max();
-        for (i = 0; i < numSelection; i++) {
-            idI = I[i];
-            if (visited[idI] == 1) {
-                continue;
-            }
-            q1[idI] = 2 * h1[idI] + h2[idI];
-            q2[idI] = h1[idI];
-            if (q1[idI] > 0 || (q1[idI] == 0 && q2[idI] >= 0)) {
-                r = 1;
-            }
-            else {
-                r = 0;
-                q1[idI] = -q1[idI];
-                q2[idI] = -q2[idI];
-            }
-            if (q1[idI] > V1 ||(q1[idI] == V1 && q2[idI] > V2)) {
-                V1 = q1[idI];
-                V2 = q2[idI];
-                j = idI;
-                v = r;
-            }
+    // the value the variable at p would be set to, with its pair (q1, q2)
+    auto evaluate = [&](int p) {
+        q1[p] = 2 * h1[p] + h2[p];
+        q2[p] = h1[p];
+        if (q1[p] > 0 || (q1[p] == 0 && q2[p] >= 0)) {
+            return 1;
         }
+        q1[p] = -q1[p];
+        q2[p] = -q2[p];
+        return 0;
+    };
+    for (int p = 0; p < numSelection; p++) {
+        evaluate(p);
+    }
+
+    vector<int> changed;
+    AscentTree moves(numSelection);
+    moves.build(q1, q2, visited);
+
+    for (int ctr = 0; ctr < numSelection; ctr++) {
+        int p = moves.top();
+        int j = I[p];
+        int v = evaluate(p);
         solution[j] = v;
-        visited[j] = 1;
-        for (i = 0; i < numSelection; i++) {
-            idI = I[i];
-            if (visited[idI] == 1) {
+        visited[p] = 1;
+        changed.clear();
+        for (const Neighbor *n = bqp.quadratic.begin(j); n != bqp.quadratic.end(j); ++n) {
+            int k = position[n->var];
+            if (k < 0 || visited[k] == 1) {
                 continue;
             }
-            h2[idI] = h2[idI] - 1 * (C[idI][j]);
+            double c = coefficient(bqp.solution, j, *n);
+            h2[k] = h2[k] - c;
             if (v == 1) {
-                h1[idI] = h1[idI] + 1 * (C[idI][j]);
+                h1[k] = h1[k] + c;
+            }
+            evaluate(k);
+            changed.push_back(k);
+        }
+        if (rebuildCheaper(changed.size(), numSelection)) {
+            moves.build(q1, q2, visited);
+        } else {
+            moves.remove(p);
+            for (int k : changed) {
+                moves.update(k, q1[k], q2[k]);
             }
         }
     }
 }
 
-void TabuSearch::computeC(vector<vector<double>> &C, const vector<int> &solution) {
+void TabuSearch::computeC(vector<double> &C, const vector<int> &solution) {
     for (int i = 0; i < bqp.nVars; i++) {
-        C[i][i] = -bqp.Q[i][i];
-        for (int j = i + 1; j < bqp.nVars; j++) {
-            if (solution[j] == 1) {
-                C[i][i] += -(bqp.Q[i][j]);
+        double diagonal = -bqp.linear[i];
+        for (const Neighbor *n = bqp.quadratic.begin(i); n != bqp.quadratic.end(i); ++n) {
+            if (n->var > i && solution[n->var] == 1) {
+                diagonal += -n->weight;
+            }
+        }
+        C[i] = (solution[i] == 1)? -diagonal : diagonal;
+    }
+}
+
+/**
+ * Runs the searches of multiReadTabuSearch, the one of each read with stream
+ * streams[read].second of seed streams[read].first
+ */
+static void runTabuSearches(const BQP &problem,
+                            const vector<vector<int>> &initSolutions,
+                            const vector<std::pair<std::uint64_t, std::uint64_t>> &streams,
+                            int tenure,
+                            long int timeout,
+                            int numRestarts,
+                            double energyThreshold,
+                            int coeffZFirst,
+                            int coeffZRestart,
+                            int lowerBoundZ,
+                            int numThreads,
+                            vector<vector<int>> &solutions,
+                            vector<int> &restarts,
+                            int elitePoolSize,
+                            vector<unsigned long long> *iterations,
+                            vector<unsigned long long> *evaluations) {
+
+    const int numReads = initSolutions.size();
+    solutions.assign(numReads, vector<int>());
+    restarts.assign(numReads, 0);
+    if (iterations) iterations->assign(numReads, 0);
+    if (evaluations) evaluations->assign(numReads, 0);
+
+    std::unique_ptr<ElitePool> elitePool;
+    if (elitePoolSize > 0) {
+        elitePool.reset(new ElitePool(elitePoolSize));
+    }
+
+    // each thread claims reads from a shared counter, and stops at the first
+    // error, which is rethrown once all of them are done
+    std::atomic<int> nextRead(0);
+    std::atomic<bool> stop(false);
+    std::mutex lock;
+    std::exception_ptr error;
+
+    auto worker = [&]() {
+        while (!stop) {
+            const int read = nextRead++;
+            if (read >= numReads) break;
+
+            try {
+                TabuSearch search(problem, initSolutions[read], tenure, timeout,
+                                  numRestarts, streams[read].first, energyThreshold,
+                                  coeffZFirst, coeffZRestart, lowerBoundZ,
+                                  elitePool.get(), streams[read].second);
+                solutions[read] = search.bestSolution();
+                restarts[read] = search.numRestarts();
+                if (iterations) (*iterations)[read] = search.numIterations();
+                if (evaluations) (*evaluations)[read] = search.numEvaluations();
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!error) error = std::current_exception();
+                stop = true;
             }
-            C[i][j] = (solution[i] == solution[j])? -bqp.Q[i][j] : bqp.Q[i][j];
-            C[j][i] = C[i][j];
         }
-        C[i][i] = (solution[i] == 1)? -C[i][i] : C[i][i];
+    };
+
+    numThreads = std::min(numThreads, numReads);
+    run_parallel(numThreads, worker);
+
+    if (error) std::rethrow_exception(error);
+}
+
+void multiReadTabuSearch(const BQP &problem,
+                         const vector<vector<int>> &initSolutions,
+                         const vector<unsigned int> &seeds,
+                         int tenure,
+                         long int timeout,
+                         int numRestarts,
+                         double energyThreshold,
+                         int coeffZFirst,
+                         int coeffZRestart,
+                         int lowerBoundZ,
+                         int numThreads,
+                         vector<vector<int>> &solutions,
+                         vector<int> &restarts,
+                         int elitePoolSize,
+                         vector<unsigned long long> *iterations,
+                         vector<unsigned long long> *evaluations) {
+    if (seeds.size() != initSolutions.size()) {
+        throw Exception("length of seeds doesn't match the number of initial solutions");
     }
+    vector<std::pair<std::uint64_t, std::uint64_t>> streams;
+    streams.reserve(seeds.size());
+    for (unsigned int seed : seeds) streams.emplace_back(seed, 0);
+
+    runTabuSearches(problem, initSolutions, streams, tenure, timeout, numRestarts,
+                    energyThreshold, coeffZFirst, coeffZRestart, lowerBoundZ,
+                    numThreads, solutions, restarts, elitePoolSize, iterations, evaluations);
+}
+
+void multiReadTabuSearch(const BQP &problem,
+                         const vector<vector<int>> &initSolutions,
+                         std::uint64_t seed,
+                         int tenure,
+                         long int timeout,
+                         int numRestarts,
+                         double energyThreshold,
+                         int coeffZFirst,
+                         int coeffZRestart,
+                         int lowerBoundZ,
+                         int numThreads,
+                         vector<vector<int>> &solutions,
+                         vector<int> &restarts,
+                         int elitePoolSize,
+                         vector<unsigned long long> *iterations,
+                         vector<unsigned long long> *evaluations) {
+    vector<std::pair<std::uint64_t, std::uint64_t>> streams;
+    streams.reserve(initSolutions.size());
+    for (std::size_t read = 0; read < initSolutions.size(); read++) {
+        streams.emplace_back(seed, read);
+    }
+
+    runTabuSearches(problem, initSolutions, streams, tenure, timeout, numRestarts,
+                    energyThreshold, coeffZFirst, coeffZRestart, lowerBoundZ,
+                    numThreads, solutions, restarts, elitePoolSize, iterations, evaluations);
 }
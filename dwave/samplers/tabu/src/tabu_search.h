@@ -18,33 +18,113 @@
 #define LAMBDA 5000
 #define ALPHA 0.4
 
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
 #include <vector>
-#include <random>
 
+#include "batch.h"
 #include "bqp.h"
+#include "deadline.h"
+#include "rng.h"
 
 typedef struct bqpSolver_Callback {
   void (*func)(const struct bqpSolver_Callback *callback, BQP *bqp);
   void *context;
 } bqpSolver_Callback;
 
+/**
+ * The best solutions found by cooperating tabu searches, which restart from
+ * them, see TabuSearch. It is safe to use from several threads: each call
+ * holds a lock while it copies a solution, which searches only do once per
+ * restart.
+ */
+class ElitePool
+{
+    public:
+        /**
+         * \param capacity: Maximum number of solutions kept
+         */
+        explicit ElitePool(int capacity);
+
+        /**
+         * Keeps a solution if it is not in the pool already, and either the
+         * pool is not full or the solution is better than the worst one in
+         * it, which it then replaces
+         * \param solution: The solution
+         * \param objective: Its value of the objective function
+         * \return
+         */
+        void offer(const std::vector<int> &solution, double objective);
+
+        /**
+         * Copies one of the solutions in the pool, picked uniformly at random
+         * \param generator: RNG
+         * \param solution: Storage for the solution
+         * \param objective: Storage for its value of the objective function
+         * \return false if the pool is empty
+         */
+        bool draw(StreamRng &generator, std::vector<int> &solution, double &objective);
+
+        /**
+         * \return The number of solutions in the pool
+         */
+        int size();
+
+    private:
+        std::mutex lock;
+        int capacity;
+        std::vector<std::vector<int>> solutions;
+        std::vector<double> objectives;
+};
+
 class TabuSearch
 {
     public:
-        TabuSearch(std::vector<std::vector<double>> Q, 
+        TabuSearch(const std::vector<std::vector<double>> &Q, 
                    const std::vector<int> initSol, 
                    int tenure, 
                    long int timeout, 
                    int numRestarts, 
-                   unsigned int seed, 
+                   std::uint64_t seed, 
                    double energyThreshold,
                    int coeffZFirst,
                    int coeffZRestart,
                    int lowerBoundZ);
+
+        /**
+         * Runs a multistart tabu search. If elitePool is not null, the search
+         * cooperates with the others that share it: it offers the pool the
+         * result of each simple tabu search, and restarts from a solution
+         * drawn from the pool rather than from its own. The search draws its
+         * random numbers from stream `stream` of `seed`, see StreamRng.
+         */
+        TabuSearch(const BQP &problem, 
+                   const std::vector<int> initSol, 
+                   int tenure, 
+                   long int timeout, 
+                   int numRestarts, 
+                   std::uint64_t seed, 
+                   double energyThreshold,
+                   int coeffZFirst,
+                   int coeffZRestart,
+                   int lowerBoundZ,
+                   ElitePool *elitePool = nullptr,
+                   std::uint64_t stream = 0);
         double bestEnergy();
         std::vector<int> bestSolution();
         int numRestarts();
 
+        /**
+         * \return The number of iterations of the simple tabu searches run
+         */
+        unsigned long long numIterations();
+
+        /**
+         * \return The number of moves evaluated by the simple tabu searches run
+         */
+        unsigned long long numEvaluations();
+
     private:
         /**
          * Simple tabu search solver with multi starts. Updates bqp with best solution found.
@@ -71,8 +151,7 @@ class TabuSearch
          * Solves and updates the BQP using simple tabu search heuristic
          * \param starting: A starting solution
          * \param startingObjective: The objective function value for the starting solution
-         * \param timeLimitInMilliSecs: Time limit in milli seconds
-         * \param useTimeLimit: If false, timeLimitInMilliSecs is ignored
+         * \param deadline: Deadline of the search, shared with the other restarts
          * \param energyThreshold: Search terminates when energy lower than or equal to the threshold is found
          * \param coeffZFirst: Parameter used to define the number of iterations on first STS
          * \param coeffZRestart: Parameter used to define the number of iterations on subsequent STS
@@ -83,8 +162,7 @@ class TabuSearch
         void simpleTabuSearch(const std::vector<int> &starting, 
                               double startingObjective, 
                               long long ZCoeff, 
-                              long long timeLimitInMilliSecs, 
-                              bool useTimeLimit, 
+                              Deadline &deadline, 
                               double energyThreshold,
                               const bqpSolver_Callback *callback);
 
@@ -103,35 +181,37 @@ class TabuSearch
          * Helper function to multiStartTabuSearch() function
          * Selects variables to change and build up new solution
          * \param numSelection: Number of variables required to be selected
-         * \param C: C matrix (refer paper for multi start tabu search by Palubeckis)
+         * \param C: Diagonal of the C matrix, see computeC()
          * \param I: Storage for selected variables
          * \return
          */
         void selectVariables(int numSelection, 
-                             std::vector<std::vector<double>> &C, 
+                             const std::vector<double> &C, 
                              std::vector<int> &I);
         
         /**
          * Helper function to multiStartTabuSearch() function
          * Uses steepest ascent to construct a new solution
          * \param numSelection: Number of variables required to be selected
-         * \param C: C matrix (refer paper for multi start tabu search by Palubeckis)
+         * \param C: Diagonal of the C matrix, see computeC()
          * \param I: Selected variables
          * \param solution: Solution to be updated
          * \return
          */
         void steepestAscent(int numSelection, 
-                            std::vector<std::vector<double>> &C, 
+                            const std::vector<double> &C, 
                             std::vector<int> &I, 
                             std::vector<int> &solution);
 
         /**
-         * Compute the C matrix (refer to the tabu search heuristic in the paper by Palubeckis (p.262))
-         * \param C: The matrix computed
+         * Compute the diagonal of the C matrix (refer to the tabu search heuristic in the paper by Palubeckis (p.262))
+         * Its other entries are those of bqp.quadratic, negated where both variables have the same value
+         * in bqp.solution, so selectVariables() and steepestAscent() read them from there.
+         * \param C: Storage for the diagonal
          * \param solution: Current solution
          * \return
          */
-        void computeC(std::vector<std::vector<double>> &C, const std::vector<int> &solution);
+        void computeC(std::vector<double> &C, const std::vector<int> &solution);
 
         /**
          * Stores the problem, the solution, and some statistics
@@ -146,7 +226,144 @@ class TabuSearch
         /**
          * RNG
          */
-        std::default_random_engine generator;
+        StreamRng generator;
+
+        /**
+         * Solutions shared with cooperating searches, or null
+         */
+        ElitePool *elitePool;
 };
 
+/**
+ * Runs one multistart tabu search for each initial solution, see TabuSearch.
+ * The searches share the problem and are distributed over numThreads threads,
+ * each of which copies the problem into the search it runs. Every search is
+ * seeded by its own seed, so unless they cooperate, the results do not
+ * depend on numThreads.
+ * \param problem: The problem to search, shared by all searches
+ * \param initSolutions: The initial solution of each search
+ * \param seeds: The seed of each search, of the same length as initSolutions
+ * \param tenure, timeout, numRestarts, energyThreshold, coeffZFirst,
+ *        coeffZRestart, lowerBoundZ: Parameters of each search, see TabuSearch
+ * \param numThreads: Number of threads to distribute the searches over
+ * \param solutions: Storage for the best solution of each search
+ * \param restarts: Storage for the number of restarts of each search
+ * \param elitePoolSize: If positive, the searches cooperate through an
+ *        ElitePool of this capacity. Which solutions they restart from then
+ *        depends on the order they finish their simple tabu searches in.
+ * \param iterations: If not null, storage for the number of iterations of
+ *        each search, see TabuSearch::numIterations
+ * \param evaluations: If not null, storage for the number of moves evaluated
+ *        by each search, see TabuSearch::numEvaluations
+ * \return
+ */
+void multiReadTabuSearch(const BQP &problem,
+                         const std::vector<std::vector<int>> &initSolutions,
+                         const std::vector<unsigned int> &seeds,
+                         int tenure,
+                         long int timeout,
+                         int numRestarts,
+                         double energyThreshold,
+                         int coeffZFirst,
+                         int coeffZRestart,
+                         int lowerBoundZ,
+                         int numThreads,
+                         std::vector<std::vector<int>> &solutions,
+                         std::vector<int> &restarts,
+                         int elitePoolSize = 0,
+                         std::vector<unsigned long long> *iterations = nullptr,
+                         std::vector<unsigned long long> *evaluations = nullptr);
+
+/**
+ * Runs one multistart tabu search for each initial solution, as above, but
+ * with a single seed: each search draws from its own stream of `seed`, the
+ * one of the index of its initial solution, see StreamRng.
+ */
+void multiReadTabuSearch(const BQP &problem,
+                         const std::vector<std::vector<int>> &initSolutions,
+                         std::uint64_t seed,
+                         int tenure,
+                         long int timeout,
+                         int numRestarts,
+                         double energyThreshold,
+                         int coeffZFirst,
+                         int coeffZRestart,
+                         int lowerBoundZ,
+                         int numThreads,
+                         std::vector<std::vector<int>> &solutions,
+                         std::vector<int> &restarts,
+                         int elitePoolSize = 0,
+                         std::vector<unsigned long long> *iterations = nullptr,
+                         std::vector<unsigned long long> *evaluations = nullptr);
+
+/**
+ * Runs numReads multistart tabu searches on each of a batch of BINARY-valued
+ * binary quadratic models, read in place, see bqmToBQP. The models are spread
+ * over numThreads threads, each of which builds the problem of one model at a
+ * time and runs all of its searches in turn, see run_batch. The tabu tenure
+ * of each model is min(20, numVars / 4), as in TabuSampler.
+ * \param bqms: The models
+ * \param seed: The random initial solutions and the searches of model i draw
+ *        from stream i of the seed, so the results do not depend on numThreads
+ * \param timeout, numRestarts, energyThreshold, coeffZFirst, coeffZRestart,
+ *        lowerBoundZ: Parameters of each search, see TabuSearch
+ * \param numReads: Number of searches of each model
+ * \param numThreads: Number of threads to distribute the models over
+ * \param solutions: Storage for the best solution of each search of each
+ *        model in turn, numReads rows of bqms[i]->num_variables() values for
+ *        model i
+ * \param restarts: Storage for the number of restarts of each search of each
+ *        model in turn
+ * \return
+ */
+template <class BQM>
+void multiProblemTabuSearch(const std::vector<BQM*> &bqms,
+                            std::uint64_t seed,
+                            long int timeout,
+                            int numRestarts,
+                            double energyThreshold,
+                            int coeffZFirst,
+                            int coeffZRestart,
+                            int lowerBoundZ,
+                            int numReads,
+                            int numThreads,
+                            std::int8_t *solutions,
+                            int *restarts) {
+    std::vector<std::int64_t> offsets(bqms.size() + 1, 0);
+    for (std::size_t i = 0; i < bqms.size(); i++) {
+        offsets[i + 1] = offsets[i] +
+            static_cast<std::int64_t>(numReads) * bqms[i]->num_variables();
+    }
+
+    auto task = [&](const int i) {
+        const int nVars = bqms[i]->num_variables();
+        int *problemRestarts = restarts + static_cast<std::int64_t>(numReads) * i;
+        if (!nVars) {
+            std::fill(problemRestarts, problemRestarts + numReads, 0);
+            return;
+        }
+
+        StreamRng generator(seed, i);
+        std::vector<std::vector<int>> initSolutions(numReads, std::vector<int>(nVars));
+        for (auto &initSolution : initSolutions) {
+            for (int &value : initSolution) value = generator() >> 63;
+        }
+
+        std::vector<std::vector<int>> problemSolutions;
+        std::vector<int> problemRestartsVector;
+        multiReadTabuSearch(bqmToBQP(*bqms[i]), initSolutions, generator(),
+                            std::min(20, nVars / 4), timeout, numRestarts,
+                            energyThreshold, coeffZFirst, coeffZRestart,
+                            lowerBoundZ, 1, problemSolutions, problemRestartsVector);
+
+        std::int8_t *problemSolution = solutions + offsets[i];
+        for (int read = 0; read < numReads; read++) {
+            std::copy(problemSolutions[read].begin(), problemSolutions[read].end(),
+                      problemSolution + static_cast<std::int64_t>(read) * nVars);
+            problemRestarts[read] = problemRestartsVector[read];
+        }
+    };
+    run_batch(bqms.size(), numThreads, task);
+}
+
 #endif
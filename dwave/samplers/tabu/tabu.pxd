@@ -12,12 +12,24 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+from libc.stdint cimport int8_t, uint64_t
 from libcpp.vector cimport vector
 
+from dimod.cyqmbase.cyqmbase_float64 cimport bias_type, index_type
+from dimod.libcpp.binary_quadratic_model cimport BinaryQuadraticModel as cppBinaryQuadraticModel
+
+cdef extern from "bqp.h" nogil:
+    cdef cppclass BQP:
+        BQP() except +
+        BQP(const vector[vector[double]] &Q) except +
+        int nVars
+
+    vector[vector[double]] bqmToQ(const cppBinaryQuadraticModel[bias_type, index_type] &bqm) except +
+    BQP bqmToBQP(const cppBinaryQuadraticModel[bias_type, index_type] &bqm) except +
 
 cdef extern from "tabu_search.h" nogil:
     cdef cppclass TabuSearch:
-        TabuSearch(vector[vector[double]] Q,
+        TabuSearch(const vector[vector[double]] &Q,
                    const vector[int] initSol,
                    int tenure,
                    long int timeout,
@@ -27,6 +39,65 @@ cdef extern from "tabu_search.h" nogil:
 		   int coeffZFirst,
 		   int coeffZRestart,
 		   int lowerBoundZ) except +
+        TabuSearch(const BQP &problem,
+                   const vector[int] initSol,
+                   int tenure,
+                   long int timeout,
+                   int numRestarts,
+                   unsigned int seed,
+                   double energyThreshold,
+                   int coeffZFirst,
+                   int coeffZRestart,
+                   int lowerBoundZ) except +
         double bestEnergy()
         vector[int] bestSolution()
         int numRestarts()
+        unsigned long long numIterations()
+        unsigned long long numEvaluations()
+
+    void multiReadTabuSearch(const BQP &problem,
+                             const vector[vector[int]] &initSolutions,
+                             const vector[unsigned int] &seeds,
+                             int tenure,
+                             long int timeout,
+                             int numRestarts,
+                             double energyThreshold,
+                             int coeffZFirst,
+                             int coeffZRestart,
+                             int lowerBoundZ,
+                             int numThreads,
+                             vector[vector[int]] &solutions,
+                             vector[int] &restarts,
+                             int elitePoolSize,
+                             vector[unsigned long long] *iterations,
+                             vector[unsigned long long] *evaluations) except +
+
+    void multiReadTabuSearch(const BQP &problem,
+                             const vector[vector[int]] &initSolutions,
+                             uint64_t seed,
+                             int tenure,
+                             long int timeout,
+                             int numRestarts,
+                             double energyThreshold,
+                             int coeffZFirst,
+                             int coeffZRestart,
+                             int lowerBoundZ,
+                             int numThreads,
+                             vector[vector[int]] &solutions,
+                             vector[int] &restarts,
+                             int elitePoolSize,
+                             vector[unsigned long long] *iterations,
+                             vector[unsigned long long] *evaluations) except +
+
+    void multiProblemTabuSearch(const vector[cppBinaryQuadraticModel[bias_type, index_type]*] &bqms,
+                                uint64_t seed,
+                                long int timeout,
+                                int numRestarts,
+                                double energyThreshold,
+                                int coeffZFirst,
+                                int coeffZRestart,
+                                int lowerBoundZ,
+                                int numReads,
+                                int numThreads,
+                                int8_t *solutions,
+                                int *restarts) except +
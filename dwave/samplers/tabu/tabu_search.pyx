@@ -1,5 +1,5 @@
 # distutils: language = c++
-# distutils: include_dirs = dwave/samplers/tabu/src/
+# distutils: include_dirs = dwave/samplers/tabu/src/ dwave/samplers/common/src/
 # distutils: sources = dwave/samplers/tabu/src/tabu_search.cpp dwave/samplers/tabu/src/tabu_utils.cpp dwave/samplers/tabu/src/bqp.cpp
 
 # Copyright 2020 D-Wave Systems Inc.
@@ -16,15 +16,54 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+from cython.operator cimport dereference as deref
+from libc.stdint cimport int8_t, uint64_t
 from libcpp.vector cimport vector
 from libc.time cimport time
+import dimod
+cimport dimod
+from dimod.cyqmbase.cyqmbase_float64 cimport bias_type, index_type
+from dimod.libcpp.binary_quadratic_model cimport BinaryQuadraticModel as cppBinaryQuadraticModel
 import numpy as np
+cimport numpy as np
 
 cimport dwave.samplers.tabu.tabu
+from dwave.samplers.common.pool cimport set_worker_pool, shared_worker_pool
+
+# run the parallel loops of the kernels on the workers shared by all samplers
+set_worker_pool(shared_worker_pool())
+
+
+cdef dwave.samplers.tabu.tabu.BQP _as_bqp(object Q) except *:
+    """Builds the problem of `Q`, see `TabuSearch`."""
+    cdef dimod.cyBQM_float64 cybqm
+    cdef double[:,:] qubo
+    cdef vector[vector[double]] Qvec
+    cdef Py_ssize_t i, j
+    if isinstance(Q, dimod.BinaryQuadraticModel):
+        # read the biases of a QUBO in place
+        if Q.vartype is not dimod.BINARY:
+            raise ValueError("Q must be a binary-valued BQM or a matrix")
+        cybqm = dimod.as_bqm(Q, dtype=float).data
+        return dwave.samplers.tabu.tabu.bqmToBQP(deref(cybqm.data()))
+
+    qubo = np.asarray(Q, dtype=np.double)
+    Qvec.resize(qubo.shape[0])
+    for i in range(qubo.shape[0]):
+        for j in range(qubo.shape[1]):
+            Qvec[i].push_back(qubo[i, j])
+    return dwave.samplers.tabu.tabu.BQP(Qvec)
 
 
 cdef class TabuSearch:
-    """Wraps the class `TabuSearch` from `src/tabu_search.cpp`."""
+    """Wraps the class `TabuSearch` from `src/tabu_search.cpp`.
+
+    `Q` is either a symmetric matrix, see `TabuSampler._bqm_to_tabu_qubo`, or a
+    binary-valued :class:`dimod.BinaryQuadraticModel` whose biases are read in
+    place, with its variables in the order of ``Q.variables``. The search
+    stores the problem sparsely in both cases, but only a BQM avoids building
+    the dense matrix in the first place.
+    """
 
     cdef dwave.samplers.tabu.tabu.TabuSearch *c_tabu
 
@@ -45,14 +84,9 @@ cdef class TabuSearch:
         cdef int _coeffZRestart = -1 if coeffZRestart is None else coeffZRestart
         cdef int _lowerBoundZ = -1 if lowerBoundZ is None else lowerBoundZ
 
-        cdef double[:,:] qubo = np.asarray(Q, dtype=np.double)
-        cdef vector[vector[double]] Qvec
-        Qvec.resize(qubo.shape[0])
-        cdef Py_ssize_t i, j
-        for i in range(qubo.shape[0]):
-            for j in range(qubo.shape[1]):
-                Qvec[i].push_back(qubo[i, j])
+        cdef dwave.samplers.tabu.tabu.BQP problem = _as_bqp(Q)
 
+        cdef Py_ssize_t i
         cdef int[:] initial = np.asarray(initSol, dtype=np.intc)
         cdef vector[int] initVec
         for i in range(len(initial)):
@@ -60,7 +94,7 @@ cdef class TabuSearch:
 
         with nogil:
             self.c_tabu = new dwave.samplers.tabu.tabu.TabuSearch(
-                Qvec, initVec, tenure, timeout, numRestarts, _seed, _energyThreshold,
+                problem, initVec, tenure, timeout, numRestarts, _seed, _energyThreshold,
                 _coeffZFirst, _coeffZRestart, _lowerBoundZ)
 
     def __dealloc__(self):
@@ -74,3 +108,158 @@ cdef class TabuSearch:
 
     def numRestarts(self):
         return self.c_tabu.numRestarts()
+
+
+def multi_read_tabu_search(object Q,
+                           object initial_states,
+                           int tenure,
+                           int timeout,
+                           int numRestarts,
+                           object seeds,
+                           object energyThreshold=None,
+                           object coeffZFirst=None,
+                           object coeffZRestart=None,
+                           object lowerBoundZ=None,
+                           int num_threads=1,
+                           int elite_pool_size=0,
+                           dict counters=None):
+    """Wraps `multiReadTabuSearch` from `src/tabu_search.cpp`.
+
+    Runs one search, as `TabuSearch` does, from each row of
+    `initial_states`. If `seeds` is an integer, each search draws from its
+    own stream of that seed, the one of the index of its initial state.
+    Otherwise it is the seed of each search, in the order of
+    `initial_states`. The problem `Q` is built once and shared by the
+    searches, which are distributed over `num_threads` threads. If
+    `elite_pool_size` is positive, the searches cooperate, restarting from a
+    shared pool of that many of the best solutions found by any of them.
+
+    If `counters` is given, it is filled with the ``num_iterations`` and
+    ``num_evaluations`` (moves evaluated) of each search, as arrays in the
+    order of `initial_states`.
+
+    Returns:
+        tuple: The best solution of each search as an int8 array with one
+        row per initial state, and the number of restarts of each search.
+    """
+    cdef double _energyThreshold = -np.inf if energyThreshold is None else energyThreshold
+    cdef int _coeffZFirst = -1 if coeffZFirst is None else coeffZFirst
+    cdef int _coeffZRestart = -1 if coeffZRestart is None else coeffZRestart
+    cdef int _lowerBoundZ = -1 if lowerBoundZ is None else lowerBoundZ
+
+    cdef dwave.samplers.tabu.tabu.BQP problem = _as_bqp(Q)
+
+    cdef int[:, :] initial = np.atleast_2d(np.asarray(initial_states, dtype=np.intc))
+    cdef Py_ssize_t num_reads = initial.shape[0]
+
+    cdef bint single_seed = np.ndim(seeds) == 0
+    cdef uint64_t _seed = 0
+    cdef unsigned int[:] _seeds
+    cdef vector[unsigned int] seedVec
+    cdef Py_ssize_t i, j
+    if single_seed:
+        _seed = seeds
+    else:
+        _seeds = np.asarray(seeds, dtype=np.uintc)
+        if _seeds.shape[0] != num_reads:
+            raise ValueError("the number of seeds must match the number of initial states")
+        for i in range(num_reads):
+            seedVec.push_back(_seeds[i])
+
+    cdef vector[vector[int]] initVecs
+    initVecs.resize(num_reads)
+    for i in range(num_reads):
+        for j in range(initial.shape[1]):
+            initVecs[i].push_back(initial[i, j])
+
+    cdef vector[vector[int]] solutions
+    cdef vector[int] restarts
+    cdef vector[unsigned long long] iterations, evaluations
+    with nogil:
+        if single_seed:
+            dwave.samplers.tabu.tabu.multiReadTabuSearch(
+                problem, initVecs, _seed, tenure, timeout, numRestarts,
+                _energyThreshold, _coeffZFirst, _coeffZRestart, _lowerBoundZ,
+                num_threads, solutions, restarts, elite_pool_size,
+                &iterations, &evaluations)
+        else:
+            dwave.samplers.tabu.tabu.multiReadTabuSearch(
+                problem, initVecs, seedVec, tenure, timeout, numRestarts,
+                _energyThreshold, _coeffZFirst, _coeffZRestart, _lowerBoundZ,
+                num_threads, solutions, restarts, elite_pool_size,
+                &iterations, &evaluations)
+
+    if counters is not None:
+        counters.update(num_iterations=np.asarray(iterations, dtype=np.uint64),
+                        num_evaluations=np.asarray(evaluations, dtype=np.uint64))
+
+    samples = np.empty((num_reads, initial.shape[1]), dtype=np.int8)
+    cdef signed char[:, :] _samples = samples
+    for i in range(num_reads):
+        for j in range(initial.shape[1]):
+            _samples[i, j] = solutions[i][j]
+
+    return samples, np.asarray(restarts, dtype=int)
+
+
+def multi_problem_tabu_search(object bqms,
+                              int num_reads,
+                              int timeout,
+                              int numRestarts,
+                              uint64_t seed,
+                              object energyThreshold=None,
+                              object coeffZFirst=None,
+                              object coeffZRestart=None,
+                              object lowerBoundZ=None,
+                              int num_threads=1):
+    """Wraps `multiProblemTabuSearch` from `src/tabu_search.h`.
+
+    Runs `num_reads` searches from random initial states on each of the
+    binary-valued BQMs `bqms`, whose biases are read in place, in a single
+    native call that spreads the BQMs over `num_threads` threads. The
+    searches of the `i`-th BQM only depend on `seed` and on `i`.
+
+    Returns:
+        tuple: The best solutions of the searches of each BQM, as a list of
+        int8 arrays with one row per search, which are views of a single
+        array, and the number of restarts of each search, as an array with
+        one row per BQM.
+    """
+    cdef double _energyThreshold = -np.inf if energyThreshold is None else energyThreshold
+    cdef int _coeffZFirst = -1 if coeffZFirst is None else coeffZFirst
+    cdef int _coeffZRestart = -1 if coeffZRestart is None else coeffZRestart
+    cdef int _lowerBoundZ = -1 if lowerBoundZ is None else lowerBoundZ
+
+    cdef vector[cppBinaryQuadraticModel[bias_type, index_type]*] _bqms
+    cdef dimod.cyBQM_float64 cybqm
+    cdef Py_ssize_t total_vars = 0
+
+    # hold the float64 models until the searches are done
+    models = []
+    for bqm in bqms:
+        if bqm.vartype is not dimod.BINARY:
+            raise ValueError("bqms must be binary-valued")
+        cybqm = dimod.as_bqm(bqm, dtype=float).data
+        models.append(cybqm)
+        _bqms.push_back(cybqm.cppbqm)
+        total_vars += bqm.num_variables
+
+    solutions = np.empty(num_reads * total_vars, dtype=np.int8)
+    restarts = np.empty((len(models), num_reads), dtype=np.intc)
+    cdef int8_t* _solutions = <int8_t*> np.PyArray_DATA(solutions)
+    cdef int* _restarts = <int*> np.PyArray_DATA(restarts)
+
+    with nogil:
+        dwave.samplers.tabu.tabu.multiProblemTabuSearch(
+            _bqms, seed, timeout, numRestarts, _energyThreshold,
+            _coeffZFirst, _coeffZRestart, _lowerBoundZ, num_reads,
+            num_threads, _solutions, _restarts)
+
+    samples = []
+    cdef Py_ssize_t offset = 0
+    for bqm in bqms:
+        size = num_reads * bqm.num_variables
+        samples.append(solutions[offset:offset + size].reshape(num_reads, bqm.num_variables))
+        offset += size
+
+    return samples, restarts.astype(int)
@@ -16,9 +16,16 @@
 # limitations under the License.
 
 cimport numpy as np
+from libcpp.vector cimport vector
 
 ctypedef double energies_type
 ctypedef int samples_type
 
 cdef extern from "numpy/arrayobject.h":
     void PyArray_ENABLEFLAGS(np.ndarray arr, int flags)
+
+cdef extern from "buckettree.h" namespace "orang":
+    cdef cppclass NodeStats:
+        unsigned int nodeVar
+        size_t tableSize
+        double mergeSeconds
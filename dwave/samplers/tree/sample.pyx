@@ -1,6 +1,6 @@
 # distutils: language = c++
 # cython: language_level = 3
-# distutils: include_dirs = dwave/samplers/tree/src/include/
+# distutils: include_dirs = dwave/samplers/tree/src/include/ dwave/samplers/common/src/
 #
 # Copyright 2019 D-Wave Systems Inc.
 #
@@ -16,9 +16,12 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import os
 from typing import Tuple
 from libcpp cimport bool
 from libc.stdlib cimport free
+from libcpp.string cimport string
+from libcpp.vector cimport vector
 
 
 import numpy as np
@@ -31,7 +34,12 @@ from cython.operator cimport dereference as deref
 from dimod cimport cyBQM_float64
 from dimod.libcpp cimport BinaryQuadraticModel as cppBinaryQuadraticModel
 
-from dwave.samplers.tree.orang cimport samples_type, PyArray_ENABLEFLAGS
+from dwave.samplers.common.counters cimport counters_enabled
+from dwave.samplers.common.pool cimport set_worker_pool, shared_worker_pool
+from dwave.samplers.tree.orang cimport samples_type, PyArray_ENABLEFLAGS, NodeStats
+
+# run the parallel loops of the kernels on the workers shared by all samplers
+set_worker_pool(shared_worker_pool())
 
 cdef extern from "src/include/sample.hpp":
     void sampleBQM[V, B](cppBinaryQuadraticModel[B, V]& refBQM,
@@ -39,14 +47,25 @@ cdef extern from "src/include/sample.hpp":
                          double beta,
                          int low,
                          double max_complexity,
+                         double max_memory,
                          int num_samples,
                          bool marginals,
+                         const int* marginal_pairs,
+                         int num_marginal_pairs,
                          int seed,
+                         int num_threads,
+                         bool single_precision,
+                         double mmap_threshold,
+                         const string& mmap_dir,
                          double* log_pf,
                          int** samples_data, int* samples_rows, int* samples_cols,
                          double** single_mrg_data, int* single_mrg_len,
                          double** pair_mrg_data, int* pair_mrg_rows, int* pair_mrg_cols,
-                         int** pair_data, int* pair_rows, int* pair_cols) except +
+                         int** pair_data, int* pair_rows, int* pair_cols,
+                         vector[NodeStats]* node_stats) except +
+
+# whether the tree kernels were built with DWAVE_SAMPLERS_COUNTERS
+has_counters = counters_enabled
 
 @cython.annotation_typing(False)  # maintain Cython2 behavior
 def sample_bqm_wrapper(bqm: BinaryQuadraticModel,
@@ -55,7 +74,13 @@ def sample_bqm_wrapper(bqm: BinaryQuadraticModel,
                        order: list,
                        marginals: bool = False,
                        num_reads: int = 1,
-                       seed: float = None) -> Tuple[np.ndarray, dict]:
+                       seed: float = None,
+                       num_threads: int = 1,
+                       max_memory: float = float('inf'),
+                       single_precision: bool = False,
+                       marginal_pairs: list = None,
+                       mmap_threshold: float = float('inf'),
+                       mmap_dir: str = '') -> Tuple[np.ndarray, dict]:
     """Cython wrapper for :func:`sampleBQM`.
 
     Args:
@@ -82,8 +107,38 @@ def sample_bqm_wrapper(bqm: BinaryQuadraticModel,
             Random number generator seed. Negative values will cause a time-based
             seed to be used.
 
+        num_threads:
+            Number of threads to build the tables of the tree decomposition on.
+
+        max_memory:
+            Upper bound, in bytes, on the estimated memory taken by the tables
+            of the tree decomposition.
+
+        single_precision:
+            If True, the tables of the tree decomposition hold 32-bit rather
+            than 64-bit floats.
+
+        marginal_pairs:
+            List of pairs of variables to compute the interaction marginals
+            of, each an interaction of nonzero bias. If None, they are
+            computed for all such interactions.
+
+        mmap_threshold:
+            Size, in bytes, from which the tables of the tree decomposition
+            are kept in memory-mapped temporary files rather than in memory.
+            If infinite, no table is.
+
+        mmap_dir:
+            Directory of the memory-mapped files. If empty, ``TMPDIR`` or
+            ``/tmp``.
+
     Returns:
-        The samples and marginals.
+        The samples and marginals. If the kernel counters are compiled in
+        (see ``DWAVE_SAMPLERS_COUNTERS``), the marginals also hold
+        ``'counters'``, a dict of arrays over the nodes of the tree
+        decomposition, in preorder: ``node_variables``, the variable of each
+        node, ``table_sizes``, the number of entries of its table, and
+        ``merge_seconds``, the time taken to merge its tables.
     """
     if not bqm.num_variables:
         raise ValueError("bqm must have at least one variable.")
@@ -95,6 +150,7 @@ def sample_bqm_wrapper(bqm: BinaryQuadraticModel,
 
     cdef double _beta = beta
     cdef double _max_complexity = max_complexity
+    cdef double _max_memory = max_memory
     cdef int low = -1 if bqm.vartype is dimod.SPIN else 0
 
     cdef int _seed
@@ -106,6 +162,14 @@ def sample_bqm_wrapper(bqm: BinaryQuadraticModel,
     cdef int[:] elimination_order = np.asarray(order, dtype=np.intc)
     cdef int* elimination_order_ptr = &elimination_order[0]
 
+    # a dummy pair keeps the pointer valid when no pairs are requested
+    cdef int num_marginal_pairs = -1
+    cdef int[:, :] marginal_pairs_array = np.zeros((1, 2), dtype=np.intc)
+    if marginal_pairs is not None:
+        num_marginal_pairs = len(marginal_pairs)
+        if num_marginal_pairs:
+            marginal_pairs_array = np.asarray(marginal_pairs, dtype=np.intc).reshape(-1, 2)
+
     # pass in pointers so that sample_bqm can fill things in
     cdef double logpf
 
@@ -123,19 +187,30 @@ def sample_bqm_wrapper(bqm: BinaryQuadraticModel,
     cdef int* pair_pointer
     cdef int prows, pcols
 
+    cdef vector[NodeStats] node_stats
+    cdef string _mmap_dir = os.fsencode(mmap_dir)
+
     sampleBQM(deref(cybqm.cppbqm),
               elimination_order_ptr,
               _beta,
               low,
               _max_complexity,
+              _max_memory,
               num_reads,
               marginals,
+              &marginal_pairs_array[0, 0],
+              num_marginal_pairs,
               _seed,
+              num_threads,
+              single_precision,
+              mmap_threshold,
+              _mmap_dir,
               &logpf,
               &samples_pointer, &srows, &scols,
               &single_marginals_pointer, &smlen,
               &pair_marginals_pointer, &pmrows, &pmcols,
-              &pair_pointer, &prows, &pcols)
+              &pair_pointer, &prows, &pcols,
+              &node_stats)
 
     # create a numpy array without making a copy then tell numpy it needs to
     # free the memory
@@ -176,4 +251,16 @@ def sample_bqm_wrapper(bqm: BinaryQuadraticModel,
 
     marginal_data['log_partition_function'] += -beta*bqm.offset
 
+    if not node_stats.empty():
+        node_variables = np.empty(node_stats.size(), dtype=np.intc)
+        table_sizes = np.empty(node_stats.size(), dtype=np.int64)
+        merge_seconds = np.empty(node_stats.size(), dtype=np.double)
+        for i in range(node_stats.size()):
+            node_variables[i] = node_stats[i].nodeVar
+            table_sizes[i] = node_stats[i].tableSize
+            merge_seconds[i] = node_stats[i].mergeSeconds
+        marginal_data['counters'] = dict(node_variables=node_variables,
+                                         table_sizes=table_sizes,
+                                         merge_seconds=merge_seconds)
+
     return samples, marginal_data
@@ -12,20 +12,62 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-from typing import List, Optional
+import collections
+
+from typing import Collection, Hashable, List, Optional, Tuple
+
+from numpy.typing import DTypeLike
 
 import dimod
 import numpy as np
 
 from dimod.typing import Variable
 
-from dwave.samplers.tree.sample import sample_bqm_wrapper
+from dwave.samplers.tree.sample import sample_bqm_wrapper, has_counters
 from dwave.samplers.tree.solve import solve_bqm_wrapper, samples_dtype, energies_dtype
 from dwave.samplers.tree.utilities import elimination_order_width, min_fill_heuristic
 
 __all__ = ['TreeDecompositionSolver', 'TreeDecompositionSampler']
 
 
+def _empty_counters() -> dict:
+    """The kernel counters of a problem without variables, see :meth:`sample`."""
+    return dict(node_variables=[],
+                table_sizes=np.empty(0, dtype=np.int64),
+                merge_seconds=np.empty(0, dtype=np.double))
+
+
+class _EliminationOrderCache:
+    """Min-fill elimination orders of the graphs of the most recently
+    sampled binary quadratic models.
+
+    The elimination order and treewidth only depend on the graph of a BQM, so
+    BQMs that share a graph but not their biases reuse the order found for the
+    first of them rather than running the heuristic again.
+    """
+    def __init__(self, maxsize: int = 16):
+        self.maxsize = maxsize
+        self._orders = collections.OrderedDict()
+
+    @staticmethod
+    def graph_key(bqm: dimod.BinaryQuadraticModel) -> Hashable:
+        return (frozenset(bqm.variables),
+                frozenset(frozenset(interaction) for interaction in bqm.quadratic))
+
+    def __call__(self, bqm: dimod.BinaryQuadraticModel) -> Tuple[int, List[Variable]]:
+        key = self.graph_key(bqm)
+        try:
+            self._orders.move_to_end(key)
+            return self._orders[key]
+        except KeyError:
+            pass
+
+        self._orders[key] = result = min_fill_heuristic(bqm)
+        if len(self._orders) > self.maxsize:
+            self._orders.popitem(last=False)
+        return result
+
+
 class TreeDecompositionSolver(dimod.Sampler):
     """Tree decomposition-based solver for binary quadratic models.
 
@@ -68,7 +110,13 @@ class TreeDecompositionSolver(dimod.Sampler):
 
     """
     parameters = {'num_reads': [],
-                  'elimination_order': ['max_treewidth']}
+                  'elimination_order': ['max_treewidth'],
+                  'num_threads': [],
+                  'max_memory': [],
+                  'dtype': [],
+                  'max_clamped': ['max_treewidth'],
+                  'mmap_threshold': [],
+                  'mmap_dir': []}
     """Keyword arguments accepted by the sampling methods.
 
     Examples:
@@ -76,7 +124,7 @@ class TreeDecompositionSolver(dimod.Sampler):
         >>> from dwave.samplers import TreeDecompositionSolver
         >>> solver = TreeDecompositionSolver()
         >>> solver.parameters.keys()
-        dict_keys(['num_reads', 'elimination_order'])
+        dict_keys(['num_reads', 'elimination_order', 'num_threads', 'max_memory', 'dtype', 'max_clamped', 'mmap_threshold', 'mmap_dir'])
 
     See :meth:`.sample` for descriptions.
 
@@ -99,8 +147,16 @@ class TreeDecompositionSolver(dimod.Sampler):
         self.parameters = dict(self.parameters)
         self.properties = dict(self.properties)
 
+        self._elimination_orders = _EliminationOrderCache()
+
     def sample(self, bqm: dimod.BinaryQuadraticModel, num_reads: Optional[int] = 1,
-               elimination_order: Optional[List[Variable]] = None) -> dimod.SampleSet:
+               elimination_order: Optional[List[Variable]] = None,
+               num_threads: int = 1,
+               max_memory: Optional[float] = None,
+               dtype: DTypeLike = np.float64,
+               max_clamped: int = 0,
+               mmap_threshold: Optional[float] = None,
+               mmap_dir: Optional[str] = None) -> dimod.SampleSet:
         """Find ground states of a binary quadratic model.
 
         Args:
@@ -117,12 +173,74 @@ class TreeDecompositionSolver(dimod.Sampler):
             elimination_order:
                 Variable elimination order. Should be a list of the
                 variables in the binary quadratic model. If None, the min-fill
-                heuristic [#gd]_ is used to generate one.
+                heuristic [#gd]_ is used to generate one. The orders generated
+                for the graphs of recent BQMs are kept, and reused for BQMs
+                with the same graph whatever their biases.
+
+            num_threads:
+                Number of threads to build the tables of the tree decomposition
+                on. Independent subtrees are built concurrently. The result
+                does not depend on ``num_threads``.
+
+            max_memory:
+                Upper bound, in bytes, on the memory taken by the tables of
+                the tree decomposition, as estimated from the elimination
+                order before any of them is built. If None, there is no bound.
+
+            dtype:
+                Floating-point type of the entries of the tables of the tree
+                decomposition, either ``numpy.float64`` or ``numpy.float32``.
+                Single-precision tables take half the memory, which allows for
+                a treewidth about one larger. The energies of the samples are
+                computed exactly, but states whose energies differ by less
+                than the rounding error may be returned out of order.
+
+            max_clamped:
+                Maximum number of variables to clamp when the treewidth_ of
+                the elimination order exceeds ``max_treewidth`` or its tables
+                exceed ``max_memory``. Variables of the largest node of the
+                tree decomposition are clamped until it fits, and each
+                assignment of the clamped variables is solved, on
+                ``num_threads`` threads, with the remaining variables. An
+                assignment is skipped when a lower bound on its energies
+                shows that it cannot improve on the states already found.
+                The cost grows as ``2**max_clamped``, which can be at most
+                24. If 0, no variables are clamped.
+
+            mmap_threshold:
+                Size, in bytes, from which the tables of the tree
+                decomposition are kept in memory-mapped temporary files
+                rather than in memory, so that problems whose tables do not
+                fit in RAM can still be solved, bounded by disk space
+                instead. The tables are merged in the order of their entries,
+                so the files are streamed. ``max_memory`` still bounds all
+                of the tables. If None, every table is kept in memory.
+                Memory mapping is only available on POSIX systems.
+
+            mmap_dir:
+                Directory of the memory-mapped files. The files are removed
+                as soon as they are created, and their space is freed with
+                their tables. If None, ``TMPDIR`` or ``/tmp`` is used.
+
+        Returns:
+            If the kernel counters are compiled in (by building with the
+            ``DWAVE_SAMPLERS_COUNTERS`` environment variable set), the
+            returned :attr:`dimod.SampleSet.info` contains ``'counters'``, a
+            dict with the ``'node_variables'`` of the nodes of the tree
+            decomposition, in preorder, and arrays of the ``'table_sizes'``
+            of their tables and of the ``'merge_seconds'`` taken to merge
+            them, summed over the assignments of any clamped variables.
 
         Raises:
             ValueError:
                 The treewidth_ of the given BQM and elimination order cannot
-                exceed the value provided in :attr:`.properties`.
+                exceed the value provided in :attr:`.properties`, unless
+                ``max_clamped`` is positive.
+
+            RuntimeError:
+                The tables of the tree decomposition are estimated to take
+                more than ``max_memory`` bytes, or more than ``max_clamped``
+                variables would need to be clamped.
 
         .. _treewidth: https://en.wikipedia.org/wiki/Treewidth
 
@@ -130,31 +248,61 @@ class TreeDecompositionSolver(dimod.Sampler):
            https://arxiv.org/abs/1207.4109
 
         """
+        if num_threads < 1:
+            raise ValueError("num_threads must be a positive integer")
+
+        if max_memory is None:
+            max_memory = float('inf')
+        elif not max_memory > 0:
+            raise ValueError("max_memory must be positive")
+
+        dtype = np.dtype(dtype)
+        if dtype != np.float64 and dtype != np.float32:
+            raise ValueError("dtype must be numpy.float64 or numpy.float32")
+
+        if not 0 <= max_clamped <= 24:
+            raise ValueError("max_clamped must be between 0 and 24")
+
+        if mmap_threshold is None:
+            mmap_threshold = float('inf')
+        elif not mmap_threshold >= 0:
+            raise ValueError("mmap_threshold must be non-negative")
+        if mmap_dir is None:
+            mmap_dir = ''
+
         if not bqm:
+            info = {}
+            if has_counters:
+                info['counters'] = _empty_counters()
             samples = np.empty((num_reads, 0), dtype=samples_dtype)
             energies = bqm.energies(samples, dtype=energies_dtype)
-            return dimod.SampleSet.from_samples(samples, bqm.vartype, energy=energies)
+            return dimod.SampleSet.from_samples(samples, bqm.vartype, energy=energies,
+                                                info=info)
 
         bqm = dimod.as_bqm(bqm, copy=True, dtype=float)
 
         max_samples = min(num_reads, 2**len(bqm))
 
         if elimination_order is None:
-            tree_width, elimination_order = min_fill_heuristic(bqm)
+            tree_width, elimination_order = self._elimination_orders(bqm)
         else:
             tree_width = elimination_order_width(bqm, elimination_order)
 
         # developer note: we start getting bad_alloc errors above tree_width 25, this
         # should be fixed in the future
         if tree_width > self.properties['max_treewidth']:
-            raise ValueError(
-                f"maximum treewidth of {self.properties['max_treewidth']} exceeded. "
-                "To see the bqm's treewidth:\n"
-                ">>> import dwave_networkx as dnx\n"
-                f">>> dnx.elimination_order_width(bqm.adj, {elimination_order})"
-                )
-
-        max_complexity = tree_width + 1
+            if not max_clamped:
+                raise ValueError(
+                    f"maximum treewidth of {self.properties['max_treewidth']} exceeded. "
+                    "To see the bqm's treewidth:\n"
+                    ">>> import dwave_networkx as dnx\n"
+                    f">>> dnx.elimination_order_width(bqm.adj, {elimination_order})"
+                    )
+
+            # clamp variables down to the maximum treewidth
+            max_complexity = self.properties['max_treewidth'] + 1
+        else:
+            max_complexity = tree_width + 1
 
         # relabel bqm variables so that we only work with linear indices
         bqm_copy, int_to_var = bqm.relabel_variables_as_integers(inplace=False)
@@ -163,12 +311,24 @@ class TreeDecompositionSolver(dimod.Sampler):
         # relabel variables in the elimination order as well
         elimination_order = [var_to_int.get(var, var) for var in elimination_order]
 
+        counters = {}
         samples, energies = solve_bqm_wrapper(bqm=bqm_copy,
                                               order=elimination_order,
                                               max_complexity=max_complexity,
-                                              max_solutions=max_samples
+                                              max_solutions=max_samples,
+                                              num_threads=num_threads,
+                                              max_memory=max_memory,
+                                              single_precision=dtype == np.float32,
+                                              max_clamped=max_clamped,
+                                              counters=counters,
+                                              mmap_threshold=mmap_threshold,
+                                              mmap_dir=mmap_dir,
                                               )
 
+        if dtype == np.float32:
+            # the energies found are only accurate to single precision
+            energies = bqm_copy.energies(samples, dtype=energies_dtype)
+
         # if we asked for more than the total number of distinct samples, we
         # just resample again starting from the beginning
         num_occurrences = np.ones(max_samples, dtype=np.intc)
@@ -177,10 +337,16 @@ class TreeDecompositionSolver(dimod.Sampler):
             num_occurrences *= q
             num_occurrences[:r] += 1
 
+        info = {}
+        if counters:
+            counters['node_variables'] = [int_to_var.get(i, i) for i in counters['node_variables']]
+            info['counters'] = counters
+
         return dimod.SampleSet.from_samples((samples, bqm.variables),
                                             bqm.vartype,
                                             energy=energies,
-                                            num_occurrences=num_occurrences)
+                                            num_occurrences=num_occurrences,
+                                            info=info)
 
 
 class TreeDecompositionSampler(dimod.Sampler):
@@ -201,7 +367,13 @@ class TreeDecompositionSampler(dimod.Sampler):
                   'elimination_order': ['max_treewidth'],
                   'beta': [],
                   'marginals': [],
-                  'seed': []}
+                  'seed': [],
+                  'num_threads': [],
+                  'max_memory': [],
+                  'dtype': [],
+                  'interactions': [],
+                  'mmap_threshold': [],
+                  'mmap_dir': []}
     """Keyword arguments accepted by the sampling methods.
 
     Examples:
@@ -209,7 +381,7 @@ class TreeDecompositionSampler(dimod.Sampler):
         >>> from dwave.samplers import TreeDecompositionSampler
         >>> sampler = TreeDecompositionSampler()
         >>> sampler.parameters.keys()
-        dict_keys(['num_reads', 'elimination_order', 'beta', 'marginals', 'seed'])
+        dict_keys(['num_reads', 'elimination_order', 'beta', 'marginals', 'seed', 'num_threads', 'max_memory', 'dtype', 'interactions', 'mmap_threshold', 'mmap_dir'])
 
     See :meth:`.sample` for descriptions.
 
@@ -232,9 +404,18 @@ class TreeDecompositionSampler(dimod.Sampler):
         self.parameters = dict(self.parameters)
         self.properties = dict(self.properties)
 
+        self._elimination_orders = _EliminationOrderCache()
+
     def sample(self, bqm: dimod.BinaryQuadraticModel, num_reads: Optional[int] = 1,
                elimination_order: Optional[List[Variable]] = None, beta: Optional[float] = 1.0,
-               marginals: Optional[bool] = True, seed: Optional[int] = None) -> dimod.SampleSet:
+               marginals: Optional[bool] = True, seed: Optional[int] = None,
+               num_threads: int = 1,
+               max_memory: Optional[float] = None,
+               dtype: DTypeLike = np.float64,
+               interactions: Optional[Collection[Tuple[Variable, Variable]]] = None,
+               mmap_threshold: Optional[float] = None,
+               mmap_dir: Optional[str] = None,
+               ) -> dimod.SampleSet:
         """Draw samples and compute marginals of a binary quadratic model.
 
         Args:
@@ -247,7 +428,9 @@ class TreeDecompositionSampler(dimod.Sampler):
             elimination_order:
                 Variable elimination order. Should be a list of the
                 variables in the binary quadratic model. If None, the min-fill
-                heuristic [#gd]_ is used to generate one.
+                heuristic [#gd]_ is used to generate one. The orders generated
+                for the graphs of recent BQMs are kept, and reused for BQMs
+                with the same graph whatever their biases.
 
             beta:
                 `Boltzmann distribution`_ inverse temperature parameter.
@@ -261,6 +444,47 @@ class TreeDecompositionSampler(dimod.Sampler):
                 Random number generator seed. Negative values cause a
                 time-based seed to be used.
 
+            num_threads:
+                Number of threads to build the tables of the tree decomposition
+                and draw the samples on. Independent subtrees are built
+                concurrently, and samples are drawn in blocks of 1024, each
+                with its own random number generator seeded from ``seed``.
+                The samples and marginals do not depend on ``num_threads``.
+
+            max_memory:
+                Upper bound, in bytes, on the memory taken by the tables of
+                the tree decomposition, as estimated from the elimination
+                order before any of them is built. If None, there is no bound.
+
+            dtype:
+                Floating-point type of the entries of the tables of the tree
+                decomposition, either ``numpy.float64`` or ``numpy.float32``.
+                Single-precision tables take half the memory, which allows for
+                a treewidth about one larger, at the cost of a log partition
+                function and marginals only accurate to single precision.
+
+            interactions:
+                Interactions to compute the marginals of, if ``marginals`` is
+                True, each a pair of variables ``(u, v)`` with a nonzero bias
+                in the binary quadratic model. If None, the marginals of all
+                interactions of nonzero bias are computed. The variable
+                marginals are always all computed.
+
+            mmap_threshold:
+                Size, in bytes, from which the tables of the tree
+                decomposition are kept in memory-mapped temporary files
+                rather than in memory, so that problems whose tables do not
+                fit in RAM can still be solved, bounded by disk space
+                instead. The tables are merged in the order of their entries,
+                so the files are streamed. ``max_memory`` still bounds all
+                of the tables. If None, every table is kept in memory.
+                Memory mapping is only available on POSIX systems.
+
+            mmap_dir:
+                Directory of the memory-mapped files. The files are removed
+                as soon as they are created, and their space is freed with
+                their tables. If None, ``TMPDIR`` or ``/tmp`` is used.
+
         Returns:
             Returned :attr:`dimod.SampleSet.info` contains:
 
@@ -275,24 +499,69 @@ class TreeDecompositionSampler(dimod.Sampler):
                 * ``'interaction_marginals'``: Dict of the form
                   ``{(u, v): {(s, t): p, ...}, ...}``, where ``(u, v)`` is an
                   interaction in the binary quadratic model and
-                  ``p = prob(u == s & v == t)``.
+                  ``p = prob(u == s & v == t)``. Only the given
+                  ``interactions`` are included, keyed as given, if any.
+
+            If the kernel counters are compiled in (by building with the
+            ``DWAVE_SAMPLERS_COUNTERS`` environment variable set), also
+            contains:
+
+                * ``'counters'``: Dict with the ``'node_variables'`` of the
+                  nodes of the tree decomposition, in preorder, and arrays of
+                  the ``'table_sizes'`` of their tables and of the
+                  ``'merge_seconds'`` taken to merge them.
 
         Raises:
             ValueError:
                 The treewidth_ of the given bqm and elimination order cannot
                 exceed the value provided in :attr:`.properties`.
 
+            RuntimeError:
+                The tables of the tree decomposition are estimated to take
+                more than ``max_memory`` bytes.
+
         .. _treewidth: https://en.wikipedia.org/wiki/Treewidth
         .. _Boltzmann distribution: https://en.wikipedia.org/wiki/Boltzmann_distribution
         .. [#gd] Gogate & Dechter, "A Complete Anytime Algorithm for Treewidth",
            https://arxiv.org/abs/1207.4109
 
         """
+        if num_threads < 1:
+            raise ValueError("num_threads must be a positive integer")
+
+        if max_memory is None:
+            max_memory = float('inf')
+        elif not max_memory > 0:
+            raise ValueError("max_memory must be positive")
+
+        dtype = np.dtype(dtype)
+        if dtype != np.float64 and dtype != np.float32:
+            raise ValueError("dtype must be numpy.float64 or numpy.float32")
+
+        if mmap_threshold is None:
+            mmap_threshold = float('inf')
+        elif not mmap_threshold >= 0:
+            raise ValueError("mmap_threshold must be non-negative")
+        if mmap_dir is None:
+            mmap_dir = ''
+
+        if interactions is not None:
+            interactions = list(interactions)
+            for u, v in interactions:
+                try:
+                    bias = bqm.get_quadratic(u, v)
+                except ValueError:
+                    raise ValueError(f"{(u, v)!r} is not an interaction of the bqm") from None
+                if not bias:
+                    raise ValueError(f"interaction {(u, v)!r} has a zero bias")
+
         if not bqm:
             info = {'log_partition_function': 0.0}
             if marginals:
                 info['variable_marginals'] = {}
                 info['interaction_marginals'] = {}
+            if has_counters:
+                info['counters'] = _empty_counters()
             samples = np.empty((num_reads, 0), dtype=samples_dtype)
             energies = bqm.energies(samples, dtype=energies_dtype)
             return dimod.SampleSet.from_samples(samples, bqm.vartype,
@@ -302,7 +571,7 @@ class TreeDecompositionSampler(dimod.Sampler):
 
         if elimination_order is None:
             # note that this does not respect the given seed
-            tree_width, elimination_order = min_fill_heuristic(bqm)
+            tree_width, elimination_order = self._elimination_orders(bqm)
         else:
             # this also checks the order against the bqm
             tree_width = elimination_order_width(bqm, elimination_order)
@@ -326,16 +595,31 @@ class TreeDecompositionSampler(dimod.Sampler):
 
         max_complexity = tree_width + 1
 
+        marginal_pairs = None
+        if marginals and interactions is not None:
+            marginal_pairs = [(var_to_int.get(u, u), var_to_int.get(v, v)) for u, v in interactions]
+
         samples, data = sample_bqm_wrapper(bqm=bqm_copy,
                                            beta=beta,
                                            max_complexity=max_complexity,
                                            order=elimination_order,
                                            marginals=marginals,
                                            num_reads=num_reads,
-                                           seed=seed)
+                                           seed=seed,
+                                           num_threads=num_threads,
+                                           max_memory=max_memory,
+                                           single_precision=dtype == np.float32,
+                                           marginal_pairs=marginal_pairs,
+                                           mmap_threshold=mmap_threshold,
+                                           mmap_dir=mmap_dir)
 
         info = {'log_partition_function': data['log_partition_function']}
 
+        if 'counters' in data:
+            counters = data['counters']
+            counters['node_variables'] = [int_to_var.get(i, i) for i in counters['node_variables']]
+            info['counters'] = counters
+
         if marginals:
             info['variable_marginals'] = {}
             for i in elimination_order:
@@ -344,11 +628,24 @@ class TreeDecompositionSampler(dimod.Sampler):
             info['interaction_marginals'] = {}
             low = -1 if bqm.vartype is dimod.SPIN else 0
             configs = (low, low), (1, low), (low, 1), (1, 1)
-            for (i, j), probs in zip(data['interactions'],
-                                     data['interaction_marginals']):
-                u = int_to_var.get(i, i)
-                v = int_to_var.get(j, j)
-                info['interaction_marginals'][(u, v)] = dict(zip(configs, probs))
+            if marginal_pairs is None:
+                for (i, j), probs in zip(data['interactions'],
+                                         data['interaction_marginals']):
+                    u = int_to_var.get(i, i)
+                    v = int_to_var.get(j, j)
+                    info['interaction_marginals'][(u, v)] = dict(zip(configs, probs))
+            else:
+                # the pairs come back with the lower index first
+                pair_probs = {(i, j): probs for (i, j), probs
+                              in zip(data['interactions'].tolist(),
+                                     data['interaction_marginals'])}
+                flipped = tuple((t, s) for s, t in configs)
+                for (u, v), (i, j) in zip(interactions, marginal_pairs):
+                    if i < j:
+                        probs = dict(zip(configs, pair_probs[(i, j)]))
+                    else:
+                        probs = dict(zip(flipped, pair_probs[(j, i)]))
+                    info['interaction_marginals'][(u, v)] = probs
 
         energies = bqm.energies((samples, bqm.variables),
                                 dtype=energies_dtype)
@@ -1,6 +1,6 @@
 # distutils: language = c++
 # cython: language_level = 3
-# distutils: include_dirs = dwave/samplers/tree/src/include/
+# distutils: include_dirs = dwave/samplers/tree/src/include/ dwave/samplers/common/src/
 
 # Copyright 2019 D-Wave Systems Inc.
 #
@@ -16,17 +16,27 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import os
+
 import dimod
 import numpy as np
 
 cimport cython
 cimport numpy as np
 from cython.operator cimport dereference as deref
+from libcpp cimport bool
 from dimod cimport cyBQM_float64
 from dimod.libcpp cimport BinaryQuadraticModel as cppBinaryQuadraticModel
 from dimod.binary.binary_quadratic_model import BinaryQuadraticModel
 
-from dwave.samplers.tree.orang cimport energies_type, samples_type, PyArray_ENABLEFLAGS
+from libcpp.string cimport string
+from libcpp.vector cimport vector
+
+from dwave.samplers.common.pool cimport set_worker_pool, shared_worker_pool
+from dwave.samplers.tree.orang cimport energies_type, samples_type, PyArray_ENABLEFLAGS, NodeStats
+
+# run the parallel loops of the kernels on the workers shared by all samplers
+set_worker_pool(shared_worker_pool())
 
 cdef extern from "src/include/solve.hpp":
     void solveBQM[V, B](cppBinaryQuadraticModel[B, V]& refBQM,
@@ -34,9 +44,16 @@ cdef extern from "src/include/solve.hpp":
                         double beta,
                         int low,
                         double max_complexity,
+                        double max_memory,
+                        int max_clamped,
                         int max_solutions,
+                        int num_threads,
+                        bool single_precision,
+                        double mmap_threshold,
+                        const string& mmap_dir,
                         double** energies_data, int* energies_len,
-                        int** sols_data, int* sols_rows, int* sols_cols) except +
+                        int** sols_data, int* sols_rows, int* sols_cols,
+                        vector[NodeStats]* node_stats) except +
 
 samples_dtype = np.intc  # needs to be consistent with samples_type
 energies_dtype = np.double  # needs to be consistent with energies_type 
@@ -45,7 +62,14 @@ energies_dtype = np.double  # needs to be consistent with energies_type
 def solve_bqm_wrapper(bqm: BinaryQuadraticModel,
                       order: list,
                       max_complexity: int,
-                      max_solutions: int = 1):
+                      max_solutions: int = 1,
+                      num_threads: int = 1,
+                      max_memory: float = float('inf'),
+                      single_precision: bool = False,
+                      max_clamped: int = 0,
+                      counters: dict = None,
+                      mmap_threshold: float = float('inf'),
+                      mmap_dir: str = ''):
     """Cython wrapper for :func:`solveBQM`.
 
     Args:
@@ -61,6 +85,40 @@ def solve_bqm_wrapper(bqm: BinaryQuadraticModel,
         max_solutions:
             Maximum number of solutions to find.
 
+        num_threads:
+            Number of threads to build the tables of the tree decomposition on.
+
+        max_memory:
+            Upper bound, in bytes, on the estimated memory taken by the tables
+            of the tree decomposition.
+
+        single_precision:
+            If True, the tables of the tree decomposition hold 32-bit rather
+            than 64-bit floats.
+
+        max_clamped:
+            Maximum number of variables to clamp, and enumerate the values of,
+            if the elimination order exceeds ``max_complexity`` or
+            ``max_memory``. If 0, exceeding either raises an error.
+
+        counters:
+            If given, and the kernel counters are compiled in (see
+            ``DWAVE_SAMPLERS_COUNTERS``), filled with arrays over the nodes
+            of the tree decomposition, in preorder: ``node_variables``, the
+            variable of each node, ``table_sizes``, the number of entries of
+            its table, and ``merge_seconds``, the time taken to merge its
+            tables (summed over the assignments of the clamped variables,
+            if any).
+
+        mmap_threshold:
+            Size, in bytes, from which the tables of the tree decomposition
+            are kept in memory-mapped temporary files rather than in memory.
+            If infinite, no table is.
+
+        mmap_dir:
+            Directory of the memory-mapped files. If empty, ``TMPDIR`` or
+            ``/tmp``.
+
     Returns:
         The samples and marginals.
     """
@@ -74,6 +132,7 @@ def solve_bqm_wrapper(bqm: BinaryQuadraticModel,
     cdef cyBQM_float64 cybqm = bqm.data
     cdef double beta = -1  # solving
     cdef double _max_complexity = max_complexity
+    cdef double _max_memory = max_memory
     cdef int low = -1 if bqm.vartype is dimod.SPIN else 0
 
     cdef int[:] elimination_order = np.asarray(order, dtype=np.intc)
@@ -85,15 +144,24 @@ def solve_bqm_wrapper(bqm: BinaryQuadraticModel,
     cdef int num_energies, srows, scols
     cdef energies_type* energies_pointer
     cdef samples_type* samples_pointer
+    cdef vector[NodeStats] node_stats
+    cdef string _mmap_dir = os.fsencode(mmap_dir)
 
     solveBQM(deref(cybqm.cppbqm),
              elimination_order_ptr,
              beta,
              low,
              _max_complexity,
+             _max_memory,
+             max_clamped,
              max_solutions,
+             num_threads,
+             single_precision,
+             mmap_threshold,
+             _mmap_dir,
              &energies_pointer, &num_energies,
-             &samples_pointer, &srows, &scols
+             &samples_pointer, &srows, &scols,
+             &node_stats if counters is not None else NULL
             )
 
     # create a numpy array without making a copy then tell numpy it needs to
@@ -115,4 +183,16 @@ def solve_bqm_wrapper(bqm: BinaryQuadraticModel,
 
     energies += bqm.offset
 
+    if counters is not None and not node_stats.empty():
+        node_variables = np.empty(node_stats.size(), dtype=np.intc)
+        table_sizes = np.empty(node_stats.size(), dtype=np.int64)
+        merge_seconds = np.empty(node_stats.size(), dtype=np.double)
+        for i in range(node_stats.size()):
+            node_variables[i] = node_stats[i].nodeVar
+            table_sizes[i] = node_stats[i].tableSize
+            merge_seconds[i] = node_stats[i].mergeSeconds
+        counters.update(node_variables=node_variables,
+                        table_sizes=table_sizes,
+                        merge_seconds=merge_seconds)
+
     return samples, energies
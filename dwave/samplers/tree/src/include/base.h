@@ -34,6 +34,14 @@ typedef std::vector<DomIndex> DomIndexVector;
 
 typedef std::vector<std::size_t> SizeVector;
 
+// GCC does not vectorize loops at -O2 before version 12, so the kernels of
+// the table merges ask for it
+#if defined(__GNUC__) && !defined(__clang__)
+#define ORANG_VECTORIZE __attribute__((optimize("tree-vectorize")))
+#else
+#define ORANG_VECTORIZE
+#endif
+
 } // namespace orang
 
 #endif
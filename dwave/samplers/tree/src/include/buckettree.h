@@ -20,9 +20,11 @@
 
 #include <cstddef>
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <vector>
 #include <memory>
+#include <mutex>
 
 #include <base.h>
 #include <exception.h>
@@ -30,6 +32,7 @@
 #include <treedecomp.h>
 #include <task.h>
 #include <merger.h>
+#include <workqueue.h>
 
 namespace orang {
 
@@ -42,6 +45,20 @@ struct NodeTables {
   std::vector<const_table_smartptr> tables;
 };
 
+// What building the lambda table of a node took, recorded when the
+// DWAVE_SAMPLERS_COUNTERS instrumentation is compiled in
+struct NodeStats {
+  Var nodeVar;
+  std::size_t tableSize;  // entries of the node's lambda table
+  double mergeSeconds;    // time spent merging the node's tables into it
+};
+
+#ifdef DWAVE_SAMPLERS_COUNTERS
+constexpr bool nodeStatsEnabled = true;
+#else
+constexpr bool nodeStatsEnabled = false;
+#endif
+
 
 template<typename T>
 class BucketTree {
@@ -71,6 +88,19 @@ private:
 
   typedef typename Node::smartptr node_smartptr;
 
+  // A node of the tree together with its place in it, for building the tables
+  // of the nodes in any order their dependencies allow
+  struct BuildItem {
+    Node* node;
+    const TreeDecompNode* dNode;
+    std::size_t parent;      // index of the parent's item, or noParent
+    std::size_t childIndex;  // index among the parent's children, or the roots
+    std::size_t pending;     // number of children whose tables are not built
+    std::vector<std::size_t> children;
+  };
+
+  static constexpr std::size_t noParent = static_cast<std::size_t>(-1);
+
   const bool solvable_;
   const bool hasNodeTables_;
   const task_type& task_;
@@ -80,14 +110,31 @@ private:
   std::vector<node_smartptr> roots_;
   std::size_t numNodes_;
   std::vector<NodeTables<value_type> > nodeTables_;
+  std::vector<NodeStats> nodeStats_;
+  const int numThreads_;
 
-  typename Node::smartptr buildNode(
+  node_smartptr addNode(
       const TreeDecompNode& dNode,
-      table_vector* parentTables,
-      std::vector<value_type>& rootValues,
-      const DomIndexVector& x0);
+      std::size_t parent,
+      std::size_t childIndex,
+      std::vector<BuildItem>& items);
 
-  void buildNodeTables(node_smartptr& node, const TreeDecompNode& dNode);
+  const_table_smartptr buildNode(
+      Node& n,
+      const TreeDecompNode& dNode,
+      const DomIndexVector& x0,
+      NodeStats* stats);
+
+  void buildNodeTables(Node& node, const TreeDecompNode& dNode, NodeTables<value_type>& nt);
+
+  static double countEntries(
+      const task_type& task,
+      const TreeDecompNode& dNode,
+      bool solvable,
+      bool hasNodeTables,
+      double& peak,
+      double& kept,
+      double& largestMerge);
 
   void solveRecursive(const node_smartptr& n, solution_type& s) const {
     dynamic_cast<solvablemarginalizer_type&>(*n->marginalizer).solve(s);
@@ -96,13 +143,22 @@ private:
     }
   }
 
+  template<typename Visit>
+  void visitRecursive(const node_smartptr& n, Visit& visit) const {
+    visit(dynamic_cast<const solvablemarginalizer_type&>(*n->marginalizer));
+    for (const auto &c: n->children) {
+      visitRecursive(c, visit);
+    }
+  }
+
 public:
   BucketTree(
       const task_type& task,
       const TreeDecomp& decomp,
       const DomIndexVector& x0,
       bool solvable,
-      bool hasNodeTables) :
+      bool hasNodeTables,
+      int numThreads = 1) :
         solvable_(solvable),
         hasNodeTables_(hasNodeTables),
         task_(task),
@@ -111,32 +167,73 @@ public:
         problemValue_(),
         roots_(),
         numNodes_(0),
-        nodeTables_() {
+        nodeTables_(),
+        nodeStats_(),
+        numThreads_(numThreads) {
 
     if (x0_.size() != task_.numVars()) {
       throw InvalidArgumentException("x0 has incorrect size");
     }
 
-    std::vector<value_type> rootValues;
-    rootValues.reserve(decomp.roots().size());
+    // The tree is laid out first, with the items of its nodes in preorder.
+    // The table of a node is built once those of its children are, so the
+    // subtrees of different children are built concurrently.
+    std::vector<BuildItem> items;
     roots_.reserve(decomp.roots().size());
     for (const auto &dNode: decomp.roots()) {
-      roots_.push_back(buildNode(*dNode, 0, rootValues, x0));
-      if (!hasNodeTables_) {
-        roots_.back()->lambdaTables.clear();
-        roots_.back()->baseTables.clear();
+      roots_.push_back(addNode(*dNode, noParent, roots_.size(), items));
+    }
+    numNodes_ = items.size();
+    if (nodeStatsEnabled) {
+      nodeStats_.resize(numNodes_);
+    }
+
+    std::vector<std::size_t> leaves;
+    for (std::size_t i = items.size(); i-- > 0; ) {
+      if (items[i].pending == 0) {
+        leaves.push_back(i);
       }
     }
 
+    std::vector<value_type> rootValues(roots_.size());
+    std::mutex pendingLock;
+    internal::runWorkQueue(numThreads_, leaves,
+        [&](std::size_t i, std::vector<std::size_t>& ready) {
+          BuildItem& item = items[i];
+          const_table_smartptr pLambdaTable = buildNode(*item.node, *item.dNode, x0,
+              nodeStatsEnabled ? &nodeStats_[i] : nullptr);
+
+          if (item.parent == noParent) {
+            rootValues[item.childIndex] = (*pLambdaTable)[0];
+          } else {
+            BuildItem& parent = items[item.parent];
+            std::lock_guard<std::mutex> guard(pendingLock);
+            parent.node->lambdaTables[item.childIndex] = pLambdaTable;
+            if (--parent.pending == 0) {
+              ready.push_back(item.parent);
+            }
+          }
+        });
+
     problemValue_ = task_.problemValue(rootValues, x0, decomp.clampedVars());
 
     if (hasNodeTables_) {
-      nodeTables_.reserve(numNodes_);
-      TreeDecompNode::node_vector::const_iterator dRootsIter = decomp.roots().begin();
-      for (auto &r: roots_) {
-        buildNodeTables(r, **dRootsIter);
-        ++dRootsIter;
+      // The tables of the children of a node are built from its own, so the
+      // subtrees of its children are then also built concurrently.  The node
+      // tables are kept in preorder.
+      nodeTables_.resize(numNodes_);
+      std::vector<std::size_t> rootItems;
+      for (std::size_t i = items.size(); i-- > 0; ) {
+        if (items[i].parent == noParent) {
+          rootItems.push_back(i);
+        }
       }
+      internal::runWorkQueue(numThreads_, rootItems,
+          [&](std::size_t i, std::vector<std::size_t>& ready) {
+            BuildItem& item = items[i];
+            buildNodeTables(*item.node, *item.dNode, nodeTables_[i]);
+            ready.insert(ready.end(), item.children.rbegin(), item.children.rend());
+          });
     }
 
     if (!solvable_) {
@@ -144,6 +241,41 @@ public:
     }
   }
 
+  // An estimate of the most bytes that the tables of a BucketTree built from
+  // task and decomp with the given arguments take up at once, so that a
+  // problem that will not fit can be rejected before any table is built.
+  //
+  // Each node of decomp contributes a table of up to 2^decomp.complexity()
+  // entries.  Unless solvable or hasNodeTables, the tables of the children of
+  // a node are released once merged, so only those of a frontier of the tree
+  // are held at once.  Otherwise the solvable marginalizer of every node
+  // (about one entry per entry of its table) or the lambda and pi tables of
+  // every node are kept for the lifetime of the tree.  Solution sets and base
+  // tables are not counted.
+  static double memoryEstimate(
+      const task_type& task,
+      const TreeDecomp& decomp,
+      bool solvable,
+      bool hasNodeTables,
+      int numThreads = 1) {
+
+    double peak = 0.0;
+    double kept = 0.0;
+    double largestMerge = 0.0;
+    for (const auto &dNode: decomp.roots()) {
+      double rootPeak;
+      countEntries(task, *dNode, solvable, hasNodeTables, rootPeak, kept, largestMerge);
+      peak = std::max(peak, rootPeak);
+    }
+
+    // other threads are each merging tables of their own
+    if (numThreads > 1) {
+      peak += (numThreads - 1) * largestMerge;
+    }
+
+    return sizeof(value_type) * (peak + kept);
+  }
+
   const task_type& task() const { return task_; }
 
   bool solvable() const { return solvable_; }
@@ -164,6 +296,24 @@ public:
     }
   }
 
+  // Calls visit with the solvable marginalizer of each node, in the order in
+  // which solve() runs them.  This lets the marginalizers be driven through
+  // their own interface, eg. to draw many solutions in one pass over the tree.
+  template<typename Visit>
+  void visitSolvableMarginalizers(Visit visit) const {
+    if (solvable_) {
+      for (const auto &r: roots_) {
+        visitRecursive(r, visit);
+      }
+    } else {
+      throw OperationUnavailable();
+    }
+  }
+
+  // The stats of building each node, in preorder, or none unless
+  // DWAVE_SAMPLERS_COUNTERS is defined
+  const std::vector<NodeStats>& nodeStats() const { return nodeStats_; }
+
   const std::vector<nodetables_type>& nodeTables() const {
     if (hasNodeTables_) {
       return nodeTables_;
@@ -175,21 +325,39 @@ public:
 
 
 template<typename T>
-typename BucketTree<T>::node_smartptr BucketTree<T>::buildNode(
+typename BucketTree<T>::node_smartptr BucketTree<T>::addNode(
     const TreeDecompNode& dNode,
-    typename BucketTree<T>::table_vector* parentTables,
-    std::vector<value_type>& rootValues,
-    const DomIndexVector& x0) {
-
-  ++numNodes_;
+    std::size_t parent,
+    std::size_t childIndex,
+    std::vector<typename BucketTree<T>::BuildItem>& items) {
 
   node_smartptr n = node_smartptr( new Node );
-  n->baseTables = task_.baseTables(dNode, x0);
+  n->lambdaTables.resize(dNode.children().size());
+
+  std::size_t index = items.size();
+  items.push_back(BuildItem{n.get(), &dNode, parent, childIndex, dNode.children().size(),
+      std::vector<std::size_t>()});
+  if (parent != noParent) {
+    items[parent].children.push_back(index);
+  }
+
   n->children.reserve(dNode.children().size());
   for (const auto &cdn: dNode.children()) {
-    n->children.push_back( buildNode(*cdn, &n->lambdaTables, rootValues, x0) );
+    n->children.push_back( addNode(*cdn, index, n->children.size(), items) );
   }
 
+  return n;
+}
+
+template<typename T>
+typename BucketTree<T>::const_table_smartptr BucketTree<T>::buildNode(
+    typename BucketTree<T>::Node& n,
+    const TreeDecompNode& dNode,
+    const DomIndexVector& x0,
+    NodeStats* stats) {
+
+  n.baseTables = task_.baseTables(dNode, x0);
+
   if (solvable_) {
     DomIndexVector inDomSizes;
     inDomSizes.reserve(dNode.sepVars().size());
@@ -197,53 +365,98 @@ typename BucketTree<T>::node_smartptr BucketTree<T>::buildNode(
       inDomSizes.push_back(task_.domSize(v));
     }
 
-    n->marginalizer = task_.solvableMarginalizer(dNode.sepVars(), inDomSizes,
+    n.marginalizer = task_.solvableMarginalizer(dNode.sepVars(), inDomSizes,
         dNode.nodeVar(), task_.domSize(dNode.nodeVar()));
   } else {
-    n->marginalizer = task_.marginalizer();
+    n.marginalizer = task_.marginalizer();
   }
 
   table_vector inTables;
-  inTables.reserve(n->baseTables.size() + n->lambdaTables.size());
-  copy(n->baseTables.begin(), n->baseTables.end(), back_inserter(inTables));
-  copy(n->lambdaTables.begin(), n->lambdaTables.end(), back_inserter(inTables));
+  inTables.reserve(n.baseTables.size() + n.lambdaTables.size());
+  copy(n.baseTables.begin(), n.baseTables.end(), back_inserter(inTables));
+  copy(n.lambdaTables.begin(), n.lambdaTables.end(), back_inserter(inTables));
+  const auto start = stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
   const_table_smartptr pLambdaTable = mergeTables_(
-      dNode.sepVars(), inTables.begin(), inTables.end(), *n->marginalizer);
-
-  if (parentTables) {
-    parentTables->push_back(pLambdaTable);
-  } else {
-    rootValues.push_back((*pLambdaTable)[0]);
+      dNode.sepVars(), inTables.begin(), inTables.end(), *n.marginalizer);
+  if (stats) {
+    stats->nodeVar = dNode.nodeVar();
+    stats->tableSize = pLambdaTable->size();
+    stats->mergeSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
   }
 
   if (!hasNodeTables_) {
-    n->baseTables.clear();
-    n->lambdaTables.clear();
+    n.baseTables.clear();
+    n.lambdaTables.clear();
   }
 
-  return n;
+  return pLambdaTable;
 }
 
+// Returns the number of entries of the lambda table of dNode.  Sets peak to
+// the most entries held at once while building its subtree on one thread,
+// besides those kept, and adds the entries kept once it is built to kept.
 template<typename T>
-void BucketTree<T>::buildNodeTables(typename BucketTree<T>::Node::smartptr& node, const TreeDecompNode& dNode) {
+double BucketTree<T>::countEntries(
+    const task_type& task,
+    const TreeDecompNode& dNode,
+    bool solvable,
+    bool hasNodeTables,
+    double& peak,
+    double& kept,
+    double& largestMerge) {
+
+  using std::max;
+
+  double lambdaSize = 1.0;
+  for (auto v: dNode.sepVars()) {
+    lambdaSize *= task.domSize(v);
+  }
+
+  // the lambda tables of the children built so far wait for the others
+  double childLambdas = 0.0;
+  peak = 0.0;
+  for (const auto &c: dNode.children()) {
+    double childPeak;
+    double childLambda = countEntries(task, *c, solvable, hasNodeTables, childPeak, kept, largestMerge);
+    peak = max(peak, (hasNodeTables ? 0.0 : childLambdas) + childPeak);
+    childLambdas += childLambda;
+  }
+
+  double merge = (hasNodeTables ? 0.0 : childLambdas) + lambdaSize;
+  peak = max(peak, merge);
+  largestMerge = max(largestMerge, merge);
+
+  if (solvable) {
+    kept += lambdaSize * task.domSize(dNode.nodeVar());
+  }
+  if (hasNodeTables) {
+    kept += 2 * lambdaSize;
+  }
+
+  return lambdaSize;
+}
+
+template<typename T>
+void BucketTree<T>::buildNodeTables(
+    typename BucketTree<T>::Node& node,
+    const TreeDecompNode& dNode,
+    NodeTables<value_type>& nt) {
 
   using std::size_t;
   using std::copy;
   using std::back_inserter;
 
-  nodeTables_.push_back(NodeTables<value_type>());
-  NodeTables<value_type>& nt = nodeTables_.back();
-
-  size_t numTables = node->baseTables.size() + node->lambdaTables.size();
+  size_t numTables = node.baseTables.size() + node.lambdaTables.size();
 
   nt.nodeVar = dNode.nodeVar();
   nt.sepVars = dNode.sepVars();
 
   nt.tables.reserve(numTables + 1);
-  copy(node->baseTables.begin(), node->baseTables.end(), back_inserter(nt.tables));
-  copy(node->lambdaTables.begin(), node->lambdaTables.end(), back_inserter(nt.tables));
-  if (node->piTable) {
-    nt.tables.push_back(node->piTable);
+  copy(node.baseTables.begin(), node.baseTables.end(), back_inserter(nt.tables));
+  copy(node.lambdaTables.begin(), node.lambdaTables.end(), back_inserter(nt.tables));
+  if (node.piTable) {
+    nt.tables.push_back(node.piTable);
   }
 
   size_t numChildren = dNode.children().size();
@@ -251,10 +464,10 @@ void BucketTree<T>::buildNodeTables(typename BucketTree<T>::Node::smartptr& node
   if (numChildren > 0) {
     table_vector inTables;
     inTables.reserve(numTables);
-    copy(node->lambdaTables.begin() + 1, node->lambdaTables.end(), back_inserter(inTables));
-    copy(node->baseTables.begin(), node->baseTables.end(), back_inserter(inTables));
-    if (node->piTable) {
-      inTables.push_back(node->piTable);
+    copy(node.lambdaTables.begin() + 1, node.lambdaTables.end(), back_inserter(inTables));
+    copy(node.baseTables.begin(), node.baseTables.end(), back_inserter(inTables));
+    if (node.piTable) {
+      inTables.push_back(node.piTable);
     }
 
     const TreeDecompNode::node_vector& dChildren = dNode.children();
@@ -266,22 +479,18 @@ void BucketTree<T>::buildNodeTables(typename BucketTree<T>::Node::smartptr& node
 
       for (size_t i = 0; i < numChildren; ++i) {
         if (i > 0) {
-          inTables[i - 1] = node->lambdaTables[i - 1];
+          inTables[i - 1] = node.lambdaTables[i - 1];
         }
 
-        node->children[i]->piTable = merge(
+        node.children[i]->piTable = merge(
             dChildren[i]->sepVars(), inTables.begin(), inTables.end(), *mrg);
       }
     }
-
-    for (size_t i = 0; i < numChildren; ++i) {
-      buildNodeTables(node->children[i], *dChildren[i]);
-    }
   }
 
-  node->baseTables.clear();
-  node->lambdaTables.clear();
-  node->piTable.reset();
+  node.baseTables.clear();
+  node.lambdaTables.clear();
+  node.piTable.reset();
 }
 
 } // namespace orang
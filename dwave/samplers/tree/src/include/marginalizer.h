@@ -35,11 +35,31 @@ public:
 private:
   virtual value_type marginalizeImpl(std::size_t outIndex, const table_type& mrgTable) = 0;
 
+  virtual void marginalizeBlockImpl(std::size_t firstOut, std::size_t numOut, const value_type* values,
+      value_type* out, table_type& mrgTable) {
+    for (std::size_t i = 0; i < numOut; ++i) {
+      for (std::size_t m = 0; m < mrgTable.size(); ++m) {
+        mrgTable[m] = values[m * numOut + i];
+      }
+      out[i] = marginalizeImpl(firstOut + i, mrgTable);
+    }
+  }
+
 public:
   virtual ~Marginalizer() {}
   value_type operator()(std::size_t outIndex, const table_type& mrgTable) {
     return marginalizeImpl(outIndex, mrgTable);
   }
+
+  // Marginalizes the numOut consecutive output entries starting at firstOut
+  // at once: values[m * numOut + i] is entry m of the table of marginalized
+  // values of output entry firstOut + i, whose result goes to out[i].
+  // mrgTable has the scope of the marginalized variables, and may be used as
+  // scratch space.  By default each entry is marginalized on its own.
+  void marginalizeBlock(std::size_t firstOut, std::size_t numOut, const value_type* values,
+      value_type* out, table_type& mrgTable) {
+    marginalizeBlockImpl(firstOut, numOut, values, out, mrgTable);
+  }
 };
 
 template<typename Y, typename S>
@@ -65,6 +65,14 @@ public:
       const TblIter& tablesBegin,
       const TblIter& tablesEnd,
       marginalizer_type& marginalizer) const;
+
+private:
+  template<typename TblIter>
+  table_smartptr mergeBinary(
+      const VarVector& outScope,
+      const TblIter& tablesBegin,
+      const TblIter& tablesEnd,
+      marginalizer_type& marginalizer) const;
 };
 
 
@@ -96,6 +104,33 @@ public:
   }
 };
 
+// dst[i] = src[index[i]], or combined with it if first is false
+template<typename T, typename Y>
+ORANG_VECTORIZE
+void gatherCombine(std::size_t n, const Y* src, const std::size_t* index, Y* dst, bool first) {
+  if (first) {
+    for (std::size_t i = 0; i < n; ++i) {
+      dst[i] = src[index[i]];
+    }
+  } else {
+    for (std::size_t i = 0; i < n; ++i) {
+      dst[i] = T::combine(dst[i], src[index[i]]);
+    }
+  }
+}
+
+// Sets offsets[k], for each k < 2^steps.size(), to the sum of the steps of
+// the bits set in k
+inline void binaryOffsets(const SizeVector& steps, SizeVector& offsets) {
+  offsets.assign(std::size_t(1) << steps.size(), 0);
+  for (std::size_t b = 0; b < steps.size(); ++b) {
+    const std::size_t half = std::size_t(1) << b;
+    for (std::size_t k = 0; k < half; ++k) {
+      offsets[half + k] = offsets[k] + steps[b];
+    }
+  }
+}
+
 template<typename T>
 class GrayVar {
 public:
@@ -196,13 +231,21 @@ TableMerger<T>::operator ()(
     return t;
   }
 
+  bool binary = true;
   for (auto it = tablesBegin; it != tablesEnd; ++it) {
     for (const auto &v: (*it)->vars()) {
       if (v.domSize != task_.domSize(v.index)) {
         throw InvalidArgumentException("Table and Task domain sizes don't match");
       }
+      binary = binary && v.domSize == 2;
     }
   }
+  for (auto var: outScope) {
+    binary = binary && task_.domSize(var) == 2;
+  }
+  if (binary) {
+    return mergeBinary(outScope, tablesBegin, tablesEnd, marginalize);
+  }
 
   //===========================================================================================================
   //
@@ -221,7 +264,8 @@ TableMerger<T>::operator ()(
   for (auto var: outScope) {
     outDomSizes.push_back(task_.domSize(var));
   }
-  table_smartptr outTable( new table_type(outScope, outDomSizes));
+  table_smartptr outTable( new table_type(outScope, outDomSizes, typename table_type::value_type(),
+      task_.tableStorage()) );
   table_type& outTableRef = *outTable.get();
   size_t outIndex = 0;
 
@@ -328,6 +372,112 @@ TableMerger<T>::operator ()(
   return outTable;
 }
 
+// The same merge, for variables whose domains all have size 2.  Every
+// variable is then a bit of the indices of the tables it is in, so the input
+// entries of a run of output entries are gathered through precomputed
+// offsets, one input table and one setting of the marginalized variables at a
+// time, into rows that the marginalizer reduces a block at a time.  The
+// entries are combined in the same order as above, so the results are the
+// same.
+template<typename T>
+template<typename TblIter>
+typename TableMerger<T>::table_smartptr
+TableMerger<T>::mergeBinary(
+    const VarVector& outScope,
+    const TblIter& tablesBegin,
+    const TblIter& tablesEnd,
+    typename TableMerger<T>::marginalizer_type& marginalize) const {
+
+  using std::size_t;
+  using std::vector;
+
+  typedef typename TableMerger<T>::table_type table_type;
+  typedef typename table_type::value_type value_type;
+
+  // output entries are marginalized in blocks of up to 2^maxBlockBits
+  static const size_t maxBlockBits = 10;
+
+  // the marginalized variables are those of the input tables not in outScope
+  VarVector mrgScope;
+  for (auto it = tablesBegin; it != tablesEnd; ++it) {
+    for (const auto &v: (*it)->vars()) {
+      if (!std::binary_search(outScope.begin(), outScope.end(), v.index)) {
+        mrgScope.push_back(v.index);
+      }
+    }
+  }
+  std::sort(mrgScope.begin(), mrgScope.end());
+  mrgScope.erase(std::unique(mrgScope.begin(), mrgScope.end()), mrgScope.end());
+
+  table_smartptr outTable( new table_type(outScope, DomIndexVector(outScope.size(), 2), value_type(),
+      task_.tableStorage()) );
+  table_type mrgTable(mrgScope, DomIndexVector(mrgScope.size(), 2));
+
+  // the blocks below read the input tables and write the output table in
+  // the order of their indices, which mapped tables are told about
+  SequentialSweep<TblIter> inSweep(tablesBegin, tablesEnd);
+  outTable->adviseSequential(true);
+
+  const size_t blockBits = std::min(outScope.size(), maxBlockBits);
+  const size_t blockSize = size_t(1) << blockBits;
+  const size_t numBlocks = outTable->size() / blockSize;
+  const size_t numMrg = mrgTable.size();
+
+  // for each input table: the offsets of the settings of the low bits of
+  // output indices, the steps of their high bits, and the offsets of the
+  // marginalized indices
+  struct BinaryTable {
+    const value_type* values;
+    SizeVector lowOffsets;
+    SizeVector highSteps;
+    SizeVector mrgOffsets;
+  };
+  vector<BinaryTable> inTables;
+  for (auto it = tablesBegin; it != tablesEnd; ++it) {
+    SizeVector outSteps(outScope.size(), 0);
+    SizeVector mrgSteps(mrgScope.size(), 0);
+    for (const auto &v: (*it)->vars()) {
+      auto outIter = std::lower_bound(outScope.begin(), outScope.end(), v.index);
+      if (outIter != outScope.end() && *outIter == v.index) {
+        outSteps[outIter - outScope.begin()] = v.stepSize;
+      } else {
+        mrgSteps[std::lower_bound(mrgScope.begin(), mrgScope.end(), v.index) - mrgScope.begin()] = v.stepSize;
+      }
+    }
+
+    BinaryTable t;
+    t.values = &(**it)[0];
+    internal::binaryOffsets(SizeVector(outSteps.begin(), outSteps.begin() + blockBits), t.lowOffsets);
+    t.highSteps.assign(outSteps.begin() + blockBits, outSteps.end());
+    internal::binaryOffsets(mrgSteps, t.mrgOffsets);
+    inTables.push_back(std::move(t));
+  }
+
+  vector<value_type> rows(numMrg * blockSize);
+  value_type* out = &(*outTable)[0];
+  for (size_t block = 0; block < numBlocks; ++block) {
+    bool first = true;
+    for (const auto &t: inTables) {
+      size_t base = 0;
+      for (size_t b = 0; b < t.highSteps.size(); ++b) {
+        if ((block >> b) & 1) {
+          base += t.highSteps[b];
+        }
+      }
+      for (size_t m = 0; m < numMrg; ++m) {
+        internal::gatherCombine<T>(blockSize, t.values + base + t.mrgOffsets[m], t.lowOffsets.data(),
+            rows.data() + m * blockSize, first);
+      }
+      first = false;
+    }
+
+    marginalize.marginalizeBlock(block * blockSize, blockSize, rows.data(), out + block * blockSize, mrgTable);
+  }
+
+  outTable->adviseSequential(false);
+  return outTable;
+}
+
 }
 
 #endif
@@ -30,12 +30,16 @@
 
 namespace orang {
 
-class LogSumMarginalizer : public Marginalizer<double> {
+// Tables may hold floats (Y = float) to halve their size.  The sums of
+// exponentials are always taken in double precision.
+template<typename Y = double>
+class LogSumMarginalizer : public Marginalizer<Y> {
 public:
-  typedef Table<double> table_type;
+  typedef Y value_type;
+  typedef Table<value_type> table_type;
 
 private:
-  virtual double marginalizeImpl(std::size_t, const table_type& mrgTable) {
+  virtual value_type marginalizeImpl(std::size_t, const table_type& mrgTable) {
 
     double yMax = *std::max_element(mrgTable.begin(), mrgTable.end());
     double fsum = 0.0;
@@ -44,28 +48,56 @@ private:
       fsum += exp(y - yMax);
     }
 
-    return yMax + log(fsum);
+    return static_cast<value_type>(yMax + log(fsum));
+  }
+
+  ORANG_VECTORIZE
+  virtual void marginalizeBlockImpl(std::size_t, std::size_t numOut, const value_type* values,
+      value_type* out, table_type& mrgTable) {
+    const std::size_t numMrg = mrgTable.size();
+    std::vector<double> fsum(numOut, 0.0);
+
+    // out holds the largest values until they are needed
+    std::copy(values, values + numOut, out);
+    for (std::size_t m = 1; m < numMrg; ++m) {
+      const value_type* row = values + m * numOut;
+      for (std::size_t i = 0; i < numOut; ++i) {
+        out[i] = out[i] < row[i] ? row[i] : out[i];
+      }
+    }
+    for (std::size_t m = 0; m < numMrg; ++m) {
+      const value_type* row = values + m * numOut;
+      for (std::size_t i = 0; i < numOut; ++i) {
+        fsum[i] += exp(static_cast<double>(row[i]) - out[i]);
+      }
+    }
+    for (std::size_t i = 0; i < numOut; ++i) {
+      out[i] = static_cast<value_type>(out[i] + log(fsum[i]));
+    }
   }
 };
 
 
 
-template<typename Rng>
-class SolvableLogSumMarginalizer : public SolvableMarginalizer<double, DomIndexVector> {
+template<typename Rng, typename Y = double>
+class SolvableLogSumMarginalizer : public SolvableMarginalizer<Y, DomIndexVector> {
 public:
-  typedef Table<double> table_type;
+  typedef Y value_type;
+  typedef Table<value_type> table_type;
 
 private:
+  typedef typename SolvableMarginalizer<Y, DomIndexVector>::varstep_vector varstep_vector;
+
   Rng& rng_;
   varstep_vector inVarsSteps_;
   Var outVar_;
   DomIndex outStepSize_;
-  std::vector<double> cumProbs_;
+  std::vector<value_type> cumProbs_;
 
-  virtual double marginalizeImpl(std::size_t n, const table_type& mrgTable) {
+  virtual value_type marginalizeImpl(std::size_t n, const table_type& mrgTable) {
     using std::transform;
     using std::make_pair;
-    typedef std::vector<double>::iterator value_iterator;
+    typedef typename std::vector<value_type>::iterator value_iterator;
 
     double yMax = *std::max_element(mrgTable.begin(), mrgTable.end());
     double fsum(0.0);
@@ -73,37 +105,60 @@ private:
     value_iterator cpBegin = cumProbs_.begin() + n * outStepSize_;
     value_iterator cpIter = cpBegin;
     value_iterator cpEnd = cpBegin + outStepSize_;
-    table_type::const_iterator tblIter = mrgTable.begin();
+    typename table_type::const_iterator tblIter = mrgTable.begin();
     while (cpIter != cpEnd) {
       fsum += exp(*tblIter - yMax);
-      *cpIter = fsum;
+      *cpIter = static_cast<value_type>(fsum);
       ++cpIter;
       ++tblIter;
     }
     fsum += exp(*tblIter - yMax);
-    transform(cpBegin, cpEnd, cpBegin, [&](double a){ return a / fsum; });
+    transform(cpBegin, cpEnd, cpBegin, [&](value_type a){ return static_cast<value_type>(a / fsum); });
 
-    return yMax + log(fsum);
+    return static_cast<value_type>(yMax + log(fsum));
   }
 
-  virtual void solveImpl(DomIndexVector& s) const {
-    using std::find_if;
-    using std::make_pair;
-    typedef std::vector<double>::const_iterator value_const_iterator;
+  virtual void marginalizeBlockImpl(std::size_t firstOut, std::size_t numOut, const value_type* values,
+      value_type* out, table_type& mrgTable) {
+    const std::size_t numMrg = mrgTable.size();
+    for (std::size_t i = 0; i < numOut; ++i) {
+      double yMax = values[i];
+      for (std::size_t m = 1; m < numMrg; ++m) {
+        yMax = yMax < values[m * numOut + i] ? values[m * numOut + i] : yMax;
+      }
+
+      typename std::vector<value_type>::iterator cpBegin = cumProbs_.begin() + (firstOut + i) * outStepSize_;
+      double fsum(0.0);
+      for (std::size_t m = 0; m < outStepSize_; ++m) {
+        fsum += exp(values[m * numOut + i] - yMax);
+        cpBegin[m] = static_cast<value_type>(fsum);
+      }
+      fsum += exp(values[outStepSize_ * numOut + i] - yMax);
+      for (std::size_t m = 0; m < outStepSize_; ++m) {
+        cpBegin[m] = static_cast<value_type>(cpBegin[m] / fsum);
+      }
+
+      out[i] = static_cast<value_type>(yMax + log(fsum));
+    }
+  }
 
+  // The value of the out variable drawn by the uniform variate u, given the
+  // values of the in variables in s.  The cumulative probabilities are
+  // nondecreasing, so the first one above u is found by binary search.
+  template<typename S>
+  DomIndex draw(const S& s, double u) const {
     size_t n = 0;
     for (const auto &vs: inVarsSteps_) {
       n += s[vs.first] * vs.second;
     }
-    n *= outStepSize_;
 
-    value_const_iterator cpBegin = cumProbs_.begin() + n;
-    value_const_iterator cpEnd = cpBegin + outStepSize_;
-    const double rng = rng_();
-    value_const_iterator cpFound = find_if(cpBegin, cpEnd, [&](double a){ return rng < a; });
-    DomIndex outI = static_cast<DomIndex>(cpFound - cpBegin);
+    const value_type* cpBegin = cumProbs_.data() + n * outStepSize_;
+    const value_type* cpEnd = cpBegin + outStepSize_;
+    return static_cast<DomIndex>(std::upper_bound(cpBegin, cpEnd, u) - cpBegin);
+  }
 
-    s[outVar_] = outI;
+  virtual void solveImpl(DomIndexVector& s) const {
+    s[outVar_] = draw(s, rng_());
   }
 
 public:
@@ -117,16 +172,29 @@ public:
     outStepSize_(outDomSize - 1),
     cumProbs_() {
 
-    size_t numInEntries = buildStepSizes(inScope, inDomSizes, inVarsSteps_);
+    size_t numInEntries = SolvableLogSumMarginalizer::buildStepSizes(inScope, inDomSizes, inVarsSteps_);
     cumProbs_.assign(numInEntries * outStepSize_, 0.0);
   }
 
+  // Draws the value of the out variable of numSolutions solutions at once, the
+  // i-th of which starts at solutions + i * stride, taking the uniform variates
+  // from rng rather than from the marginalizer's own generator.  Solutions can
+  // then be drawn by several threads, each with its own rng, and the values
+  // are those solve() would draw given the same variates.
+  template<typename R>
+  void solveBlock(std::size_t numSolutions, DomIndex* solutions, std::size_t stride, R& rng) const {
+    for (std::size_t i = 0; i < numSolutions; ++i) {
+      DomIndex* s = solutions + i * stride;
+      s[outVar_] = draw(s, rng());
+    }
+  }
+
 };
 
-template<typename Rng>
-class LogSumProductOperations : public Plus<double> {
+template<typename Rng, typename Y = double>
+class LogSumProductOperations : public Plus<Y> {
 public:
-  typedef double value_type;
+  typedef Y value_type;
   typedef DomIndexVector solution_type;
   typedef MarginalizerTypes<value_type,solution_type> marginalizer_types;
   typedef typename marginalizer_types::marginalizer_type marginalizer_type;
@@ -145,7 +213,7 @@ private:
 
 public:
   LogSumProductOperations(const CtorArgs& ca) :
-    rng_(ca.rng), marginalizer_(new LogSumMarginalizer) {}
+    rng_(ca.rng), marginalizer_(new LogSumMarginalizer<value_type>) {}
 
   marginalizer_smartptr marginalizer() const {
     return marginalizer_;
@@ -155,7 +223,7 @@ public:
       const VarVector& inScope, const DomIndexVector& inDomSizes,
       Var outVar, DomIndex outDomSize) const {
     return solvablemarginalizer_smartptr(
-        new SolvableLogSumMarginalizer<Rng>(rng_, inScope, inDomSizes, outVar, outDomSize));
+        new SolvableLogSumMarginalizer<Rng, value_type>(rng_, inScope, inDomSizes, outVar, outDomSize));
   }
 
   solution_type initSolution(const DomIndexVector& x0) const {
@@ -19,6 +19,7 @@
 #define INCLUDED_ORANG_OPERATIONS_MIN_H
 
 #include <cstddef>
+#include <cstdint>
 #include <algorithm>
 #include <iterator>
 #include <set>
@@ -44,6 +45,19 @@ private:
   virtual value_type marginalizeImpl(std::size_t, const table_type& mrgTable) {
     return *std::min_element(mrgTable.begin(), mrgTable.end(), value_compare());
   }
+
+  ORANG_VECTORIZE
+  virtual void marginalizeBlockImpl(std::size_t, std::size_t numOut, const value_type* values,
+      value_type* out, table_type& mrgTable) {
+    value_compare less;
+    std::copy(values, values + numOut, out);
+    for (std::size_t m = 1; m < mrgTable.size(); ++m) {
+      const value_type* row = values + m * numOut;
+      for (std::size_t i = 0; i < numOut; ++i) {
+        out[i] = less(row[i], out[i]) ? row[i] : out[i];
+      }
+    }
+  }
 };
 
 
@@ -88,6 +102,159 @@ public:
   const solution_set& solutions() const { return solSet_; }
 };
 
+
+// A MinSolutionSet kept in flat arrays, for backtracking with many solutions
+// without allocating per solution.  The storage of up to maxSolutions
+// solutions is reserved up front and reused, and each assignment is packed
+// into a row of rowWords() 64-bit words, at bitsPerVar() bits per variable.
+// The first variables of a row take the most significant bits of its first
+// word, so that comparing rows word by word orders them as their
+// DomIndexVectors are ordered.  SolvableMinMarginalizer::solveFlat keeps the
+// solutions sorted as MinSolutionCompare sorts them.
+template<typename Y, typename Compare=std::less<Y> >
+class FlatMinSolutionSet {
+public:
+  typedef Y value_type;
+  typedef Compare value_compare;
+  typedef std::uint64_t word_type;
+
+private:
+  static const std::size_t wordBits = 64;
+
+  std::size_t maxSolutions_;
+  std::size_t numVars_;
+  std::size_t bitsPerVar_;
+  std::size_t varsPerWord_;
+  std::size_t rowWords_;
+  std::vector<value_type> values_;
+  std::vector<word_type> rows_;
+
+  template<typename Y2, typename Cmb, typename Compare2> friend class SolvableMinMarginalizer;
+
+  // A solution being built by solveFlat: solution parent of its input with
+  // the out variable set to x
+  struct Candidate {
+    value_type value;
+    std::size_t parent;
+    DomIndex x;
+  };
+
+  // solveFlat's bounded heap, kept here to be reused
+  std::vector<Candidate> candidates_;
+
+  std::size_t shift(Var v) const { return wordBits - bitsPerVar_ * (v % varsPerWord_ + 1); }
+  word_type mask() const { return (word_type(1) << bitsPerVar_) - 1; }
+
+  // Word w of solution i, with variable v set to x if it is in that word
+  word_type word(std::size_t i, std::size_t w, Var v, DomIndex x) const {
+    word_type r = rows_[i * rowWords_ + w];
+    if (v / varsPerWord_ == w) {
+      r = (r & ~(mask() << shift(v))) | (word_type(x) << shift(v));
+    }
+    return r;
+  }
+
+  // Whether solution i with v set to x is lexicographically before solution
+  // j with v set to y
+  bool rowLess(std::size_t i, DomIndex x, std::size_t j, DomIndex y, Var v) const {
+    for (std::size_t w = 0; w < rowWords_; ++w) {
+      word_type a = word(i, w, v, x);
+      word_type b = word(j, w, v, y);
+      if (a != b) {
+        return a < b;
+      }
+    }
+    return false;
+  }
+
+  void checkLayout(const FlatMinSolutionSet& other) const {
+    if (other.numVars_ != numVars_ || other.bitsPerVar_ != bitsPerVar_) {
+      throw InvalidArgumentException("solution sets have different layouts");
+    }
+  }
+
+public:
+  FlatMinSolutionSet(std::size_t maxSolutions, std::size_t numVars, DomIndex maxDomSize) :
+    maxSolutions_(maxSolutions),
+    numVars_(numVars),
+    bitsPerVar_(1),
+    varsPerWord_(),
+    rowWords_(),
+    values_(),
+    rows_(),
+    candidates_() {
+
+    if (maxSolutions_ == 0) {
+      throw InvalidArgumentException("maxSolutions must be positive");
+    }
+    while (bitsPerVar_ < wordBits && (word_type(1) << bitsPerVar_) < maxDomSize) {
+      ++bitsPerVar_;
+    }
+    varsPerWord_ = wordBits / bitsPerVar_;
+    rowWords_ = std::max<std::size_t>(1, (numVars_ + varsPerWord_ - 1) / varsPerWord_);
+    values_.reserve(maxSolutions_);
+    rows_.reserve(maxSolutions_ * rowWords_);
+    candidates_.reserve(maxSolutions_);
+  }
+
+  std::size_t maxSolutions() const { return maxSolutions_; }
+  std::size_t numVars() const { return numVars_; }
+  std::size_t bitsPerVar() const { return bitsPerVar_; }
+  std::size_t rowWords() const { return rowWords_; }
+  std::size_t size() const { return values_.size(); }
+
+  const value_type& value(std::size_t i) const { return values_[i]; }
+
+  DomIndex get(std::size_t i, Var v) const {
+    return static_cast<DomIndex>((rows_[i * rowWords_ + v / varsPerWord_] >> shift(v)) & mask());
+  }
+
+  DomIndexVector solution(std::size_t i) const {
+    DomIndexVector s(numVars_);
+    for (Var v = 0; v < numVars_; ++v) {
+      s[v] = get(i, v);
+    }
+    return s;
+  }
+
+  void clear() {
+    values_.clear();
+    rows_.clear();
+  }
+
+  // Appends a solution; solutions must be appended in increasing order.
+  void push_back(const value_type& value, const DomIndexVector& solution) {
+    if (solution.size() != numVars_ || values_.size() == maxSolutions_) {
+      throw InvalidArgumentException();
+    }
+    values_.push_back(value);
+    rows_.resize(rows_.size() + rowWords_, 0);
+    word_type* row = &rows_[rows_.size() - rowWords_];
+    for (Var v = 0; v < numVars_; ++v) {
+      row[v / varsPerWord_] |= word_type(solution[v]) << shift(v);
+    }
+  }
+
+  // Appends solution i of other, with variable v set to x
+  void push_back(const value_type& value, const FlatMinSolutionSet& other, std::size_t i, Var v, DomIndex x) {
+    values_.push_back(value);
+    for (std::size_t w = 0; w < rowWords_; ++w) {
+      rows_.push_back(other.word(i, w, v, x));
+    }
+  }
+
+  void swap(FlatMinSolutionSet& other) {
+    std::swap(maxSolutions_, other.maxSolutions_);
+    std::swap(numVars_, other.numVars_);
+    std::swap(bitsPerVar_, other.bitsPerVar_);
+    std::swap(varsPerWord_, other.varsPerWord_);
+    std::swap(rowWords_, other.rowWords_);
+    values_.swap(other.values_);
+    rows_.swap(other.rows_);
+    candidates_.swap(other.candidates_);
+  }
+};
+
 template<typename Y, typename Cmb, typename Compare> class MinOperations;
 
 template<typename Y, typename Cmb, typename Compare=std::less<Y> >
@@ -130,6 +297,34 @@ private:
     return minValue;
   }
 
+  virtual void marginalizeBlockImpl(std::size_t firstOut, std::size_t numOut, const value_type* values,
+      value_type* out, table_type& mrgTable) {
+    const std::size_t numMrg = mrgTable.size();
+    for (std::size_t i = 0; i < numOut; ++i) {
+      value_type minValue = values[i];
+      for (std::size_t m = 1; m < numMrg; ++m) {
+        if (value_compare()(values[m * numOut + i], minValue)) {
+          minValue = values[m * numOut + i];
+        }
+      }
+
+      typename valueindex_vector::iterator svBegin = solveVector_.begin() + (firstOut + i) * outDomSize_;
+      for (std::size_t m = 0; m < numMrg; ++m) {
+        svBegin[m].first = minproblem_type::combineInverse(values[m * numOut + i], minValue);
+        svBegin[m].second = static_cast<DomIndex>(m);
+      }
+      if (numMrg == 2) {
+        if (svBegin[1] < svBegin[0]) {
+          std::swap(svBegin[0], svBegin[1]);
+        }
+      } else {
+        std::sort(svBegin, svBegin + numMrg);
+      }
+
+      out[i] = minValue;
+    }
+  }
+
   virtual void solveImpl(solution_type& solSet) const {
     typedef typename solution_type::solution_type single_solution_type;
     typedef typename solution_type::solution_set solution_set;
@@ -178,6 +373,68 @@ private:
   }
 
 public:
+  typedef FlatMinSolutionSet<value_type, value_compare> flat_solution_type;
+
+  // Does what solve() does, on flat solution sets: out is set to the best
+  // out.maxSolutions() extensions of the solutions of in (sorted, as out is
+  // left) by a value of the out variable.  The same candidates are considered
+  // in the same order as by solve(), but they are kept in a bounded max-heap
+  // of (solution of in, out value) pairs and only the rows of those kept are
+  // written, so nothing is allocated once out has reached its capacity.
+  void solveFlat(const flat_solution_type& in, flat_solution_type& out) const {
+    typedef typename flat_solution_type::Candidate candidate;
+
+    in.checkLayout(out);
+    out.clear();
+    std::vector<candidate>& heap = out.candidates_;
+    heap.clear();
+
+    value_compare valueLess;
+    auto less = [&](const candidate& a, const candidate& b) {
+      return valueLess(a.value, b.value) ||
+          (a.value == b.value && in.rowLess(a.parent, a.x, b.parent, b.x, outVar_));
+    };
+
+    for (std::size_t i = 0; i < in.size(); ++i) {
+      bool added = false;
+      value_type baseValue = in.value(i);
+
+      std::size_t svIndex = 0;
+      for (const auto &vs: inVarsSteps_) {
+        svIndex += in.get(i, vs.first) * vs.second;
+      }
+      svIndex *= outDomSize_;
+      valueindex_iterator svBegin = solveVector_.begin() + svIndex;
+      valueindex_iterator svEnd = svBegin + outDomSize_;
+
+      for (auto it = svBegin; it != svEnd; ++it) {
+        candidate c = {minproblem_type::combine(baseValue, it->first), i, it->second};
+
+        if (heap.size() < out.maxSolutions()) {
+          heap.push_back(c);
+          std::push_heap(heap.begin(), heap.end(), less);
+        } else if (less(c, heap.front())) {
+          std::pop_heap(heap.begin(), heap.end(), less);
+          heap.back() = c;
+          std::push_heap(heap.begin(), heap.end(), less);
+        } else {
+          break;
+        }
+
+        added = true;
+      }
+
+      if (!added) {
+        break;
+      }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), less);
+    for (const auto &c: heap) {
+      out.push_back(c.value, in, c.parent, outVar_, c.x);
+    }
+  }
+
   SolvableMinMarginalizer(
       const VarVector& inScope, const DomIndexVector& inDomSizes,
       Var outVar, DomIndex outDomSize) :
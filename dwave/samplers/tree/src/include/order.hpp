@@ -0,0 +1,56 @@
+// Copyright 2026 D-Wave Systems Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <utility>
+#include <vector>
+
+#include <base.h>
+#include <graph.h>
+#include <varorder.h>
+
+#include <dimod/quadratic_model.h>
+
+using std::vector;
+
+// Computes a min-fill elimination order of the variables of bqm into order and
+// returns its width.  With num_restarts > 1, that many orders are computed
+// with randomized tie-breaking (from seed), on up to num_threads threads, and
+// the one with the lowest complexity is kept.
+template <class V, class B>
+int minFillOrder(dimod::BinaryQuadraticModel<B, V> &bqm,
+                 int num_restarts,
+                 int num_threads,
+                 unsigned seed,
+                 vector<int>& order
+) {
+  int num_vars = bqm.num_variables();
+
+  vector<std::pair<orang::Var, orang::Var> > edges;
+  for (int i = 0; i < num_vars; ++i) {
+    auto span = bqm.neighborhood(i);
+    for (; span.first != span.second; ++span.first) {
+      if (span.first->v > i) {
+        edges.push_back(std::make_pair(i, span.first->v));
+      }
+    }
+  }
+
+  orang::Graph g(edges, num_vars);
+  orang::DomIndexVector domSizes(num_vars, 2);
+  orang::greedyvarorder::VarOrder best = orang::bestFlatVarOrder(
+      g, domSizes, orang::greedyvarorder::MIN_FILL, num_restarts, num_threads, seed);
+
+  order.assign(best.varOrder.begin(), best.varOrder.end());
+  return best.width;
+}
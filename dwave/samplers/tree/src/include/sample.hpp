@@ -14,27 +14,28 @@
 
 #include <algorithm>
 #include <limits>
-#include <map>
 #include <utility>
 #include <vector>
 #include <random>
+#include <string>
 
 #include <cstddef>
-#include <cstdlib>
+#include <cstdint>
 
 #include <base.h>
 #include <table.h>
 #include <task.h>
 #include <treedecomp.h>
 #include <buckettree.h>
+#include <workqueue.h>
 #include <operations/logsumprod.h>
 
 #include "dimod/quadratic_model.h"
+#include "rng.h"
 #include "utils.hpp"
 
 using std::size_t;
 using std::copy;
-using std::map;
 using std::max;
 using std::min;
 using std::numeric_limits;
@@ -51,29 +52,81 @@ using orang::TableMerger;
 
 namespace {
 
+// Uniform doubles in [0, 1) from stream `stream` of `seed`, see StreamRng
 class Rng {
-  std::mt19937 engine_;
-  std::uniform_real_distribution<> distribution_;
+  StreamRng engine_;
 
 public:
-  Rng(std::mt19937& engine) :
-    engine_(engine) {}
+  Rng(std::uint64_t seed, std::uint64_t stream) :
+    engine_(seed, stream) {}
 
   double operator()() {
-    return distribution_(engine_);
+    return engine_.uniform();
   }
 };
 
 typedef orang::Task<orang::LogSumProductOperations<Rng> > SampleTask;
+typedef orang::Task<orang::LogSumProductOperations<Rng, float> > FloatSampleTask;
 typedef std::vector<orang::Table<double>::smartptr> Tables;
 
 typedef pair<Var, Var> VarPair;
 
-struct PairMrgVals {
-  double values[4];
+// The interactions to compute the marginals of, as pairs (u, v) with u < v,
+// sorted, so that the pairs of each u are contiguous:
+// pairs[offsets[u]], ..., pairs[offsets[u + 1] - 1].
+class PairIndex {
+private:
+  vector<VarPair> pairs_;
+  vector<size_t> offsets_;
+
+public:
+  static const size_t npos = static_cast<size_t>(-1);
+
+  PairIndex(vector<VarPair> pairs, size_t num_vars) : pairs_(), offsets_(num_vars + 1, 0) {
+    for (auto &p: pairs) {
+      if (p.first > p.second) std::swap(p.first, p.second);
+      if (p.first == p.second || p.second >= num_vars) {
+        throw std::invalid_argument("marginal pairs must be interactions of the model");
+      }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    pairs_.swap(pairs);
+
+    for (const auto &p: pairs_) {
+      ++offsets_[p.first + 1];
+    }
+    for (size_t u = 0; u < num_vars; ++u) {
+      offsets_[u + 1] += offsets_[u];
+    }
+  }
+
+  size_t size() const { return pairs_.size(); }
+
+  const VarPair& operator[](size_t i) const { return pairs_[i]; }
+
+  // The index of the pair of u and v, or npos if it is not one of them
+  size_t find(Var u, Var v) const {
+    if (u > v) std::swap(u, v);
+    auto first = pairs_.begin() + offsets_[u];
+    auto last = pairs_.begin() + offsets_[u + 1];
+    auto it = std::lower_bound(first, last, VarPair(u, v));
+    return it != last && it->second == v ? static_cast<size_t>(it - pairs_.begin()) : npos;
+  }
 };
 
-typedef map<VarPair, PairMrgVals> PairMrgMap;
+// The pairs of variables of the two-variable tables of task, ie. its
+// interactions of nonzero bias.
+template<class Task>
+vector<VarPair> taskPairs(const Task& task) {
+  vector<VarPair> pairs;
+  for (const auto &t: task.tables()) {
+    if (t->vars().size() == 2) {
+      pairs.push_back(VarPair(t->vars()[0].index, t->vars()[1].index));
+    }
+  }
+  return pairs;
+}
 
 class Normalizer {
 private:
@@ -84,77 +137,139 @@ public:
   double operator()(double x) const { return exp(x - log_pf_); }
 };
 
-unsigned int randomSeed(int seed) {
+std::uint64_t randomSeed(int seed) {
   if (seed >= 0) {
     return seed;
   } else {
-    return static_cast<unsigned>(std::rand());
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32) | device();
   }
 }
 
-vector<double> singleMarginals(const BucketTree<SampleTask>& bucket_tree) {
-  vector<double> mrg(bucket_tree.task().numVars());
+// Computes the marginal of each variable into single_mrg, and the four
+// marginals of each pair of index into pair_mrg, on num_threads threads.  Each
+// pair is an interaction of the task, so it is held by the node of whichever
+// of its variables is eliminated first, with the other among the node's
+// separator variables.  Every node then writes its own variable and pairs
+// only, and the nodes can be worked on in any order.
+template<class Task>
+void nodeMarginals(const BucketTree<Task>& bucket_tree,
+                   const PairIndex& index,
+                   int num_threads,
+                   vector<double>& single_mrg,
+                   vector<double>& pair_mrg
+) {
+  const auto &node_tables = bucket_tree.nodeTables();
+  single_mrg.assign(bucket_tree.task().numVars(), 0.0);
+  pair_mrg.assign(4 * index.size(), 0.0);
+  vector<char> found(index.size(), 0);
 
-  VarVector vars1(1);
-  TableMerger<SampleTask> merge_tables(bucket_tree.task());
-  SampleTask::marginalizer_smartptr marginalizer = bucket_tree.task().marginalizer();
-  for (const auto &nt: bucket_tree.nodeTables()) {
-    vars1[0] = nt.nodeVar;
-    SampleTask::table_smartptr m_table = merge_tables(vars1, nt.tables.begin(),
-        nt.tables.end(), *marginalizer);
+  TableMerger<Task> merge_tables(bucket_tree.task());
+  typename Task::marginalizer_smartptr marginalizer = bucket_tree.task().marginalizer();
 
-    Normalizer normalize((*marginalizer)(0, *m_table));
-    mrg[nt.nodeVar] = normalize((*m_table)[1]);
+  vector<size_t> nodes(node_tables.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i] = i;
   }
 
-  return mrg;
-}
+  orang::internal::runWorkQueue(num_threads, nodes, [&](size_t i, vector<size_t>&) {
+    const auto &nt = node_tables[i];
 
-PairMrgMap pairMarginals(const BucketTree<SampleTask>& bucket_tree) {
-  PairMrgMap mrg;
+    VarVector vars1(1, nt.nodeVar);
+    typename Task::table_smartptr m_table = merge_tables(vars1, nt.tables.begin(),
+        nt.tables.end(), *marginalizer);
+    Normalizer normalize((*marginalizer)(0, *m_table));
+    single_mrg[nt.nodeVar] = normalize((*m_table)[1]);
 
-  for (const auto &t: bucket_tree.task().tables()) {
-    if (t->vars().size() == 2) {
-      VarPair p(t->vars()[0].index, t->vars()[1].index);
-      mrg[p];
+    VarVector vars2(2);
+    for (const auto &v: nt.sepVars) {
+      size_t p = index.find(nt.nodeVar, v);
+      if (p == PairIndex::npos) continue;
+      vars2[0] = index[p].first;
+      vars2[1] = index[p].second;
+      m_table = merge_tables(vars2, nt.tables.begin(), nt.tables.end(), *marginalizer);
+
+      Normalizer normalize((*marginalizer)(0, *m_table));
+      for (int k = 0; k < 4; ++k) {
+        pair_mrg[4 * p + k] = normalize((*m_table)[k]);
+      }
+      found[p] = 1;
     }
+  });
+
+  if (std::find(found.begin(), found.end(), 0) != found.end()) {
+    throw std::invalid_argument("marginal pairs must be interactions of the model of nonzero bias");
   }
+}
 
-  VarVector vars2(2);
-  TableMerger<SampleTask> merge_tables(bucket_tree.task());
-  SampleTask::marginalizer_smartptr marginalizer = bucket_tree.task().marginalizer();
-  for (const auto &nt: bucket_tree.nodeTables()) {
-    for (const auto &v : nt.sepVars) {
-      VarPair p(min(nt.nodeVar, v), max(nt.nodeVar, v));
-      if (mrg.find(p) == mrg.end()) continue;
-      vars2[0] = p.first;
-      vars2[1] = p.second;
-      SampleTask::table_smartptr m_table = merge_tables(vars2, nt.tables.begin(),
-          nt.tables.end(), *marginalizer);
+// Samples are drawn in blocks of this many, each block in one pass over the
+// tree and with its own stream of the sampler's seed.
+const int sampleBlockSize = 1024;
+
+// Draws num_samples samples into out, with the values of each variable mapped
+// to {z, 1}.  The blocks are spread over num_threads threads, but block b
+// always draws from stream b + 1 of seed, so the samples do not depend on
+// num_threads.
+template<class Task>
+void drawSamples(const BucketTree<Task>& bucket_tree,
+                 std::uint64_t seed,
+                 int z,
+                 int num_samples,
+                 int num_threads,
+                 int* out
+) {
+  typedef orang::SolvableLogSumMarginalizer<Rng, typename Task::value_type> marginalizer_type;
 
-      Normalizer normalize((*marginalizer)(0, *m_table));
-      PairMrgVals& mv = mrg[p];
-      mv.values[0] = normalize((*m_table)[0]);
-      mv.values[1] = normalize((*m_table)[1]);
-      mv.values[2] = normalize((*m_table)[2]);
-      mv.values[3] = normalize((*m_table)[3]);
-    }
+  vector<const marginalizer_type*> marginalizers;
+  bucket_tree.visitSolvableMarginalizers([&](const typename Task::solvablemarginalizer_type& m) {
+    marginalizers.push_back(&dynamic_cast<const marginalizer_type&>(m));
+  });
+
+  const size_t num_vars = bucket_tree.task().numVars();
+  const int num_blocks = (num_samples + sampleBlockSize - 1) / sampleBlockSize;
+
+  vector<int> blocks;
+  for (int b = num_blocks - 1; b >= 0; --b) {
+    blocks.push_back(b);
   }
-  return mrg;
+
+  const int s[2] = {z, 1};
+  orang::internal::runWorkQueue(num_threads, blocks, [&](int b, vector<int>&) {
+    Rng rng(seed, static_cast<std::uint64_t>(b) + 1);
+
+    const int first = b * sampleBlockSize;
+    const size_t block_size = min(sampleBlockSize, num_samples - first);
+    DomIndexVector block(block_size * num_vars, 0);
+    for (const auto &m: marginalizers) {
+      m->solveBlock(block_size, block.data(), num_vars, rng);
+    }
+
+    int* block_out = out + first * num_vars;
+    for (size_t i = 0; i < block.size(); ++i) {
+      block_out[i] = s[block[i]];
+    }
+  });
 }
 
-void sample(SampleTask& task,
+template<class Task>
+void sample(Task& task,
             int* var_order,
             int z,
             int num_vars,
             double max_complexity,
+            double max_memory,
             int num_samples,
             bool marginals,
+            const int* marginal_pairs,
+            int num_marginal_pairs,
+            std::uint64_t seed,
+            int num_threads,
             double* log_pf,
             int** samples_data, int* samples_rows, int* samples_cols,
             double** single_mrg_data, int* single_mrg_len,
             double** pair_mrg_data, int* pair_mrg_rows, int* pair_mrg_cols,
-            int** pair_data, int* pair_rows, int* pair_cols
+            int** pair_data, int* pair_rows, int* pair_cols,
+            vector<orang::NodeStats>* node_stats = nullptr
 ) {
   // todo: isn't num_vars and task.numVars the same?
   VarVector var_order_vect = varOrderVec(num_vars, var_order, task.numVars());
@@ -163,9 +278,16 @@ void sample(SampleTask& task,
   if (!(decomp.complexity() <= max_complexity)) throw std::runtime_error("complexity exceeded");
 
   bool solvable = num_samples > 0;
+  if (!(BucketTree<Task>::memoryEstimate(task, decomp, solvable, marginals, num_threads) <= max_memory)) {
+    throw std::runtime_error("memory budget exceeded");
+  }
 
-  BucketTree<SampleTask> bucket_tree(task, decomp, DomIndexVector(task.numVars()), solvable, marginals);
+  BucketTree<Task> bucket_tree(task, decomp, DomIndexVector(task.numVars()), solvable, marginals,
+                               num_threads);
   *log_pf = bucket_tree.problemValue();
+  if (node_stats) {
+    *node_stats = bucket_tree.nodeStats();
+  }
 
   MallocPtr samples_mp;
   MallocPtr single_mrg_mp;
@@ -181,14 +303,7 @@ void sample(SampleTask& task,
     }
     samples_mp.reset(mallocOrThrow(static_cast<size_t>(*samples_rows) * *samples_cols * sizeof(**samples_data)));
 
-    int s[2] = {z, 1};
-    int* samples_mp_data = static_cast<int*>(samples_mp.get());
-    for (int i = 0; i < num_samples; ++i) {
-      DomIndexVector samp = bucket_tree.solve();
-      for (int j = 0; j < num_vars; ++j) {
-        *samples_mp_data++ = s[samp[j]];
-      }
-    }
+    drawSamples(bucket_tree, seed, z, num_samples, num_threads, static_cast<int*>(samples_mp.get()));
 
   } else {
     *samples_rows = 0;
@@ -197,27 +312,36 @@ void sample(SampleTask& task,
   }
 
   if (marginals) {
-    vector<double> single_mrg = singleMarginals(bucket_tree);
+    vector<VarPair> pairs;
+    if (num_marginal_pairs < 0) {
+      pairs = taskPairs(task);
+    } else {
+      for (int i = 0; i < num_marginal_pairs; ++i) {
+        pairs.push_back(VarPair(marginal_pairs[2 * i], marginal_pairs[2 * i + 1]));
+      }
+    }
+    PairIndex index(pairs, task.numVars());
+
+    vector<double> single_mrg;
+    vector<double> pair_mrg;
+    nodeMarginals(bucket_tree, index, num_threads, single_mrg, pair_mrg);
+
     *single_mrg_len = static_cast<int>(single_mrg.size());
     single_mrg_mp.reset(mallocOrThrow(single_mrg.size() * sizeof(**single_mrg_data)));
     copy(single_mrg.begin(), single_mrg.end(), static_cast<double*>(single_mrg_mp.get()));
 
-    PairMrgMap pair_mrg = pairMarginals(bucket_tree);
-    *pair_mrg_rows = static_cast<int>(pair_mrg.size());
+    *pair_mrg_rows = static_cast<int>(index.size());
     *pair_mrg_cols = 4;
-    pair_mrg_mp.reset(mallocOrThrow(pair_mrg.size() * 4 * sizeof(**pair_mrg_data)));
-    *pair_rows = static_cast<int>(pair_mrg.size());
+    pair_mrg_mp.reset(mallocOrThrow(max<size_t>(pair_mrg.size() * sizeof(**pair_mrg_data), 1)));
+    copy(pair_mrg.begin(), pair_mrg.end(), static_cast<double*>(pair_mrg_mp.get()));
+
+    *pair_rows = static_cast<int>(index.size());
     *pair_cols = 2;
-    pair_mp.reset(mallocOrThrow(pair_mrg.size() * 2 * sizeof(**pair_data)));
+    pair_mp.reset(mallocOrThrow(max<size_t>(index.size() * 2 * sizeof(**pair_data), 1)));
     int* pair_mp_data = static_cast<int*>(pair_mp.get());
-    double* pair_mrg_mp_data = static_cast<double*>(pair_mrg_mp.get());
-    for (const auto &e: pair_mrg) {
-      *pair_mp_data++ = static_cast<int>(e.first.first);
-      *pair_mp_data++ = static_cast<int>(e.first.second);
-      *pair_mrg_mp_data++ = e.second.values[0];
-      *pair_mrg_mp_data++ = e.second.values[1];
-      *pair_mrg_mp_data++ = e.second.values[2];
-      *pair_mrg_mp_data++ = e.second.values[3];
+    for (size_t i = 0; i < index.size(); ++i) {
+      *pair_mp_data++ = static_cast<int>(index[i].first);
+      *pair_mp_data++ = static_cast<int>(index[i].second);
     }
 
   } else {
@@ -239,42 +363,112 @@ void sample(SampleTask& task,
   *pair_data = static_cast<int*>(pair_mp.release());
 }
 
-} // namespace {anonymous}
-
-template <class V, class B>
-void sampleBQM(
+template <class Task, class V, class B>
+void sampleBQMAs(
   dimod::BinaryQuadraticModel<B, V> &bqm,
   int* var_order,
   double beta,
   int low,
   double max_complexity,
+  double max_memory,
   int num_samples,
   bool marginals,
+  const int* marginal_pairs,
+  int num_marginal_pairs,
   int seed,
+  int num_threads,
+  const orang::TableStorage& table_storage,
   double* log_pf,
   int** samples_data, int* samples_rows, int* samples_cols,
   double** single_mrg_data, int* single_mrg_len,
   double** pair_mrg_data, int* pair_mrg_rows, int* pair_mrg_cols,
-  int** pair_data, int* pair_rows, int* pair_cols
+  int** pair_data, int* pair_rows, int* pair_cols,
+  vector<orang::NodeStats>* node_stats
 ) {
-    std::mt19937 engine(randomSeed(seed));
-    Rng rng(engine);
+    // the task's own generator is stream 0, the blocks of samples use the
+    // others, see drawSamples
+    const std::uint64_t stream_seed = randomSeed(seed);
+    Rng rng(stream_seed, 0);
 
-    vector<Table<double>::smartptr> tables = getTables(bqm, beta, low);
+    typedef typename Task::value_type value_type;
+    vector<typename Table<value_type>::smartptr> tables = getTables<value_type>(bqm, beta, low);
 
     int num_vars = bqm.num_variables();
-    SampleTask task(tables.begin(), tables.end(), rng, num_vars);
+    Task task(tables.begin(), tables.end(), rng, num_vars);
+    task.tableStorage(table_storage);
 
     sample(task,
            var_order,
            low,   // -1 for SPIN, 0 for BINARY
            num_vars,
            max_complexity,
+           max_memory,
            num_samples,
            marginals,
+           marginal_pairs,
+           num_marginal_pairs,
+           stream_seed,
+           num_threads,
            log_pf,
            samples_data, samples_rows, samples_cols,
            single_mrg_data, single_mrg_len,
            pair_mrg_data, pair_mrg_rows, pair_mrg_cols,
-           pair_data, pair_rows, pair_cols);
+           pair_data, pair_rows, pair_cols,
+           node_stats);
+}
+
+} // namespace {anonymous}
+
+// With single_precision, the tables hold floats rather than doubles, which
+// halves their size.  The log partition function and the marginals are then
+// only accurate to single precision.
+//
+// With num_marginal_pairs >= 0, only the pair marginals of the
+// num_marginal_pairs pairs of variables marginal_pairs[2 * i],
+// marginal_pairs[2 * i + 1] are computed, each of which must be an interaction
+// of nonzero bias.  Otherwise they are computed for all such interactions.
+//
+// The merged tables of at least mmap_threshold bytes are kept in
+// memory-mapped files in mmap_dir rather than on the heap, see
+// orang::TableStorage.
+//
+// If node_stats is given and the DWAVE_SAMPLERS_COUNTERS instrumentation is
+// compiled in, it gets the variable, lambda table size and merge time of each
+// node of the tree, in preorder.
+template <class V, class B>
+void sampleBQM(
+  dimod::BinaryQuadraticModel<B, V> &bqm,
+  int* var_order,
+  double beta,
+  int low,
+  double max_complexity,
+  double max_memory,
+  int num_samples,
+  bool marginals,
+  const int* marginal_pairs,
+  int num_marginal_pairs,
+  int seed,
+  int num_threads,
+  bool single_precision,
+  double mmap_threshold,
+  const std::string& mmap_dir,
+  double* log_pf,
+  int** samples_data, int* samples_rows, int* samples_cols,
+  double** single_mrg_data, int* single_mrg_len,
+  double** pair_mrg_data, int* pair_mrg_rows, int* pair_mrg_cols,
+  int** pair_data, int* pair_rows, int* pair_cols,
+  std::vector<orang::NodeStats>* node_stats = nullptr
+) {
+  const orang::TableStorage table_storage = tableStorage(mmap_threshold, mmap_dir);
+  if (single_precision) {
+    sampleBQMAs<FloatSampleTask>(bqm, var_order, beta, low, max_complexity, max_memory, num_samples,
+        marginals, marginal_pairs, num_marginal_pairs, seed, num_threads, table_storage, log_pf, samples_data, samples_rows, samples_cols,
+        single_mrg_data, single_mrg_len, pair_mrg_data, pair_mrg_rows, pair_mrg_cols,
+        pair_data, pair_rows, pair_cols, node_stats);
+  } else {
+    sampleBQMAs<SampleTask>(bqm, var_order, beta, low, max_complexity, max_memory, num_samples,
+        marginals, marginal_pairs, num_marginal_pairs, seed, num_threads, table_storage, log_pf, samples_data, samples_rows, samples_cols,
+        single_mrg_data, single_mrg_len, pair_mrg_data, pair_mrg_rows, pair_mrg_cols,
+        pair_data, pair_rows, pair_cols, node_stats);
+  }
 }
@@ -14,10 +14,16 @@
 
 #include <new>
 #include <algorithm>
+#include <iterator>
 #include <limits>
+#include <mutex>
+#include <set>
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include <cmath>
 #include <cstddef>
 #include <cstdlib>
 
@@ -27,6 +33,7 @@
 #include <combine.h>
 #include <treedecomp.h>
 #include <buckettree.h>
+#include <workqueue.h>
 #include <operations/min.h>
 
 #include "utils.hpp"
@@ -44,31 +51,353 @@ using orang::MinSolution;
 using orang::MinSolutionSet;
 
 typedef orang::Task<orang::MinOperations<double, orang::Plus<double> > > SolveTask;
+typedef orang::Task<orang::MinOperations<float, orang::Plus<float> > > FloatSolveTask;
 typedef std::vector<orang::Table<double>::smartptr> Tables;
 
 namespace {
 
-void solve(SolveTask& task,
+typedef MinSolution<double> Solution;
+typedef std::set<Solution, orang::MinSolutionCompare<double> > SolutionSet;
+
+// The bound of every assignment of the clamped variables is kept, so their
+// number is limited to this
+const size_t maxClampedAssignments = size_t(1) << 24;
+
+// The largest node of decomp, by the number of entries of its table
+const orang::TreeDecompNode* widestNode(const TreeDecomp& decomp, const DomIndexVector& domSizes) {
+  const orang::TreeDecompNode* widest = 0;
+  double widestSize = 0;
+  vector<const orang::TreeDecompNode*> nodes;
+  for (const auto &r: decomp.roots()) {
+    nodes.push_back(r.get());
+  }
+  while (!nodes.empty()) {
+    const orang::TreeDecompNode* n = nodes.back();
+    nodes.pop_back();
+
+    double size = domSizes[n->nodeVar()];
+    for (auto v: n->sepVars()) {
+      size *= domSizes[v];
+    }
+    if (!widest || size > widestSize) {
+      widest = n;
+      widestSize = size;
+    }
+
+    for (const auto &c: n->children()) {
+      nodes.push_back(c.get());
+    }
+  }
+  return widest;
+}
+
+// Appends the max_solutions best states of bucket_tree (built from x0) to
+// solutions, lowest energy first, with base_value added to their values.  They
+// are those bucket_tree.solve() finds, but the backtracking goes through flat
+// solution sets, whose cost grows linearly with max_solutions.
+template<class Task>
+void solveFlat(const Task& task,
+               const BucketTree<Task>& bucket_tree,
+               const DomIndexVector& x0,
+               size_t max_solutions,
+               double base_value,
+               vector<Solution>& solutions
+) {
+  typedef orang::SolvableMinMarginalizer<typename Task::value_type,
+      orang::Plus<typename Task::value_type> > marginalizer;
+  typedef typename marginalizer::flat_solution_type flat_solution_set;
+
+  orang::DomIndex max_dom_size = 1;
+  for (auto d: task.domSizes()) {
+    max_dom_size = std::max(max_dom_size, d);
+  }
+
+  flat_solution_set in(max_solutions, task.numVars(), max_dom_size);
+  flat_solution_set out(max_solutions, task.numVars(), max_dom_size);
+  in.push_back(task.combineIdentity(), x0);
+
+  bucket_tree.visitSolvableMarginalizers([&](const typename Task::solvablemarginalizer_type& m) {
+    dynamic_cast<const marginalizer&>(m).solveFlat(in, out);
+    in.swap(out);
+  });
+
+  for (size_t i = 0; i < in.size(); ++i) {
+    solutions.push_back(Solution(base_value + in.value(i), in.solution(i)));
+  }
+}
+
+// Removes variables from var_order, which clamps them, until the decomposition
+// of the rest is within max_complexity and the tables of num_threads such
+// decompositions are within max_memory.  Each time, the variable removed is
+// the one of the widest node with the most neighbours left.  Throws if that
+// takes more than max_clamped variables.
+template<class Task>
+VarVector clampedOrder(const Task& task,
+                       VarVector var_order,
+                       double max_complexity,
+                       double max_memory,
+                       bool solvable,
+                       int max_clamped,
+                       int num_threads
+) {
+  const orang::Graph& g = task.graph();
+  vector<char> clamped(task.numVars(), 0);
+
+  for (int num_clamped = 0; ; ++num_clamped) {
+    TreeDecomp decomp(g, var_order, task.domSizes());
+    if (decomp.complexity() <= max_complexity &&
+        num_threads * BucketTree<Task>::memoryEstimate(task, decomp, solvable, false, 1) <= max_memory) {
+      return var_order;
+    }
+    if (num_clamped == max_clamped || var_order.empty()) {
+      throw std::runtime_error("complexity exceeded");
+    }
+
+    const orang::TreeDecompNode* widest = widestNode(decomp, task.domSizes());
+    VarVector clique = widest->sepVars();
+    clique.push_back(widest->nodeVar());
+
+    orang::Var best = clique.front();
+    int bestDegree = -1;
+    for (auto v: clique) {
+      int degree = 0;
+      for (auto it = g.adjacencyBegin(v); it != g.adjacencyEnd(v); ++it) {
+        degree += !clamped[*it];
+      }
+      if (degree > bestDegree || (degree == bestDegree && v < best)) {
+        best = v;
+        bestDegree = degree;
+      }
+    }
+
+    clamped[best] = 1;
+    var_order.erase(std::find(var_order.begin(), var_order.end(), best));
+  }
+}
+
+// A lower bound on the energy of the states that agree with x0 on its clamped
+// variables: the sum over tables of their smallest entry that agrees with x0.
+class ClampBound {
+private:
+  double constant_;
+  vector<std::pair<vector<double>, vector<orang::TableVar> > > tables_;
+  double slack_;
+
+public:
+  template<class Task>
+  ClampBound(const Task& task, const VarVector& clampedVars) : constant_(0), tables_(), slack_(0) {
+    double scale = 0;
+    for (const auto &t: task.tables()) {
+      vector<orang::TableVar> vars;
+      for (const auto &tv: t->vars()) {
+        if (std::binary_search(clampedVars.begin(), clampedVars.end(), tv.index)) {
+          vars.push_back(tv);
+        }
+      }
+
+      double tableMax = 0;
+      for (const auto &y: *t) {
+        tableMax = std::max(tableMax, std::fabs(static_cast<double>(y)));
+      }
+      scale += tableMax;
+
+      if (vars.empty()) {
+        constant_ += *std::min_element(t->begin(), t->end());
+      } else {
+        tables_.push_back(std::make_pair(vector<double>(t->begin(), t->end()), vars));
+      }
+    }
+
+    // the tree and the bound sum the tables in different orders and
+    // precisions, so they may disagree by this much
+    slack_ = 64 * numeric_limits<typename Task::value_type>::epsilon() * scale;
+  }
+
+  double operator()(const DomIndexVector& x0) const {
+    double bound = constant_;
+    for (const auto &t: tables_) {
+      double tableMin = numeric_limits<double>::infinity();
+      for (size_t i = 0; i < t.first.size(); ++i) {
+        bool agrees = true;
+        for (const auto &tv: t.second) {
+          agrees = agrees && (i / tv.stepSize) % tv.domSize == x0[tv.index];
+        }
+        if (agrees) {
+          tableMin = std::min(tableMin, t.first[i]);
+        }
+      }
+      bound += tableMin;
+    }
+    return bound;
+  }
+
+  // Whether the states bounded by bound are all worse than threshold
+  bool prunes(double bound, double threshold) const {
+    return bound > threshold + slack_;
+  }
+};
+
+// Solves every assignment of the clamped variables of decomp, on num_threads
+// threads, keeping the max_solutions lowest energy states overall (or, if
+// max_solutions is 0, the lowest energy only, in ground_energy).  Assignments
+// are solved in order of their ClampBound, and those whose bound is above the
+// worst of max_solutions states found so far are skipped.  Every state skipped
+// is worse than all those kept, so the result does not depend on num_threads.
+// If node_stats is given, it gets the stats of the nodes of the trees solved,
+// with their merge times summed over the assignments.
+template<class Task>
+void solveClamped(const Task& task,
+                  const TreeDecomp& decomp,
+                  int max_solutions,
+                  int num_threads,
+                  SolutionSet& solutions,
+                  double& ground_energy,
+                  vector<orang::NodeStats>* node_stats = nullptr
+) {
+  const VarVector& clamped_vars = decomp.clampedVars();
+
+  size_t num_leaves = 1;
+  for (auto v: clamped_vars) {
+    if (num_leaves > maxClampedAssignments / task.domSize(v)) {
+      throw std::runtime_error("too many clamped assignments");
+    }
+    num_leaves *= task.domSize(v);
+  }
+
+  // leaf i clamps clamped_vars[j] to the j-th digit of i, in the mixed radix
+  // of their domain sizes
+  auto leafState = [&](size_t leaf) {
+    DomIndexVector x0(task.numVars(), 0);
+    for (auto v: clamped_vars) {
+      x0[v] = static_cast<orang::DomIndex>(leaf % task.domSize(v));
+      leaf /= task.domSize(v);
+    }
+    return x0;
+  };
+
+  ClampBound bound(task, clamped_vars);
+  vector<double> bounds(num_leaves);
+  for (size_t i = 0; i < num_leaves; ++i) {
+    bounds[i] = bound(leafState(i));
+  }
+
+  // the work queue runs the last ready item first
+  vector<size_t> leaves(num_leaves);
+  for (size_t i = 0; i < num_leaves; ++i) {
+    leaves[i] = i;
+  }
+  std::stable_sort(leaves.begin(), leaves.end(),
+      [&](size_t a, size_t b) { return bounds[a] > bounds[b]; });
+
+  bool solvable = max_solutions > 0;
+  std::mutex lock;
+  ground_energy = numeric_limits<double>::infinity();
+
+  orang::internal::runWorkQueue(num_threads, leaves, [&](size_t leaf, vector<size_t>&) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      double threshold = ground_energy;
+      if (solvable) {
+        threshold = solutions.size() < static_cast<size_t>(max_solutions) ?
+            numeric_limits<double>::infinity() : solutions.rbegin()->value;
+      }
+      if (bound.prunes(bounds[leaf], threshold)) {
+        return;
+      }
+    }
+
+    DomIndexVector x0 = leafState(leaf);
+    BucketTree<Task> bucket_tree(task, decomp, x0, solvable, false, 1);
+    double base_value = bucket_tree.problemValue();
+
+    if (node_stats && !bucket_tree.nodeStats().empty()) {
+      std::lock_guard<std::mutex> guard(lock);
+      if (node_stats->empty()) {
+        *node_stats = bucket_tree.nodeStats();
+      } else {
+        for (size_t i = 0; i < node_stats->size(); ++i) {
+          (*node_stats)[i].mergeSeconds += bucket_tree.nodeStats()[i].mergeSeconds;
+        }
+      }
+    }
+
+    if (solvable) {
+      vector<Solution> leaf_solutions;
+      solveFlat(task, bucket_tree, x0, max_solutions, base_value, leaf_solutions);
+
+      std::lock_guard<std::mutex> guard(lock);
+      for (const auto &sol: leaf_solutions) {
+        solutions.insert(sol);
+        if (solutions.size() > static_cast<size_t>(max_solutions)) {
+          solutions.erase(std::prev(solutions.end()));
+        }
+      }
+    } else {
+      std::lock_guard<std::mutex> guard(lock);
+      ground_energy = std::min(ground_energy, base_value);
+    }
+  });
+}
+
+// Solves task along var_order.  If the decomposition is over max_complexity
+// or its tables over max_memory, up to max_clamped variables are clamped to
+// bring it within both, and all of their assignments are solved, see
+// solveClamped.  If node_stats is given, it gets the stats of the nodes of the
+// tree, see BucketTree::nodeStats.
+template<class Task>
+void solve(Task& task,
            int* var_order,
            int num_vars,
            double max_complexity,
+           double max_memory,
+           int max_clamped,
            int max_solutions,
            int z,
+           int num_threads,
            double** energies_data, int* energies_len,
-           int** sols_data, int* sols_rows, int* sols_cols
+           int** sols_data, int* sols_rows, int* sols_cols,
+           vector<orang::NodeStats>* node_stats = nullptr
 ) {
   VarVector var_order_vect = varOrderVec(num_vars, var_order, task.numVars());
   TreeDecomp decomp(task.graph(), var_order_vect, task.domSizes());
-  if (!(decomp.complexity() <= max_complexity)) throw std::runtime_error("complexity exceeded");
-
   bool solvable = max_solutions > 0;
-  BucketTree<SolveTask> bucket_tree(task, decomp, DomIndexVector(task.numVars()), solvable, false);
-  double base_value = bucket_tree.problemValue();
-
   if (solvable) {
     task.maxSolutions(max_solutions);
-    MinSolutionSet<double> solution_set = bucket_tree.solve();
-    int num_solutions = static_cast<int>(solution_set.solutions().size());
+  }
+
+  // the energies and states found, lowest energy first
+  vector<Solution> solutions;
+  double base_value;
+
+  if (decomp.complexity() <= max_complexity &&
+      BucketTree<Task>::memoryEstimate(task, decomp, solvable, false, num_threads) <= max_memory) {
+    DomIndexVector x0(task.numVars());
+    BucketTree<Task> bucket_tree(task, decomp, x0, solvable, false, num_threads);
+    base_value = bucket_tree.problemValue();
+    if (node_stats) {
+      *node_stats = bucket_tree.nodeStats();
+    }
+
+    if (solvable) {
+      solveFlat(task, bucket_tree, x0, max_solutions, base_value, solutions);
+    }
+  } else if (max_clamped > 0) {
+    VarVector unclamped_order = clampedOrder(task, var_order_vect, max_complexity, max_memory,
+                                             solvable, max_clamped, num_threads);
+    TreeDecomp clamped_decomp(task.graph(), unclamped_order, task.domSizes());
+
+    SolutionSet solution_set;
+    solveClamped(task, clamped_decomp, max_solutions, num_threads, solution_set, base_value,
+                 node_stats);
+    solutions.assign(solution_set.begin(), solution_set.end());
+  } else if (!(decomp.complexity() <= max_complexity)) {
+    throw std::runtime_error("complexity exceeded");
+  } else {
+    throw std::runtime_error("memory budget exceeded");
+  }
+
+  if (solvable) {
+    int num_solutions = static_cast<int>(solutions.size());
 
     // todo: isn't num_vars and task.numVars the same?
     num_vars = static_cast<int>(task.numVars());
@@ -89,13 +418,11 @@ void solve(SolveTask& task,
 
     int s[2] = {z, 1};
 
-    MinSolutionSet<double>::solution_set::const_iterator sols_iter = solution_set.solutions().begin();
     for (int i = 0; i < num_solutions; ++i) {
-      (*energies_data)[i] = base_value + sols_iter->value;
+      (*energies_data)[i] = solutions[i].value;
       for (int j = 0; j < num_vars; ++j) {
-        (*sols_data)[i * num_vars + j] = s[sols_iter->solution[j]];
+        (*sols_data)[i * num_vars + j] = s[solutions[i].solution[j]];
       }
-      ++sols_iter;
     }
   } else {
     *sols_rows = 0;
@@ -111,32 +438,86 @@ void solve(SolveTask& task,
   }
 }
 
-} // namespace {anonymous}
-
-template <class V, class B>
-void solveBQM(dimod::BinaryQuadraticModel<B, V> &bqm,
-              int* var_order,
-              double beta,
-              int low,
-              double max_complexity,
-              int max_solutions,
-              double** energies_data, int* energies_len,
-              int** sols_data, int* sols_rows, int* sols_cols
+template <class Task, class V, class B>
+void solveBQMAs(dimod::BinaryQuadraticModel<B, V> &bqm,
+                int* var_order,
+                double beta,
+                int low,
+                double max_complexity,
+                double max_memory,
+                int max_clamped,
+                int max_solutions,
+                int num_threads,
+                const orang::TableStorage& table_storage,
+                double** energies_data, int* energies_len,
+                int** sols_data, int* sols_rows, int* sols_cols,
+                vector<orang::NodeStats>* node_stats
 ) {
-  vector<Table<double>::smartptr> tables = getTables(bqm, beta, low);
+  typedef typename Task::value_type value_type;
+  vector<typename Table<value_type>::smartptr> tables = getTables<value_type>(bqm, beta, low);
 
   int num_vars = bqm.num_variables();
-  SolveTask task(tables.begin(), tables.end(), 1, num_vars);
+  Task task(tables.begin(), tables.end(), 1, num_vars);
+  task.tableStorage(table_storage);
 
   solve(task,
         var_order,
         num_vars,
         max_complexity,
+        max_memory,
+        max_clamped,
         max_solutions,
         0,
+        num_threads,
         energies_data,
         energies_len,
         sols_data,
         sols_rows,
-        sols_cols);
+        sols_cols,
+        node_stats);
+}
+
+} // namespace {anonymous}
+
+// With single_precision, the tables hold floats rather than doubles, which
+// halves their size.  The energies are then only accurate to single precision.
+//
+// With max_clamped > 0, a var_order over max_complexity or max_memory is not
+// an error: up to max_clamped variables are clamped instead, and all of their
+// assignments are solved, skipping those that bound above the states found.
+//
+// The merged tables of at least mmap_threshold bytes are kept in
+// memory-mapped files in mmap_dir rather than on the heap, see
+// orang::TableStorage.
+//
+// If node_stats is given and the DWAVE_SAMPLERS_COUNTERS instrumentation is
+// compiled in, it gets the variable, lambda table size and merge time of each
+// node of the tree, in preorder.
+template <class V, class B>
+void solveBQM(dimod::BinaryQuadraticModel<B, V> &bqm,
+              int* var_order,
+              double beta,
+              int low,
+              double max_complexity,
+              double max_memory,
+              int max_clamped,
+              int max_solutions,
+              int num_threads,
+              bool single_precision,
+              double mmap_threshold,
+              const std::string& mmap_dir,
+              double** energies_data, int* energies_len,
+              int** sols_data, int* sols_rows, int* sols_cols,
+              std::vector<orang::NodeStats>* node_stats = nullptr
+) {
+  const orang::TableStorage table_storage = tableStorage(mmap_threshold, mmap_dir);
+  if (single_precision) {
+    solveBQMAs<FloatSolveTask>(bqm, var_order, beta, low, max_complexity, max_memory, max_clamped, max_solutions,
+                               num_threads, table_storage, energies_data, energies_len, sols_data, sols_rows,
+                               sols_cols, node_stats);
+  } else {
+    solveBQMAs<SolveTask>(bqm, var_order, beta, low, max_complexity, max_memory, max_clamped, max_solutions,
+                          num_threads, table_storage, energies_data, energies_len, sols_data, sols_rows,
+                          sols_cols, node_stats);
+  }
 }
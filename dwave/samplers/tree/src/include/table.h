@@ -29,6 +29,7 @@
 
 #include <exception.h>
 #include <base.h>
+#include <tablestorage.h>
 
 namespace orang {
 
@@ -59,15 +60,15 @@ template<typename Y>
 class Table {
 public:
   typedef Y value_type;
-  typedef typename std::vector<Y>::iterator iterator;
-  typedef typename std::vector<Y>::const_iterator const_iterator;
+  typedef Y* iterator;
+  typedef const Y* const_iterator;
 
   typedef std::shared_ptr<Table> smartptr;
   typedef std::shared_ptr<const Table> const_smartptr;
 
 private:
   std::vector<TableVar> vars_;
-  std::vector<value_type> values_;
+  TableValues<value_type> values_;
 
 public:
 
@@ -77,9 +78,11 @@ public:
   //
   //===========================================================================================================
 
-  Table() : vars_(), values_(1) {}
+  Table() : vars_(), values_(1, value_type()) {}
 
-  Table(const VarVector& scope, const DomIndexVector& domSizes, const value_type& initVal = value_type()) :
+  // The values are kept as storage asks for, see TableStorage.
+  Table(const VarVector& scope, const DomIndexVector& domSizes, const value_type& initVal = value_type(),
+      const TableStorage& storage = TableStorage()) :
     vars_(),
     values_() {
 
@@ -109,7 +112,7 @@ public:
       throw LengthException();
     }
 
-    values_.assign(coeffProd, initVal);
+    values_ = TableValues<value_type>(coeffProd, initVal, storage);
   }
 
   template<typename Z>
@@ -119,8 +122,7 @@ public:
   template<typename Z>
   Table& operator=(const Table<Z>& other) {
     vars_ = other.vars();
-    values_.reserve(other.size());
-    values_.assign(other.begin(), other.end());
+    values_ = TableValues<value_type>(other.begin(), other.end());
     return *this;
   }
 
@@ -130,7 +132,7 @@ public:
   //
   //===========================================================================================================
   bool operator==(const Table& other) const {
-    return vars_ == other.vars_ && values_ == other.values_;
+    return vars_ == other.vars_ && size() == other.size() && std::equal(begin(), end(), other.begin());
   }
 
   bool operator!=(const Table& other) const {
@@ -138,7 +140,8 @@ public:
   }
 
   bool operator<(const Table& other) const {
-    return vars_ == other.vars_ ? values_ < other.values_ : vars_ < other.vars_;
+    return vars_ == other.vars_ ?
+        std::lexicographical_compare(begin(), end(), other.begin(), other.end()) : vars_ < other.vars_;
   }
 
   const std::vector<TableVar>& vars() const {
@@ -194,6 +197,22 @@ public:
   std::size_t size() const {
     return values_.size();
   }
+
+  //===========================================================================================================
+  //
+  //  Storage
+  //
+  //===========================================================================================================
+
+  // Whether the values are in a memory-mapped file, see TableStorage.
+  bool mapped() const {
+    return values_.mapped();
+  }
+
+  // See TableValues::adviseSequential.
+  void adviseSequential(bool sequential) const {
+    values_.adviseSequential(sequential);
+  }
 };
 
 } // namespace orang
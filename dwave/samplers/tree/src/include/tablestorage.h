@@ -0,0 +1,289 @@
+/**
+# Copyright 2026 D-Wave Systems Inc.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+# =============================================================================
+*/
+#ifndef INCLUDED_ORANG_TABLESTORAGE_H
+#define INCLUDED_ORANG_TABLESTORAGE_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ORANG_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace orang {
+
+// Where the values of a table are kept.  By default they are on the heap.
+// The values of tables of at least mapThreshold bytes are instead placed in a
+// memory-mapped temporary file in directory (TMPDIR, or /tmp, if empty).  The
+// file is unlinked as soon as it is created and only lives as long as its
+// table, and the kernel writes its pages back to it rather than to swap, so
+// the tables are bounded by disk rather than by RAM.  The merges of binary
+// tables in TableMerger sweep their input and output tables in the order of
+// their indices, so the mapped tables are streamed rather than paged in at
+// random.
+//
+// Memory mapping needs a POSIX system; elsewhere every table is on the heap.
+// Only tables of trivially copyable values are mapped.
+struct TableStorage {
+  std::size_t mapThreshold;
+  std::string directory;
+
+  TableStorage(
+      std::size_t mapThreshold0 = std::numeric_limits<std::size_t>::max(),
+      const std::string& directory0 = std::string()) :
+        mapThreshold(mapThreshold0), directory(directory0) {}
+};
+
+namespace internal {
+
+#ifdef ORANG_HAVE_MMAP
+
+// Maps a new temporary file of the given size, see TableStorage.
+inline void* mapTableFile(std::size_t bytes, const std::string& directory) {
+  std::string dir = directory;
+  if (dir.empty()) {
+    const char* tmpdir = std::getenv("TMPDIR");
+    dir = tmpdir && *tmpdir ? tmpdir : "/tmp";
+  }
+
+  std::string path = dir + "/orang-table-XXXXXX";
+  std::vector<char> name(path.begin(), path.end());
+  name.push_back('\0');
+
+  int fd = mkstemp(name.data());
+  if (fd == -1) {
+    throw std::runtime_error("cannot create a table file in " + dir + ": " + std::strerror(errno));
+  }
+  unlink(name.data());
+
+  // reserve the disk space up front where we can, so that running out of it
+  // is an error here rather than a SIGBUS while the table is written
+#ifdef __linux__
+  int err = posix_fallocate(fd, 0, bytes);
+#else
+  int err = ftruncate(fd, bytes) == 0 ? 0 : errno;
+#endif
+  if (err != 0) {
+    close(fd);
+    throw std::runtime_error("cannot allocate a table file in " + dir + ": " + std::strerror(err));
+  }
+
+  void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  err = errno;
+  close(fd);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error(std::string("cannot map a table file: ") + std::strerror(err));
+  }
+  return data;
+}
+
+#endif
+
+} // namespace internal
+
+// The values of a table, in one contiguous array which is either on the heap
+// or memory-mapped, see TableStorage.
+template<typename Y>
+class TableValues {
+public:
+  typedef Y value_type;
+
+private:
+  static const bool mappable = std::is_trivially_copyable<Y>::value && std::is_trivially_destructible<Y>::value;
+
+  Y* data_;
+  std::size_t size_;
+  std::size_t mappedBytes_; // 0 if the values are on the heap
+  TableStorage storage_;
+
+  void allocate(std::size_t n) {
+    const std::size_t bytes = n * sizeof(Y);
+#ifdef ORANG_HAVE_MMAP
+    if (mappable && bytes > 0 && bytes >= storage_.mapThreshold) {
+      data_ = static_cast<Y*>(internal::mapTableFile(bytes, storage_.directory));
+      mappedBytes_ = bytes;
+      size_ = n;
+      return;
+    }
+#endif
+    data_ = static_cast<Y*>(::operator new(bytes));
+    mappedBytes_ = 0;
+    size_ = n;
+  }
+
+  void release() {
+    if (!data_) {
+      return;
+    }
+    for (std::size_t i = 0; i < size_; ++i) {
+      data_[i].~Y();
+    }
+#ifdef ORANG_HAVE_MMAP
+    if (mappedBytes_) {
+      munmap(data_, mappedBytes_);
+      data_ = nullptr;
+      return;
+    }
+#endif
+    ::operator delete(data_);
+    data_ = nullptr;
+  }
+
+  template<typename Iter>
+  void construct(Iter first, Iter last) {
+    allocate(std::distance(first, last));
+    try {
+      std::uninitialized_copy(first, last, data_);
+    } catch (...) {
+      size_ = 0;
+      release();
+      throw;
+    }
+  }
+
+public:
+  TableValues() : data_(nullptr), size_(0), mappedBytes_(0), storage_() {}
+
+  TableValues(std::size_t n, const Y& value, const TableStorage& storage = TableStorage()) :
+    data_(nullptr), size_(0), mappedBytes_(0), storage_(storage) {
+    allocate(n);
+
+    // a new file is all zeros already, so it need not be written through
+    if (mapped()) {
+      const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+      bool zero = true;
+      for (std::size_t i = 0; i < sizeof(Y); ++i) {
+        zero = zero && bytes[i] == 0;
+      }
+      if (zero) {
+        return;
+      }
+    }
+
+    try {
+      std::uninitialized_fill(data_, data_ + n, value);
+    } catch (...) {
+      size_ = 0;
+      release();
+      throw;
+    }
+  }
+
+  template<typename Iter, typename = typename std::enable_if<!std::is_integral<Iter>::value>::type>
+  TableValues(Iter first, Iter last, const TableStorage& storage = TableStorage()) :
+    data_(nullptr), size_(0), mappedBytes_(0), storage_(storage) {
+    construct(first, last);
+  }
+
+  // copies are kept the way their source is
+  TableValues(const TableValues& other) :
+    data_(nullptr), size_(0), mappedBytes_(0), storage_(other.storage_) {
+    construct(other.begin(), other.end());
+  }
+
+  TableValues(TableValues&& other) noexcept :
+    data_(other.data_), size_(other.size_), mappedBytes_(other.mappedBytes_),
+    storage_(std::move(other.storage_)) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mappedBytes_ = 0;
+  }
+
+  TableValues& operator=(TableValues other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(mappedBytes_, other.mappedBytes_);
+    std::swap(storage_, other.storage_);
+    return *this;
+  }
+
+  ~TableValues() {
+    release();
+  }
+
+  Y* begin() { return data_; }
+  const Y* begin() const { return data_; }
+  Y* end() { return data_ + size_; }
+  const Y* end() const { return data_ + size_; }
+
+  Y& operator[](std::size_t n) { return data_[n]; }
+  const Y& operator[](std::size_t n) const { return data_[n]; }
+
+  std::size_t size() const { return size_; }
+
+  static std::size_t max_size() { return std::numeric_limits<std::size_t>::max() / sizeof(Y); }
+
+  // Whether the values are in a memory-mapped file.
+  bool mapped() const { return mappedBytes_ != 0; }
+
+  // Tells the kernel whether the values are about to be swept in order, so
+  // that it reads mapped pages ahead and drops them once they are passed.
+  // Does nothing for values on the heap.
+  void adviseSequential(bool sequential) const {
+#ifdef ORANG_HAVE_MMAP
+    if (mappedBytes_) {
+      madvise(static_cast<void*>(data_), mappedBytes_, sequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+    }
+#else
+    static_cast<void>(sequential);
+#endif
+  }
+};
+
+// Marks a range of tables for a sweep in index order while it is in scope,
+// see TableValues::adviseSequential.
+template<typename TblIter>
+class SequentialSweep {
+private:
+  TblIter begin_;
+  TblIter end_;
+
+public:
+  SequentialSweep(TblIter begin, TblIter end) : begin_(begin), end_(end) {
+    for (auto it = begin_; it != end_; ++it) {
+      (*it)->adviseSequential(true);
+    }
+  }
+
+  ~SequentialSweep() {
+    for (auto it = begin_; it != end_; ++it) {
+      (*it)->adviseSequential(false);
+    }
+  }
+
+  SequentialSweep(const SequentialSweep&) = delete;
+  SequentialSweep& operator=(const SequentialSweep&) = delete;
+};
+
+} // namespace orang
+
+#endif
@@ -26,6 +26,7 @@
 
 #include <base.h>
 #include <graph.h>
+#include <table.h>
 #include <treedecomp.h>
 #include <marginalizer.h>
 
@@ -35,14 +36,19 @@ class TaskBase {
 protected:
   DomIndexVector domSizes_;
   Graph graph_;
+  TableStorage tableStorage_;
 
-  TaskBase() : domSizes_(), graph_() {}
+  TaskBase() : domSizes_(), graph_(), tableStorage_() {}
 
 public:
   const DomIndexVector& domSizes() const { return domSizes_; }
   DomIndex domSize(Var v) const { return domSizes_[v]; }
   Var numVars() const { return static_cast<Var>(domSizes_.size()); }
   const Graph& graph() const { return graph_; }
+
+  // Where the tables merged for the task are kept, see TableStorage.
+  const TableStorage& tableStorage() const { return tableStorage_; }
+  void tableStorage(const TableStorage& storage) { tableStorage_ = storage; }
 };
 
 template<typename Ops>
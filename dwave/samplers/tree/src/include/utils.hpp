@@ -14,6 +14,9 @@
 
 #include <vector>
 #include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
 
 #include "dimod/quadratic_model.h"
 
@@ -52,6 +55,17 @@ inline void* mallocOrThrow(std::size_t sz) {
   return p;
 }
 
+// The storage of the merged tables: those of at least mmap_threshold bytes
+// are memory-mapped in mmap_dir, see orang::TableStorage.  An infinite
+// threshold keeps every table on the heap.
+inline orang::TableStorage tableStorage(double mmap_threshold, const std::string& mmap_dir) {
+  if (!(mmap_threshold >= 0)) throw std::invalid_argument("mmap_threshold must be non-negative");
+  const double never = static_cast<double>(std::numeric_limits<std::size_t>::max());
+  return orang::TableStorage(
+      mmap_threshold < never ? static_cast<std::size_t>(mmap_threshold) : std::numeric_limits<std::size_t>::max(),
+      mmap_dir);
+}
+
 VarVector varOrderVec(int voLen, const int* voData, int numVars) {
   if (voLen < 0) throw std::invalid_argument("negative voLen");
 
@@ -69,8 +83,8 @@ VarVector varOrderVec(int voLen, const int* voData, int numVars) {
   return varOrder;
 }
 
-template <class V, class B>
-vector<Table<double>::smartptr> getTables(
+template <class Y = double, class V, class B>
+vector<typename Table<Y>::smartptr> getTables(
   dimod::BinaryQuadraticModel<B, V> &bqm,
   double beta,
   int low
@@ -80,7 +94,7 @@ vector<Table<double>::smartptr> getTables(
 
     VarVector vars1(1);
     VarVector vars2(2);
-    vector<Table<double>::smartptr> tables;
+    vector<typename Table<Y>::smartptr> tables;
 
     auto num_vars = bqm.num_variables();
 
@@ -88,7 +102,7 @@ vector<Table<double>::smartptr> getTables(
         auto var = i;
         if (bqm.linear(var) != 0.0) {
             vars1[0] = var;
-            Table<double>::smartptr t(new Table<double>(vars1, ds1));
+            typename Table<Y>::smartptr t(new Table<Y>(vars1, ds1));
             (*t)[0] = -beta * bqm.linear(var) * low;
             (*t)[1] = -beta * bqm.linear(var);
             tables.push_back(t);
@@ -105,7 +119,7 @@ vector<Table<double>::smartptr> getTables(
             if (neighbor > var && bias != 0.0) {
               vars2[0] = var;
               vars2[1] = neighbor;
-              Table<double>::smartptr t(new Table<double>(vars2, ds2));
+              typename Table<Y>::smartptr t(new Table<Y>(vars2, ds2));
 
               (*t)[0] = -beta * bias * low * low;
               (*t)[1] = -beta * bias * low;
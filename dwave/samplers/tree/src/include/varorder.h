@@ -27,12 +27,14 @@
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <random>
 #include <cassert>
 
 #include <base.h>
 #include <exception.h>
 #include <graph.h>
 #include <task.h>
+#include <workqueue.h>
 
 namespace orang {
 
@@ -594,6 +596,308 @@ VarVector greedyVarOrder(
   return varOrder;
 }
 
+
+
+//===================================================================================================================
+//
+//   F L A T   M I N - D E G R E E   A N D   M I N - F I L L
+//
+//===================================================================================================================
+
+namespace greedyvarorder {
+
+// An elimination order together with the width and complexity of the tree
+// decomposition it gives (as computed by TreeDecomp).
+struct VarOrder {
+  VarVector varOrder;
+  std::size_t width;
+  double complexity;
+};
+
+namespace internal {
+
+/*
+ * Min-priority queue of vertices keyed by integer costs.  Costs below the
+ * number of buckets are kept in one bucket each, larger ones (rare, for
+ * min-fill) in an ordered set.  Entries are never updated in place: pushing a
+ * vertex again with its new cost leaves the old entry stale, and pop() skips
+ * the stale entries that isCurrent rejects.
+ */
+class CostQueue {
+private:
+  std::vector<VarVector> buckets_;
+  std::set<std::pair<std::size_t, Var> > large_;
+  std::size_t minBucket_;
+
+public:
+  explicit CostQueue(std::size_t numBuckets) : buckets_(numBuckets), large_(), minBucket_(numBuckets) {}
+
+  void push(Var v, std::size_t cost) {
+    if (cost < buckets_.size()) {
+      buckets_[cost].push_back(v);
+      minBucket_ = std::min(minBucket_, cost);
+    } else {
+      large_.insert(std::make_pair(cost, v));
+    }
+  }
+
+  template<typename IsCurrent>
+  bool pop(Var& v, const IsCurrent& isCurrent) {
+    for (; minBucket_ < buckets_.size(); ++minBucket_) {
+      VarVector& bucket = buckets_[minBucket_];
+      while (!bucket.empty()) {
+        v = bucket.back();
+        bucket.pop_back();
+        if (isCurrent(v, minBucket_)) {
+          return true;
+        }
+      }
+    }
+    while (!large_.empty()) {
+      std::pair<std::size_t, Var> entry = *large_.begin();
+      large_.erase(large_.begin());
+      if (isCurrent(entry.second, entry.first)) {
+        v = entry.second;
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+/*
+ * Greedy elimination on flat arrays.  Each vertex keeps a sorted vector of
+ * its neighbours that are not yet eliminated, grown in place with fill-in.
+ * Neighbourhoods are compared through an array of stamps, which stands in for
+ * a bitset of the current neighbourhood without clearing it between uses.
+ */
+class FlatEliminator {
+private:
+  const bool minFill_;
+  std::vector<VarVector> adj_;
+  std::vector<std::size_t> cost_;
+  std::vector<char> eliminated_;
+  std::vector<std::size_t> stamps_;
+  std::size_t stamp_;
+  VarVector merged_;
+
+  std::size_t nextStamp() {
+    return ++stamp_;
+  }
+
+  // number of pairs of neighbours of v that are not adjacent to each other
+  std::size_t fill(Var v) {
+    const VarVector& nv = adj_[v];
+    std::size_t s = nextStamp();
+    for (auto u: nv) {
+      stamps_[u] = s;
+    }
+    std::size_t links = 0;
+    for (auto u: nv) {
+      for (auto w: adj_[u]) {
+        links += stamps_[w] == s;
+      }
+    }
+    return nv.size() * (nv.size() - 1) / 2 - links / 2;
+  }
+
+  std::size_t computeCost(Var v) {
+    return minFill_ ? fill(v) : adj_[v].size();
+  }
+
+public:
+  // vertex v of g is labelled labels[v]
+  FlatEliminator(const Graph& g, const VarVector& labels, bool minFill) :
+    minFill_(minFill),
+    adj_(g.numVertices()),
+    cost_(g.numVertices()),
+    eliminated_(g.numVertices(), 0),
+    stamps_(g.numVertices(), 0),
+    stamp_(0),
+    merged_() {
+
+    for (Var v = 0; v < g.numVertices(); ++v) {
+      VarVector& nv = adj_[labels[v]];
+      for (auto it = g.adjacencyBegin(v); it != g.adjacencyEnd(v); ++it) {
+        nv.push_back(labels[*it]);
+      }
+      std::sort(nv.begin(), nv.end());
+    }
+  }
+
+  // Eliminates every vertex, appending their labels to varOrder in order, and
+  // calls visit with each and its neighbourhood when eliminated.
+  template<typename Visit>
+  void run(VarVector& varOrder, Visit visit) {
+    const Var numVars = static_cast<Var>(adj_.size());
+    CostQueue queue(numVars + 1);
+    for (Var v = numVars; v-- > 0; ) {
+      cost_[v] = computeCost(v);
+      queue.push(v, cost_[v]);
+    }
+
+    auto isCurrent = [&](Var v, std::size_t c) { return !eliminated_[v] && cost_[v] == c; };
+    VarVector affected;
+    Var v;
+    while (queue.pop(v, isCurrent)) {
+      varOrder.push_back(v);
+      eliminated_[v] = 1;
+      const VarVector nv = std::move(adj_[v]);
+      adj_[v].clear();
+      visit(v, nv);
+
+      // the neighbourhood of v becomes a clique
+      for (auto u: nv) {
+        VarVector& nu = adj_[u];
+        merged_.clear();
+        std::set_union(nu.begin(), nu.end(), nv.begin(), nv.end(), std::back_inserter(merged_));
+        nu.clear();
+        for (auto w: merged_) {
+          if (w != u && w != v) {
+            nu.push_back(w);
+          }
+        }
+      }
+
+      // costs that may have changed: those of the neighbours of v, and for
+      // min-fill those of their neighbours too
+      std::size_t s = nextStamp();
+      affected.clear();
+      for (auto u: nv) {
+        stamps_[u] = s;
+        affected.push_back(u);
+      }
+      if (minFill_) {
+        for (auto u: nv) {
+          for (auto w: adj_[u]) {
+            if (stamps_[w] != s) {
+              stamps_[w] = s;
+              affected.push_back(w);
+            }
+          }
+        }
+      }
+      for (auto u: affected) {
+        std::size_t c = computeCost(u);
+        if (c != cost_[u]) {
+          cost_[u] = c;
+          queue.push(u, c);
+        }
+      }
+    }
+  }
+};
+
+} // namespace orang::greedyvarorder::internal
+} // namespace orang::greedyvarorder
+
+
+/*
+ * Min-degree or min-fill elimination order of all the vertices of g, for
+ * large graphs.  Unlike greedyVarOrder, there is no complexity limit and no
+ * clamping, and ties between vertices of equal cost are broken by a shuffle of
+ * the vertex indices (seeded by seed, or the identity if seed is 0).
+ */
+inline greedyvarorder::VarOrder flatVarOrder(
+    const Graph& g,
+    const DomIndexVector& domSizes,
+    greedyvarorder::Heuristics h,
+    unsigned seed = 0) {
+
+  using std::log;
+  using namespace greedyvarorder::internal;
+
+  if (h != greedyvarorder::MIN_DEGREE && h != greedyvarorder::MIN_FILL) {
+    throw InvalidArgumentException("flatVarOrder only supports MIN_DEGREE and MIN_FILL");
+  }
+  const Var numVars = g.numVertices();
+  if (domSizes.size() != numVars) {
+    throw InvalidArgumentException("domSizes size must equal the number of vertices in g");
+  }
+
+  // the elimination runs on relabelled vertices, so that the labels break ties
+  VarVector labels(numVars);
+  for (Var v = 0; v < numVars; ++v) {
+    labels[v] = v;
+  }
+  if (seed != 0) {
+    std::mt19937 rng(seed);
+    std::shuffle(labels.begin(), labels.end(), rng);
+  }
+  VarVector vertices(numVars);
+  for (Var v = 0; v < numVars; ++v) {
+    vertices[labels[v]] = v;
+  }
+
+  greedyvarorder::VarOrder result;
+  result.varOrder.reserve(numVars);
+  result.width = numVars > 0;
+  result.complexity = 0.0;
+
+  FlatEliminator eliminator(g, labels, h == greedyvarorder::MIN_FILL);
+  eliminator.run(result.varOrder, [&](Var v, const VarVector& nv) {
+    double nodeWidth = log(static_cast<double>(domSizes[vertices[v]]));
+    for (auto u: nv) {
+      nodeWidth += log(static_cast<double>(domSizes[vertices[u]]));
+    }
+    result.width = std::max(result.width, nv.size());
+    result.complexity = std::max(result.complexity, nodeWidth);
+  });
+
+  static const double LOG2E = 1.4426950408889634074;
+  result.complexity *= LOG2E;
+  for (auto &v: result.varOrder) {
+    v = vertices[v];
+  }
+  return result;
+}
+
+/*
+ * The lowest-complexity order found by numRestarts runs of flatVarOrder, the
+ * first with ties broken by vertex index and the others with ties broken at
+ * random, on numThreads threads.  Among orders of equal complexity the one of
+ * the earliest run is kept, so the result does not depend on numThreads.
+ */
+inline greedyvarorder::VarOrder bestFlatVarOrder(
+    const Graph& g,
+    const DomIndexVector& domSizes,
+    greedyvarorder::Heuristics h,
+    int numRestarts,
+    int numThreads = 1,
+    unsigned seed = 1) {
+
+  if (numRestarts < 1) {
+    throw InvalidArgumentException("numRestarts must be positive");
+  }
+
+  std::vector<greedyvarorder::VarOrder> orders(numRestarts);
+  std::vector<int> restarts;
+  for (int r = numRestarts; r-- > 0; ) {
+    restarts.push_back(r);
+  }
+
+  // run 0 is unshuffled, so seeds are drawn only for the others
+  std::mt19937 seeds(seed);
+  std::vector<unsigned> runSeeds(numRestarts, 0);
+  for (int r = 1; r < numRestarts; ++r) {
+    do {
+      runSeeds[r] = seeds();
+    } while (runSeeds[r] == 0);
+  }
+
+  internal::runWorkQueue(numThreads, restarts, [&](int r, std::vector<int>&) {
+    orders[r] = flatVarOrder(g, domSizes, h, runSeeds[r]);
+  });
+
+  std::size_t best = 0;
+  for (std::size_t r = 1; r < orders.size(); ++r) {
+    if (orders[r].complexity < orders[best].complexity) {
+      best = r;
+    }
+  }
+  return std::move(orders[best]);
+}
+
 } // namespace orang
 
 #endif
@@ -0,0 +1,107 @@
+/**
+# Copyright 2026 D-Wave Systems Inc.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+# =============================================================================
+*/
+#ifndef INCLUDED_ORANG_WORKQUEUE_H
+#define INCLUDED_ORANG_WORKQUEUE_H
+
+#include <cstddef>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+#include "pool.h"
+
+namespace orang {
+namespace internal {
+
+// Runs work items, each of which may make others ready, on numThreads
+// threads until none are left.  run(item, ready) does the work of an item and
+// appends the items it makes ready to ready.  The threads are the calling
+// thread and workers of the shared pool of the samplers, see pool.h.
+//
+// Ready items are kept on a stack, so that the item made ready last is run
+// first.  Run on a single thread, a tree whose leaves are given in preorder
+// (first leaf last), and where finishing the last child of a node makes the
+// node ready, is then processed in postorder, exactly as a recursion would.
+// Work items are expected to be large (eg. table merges), so sharing the stack
+// under a lock costs little.
+//
+// The first exception thrown by run stops the threads from taking new items,
+// and is rethrown once they are all done.
+template<typename Item, typename Run>
+void runWorkQueue(int numThreads, std::vector<Item> ready, Run run) {
+  if (numThreads <= 1) {
+    std::vector<Item> next;
+    while (!ready.empty()) {
+      Item item = ready.back();
+      ready.pop_back();
+      next.clear();
+      run(item, next);
+      ready.insert(ready.end(), next.begin(), next.end());
+    }
+    return;
+  }
+
+  std::mutex lock;
+  std::condition_variable changed;
+  std::size_t running = 0;
+  std::exception_ptr error;
+
+  auto worker = [&]() {
+    std::vector<Item> next;
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+      changed.wait(guard, [&]() { return error || !ready.empty() || running == 0; });
+      if (error || ready.empty()) {
+        break;
+      }
+
+      Item item = ready.back();
+      ready.pop_back();
+      ++running;
+      guard.unlock();
+
+      next.clear();
+      std::exception_ptr itemError;
+      try {
+        run(item, next);
+      } catch (...) {
+        itemError = std::current_exception();
+      }
+
+      guard.lock();
+      --running;
+      if (itemError && !error) {
+        error = itemError;
+      }
+      ready.insert(ready.end(), next.begin(), next.end());
+      changed.notify_all();
+    }
+  };
+
+  run_parallel(numThreads, worker);
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace internal
+} // namespace orang
+
+#endif
@@ -1,5 +1,6 @@
 # distutils: language = c++
 # cython: language_level = 3
+# distutils: include_dirs = dwave/samplers/tree/src/include/ dwave/samplers/common/src/
 
 from cython.operator cimport preincrement as inc, dereference as deref
 
@@ -7,13 +8,29 @@ from libcpp.vector cimport vector
 from libcpp.unordered_map cimport unordered_map
 from libcpp.unordered_set cimport unordered_set
 
+import random
+
 import dimod
 cimport dimod
+from dimod.libcpp cimport BinaryQuadraticModel as cppBinaryQuadraticModel
+
+from dwave.samplers.common.pool cimport set_worker_pool, shared_worker_pool
+
+# run the parallel loops of the kernels on the workers shared by all samplers
+set_worker_pool(shared_worker_pool())
 
 
 __all__ = ['elimination_order_width', 'min_fill_heuristic']
 
 
+cdef extern from "src/include/order.hpp":
+    int minFillOrder[V, B](cppBinaryQuadraticModel[B, V]& bqm,
+                           int num_restarts,
+                           int num_threads,
+                           unsigned seed,
+                           vector[int]& order) except +
+
+
 ctypedef unordered_map[Py_ssize_t, unordered_set[Py_ssize_t]] adj_t
 
 cdef adj_t _cybqm_to_adj(dimod.cyBQM_float64 cybqm):
@@ -84,82 +101,40 @@ def elimination_order_width(bqm, order):
     return treewidth
 
 
-# dev note: adj is actually a const reference, but Cython does not like
-# that (fixed in Cython 3.0)
-cdef Py_ssize_t _min_num_edges(adj_t& adj):
-    """Get the node that would need to add the fewest edges when eliminated.
-
-    Only defined for len(adj) > 0.
-    """
-    # The goal is to go through each node in adj, and determine how many
-    # edges we would need to add in order to eliminate it.
-
-    # C++ lambdas don't work so well in Cython so we do 'min' the hard way...
-
-    cdef Py_ssize_t min_num_edges = adj.size() * adj.size()
-    cdef Py_ssize_t min_node  # our return value
-
-
-    cdef Py_ssize_t num_edges
-    cdef Py_ssize_t vi
-
-    it = adj.begin()
-    while it != adj.end():
-        vi = deref(it).first
-
-        # for all pairs of nodes in the neighborhood of vi, count the missing edges
-        num_edges = 0
-        uit = deref(it).second.begin()
-        while uit != deref(it).second.end():
-            vit = uit
-            while vit != deref(it).second.end():
-                if not adj[deref(vit)].count(deref(uit)):
-                    num_edges += 1
-                inc(vit)
-            inc(uit)
-
-        if num_edges < min_num_edges:
-            min_num_edges = num_edges
-            min_node = vi
-
-        inc(it)
-
-    return min_node
-
-
-def min_fill_heuristic(bqm):
+def min_fill_heuristic(bqm, int num_restarts=1, int num_threads=1, seed=None):
     """Compute an upper bound on the treewidth of the given bqm based on
     the min-fill heuristic for the elimination ordering.
 
     Args:
         bqm: a binary quadratic model
 
+        num_restarts: the number of orders to compute. The first breaks ties
+            between variables in a fixed way, the others at random, and the
+            order of lowest complexity is returned.
+
+        num_threads: the number of threads to compute the orders on. The
+            result does not depend on it.
+
+        seed: seed for the random tie-breaking of restarts. Drawn at random
+            when not given.
+
     Returns:
         A 2-tuple containing the bound on the treewidth and the elimination 
         order.
 
     """
-    cdef dimod.cyBQM_float64 cybqm = dimod.as_bqm(bqm, dtype=float).data
-
-    cdef adj_t adj = _cybqm_to_adj(cybqm)
+    if num_restarts < 1:
+        raise ValueError("num_restarts must be positive")
+    if num_threads < 1:
+        raise ValueError("num_threads must be positive")
+    if seed is None:
+        seed = random.getrandbits(32)
 
-    cdef vector[Py_ssize_t] order
-    order.reserve(cybqm.num_variables())
-
-    # if there is at least one node then the treewidth is at least 1
-    cdef Py_ssize_t upper_bound = cybqm.num_variables() > 0
-
-    cdef Py_ssize_t vi
-    while adj.size():
-        vi = _min_num_edges(adj)
-
-        if adj[vi].size() > upper_bound:
-            upper_bound = adj[vi].size()
-
-        # remove vi from adj
-        _elim_adj(adj, vi)
+    cdef dimod.cyBQM_float64 cybqm = dimod.as_bqm(bqm, dtype=float).data
 
-        order.push_back(vi)
+    cdef vector[int] order
+    cdef Py_ssize_t upper_bound = minFillOrder(deref(cybqm.cppbqm), num_restarts, num_threads,
+                                               seed % 2**32, order)
 
     cdef Py_ssize_t i
     variables = []
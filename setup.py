@@ -12,6 +12,8 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import os
+
 from setuptools import setup
 from Cython.Build import cythonize
 from setuptools.command.build_ext import build_ext
@@ -44,6 +46,11 @@ class build_ext_with_args(build_ext):
         for ext in self.extensions:
             ext.extra_compile_args = link_args
 
+        # the kernel counters, see dwave/samplers/common/src/counters.h
+        if os.environ.get('DWAVE_SAMPLERS_COUNTERS'):
+            for ext in self.extensions:
+                ext.define_macros.append(('DWAVE_SAMPLERS_COUNTERS', None))
+
         super().build_extensions()
 
 
@@ -51,7 +58,11 @@ class build_ext_with_args(build_ext):
 setup(
     cmdclass={'build_ext': build_ext_with_args},
     ext_modules=cythonize(
-        ['dwave/samplers/greedy/descent.pyx',
+        ['dwave/samplers/common/graph.pyx',
+         'dwave/samplers/common/pool.pyx',
+         'dwave/samplers/common/stream.pyx',
+         'dwave/samplers/greedy/descent.pyx',
+         'dwave/samplers/planar/cyplanar.pyx',
          'dwave/samplers/random/*.pyx',
          'dwave/samplers/sa/*.pyx',
          'dwave/samplers/tabu/tabu_search.pyx',
@@ -62,6 +62,8 @@ using orang::MinOperations;
 using orang::Task;
 using orang::BucketTree;
 using orang::NodeTables;
+using orang::NodeStats;
+using orang::nodeStatsEnabled;
 
 using tableAssign::vars;
 using tableAssign::domSizes;
@@ -588,4 +590,62 @@ BOOST_AUTO_TEST_CASE( tworoots_solve_tables )
       expectedNodeTablesSet.begin(), expectedNodeTablesSet.end());
 }
 
+BOOST_AUTO_TEST_CASE( memory_estimate )
+{
+  // a chain 0 - 1 - 2, eliminated in that order: the lambda tables of nodes 0
+  // and 1 have 2 entries, and their node tables 4
+  vector<Table<int> > chainTables = list_of<Table<int> >
+    ((vars = 0, 1, domSizes = 2, 2, values = 1, 2, 3, 4))
+    ((vars = 1, 2, domSizes = 2, 2, values = 5, 6, 7, 8));
+  vector<Table<int>*> chainTablesPtr;
+  for (auto &table: chainTables) {
+    chainTablesPtr.push_back(&table);
+  }
+
+  task_type task(chainTablesPtr.begin(), chainTablesPtr.end(), 1);
+  TreeDecomp decomp(task.graph(), list_of(0)(1)(2), task.domSizes());
+
+  // merging node 1 holds the lambda tables of nodes 0 and 1
+  BOOST_CHECK_EQUAL(BucketTree<task_type>::memoryEstimate(task, decomp, false, false), 4 * sizeof(int));
+  // two threads may merge the tables of nodes 1 and 2 at once
+  BOOST_CHECK_EQUAL(BucketTree<task_type>::memoryEstimate(task, decomp, false, false, 2), 8 * sizeof(int));
+  // solving keeps an entry per entry of each node table
+  BOOST_CHECK_EQUAL(BucketTree<task_type>::memoryEstimate(task, decomp, true, false), 14 * sizeof(int));
+  // the node tables keep a lambda and a pi table per node
+  BOOST_CHECK_EQUAL(BucketTree<task_type>::memoryEstimate(task, decomp, false, true), 12 * sizeof(int));
+}
+
+BOOST_AUTO_TEST_CASE( node_stats )
+{
+  vector<Table<int> > chainTables = list_of<Table<int> >
+    ((vars = 0, 1, domSizes = 2, 2, values = 1, 2, 3, 4))
+    ((vars = 1, 2, domSizes = 2, 2, values = 5, 6, 7, 8));
+  vector<Table<int>*> chainTablesPtr;
+  for (auto &table: chainTables) {
+    chainTablesPtr.push_back(&table);
+  }
+
+  task_type task(chainTablesPtr.begin(), chainTablesPtr.end(), 1);
+  TreeDecomp decomp(task.graph(), list_of(0)(1)(2), task.domSizes());
+  BucketTree<task_type> bucketTree(task, decomp, DomIndexVector(3), false, false);
+
+  const vector<NodeStats>& stats = bucketTree.nodeStats();
+  if (!nodeStatsEnabled) {
+    BOOST_CHECK(stats.empty());
+    return;
+  }
+
+  // in preorder, from the root 2 down to 0
+  BOOST_REQUIRE_EQUAL(stats.size(), 3u);
+  BOOST_CHECK_EQUAL(stats[0].nodeVar, 2u);
+  BOOST_CHECK_EQUAL(stats[0].tableSize, 1u);
+  BOOST_CHECK_EQUAL(stats[1].nodeVar, 1u);
+  BOOST_CHECK_EQUAL(stats[1].tableSize, 2u);
+  BOOST_CHECK_EQUAL(stats[2].nodeVar, 0u);
+  BOOST_CHECK_EQUAL(stats[2].tableSize, 2u);
+  for (const auto &s: stats) {
+    BOOST_CHECK_GE(s.mergeSeconds, 0.0);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
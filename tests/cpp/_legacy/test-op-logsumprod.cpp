@@ -121,4 +121,53 @@ BOOST_AUTO_TEST_CASE( solvable_marginalizer )
   }
 }
 
+BOOST_AUTO_TEST_CASE( solvable_marginalizer_block )
+{
+  FixedNumberGenerator fng(tableData::fixedNums);
+  SolvableLogSumMarginalizer<FixedNumberGenerator> mrg(fng, tableData::inScope, tableData::inDomSizes,
+      tableData::outVar, tableData::outDomSize);
+
+  Table<int> mrgTable(VarVector(1, tableData::outVar), DomIndexVector(1, tableData::outDomSize));
+  copy(tableData::values.begin(), tableData::values.end(), mrgTable.begin());
+  mrg(tableData::inIndex, mrgTable);
+
+  const size_t numSols = tableData::expectedOutSols.size();
+  const size_t stride = tableData::inSol.size();
+  DomIndexVector sols;
+  for (size_t i = 0; i < numSols; ++i) {
+    sols.insert(sols.end(), tableData::inSol.begin(), tableData::inSol.end());
+  }
+
+  FixedNumberGenerator blockFng(tableData::fixedNums);
+  mrg.solveBlock(numSols, sols.data(), stride, blockFng);
+  for (size_t i = 0; i < numSols; ++i) {
+    BOOST_CHECK_EQUAL_COLLECTIONS(sols.begin() + i * stride, sols.begin() + (i + 1) * stride,
+        tableData::expectedOutSols[i]->begin(), tableData::expectedOutSols[i]->end());
+  }
+}
+
+BOOST_AUTO_TEST_CASE( float_solvable_marginalizer )
+{
+  typedef LogSumProductOperations<FixedNumberGenerator, float> float_ops_type;
+
+  FixedNumberGenerator fng(tableData::fixedNums);
+  float_ops_type ops(fng);
+  float_ops_type::solvablemarginalizer_smartptr mrgP = ops.solvableMarginalizer(tableData::inScope,
+      tableData::inDomSizes, tableData::outVar, tableData::outDomSize);
+  float_ops_type::solvablemarginalizer_type& mrg = *mrgP;
+
+  Table<float> mrgTable(VarVector(1, tableData::outVar), DomIndexVector(1, tableData::outDomSize));
+  BOOST_REQUIRE_EQUAL(tableData::values.size(), mrgTable.size());
+  copy(tableData::values.begin(), tableData::values.end(), mrgTable.begin());
+
+  BOOST_CHECK_CLOSE(mrg(tableData::inIndex, mrgTable), tableData::expectedMinMrgValue, 1e-4);
+
+  for (const auto &expectedOutSol: tableData::expectedOutSols) {
+    DomIndexVector outSol = tableData::inSol;
+    mrg.solve(outSol);
+    BOOST_CHECK_EQUAL_COLLECTIONS(outSol.begin(), outSol.end(),
+        expectedOutSol->begin(), expectedOutSol->end());
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -46,7 +46,9 @@ using orang::VarVector;
 using orang::DomIndexVector;
 using orang::Table;
 using orang::Plus;
+using orang::MinSolution;
 using orang::MinSolutionSet;
+using orang::FlatMinSolutionSet;
 using orang::MinMarginalizer;
 using orang::SolvableMinMarginalizer;
 using orang::MinOperations;
@@ -106,6 +108,25 @@ const MinSolutionSet<int, greater<int> > expectedOutSolMax = MinSolSetBuilder<in
 
 
 } // namespace tableData
+
+// Runs mrg.solveFlat on inSol and returns the solutions found, in order
+template<typename Compare>
+vector<MinSolution<int> > solveFlat(const SolvableMinMarginalizer<int, Plus<int>, Compare>& mrg,
+    const MinSolutionSet<int, Compare>& inSol) {
+  FlatMinSolutionSet<int, Compare> in(inSol.maxSolutions(), 10, 10);
+  FlatMinSolutionSet<int, Compare> out(inSol.maxSolutions(), 10, 10);
+  for (const auto &sol: inSol.solutions()) {
+    in.push_back(sol.value, sol.solution);
+  }
+  mrg.solveFlat(in, out);
+
+  vector<MinSolution<int> > outSol;
+  for (size_t i = 0; i < out.size(); ++i) {
+    outSol.push_back(MinSolution<int>(out.value(i), out.solution(i)));
+  }
+  return outSol;
+}
+
 } // anonymous namespace
 
 
@@ -178,4 +199,31 @@ BOOST_AUTO_TEST_CASE( solvable_marginalizer_maxcompare )
       tableData::expectedOutSolMax.solutions().begin(), tableData::expectedOutSolMax.solutions().end());
 }
 
+
+BOOST_AUTO_TEST_CASE( solvable_marginalizer_flat )
+{
+  Table<int> mrgTable(VarVector(1, tableData::outVar), DomIndexVector(1, tableData::outDomSize));
+  copy(tableData::values.begin(), tableData::values.end(), mrgTable.begin());
+
+  SolvableMinMarginalizer<int, Plus<int> > mrg(tableData::inScope, tableData::inDomSizes,
+      tableData::outVar, tableData::outDomSize);
+  BOOST_CHECK_EQUAL(mrg(tableData::inIndex, mrgTable), tableData::expectedMinMrgValue);
+
+  vector<MinSolution<int> > outSol3 = solveFlat(mrg, tableData::inSol3);
+  BOOST_CHECK_EQUAL_COLLECTIONS(outSol3.begin(), outSol3.end(),
+      tableData::expectedOutSol3.solutions().begin(), tableData::expectedOutSol3.solutions().end());
+
+  vector<MinSolution<int> > outSol10 = solveFlat(mrg, tableData::inSol10);
+  BOOST_CHECK_EQUAL_COLLECTIONS(outSol10.begin(), outSol10.end(),
+      tableData::expectedOutSol10.solutions().begin(), tableData::expectedOutSol10.solutions().end());
+
+  SolvableMinMarginalizer<int, Plus<int>, greater<int> > maxMrg(tableData::inScope, tableData::inDomSizes,
+      tableData::outVar, tableData::outDomSize);
+  BOOST_CHECK_EQUAL(maxMrg(tableData::inIndex, mrgTable), tableData::expectedMaxMrgValue);
+
+  vector<MinSolution<int> > outSolMax = solveFlat(maxMrg, tableData::inSolMax);
+  BOOST_CHECK_EQUAL_COLLECTIONS(outSolMax.begin(), outSolMax.end(),
+      tableData::expectedOutSolMax.solutions().begin(), tableData::expectedOutSolMax.solutions().end());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -44,6 +44,7 @@ using orang::VarVector;
 using orang::DomIndexVector;
 using orang::SizeVector;
 using orang::Table;
+using orang::TableStorage;
 using orang::TableVar;
 using orang::InvalidArgumentException;
 using orang::LengthException;
@@ -155,4 +156,37 @@ BOOST_AUTO_TEST_CASE( table_constructor_exceptions )
   BOOST_CHECK_THROW(Table<int> t(goodTableData::vars, badTableData::hugeDomSizes), LengthException);
 }
 
+BOOST_AUTO_TEST_CASE( table_mapped_storage )
+{
+  Table<int> heapTable(goodTableData::vars, goodTableData::domSizes);
+  copy(goodTableData::ints.begin(), goodTableData::ints.end(), heapTable.begin());
+  BOOST_CHECK(!heapTable.mapped());
+
+  // every table of at least one byte is mapped
+  Table<int> mappedTable(goodTableData::vars, goodTableData::domSizes, 0, TableStorage(1));
+  copy(goodTableData::ints.begin(), goodTableData::ints.end(), mappedTable.begin());
+  BOOST_CHECK(mappedTable.mapped());
+  BOOST_CHECK(mappedTable == heapTable);
+
+  // copies are kept the way their source is
+  Table<int> mappedCopy(mappedTable);
+  BOOST_CHECK(mappedCopy.mapped());
+  BOOST_CHECK_EQUAL_COLLECTIONS(mappedCopy.begin(), mappedCopy.end(),
+      goodTableData::ints.begin(), goodTableData::ints.end());
+
+  Table<int> heapAssign;
+  heapAssign = mappedTable;
+  BOOST_CHECK(heapAssign.mapped());
+  BOOST_CHECK(heapAssign == heapTable);
+
+  // non-zero initial values are written through
+  Table<double> filled(goodTableData::vars, goodTableData::domSizes, 2.5, TableStorage(1));
+  BOOST_CHECK(filled.mapped());
+  BOOST_CHECK_EQUAL(std::count(filled.begin(), filled.end(), 2.5), static_cast<std::ptrdiff_t>(goodTableData::tableSize));
+
+  // tables below the threshold stay on the heap
+  Table<int> small(goodTableData::vars, goodTableData::domSizes, 0, TableStorage(goodTableData::tableSize * sizeof(int) + 1));
+  BOOST_CHECK(!small.mapped());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -29,6 +29,7 @@
 #include <table.h>
 #include <operations/dummy.h>
 #include <task.h>
+#include <treedecomp.h>
 #include <varorder.h>
 
 #include "test.h"
@@ -43,6 +44,9 @@ using orang::Table;
 using orang::DummyOperations;
 using orang::Task;
 using orang::greedyVarOrder;
+using orang::flatVarOrder;
+using orang::bestFlatVarOrder;
+using orang::TreeDecomp;
 
 using tableAssign::vars;
 using tableAssign::domSizes;
@@ -201,5 +205,37 @@ BOOST_AUTO_TEST_CASE( weightedMinFill )
       testData::expectedWMinFillVarOrder.begin(), testData::expectedWMinFillVarOrder.end());
 }
 
+BOOST_AUTO_TEST_CASE( flatOrders )
+{
+  const orang::Graph& g = testData::task.graph();
+  const orang::greedyvarorder::Heuristics heuristics[] = {
+      orang::greedyvarorder::MIN_DEGREE, orang::greedyvarorder::MIN_FILL };
+
+  for (auto h: heuristics) {
+    for (unsigned seed = 0; seed < 3; ++seed) {
+      orang::greedyvarorder::VarOrder vo = flatVarOrder(g, testData::task.domSizes(), h, seed);
+
+      VarVector sorted = vo.varOrder;
+      std::sort(sorted.begin(), sorted.end());
+      BOOST_REQUIRE_EQUAL(sorted.size(), testData::task.numVars());
+      for (std::size_t i = 0; i < sorted.size(); ++i) {
+        BOOST_CHECK_EQUAL(sorted[i], i);
+      }
+
+      TreeDecomp decomp(g, vo.varOrder, testData::task.domSizes());
+      BOOST_CHECK_CLOSE(vo.complexity, decomp.complexity(), 1e-9);
+    }
+
+    orang::greedyvarorder::VarOrder best1 = bestFlatVarOrder(g, testData::task.domSizes(), h, 5, 1, 7);
+    orang::greedyvarorder::VarOrder best3 = bestFlatVarOrder(g, testData::task.domSizes(), h, 5, 3, 7);
+    BOOST_CHECK_EQUAL_COLLECTIONS(best1.varOrder.begin(), best1.varOrder.end(),
+        best3.varOrder.begin(), best3.varOrder.end());
+    BOOST_CHECK(best1.complexity <= flatVarOrder(g, testData::task.domSizes(), h).complexity);
+  }
+
+  BOOST_CHECK_THROW(flatVarOrder(g, testData::task.domSizes(), orang::greedyvarorder::WEIGHTED_MIN_FILL),
+      orang::InvalidArgumentException);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
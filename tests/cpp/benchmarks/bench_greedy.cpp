@@ -0,0 +1,76 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "benchmarks.h"
+#include "descent.h"
+
+namespace {
+
+const int num_samples = 16;
+
+// Descends from `num_samples` random states per iteration with `solver`.
+// Reports the descent steps, ie. variable flips, per second.
+void descend(benchmark::State &state, std::shared_ptr<const IsingGraph> graph,
+             DescentSolver solver) {
+    const int num_vars = graph->num_variables();
+    std::vector<std::int8_t> states;
+    std::vector<double> energies(num_samples);
+    std::vector<unsigned> num_steps(num_samples);
+    std::uint64_t seed = 0;
+    double steps = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        states = random_states(num_samples, num_vars, seed++);
+        state.ResumeTiming();
+
+        steepest_gradient_descent(states.data(), energies.data(), num_steps.data(),
+                                  num_samples, *graph, solver);
+        for (unsigned s : num_steps) steps += s;
+    }
+
+    state.counters["steps"] = benchmark::Counter(steps, benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+void register_greedy_benchmarks(const std::vector<Problem> &problems) {
+    struct Solver {
+        const char *name;
+        DescentSolver solver;
+    };
+    const Solver solvers[] {
+        {"LinearSearch", LinearSearch},
+        {"OrderedSet", OrderedSet},
+        {"IndexedHeap", IndexedHeap},
+    };
+
+    for (const Problem &p : problems) {
+        auto graph = std::make_shared<const IsingGraph>(build_ising_graph(
+            p.h, p.coupler_starts, p.coupler_ends, p.coupler_weights));
+        for (const Solver &solver : solvers) {
+            benchmark::RegisterBenchmark(
+                ("greedy/" + std::string(solver.name) + "/" + p.name).c_str(),
+                descend, graph, solver.solver
+            )->Unit(benchmark::kMillisecond);
+        }
+    }
+}
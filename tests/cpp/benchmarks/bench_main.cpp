@@ -0,0 +1,39 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "benchmarks.h"
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    const std::vector<Problem> &problems = benchmark_problems();
+    register_sa_benchmarks(problems);
+    register_greedy_benchmarks(problems);
+    register_tabu_benchmarks(problems);
+    register_tree_benchmarks();
+
+    for (const Problem &problem : problems) {
+        benchmark::AddCustomContext(problem.name,
+            std::to_string(problem.num_variables()) + " variables, " +
+            std::to_string(problem.num_couplers()) + " couplers");
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "benchmarks.h"
+#include "cpu_sa.h"
+
+namespace {
+
+const int num_samples = 64;
+const int sweeps_per_beta = 1;
+const std::vector<double> beta_schedule {.1, .2, .4, .8, 1.6, 3.2, 6.4, 12.8};
+
+// Anneals `num_samples` reads per iteration, with the annealing run given by
+// `varorder`, `proposal` and `multi_spin`, see `general_simulated_annealing`.
+// Reports the sweeps, and the variable updates, per second.
+void anneal(benchmark::State &state, std::shared_ptr<const AnnealingProblem> problem,
+            VariableOrder varorder, Proposal proposal, bool multi_spin) {
+    const int num_vars = problem->num_variables();
+    std::vector<std::int8_t> states;
+    std::vector<double> energies(num_samples);
+    std::uint64_t seed = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        states = random_states(num_samples, num_vars, seed);
+        state.ResumeTiming();
+
+        problem->sample(states.data(), energies.data(), num_samples,
+                        sweeps_per_beta, beta_schedule, seed++, varorder, proposal,
+                        nullptr, nullptr, 1, multi_spin);
+        benchmark::DoNotOptimize(energies.data());
+    }
+
+    const double sweeps = (double)state.iterations() * num_samples *
+        sweeps_per_beta * beta_schedule.size();
+    state.counters["sweeps"] = benchmark::Counter(sweeps, benchmark::Counter::kIsRate);
+    state.counters["updates"] = benchmark::Counter(sweeps * num_vars,
+                                                   benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+void register_sa_benchmarks(const std::vector<Problem> &problems) {
+    struct Engine {
+        const char *name;
+        VariableOrder varorder;
+        Proposal proposal;
+        bool multi_spin;
+    };
+    const Engine engines[] {
+        {"Sequential/Metropolis", Sequential, Metropolis, false},
+        {"Sequential/Gibbs", Sequential, Gibbs, false},
+        {"Random/Metropolis", Random, Metropolis, false},
+        {"Random/Gibbs", Random, Gibbs, false},
+        {"Colored/Metropolis", Colored, Metropolis, false},
+        {"Colored/Gibbs", Colored, Gibbs, false},
+        {"MultiSpin/Metropolis", Sequential, Metropolis, true},
+        {"MultiSpin/Gibbs", Sequential, Gibbs, true},
+    };
+
+    for (const Problem &p : problems) {
+        // built once, outside of the timings, as the samplers do
+        auto problem = std::make_shared<const AnnealingProblem>(
+            p.h, p.coupler_starts, p.coupler_ends, p.coupler_weights);
+        for (const Engine &engine : engines) {
+            benchmark::RegisterBenchmark(
+                ("sa/" + std::string(engine.name) + "/" + p.name).c_str(),
+                anneal, problem, engine.varorder, engine.proposal, engine.multi_spin
+            )->Unit(benchmark::kMillisecond);
+        }
+    }
+}
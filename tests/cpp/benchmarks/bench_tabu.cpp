@@ -0,0 +1,59 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "benchmarks.h"
+#include "bqp.h"
+#include "tabu_search.h"
+
+namespace {
+
+// Runs one simple tabu search per iteration from the all-zeros solution of the
+// problem read as a QUBO. The search evaluates `coeff_z` times as many moves
+// as there are variables, which is about `coeff_z` tabu iterations, see
+// `TabuSearch::multiStartTabuSearch`. Reports the tabu iterations per second.
+void search(benchmark::State &state, std::shared_ptr<const BQP> problem, int coeff_z) {
+    const std::vector<int> init(problem->nVars, 0);
+    const double no_threshold = -std::numeric_limits<double>::infinity();
+    std::uint64_t seed = 0;
+    double iterations = 0;
+
+    for (auto _ : state) {
+        TabuSearch tabu(*problem, init, 0, -1, 0, seed++, no_threshold,
+                        coeff_z, coeff_z, 0);
+        iterations += tabu.numIterations();
+        benchmark::DoNotOptimize(tabu.bestEnergy());
+    }
+
+    state.counters["iterations"] = benchmark::Counter(iterations,
+                                                      benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+void register_tabu_benchmarks(const std::vector<Problem> &problems) {
+    for (const Problem &p : problems) {
+        auto problem = std::make_shared<const BQP>(graphToBQP(build_ising_graph(
+            p.h, p.coupler_starts, p.coupler_ends, p.coupler_weights)));
+        benchmark::RegisterBenchmark(("tabu/" + p.name).c_str(), search, problem, 1000)
+            ->Unit(benchmark::kMillisecond);
+    }
+}
@@ -0,0 +1,104 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <base.h>
+#include <table.h>
+#include <task.h>
+#include <merger.h>
+#include <operations/min.h>
+#include <operations/logsumprod.h>
+
+#include "benchmarks.h"
+#include "rng.h"
+
+namespace {
+
+// The uniform doubles the sampling marginalizers draw from
+class Rng {
+    StreamRng engine_;
+
+  public:
+    Rng() : engine_(0) {}
+    double operator()() { return engine_.uniform(); }
+};
+
+// The tables of a bucket of the given width: variable 0, eliminated by the
+// merge, is coupled to each of the variables 1..width, which form a chain,
+// as in the buckets of a tree decomposition of a lattice
+std::vector<orang::Table<double>> bucket_tables(int width) {
+    StreamRng rng(width);
+    std::vector<orang::Table<double>> tables;
+    auto add_table = [&](const orang::VarVector &scope) {
+        tables.emplace_back(scope, orang::DomIndexVector(scope.size(), 2));
+        for (double &value : tables.back()) value = rng.uniform() - .5;
+    };
+
+    add_table({0});
+    for (orang::Var v = 1; v <= (orang::Var)width; v++) {
+        add_table({0, v});
+        if (v > 1) add_table({v - 1, v});
+    }
+    return tables;
+}
+
+// Merges the tables of a bucket of width `state.range(0)` into a table over
+// the variables 1..width once per iteration, marginalizing variable 0 as the
+// tree decomposition solvers do. Reports the entries of the merged scope,
+// 2^(width + 1), processed per second.
+template <class Ops>
+void merge(benchmark::State &state, typename Ops::CtorArgs ctor_args) {
+    const int width = state.range(0);
+    const std::vector<orang::Table<double>> tables = bucket_tables(width);
+    std::vector<const orang::Table<double>*> table_ptrs;
+    for (const auto &table : tables) table_ptrs.push_back(&table);
+
+    typedef orang::Task<Ops> task_type;
+    task_type task(table_ptrs.begin(), table_ptrs.end(), ctor_args);
+    orang::TableMerger<task_type> merger(task);
+    auto marginalizer = task.marginalizer();
+
+    orang::VarVector out_scope;
+    for (orang::Var v = 1; v <= (orang::Var)width; v++) out_scope.push_back(v);
+
+    for (auto _ : state) {
+        auto table = merger(out_scope, task.tables().begin(), task.tables().end(), *marginalizer);
+        benchmark::DoNotOptimize(table->begin());
+    }
+
+    state.SetItemsProcessed(state.iterations() * (std::int64_t(1) << (width + 1)));
+}
+
+typedef orang::MinOperations<double, orang::Plus<double>> MinOps;
+typedef orang::LogSumProductOperations<Rng> LogSumProductOps;
+
+}  // namespace
+
+void register_tree_benchmarks() {
+    static Rng rng;
+    const std::vector<std::int64_t> widths {8, 12, 16};
+
+    benchmark::RegisterBenchmark("tree/TableMerger/Min", merge<MinOps>,
+                                 MinOps::CtorArgs(1))
+        ->ArgName("width")->ArgsProduct({widths});
+    benchmark::RegisterBenchmark("tree/TableMerger/LogSumProduct", merge<LogSumProductOps>,
+                                 LogSumProductOps::CtorArgs(rng))
+        ->ArgName("width")->ArgsProduct({widths});
+}
@@ -0,0 +1,30 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The benchmarks of each kernel, registered by `main` once the problems are
+// built
+
+#ifndef _BENCHMARKS_H
+#define _BENCHMARKS_H
+
+#include <vector>
+
+#include "problems.h"
+
+void register_sa_benchmarks(const std::vector<Problem> &problems);
+void register_greedy_benchmarks(const std::vector<Problem> &problems);
+void register_tabu_benchmarks(const std::vector<Problem> &problems);
+void register_tree_benchmarks();
+
+#endif
@@ -0,0 +1,163 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The problems the kernels are benchmarked on: spin glasses on graphs of the
+// size and degree of the QPU topologies, and the frustrated triangular
+// lattices of tests/data.
+
+#ifndef _BENCHMARK_PROBLEMS_H
+#define _BENCHMARK_PROBLEMS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rng.h"
+
+#ifndef BENCHMARK_DATA_DIR
+#define BENCHMARK_DATA_DIR "../data/"
+#endif
+
+// An Ising problem given by its list of couplers, as the kernels take it
+struct Problem {
+    std::string name;
+    std::vector<double> h;
+    std::vector<int> coupler_starts;
+    std::vector<int> coupler_ends;
+    std::vector<double> coupler_weights;
+
+    int num_variables() const { return h.size(); }
+    int num_couplers() const { return coupler_weights.size(); }
+};
+
+// Gives `problem` random +-1 fields and couplings on the edges `edges`
+inline void assign_spin_glass(Problem &problem, int num_vars,
+                              const std::set<std::pair<int, int>> &edges,
+                              std::uint64_t seed) {
+    StreamRng rng(seed);
+    problem.h.resize(num_vars);
+    for (double &bias : problem.h) bias = rng.below(2) ? 1 : -1;
+    for (const auto &edge : edges) {
+        problem.coupler_starts.push_back(edge.first);
+        problem.coupler_ends.push_back(edge.second);
+        problem.coupler_weights.push_back(rng.below(2) ? 1 : -1);
+    }
+}
+
+// A spin glass on the Chimera graph C(m), of m by m unit cells of K(4, 4)
+inline Problem chimera_problem(int m, std::uint64_t seed = 1) {
+    const int t = 4;
+    auto index = [m, t](int i, int j, int u, int k) {
+        return ((i * m + j) * 2 + u) * t + k;
+    };
+    std::set<std::pair<int, int>> edges;
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < m; j++) {
+            for (int k = 0; k < t; k++) {
+                for (int l = 0; l < t; l++) edges.insert({index(i, j, 0, k), index(i, j, 1, l)});
+                if (i + 1 < m) edges.insert({index(i, j, 0, k), index(i + 1, j, 0, k)});
+                if (j + 1 < m) edges.insert({index(i, j, 1, k), index(i, j + 1, 1, k)});
+            }
+        }
+    }
+    Problem problem;
+    problem.name = "chimera" + std::to_string(m);
+    assign_spin_glass(problem, m * m * 2 * t, edges, seed);
+    return problem;
+}
+
+// A spin glass on a graph of the shape of the Pegasus and Zephyr topologies:
+// a `side` by `side` lattice of cells of `per_cell` variables, where each
+// variable is coupled at random to about `degree` variables of its own and
+// of the adjacent cells. It has the size, degree and locality of the QPU
+// graphs, rather than their exact structure.
+inline Problem local_problem(const std::string &name, int side, int per_cell,
+                             int degree, std::uint64_t seed = 1) {
+    const int num_vars = side * side * per_cell;
+    StreamRng rng(seed, 1);
+    std::set<std::pair<int, int>> edges;
+    for (int v = 0; v < num_vars; v++) {
+        const int cell = v / per_cell;
+        const int x = cell % side, y = cell / side;
+        // each edge is drawn from both of its ends
+        for (int d = 0; d < (degree + 1) / 2; d++) {
+            const int nx = x + (int)rng.below(3) - 1, ny = y + (int)rng.below(3) - 1;
+            if (nx < 0 || nx >= side || ny < 0 || ny >= side) continue;
+            const int u = (ny * side + nx) * per_cell + (int)rng.below(per_cell);
+            if (u != v) edges.insert({std::min(u, v), std::max(u, v)});
+        }
+    }
+    Problem problem;
+    problem.name = name;
+    assign_spin_glass(problem, num_vars, edges, seed);
+    return problem;
+}
+
+// Pegasus P(16) has 5640 variables of degree up to 15
+inline Problem pegasus_shaped_problem(std::uint64_t seed = 1) {
+    return local_problem("pegasus_shaped", 24, 10, 15, seed);
+}
+
+// Zephyr Z(12, 4) has 4992 variables of degree up to 20
+inline Problem zephyr_shaped_problem(std::uint64_t seed = 1) {
+    return local_problem("zephyr_shaped", 24, 9, 20, seed);
+}
+
+// The frustrated triangular lattice FrustTriangleL<size>.tsv of tests/data,
+// whose lines are couplers "u v J", without fields
+inline Problem frust_triangle_problem(int size) {
+    const std::string name = "FrustTriangleL" + std::to_string(size);
+    std::ifstream file(BENCHMARK_DATA_DIR + name + ".tsv");
+    if (!file) throw std::runtime_error("cannot read " + name + ".tsv");
+
+    Problem problem;
+    problem.name = name;
+    int u, v, num_vars = 0;
+    double weight;
+    while (file >> u >> v >> weight) {
+        problem.coupler_starts.push_back(u);
+        problem.coupler_ends.push_back(v);
+        problem.coupler_weights.push_back(weight);
+        num_vars = std::max(num_vars, std::max(u, v) + 1);
+    }
+    problem.h.assign(num_vars, 0);
+    return problem;
+}
+
+// The problems every sampler kernel is benchmarked on, built once
+inline const std::vector<Problem> &benchmark_problems() {
+    static const std::vector<Problem> problems {
+        chimera_problem(16),
+        pegasus_shaped_problem(),
+        zephyr_shaped_problem(),
+        frust_triangle_problem(39),
+    };
+    return problems;
+}
+
+// Random initial states, one row of `num_vars` spins per sample
+inline std::vector<std::int8_t> random_states(int num_samples, int num_vars,
+                                              std::uint64_t seed = 7) {
+    StreamRng rng(seed);
+    std::vector<std::int8_t> states((std::size_t)num_samples * num_vars);
+    for (auto &spin : states) spin = rng.below(2) ? 1 : -1;
+    return states;
+}
+
+#endif
@@ -0,0 +1,64 @@
+// Copyright 2022 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _MOCK_BQM_H
+#define _MOCK_BQM_H
+
+#include <vector>
+
+// A minimal binary quadratic model with the part of the interface of
+// `dimod::BinaryQuadraticModel` that the samplers read in place. Unlike dimod,
+// interactions are not merged, so each pair of variables should be added at
+// most once.
+class MockBQM {
+  public:
+    struct Term {
+        int v;
+        double bias;
+    };
+    typedef std::vector<Term>::const_iterator const_neighborhood_iterator;
+
+    explicit MockBQM(int num_variables)
+        : linear_(num_variables), adj_(num_variables), offset_(0) {}
+
+    void add_linear(int v, double bias) { linear_[v] += bias; }
+
+    void add_quadratic(int u, int v, double bias) {
+        adj_[u].push_back({v, bias});
+        adj_[v].push_back({u, bias});
+    }
+
+    void add_offset(double bias) { offset_ += bias; }
+
+    int num_variables() const { return linear_.size(); }
+
+    double linear(int v) const { return linear_[v]; }
+
+    double offset() const { return offset_; }
+
+    const_neighborhood_iterator cbegin_neighborhood(int v) const {
+        return adj_[v].cbegin();
+    }
+
+    const_neighborhood_iterator cend_neighborhood(int v) const {
+        return adj_[v].cend();
+    }
+
+  private:
+    std::vector<double> linear_;
+    std::vector<std::vector<Term>> adj_;
+    double offset_;
+};
+
+#endif
@@ -0,0 +1,64 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#include "../Catch2/single_include/catch2/catch.hpp"
+#include "deadline.h"
+
+
+TEST_CASE("Test Deadline") {
+    SECTION("an untimed deadline never passes") {
+        Deadline deadline;
+        CHECK_FALSE(deadline.timed());
+        for (int i = 0; i < 1000; i++) REQUIRE_FALSE(deadline.expired());
+        CHECK_FALSE(deadline.check());
+
+        deadline.expire();
+        CHECK(deadline.expired());
+    }
+
+    SECTION("a past deadline is noticed at the first check") {
+        Deadline deadline(0.0);
+        CHECK(deadline.timed());
+        CHECK(deadline.expired());
+        CHECK(deadline.check());
+
+        Deadline past(Deadline::clock::now() - std::chrono::seconds(1));
+        CHECK(past.check());
+    }
+
+    SECTION("cheap checks read the clock less often") {
+        Deadline deadline(60.0);
+        for (int i = 0; i < 100000; i++) REQUIRE_FALSE(deadline.expired());
+        CHECK(deadline.stride() > 1);
+        CHECK_FALSE(deadline.check());
+    }
+
+    SECTION("a deadline is noticed soon after it passes") {
+        const double seconds = .02;
+        const auto start = Deadline::clock::now();
+        Deadline deadline(seconds);
+        std::int64_t checks = 0;
+        while (!deadline.expired()) checks++;
+        const double elapsed = std::chrono::duration<double>(Deadline::clock::now() - start).count();
+
+        CHECK(checks > 0);
+        CHECK(elapsed >= seconds);
+        // generous, the target is a check interval late
+        CHECK(elapsed < seconds + .01);
+    }
+}
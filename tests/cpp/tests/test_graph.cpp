@@ -0,0 +1,201 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "../Catch2/single_include/catch2/catch.hpp"
+#include "bqp.h"
+#include "cpu_sa.h"
+#include "descent.h"
+#include "graph.h"
+#include "mock_bqm.h"
+
+
+namespace {
+
+template <class Weight>
+std::vector<std::int32_t> row_vars(const BasicAdjacency<Weight> &adj, int v) {
+    std::vector<std::int32_t> vars;
+    for (auto n = adj.begin(v); n != adj.end(v); n++) vars.push_back(n->var);
+    return vars;
+}
+
+template <class Weight>
+std::vector<Weight> row_weights(const BasicAdjacency<Weight> &adj, int v) {
+    std::vector<Weight> weights;
+    for (auto n = adj.begin(v); n != adj.end(v); n++) weights.push_back(n->weight);
+    return weights;
+}
+
+}  // namespace
+
+TEST_CASE("Test build_adjacency options") {
+    // bqm ~ {(0, 3): 1, (0, 1): 2, (3, 0): 3, (0, 2): 4, (1, 1): 5}
+    std::vector<int> coupler_starts {0, 0, 3, 0, 1};
+    std::vector<int> coupler_ends {3, 1, 0, 2, 1};
+    std::vector<double> coupler_weights {1, 2, 3, 4, 5};
+
+    SECTION("coupler order") {
+        Adjacency adj = build_adjacency(4, coupler_starts, coupler_ends,
+                                        coupler_weights);
+        CHECK(adj.num_variables() == 4);
+        CHECK(row_vars(adj, 0) == std::vector<std::int32_t>{3, 1, 3, 2});
+        CHECK(row_weights(adj, 0) == std::vector<double>{1, 2, 3, 4});
+        CHECK(row_vars(adj, 1) == std::vector<std::int32_t>{0, 1, 1});
+    }
+
+    SECTION("sorted neighbors") {
+        AdjacencyOptions options;
+        options.sort_neighbors = true;
+        Adjacency adj = build_adjacency(4, coupler_starts, coupler_ends,
+                                        coupler_weights, options);
+        REQUIRE(adj.offsets == std::vector<int>{0, 4, 7, 8, 10});
+        CHECK(row_vars(adj, 0) == std::vector<std::int32_t>{1, 2, 3, 3});
+        // duplicates keep the order they are given in
+        CHECK(row_weights(adj, 0) == std::vector<double>{2, 4, 1, 3});
+        CHECK(row_vars(adj, 1) == std::vector<std::int32_t>{0, 1, 1});
+    }
+
+    SECTION("merged duplicates") {
+        AdjacencyOptions options;
+        options.merge_duplicates = true;
+        Adjacency adj = build_adjacency(4, coupler_starts, coupler_ends,
+                                        coupler_weights, options);
+        REQUIRE(adj.offsets == std::vector<int>{0, 3, 5, 6, 7});
+        CHECK(row_vars(adj, 0) == std::vector<std::int32_t>{1, 2, 3});
+        CHECK(row_weights(adj, 0) == std::vector<double>{2, 4, 4});
+        CHECK(row_vars(adj, 3) == std::vector<std::int32_t>{0});
+        CHECK(row_weights(adj, 3) == std::vector<double>{4});
+        // both halves of the self-loop are merged
+        CHECK(row_vars(adj, 1) == std::vector<std::int32_t>{0, 1});
+        CHECK(row_weights(adj, 1) == std::vector<double>{2, 10});
+    }
+
+    SECTION("float weights") {
+        BasicAdjacency<float> adj = build_adjacency<float>(
+            4, coupler_starts, coupler_ends, coupler_weights);
+        CHECK(row_weights(adj, 0) == std::vector<float>{1, 2, 3, 4});
+    }
+
+    SECTION("invalid couplers") {
+        std::vector<int> bad_starts {0, 0, 3, 0, -1};
+        CHECK_THROWS_AS(build_adjacency(4, bad_starts, coupler_ends,
+                                        coupler_weights), std::runtime_error);
+        std::vector<int> short_ends {3, 1};
+        CHECK_THROWS_AS(build_adjacency(4, coupler_starts, short_ends,
+                                        coupler_weights), std::runtime_error);
+    }
+}
+
+TEST_CASE("Test build_ising_graph") {
+    MockBQM bqm(3);
+    bqm.add_linear(0, -1);
+    bqm.add_linear(2, .5);
+    bqm.add_quadratic(0, 2, 2);
+    bqm.add_quadratic(1, 0, -3);
+
+    IsingGraph from_bqm = build_ising_graph(bqm);
+    IsingGraph from_couplers = build_ising_graph({-1, 0, .5}, {0, 1}, {2, 0}, {2, -3});
+
+    REQUIRE(from_bqm.num_variables() == 3);
+    CHECK(from_bqm.linear == from_couplers.linear);
+    CHECK(from_bqm.adjacency.offsets == from_couplers.adjacency.offsets);
+    for (int v = 0; v < 3; v++) {
+        CHECK(row_vars(from_bqm.adjacency, v) == row_vars(from_couplers.adjacency, v));
+        CHECK(row_weights(from_bqm.adjacency, v) == row_weights(from_couplers.adjacency, v));
+    }
+
+    // the dense Q matrix matches the one read from the model
+    CHECK(graphToQ(from_bqm) == bqmToQ(bqm));
+}
+
+TEST_CASE("Test sharing an IsingGraph between samplers") {
+    // frustrated ring of spins, with a field on one of them
+    const int num_vars = 9;
+    std::vector<double> h(num_vars, 0);
+    h[0] = .25;
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v ? 1 : -1);
+    }
+
+    auto graph = std::make_shared<const IsingGraph>(
+        build_ising_graph(h, coupler_starts, coupler_ends, coupler_weights));
+
+    AnnealingProblem problem(graph);
+    CHECK(problem.graph() == graph);
+    CHECK(problem.num_variables() == num_vars);
+
+    const int num_samples = 4;
+    std::vector<std::int8_t> states(num_samples * num_vars, 1);
+    std::vector<double> energies(num_samples);
+    std::vector<double> beta_schedule {.1, .5, 1};
+    problem.sample(states.data(), energies.data(), num_samples, 10,
+                   beta_schedule, 1234, Sequential, Metropolis, nullptr, nullptr);
+
+    // descending from the annealed states on the same graph gives the same
+    // result as on the coupler vectors
+    std::vector<std::int8_t> shared_states(states);
+    std::vector<double> shared_energies(num_samples);
+    std::vector<unsigned> shared_steps(num_samples);
+    steepest_gradient_descent(shared_states.data(), shared_energies.data(),
+                              shared_steps.data(), num_samples, *graph);
+
+    std::vector<double> coupler_energies(num_samples);
+    std::vector<unsigned> coupler_steps(num_samples);
+    steepest_gradient_descent(states.data(), coupler_energies.data(),
+                              coupler_steps.data(), num_samples, h,
+                              coupler_starts, coupler_ends, coupler_weights);
+
+    CHECK(shared_states == states);
+    CHECK(shared_energies == coupler_energies);
+    CHECK(shared_steps == coupler_steps);
+
+    CHECK_THROWS_AS(AnnealingProblem(std::shared_ptr<const IsingGraph>()),
+                    std::runtime_error);
+}
+
+TEST_CASE("Test state_energy_from_flip_energies") {
+    std::vector<double> h {-1, 0, .5};
+    Adjacency adj = build_adjacency(3, {0, 1}, {2, 0}, {2, -3});
+
+    for (int i = 0; i < 8; i++) {
+        std::int8_t state[3] = {std::int8_t(i & 1 ? 1 : -1),
+                                std::int8_t(i & 2 ? 1 : -1),
+                                std::int8_t(i & 4 ? 1 : -1)};
+        double energy = -state[0] + .5 * state[2] + 2 * state[0] * state[2]
+                        - 3 * state[1] * state[0];
+
+        // flipping each variable in turn gives its energy delta
+        std::vector<double> flip_energies(3);
+        for (int v = 0; v < 3; v++) {
+            state[v] *= -1;
+            flip_energies[v] = get_state_energy(state, h, adj) - energy;
+            state[v] *= -1;
+        }
+
+        CHECK(get_state_energy(state, h, adj) == Approx(energy));
+        CHECK(state_energy_from_flip_energies(state, h, flip_energies.data())
+              == Approx(energy));
+    }
+
+    CHECK_NOTHROW(verify_energy(1e8 + 1e-3, 1e8));
+    CHECK_THROWS_AS(verify_energy(1.001, 1), std::runtime_error);
+}
@@ -12,10 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <limits>
+#include <thread>
 #include <vector>
 
 #include "../Catch2/single_include/catch2/catch.hpp"
 #include "descent.h"
+#include "mock_bqm.h"
 
 
 TEST_CASE("Test steepest_gradient_descent") {
@@ -44,3 +47,409 @@ TEST_CASE("Test steepest_gradient_descent") {
         CHECK(energies[i] == min_energies[i]);
     }
 }
+
+TEST_CASE("Test steepest_gradient_descent on a binary quadratic model") {
+    int num_samples = 2;
+
+    int8_t states[6] = {1, 1, 1, -1, -1, 1}, min_states[3] = {-1, 1, 1};
+    double energies[2] = {0, 0};
+    unsigned num_steps[2] = {0, 0};
+
+    // bqm ~ {(0, 1): 1, (1, 2): 1, (2, 0): 1})
+    MockBQM bqm(3);
+    bqm.add_quadratic(0, 1, 1.0);
+    bqm.add_quadratic(1, 2, 1.0);
+    bqm.add_quadratic(2, 0, 1.0);
+
+    for (DescentSolver solver : {LinearSearch, OrderedSet, IndexedHeap}) {
+        steepest_gradient_descent(
+            states, energies, num_steps, num_samples, bqm, solver
+        );
+
+        // the first sample descends to the same minimum as above, the second
+        // starts in a minimum
+        for (auto i = 0; i < 3; i++) {
+            CHECK(states[i] == min_states[i]);
+        }
+        CHECK(states[3] == -1);
+        CHECK(states[4] == -1);
+        CHECK(states[5] == 1);
+        CHECK(energies[0] == -1);
+        CHECK(energies[1] == -1);
+        CHECK(num_steps[1] == 0);
+    }
+}
+
+TEST_CASE("Test steepest_gradient_descent solvers and threads agree") {
+    // a sparse problem with small integer biases, so that there are many
+    // ties between the flip energies
+    const int num_vars = 500, num_samples = 20;
+    vector<double> linear_biases(num_vars);
+    vector<int> coupler_starts, coupler_ends;
+    vector<double> coupler_weights;
+    unsigned x = 12345;
+    auto next = [&x]() { x = x * 1103515245 + 12345; return (x >> 16) & 0x7fff; };
+    for (int v = 0; v < num_vars; v++) {
+        linear_biases[v] = (int)(next() % 3) - 1;
+        for (int k = 1; k <= 3; k++) {
+            coupler_starts.push_back(v);
+            coupler_ends.push_back((v + k * (next() % 50 + 1)) % num_vars);
+            coupler_weights.push_back((int)(next() % 5) - 2);
+        }
+    }
+    vector<int8_t> initial_states(num_vars * num_samples);
+    for (auto &spin : initial_states) spin = next() % 2 ? 1 : -1;
+
+    vector<int8_t> states(initial_states);
+    vector<double> energies(num_samples);
+    vector<unsigned> num_steps(num_samples);
+    steepest_gradient_descent(
+        states.data(), energies.data(), num_steps.data(), num_samples,
+        linear_biases, coupler_starts, coupler_ends, coupler_weights,
+        LinearSearch
+    );
+
+    for (DescentSolver solver : {OrderedSet, IndexedHeap}) {
+        vector<int8_t> solver_states(initial_states);
+        vector<double> solver_energies(num_samples);
+        vector<unsigned> solver_num_steps(num_samples);
+        steepest_gradient_descent(
+            solver_states.data(), solver_energies.data(),
+            solver_num_steps.data(), num_samples,
+            linear_biases, coupler_starts, coupler_ends, coupler_weights,
+            solver
+        );
+        CHECK(solver_states == states);
+        CHECK(solver_energies == energies);
+        CHECK(solver_num_steps == num_steps);
+    }
+    CHECK(num_steps[0] > 0);
+
+    // nor do the descents depend on the number of threads
+    for (DescentSolver solver : {LinearSearch, OrderedSet, IndexedHeap})
+    for (int num_threads : {2, 3, 100}) {
+        vector<int8_t> thread_states(initial_states);
+        vector<double> thread_energies(num_samples);
+        vector<unsigned> thread_num_steps(num_samples);
+        steepest_gradient_descent(
+            thread_states.data(), thread_energies.data(),
+            thread_num_steps.data(), num_samples,
+            linear_biases, coupler_starts, coupler_ends, coupler_weights,
+            solver, num_threads
+        );
+        CHECK(thread_states == states);
+        CHECK(thread_energies == energies);
+        CHECK(thread_num_steps == num_steps);
+    }
+}
+
+TEST_CASE("Test get_state_energy from neighbors") {
+    int8_t state[3] = {1, -1, 1};
+    vector<double> linear_biases {1, 2, 0};
+    // couplers (0, 1): 3, (2, 1): -1 and (2, 2): 4
+    vector<vector<int>> neighbors {{1}, {0, 2}, {1, 2, 2}};
+    vector<vector<double>> neighbour_couplings {{3}, {3, -1}, {-1, 4, 4}};
+
+    CHECK(get_state_energy(state, linear_biases, neighbors, neighbour_couplings)
+          == get_state_energy(state, linear_biases, {0, 2, 2}, {1, 1, 2}, {3, -1, 4}));
+}
+
+TEST_CASE("Test steepest_gradient_descent completed reads") {
+    const int num_vars = 100, num_samples = 40;
+    vector<double> linear_biases(num_vars);
+    vector<int> coupler_starts, coupler_ends;
+    vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        linear_biases[v] = v % 3 - 1;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 4 ? -1 : 2);
+    }
+    const IsingGraph graph = build_ising_graph(
+        linear_biases, coupler_starts, coupler_ends, coupler_weights);
+
+    vector<int8_t> initial_states(num_vars * num_samples);
+    for (int i = 0; i < num_vars * num_samples; i++) {
+        initial_states[i] = (i * 7 + i / 3) % 5 < 2 ? 1 : -1;
+    }
+
+    vector<int8_t> states(initial_states);
+    vector<double> energies(num_samples);
+    vector<unsigned> num_steps(num_samples);
+    steepest_gradient_descent(states.data(), energies.data(), num_steps.data(),
+                              num_samples, graph);
+
+    // every sample is pushed once, after its descent is done
+    for (int num_threads : {1, 3}) {
+        ReadQueue queue(4);
+        vector<int8_t> streamed_states(initial_states);
+        vector<double> streamed_energies(num_samples);
+        vector<unsigned> streamed_num_steps(num_samples);
+        vector<double> popped_energies(num_samples, 0);
+        vector<int> num_pops(num_samples, 0);
+
+        std::thread consumer([&]() {
+            int reads[3];
+            for (;;) {
+                const bool finished = queue.finished();
+                const std::size_t num_popped = queue.pop(reads, 3, 1);
+                if (!num_popped && finished) break;
+                for (std::size_t i = 0; i < num_popped; i++) {
+                    num_pops[reads[i]]++;
+                    popped_energies[reads[i]] = streamed_energies[reads[i]];
+                }
+            }
+        });
+        steepest_gradient_descent(
+            streamed_states.data(), streamed_energies.data(),
+            streamed_num_steps.data(), num_samples, graph,
+            LinearSearch, num_threads, &queue);
+        queue.finish();
+        consumer.join();
+
+        CHECK(num_pops == vector<int>(num_samples, 1));
+        CHECK(popped_energies == energies);
+        CHECK(streamed_states == states);
+    }
+}
+
+TEST_CASE("Test steepest_gradient_descent_batch") {
+    // frustrated rings of different sizes, one of them without variables
+    std::vector<MockBQM> bqms;
+    for (int num_vars : {3, 10, 0, 25}) {
+        MockBQM bqm(num_vars);
+        for (int v = 0; v < num_vars; v++) {
+            bqm.add_linear(v, 0.1 * (v % 4) - 0.15);
+            bqm.add_quadratic(v, (v + 1) % num_vars, v % 3 ? 1.0 : -1.0);
+        }
+        bqms.push_back(bqm);
+    }
+    std::vector<MockBQM*> pointers;
+    int total_vars = 0;
+    for (auto &bqm : bqms) {
+        pointers.push_back(&bqm);
+        total_vars += bqm.num_variables();
+    }
+
+    const int num_samples = 5;
+    std::vector<int8_t> states(num_samples * total_vars);
+    std::vector<double> energies(num_samples * bqms.size());
+    std::vector<unsigned> num_steps(num_samples * bqms.size());
+    steepest_gradient_descent_batch(pointers, states.data(), energies.data(),
+                                    num_steps.data(), num_samples, 42);
+
+    // every sample is a local minimum of its problem with the right energy
+    int offset = 0;
+    for (size_t i = 0; i < bqms.size(); i++) {
+        const IsingGraph graph = build_ising_graph(bqms[i]);
+        const int num_vars = graph.num_variables();
+        for (int s = 0; s < num_samples; s++) {
+            int8_t* state = states.data() + offset + s * num_vars;
+            const double energy = get_state_energy(state, graph.linear, graph.adjacency);
+            CHECK(energy == Approx(energies[num_samples * i + s]));
+            for (int v = 0; v < num_vars; v++) {
+                state[v] = -state[v];
+                CHECK(get_state_energy(state, graph.linear, graph.adjacency) >= energy - 1e-9);
+                state[v] = -state[v];
+            }
+        }
+        offset += num_samples * num_vars;
+    }
+    for (int s = 0; s < num_samples; s++) CHECK(energies[num_samples * 2 + s] == 0);
+
+    // and the samples do not depend on the number of threads or the solver
+    for (DescentSolver solver : {LinearSearch, IndexedHeap}) {
+        for (int num_threads : {1, 2, 4}) {
+            std::vector<int8_t> threaded_states(states.size());
+            std::vector<double> threaded_energies(energies.size());
+            std::vector<unsigned> threaded_num_steps(num_steps.size());
+            steepest_gradient_descent_batch(
+                pointers, threaded_states.data(), threaded_energies.data(),
+                threaded_num_steps.data(), num_samples, 42, solver, num_threads);
+            CHECK(threaded_states == states);
+            CHECK(threaded_num_steps == num_steps);
+        }
+    }
+}
+
+TEST_CASE("Test DescentState updates") {
+    // a sparse frustrated problem, as a list of couplers that the updates are
+    // also applied to
+    const int num_vars = 40;
+    vector<double> linear(num_vars);
+    vector<int> starts, ends;
+    vector<double> weights;
+    for (int v = 0; v < num_vars; v++) {
+        linear[v] = 0.1 * (v % 5) - 0.2;
+        for (int d : {1, 7}) {
+            starts.push_back(v);
+            ends.push_back((v + d) % num_vars);
+            weights.push_back((v * d) % 3 ? 1.0 : -1.5);
+        }
+    }
+
+    const int num_samples = 6;
+    vector<int8_t> initial(num_samples * num_vars);
+    for (size_t i = 0; i < initial.size(); i++) initial[i] = (i * 7919) % 3 ? 1 : -1;
+
+    vector<unsigned> num_steps(num_samples);
+    DescentState descent(build_ising_graph(linear, starts, ends, weights),
+                         initial.data(), num_samples, num_steps.data());
+
+    // each update gives the same minima as a full descent from the previous
+    // ones on the updated problem
+    auto check = [&](const vector<int>& linear_vars, const vector<double>& linear_deltas,
+                     const vector<int>& coupler_starts, const vector<int>& coupler_ends,
+                     const vector<double>& coupler_deltas, const int num_threads) {
+        vector<int8_t> states(descent.states(), descent.states() + num_samples * num_vars);
+
+        for (size_t i = 0; i < linear_vars.size(); i++) linear[linear_vars[i]] += linear_deltas[i];
+        starts.insert(starts.end(), coupler_starts.begin(), coupler_starts.end());
+        ends.insert(ends.end(), coupler_ends.begin(), coupler_ends.end());
+        weights.insert(weights.end(), coupler_deltas.begin(), coupler_deltas.end());
+        const IsingGraph graph = build_ising_graph(linear, starts, ends, weights);
+
+        descent.update(linear_vars, linear_deltas, coupler_starts, coupler_ends,
+                       coupler_deltas, num_steps.data(), num_threads);
+
+        vector<double> energies(num_samples);
+        vector<unsigned> full_steps(num_samples);
+        steepest_gradient_descent(states.data(), energies.data(), full_steps.data(),
+                                  num_samples, graph, IndexedHeap);
+
+        CHECK(vector<int8_t>(descent.states(), descent.states() + num_samples * num_vars) == states);
+        CHECK(num_steps == full_steps);
+        for (int s = 0; s < num_samples; s++) {
+            CHECK(descent.energies()[s] == Approx(energies[s]));
+            CHECK(descent.energies()[s] == Approx(
+                get_state_energy(states.data() + s * num_vars, graph.linear, graph.adjacency)));
+        }
+    };
+
+    SECTION("linear biases") {
+        check({3, 17, 3}, {2.5, -1.0, 0.5}, {}, {}, {}, 1);
+        check({0}, {-4.0}, {}, {}, {}, 2);
+    }
+    SECTION("existing and new couplers") {
+        check({}, {}, {1, 8, 20}, {2, 1, 21}, {-3.0, 2.0, 0.5}, 1);
+        check({5}, {1.0}, {0, 30, 30}, {20, 10, 10}, {-2.0, 1.0, 1.5}, 3);
+        check({}, {}, {12}, {12}, {2.0}, 2);
+    }
+}
+
+TEST_CASE("Test DescentState errors") {
+    vector<int8_t> initial {1, 1};
+    DescentState descent(build_ising_graph(vector<double>{1, 1}, {0}, {1}, {1.0}),
+                         initial.data(), 1);
+    CHECK(descent.energies()[0] == -1);
+
+    CHECK_THROWS(descent.update({2}, {1.0}, {}, {}, {}));
+    CHECK_THROWS(descent.update({0}, {}, {}, {}, {}));
+    CHECK_THROWS(descent.update({}, {}, {0}, {-1}, {1.0}));
+    CHECK_THROWS(descent.update({}, {}, {0}, {1}, {}));
+    CHECK(descent.energies()[0] == -1);
+}
+
+TEST_CASE("Test iterated_local_search") {
+    // a sparse frustrated problem with many local minima
+    const int num_vars = 200, num_samples = 8;
+    vector<double> linear(num_vars);
+    vector<int> starts, ends;
+    vector<double> weights;
+    unsigned x = 2468;
+    auto next = [&x]() { x = x * 1103515245 + 12345; return (x >> 16) & 0x7fff; };
+    for (int v = 0; v < num_vars; v++) {
+        linear[v] = 0.1 * (v % 5) - 0.2;
+        for (int d : {1, 12, 37}) {
+            starts.push_back(v);
+            ends.push_back((v + d) % num_vars);
+            weights.push_back(next() % 2 ? 1.0 : -2.0);
+        }
+    }
+    const IsingGraph graph = build_ising_graph(linear, starts, ends, weights);
+
+    vector<int8_t> initial(num_samples * num_vars);
+    for (size_t i = 0; i < initial.size(); i++) initial[i] = (i * 7919) % 3 ? 1 : -1;
+
+    vector<int8_t> descent_states(initial);
+    vector<double> descent_energies(num_samples);
+    vector<unsigned> descent_steps(num_samples);
+    steepest_gradient_descent(descent_states.data(), descent_energies.data(),
+                              descent_steps.data(), num_samples, graph, IndexedHeap);
+
+    auto search = [&](const std::int64_t max_iterations, const int num_threads,
+                      vector<int8_t>& states, vector<double>& energies,
+                      vector<unsigned>& num_steps) {
+        states = initial;
+        energies.assign(num_samples, 0);
+        num_steps.assign(num_samples, 0);
+        iterated_local_search(states.data(), energies.data(), num_steps.data(),
+                              num_samples, graph, 4, max_iterations,
+                              std::numeric_limits<double>::infinity(), 5, num_threads);
+    };
+
+    vector<int8_t> states;
+    vector<double> energies;
+    vector<unsigned> num_steps;
+
+    SECTION("without iterations it is a descent") {
+        search(0, 1, states, energies, num_steps);
+        CHECK(states == descent_states);
+        CHECK(num_steps == descent_steps);
+        for (int s = 0; s < num_samples; s++) CHECK(energies[s] == Approx(descent_energies[s]));
+    }
+
+    SECTION("the minima are local minima no higher than those of a descent") {
+        search(200, 1, states, energies, num_steps);
+        double total = 0, descent_total = 0;
+        for (int s = 0; s < num_samples; s++) {
+            int8_t* state = states.data() + s * num_vars;
+            CHECK(energies[s] <= descent_energies[s] + 1e-9);
+            CHECK(energies[s] == Approx(get_state_energy(state, graph.linear, graph.adjacency)));
+            CHECK(num_steps[s] >= descent_steps[s]);
+            vector<int8_t> flipped(state, state + num_vars);
+            for (int v = 0; v < num_vars; v++) {
+                flipped[v] *= -1;
+                CHECK(get_state_energy(flipped.data(), graph.linear, graph.adjacency) >=
+                      energies[s] - 1e-9);
+                flipped[v] *= -1;
+            }
+            total += energies[s];
+            descent_total += descent_energies[s];
+        }
+        CHECK(total < descent_total);
+
+        // nor do the searches depend on the number of threads
+        for (int num_threads : {2, 3, 100}) {
+            vector<int8_t> thread_states;
+            vector<double> thread_energies;
+            vector<unsigned> thread_num_steps;
+            search(200, num_threads, thread_states, thread_energies, thread_num_steps);
+            CHECK(thread_states == states);
+            CHECK(thread_energies == energies);
+            CHECK(thread_num_steps == num_steps);
+        }
+    }
+
+    SECTION("a time limit alone bounds the search") {
+        states = initial;
+        energies.assign(num_samples, 0);
+        num_steps.assign(num_samples, 0);
+        iterated_local_search(states.data(), energies.data(), num_steps.data(),
+                              num_samples, graph, 4, -1, .01, 5, 2);
+        for (int s = 0; s < num_samples; s++) CHECK(energies[s] <= descent_energies[s] + 1e-9);
+    }
+
+    SECTION("errors") {
+        states = initial;
+        energies.assign(num_samples, 0);
+        num_steps.assign(num_samples, 0);
+        CHECK_THROWS(iterated_local_search(
+            states.data(), energies.data(), num_steps.data(), num_samples, graph,
+            0, 10, std::numeric_limits<double>::infinity(), 5));
+        CHECK_THROWS(iterated_local_search(
+            states.data(), energies.data(), num_steps.data(), num_samples, graph,
+            4, -1, std::numeric_limits<double>::infinity(), 5));
+        CHECK(states == initial);
+    }
+}
@@ -0,0 +1,209 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "../Catch2/single_include/catch2/catch.hpp"
+#include "matching.h"
+#include "planar.h"
+#include "rng.h"
+
+namespace {
+
+// The weight of the heaviest perfect matching of the vertices not in `used`,
+// by exhaustive search
+double brute_force_matching(int num_vertices, const std::vector<int>& starts,
+                            const std::vector<int>& ends, const std::vector<double>& weights,
+                            std::vector<char>& used) {
+    int v = 0;
+    while (v < num_vertices && used[v]) v++;
+    if (v == num_vertices) return 0;
+
+    double best = -std::numeric_limits<double>::infinity();
+    used[v] = 1;
+    for (std::size_t k = 0; k < weights.size(); k++) {
+        int w = -1;
+        if (starts[k] == v) w = ends[k];
+        else if (ends[k] == v) w = starts[k];
+        if (w < 0 || w == v || used[w]) continue;
+        used[w] = 1;
+        best = std::max(best, weights[k] + brute_force_matching(num_vertices, starts, ends, weights, used));
+        used[w] = 0;
+    }
+    used[v] = 0;
+    return best;
+}
+
+// A triangulated side x side grid, the lattice of the sampler tests
+struct Lattice {
+    int num_nodes;
+    std::vector<int> starts, ends;
+    std::vector<double> couplings, x, y;
+
+    Lattice(int side, std::uint64_t seed) : num_nodes(side * side) {
+        StreamRng rng(seed);
+        for (int i = 0; i < side; i++) {
+            for (int j = 0; j < side; j++) {
+                x.push_back(i);
+                y.push_back(j);
+                const int u = i * side + j;
+                auto add = [&](int v) {
+                    starts.push_back(u);
+                    ends.push_back(v);
+                    couplings.push_back(rng.below(2) ? 1 : -1);
+                };
+                if (i + 1 < side) add(u + side);
+                if (j + 1 < side) add(u + 1);
+                if (i + 1 < side && j + 1 < side) add(u + side + 1);
+            }
+        }
+    }
+
+    std::vector<double> weights() const {
+        std::vector<double> w;
+        for (double c : couplings) w.push_back(-2 * c);
+        return w;
+    }
+
+    double energy(const std::vector<std::int8_t>& binary) const {
+        double e = 0;
+        for (std::size_t k = 0; k < couplings.size(); k++) {
+            e += couplings[k] * (2 * binary[starts[k]] - 1) * (2 * binary[ends[k]] - 1);
+        }
+        return e;
+    }
+
+    double brute_force_energy() const {
+        double best = std::numeric_limits<double>::infinity();
+        std::vector<std::int8_t> binary(num_nodes);
+        for (long s = 0; s < (1L << num_nodes); s++) {
+            for (int v = 0; v < num_nodes; v++) binary[v] = (s >> v) & 1;
+            best = std::min(best, energy(binary));
+        }
+        return best;
+    }
+};
+
+}  // namespace
+
+
+TEST_CASE("Test max_weight_perfect_matching") {
+    SECTION("a path of three edges matches its ends") {
+        std::vector<int> starts {0, 1, 2}, ends {1, 2, 3};
+        std::vector<double> weights {1, 5, 1};
+        auto matched = max_weight_perfect_matching(4, starts, ends, weights);
+        CHECK(matched == std::vector<int> {0, 0, 2, 2});
+    }
+
+    SECTION("a graph without a perfect matching is rejected") {
+        std::vector<int> starts {0, 0, 0}, ends {1, 2, 3};
+        std::vector<double> weights {1, 1, 1};
+        CHECK_THROWS_AS(max_weight_perfect_matching(4, starts, ends, weights), std::runtime_error);
+        CHECK_THROWS_AS(max_weight_perfect_matching(3, {0, 1}, {1, 2}, {1, 1}), std::runtime_error);
+    }
+
+    SECTION("the matching is as heavy as the heaviest perfect matching") {
+        StreamRng rng(11);
+        for (int trial = 0; trial < 200; trial++) {
+            const int num_vertices = 2 + 2 * rng.below(5);
+            std::vector<int> starts, ends;
+            std::vector<double> weights;
+            // a cycle, so that there is a perfect matching, and random chords
+            for (int v = 0; v < num_vertices; v++) {
+                starts.push_back(v);
+                ends.push_back((v + 1) % num_vertices);
+                weights.push_back((double)rng.below(7) - 3);
+            }
+            for (int c = 0; c < num_vertices; c++) {
+                int u = rng.below(num_vertices), v = rng.below(num_vertices);
+                if (u == v) continue;
+                starts.push_back(u);
+                ends.push_back(v);
+                weights.push_back((double)rng.below(7) - 3);
+            }
+
+            auto matched = max_weight_perfect_matching(num_vertices, starts, ends, weights);
+
+            double total = 0;
+            for (int v = 0; v < num_vertices; v++) {
+                const int k = matched[v];
+                const int w = starts[k] == v ? ends[k] : starts[k];
+                REQUIRE((starts[k] == v || ends[k] == v));
+                REQUIRE(matched[w] == k);
+                total += weights[k];
+            }
+            std::vector<char> used(num_vertices, 0);
+            REQUIRE(total / 2 == brute_force_matching(num_vertices, starts, ends, weights, used));
+        }
+    }
+}
+
+TEST_CASE("Test RotationSystem") {
+    SECTION("a square is triangulated with a chord") {
+        // 0 -- 1
+        // |    |
+        // 3 -- 2
+        RotationSystem graph(4, {0, 1, 2, 3}, {1, 2, 3, 0}, {0, 1, 1, 0}, {1, 1, 0, 0});
+        CHECK_FALSE(graph.is_triangulated());
+        graph.triangulate();
+        CHECK(graph.is_triangulated());
+        CHECK(graph.num_edges() > 4);
+    }
+
+    SECTION("too few nodes are rejected") {
+        RotationSystem graph(2, {0}, {1}, {0, 1}, {0, 0});
+        CHECK_THROWS_AS(graph.triangulate(), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Test planar_ground_state") {
+    SECTION("a frustrated triangle") {
+        std::vector<std::int8_t> state(3);
+        planar_ground_state(state.data(), 3, {0, 1, 2}, {1, 2, 0}, {-2, -2, -2},
+                            {0, 1, 0}, {0, 0, 1});
+        CHECK(state[0] == 0);
+        // not all equal
+        CHECK((state[1] || state[2]));
+    }
+
+    SECTION("the ground states of random lattices") {
+        for (int side : {3, 4}) {
+            for (std::uint64_t seed = 0; seed < 5; seed++) {
+                Lattice lattice(side, seed);
+                std::vector<std::int8_t> state(lattice.num_nodes);
+                planar_ground_state(state.data(), lattice.num_nodes, lattice.starts, lattice.ends,
+                                    lattice.weights(), lattice.x, lattice.y);
+                REQUIRE(lattice.energy(state) == lattice.brute_force_energy());
+            }
+        }
+    }
+
+    SECTION("a large lattice is consistent") {
+        Lattice lattice(60, 3);
+        std::vector<std::int8_t> state(lattice.num_nodes);
+        planar_ground_state(state.data(), lattice.num_nodes, lattice.starts, lattice.ends,
+                            lattice.weights(), lattice.x, lattice.y);
+        // no single flip lowers the energy of a ground state
+        const double energy = lattice.energy(state);
+        for (int v = 0; v < lattice.num_nodes; v += 97) {
+            state[v] ^= 1;
+            REQUIRE(lattice.energy(state) >= energy);
+            state[v] ^= 1;
+        }
+    }
+}
@@ -0,0 +1,115 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../Catch2/single_include/catch2/catch.hpp"
+#include "pool.h"
+
+
+TEST_CASE("Test WorkerPool") {
+    WorkerPool pool(4);
+    CHECK(pool.num_threads() == 4);
+
+    SECTION("the work claimed from a counter is all done") {
+        const int num_items = 10000;
+        std::vector<int> done(num_items, 0);
+        std::atomic<int> next(0);
+        auto body = [&]() {
+            for (int i; (i = next++) < num_items;) done[i]++;
+        };
+        pool.run(5, body);
+        for (int i = 0; i < num_items; i++) REQUIRE(done[i] == 1);
+    }
+
+    SECTION("nested loops complete when no worker is free") {
+        const int num_outer = 16, num_inner = 100;
+        std::atomic<int> total(0);
+        std::atomic<int> outer(0);
+        auto body = [&]() {
+            while (outer++ < num_outer) {
+                std::atomic<int> inner(0);
+                auto inner_body = [&]() {
+                    while (inner++ < num_inner) total++;
+                };
+                pool.run(5, inner_body);
+            }
+        };
+        pool.run(5, body);
+        CHECK(total == num_outer * num_inner);
+    }
+
+    SECTION("the exception of a call is rethrown") {
+        std::atomic<int> calls(0);
+        auto body = [&]() {
+            if (calls++ == 0) throw std::runtime_error("body");
+        };
+        CHECK_THROWS_AS(pool.run(3, body), std::runtime_error);
+
+        // the pool is still usable
+        std::atomic<int> next(0);
+        auto count = [&]() { while (next++ < 100) {} };
+        pool.run(3, count);
+        CHECK(next >= 100);
+    }
+
+    SECTION("the pool cannot be configured by its tasks") {
+        const std::thread::id caller = std::this_thread::get_id();
+        std::atomic<int> thrown(0);
+        auto body = [&]() {
+            if (std::this_thread::get_id() == caller) {
+                // wait for the call of the worker
+                while (thrown == 0) std::this_thread::yield();
+            } else {
+                try {
+                    pool.configure(2, false);
+                } catch (const std::logic_error&) {
+                    thrown++;
+                }
+            }
+        };
+        pool.run(2, body);
+        CHECK(thrown == 1);
+
+        pool.configure(2, false);
+        CHECK(pool.num_threads() == 2);
+        CHECK_FALSE(pool.pinned());
+    }
+
+    SECTION("loops run on the threads of the installed pool") {
+        set_worker_pool(&pool);
+        CHECK(&worker_pool() == &pool);
+
+        std::atomic<int> next(0);
+        std::vector<std::thread::id> ids(1000);
+        auto body = [&]() {
+            for (int i; (i = next++) < 1000;) ids[i] = std::this_thread::get_id();
+        };
+        run_parallel(4, body);
+        set_worker_pool(nullptr);
+        CHECK(&worker_pool() != &pool);
+        for (auto &id : ids) CHECK(id != std::thread::id());
+    }
+
+    SECTION("a loop of one thread runs on the calling thread") {
+        std::vector<std::thread::id> ids;
+        auto body = [&]() { ids.push_back(std::this_thread::get_id()); };
+        run_parallel(1, body);
+        REQUIRE(ids.size() == 1);
+        CHECK(ids[0] == std::this_thread::get_id());
+    }
+}
@@ -0,0 +1,180 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "../Catch2/single_include/catch2/catch.hpp"
+#include "random_sampler.h"
+#include "mock_bqm.h"
+
+namespace {
+
+const double inf = std::numeric_limits<double>::infinity();
+
+// a frustrated loop of `n` variables with some linear biases
+MockBQM loop_bqm(int n) {
+    MockBQM bqm(n);
+    for (int v = 0; v < n; v++) {
+        bqm.add_linear(v, (v % 3) - 1.0);
+        bqm.add_quadratic(v, (v + 1) % n, v % 2 ? 1.5 : -0.5);
+    }
+    bqm.add_offset(2.0);
+    return bqm;
+}
+
+double energy(const MockBQM& bqm, const std::int8_t* state) {
+    double e = bqm.offset();
+    for (int v = 0; v < bqm.num_variables(); v++) {
+        e += bqm.linear(v) * state[v];
+        for (auto it = bqm.cbegin_neighborhood(v); it != bqm.cend_neighborhood(v); ++it) {
+            if (it->v < v) e += it->bias * state[v] * state[it->v];
+        }
+    }
+    return e;
+}
+
+}  // anonymous namespace
+
+
+TEST_CASE("Test random_sample energies") {
+    const int n = 70, num_reads = 150;
+    MockBQM bqm = loop_bqm(n);
+
+    for (bool is_spin : {true, false}) {
+        std::vector<std::int8_t> states(num_reads * n);
+        std::vector<double> energies(num_reads);
+        std::int64_t num_kept = 0;
+
+        std::int64_t num_drawn = random_sample(
+            states.data(), energies.data(), &num_kept, bqm, is_spin,
+            num_reads, inf, num_reads, 5
+        );
+
+        CHECK(num_drawn == num_reads);
+        REQUIRE(num_kept == num_reads);
+        for (int i = 0; i < num_reads; i++) {
+            const std::int8_t* state = states.data() + i * n;
+            for (int v = 0; v < n; v++) {
+                CHECK((state[v] == 1 || state[v] == (is_spin ? -1 : 0)));
+            }
+            CHECK(energies[i] == Approx(energy(bqm, state)));
+        }
+    }
+}
+
+TEST_CASE("Test random_sample threads agree") {
+    const int n = 20, num_reads = 1000;
+    MockBQM bqm = loop_bqm(n);
+
+    std::vector<std::int8_t> states(num_reads * n), threaded_states(num_reads * n);
+    std::vector<double> energies(num_reads), threaded_energies(num_reads);
+    std::int64_t num_kept, threaded_num_kept;
+
+    random_sample(states.data(), energies.data(), &num_kept, bqm, true,
+                  num_reads, inf, num_reads, 11, 1);
+    random_sample(threaded_states.data(), threaded_energies.data(), &threaded_num_kept, bqm, true,
+                  num_reads, inf, num_reads, 11, 4);
+
+    CHECK(num_kept == threaded_num_kept);
+    CHECK(states == threaded_states);
+    CHECK(energies == threaded_energies);
+}
+
+TEST_CASE("Test random_sample keeps the lowest energy samples") {
+    const int n = 20, num_reads = 1000, max_num_samples = 10;
+    MockBQM bqm = loop_bqm(n);
+
+    std::vector<std::int8_t> all_states(num_reads * n);
+    std::vector<double> all_energies(num_reads);
+    std::int64_t num_kept;
+    random_sample(all_states.data(), all_energies.data(), &num_kept, bqm, true,
+                  num_reads, inf, num_reads, 3);
+
+    // the lowest energy samples, ties broken by the order they are drawn in
+    std::vector<int> order(num_reads);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return all_energies[a] < all_energies[b]; });
+    order.resize(max_num_samples);
+    std::sort(order.begin(), order.end());
+
+    for (int num_threads : {1, 3}) {
+        std::vector<std::int8_t> states(max_num_samples * n);
+        std::vector<double> energies(max_num_samples);
+
+        std::int64_t num_drawn = random_sample(
+            states.data(), energies.data(), &num_kept, bqm, true,
+            num_reads, inf, max_num_samples, 3, num_threads
+        );
+
+        CHECK(num_drawn == num_reads);
+        REQUIRE(num_kept == max_num_samples);
+        for (int i = 0; i < max_num_samples; i++) {
+            CHECK(energies[i] == all_energies[order[i]]);
+            CHECK(std::equal(states.begin() + i * n, states.begin() + (i + 1) * n,
+                             all_states.begin() + order[i] * n));
+        }
+    }
+}
+
+TEST_CASE("Test random_sample time limit") {
+    MockBQM bqm = loop_bqm(10);
+
+    std::vector<std::int8_t> states(5 * 10);
+    std::vector<double> energies(5);
+    std::int64_t num_kept;
+
+    std::int64_t num_drawn = random_sample(
+        states.data(), energies.data(), &num_kept, bqm, false,
+        std::numeric_limits<std::int64_t>::max(), .01, 5, 1
+    );
+
+    CHECK(num_kept == 5);
+    CHECK(num_drawn > 5);
+}
+
+TEST_CASE("Test random_sample_packed") {
+    const int n = 21, num_reads = 300, max_num_samples = 40;
+    MockBQM bqm = loop_bqm(n);
+    const std::size_t row_bytes = packed_row_bytes(n);
+    REQUIRE(row_bytes == 3);
+
+    for (bool is_spin : {true, false}) {
+        std::vector<std::int8_t> states(max_num_samples * n);
+        std::vector<std::uint8_t> packed(max_num_samples * row_bytes);
+        std::vector<double> energies(max_num_samples), packed_energies(max_num_samples);
+        std::int64_t num_kept, packed_num_kept;
+
+        random_sample(states.data(), energies.data(), &num_kept, bqm, is_spin,
+                      num_reads, inf, max_num_samples, 9);
+        random_sample_packed(packed.data(), packed_energies.data(), &packed_num_kept, bqm, is_spin,
+                             num_reads, inf, max_num_samples, 9, 2);
+
+        REQUIRE(packed_num_kept == num_kept);
+        CHECK(packed_energies == energies);
+
+        std::vector<std::uint8_t> row(row_bytes);
+        std::vector<std::int8_t> unpacked(max_num_samples * n);
+        for (int i = 0; i < num_kept; i++) {
+            pack_state(states.data() + i * n, n, row.data());
+            CHECK(std::equal(row.begin(), row.end(), packed.begin() + i * row_bytes));
+        }
+        unpack_states(packed.data(), num_kept, n, is_spin, unpacked.data(), n);
+        CHECK(unpacked == states);
+    }
+}
@@ -0,0 +1,83 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "../Catch2/single_include/catch2/catch.hpp"
+#include "read_queue.h"
+
+
+TEST_CASE("Test ReadQueue") {
+    SECTION("reads are popped in the order they are pushed") {
+        ReadQueue queue(5);
+        CHECK(queue.capacity() == 8);
+
+        for (int read = 0; read < 8; read++) CHECK(queue.try_push(read));
+        CHECK_FALSE(queue.try_push(8));
+
+        int reads[16];
+        CHECK(queue.pop(reads, 3, 0) == 3);
+        CHECK(queue.pop(reads + 3, 16, 0) == 5);
+        for (int read = 0; read < 8; read++) CHECK(reads[read] == read);
+
+        // empty, so the pop times out
+        CHECK(queue.pop(reads, 16, .001) == 0);
+    }
+
+    SECTION("every read pushed by many producers is popped once") {
+        const int num_producers = 4, reads_per_producer = 5000;
+        ReadQueue queue(16);
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p < num_producers; p++) {
+            producers.emplace_back([&queue, p]() {
+                for (int i = 0; i < reads_per_producer; i++) {
+                    REQUIRE(queue.push(p * reads_per_producer + i));
+                }
+            });
+        }
+        std::thread finisher([&]() {
+            for (auto &p : producers) p.join();
+            queue.finish();
+        });
+
+        std::vector<int> popped;
+        int reads[7];
+        for (;;) {
+            // the queue is drained once a pop after it finished finds nothing
+            const bool finished = queue.finished();
+            const std::size_t num_popped = queue.pop(reads, 7, 1);
+            if (!num_popped && finished) break;
+            popped.insert(popped.end(), reads, reads + num_popped);
+        }
+        finisher.join();
+
+        std::sort(popped.begin(), popped.end());
+        REQUIRE(popped.size() == num_producers * reads_per_producer);
+        for (int read = 0; read < (int)popped.size(); read++) CHECK(popped[read] == read);
+    }
+
+    SECTION("closing the queue releases waiting producers") {
+        ReadQueue queue(2);
+        CHECK(queue.push(0));
+        CHECK(queue.push(1));
+
+        std::thread producer([&]() { CHECK_FALSE(queue.push(2)); });
+        queue.close();
+        producer.join();
+        CHECK(queue.closed());
+    }
+}
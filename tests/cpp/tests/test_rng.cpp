@@ -0,0 +1,73 @@
+// Copyright 2026 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "../Catch2/single_include/catch2/catch.hpp"
+#include "rng.h"
+
+
+TEST_CASE("Test StreamRng") {
+    SECTION("a stream only depends on its seed and index") {
+        StreamRng a(5, 3), b(5, 3);
+        std::uint64_t state[2];
+        seed_stream(state, 5, 3);
+        for (int i = 0; i < 100; i++) {
+            const std::uint64_t x = a();
+            CHECK(x == b());
+            CHECK(x == xorshift128p(state));
+        }
+    }
+
+    SECTION("the streams of a seed differ") {
+        std::set<std::uint64_t> first_outputs;
+        for (std::uint64_t stream = 0; stream < 1000; stream++) {
+            first_outputs.insert(StreamRng(5, stream)());
+        }
+        first_outputs.insert(StreamRng(6, 0)());
+        CHECK(first_outputs.size() == 1001);
+    }
+
+    SECTION("uniform and below stay in range") {
+        StreamRng rng(11);
+        std::vector<int> counts(7, 0);
+        double sum = 0;
+        const int n = 70000;
+        for (int i = 0; i < n; i++) {
+            const double u = rng.uniform();
+            REQUIRE(u >= 0);
+            REQUIRE(u < 1);
+            sum += u;
+
+            const std::uint64_t k = rng.below(7);
+            REQUIRE(k < 7);
+            counts[k]++;
+        }
+        CHECK(sum / n == Approx(.5).margin(.01));
+        for (int count : counts) CHECK(count == Approx(n / 7).epsilon(.05));
+    }
+
+    SECTION("it works with the standard distributions") {
+        StreamRng rng(13);
+        std::uniform_int_distribution<int> die(1, 6);
+        for (int i = 0; i < 100; i++) {
+            const int x = die(rng);
+            REQUIRE(x >= 1);
+            REQUIRE(x <= 6);
+        }
+    }
+}
@@ -0,0 +1,1208 @@
+// Copyright 2022 D-Wave Systems Inc.
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../Catch2/single_include/catch2/catch.hpp"
+#include "cpu_sa.h"
+#include "mock_bqm.h"
+
+
+namespace {
+
+// frustrated ring of `num_vars` spins
+struct Ring {
+    int num_vars;
+    std::vector<double> h;
+    std::vector<int> coupler_starts;
+    std::vector<int> coupler_ends;
+    std::vector<double> coupler_weights;
+
+    explicit Ring(int num_vars) : num_vars(num_vars), h(num_vars, 0.1) {
+        for (int v = 0; v < num_vars; v++) {
+            coupler_starts.push_back(v);
+            coupler_ends.push_back((v + 1) % num_vars);
+            coupler_weights.push_back(v % 3 ? 1.0 : -1.0);
+        }
+    }
+
+    int sample(std::vector<std::int8_t> &states, std::vector<double> &energies,
+               int num_samples, int num_threads,
+               callback interrupt_callback = nullptr,
+               void *interrupt_function = nullptr) const {
+        states.assign(num_samples * num_vars, 1);
+        energies.assign(num_samples, 0);
+        std::vector<double> beta_schedule {0.1, 0.5, 1.0, 2.0, 4.0};
+        return general_simulated_annealing(
+            states.data(), energies.data(), num_samples, h,
+            coupler_starts, coupler_ends, coupler_weights,
+            10, beta_schedule, 1234, Random, Metropolis,
+            interrupt_callback, interrupt_function, num_threads);
+    }
+};
+
+bool interrupt_after_three(void * const function) {
+    int *count = static_cast<int*>(function);
+    return ++(*count) >= 3;
+}
+
+}  // namespace
+
+
+TEST_CASE("Test general_simulated_annealing num_threads") {
+    Ring ring(50);
+    int num_samples = 40;
+
+    std::vector<std::int8_t> states;
+    std::vector<double> energies;
+    REQUIRE(ring.sample(states, energies, num_samples, 1) == num_samples);
+
+    SECTION("samples do not depend on the number of threads") {
+        for (int num_threads : {2, 3, 8, 100}) {
+            std::vector<std::int8_t> parallel_states;
+            std::vector<double> parallel_energies;
+            REQUIRE(ring.sample(parallel_states, parallel_energies,
+                                num_samples, num_threads) == num_samples);
+            CHECK(parallel_states == states);
+            CHECK(parallel_energies == energies);
+        }
+    }
+
+    SECTION("interrupted samples are a prefix") {
+        int count = 0;
+        std::vector<std::int8_t> parallel_states;
+        std::vector<double> parallel_energies;
+        int num_taken = ring.sample(parallel_states, parallel_energies,
+                                    num_samples, 4, interrupt_after_three,
+                                    &count);
+
+        // samples already in progress are finished, so we may get more than
+        // three back, but the interrupt function is only polled until it
+        // returns true
+        CHECK(count == 3);
+        REQUIRE(num_taken >= 3);
+        REQUIRE(num_taken <= num_samples);
+        for (int i = 0; i < num_taken * ring.num_vars; i++) {
+            CHECK(parallel_states[i] == states[i]);
+        }
+    }
+}
+
+TEST_CASE("Test build_adjacency") {
+    // bqm ~ {(0, 1): 1, (1, 2): 2, (2, 0): 3, (0, 3): 4}
+    std::vector<int> coupler_starts {0, 1, 2, 0};
+    std::vector<int> coupler_ends {1, 2, 0, 3};
+    std::vector<double> coupler_weights {1, 2, 3, 4};
+
+    Adjacency adj = build_adjacency(5, coupler_starts, coupler_ends,
+                                    coupler_weights);
+
+    REQUIRE(adj.offsets == std::vector<int>{0, 3, 5, 7, 8, 8});
+    CHECK(adj.degree(0) == 3);
+    CHECK(adj.degree(4) == 0);
+
+    // neighbors are stored in coupler order
+    std::vector<std::int32_t> vars;
+    std::vector<double> weights;
+    for (const Neighbor *n = adj.begin(0); n != adj.end(0); n++) {
+        vars.push_back(n->var);
+        weights.push_back(n->weight);
+    }
+    CHECK(vars == std::vector<std::int32_t>{1, 2, 3});
+    CHECK(weights == std::vector<double>{1, 3, 4});
+
+    SECTION("invalid couplers") {
+        std::vector<int> bad_ends {1, 2, 0, 5};
+        CHECK_THROWS_AS(build_adjacency(5, coupler_starts, bad_ends,
+                                        coupler_weights), std::runtime_error);
+        std::vector<double> short_weights {1, 2};
+        CHECK_THROWS_AS(build_adjacency(5, coupler_starts, coupler_ends,
+                                        short_weights), std::runtime_error);
+    }
+}
+
+TEST_CASE("Test general_simulated_annealing multi_spin") {
+    // anneals with a fixed beta, starting from all +1
+    auto sample = [](const std::vector<double> &h,
+                     const std::vector<int> &coupler_starts,
+                     const std::vector<int> &coupler_ends,
+                     const std::vector<double> &coupler_weights,
+                     std::vector<std::int8_t> &states,
+                     std::vector<double> &energies,
+                     int num_samples, double beta, int num_sweeps,
+                     Proposal proposal, bool multi_spin) {
+        states.assign(num_samples * h.size(), 1);
+        energies.assign(num_samples, 0);
+        std::vector<double> beta_schedule(num_sweeps, beta);
+        return general_simulated_annealing(
+            states.data(), energies.data(), num_samples, h,
+            coupler_starts, coupler_ends, coupler_weights,
+            1, beta_schedule, 5678, Sequential, proposal,
+            nullptr, nullptr, 1, multi_spin);
+    };
+
+    std::vector<std::int8_t> states;
+    std::vector<double> energies;
+
+    SECTION("independent spins are sampled from the Boltzmann distribution") {
+        std::vector<double> h {1, -2, 3};
+        std::vector<int> empty;
+        std::vector<double> no_weights;
+        int num_samples = 64 * 100;  // not all that many for a statistical test
+        double beta = .25;
+
+        for (Proposal proposal : {Metropolis, Gibbs}) {
+            REQUIRE(sample(h, empty, empty, no_weights, states, energies,
+                           num_samples, beta, 10, proposal, true) == num_samples);
+
+            for (int v = 0; v < 3; v++) {
+                int num_up = 0;
+                for (int i = 0; i < num_samples; i++) {
+                    num_up += states[i * 3 + v] > 0;
+                }
+                double expected = 1 / (1 + exp(2 * beta * h[v]));
+                CHECK(num_up / (double)num_samples == Approx(expected).margin(.02));
+            }
+        }
+    }
+
+    SECTION("coupled spins are sampled from the Boltzmann distribution") {
+        // bqm ~ {(0, 1): -2, (1, 2): 1}, {0: 1}
+        std::vector<double> h {1, 0, 0};
+        std::vector<int> coupler_starts {0, 1};
+        std::vector<int> coupler_ends {1, 2};
+        std::vector<double> coupler_weights {-2, 1};
+        int num_samples = 64 * 100;
+        double beta = .3;
+
+        REQUIRE(sample(h, coupler_starts, coupler_ends, coupler_weights,
+                       states, energies, num_samples, beta, 20, Gibbs,
+                       true) == num_samples);
+
+        // compare the empirical distribution to the exact one
+        std::vector<double> expected(8), observed(8, 0);
+        double z = 0;
+        for (int i = 0; i < 8; i++) {
+            int s0 = i & 1 ? 1 : -1, s1 = i & 2 ? 1 : -1, s2 = i & 4 ? 1 : -1;
+            expected[i] = exp(-beta * (s0 - 2 * s0 * s1 + s1 * s2));
+            z += expected[i];
+        }
+        for (int i = 0; i < num_samples; i++) {
+            int index = (states[i * 3] > 0) + 2 * (states[i * 3 + 1] > 0)
+                + 4 * (states[i * 3 + 2] > 0);
+            observed[index] += 1. / num_samples;
+        }
+        for (int i = 0; i < 8; i++) {
+            CHECK(observed[i] == Approx(expected[i] / z).margin(.02));
+        }
+    }
+
+    SECTION("energies match states") {
+        // frustrated, integer weighted ring
+        std::vector<double> h {1, 0, -1, 2, 0, 0, 1};
+        std::vector<int> coupler_starts {0, 1, 2, 3, 4, 5, 6};
+        std::vector<int> coupler_ends {1, 2, 3, 4, 5, 6, 0};
+        std::vector<double> coupler_weights {1, -2, 1, 3, -1, 1, 2};
+        int num_samples = 100;  // not a multiple of 64
+
+        REQUIRE(sample(h, coupler_starts, coupler_ends, coupler_weights,
+                       states, energies, num_samples, 1, 50, Metropolis,
+                       true) == num_samples);
+
+        for (int i = 0; i < num_samples; i++) {
+            double energy = 0;
+            for (int v = 0; v < 7; v++) energy += h[v] * states[i * 7 + v];
+            for (int c = 0; c < 7; c++) {
+                energy += coupler_weights[c] * states[i * 7 + coupler_starts[c]]
+                    * states[i * 7 + coupler_ends[c]];
+            }
+            CHECK(energies[i] == energy);
+        }
+    }
+
+    SECTION("falls back for non-integer biases") {
+        std::vector<double> h {.5, 0, 1};
+        std::vector<int> coupler_starts {0, 1};
+        std::vector<int> coupler_ends {1, 2};
+        std::vector<double> coupler_weights {1, -1};
+
+        std::vector<std::int8_t> scalar_states;
+        std::vector<double> scalar_energies;
+        sample(h, coupler_starts, coupler_ends, coupler_weights,
+               scalar_states, scalar_energies, 10, 1, 10, Gibbs, false);
+        sample(h, coupler_starts, coupler_ends, coupler_weights,
+               states, energies, 10, 1, 10, Gibbs, true);
+
+        CHECK(states == scalar_states);
+        CHECK(energies == scalar_energies);
+    }
+}
+
+TEST_CASE("Test greedy_coloring") {
+    // a wheel on 6 variables, variable 0 is the hub
+    std::vector<int> coupler_starts {0, 0, 0, 0, 0, 1, 2, 3, 4, 5};
+    std::vector<int> coupler_ends {1, 2, 3, 4, 5, 2, 3, 4, 5, 1};
+    std::vector<double> coupler_weights(10, 1);
+
+    Adjacency adj = build_adjacency(7, coupler_starts, coupler_ends,
+                                    coupler_weights);
+    std::vector<std::vector<int>> classes = greedy_coloring(adj);
+
+    // an odd wheel needs four colors, the isolated variable gets color 0
+    REQUIRE(classes.size() == 4);
+    CHECK(classes[0] == std::vector<int>{0, 6});
+
+    std::vector<int> color(7, -1);
+    for (int c = 0; c < (int)classes.size(); c++) {
+        for (int v : classes[c]) {
+            CHECK(color[v] == -1);
+            color[v] = c;
+        }
+    }
+    for (int c = 0; c < (int)coupler_starts.size(); c++) {
+        CHECK(color[coupler_starts[c]] != color[coupler_ends[c]]);
+    }
+}
+
+TEST_CASE("Test general_simulated_annealing Colored") {
+    // bqm ~ {(0, 1): -2, (1, 2): 1.5}, {0: 1}
+    std::vector<double> h {1, 0, 0};
+    std::vector<int> coupler_starts {0, 1};
+    std::vector<int> coupler_ends {1, 2};
+    std::vector<double> coupler_weights {-2, 1.5};
+    int num_samples = 5000;
+    double beta = .3;
+
+    std::vector<double> expected(8);
+    double z = 0;
+    for (int i = 0; i < 8; i++) {
+        int s0 = i & 1 ? 1 : -1, s1 = i & 2 ? 1 : -1, s2 = i & 4 ? 1 : -1;
+        expected[i] = exp(-beta * (s0 - 2 * s0 * s1 + 1.5 * s1 * s2));
+        z += expected[i];
+    }
+
+    for (int sweep_threads : {1, 2})
+    for (Proposal proposal : {Metropolis, Gibbs}) {
+        std::vector<std::int8_t> states(num_samples * 3, 1);
+        std::vector<double> energies(num_samples);
+        std::vector<double> beta_schedule(20, beta);
+        REQUIRE(general_simulated_annealing(
+            states.data(), energies.data(), num_samples, h,
+            coupler_starts, coupler_ends, coupler_weights,
+            1, beta_schedule, 5678, Colored, proposal,
+            nullptr, nullptr, 1, false, sweep_threads) == num_samples);
+
+        // compare the empirical distribution to the exact one
+        std::vector<double> observed(8, 0);
+        for (int i = 0; i < num_samples; i++) {
+            int index = (states[i * 3] > 0) + 2 * (states[i * 3 + 1] > 0)
+                + 4 * (states[i * 3 + 2] > 0);
+            observed[index] += 1. / num_samples;
+        }
+        for (int i = 0; i < 8; i++) {
+            CHECK(observed[i] == Approx(expected[i] / z).margin(.025));
+        }
+    }
+}
+
+TEST_CASE("Test general_simulated_annealing sweep_threads") {
+    // a grid large enough to have several blocks per color class
+    const int width = 40;
+    const int num_vars = width * width;
+    std::vector<double> h(num_vars, 0);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = (v % 7) * .1 - .3;
+        if (v % width + 1 < width) {
+            coupler_starts.push_back(v);
+            coupler_ends.push_back(v + 1);
+            coupler_weights.push_back(v % 3 ? -1 : .5);
+        }
+        if (v + width < num_vars) {
+            coupler_starts.push_back(v);
+            coupler_ends.push_back(v + width);
+            coupler_weights.push_back(v % 5 ? -1 : .5);
+        }
+    }
+
+    auto sample = [&](int sweep_threads, std::vector<std::int8_t> &states,
+                      std::vector<double> &energies) {
+        int num_samples = 3;
+        states.assign(num_samples * num_vars, 1);
+        energies.assign(num_samples, 0);
+        std::vector<double> beta_schedule {.1, .3, 1, 3};
+        return general_simulated_annealing(
+            states.data(), energies.data(), num_samples, h,
+            coupler_starts, coupler_ends, coupler_weights,
+            5, beta_schedule, 42, Colored, Metropolis,
+            nullptr, nullptr, 1, false, sweep_threads);
+    };
+
+    std::vector<std::int8_t> states;
+    std::vector<double> energies;
+    REQUIRE(sample(2, states, energies) == 3);
+
+    // the samples do not depend on the number of threads
+    for (int sweep_threads : {3, 4}) {
+        std::vector<std::int8_t> other_states;
+        std::vector<double> other_energies;
+        REQUIRE(sample(sweep_threads, other_states, other_energies) == 3);
+        CHECK(other_states == states);
+        CHECK(other_energies == energies);
+    }
+}
+
+TEST_CASE("Test bias_quantum") {
+    CHECK(bias_quantum({1, -2, 0}, {3, 4}) == 1);
+    CHECK(bias_quantum({2, 4}, {-6}) == 2);
+    CHECK(bias_quantum({.5}, {.2, -1}) == Approx(.1));
+    CHECK(bias_quantum({.25, .5}, {}) == .25);
+    CHECK(bias_quantum({1, 1.0001}, {}) == 0);
+    CHECK(bias_quantum({0, 0}, {0}) == 0);
+    CHECK(bias_quantum({}, {}) == 0);
+}
+
+TEST_CASE("Test general_simulated_annealing lookup_table") {
+    // frustrated ring with biases that are multiples of .25
+    const int num_vars = 30;
+    std::vector<double> h(num_vars);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = (v % 5 - 2) * .25;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 3 ? -1.5 : .75);
+    }
+
+    auto sample = [&](VariableOrder varorder, Proposal proposal,
+                      bool lookup_table, std::vector<std::int8_t> &states,
+                      std::vector<double> &energies) {
+        int num_samples = 10;
+        states.assign(num_samples * num_vars, 1);
+        energies.assign(num_samples, 0);
+        std::vector<double> beta_schedule {.01, .1, .5, 1, 2, 5, 10};
+        general_simulated_annealing(
+            states.data(), energies.data(), num_samples, h,
+            coupler_starts, coupler_ends, coupler_weights,
+            10, beta_schedule, 99, varorder, proposal,
+            nullptr, nullptr, 1, false, 1, lookup_table);
+    };
+
+    // with exactly representable biases the same flips are accepted
+    for (VariableOrder varorder : {Sequential, Random})
+    for (Proposal proposal : {Metropolis, Gibbs}) {
+        std::vector<std::int8_t> states, lookup_states;
+        std::vector<double> energies, lookup_energies;
+        sample(varorder, proposal, false, states, energies);
+        sample(varorder, proposal, true, lookup_states, lookup_energies);
+        CHECK(states == lookup_states);
+        CHECK(energies == lookup_energies);
+    }
+}
+
+TEST_CASE("Test AnnealingProblem") {
+    // frustrated ring with integer biases, representable by every engine
+    const int num_vars = 20;
+    std::vector<double> h(num_vars);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = v % 3 - 1;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 4 ? -1 : 2);
+    }
+
+    const AnnealingProblem problem(h, coupler_starts, coupler_ends, coupler_weights);
+    CHECK(problem.num_variables() == num_vars);
+
+    int num_samples = 70;
+    std::vector<double> beta_schedule {.1, .5, 1, 2, 5};
+
+    // repeated samples from the problem match those of
+    // general_simulated_annealing, for every engine
+    for (VariableOrder varorder : {Sequential, Random, Colored})
+    for (bool multi_spin : {false, true})
+    for (bool lookup_table : {false, true}) {
+        std::vector<std::int8_t> states(num_samples * num_vars, 1);
+        std::vector<double> energies(num_samples);
+        REQUIRE(general_simulated_annealing(
+            states.data(), energies.data(), num_samples, h,
+            coupler_starts, coupler_ends, coupler_weights,
+            5, beta_schedule, 11, varorder, Metropolis,
+            nullptr, nullptr, 1, multi_spin, 1, lookup_table) == num_samples);
+
+        for (int repeat = 0; repeat < 2; repeat++) {
+            std::vector<std::int8_t> problem_states(num_samples * num_vars, 1);
+            std::vector<double> problem_energies(num_samples);
+            REQUIRE(problem.sample(
+                problem_states.data(), problem_energies.data(), num_samples,
+                5, beta_schedule, 11, varorder, Metropolis,
+                nullptr, nullptr, 1, multi_spin, 1, lookup_table) == num_samples);
+            CHECK(problem_states == states);
+            CHECK(problem_energies == energies);
+        }
+    }
+
+    // an empty schedule leaves the initial state, all +1, unchanged
+    std::vector<std::int8_t> states(num_vars, 1);
+    std::vector<double> energies(1);
+    REQUIRE(problem.sample(states.data(), energies.data(), 1, 1, {}, 3,
+                           Sequential, Gibbs, nullptr, nullptr) == 1);
+    double energy = 0;
+    for (double bias : h) energy += bias;
+    for (double weight : coupler_weights) energy += weight;
+    CHECK(states == std::vector<std::int8_t>(num_vars, 1));
+    CHECK(energies[0] == energy);
+}
+
+TEST_CASE("Test AnnealingProblem from a binary quadratic model") {
+    Ring ring(30);
+
+    // add the couplers in the same order, so that the neighborhoods match
+    MockBQM bqm(ring.num_vars);
+    for (int v = 0; v < ring.num_vars; v++) bqm.add_linear(v, ring.h[v]);
+    for (size_t c = 0; c < ring.coupler_starts.size(); c++) {
+        bqm.add_quadratic(ring.coupler_starts[c], ring.coupler_ends[c],
+                          ring.coupler_weights[c]);
+    }
+
+    const AnnealingProblem problem(bqm);
+    REQUIRE(problem.num_variables() == ring.num_vars);
+
+    int num_samples = 10;
+    std::vector<std::int8_t> states;
+    std::vector<double> energies;
+    REQUIRE(ring.sample(states, energies, num_samples, 1) == num_samples);
+
+    std::vector<std::int8_t> bqm_states(num_samples * ring.num_vars, 1);
+    std::vector<double> bqm_energies(num_samples);
+    std::vector<double> beta_schedule {0.1, 0.5, 1.0, 2.0, 4.0};
+    REQUIRE(problem.sample(bqm_states.data(), bqm_energies.data(), num_samples,
+                           10, beta_schedule, 1234, Random, Metropolis,
+                           nullptr, nullptr) == num_samples);
+    CHECK(bqm_states == states);
+    CHECK(bqm_energies == energies);
+}
+
+TEST_CASE("Test AnnealingProblem parallel_tempering") {
+    SECTION("the coldest replica is sampled from the Boltzmann distribution") {
+        // bqm ~ {(0, 1): -2, (1, 2): 1}, {0: 1}
+        std::vector<double> h {1, 0, 0};
+        const AnnealingProblem problem(h, {0, 1}, {1, 2}, {-2, 1});
+        std::vector<double> beta_ladder {.05, .1, .2, .4};
+        double beta = beta_ladder.back();
+        int num_samples = 4000;
+
+        for (VariableOrder varorder : {Sequential, Random})
+        for (Proposal proposal : {Metropolis, Gibbs}) {
+            std::vector<std::int8_t> states(num_samples * 3, 1);
+            std::vector<double> energies(num_samples);
+            std::vector<std::int64_t> swap_accepts(3, 0);
+            REQUIRE(problem.parallel_tempering(
+                states.data(), energies.data(), num_samples, beta_ladder, 2, 10,
+                17, varorder, proposal, nullptr, nullptr, 1,
+                swap_accepts.data()) == num_samples);
+
+            std::vector<double> expected(8), observed(8, 0);
+            double z = 0;
+            for (int i = 0; i < 8; i++) {
+                int s0 = i & 1 ? 1 : -1, s1 = i & 2 ? 1 : -1, s2 = i & 4 ? 1 : -1;
+                expected[i] = exp(-beta * (s0 - 2 * s0 * s1 + s1 * s2));
+                z += expected[i];
+            }
+            for (int i = 0; i < num_samples; i++) {
+                const std::int8_t *state = states.data() + i * 3;
+                int index = (state[0] > 0) + 2 * (state[1] > 0) + 4 * (state[2] > 0);
+                observed[index] += 1. / num_samples;
+                CHECK(energies[i] == state[0] - 2 * state[0] * state[1]
+                                     + state[1] * state[2]);
+            }
+            for (int i = 0; i < 8; i++) {
+                CHECK(observed[i] == Approx(expected[i] / z).margin(.025));
+            }
+
+            // at these temperatures most swaps are accepted, and each pair is
+            // attempted in every other round
+            for (std::int64_t accepts : swap_accepts) {
+                CHECK(accepts > num_samples * 5 / 2);
+                CHECK(accepts <= num_samples * 5);
+            }
+        }
+    }
+
+    SECTION("samples do not depend on the number of threads") {
+        Ring ring(40);
+        const AnnealingProblem problem(ring.h, ring.coupler_starts,
+                                       ring.coupler_ends, ring.coupler_weights);
+        std::vector<double> beta_ladder {.1, .3, .6, 1, 2, 4};
+        int num_samples = 5;
+
+        auto sample = [&](int num_threads, std::vector<std::int8_t> &states,
+                          std::vector<double> &energies,
+                          std::vector<std::int64_t> &swap_accepts) {
+            states.assign(num_samples * ring.num_vars, 1);
+            energies.assign(num_samples, 0);
+            swap_accepts.assign(beta_ladder.size() - 1, 0);
+            return problem.parallel_tempering(
+                states.data(), energies.data(), num_samples, beta_ladder, 3, 20,
+                5, Random, Metropolis, nullptr, nullptr, num_threads,
+                swap_accepts.data());
+        };
+
+        std::vector<std::int8_t> states;
+        std::vector<double> energies;
+        std::vector<std::int64_t> swap_accepts;
+        REQUIRE(sample(1, states, energies, swap_accepts) == num_samples);
+
+        for (int num_threads : {2, 4}) {
+            std::vector<std::int8_t> other_states;
+            std::vector<double> other_energies;
+            std::vector<std::int64_t> other_swap_accepts;
+            REQUIRE(sample(num_threads, other_states, other_energies,
+                           other_swap_accepts) == num_samples);
+            CHECK(other_states == states);
+            CHECK(other_energies == energies);
+            CHECK(other_swap_accepts == swap_accepts);
+        }
+    }
+
+    SECTION("invalid arguments") {
+        const AnnealingProblem problem({0, 0}, {0}, {1}, {1});
+        std::vector<std::int8_t> states(2, 1);
+        std::vector<double> energies(1);
+        CHECK_THROWS_AS(problem.parallel_tempering(
+            states.data(), energies.data(), 1, {}, 1, 1, 1, Sequential,
+            Metropolis, nullptr, nullptr), std::runtime_error);
+        CHECK_THROWS_AS(problem.parallel_tempering(
+            states.data(), energies.data(), 1, {1}, 1, 1, 1, Colored,
+            Metropolis, nullptr, nullptr), std::runtime_error);
+    }
+}
+
+TEST_CASE("Test AnnealingProblem termination") {
+    // frustrated ring with integer biases, so that no flip at a large beta
+    // leaves the energy unchanged
+    const int num_vars = 20;
+    std::vector<double> h(num_vars);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = v % 2 ? 1 : -2;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 4 ? -4 : 5);
+    }
+    const AnnealingProblem problem(h, coupler_starts, coupler_ends, coupler_weights);
+
+    const int num_samples = 10;
+    auto sample = [&](const int sweeps_per_beta,
+                      const std::vector<double> &beta_schedule,
+                      const VariableOrder varorder, const bool multi_spin,
+                      const int sweep_threads, const Termination &termination,
+                      std::vector<std::int8_t> &states,
+                      std::vector<double> &energies) {
+        states.assign(num_samples * num_vars, 1);
+        energies.assign(num_samples, 0);
+        return problem.sample(states.data(), energies.data(), num_samples,
+                              sweeps_per_beta, beta_schedule, 5, varorder,
+                              Metropolis, nullptr, nullptr, 1, multi_spin,
+                              sweep_threads, false, termination);
+    };
+
+    SECTION("reaching the target energy ends a sample after the sweep") {
+        // every state reaches a target above the largest energy
+        Termination termination;
+        termination.target_energy = 1000;
+
+        for (VariableOrder varorder : {Sequential, Random, Colored})
+        for (bool multi_spin : {false, true})
+        for (int sweep_threads : {1, 2}) {
+            std::vector<std::int8_t> states, first_sweep_states;
+            std::vector<double> energies, first_sweep_energies;
+            REQUIRE(sample(10, {.1, 1, 10}, varorder, multi_spin,
+                           sweep_threads, termination, states,
+                           energies) == num_samples);
+            REQUIRE(sample(1, {.1}, varorder, false, sweep_threads,
+                           Termination(), first_sweep_states,
+                           first_sweep_energies) == num_samples);
+            CHECK(states == first_sweep_states);
+            CHECK(energies == first_sweep_energies);
+        }
+    }
+
+    SECTION("stalled samples end") {
+        // at a large beta each sample quickly gets stuck in a local minimum,
+        // so ending it once stalled gives the same result as the full run
+        Termination termination;
+        termination.stall_sweeps = 5;
+
+        for (VariableOrder varorder : {Sequential, Colored}) {
+            std::vector<std::int8_t> states, full_states;
+            std::vector<double> energies, full_energies;
+            REQUIRE(sample(100000000, {100}, varorder, false, 1, termination,
+                           states, energies) == num_samples);
+            REQUIRE(sample(200, {100}, varorder, false, 1, Termination(),
+                           full_states, full_energies) == num_samples);
+            CHECK(states == full_states);
+            CHECK(energies == full_energies);
+        }
+    }
+
+    SECTION("samples end after the time limit") {
+        Termination termination;
+        termination.time_limit = .01;
+
+        // a sample would take many seconds without the time limit
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::int8_t> states;
+        std::vector<double> energies;
+        REQUIRE(sample(100000000, {.1}, Random, false, 1, termination,
+                       states, energies) == num_samples);
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        CHECK(elapsed.count() < 2);
+
+        // the energies are still those of the states
+        for (int s = 0; s < num_samples; s++) {
+            double energy = 0;
+            for (int v = 0; v < num_vars; v++) {
+                const std::int8_t *sample_state = &states[s * num_vars];
+                energy += h[v] * sample_state[v] + coupler_weights[v] *
+                    sample_state[v] * sample_state[(v + 1) % num_vars];
+            }
+            CHECK(energies[s] == Approx(energy));
+        }
+    }
+}
+
+TEST_CASE("Test AnnealingProblem descend") {
+    // frustrated ring with integer biases, representable by every engine
+    const int num_vars = 30;
+    std::vector<double> h(num_vars);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = v % 3 - 1;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 4 ? -1 : 2);
+    }
+
+    const AnnealingProblem problem(h, coupler_starts, coupler_ends, coupler_weights);
+
+    const int num_samples = 70;
+    // a hot schedule, so that the annealed states are not local minima
+    std::vector<double> beta_schedule {.01, .05};
+
+    // the fused descent matches steepest_gradient_descent on the annealed
+    // states, for every engine and solver
+    for (VariableOrder varorder : {Sequential, Random, Colored})
+    for (bool multi_spin : {false, true})
+    for (int sweep_threads : {1, 2})
+    for (DescentSolver solver : {LinearSearch, OrderedSet, IndexedHeap}) {
+        std::vector<std::int8_t> states(num_samples * num_vars, 1);
+        std::vector<double> energies(num_samples);
+        REQUIRE(problem.sample(
+            states.data(), energies.data(), num_samples,
+            2, beta_schedule, 5, varorder, Metropolis,
+            nullptr, nullptr, 1, multi_spin, sweep_threads) == num_samples);
+
+        std::vector<double> descent_energies(num_samples);
+        std::vector<unsigned> num_steps(num_samples);
+        steepest_gradient_descent(states.data(), descent_energies.data(),
+                                  num_steps.data(), num_samples, h,
+                                  coupler_starts, coupler_ends, coupler_weights);
+        unsigned total_steps = 0;
+        for (unsigned steps : num_steps) total_steps += steps;
+        CHECK(total_steps > 0);
+
+        std::vector<std::int8_t> fused_states(num_samples * num_vars, 1);
+        std::vector<double> fused_energies(num_samples);
+        REQUIRE(problem.sample(
+            fused_states.data(), fused_energies.data(), num_samples,
+            2, beta_schedule, 5, varorder, Metropolis,
+            nullptr, nullptr, 1, multi_spin, sweep_threads, false,
+            Termination(), true, solver) == num_samples);
+
+        CHECK(fused_states == states);
+        for (int s = 0; s < num_samples; s++) {
+            CHECK(fused_energies[s] == Approx(descent_energies[s]));
+        }
+    }
+}
+
+TEST_CASE("Test AnnealingProblem tracked energies") {
+    // non-integer biases, so that the energies are not exact
+    const int num_vars = 25;
+    std::vector<double> h(num_vars);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = .3 * (v % 5) - .55;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 3 ? -.7 : 1.1);
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 7) % num_vars);
+        coupler_weights.push_back(.45);
+    }
+
+    const AnnealingProblem problem(h, coupler_starts, coupler_ends, coupler_weights);
+
+    const int num_samples = 20;
+    std::vector<double> beta_schedule {.1, .5, 1, 2};
+
+    // the energies tracked over the flips of a read match the energies of
+    // the final states, for every engine
+    for (VariableOrder varorder : {Sequential, Random, Colored})
+    for (Proposal proposal : {Metropolis, Gibbs})
+    for (int sweep_threads : {1, 2})
+    for (bool descend : {false, true}) {
+        std::vector<std::int8_t> states(num_samples * num_vars, 1);
+        std::vector<double> energies(num_samples);
+        REQUIRE(problem.sample(
+            states.data(), energies.data(), num_samples,
+            5, beta_schedule, 11, varorder, proposal,
+            nullptr, nullptr, 1, false, sweep_threads, false,
+            Termination(), descend) == num_samples);
+
+        for (int s = 0; s < num_samples; s++) {
+            CHECK(energies[s] == Approx(get_state_energy(
+                states.data() + s * num_vars, h, problem.graph()->adjacency)));
+        }
+    }
+
+    for (VariableOrder varorder : {Sequential, Random}) {
+        std::vector<std::int8_t> states(num_samples * num_vars, 1);
+        std::vector<double> energies(num_samples);
+        REQUIRE(problem.parallel_tempering(
+            states.data(), energies.data(), num_samples, beta_schedule, 2, 10,
+            11, varorder, Metropolis, nullptr, nullptr) == num_samples);
+
+        for (int s = 0; s < num_samples; s++) {
+            CHECK(energies[s] == Approx(get_state_energy(
+                states.data() + s * num_vars, h, problem.graph()->adjacency)));
+        }
+    }
+}
+
+TEST_CASE("Test AnnealingProblem completed reads") {
+    const int num_vars = 20;
+    std::vector<double> h(num_vars);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = v % 3 - 1;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 4 ? -1 : 2);
+    }
+
+    const AnnealingProblem problem(h, coupler_starts, coupler_ends, coupler_weights);
+
+    const int num_samples = 150;
+    std::vector<double> beta_schedule {.1, .5, 1, 2};
+
+    // every read is pushed once, after its state and energy are final, and
+    // streaming the reads does not change them
+    for (bool multi_spin : {false, true})
+    for (int num_threads : {1, 3}) {
+        std::vector<std::int8_t> states(num_samples * num_vars, 1);
+        std::vector<double> energies(num_samples);
+        REQUIRE(problem.sample(
+            states.data(), energies.data(), num_samples,
+            3, beta_schedule, 7, Sequential, Metropolis,
+            nullptr, nullptr, num_threads, multi_spin) == num_samples);
+
+        // a small queue, so that the sampler waits for the consumer
+        ReadQueue queue(8);
+        std::vector<std::int8_t> streamed_states(num_samples * num_vars, 1);
+        std::vector<double> streamed_energies(num_samples);
+        std::vector<std::int8_t> popped_states(num_samples * num_vars, 0);
+        std::vector<double> popped_energies(num_samples, 0);
+        std::vector<int> num_pops(num_samples, 0);
+
+        std::thread consumer([&]() {
+            int reads[5];
+            for (;;) {
+                const bool finished = queue.finished();
+                const std::size_t num_popped = queue.pop(reads, 5, 1);
+                if (!num_popped && finished) break;
+                for (std::size_t i = 0; i < num_popped; i++) {
+                    const int read = reads[i];
+                    num_pops[read]++;
+                    std::copy(streamed_states.begin() + read * num_vars,
+                              streamed_states.begin() + (read + 1) * num_vars,
+                              popped_states.begin() + read * num_vars);
+                    popped_energies[read] = streamed_energies[read];
+                }
+            }
+        });
+        const int num_taken = problem.sample(
+            streamed_states.data(), streamed_energies.data(), num_samples,
+            3, beta_schedule, 7, Sequential, Metropolis,
+            nullptr, nullptr, num_threads, multi_spin, 1, false,
+            Termination(), false, LinearSearch, &queue);
+        queue.finish();
+        consumer.join();
+
+        REQUIRE(num_taken == num_samples);
+        CHECK(num_pops == std::vector<int>(num_samples, 1));
+        CHECK(popped_states == states);
+        CHECK(popped_energies == energies);
+        CHECK(streamed_states == states);
+    }
+}
+
+TEST_CASE("Test AnnealingProblem proposal counts") {
+    // integer biases, so that every kernel can sample the problem
+    const int num_vars = 20;
+    std::vector<double> h(num_vars);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = v % 3 - 1;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 4 ? -1 : 2);
+    }
+
+    const AnnealingProblem problem(h, coupler_starts, coupler_ends, coupler_weights);
+
+    const int num_samples = 70;
+    const int sweeps_per_beta = 3;
+    // the last beta is high enough for flips to be skipped
+    std::vector<double> beta_schedule {.1, 1, 10, 100};
+
+    struct Kernel {
+        VariableOrder varorder;
+        bool multi_spin;
+        int sweep_threads;
+    };
+    for (const Kernel &kernel : {Kernel{Sequential, false, 1}, Kernel{Random, false, 1},
+                                 Kernel{Colored, false, 1}, Kernel{Colored, false, 2},
+                                 Kernel{Sequential, true, 1}})
+    for (Proposal proposal : {Metropolis, Gibbs}) {
+        std::vector<std::int8_t> states(num_samples * num_vars, 1);
+        std::vector<double> energies(num_samples);
+        REQUIRE(problem.sample(
+            states.data(), energies.data(), num_samples,
+            sweeps_per_beta, beta_schedule, 5, kernel.varorder, proposal,
+            nullptr, nullptr, 2, kernel.multi_spin, kernel.sweep_threads) == num_samples);
+
+        std::vector<ProposalCounts> counts;
+        std::vector<std::int8_t> counted_states(num_samples * num_vars, 1);
+        std::vector<double> counted_energies(num_samples);
+        REQUIRE(problem.sample(
+            counted_states.data(), counted_energies.data(), num_samples,
+            sweeps_per_beta, beta_schedule, 5, kernel.varorder, proposal,
+            nullptr, nullptr, 2, kernel.multi_spin, kernel.sweep_threads, false,
+            Termination(), false, LinearSearch, nullptr, &counts) == num_samples);
+
+        // counting does not change the samples
+        CHECK(counted_states == states);
+        CHECK(counted_energies == energies);
+
+        if (!counters_enabled) {
+            CHECK(counts.empty());
+            continue;
+        }
+
+        // every variable is proposed once per sweep
+        REQUIRE(counts.size() == beta_schedule.size());
+        for (const ProposalCounts &c : counts) {
+            CHECK(c.accepted + c.rejected + c.skipped ==
+                  (std::int64_t)num_samples * sweeps_per_beta * num_vars);
+        }
+
+        // flips are accepted less often as beta grows
+        CHECK(counts.front().accepted > counts.back().accepted);
+        if (kernel.varorder != Colored) {
+            CHECK(counts.front().skipped == 0);
+            CHECK(counts.back().skipped > 0);
+        } else {
+            for (const ProposalCounts &c : counts) CHECK(c.skipped == 0);
+        }
+    }
+}
+
+TEST_CASE("Test default_beta_range") {
+    // v0 has biases 1, 2; v1 has 2, .5; v2 has .5, .5
+    const AnnealingProblem problem({1, 0, .5}, {0, 1}, {1, 2}, {2, .5});
+
+    SECTION("from the largest and smallest biases") {
+        const auto range = problem.default_beta_range();
+        CHECK(range.first == Approx(std::log(2) / (2 * 3)));
+        // the smallest bias is that of two variables
+        CHECK(range.second == Approx(std::log(2 / .01) / (2 * .5)));
+    }
+
+    SECTION("options") {
+        CHECK(problem.default_beta_range(.01, false).second == Approx(std::log(1 / .01)));
+        CHECK(problem.default_beta_range(.1).second == Approx(std::log(2 / .1)));
+        CHECK_THROWS_AS(problem.default_beta_range(0), std::invalid_argument);
+        CHECK_THROWS_AS(problem.default_beta_range(1), std::invalid_argument);
+    }
+
+    SECTION("all biases zero") {
+        const AnnealingProblem zero({0, 0}, {0}, {1}, {0});
+        CHECK(zero.default_beta_range() == std::make_pair(0.0, 0.0));
+    }
+}
+
+TEST_CASE("Test AnnealingProblem adaptive schedule") {
+    const int num_vars = 20;
+    std::vector<double> h(num_vars);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = v % 3 - 1;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 4 ? -1 : 2);
+    }
+    const AnnealingProblem problem(h, coupler_starts, coupler_ends, coupler_weights);
+
+    const int num_samples = 10;
+    const int sweeps_per_beta = 2;
+
+    auto sample = [&](const std::vector<double> &beta_schedule, VariableOrder varorder,
+                      double min_acceptance, std::vector<std::int8_t> &states,
+                      std::vector<ProposalCounts> *counts) {
+        states.assign(num_samples * num_vars, 1);
+        std::vector<double> energies(num_samples);
+        REQUIRE(problem.sample(
+            states.data(), energies.data(), num_samples,
+            sweeps_per_beta, beta_schedule, 5, varorder, Metropolis,
+            nullptr, nullptr, 1, false, 1, false, Termination(), false, LinearSearch,
+            nullptr, counts, min_acceptance) == num_samples);
+    };
+
+    SECTION("samples that keep moving walk the whole schedule") {
+        const std::vector<double> hot(10, .01);
+        for (VariableOrder varorder : {Sequential, Random}) {
+            std::vector<std::int8_t> states, adaptive_states;
+            sample(hot, varorder, 0, states, nullptr);
+            sample(hot, varorder, 1e-6, adaptive_states, nullptr);
+            CHECK(adaptive_states == states);
+        }
+    }
+
+    SECTION("frozen samples take doubling steps to the last beta") {
+        // no step accepts more than all of its proposals
+        const std::vector<double> schedule(10, 1);
+        std::vector<std::int8_t> states;
+        std::vector<ProposalCounts> counts;
+        sample(schedule, Sequential, 2, states, &counts);
+
+        if (counters_enabled) {
+            REQUIRE(counts.size() == schedule.size());
+            const std::set<int> swept {0, 2, 6, 9};
+            for (int b = 0; b < (int)schedule.size(); b++) {
+                const std::int64_t proposals =
+                    counts[b].accepted + counts[b].rejected + counts[b].skipped;
+                CHECK(proposals == (swept.count(b) ?
+                    (std::int64_t)num_samples * sweeps_per_beta * num_vars : 0));
+            }
+        }
+    }
+
+    SECTION("requires a scalar variable order") {
+        std::vector<std::int8_t> states(num_samples * num_vars, 1);
+        std::vector<double> energies(num_samples);
+        CHECK_THROWS_AS(problem.sample(
+            states.data(), energies.data(), num_samples,
+            sweeps_per_beta, {1, 2}, 5, Colored, Metropolis,
+            nullptr, nullptr, 1, false, 1, false, Termination(), false, LinearSearch,
+            nullptr, nullptr, .1), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Test AnnealingProblem precision") {
+    // frustrated ring with biases that are multiples of .25, so that the
+    // integer delta energies are exact and so are the double ones
+    const int num_vars = 30;
+    std::vector<double> h(num_vars);
+    std::vector<int> coupler_starts, coupler_ends;
+    std::vector<double> coupler_weights;
+    for (int v = 0; v < num_vars; v++) {
+        h[v] = (v % 5 - 2) * .25;
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 1) % num_vars);
+        coupler_weights.push_back(v % 3 ? -1.5 : .75);
+        coupler_starts.push_back(v);
+        coupler_ends.push_back((v + 7) % num_vars);
+        coupler_weights.push_back(.5);
+    }
+    const AnnealingProblem problem(h, coupler_starts, coupler_ends, coupler_weights);
+
+    const int num_samples = 10;
+    std::vector<double> beta_schedule {.01, .1, .5, 1, 2, 5, 10};
+
+    auto sample = [&](const AnnealingProblem &problem, VariableOrder varorder,
+                      Proposal proposal, bool lookup_table, Precision precision,
+                      std::vector<std::int8_t> &states, std::vector<double> &energies) {
+        states.assign(num_samples * problem.num_variables(), 1);
+        energies.assign(num_samples, 0);
+        REQUIRE(problem.sample(
+            states.data(), energies.data(), num_samples,
+            20, beta_schedule, 99, varorder, proposal,
+            nullptr, nullptr, 1, false, 1, lookup_table, Termination(), false,
+            LinearSearch, nullptr, nullptr, 0, precision) == num_samples);
+    };
+
+    SECTION("integer precision accepts the same flips") {
+        for (VariableOrder varorder : {Sequential, Random})
+        for (Proposal proposal : {Metropolis, Gibbs})
+        for (bool lookup_table : {false, true}) {
+            std::vector<std::int8_t> states, integer_states;
+            std::vector<double> energies, integer_energies;
+            sample(problem, varorder, proposal, lookup_table, DoublePrecision,
+                   states, energies);
+            sample(problem, varorder, proposal, lookup_table, IntegerPrecision,
+                   integer_states, integer_energies);
+            CHECK(states == integer_states);
+            CHECK(energies == integer_energies);
+        }
+    }
+
+    SECTION("the energies of every precision are exact") {
+        // non-integer biases, whose single precision deltas are rounded
+        std::vector<double> weights(coupler_weights);
+        for (double &w : weights) w *= 1.1;
+        const AnnealingProblem inexact(h, coupler_starts, coupler_ends, weights);
+
+        for (VariableOrder varorder : {Sequential, Random})
+        for (Proposal proposal : {Metropolis, Gibbs})
+        for (Precision precision : {SinglePrecision, IntegerPrecision}) {
+            std::vector<std::int8_t> states;
+            std::vector<double> energies;
+            sample(inexact, varorder, proposal, false, precision, states, energies);
+            for (int s = 0; s < num_samples; s++) {
+                CHECK(energies[s] == Approx(get_state_energy(
+                    states.data() + s * num_vars, h, inexact.graph()->adjacency)));
+            }
+        }
+    }
+
+    SECTION("single precision anneals to low energies") {
+        // a ferromagnetic chain, whose ground state is all-up
+        const int n = 200;
+        std::vector<double> chain_h(n, -.1);
+        std::vector<int> starts, ends;
+        std::vector<double> weights;
+        for (int v = 0; v + 1 < n; v++) {
+            starts.push_back(v);
+            ends.push_back(v + 1);
+            weights.push_back(-1.3);
+        }
+        const AnnealingProblem chain(chain_h, starts, ends, weights);
+
+        std::vector<std::int8_t> states;
+        std::vector<double> energies;
+        sample(chain, Sequential, Metropolis, false, SinglePrecision, states, energies);
+        const double ground = -.1 * n - 1.3 * (n - 1);
+        for (int s = 0; s < num_samples; s++) {
+            CHECK(energies[s] == Approx(get_state_energy(
+                states.data() + s * n, chain_h, chain.graph()->adjacency)));
+            CHECK(energies[s] < ground + 10);
+        }
+    }
+}
+
+TEST_CASE("Test simulated_annealing_batch") {
+    // rings of different sizes, one of them without variables
+    std::vector<MockBQM> bqms;
+    for (int num_vars : {5, 12, 0, 30, 7}) {
+        Ring ring(num_vars);
+        MockBQM bqm(num_vars);
+        for (int v = 0; v < num_vars; v++) bqm.add_linear(v, ring.h[v]);
+        for (size_t c = 0; c < ring.coupler_starts.size(); c++) {
+            bqm.add_quadratic(ring.coupler_starts[c], ring.coupler_ends[c],
+                              ring.coupler_weights[c]);
+        }
+        bqms.push_back(bqm);
+    }
+    std::vector<MockBQM*> pointers;
+    int total_vars = 0;
+    for (auto &bqm : bqms) {
+        pointers.push_back(&bqm);
+        total_vars += bqm.num_variables();
+    }
+
+    AnnealingBatch batch;
+    batch.num_samples = 4;
+    batch.num_betas = 20;
+    batch.sweeps_per_beta = 2;
+
+    std::vector<std::int8_t> states(batch.num_samples * total_vars);
+    std::vector<double> energies(batch.num_samples * bqms.size());
+    std::vector<std::pair<double, double>> beta_ranges(bqms.size());
+    simulated_annealing_batch(pointers, states.data(), energies.data(),
+                              beta_ranges.data(), batch, 1234);
+
+    SECTION("each problem is sampled as on its own") {
+        int offset = 0;
+        for (size_t i = 0; i < bqms.size(); i++) {
+            const AnnealingProblem problem(bqms[i]);
+            const int num_vars = problem.num_variables();
+            std::vector<std::int8_t> own_states(batch.num_samples * num_vars);
+            std::vector<double> own_energies(batch.num_samples);
+            std::pair<double, double> own_range;
+            sample_batch_problem(problem, own_states.data(), own_energies.data(),
+                                 own_range, batch, 1234, i);
+
+            CHECK(own_range == beta_ranges[i]);
+            CHECK(std::equal(own_states.begin(), own_states.end(),
+                             states.begin() + offset));
+            CHECK(std::equal(own_energies.begin(), own_energies.end(),
+                             energies.begin() + batch.num_samples * i));
+            offset += batch.num_samples * num_vars;
+        }
+        CHECK(beta_ranges[2] == std::make_pair(0.1, 1.0));
+    }
+
+    SECTION("samples do not depend on the number of threads") {
+        for (int num_threads : {2, 3, 8}) {
+            std::vector<std::int8_t> threaded_states(states.size());
+            std::vector<double> threaded_energies(energies.size());
+            simulated_annealing_batch(pointers, threaded_states.data(),
+                                      threaded_energies.data(), beta_ranges.data(),
+                                      batch, 1234, num_threads);
+            CHECK(threaded_states == states);
+            CHECK(threaded_energies == energies);
+        }
+    }
+
+    SECTION("the given beta range is used for all problems") {
+        batch.hot_beta = 0.5;
+        batch.cold_beta = 3;
+        batch.geometric = false;
+        simulated_annealing_batch(pointers, states.data(), energies.data(),
+                                  beta_ranges.data(), batch, 1234);
+        for (auto &beta_range : beta_ranges) {
+            CHECK(beta_range == std::make_pair(0.5, 3.0));
+        }
+    }
+}
@@ -17,6 +17,8 @@
 #include <vector>
 
 #include "bqp.cpp"
+#include "mock_bqm.h"
+#include "tabu_search.h"
 
 using std::vector;
 using Catch::Matchers::Contains;
@@ -47,11 +49,13 @@ TEST_CASE("Test BQP::initialize()") {
     vector<int> solution = {1, 1, 1};
     bqp.initialize(solution);
 
-    // Check that Q matrix was converted to upper triangular
+    // Check that the coefficients were stored sparsely
     for (int i = 0; i < bqp.nVars; i++) {
-        for (int j = i + 1; j < bqp.nVars; j++) {
-            REQUIRE(bqp.Q[i][j] == Q[i][j] + Q[j][i]);
-            REQUIRE(bqp.Q[j][i] == 0);
+        REQUIRE(bqp.linear[i] == Q[i][i]);
+        REQUIRE(bqp.quadratic.degree(i) == bqp.nVars - 1);
+        for (const Neighbor *n = bqp.quadratic.begin(i); n != bqp.quadratic.end(i); ++n) {
+            REQUIRE(n->var != i);
+            REQUIRE(n->weight == Q[i][n->var] + Q[n->var][i]);
         }
     }
     
@@ -84,3 +88,355 @@ TEST_CASE("Testing BQP::getMaxBQPCoeff()") {
     BQP bqp = BQP(Q);
     REQUIRE(bqp.getMaxBQPCoeff() == 3);  
 }
+
+TEST_CASE("Testing bqmToQ()") {
+    MockBQM bqm(3);
+    bqm.add_linear(0, 1);
+    bqm.add_linear(2, -3);
+    bqm.add_quadratic(0, 1, 2);
+    bqm.add_quadratic(2, 1, -1);
+
+    vector<vector<double>> Q {{1, 1, 0},
+                              {1, 0, -.5},
+                              {0, -.5, -3}};
+    REQUIRE(bqmToQ(bqm) == Q);
+
+    // the matrix is accepted by BQP
+    BQP bqp = BQP(bqmToQ(bqm));
+    REQUIRE(bqp.nVars == 3);
+
+    REQUIRE(bqmToQ(MockBQM(0)).empty());
+}
+
+TEST_CASE("Testing sparse BQP") {
+    MockBQM bqm(4);
+    bqm.add_linear(0, 1);
+    bqm.add_linear(2, -3);
+    bqm.add_quadratic(0, 1, 2);
+    bqm.add_quadratic(2, 1, -1);
+    bqm.add_quadratic(3, 0, .5);
+
+    // only the nonzero coefficients are stored, in sorted rows
+    BQP bqp = bqmToBQP(bqm);
+    REQUIRE(bqp.nVars == 4);
+    REQUIRE(bqp.linear == vector<double>{1, 0, -3, 0});
+    REQUIRE(bqp.quadratic.offsets == vector<int>{0, 2, 4, 5, 6});
+    REQUIRE(bqp.quadratic.neighbors[0].var == 1);
+    REQUIRE(bqp.quadratic.neighbors[0].weight == 2);
+    REQUIRE(bqp.quadratic.neighbors[1].var == 3);
+    REQUIRE(bqp.quadratic.neighbors[1].weight == .5);
+
+    // and they agree with the dense matrix
+    BQP dense = BQP(bqmToQ(bqm));
+    REQUIRE(dense.linear == bqp.linear);
+    REQUIRE(dense.quadratic.offsets == bqp.quadratic.offsets);
+    for (int i = 0; i < 16; i++) {
+        vector<int> solution {i & 1, (i >> 1) & 1, (i >> 2) & 1, (i >> 3) & 1};
+        REQUIRE(bqp.getObjective(solution) == dense.getObjective(solution));
+        for (int v = 0; v < 4; v++) {
+            REQUIRE(bqp.getChangeInObjective(solution, v) ==
+                    dense.getChangeInObjective(solution, v));
+        }
+    }
+    REQUIRE(bqp.getMaxBQPCoeff() == 3);
+
+    // graphs merge duplicate couplers, and move self-loops to the linear biases
+    IsingGraph graph = build_ising_graph({1, 0, -3}, {0, 1, 1, 2}, {1, 0, 2, 2}, {1, 1, -1, 4});
+    BQP from_graph = graphToBQP(graph);
+    REQUIRE(from_graph.linear == vector<double>{1, 0, 1});
+    REQUIRE(from_graph.quadratic.offsets == vector<int>{0, 1, 3, 4});
+    REQUIRE(from_graph.quadratic.neighbors[0].weight == 2);
+    REQUIRE(from_graph.quadratic.neighbors[2].weight == -1);
+    REQUIRE(BQP(graphToQ(graph)).getObjective({1, 1, 1}) == from_graph.getObjective({1, 1, 1}));
+
+    Adjacency self_loop = build_adjacency(2, {0}, {0}, {1});
+    REQUIRE_THROWS_WITH([&]() {
+        BQP bad = BQP({0, 0}, self_loop);
+    }(), Contains("quadratic contains an invalid variable"));
+}
+
+TEST_CASE("Testing TabuSearch on a sparse BQP") {
+    // a ferromagnetic chain of 200 variables, with a field pulling it to 1
+    const int num_vars = 200;
+    MockBQM bqm(num_vars);
+    bqm.add_linear(0, -1);
+    for (int v = 0; v + 1 < num_vars; v++) {
+        bqm.add_linear(v, 1);
+        bqm.add_linear(v + 1, 1);
+        bqm.add_quadratic(v, v + 1, -2);
+    }
+
+    vector<int> init(num_vars, 0);
+    TabuSearch sparse(bqmToBQP(bqm), init, 0, -1, 2, 17, -1e300, -1, -1, 1000);
+    REQUIRE(sparse.bestSolution() == vector<int>(num_vars, 1));
+    REQUIRE(sparse.bestEnergy() == -1);
+
+    // the same search on the dense matrix
+    TabuSearch dense(bqmToQ(bqm), init, 0, -1, 2, 17, -1e300, -1, -1, 1000);
+    REQUIRE(dense.bestSolution() == sparse.bestSolution());
+    REQUIRE(dense.numRestarts() == sparse.numRestarts());
+}
+
+TEST_CASE("Testing TabuSearch restarts with hubs") {
+    // a ring whose first variables are also coupled to every other one, so
+    // that restarts update their trees both one leaf at a time and by
+    // rebuilding them
+    const int num_vars = 300;
+    MockBQM bqm(num_vars);
+    for (int v = 0; v < num_vars; v++) {
+        bqm.add_linear(v, (v * 13) % 7 - 3);
+        bqm.add_quadratic(v, (v + 1) % num_vars, (v * 5) % 9 - 4);
+    }
+    for (int hub = 0; hub < 3; hub++) {
+        for (int v = hub + 2; v < num_vars; v++) {
+            bqm.add_quadratic(hub, v, (v % 2)? 1 : -1);
+        }
+    }
+    BQP problem = bqmToBQP(bqm);
+    REQUIRE(!problem.denseQuadratic);
+
+    vector<int> init(num_vars, 0);
+    TabuSearch search(problem, init, 0, -1, 20, 21, -1e300, 5, 5, 100);
+    REQUIRE(search.numRestarts() == 20);
+
+    vector<int> solution = search.bestSolution();
+    REQUIRE(search.bestEnergy() == problem.getObjective(solution));
+
+    // the same search without restarts finds no better solution
+    TabuSearch first(problem, init, 0, -1, 0, 21, -1e300, 5, 5, 100);
+    REQUIRE(search.bestEnergy() <= first.bestEnergy());
+}
+
+TEST_CASE("Testing multiReadTabuSearch") {
+    // a frustrated ring, whose many ground states exercise the rng
+    const int num_vars = 30;
+    MockBQM bqm(num_vars);
+    for (int v = 0; v < num_vars; v++) {
+        bqm.add_linear(v, -1);
+        bqm.add_quadratic(v, (v + 1) % num_vars, 2);
+    }
+    BQP problem = bqmToBQP(bqm);
+
+    const int num_reads = 6;
+    vector<vector<int>> init(num_reads, vector<int>(num_vars, 0));
+    vector<unsigned int> seeds {3, 1, 4, 1, 5, 9};
+
+    vector<vector<int>> solutions;
+    vector<int> restarts;
+    multiReadTabuSearch(problem, init, seeds, 0, -1, 2, -1e300, 10, 10, 100,
+                        1, solutions, restarts);
+    REQUIRE(solutions.size() == num_reads);
+    REQUIRE(restarts == vector<int>(num_reads, 2));
+
+    // each read matches the search with its seed, whatever the threads
+    for (int t : {2, 4, 8}) {
+        vector<vector<int>> threaded_solutions;
+        vector<int> threaded_restarts;
+        multiReadTabuSearch(problem, init, seeds, 0, -1, 2, -1e300, 10, 10, 100,
+                            t, threaded_solutions, threaded_restarts);
+        REQUIRE(threaded_solutions == solutions);
+        REQUIRE(threaded_restarts == restarts);
+    }
+    for (int r = 0; r < num_reads; r++) {
+        TabuSearch search(problem, init[r], 0, -1, 2, seeds[r], -1e300, 10, 10, 100);
+        REQUIRE(search.bestSolution() == solutions[r]);
+    }
+
+    // the iterations and evaluations of each read are those of its search
+    vector<unsigned long long> iterations, evaluations;
+    multiReadTabuSearch(problem, init, seeds, 0, -1, 2, -1e300, 10, 10, 100,
+                        3, solutions, restarts, 0, &iterations, &evaluations);
+    REQUIRE(iterations.size() == num_reads);
+    REQUIRE(evaluations.size() == num_reads);
+    for (int r = 0; r < num_reads; r++) {
+        TabuSearch search(problem, init[r], 0, -1, 2, seeds[r], -1e300, 10, 10, 100);
+        REQUIRE(search.numIterations() > 0);
+        REQUIRE(search.numIterations() == iterations[r]);
+        REQUIRE(search.numEvaluations() >= search.numIterations() * num_vars);
+        REQUIRE(search.numEvaluations() == evaluations[r]);
+    }
+
+    // with a single seed, each read draws from the stream of its index
+    vector<vector<int>> stream_solutions;
+    vector<int> stream_restarts;
+    multiReadTabuSearch(problem, init, (std::uint64_t)42, 0, -1, 2, -1e300, 10, 10,
+                        100, 1, stream_solutions, stream_restarts);
+    REQUIRE(stream_restarts == vector<int>(num_reads, 2));
+    for (int t : {2, 4}) {
+        vector<vector<int>> threaded_solutions;
+        vector<int> threaded_restarts;
+        multiReadTabuSearch(problem, init, (std::uint64_t)42, 0, -1, 2, -1e300, 10,
+                            10, 100, t, threaded_solutions, threaded_restarts);
+        REQUIRE(threaded_solutions == stream_solutions);
+    }
+    for (int r = 0; r < num_reads; r++) {
+        TabuSearch search(problem, init[r], 0, -1, 2, 42, -1e300, 10, 10, 100,
+                          nullptr, r);
+        REQUIRE(search.bestSolution() == stream_solutions[r]);
+    }
+
+    // errors of any read are raised
+    vector<vector<int>> bad_init(init);
+    bad_init[4].pop_back();
+    REQUIRE_THROWS_WITH(multiReadTabuSearch(problem, bad_init, seeds, 0, -1, 2,
+                                            -1e300, 10, 10, 100, 3,
+                                            solutions, restarts),
+                        Contains("length of init_solution"));
+    REQUIRE_THROWS_WITH(multiReadTabuSearch(problem, init, {1, 2}, 0, -1, 2,
+                                            -1e300, 10, 10, 100, 3,
+                                            solutions, restarts),
+                        Contains("length of seeds"));
+}
+
+TEST_CASE("Testing ElitePool") {
+    StreamRng generator(7);
+    vector<int> solution;
+    double objective;
+
+    ElitePool pool(2);
+    REQUIRE_FALSE(pool.draw(generator, solution, objective));
+
+    pool.offer({0, 1}, -1);
+    pool.offer({0, 1}, -1);
+    REQUIRE(pool.size() == 1);
+    REQUIRE(pool.draw(generator, solution, objective));
+    REQUIRE(solution == vector<int>{0, 1});
+    REQUIRE(objective == -1);
+
+    // once full, only solutions better than the worst are kept
+    pool.offer({1, 1}, 2);
+    pool.offer({1, 0}, 3);
+    REQUIRE(pool.size() == 2);
+    pool.offer({0, 0}, -5);
+    for (int i = 0; i < 20; i++) {
+        REQUIRE(pool.draw(generator, solution, objective));
+        REQUIRE(objective < 0);
+        REQUIRE(solution == (objective == -1 ? vector<int>{0, 1} : vector<int>{0, 0}));
+    }
+
+    REQUIRE_THROWS_WITH(ElitePool(0), Contains("capacity"));
+}
+
+TEST_CASE("Testing cooperative multiReadTabuSearch") {
+    const int num_vars = 30;
+    MockBQM bqm(num_vars);
+    for (int v = 0; v < num_vars; v++) {
+        bqm.add_linear(v, -1);
+        bqm.add_quadratic(v, (v + 1) % num_vars, 2);
+    }
+    BQP problem = bqmToBQP(bqm);
+
+    const int num_reads = 6;
+    vector<vector<int>> init(num_reads, vector<int>(num_vars, 0));
+    vector<unsigned int> seeds {3, 1, 4, 1, 5, 9};
+
+    for (int t : {1, 3}) {
+        vector<vector<int>> solutions;
+        vector<int> restarts;
+        multiReadTabuSearch(problem, init, seeds, 0, -1, 5, -1e300, 10, 10, 100,
+                            t, solutions, restarts, 4);
+        REQUIRE(restarts == vector<int>(num_reads, 5));
+
+        // the ring is solved by alternating values
+        for (const auto &solution : solutions) {
+            REQUIRE(solution.size() == num_vars);
+            REQUIRE(problem.getObjective(solution) == -num_vars / 2);
+        }
+    }
+}
+
+TEST_CASE("Testing BQP dense storage") {
+    // a complete problem with integer biases
+    const int num_vars = 40;
+    MockBQM bqm(num_vars);
+    for (int u = 0; u < num_vars; u++) {
+        bqm.add_linear(u, (u * 7) % 5 - 2);
+        for (int v = u + 1; v < num_vars; v++) {
+            bqm.add_quadratic(u, v, (u * v + u) % 7 - 3);
+        }
+    }
+
+    BQP problem = bqmToBQP(bqm);
+    REQUIRE(problem.denseQuadratic);
+    REQUIRE(!problem.denseQuadraticFloat);
+    for (int i = 0; i < num_vars; i++) {
+        REQUIRE((*problem.denseQuadratic)[i * num_vars + i] == 0);
+        for (const Neighbor *n = problem.quadratic.begin(i); n != problem.quadratic.end(i); ++n) {
+            REQUIRE((*problem.denseQuadratic)[i * num_vars + n->var] == n->weight);
+        }
+    }
+
+    // copies share the dense storage
+    BQP copy(problem);
+    REQUIRE(copy.denseQuadratic == problem.denseQuadratic);
+
+    // a sparse problem has none
+    REQUIRE(!bqmToBQP(MockBQM(num_vars)).denseQuadratic);
+
+    // the search is the same with every storage
+    vector<int> init(num_vars, 0);
+    TabuSearch dense(problem, init, 0, -1, 3, 11, -1e300, 50, 50, 1000);
+
+    BQP sparse(problem);
+    sparse.useSparseStorage();
+    REQUIRE(!sparse.denseQuadratic);
+    TabuSearch expected(sparse, init, 0, -1, 3, 11, -1e300, 50, 50, 1000);
+    REQUIRE(dense.bestSolution() == expected.bestSolution());
+    REQUIRE(dense.bestEnergy() == expected.bestEnergy());
+
+    BQP single(problem);
+    single.useDenseStorage(true);
+    REQUIRE(!single.denseQuadratic);
+    REQUIRE(single.denseQuadraticFloat);
+    TabuSearch singleSearch(single, init, 0, -1, 3, 11, -1e300, 50, 50, 1000);
+    REQUIRE(singleSearch.bestSolution() == expected.bestSolution());
+}
+
+TEST_CASE("Testing multiProblemTabuSearch") {
+    // frustrated rings of different sizes, one of them without variables
+    vector<MockBQM> bqms;
+    for (int num_vars : {4, 30, 0, 12}) {
+        MockBQM bqm(num_vars);
+        for (int v = 0; v < num_vars; v++) {
+            bqm.add_linear(v, -1);
+            bqm.add_quadratic(v, (v + 1) % num_vars, 2);
+        }
+        bqms.push_back(bqm);
+    }
+    vector<MockBQM*> pointers;
+    int total_vars = 0;
+    for (auto &bqm : bqms) {
+        pointers.push_back(&bqm);
+        total_vars += bqm.num_variables();
+    }
+
+    const int num_reads = 3;
+    vector<std::int8_t> solutions(num_reads * total_vars);
+    vector<int> restarts(num_reads * bqms.size());
+    multiProblemTabuSearch(pointers, 42, -1, 2, -1e300, 1000, 1000, 100, num_reads, 1,
+                           solutions.data(), restarts.data());
+
+    // the rings of even length have two ground states, alternating 0 and 1
+    int offset = 0;
+    for (size_t i = 0; i < bqms.size(); i++) {
+        const int num_vars = bqms[i].num_variables();
+        for (int r = 0; r < num_reads; r++) {
+            const std::int8_t *solution = solutions.data() + offset + r * num_vars;
+            for (int v = 0; v < num_vars; v++) {
+                REQUIRE(solution[v] != solution[(v + 1) % num_vars]);
+            }
+            REQUIRE(restarts[num_reads * i + r] == (num_vars ? 2 : 0));
+        }
+        offset += num_reads * num_vars;
+    }
+
+    // and the solutions do not depend on the number of threads
+    for (int t : {2, 4}) {
+        vector<std::int8_t> threaded_solutions(solutions.size());
+        vector<int> threaded_restarts(restarts.size());
+        multiProblemTabuSearch(pointers, 42, -1, 2, -1e300, 1000, 1000, 100, num_reads,
+                               t, threaded_solutions.data(), threaded_restarts.data());
+        REQUIRE(threaded_solutions == solutions);
+        REQUIRE(threaded_restarts == restarts);
+    }
+}
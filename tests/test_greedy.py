@@ -17,11 +17,17 @@ import unittest
 import numpy as np
 import dimod
 
-from dwave.samplers.greedy.descent import steepest_gradient_descent
+from dwave.samplers.common import pool
+from dwave.samplers.common.graph import IsingGraph
+from dwave.samplers.greedy.descent import (
+    steepest_gradient_descent, steepest_gradient_descent_bqm,
+    steepest_gradient_descent_graph)
+from dwave.samplers.sa.simulated_annealing import AnnealingProblem
 
 
 class SteepestGradientDescentCython(unittest.TestCase):
     large_sparse_opt = False
+    solver = None
 
     def test_steepest_gradient_descent_on_small_convex_ising(self):
         """The sampler must converge to a global minimum of a convex Ising problem."""
@@ -39,12 +45,143 @@ class SteepestGradientDescentCython(unittest.TestCase):
 
         samples, energies, num_steps = steepest_gradient_descent(
             num_samples, linear_biases, coupler_starts, coupler_ends,
-            coupler_weights, initial_states, self.large_sparse_opt)
+            coupler_weights, initial_states, self.large_sparse_opt, self.solver)
 
         self.assertEqual(samples.shape, (1, 2))
         np.testing.assert_array_equal(samples, [[-1, -1]])
         np.testing.assert_array_equal(energies, [-5])
 
+    def test_steepest_gradient_descent_bqm(self):
+        """Reading the BQM in place gives the same descent as its vectors."""
+
+        bqm = dimod.generators.random.uniform(30, 'SPIN', low=-1, high=1, seed=7)
+        initial_states = np.random.default_rng(7).choice(
+            np.array([-1, 1], dtype=np.int8), size=(10, 30))
+        linear, (coupler_starts, coupler_ends, coupler_weights), _ = \
+            bqm.to_numpy_vectors()
+
+        samples, energies, num_steps = steepest_gradient_descent(
+            10, linear, coupler_starts, coupler_ends, coupler_weights,
+            np.copy(initial_states), self.large_sparse_opt, self.solver)
+        bqm_samples, bqm_energies, bqm_num_steps = steepest_gradient_descent_bqm(
+            10, bqm, np.copy(initial_states), self.large_sparse_opt, self.solver)
+
+        np.testing.assert_array_equal(bqm_samples, samples)
+        np.testing.assert_allclose(bqm_energies, energies)
+        np.testing.assert_array_equal(bqm_num_steps, num_steps)
+
+        with self.assertRaises(ValueError):
+            steepest_gradient_descent_bqm(10, bqm.binary, initial_states)
+
+    def test_steepest_gradient_descent_graph(self):
+        """A graph shared with simulated annealing gives the same descent."""
+
+        bqm = dimod.generators.random.uniform(30, 'SPIN', low=-1, high=1, seed=3)
+        initial_states = np.random.default_rng(3).choice(
+            np.array([-1, 1], dtype=np.int8), size=(10, 30))
+
+        samples, energies, num_steps = steepest_gradient_descent_bqm(
+            10, bqm, np.copy(initial_states), self.large_sparse_opt, self.solver)
+
+        for options in [{}, dict(sort_neighbors=True), dict(merge_duplicates=True)]:
+            with self.subTest(**options):
+                graph = IsingGraph.from_bqm(bqm, **options)
+                self.assertEqual(graph.num_variables, 30)
+
+                graph_samples, graph_energies, graph_num_steps = \
+                    steepest_gradient_descent_graph(
+                        10, graph, np.copy(initial_states),
+                        self.large_sparse_opt, self.solver)
+
+                np.testing.assert_array_equal(graph_samples, samples)
+                np.testing.assert_allclose(graph_energies, energies)
+                np.testing.assert_array_equal(graph_num_steps, num_steps)
+
+        # post-process annealed samples without building the graph again
+        graph = IsingGraph.from_bqm(bqm)
+        annealed, _ = AnnealingProblem.from_graph(graph).sample(
+            10, 1, [.1, 1.], 5, np.copy(initial_states))
+        descended, descended_energies, _ = steepest_gradient_descent_graph(
+            10, graph, np.copy(annealed), self.large_sparse_opt, self.solver)
+        np.testing.assert_allclose(
+            descended_energies, bqm.energies((descended, range(30))) - bqm.offset)
+
+        with self.assertRaises(ValueError):
+            IsingGraph.from_bqm(bqm.binary)
+
+    def test_num_threads(self):
+        """The descents do not depend on the number of threads."""
+
+        bqm = dimod.generators.random.uniform(50, 'SPIN', low=-1, high=1, seed=5)
+        initial_states = np.random.default_rng(5).choice(
+            np.array([-1, 1], dtype=np.int8), size=(40, 50))
+
+        samples, energies, num_steps = steepest_gradient_descent_bqm(
+            40, bqm, np.copy(initial_states), self.large_sparse_opt, self.solver)
+        for num_threads in (2, 7):
+            with self.subTest(num_threads=num_threads):
+                thread_samples, thread_energies, thread_num_steps = \
+                    steepest_gradient_descent_bqm(
+                        40, bqm, np.copy(initial_states), self.large_sparse_opt,
+                        self.solver, num_threads)
+                np.testing.assert_array_equal(thread_samples, samples)
+                np.testing.assert_array_equal(thread_energies, energies)
+                np.testing.assert_array_equal(thread_num_steps, num_steps)
+
+    def test_worker_pool(self):
+        """The descents do not depend on the size of the shared worker pool."""
+
+        bqm = dimod.generators.random.uniform(50, 'SPIN', low=-1, high=1, seed=6)
+        initial_states = np.random.default_rng(6).choice(
+            np.array([-1, 1], dtype=np.int8), size=(40, 50))
+
+        samples, energies, num_steps = steepest_gradient_descent_bqm(
+            40, bqm, np.copy(initial_states), self.large_sparse_opt, self.solver)
+
+        default = pool.num_threads()
+        try:
+            for size in (1, 3):
+                with self.subTest(size=size):
+                    pool.set_num_threads(size)
+                    self.assertEqual(pool.num_threads(), size)
+
+                    # more threads than workers
+                    pool_samples, pool_energies, pool_num_steps = \
+                        steepest_gradient_descent_bqm(
+                            40, bqm, np.copy(initial_states), self.large_sparse_opt,
+                            self.solver, 8)
+                    np.testing.assert_array_equal(pool_samples, samples)
+                    np.testing.assert_array_equal(pool_energies, energies)
+                    np.testing.assert_array_equal(pool_num_steps, num_steps)
+        finally:
+            pool.set_num_threads(default)
+
+        with self.assertRaises(ValueError):
+            pool.set_num_threads(-1)
+
 
 class SteepestGradientDescentLargeSparseCython(SteepestGradientDescentCython):
     large_sparse_opt = True
+
+
+class SteepestGradientDescentHeapCython(SteepestGradientDescentCython):
+    solver = 'heap'
+
+    def test_same_descent(self):
+        """The heap solver descends the same way as the linear search."""
+
+        bqm = dimod.generators.randint(200, 'SPIN', low=-2, high=2, seed=3)
+        initial_states = np.random.default_rng(3).choice(
+            np.array([-1, 1], dtype=np.int8), size=(20, 200))
+
+        samples, energies, num_steps = steepest_gradient_descent_bqm(
+            20, bqm, np.copy(initial_states))
+        heap_samples, heap_energies, heap_num_steps = steepest_gradient_descent_bqm(
+            20, bqm, np.copy(initial_states), solver=self.solver)
+
+        np.testing.assert_array_equal(heap_samples, samples)
+        np.testing.assert_array_equal(heap_energies, energies)
+        np.testing.assert_array_equal(heap_num_steps, num_steps)
+
+        with self.assertRaises(ValueError):
+            steepest_gradient_descent_bqm(20, bqm, initial_states, solver='list')
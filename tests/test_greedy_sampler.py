@@ -30,6 +30,8 @@ BQM_CLASSES = [(cls, ) for cls in BQM_SUBCLASSES]
     # vary large & sparse problem optimization via sampling params
     {"params": dict(large_sparse_opt=False)},
     {"params": dict(large_sparse_opt=True)},
+    {"params": dict(solver='heap')},
+    {"params": dict(num_threads=4)},
 ])
 @dimod.testing.load_sampler_bqm_tests(SteepestDescentSampler)
 class TestSteepestDescentSampler(unittest.TestCase):
@@ -88,6 +90,18 @@ class TestSteepestDescentSampler(unittest.TestCase):
         with self.assertRaises(ValueError):
             sampler.sample(empty, initial_states=init, **self.params)
 
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, **dict(self.params, solver='invalid'))
+
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, large_sparse_opt=True, solver='linear')
+
+        with self.assertRaises(TypeError):
+            sampler.sample(bqm, **dict(self.params, num_threads=1.5))
+
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, **dict(self.params, num_threads=0))
+
     def test_small_convex_ising(self):
         """The sampler must converge to a global minimum of a convex Ising problem."""
 
@@ -282,6 +296,127 @@ class TestSteepestDescentSampler(unittest.TestCase):
         np.testing.assert_array_equal(ss.record.num_steps, [0])
 
 
+    def test_sample_stream(self):
+        bqm = dimod.generators.ran_r(1, 50, seed=3)
+        params = dict(num_reads=60, seed=5, num_threads=2)
+
+        ss = SteepestDescentSampler().sample(bqm, **params)
+        streamed = list(SteepestDescentSampler().sample_stream(
+            bqm, batch_size=8, queue_size=16, **params))
+
+        self.assertTrue(all(len(part) <= 8 for part in streamed))
+        combined = dimod.concatenate(streamed)
+        self.assertEqual(len(combined), 60)
+        dimod.testing.assert_sampleset_energies(combined, bqm)
+
+        # the reads, with their number of steps, are those of sample
+        def reads(sampleset):
+            return sorted(zip(map(tuple, sampleset.record.sample),
+                              sampleset.record.num_steps))
+        self.assertEqual(reads(combined), reads(ss))
+
+
+    def test_sample_batch(self):
+        bqms = [dimod.generators.ran_r(1, n, seed=n) for n in (4, 30, 15)]
+        bqms.append(dimod.generators.ran_r(1, 10, seed=1).change_vartype('BINARY'))
+        bqms[0].offset = -1
+
+        samplesets = SteepestDescentSampler().sample_batch(bqms, num_reads=7, seed=3)
+        self.assertEqual(len(samplesets), len(bqms))
+        for bqm, ss in zip(bqms, samplesets):
+            self.assertEqual(len(ss), 7)
+            self.assertIs(ss.vartype, bqm.vartype)
+            dimod.testing.assert_sampleset_energies(ss, bqm)
+
+            # each read is a local minimum, so descending again takes no steps
+            ss2 = SteepestDescentSampler().sample(bqm, initial_states=ss)
+            np.testing.assert_array_equal(ss2.record.num_steps, 0)
+
+        # the samples do not depend on the number of threads
+        threaded = SteepestDescentSampler().sample_batch(
+            bqms, num_reads=7, seed=3, num_threads=4)
+        for ss, other in zip(samplesets, threaded):
+            np.testing.assert_array_equal(ss.record.sample, other.record.sample)
+            np.testing.assert_array_equal(ss.record.num_steps, other.record.num_steps)
+
+    def test_iterated_local_search(self):
+        bqm = dimod.generators.ran_r(1, 100, seed=7)
+        sampler = SteepestDescentSampler()
+
+        descents = sampler.sample(bqm, num_reads=10, seed=4)
+        searches = sampler.sample(bqm, num_reads=10, seed=4, num_iterations=200)
+        dimod.testing.assert_sampleset_energies(searches, bqm)
+
+        # each read starts from the same state as its descent, and ends in a
+        # local minimum no higher than it
+        self.assertTrue(all(searches.record.energy <= descents.record.energy))
+        self.assertLess(searches.record.energy.sum(), descents.record.energy.sum())
+        self.assertTrue(all(searches.record.num_steps >= descents.record.num_steps))
+        again = sampler.sample(bqm, initial_states=searches)
+        np.testing.assert_array_equal(again.record.num_steps, 0)
+
+        # without iterations it is a descent
+        ss = sampler.sample(bqm, num_reads=10, seed=4, num_iterations=0)
+        np.testing.assert_array_equal(ss.record.sample, descents.record.sample)
+
+        # the searches do not depend on the number of threads
+        threaded = sampler.sample(bqm, num_reads=10, seed=4, num_iterations=200,
+                                  num_threads=4)
+        np.testing.assert_array_equal(threaded.record.sample, searches.record.sample)
+        np.testing.assert_array_equal(threaded.record.num_steps, searches.record.num_steps)
+
+        # a time limit alone bounds the search
+        timed = sampler.sample(bqm, num_reads=4, seed=4, time_limit=.01,
+                               perturbation_size=5, num_threads=2)
+        dimod.testing.assert_sampleset_energies(timed, bqm)
+
+        streamed = dimod.concatenate(list(sampler.sample_stream(
+            bqm, num_reads=10, seed=4, num_iterations=200, batch_size=3)))
+        self.assertEqual(sorted(map(tuple, streamed.record.sample)),
+                         sorted(map(tuple, searches.record.sample)))
+
+        with self.assertRaises(TypeError):
+            sampler.sample(bqm, num_iterations=1.5)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, num_iterations=-1)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, time_limit=-1)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, num_iterations=10, perturbation_size=0)
+
+    @parameterized.expand([(dimod.SPIN,), (dimod.BINARY,)])
+    def test_incremental_descent(self, vartype):
+        bqm = dimod.generators.ran_r(1, 30, seed=5).change_vartype(vartype)
+        bqm.offset = 2
+        descent = SteepestDescentSampler().incremental_descent(bqm, num_reads=5, seed=7)
+        dimod.testing.assert_sampleset_energies(descent.sampleset, bqm)
+
+        updates = [
+            dict(linear={0: 3, 7: -2}),
+            dict(quadratic={(1, 2): 2, (0, 29): -1.5}, offset=1),
+            dict(linear={3: 1}, quadratic={(4, 5): -3}, num_threads=2),
+        ]
+        for update in updates:
+            previous = descent.sampleset
+            ss = descent.update(**update)
+            self.assertIs(ss.vartype, vartype)
+
+            bqm.add_linear_from(update.get('linear', {}))
+            bqm.add_quadratic_from(update.get('quadratic', {}))
+            bqm.offset += update.get('offset', 0)
+            dimod.testing.assert_sampleset_energies(ss, bqm)
+
+            # the same minima as a full descent from the previous ones
+            full = SteepestDescentSampler().sample(
+                bqm, initial_states=previous, solver='heap')
+            np.testing.assert_array_equal(ss.record.sample, full.record.sample)
+            np.testing.assert_array_equal(ss.record.num_steps, full.record.num_steps)
+
+        with self.assertRaises(ValueError):
+            descent.update(linear={'a': 1})
+        with self.assertRaises(ValueError):
+            descent.update(quadratic={(0, 0): 1})
+
 class TestTimingInfo(unittest.TestCase):
     def setUp(self) -> None:
         empty = dimod.BQM(dimod.SPIN)
@@ -0,0 +1,124 @@
+# Copyright 2026 D-Wave Systems Inc.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+
+import unittest
+
+import numpy as np
+
+import dimod
+
+from dwave.samplers.sa import ParallelTemperingSampler
+
+
+class TestParallelTemperingSampler(unittest.TestCase):
+    def test_instantiation(self):
+        sampler = ParallelTemperingSampler()
+        dimod.testing.assert_sampler_api(sampler)
+
+    def test_good_results(self):
+        sampler = ParallelTemperingSampler()
+
+        num_vars = 40
+        h = {v: -1 for v in range(num_vars)}
+        J = {(u, v): -1 for u in range(num_vars) for v in range(u, num_vars) if u != v}
+        ground = {v: 1 for v in range(num_vars)}
+
+        sampleset = sampler.sample_ising(h, J, num_reads=5, seed=33)
+        self.assertEqual(len(sampleset), 5)
+        for sample in sampleset.samples():
+            self.assertEqual(sample, ground)
+
+    def test_empty(self):
+        sampleset = ParallelTemperingSampler().sample(dimod.BQM(dimod.SPIN))
+        self.assertEqual(len(sampleset.variables), 0)
+
+    def test_vartype(self):
+        bqm = dimod.generators.ran_r(1, 10, seed=7)
+        sampler = ParallelTemperingSampler()
+
+        spin = sampler.sample(bqm, num_reads=3, seed=5)
+        binary = sampler.sample(bqm.binary, num_reads=3, seed=5)
+
+        self.assertIs(binary.vartype, dimod.BINARY)
+        dimod.testing.assert_sampleset_energies(binary, bqm.binary)
+        np.testing.assert_array_equal(spin.record.energy, binary.record.energy)
+
+    def test_seed(self):
+        bqm = dimod.generators.ran_r(1, 20, seed=3)
+        sampler = ParallelTemperingSampler()
+
+        ss1 = sampler.sample(bqm, num_reads=4, num_sweeps=50, seed=12)
+        ss2 = sampler.sample(bqm, num_reads=4, num_sweeps=50, seed=12)
+        np.testing.assert_array_equal(ss1.record.sample, ss2.record.sample)
+
+    def test_num_threads(self):
+        bqm = dimod.generators.ran_r(1, 30, seed=8)
+        sampler = ParallelTemperingSampler()
+
+        ss1 = sampler.sample(bqm, num_reads=4, num_sweeps=100, seed=12)
+        ss4 = sampler.sample(bqm, num_reads=4, num_sweeps=100, seed=12,
+                             num_threads=4)
+        np.testing.assert_array_equal(ss1.record.sample, ss4.record.sample)
+        np.testing.assert_array_equal(ss1.info['swap_acceptance_rates'],
+                                      ss4.info['swap_acceptance_rates'])
+
+    def test_beta_ladder(self):
+        bqm = dimod.generators.ran_r(1, 20, seed=4)
+        sampler = ParallelTemperingSampler()
+
+        ladder = [.1, .2, .5, 1, 2]
+        sampleset = sampler.sample(bqm, beta_ladder=ladder, num_sweeps=100,
+                                   num_sweeps_per_swap=2, seed=1)
+        np.testing.assert_array_equal(sampleset.info['beta_ladder'], ladder)
+        self.assertEqual(sampleset.info['beta_range'], [.1, 2])
+
+        rates = sampleset.info['swap_acceptance_rates']
+        self.assertEqual(len(rates), len(ladder) - 1)
+        self.assertTrue(np.all(rates >= 0) and np.all(rates <= 1))
+
+        sampleset = sampler.sample(bqm, beta_range=[.1, 3], num_replicas=6)
+        np.testing.assert_allclose(sampleset.info['beta_ladder'],
+                                   np.geomspace(.1, 3, num=6))
+
+    def test_initial_states(self):
+        bqm = dimod.BQM.from_ising({'a': 1, 'b': -1}, {})
+        sampler = ParallelTemperingSampler()
+
+        # with no sweeps the coldest replica keeps its initial state
+        sampleset = sampler.sample(bqm, initial_states=({'b': 1, 'a': 1}),
+                                   num_sweeps=0)
+        self.assertEqual(sampleset.first.sample, {'a': 1, 'b': 1})
+
+    def test_errors(self):
+        bqm = dimod.generators.ran_r(1, 10, seed=4)
+        sampler = ParallelTemperingSampler()
+
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, num_sweeps=10, num_sweeps_per_swap=3)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, num_replicas=0)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, beta_ladder=[])
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, beta_ladder=[-1, 1])
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, beta_ladder=[.1, 1], beta_range=[.2, 1])
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, num_threads=0)
+        with self.assertRaises(TypeError):
+            sampler.sample(bqm, interrupt_function=1)
+
+
+if __name__ == '__main__':
+    unittest.main()
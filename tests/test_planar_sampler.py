@@ -71,9 +71,9 @@ class TestGroundStateBQM(unittest.TestCase):
         sample = PlanarGraphSolver().sample(bqm)
 
         self.assertEqual(set(sample.first.sample.values()), {-1, +1})
-        self.assertDictEqual(
-            sample.first.sample,
-            {(0, 0): 1, (0, 1): -1, (0, 2): 1, (0, 3): -1, (0, 4): 1, (0, 5): -1, (0, 6): 1, (0, 7): -1, (0, 8): 1,
+
+        # the ground state is degenerate, so only its energy is checked
+        ground_state = {(0, 0): 1, (0, 1): -1, (0, 2): 1, (0, 3): -1, (0, 4): 1, (0, 5): -1, (0, 6): 1, (0, 7): -1, (0, 8): 1,
              (0, 9): -1, (0, 10): 1, (0, 11): -1, (0, 12): 1, (0, 13): -1, (0, 14): 1, (0, 15): -1, (1, 0): -1,
              (1, 1): -1, (1, 2): 1, (1, 3): -1, (1, 4): 1, (1, 5): -1, (1, 6): 1, (1, 7): -1, (1, 8): 1, (1, 9): -1,
              (1, 10): 1, (1, 11): -1, (1, 12): 1, (1, 13): -1, (1, 14): 1, (1, 15): -1, (2, 0): 1, (2, 1): 1, (2, 2): 1,
@@ -104,7 +104,7 @@ class TestGroundStateBQM(unittest.TestCase):
              (14, 12): 1, (14, 13): 1, (14, 14): 1, (14, 15): -1, (15, 0): -1, (15, 1): -1, (15, 2): -1, (15, 3): -1,
              (15, 4): -1, (15, 5): -1, (15, 6): -1, (15, 7): -1, (15, 8): -1, (15, 9): -1, (15, 10): -1, (15, 11): -1,
              (15, 12): -1, (15, 13): -1, (15, 14): -1, (15, 15): -1}
-        )
+        self.assertEqual(sample.first.energy, bqm.energy(ground_state))
 
     def test_grid_15x15_ferromagnet(self):
         bqm = dimod.BinaryQuadraticModel.empty(dimod.SPIN)
@@ -18,6 +18,7 @@ import unittest
 
 import dimod
 import dimod.testing
+import numpy as np
 
 from dwave.samplers import RandomSampler
 
@@ -47,6 +48,21 @@ class TestRandomSampler(unittest.TestCase):
         with self.assertWarns(dimod.exceptions.SamplerUnknownArgWarning):
             RandomSampler().sample(bqm, a=5, b=2)
 
+    def test_num_threads(self):
+        bqm = dimod.generators.gnp_random_bqm(100, .5, 'BINARY', seed=5)
+
+        sampleset = RandomSampler().sample(bqm, num_reads=500, seed=7)
+        threaded = RandomSampler().sample(bqm, num_reads=500, seed=7, num_threads=3)
+
+        self.assertEqual(sampleset.info['num_reads'], 500)
+        self.assertEqual(threaded.info['num_reads'], 500)
+        np.testing.assert_array_equal(sampleset.record.sample, threaded.record.sample)
+        np.testing.assert_array_equal(sampleset.record.energy, threaded.record.energy)
+        dimod.testing.assert_sampleset_energies(threaded, bqm)
+
+        with self.assertRaises(ValueError):
+            RandomSampler().sample(bqm, num_threads=0)
+
     def test_time_limit(self):
         bqm = dimod.BinaryQuadraticModel({0: 0.0, 1: 0.0, 2: 0.0},
                                          {(0, 1): -1.0, (1, 2): 1.0, (0, 2): 1.0},
@@ -20,9 +20,11 @@ from concurrent.futures import ThreadPoolExecutor, wait
 from copy import deepcopy
 from time import perf_counter
 
+import dimod
 import numpy as np
 
-from dwave.samplers.sa.simulated_annealing import simulated_annealing
+from dwave.samplers.common.graph import IsingGraph
+from dwave.samplers.sa.simulated_annealing import AnnealingProblem, simulated_annealing
 
 
 try:
@@ -242,6 +244,120 @@ class TestSA(unittest.TestCase):
         self.assertTrue(np.array_equal(initial_states, samples),
                         "Initial states do not match samples with 0 sweeps")
 
+    def test_num_threads(self):
+        problem = self._sample_fm_problem(num_variables=20, num_sweeps=100)
+        num_samples, *args, initial_states = problem
+
+        samples, energies = simulated_annealing(
+            num_samples, *args, np.copy(initial_states), randomize_order=True)
+
+        for num_threads in (2, 3, 2*num_samples):
+            with self.subTest(num_threads=num_threads):
+                parallel_samples, parallel_energies = simulated_annealing(
+                    num_samples, *args, np.copy(initial_states),
+                    randomize_order=True, num_threads=num_threads)
+
+                np.testing.assert_array_equal(samples, parallel_samples)
+                np.testing.assert_array_equal(energies, parallel_energies)
+
+    def test_num_threads_interrupt(self):
+        problem = self._sample_fm_problem(num_variables=5)
+
+        count = [0]
+
+        def stop():
+            count[0] += 1
+            return count[0] >= 5
+
+        samples, energies = simulated_annealing(
+            *problem, interrupt_function=stop, num_threads=4)
+
+        # samples in progress are completed, but the interrupt function is not
+        # called after it returns True
+        self.assertEqual(count[0], 5)
+        self.assertGreaterEqual(len(samples), 5)
+        self.assertEqual(len(samples), len(energies))
+
+    def test_annealing_problem(self):
+        problem = self._sample_fm_problem(num_variables=20, num_sweeps=100)
+        num_samples, h, coupler_starts, coupler_ends, coupler_weights, \
+            sweeps_at_beta, beta_schedule, seed, initial_states = problem
+
+        samples, energies = simulated_annealing(
+            num_samples, h, coupler_starts, coupler_ends, coupler_weights,
+            sweeps_at_beta, beta_schedule, seed, np.copy(initial_states))
+
+        prepared = AnnealingProblem(h, coupler_starts, coupler_ends, coupler_weights)
+        self.assertEqual(prepared.num_variables, 20)
+
+        # the problem can be sampled repeatedly
+        for _ in range(2):
+            prepared_samples, prepared_energies = prepared.sample(
+                num_samples, sweeps_at_beta, beta_schedule, seed,
+                np.copy(initial_states))
+
+            np.testing.assert_array_equal(samples, prepared_samples)
+            np.testing.assert_array_equal(energies, prepared_energies)
+
+        # with a different schedule
+        prepared_samples, _ = prepared.sample(
+            num_samples, 1, [], seed, np.copy(initial_states))
+        np.testing.assert_array_equal(prepared_samples, initial_states)
+
+        with self.assertRaises(ValueError):
+            prepared.sample(num_samples, 1, [], seed, np.copy(initial_states[1:]))
+
+    def test_annealing_problem_from_bqm(self):
+        problem = self._sample_fm_problem(num_variables=20, num_sweeps=100)
+        num_samples, h, coupler_starts, coupler_ends, coupler_weights, \
+            sweeps_at_beta, beta_schedule, seed, initial_states = problem
+
+        bqm = dimod.BinaryQuadraticModel.from_ising(
+            dict(enumerate(h)),
+            {(u, v): w for u, v, w in zip(coupler_starts, coupler_ends, coupler_weights)
+             if u != v})
+
+        prepared = AnnealingProblem.from_bqm(bqm)
+        self.assertEqual(prepared.num_variables, 20)
+
+        samples, energies = prepared.sample(
+            num_samples, sweeps_at_beta, beta_schedule, seed,
+            np.copy(initial_states))
+
+        self.assertEqual(samples.shape, (num_samples, 20))
+        np.testing.assert_allclose(energies, bqm.energies((samples, range(20))))
+
+        with self.assertRaises(ValueError):
+            AnnealingProblem.from_bqm(bqm.binary)
+
+    def test_annealing_problem_from_graph(self):
+        problem = self._sample_fm_problem(num_variables=20, num_sweeps=100)
+        num_samples, h, coupler_starts, coupler_ends, coupler_weights, \
+            sweeps_at_beta, beta_schedule, seed, initial_states = problem
+
+        samples, energies = AnnealingProblem(
+            h, coupler_starts, coupler_ends, coupler_weights).sample(
+                num_samples, sweeps_at_beta, beta_schedule, seed,
+                np.copy(initial_states))
+
+        graph = IsingGraph(h, coupler_starts, coupler_ends, coupler_weights)
+        self.assertEqual(graph.num_variables, 20)
+
+        # several problems can share the graph
+        for _ in range(2):
+            prepared = AnnealingProblem.from_graph(graph)
+            self.assertEqual(prepared.num_variables, 20)
+
+            graph_samples, graph_energies = prepared.sample(
+                num_samples, sweeps_at_beta, beta_schedule, seed,
+                np.copy(initial_states))
+
+            np.testing.assert_array_equal(samples, graph_samples)
+            np.testing.assert_array_equal(energies, graph_energies)
+
+        with self.assertRaises(TypeError):
+            AnnealingProblem.from_graph(None)
+
     @unittest.skipIf(NUM_CPUS < 4, "insufficient CPUs available")
     def test_concurrency(self):
         """Multiple SA run in parallel threads, not blocking each other due to GIL."""
@@ -22,6 +22,7 @@ import warnings
 import dimod
 
 import dwave.samplers.sa as sa
+from dwave.samplers.greedy import SteepestDescentComposite
 from dwave.samplers.sa import SimulatedAnnealingSampler
 
 class TestTimingInfo(unittest.TestCase):
@@ -233,6 +234,304 @@ class TestSimulatedAnnealingSampler(unittest.TestCase):
 
             all_samples.append(samples0)
 
+    def test_num_threads(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.ran_r(1, 30, seed=42)
+
+        ss = sampler.sample(bqm, num_reads=20, num_sweeps=100, seed=5)
+        for num_threads in (2, 7):
+            with self.subTest(num_threads=num_threads):
+                parallel = sampler.sample(bqm, num_reads=20, num_sweeps=100,
+                                          seed=5, num_threads=num_threads)
+                np.testing.assert_array_equal(ss.record.sample,
+                                              parallel.record.sample)
+
+        with self.assertRaises(TypeError):
+            sampler.sample(bqm, num_threads=1.5)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, num_threads=0)
+
+    def test_multi_spin(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.ran_r(1, 30, seed=42)
+
+        ss = sampler.sample(bqm, num_reads=100, seed=5, multi_spin=True)
+
+        self.assertEqual(len(ss), 100)
+        dimod.testing.assert_sampleset_energies(ss, bqm)
+
+        # same seed, same results, independent of the number of threads
+        ss1 = sampler.sample(bqm, num_reads=100, seed=5, multi_spin=True,
+                             num_threads=2)
+        np.testing.assert_array_equal(ss.record.sample, ss1.record.sample)
+
+        # easy problem, most reads should find the ground state
+        ground = sampler.sample(bqm, num_reads=100, seed=5).first.energy
+        self.assertLessEqual(ss.first.energy, ground)
+
+        # the multi-spin engine draws its own random numbers, so for the same
+        # seed its reads differ from those of the scalar engine, unlike when
+        # it falls back to it (see test_multi_spin_fallback)
+        scalar = sampler.sample(bqm, num_reads=100, num_sweeps=10, seed=5)
+        multi = sampler.sample(bqm, num_reads=100, num_sweeps=10, seed=5,
+                               multi_spin=True)
+        self.assertFalse(np.array_equal(scalar.record.sample, multi.record.sample))
+
+    def test_multi_spin_fallback(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.uniform(20, 'SPIN', low=-1, high=1, seed=3)
+
+        # not representable, so uses the scalar engine
+        ss0 = sampler.sample(bqm, num_reads=10, num_sweeps=10, seed=5)
+        ss1 = sampler.sample(bqm, num_reads=10, num_sweeps=10, seed=5,
+                             multi_spin=True)
+        np.testing.assert_array_equal(ss0.record.sample, ss1.record.sample)
+
+    def test_vectorize(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.ran_r(1, 30, seed=42)
+
+        for proposal_acceptance_criteria in ('Metropolis', 'Gibbs'):
+            with self.subTest(proposal_acceptance_criteria=proposal_acceptance_criteria):
+                ss = sampler.sample(bqm, num_reads=10, seed=5, vectorize=True,
+                                    proposal_acceptance_criteria=proposal_acceptance_criteria)
+
+                self.assertEqual(len(ss), 10)
+                dimod.testing.assert_sampleset_energies(ss, bqm)
+
+                ground = sampler.sample(bqm, num_reads=10, seed=5).first.energy
+                self.assertLessEqual(ss.first.energy, ground)
+
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, vectorize=True, randomize_order=True)
+
+    def test_sweep_threads(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.ran_r(1, (20, 20), seed=42)
+
+        ss = sampler.sample(bqm, num_reads=2, num_sweeps=100, seed=5,
+                            sweep_threads=2)
+        dimod.testing.assert_sampleset_energies(ss, bqm)
+
+        ss1 = sampler.sample(bqm, num_reads=2, num_sweeps=100, seed=5,
+                             sweep_threads=3)
+        np.testing.assert_array_equal(ss.record.sample, ss1.record.sample)
+
+        with self.assertRaises(TypeError):
+            sampler.sample(bqm, sweep_threads=1.5)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, sweep_threads=0)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, sweep_threads=2, randomize_order=True)
+
+    def test_lookup_table(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.randint(20, 'BINARY', low=-3, high=3, seed=7)
+
+        for randomize_order in (False, True):
+            for proposal_acceptance_criteria in ('Metropolis', 'Gibbs'):
+                kwargs = dict(num_reads=10, num_sweeps=100, seed=5,
+                              randomize_order=randomize_order,
+                              proposal_acceptance_criteria=proposal_acceptance_criteria)
+                with self.subTest(**kwargs):
+                    ss0 = sampler.sample(bqm, **kwargs)
+                    ss1 = sampler.sample(bqm, lookup_table=True, **kwargs)
+                    np.testing.assert_array_equal(ss0.record.sample,
+                                                  ss1.record.sample)
+                    np.testing.assert_array_equal(ss0.record.energy,
+                                                  ss1.record.energy)
+
+    def test_precision(self):
+        sampler = SimulatedAnnealingSampler()
+        # the spin biases are multiples of .25, so the integer deltas are exact
+        bqm = dimod.generators.randint(20, 'BINARY', low=-3, high=3, seed=7)
+
+        for randomize_order in (False, True):
+            kwargs = dict(num_reads=10, num_sweeps=100, seed=5,
+                          randomize_order=randomize_order)
+            with self.subTest(**kwargs):
+                ss0 = sampler.sample(bqm, **kwargs)
+                ss1 = sampler.sample(bqm, precision='integer', **kwargs)
+                np.testing.assert_array_equal(ss0.record.sample, ss1.record.sample)
+                np.testing.assert_array_equal(ss0.record.energy, ss1.record.energy)
+
+                ss2 = sampler.sample(bqm, precision='single', **kwargs)
+                dimod.testing.assert_sampleset_energies(ss2, bqm)
+
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, precision='half')
+
+    def test_termination(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.ran_r(1, 30, seed=3)
+        bqm.offset = 10
+
+        # every read reaches a target above the largest energy after its
+        # first sweep, which is at the first beta of the schedule
+        target = sum(map(abs, bqm.quadratic.values())) + bqm.offset
+        ss = sampler.sample(bqm, num_reads=5, num_sweeps=1000,
+                            beta_range=[.1, 10], seed=8, target_energy=target)
+        first = sampler.sample(bqm, num_reads=5, beta_schedule=[.1],
+                               beta_schedule_type='custom', seed=8)
+        np.testing.assert_array_equal(ss.record.sample, first.record.sample)
+        np.testing.assert_array_equal(ss.record.energy, first.record.energy)
+
+        # a read ends once stuck in a local minimum at a large beta
+        ss = sampler.sample(bqm, num_reads=5, num_sweeps_per_beta=10**9,
+                            beta_schedule=[100], beta_schedule_type='custom',
+                            seed=8, stall_sweeps=10)
+        dimod.testing.assert_sampleset_energies(ss, bqm)
+
+        ss = sampler.sample(bqm, num_reads=2, num_sweeps_per_beta=10**9,
+                            beta_schedule=[.1], beta_schedule_type='custom',
+                            seed=8, time_limit=.01)
+        self.assertLess(ss.info['timing']['sampling_ns'], 2e9)
+        dimod.testing.assert_sampleset_energies(ss, bqm)
+
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, time_limit=0)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, stall_sweeps=0)
+        with self.assertRaises(TypeError):
+            sampler.sample(bqm, stall_sweeps=1.5)
+
+    def test_descend(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.ran_r(1, 30, seed=4)
+        bqm.offset = -2
+        params = dict(num_reads=10, num_sweeps=10, beta_range=[.01, .1], seed=2)
+
+        ss = sampler.sample(bqm, descend=True, **params)
+        composed = SteepestDescentComposite(sampler).sample(bqm, **params)
+
+        np.testing.assert_array_equal(ss.record.sample, composed.record.sample)
+        np.testing.assert_allclose(ss.record.energy, composed.record.energy)
+        dimod.testing.assert_sampleset_energies(ss, bqm)
+
+    def test_sample_stream(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.ran_r(1, 30, seed=4).change_vartype('BINARY')
+        bqm.offset = -2
+        params = dict(num_reads=100, num_sweeps=10, seed=2, num_threads=3)
+
+        ss = sampler.sample(bqm, **params)
+
+        stream = sampler.sample_stream(bqm, batch_size=7, queue_size=4, **params)
+        streamed = []
+        while True:
+            try:
+                streamed.append(next(stream))
+            except StopIteration as stop:
+                result = stop.value
+                break
+
+        self.assertTrue(all(len(part) <= 7 for part in streamed))
+        self.assertEqual(sum(len(part) for part in streamed), 100)
+        for part in streamed:
+            self.assertIs(part.vartype, dimod.BINARY)
+            dimod.testing.assert_sampleset_energies(part, bqm)
+
+        # the reads are those of sample, in the order they completed
+        combined = dimod.concatenate(streamed)
+        self.assertEqual(sorted(map(tuple, combined.record.sample)),
+                         sorted(map(tuple, ss.record.sample)))
+        np.testing.assert_array_equal(result.record.sample, ss.record.sample)
+        self.assertIn('beta_range', result.info)
+
+        # closing the stream early lets the sampler finish
+        stream = sampler.sample_stream(bqm, queue_size=1, **params)
+        self.assertGreater(len(next(stream)), 0)
+        stream.close()
+
+        # problems without reads yield the complete sample set once
+        streamed = list(sampler.sample_stream(dimod.BQM('SPIN'), num_reads=3))
+        self.assertEqual(len(streamed), 1)
+        self.assertEqual(len(streamed[0]), 3)
+
+
+    def test_sample_batch(self):
+        sampler = SimulatedAnnealingSampler()
+        bqms = [dimod.generators.ran_r(1, n, seed=n) for n in (5, 20, 12)]
+        bqms.append(dimod.generators.ran_r(1, 8, seed=1).change_vartype('BINARY'))
+        bqms[1].offset = 3
+        params = dict(num_reads=10, num_sweeps=100, seed=7)
+
+        samplesets = sampler.sample_batch(bqms, **params)
+        self.assertEqual(len(samplesets), len(bqms))
+        for bqm, ss in zip(bqms, samplesets):
+            self.assertEqual(len(ss), 10)
+            self.assertIs(ss.vartype, bqm.vartype)
+            self.assertEqual(ss.variables, bqm.variables)
+            dimod.testing.assert_sampleset_energies(ss, bqm)
+            self.assertEqual(len(ss.info['beta_range']), 2)
+
+        # the samples do not depend on the number of threads
+        threaded = sampler.sample_batch(bqms, num_threads=3, **params)
+        for ss, other in zip(samplesets, threaded):
+            np.testing.assert_array_equal(ss.record.sample, other.record.sample)
+
+        # the given beta range applies to all of them
+        samplesets = sampler.sample_batch(bqms, beta_range=[0.5, 5],
+                                          beta_schedule_type='linear', **params)
+        for ss in samplesets:
+            self.assertEqual(ss.info['beta_range'], [0.5, 5])
+
+        with self.assertRaises(ValueError):
+            sampler.sample_batch(bqms, beta_schedule_type='custom')
+        with self.assertRaises(ValueError):
+            sampler.sample_batch(bqms, num_threads=0)
+    def test_counters(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.ran_r(1, 30, seed=4)
+
+        ss = sampler.sample(bqm, num_reads=10, num_sweeps=20, seed=2)
+        if 'counters' not in ss.info:
+            self.skipTest("the kernels were built without DWAVE_SAMPLERS_COUNTERS")
+
+        # every variable is proposed once per sweep, and there is one sweep
+        # per beta of the default schedule
+        counters = ss.info['counters']
+        proposals = counters['accepted'] + counters['rejected'] + counters['skipped']
+        np.testing.assert_array_equal(proposals, np.full(20, 10 * 30))
+        self.assertGreater(counters['accepted'][0], counters['accepted'][-1])
+
+    def test_adaptive_schedule(self):
+        sampler = SimulatedAnnealingSampler()
+        bqm = dimod.generators.ran_r(1, 30, seed=4)
+
+        ss = sampler.sample(bqm, num_reads=10, num_sweeps=200, seed=2,
+                            beta_schedule_type='adaptive')
+        self.assertEqual(ss.info['beta_schedule_type'], 'adaptive')
+        np.testing.assert_array_almost_equal(bqm.energies(ss), ss.record.energy)
+
+        # the betas are those of the geometric schedule, of which the cold
+        # ones are skipped once the reads are frozen
+        if 'counters' in ss.info:
+            counters = ss.info['counters']
+            proposals = counters['accepted'] + counters['rejected'] + counters['skipped']
+            self.assertEqual(proposals[0], 10 * 30)
+            self.assertEqual(proposals[-1], 10 * 30)
+            self.assertLess(proposals.sum(), 200 * 10 * 30)
+
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, beta_schedule_type='adaptive', vectorize=True)
+
+    def test_initial_states_variable_order(self):
+        # the BQM is read in place, so the initial states are reordered to
+        # match its variables
+        bqm = dimod.BinaryQuadraticModel({'a': 1, 'b': -1, 'c': 2},
+                                         {'ab': -1, 'bc': 1}, 0.5, 'SPIN')
+        init = dimod.SampleSet.from_samples(
+            ([[1, -1, -1], [-1, 1, 1]], ['c', 'a', 'b']), 'SPIN', 0)
+
+        sampleset = SimulatedAnnealingSampler().sample(
+            bqm, initial_states=init, num_sweeps=0, beta_range=[1, 1])
+
+        self.assertEqual(list(sampleset.samples(sorted_by=None)),
+                         [{'a': -1, 'b': -1, 'c': 1}, {'a': 1, 'b': 1, 'c': -1}])
+        np.testing.assert_allclose(sampleset.record.energy,
+                                   bqm.energies(sampleset))
+
     def test_disconnected_problem(self):
         sampler = SimulatedAnnealingSampler()
         h = {}
@@ -443,6 +742,23 @@ class TestDefaultBetaRange(unittest.TestCase):
         self.assertTrue(res1[0] == res2[0])
         self.assertTrue(res2[1] > res1[1])
 
+    def test_native_range(self):
+        # the native range matches the one computed from the biases
+        for bqm in [dimod.generators.ran_r(1, 30, seed=3),
+                    dimod.generators.gnp_random_bqm(25, .3, 'SPIN', seed=4),
+                    dimod.BinaryQuadraticModel.from_ising({'a': 1, 'b': 0}, {'bc': .5, 'cd': 0})]:
+            problem = sa.simulated_annealing.AnnealingProblem.from_bqm(bqm)
+            for kwargs in [{}, dict(scale_T_with_N=False),
+                           dict(max_single_qubit_excitation_rate=0.1)]:
+                np.testing.assert_allclose(
+                    problem.default_beta_range(**kwargs),
+                    sa.sampler._default_ising_beta_range(bqm.linear, bqm.quadratic, **kwargs))
+
+    def test_native_empty_problem(self):
+        bqm = dimod.BinaryQuadraticModel.from_ising({'a': 0}, {})
+        with self.assertWarns(UserWarning):
+            self.assertEqual(sa.sampler.default_beta_range(bqm), [0.1, 1])
+
 class TestHeuristicResponse(unittest.TestCase):
     def test_job_shop_scheduling_with_linear(self):
         # Set up a job shop scheduling BQM
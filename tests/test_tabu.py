@@ -99,6 +99,38 @@ class TestTabuSearch(unittest.TestCase):
         search = tabu.TabuSearch(Q, init, tenure, timeout, restarts)
         self.assertAlmostEqual(search.bestEnergy(), -14.65986790)
 
+    def test_bqm(self):
+        n = 20
+        init = [1] * n
+        tenure = len(init) - 1
+        timeout = 20
+        restarts = 100
+
+        # reading the BQM in place gives the same search as its matrix
+        bqm = dimod.generators.random.uniform(n, 'BINARY', low=-100, high=100, seed=123)
+        Q, _ = tabu.TabuSampler._bqm_to_tabu_qubo(bqm)
+        search = tabu.TabuSearch(Q, init, tenure, timeout, restarts, seed=5)
+        bqm_search = tabu.TabuSearch(bqm, init, tenure, timeout, restarts, seed=5)
+        self.assertEqual(list(bqm_search.bestSolution()), list(search.bestSolution()))
+        self.assertAlmostEqual(bqm_search.bestEnergy(), search.bestEnergy())
+
+        with self.assertRaises(ValueError):
+            tabu.TabuSearch(bqm.spin, init, tenure, timeout, restarts)
+
+    def test_large_sparse_bqm(self):
+        # a dense matrix of this size would take 3.2 GB
+        n = 20000
+        bqm = dimod.generators.chimera_anticluster(40, 40, 4, seed=3).binary
+        bqm.relabel_variables({v: i for i, v in enumerate(bqm.variables)})
+        bqm.add_linear_from((v, 0) for v in range(len(bqm), n))
+        self.assertEqual(len(bqm), n)
+
+        init = [0] * n
+        search = tabu.TabuSearch(bqm, init, 20, 100, 0, seed=5)
+        self.assertEqual(len(search.bestSolution()), n)
+        self.assertAlmostEqual(search.bestEnergy(),
+                               bqm.energy(search.bestSolution()) - bqm.offset)
+
     def test_exceptions(self):
         qubo = [[-1.2, 1.1], [1.1, -1.2]]
         timeout = 10
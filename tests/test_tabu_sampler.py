@@ -14,6 +14,7 @@
 
 """Test the TabuSampler python interface."""
 
+import os
 import unittest
 
 import dimod
@@ -23,6 +24,13 @@ import dwave.samplers.tabu as tabu
 from dwave.samplers.tabu.utils import tictoc
 
 
+try:
+    NUM_CPUS = len(os.sched_getaffinity(0))
+except AttributeError:
+    # windows
+    NUM_CPUS = os.cpu_count()
+
+
 @dimod.testing.load_sampler_bqm_tests(tabu.TabuSampler)
 class TestTabuSampler(unittest.TestCase):
 
@@ -244,6 +252,49 @@ class TestTabuSampler(unittest.TestCase):
                                       num_restarts=0, lower_bound_z= 2147483647)
         self.assertAlmostEqual(tt.dt, 0.6, places=1)
 
+    def test_num_threads(self):
+        sampler = tabu.TabuSampler()
+        bqm = dimod.generators.random.randint(10, dimod.SPIN, low=1, high=1, seed=5)
+
+        # the reads are seeded separately, so threads do not change them
+        response1 = sampler.sample(bqm, num_reads=8, tenure=5, num_restarts=1,
+                                   timeout=None, seed=42)
+        response4 = sampler.sample(bqm, num_reads=8, tenure=5, num_restarts=1,
+                                   timeout=None, seed=42, num_threads=4)
+        np.testing.assert_array_equal(response1.record.sample, response4.record.sample)
+        np.testing.assert_array_equal(response1.record.num_restarts,
+                                      response4.record.num_restarts)
+
+        with self.assertRaises(TypeError):
+            sampler.sample(bqm, num_threads=1.5)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, num_threads=0)
+
+    @unittest.skipIf(NUM_CPUS < 4, "insufficient CPUs available")
+    def test_num_threads_timeout(self):
+        sampler = tabu.TabuSampler()
+        bqm = dimod.BinaryQuadraticModel.from_ising({}, {'ab': -1, 'bc': 1, 'ac': 1})
+
+        # the reads run concurrently
+        with tictoc() as tt:
+            sampler.sample(bqm, num_reads=4, timeout=300, seed=123, num_threads=4)
+        self.assertAlmostEqual(tt.dt, 0.3, places=1)
+
+    def test_elite_pool_size(self):
+        sampler = tabu.TabuSampler()
+        bqm = dimod.generators.random.randint(20, dimod.SPIN, seed=17)
+
+        response = sampler.sample(bqm, num_reads=6, num_restarts=5, timeout=None,
+                                  seed=42, num_threads=2, elite_pool_size=3)
+        self.assertEqual(len(response), 6)
+        np.testing.assert_array_equal(response.record.num_restarts, 5)
+        dimod.testing.assert_sampleset_energies(response, bqm)
+
+        with self.assertRaises(TypeError):
+            sampler.sample(bqm, elite_pool_size=1.5)
+        with self.assertRaises(ValueError):
+            sampler.sample(bqm, elite_pool_size=-1)
+
     def test_num_restarts(self):
         sampler = tabu.TabuSampler()
         bqm = dimod.generators.random.randint(10, 'SPIN', seed=123)
@@ -254,6 +305,38 @@ class TestTabuSampler(unittest.TestCase):
         num_restarts = response.record['num_restarts']  
         self.assertEqual(target_restarts, num_restarts)
 
+    def test_sample_batch(self):
+        sampler = tabu.TabuSampler()
+        bqms = [dimod.generators.random.randint(n, 'SPIN', seed=n) for n in (5, 12, 8)]
+        bqms.append(dimod.generators.random.randint(6, 'BINARY', seed=1))
+
+        samplesets = sampler.sample_batch(bqms, num_reads=3, timeout=None,
+                                          num_restarts=5, seed=345)
+        self.assertEqual(len(samplesets), len(bqms))
+        for bqm, ss in zip(bqms, samplesets):
+            self.assertEqual(len(ss), 3)
+            self.assertIs(ss.vartype, bqm.vartype)
+            dimod.testing.assert_sampleset_energies(ss, bqm)
+            np.testing.assert_array_equal(ss.record.num_restarts, 5)
+
+        # the samples do not depend on the number of threads
+        threaded = sampler.sample_batch(bqms, num_reads=3, timeout=None,
+                                        num_restarts=5, seed=345, num_threads=3)
+        for ss, other in zip(samplesets, threaded):
+            np.testing.assert_array_equal(ss.record.sample, other.record.sample)
+
+    def test_counters(self):
+        sampler = tabu.TabuSampler()
+        bqm = dimod.generators.random.randint(10, 'SPIN', seed=123)
+
+        response = sampler.sample(bqm, num_reads=3, timeout=None, num_restarts=5, seed=345)
+
+        counters = response.info['counters']
+        self.assertEqual(len(counters['num_iterations']), 3)
+        self.assertEqual(len(counters['num_evaluations']), 3)
+        self.assertTrue((counters['num_iterations'] > 0).all())
+        self.assertTrue((counters['num_evaluations'] >= counters['num_iterations']).all())
+
     def test_energy_threshold(self):
         sampler = tabu.TabuSampler()
         bqm = dimod.generators.random.randint(100, 'SPIN', seed=123)
@@ -134,6 +134,20 @@ class TestTreewidth(unittest.TestCase):
             tw, order = min_fill_heuristic(bqm)
             self.check_order(bqm, tw, order)
 
+    def test_restarts(self):
+        bqm = dimod.from_networkx_graph(nx.grid_2d_graph(6, 7), vartype='BINARY')
+
+        tw, order = min_fill_heuristic(bqm)
+        self.check_order(bqm, tw, order)
+
+        tw1, order1 = min_fill_heuristic(bqm, num_restarts=8, seed=5)
+        self.check_order(bqm, tw1, order1)
+        self.assertEqual(
+            (tw1, order1), min_fill_heuristic(bqm, num_restarts=8, num_threads=3, seed=5))
+
+        with self.assertRaises(ValueError):
+            min_fill_heuristic(bqm, num_restarts=0)
+
     def test_path(self):
         with self.subTest(n=1):
             bqm = dimod.Binary('x')
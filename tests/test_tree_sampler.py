@@ -16,6 +16,7 @@ import collections
 import inspect
 import itertools
 import unittest
+import unittest.mock
 
 import dimod
 import numpy as np
@@ -107,6 +108,128 @@ class TestSample(unittest.TestCase):
         self.assertEqual(len(samples), 1)
         dimod.testing.assert_response_energies(samples, bqm)
 
+    def test_num_threads(self):
+        # a tree, whose independent subtrees are built concurrently
+        G = nx.balanced_tree(3, 3)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+
+        sampleset = TreeDecompositionSampler().sample(bqm, num_reads=10, seed=7)
+        threaded = TreeDecompositionSampler().sample(bqm, num_reads=10, seed=7,
+                                                     num_threads=4)
+
+        np.testing.assert_array_equal(sampleset.record.sample, threaded.record.sample)
+        self.assertEqual(sampleset.info['log_partition_function'],
+                         threaded.info['log_partition_function'])
+        self.assertEqual(sampleset.info['variable_marginals'],
+                         threaded.info['variable_marginals'])
+        self.assertEqual(sampleset.info['interaction_marginals'],
+                         threaded.info['interaction_marginals'])
+
+        with self.assertRaises(ValueError):
+            TreeDecompositionSampler().sample(bqm, num_threads=0)
+
+    def test_max_memory(self):
+        G = nx.balanced_tree(3, 3)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+
+        sampleset = TreeDecompositionSampler().sample(bqm, num_reads=10, seed=7)
+        budgeted = TreeDecompositionSampler().sample(bqm, num_reads=10, seed=7, max_memory=2**30)
+        np.testing.assert_array_equal(sampleset.record.sample, budgeted.record.sample)
+
+        # the tables of a single edge do not fit in a byte
+        with self.assertRaises(RuntimeError):
+            TreeDecompositionSampler().sample(bqm, max_memory=1)
+
+        with self.assertRaises(ValueError):
+            TreeDecompositionSampler().sample(bqm, max_memory=0)
+
+    def test_dtype(self):
+        G = nx.balanced_tree(3, 3)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+
+        sampleset = TreeDecompositionSampler().sample(bqm, num_reads=10, seed=7)
+        single = TreeDecompositionSampler().sample(bqm, num_reads=10, seed=7,
+                                                   dtype=np.float32)
+
+        self.assertAlmostEqual(sampleset.info['log_partition_function'],
+                               single.info['log_partition_function'], places=4)
+        for v, p in sampleset.info['variable_marginals'].items():
+            self.assertAlmostEqual(p, single.info['variable_marginals'][v], places=5)
+
+        with self.assertRaises(ValueError):
+            TreeDecompositionSampler().sample(bqm, dtype=np.int8)
+
+    def test_elimination_order_reuse(self):
+        import dwave.samplers.tree.samplers as samplers
+
+        G = nx.balanced_tree(3, 3)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+        other = dimod.generators.randint(G, dimod.SPIN, seed=6)
+
+        sampler = TreeDecompositionSampler()
+        with unittest.mock.patch.object(samplers, 'min_fill_heuristic',
+                                        wraps=samplers.min_fill_heuristic) as heuristic:
+            sampler.sample(bqm, seed=7)
+            # same graph, different biases
+            reused = sampler.sample(other, seed=7)
+            self.assertEqual(heuristic.call_count, 1)
+
+            # a different graph
+            sampler.sample(dimod.generators.randint(nx.path_graph(5), dimod.SPIN))
+            self.assertEqual(heuristic.call_count, 2)
+
+        expected = TreeDecompositionSampler().sample(other, seed=7)
+        np.testing.assert_array_equal(reused.record.sample, expected.record.sample)
+
+    def test_interactions(self):
+        bqm = dimod.BQM({'a': .5, 'b': -1, 'c': .2}, {'ab': 1, 'bc': -.7, 'ac': .3}, 0, 'SPIN')
+
+        sampleset = TreeDecompositionSampler().sample(bqm, num_reads=1)
+        some = TreeDecompositionSampler().sample(bqm, num_reads=1,
+                                                 interactions=[('a', 'b'), ('c', 'b')])
+
+        marginals = sampleset.info['interaction_marginals']
+        self.assertEqual(set(some.info['interaction_marginals']), {('a', 'b'), ('c', 'b')})
+        for (u, v), probs in some.info['interaction_marginals'].items():
+            expected = marginals[(u, v)] if (u, v) in marginals else \
+                {(t, s): p for (s, t), p in marginals[(v, u)].items()}
+            for config, p in probs.items():
+                self.assertAlmostEqual(p, expected[config])
+        self.assertEqual(some.info['variable_marginals'], sampleset.info['variable_marginals'])
+
+        none = TreeDecompositionSampler().sample(bqm, num_reads=1, interactions=[])
+        self.assertEqual(none.info['interaction_marginals'], {})
+
+        with self.assertRaises(ValueError):
+            TreeDecompositionSampler().sample(bqm, interactions=[('a', 'd')])
+
+    def test_mmap_threshold(self):
+        bqm = dimod.generators.randint(nx.balanced_tree(3, 3), dimod.SPIN, seed=5)
+
+        sampleset = TreeDecompositionSampler().sample(bqm, num_reads=10, seed=17)
+        mapped = TreeDecompositionSampler().sample(bqm, num_reads=10, seed=17,
+                                                   mmap_threshold=0)
+
+        np.testing.assert_array_equal(sampleset.record.sample, mapped.record.sample)
+        self.assertAlmostEqual(sampleset.info['log_partition_function'],
+                               mapped.info['log_partition_function'])
+
+        with self.assertRaises(ValueError):
+            TreeDecompositionSampler().sample(bqm, mmap_threshold=-1)
+
+    def test_counters(self):
+        bqm = dimod.generators.randint(nx.path_graph('abcd'), dimod.SPIN, seed=3)
+
+        sampleset = TreeDecompositionSampler().sample(bqm, elimination_order=list('abcd'))
+        if 'counters' not in sampleset.info:
+            self.skipTest("the kernels were built without DWAVE_SAMPLERS_COUNTERS")
+
+        # the nodes in preorder, from the last variable eliminated
+        counters = sampleset.info['counters']
+        self.assertEqual(counters['node_variables'], list('dcba'))
+        np.testing.assert_array_equal(counters['table_sizes'], [1, 2, 2, 2])
+        self.assertTrue((counters['merge_seconds'] >= 0).all())
+
 
 @parameterized.parameterized_class([
         dict(bqm=dimod.BinaryQuadraticModel.from_ising({'a': -1}, {})),
@@ -14,9 +14,14 @@
 
 import inspect
 import itertools
+import os
+import tempfile
 import unittest
+import unittest.mock
 
 import dimod
+import networkx as nx
+import numpy as np
 
 from dwave.samplers.tree import TreeDecompositionSolver
 
@@ -132,3 +137,127 @@ class TestSample(unittest.TestCase):
         sampleset = TreeDecompositionSolver().sample(bqm, num_reads=101)
 
         self.assertEqual(sum(sampleset.record.num_occurrences), 101)
+
+    def test_num_threads(self):
+        # a tree, whose independent subtrees are built concurrently
+        G = nx.balanced_tree(3, 3)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+
+        sampleset = TreeDecompositionSolver().sample(bqm, num_reads=5)
+        threaded = TreeDecompositionSolver().sample(bqm, num_reads=5, num_threads=4)
+
+        np.testing.assert_array_equal(sampleset.record.sample, threaded.record.sample)
+        np.testing.assert_array_equal(sampleset.record.energy, threaded.record.energy)
+
+        with self.assertRaises(ValueError):
+            TreeDecompositionSolver().sample(bqm, num_threads=0)
+
+    def test_max_memory(self):
+        G = nx.balanced_tree(3, 3)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+
+        sampleset = TreeDecompositionSolver().sample(bqm, num_reads=5)
+        budgeted = TreeDecompositionSolver().sample(bqm, num_reads=5, max_memory=2**30)
+        np.testing.assert_array_equal(sampleset.record.sample, budgeted.record.sample)
+
+        # the tables of a single edge do not fit in a byte
+        with self.assertRaises(RuntimeError):
+            TreeDecompositionSolver().sample(bqm, max_memory=1)
+
+        with self.assertRaises(ValueError):
+            TreeDecompositionSolver().sample(bqm, max_memory=0)
+
+    def test_max_clamped(self):
+        G = nx.grid_2d_graph(5, 5)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+
+        sampleset = TreeDecompositionSolver().sample(bqm, num_reads=4)
+
+        solver = TreeDecompositionSolver()
+        solver.properties['max_treewidth'] = 3
+
+        with self.assertRaises(ValueError):
+            solver.sample(bqm)
+
+        for num_threads in [1, 3]:
+            clamped = solver.sample(bqm, num_reads=4, max_clamped=8, num_threads=num_threads)
+
+            # integer biases make the energies exact, but ground states may
+            # be degenerate
+            np.testing.assert_array_equal(sampleset.record.energy, clamped.record.energy)
+            dimod.testing.assert_sampleset_energies(clamped, bqm)
+
+        with self.assertRaises(RuntimeError):
+            solver.sample(bqm, max_clamped=1)
+
+        with self.assertRaises(ValueError):
+            solver.sample(bqm, max_clamped=-1)
+
+    def test_dtype(self):
+        G = nx.balanced_tree(3, 3)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+
+        sampleset = TreeDecompositionSolver().sample(bqm, num_reads=5)
+        single = TreeDecompositionSolver().sample(bqm, num_reads=5, dtype=np.float32)
+
+        # integer biases are exact in single precision
+        np.testing.assert_array_equal(sampleset.record.sample, single.record.sample)
+        np.testing.assert_array_equal(sampleset.record.energy, single.record.energy)
+        self.assertEqual(single.record.energy.dtype, np.float64)
+
+        with self.assertRaises(ValueError):
+            TreeDecompositionSolver().sample(bqm, dtype=np.int8)
+
+    def test_elimination_order_reuse(self):
+        import dwave.samplers.tree.samplers as samplers
+
+        G = nx.balanced_tree(3, 3)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+        other = dimod.generators.randint(G, dimod.SPIN, seed=6)
+
+        sampler = TreeDecompositionSolver()
+        with unittest.mock.patch.object(samplers, 'min_fill_heuristic',
+                                        wraps=samplers.min_fill_heuristic) as heuristic:
+            sampler.sample(bqm)
+            # same graph, different biases
+            reused = sampler.sample(other)
+            self.assertEqual(heuristic.call_count, 1)
+
+            # a different graph
+            sampler.sample(dimod.generators.randint(nx.path_graph(5), dimod.SPIN))
+            self.assertEqual(heuristic.call_count, 2)
+
+        expected = TreeDecompositionSolver().sample(other)
+        np.testing.assert_array_equal(reused.record.sample, expected.record.sample)
+
+    def test_mmap_threshold(self):
+        G = nx.balanced_tree(3, 3)
+        bqm = dimod.generators.randint(G, dimod.SPIN, seed=5)
+
+        sampleset = TreeDecompositionSolver().sample(bqm, num_reads=5)
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+            mapped = TreeDecompositionSolver().sample(
+                bqm, num_reads=5, mmap_threshold=0, mmap_dir=tmpdir)
+
+            # the table files are unlinked as soon as they are created
+            self.assertEqual(os.listdir(tmpdir), [])
+
+        np.testing.assert_array_equal(sampleset.record.sample, mapped.record.sample)
+        np.testing.assert_array_equal(sampleset.record.energy, mapped.record.energy)
+
+        with self.assertRaises(ValueError):
+            TreeDecompositionSolver().sample(bqm, mmap_threshold=-1)
+
+    def test_counters(self):
+        bqm = dimod.generators.randint(nx.path_graph('abcd'), dimod.SPIN, seed=3)
+
+        sampleset = TreeDecompositionSolver().sample(bqm, elimination_order=list('abcd'))
+        if 'counters' not in sampleset.info:
+            self.skipTest("the kernels were built without DWAVE_SAMPLERS_COUNTERS")
+
+        # the nodes in preorder, from the last variable eliminated
+        counters = sampleset.info['counters']
+        self.assertEqual(counters['node_variables'], list('dcba'))
+        np.testing.assert_array_equal(counters['table_sizes'], [1, 2, 2, 2])
+        self.assertTrue((counters['merge_seconds'] >= 0).all())